@@ -0,0 +1,179 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "AnnexBConverter.h"
+#include <string.h>
+#include <new>
+
+extern "C"
+{
+#include <libavutil/avutil.h>
+}
+
+using namespace FFmpegInterop;
+
+static const uint8_t StartCode[4] = { 0, 0, 0, 1 };
+
+static inline uint32_t ReadLength(const uint8_t* data, int lengthSize)
+{
+	switch (lengthSize)
+	{
+	case 1:
+		return data[0];
+	case 2:
+		return (data[0] << 8) | data[1];
+	default:
+		return ((uint32_t)data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+	}
+}
+
+AnnexBConverter::AnnexBConverter()
+	: m_lengthSize(4)
+{
+}
+
+int AnnexBConverter::SetExtradata(const uint8_t* extradata, size_t extradataSize)
+{
+	// avcC layout: version, profile, compatibility, level, 6 bits reserved + lengthSizeMinusOne,
+	// 3 bits reserved + number of SPS, then the SPS units, number of PPS and the PPS units.
+	// Each parameter set is prefixed with a 16-bit big endian size
+	if (extradata == nullptr || extradataSize < 7 || extradata[0] != 1)
+	{
+		return AVERROR_INVALIDDATA;
+	}
+
+	int lengthSize = (extradata[4] & 0x3) + 1;
+	if (lengthSize == 3)
+	{
+		return AVERROR_INVALIDDATA;
+	}
+
+	std::vector<uint8_t> parameterSets;
+	size_t index = 5;
+	try
+	{
+		for (int list = 0; list < 2; list++)
+		{
+			if (index >= extradataSize)
+			{
+				return AVERROR_INVALIDDATA;
+			}
+
+			int count = list == 0 ? (extradata[index] & 0x1f) : extradata[index];
+			index++;
+
+			for (int i = 0; i < count; i++)
+			{
+				if (extradataSize - index < 2)
+				{
+					return AVERROR_INVALIDDATA;
+				}
+
+				size_t unitSize = ReadLength(extradata + index, 2);
+				index += 2;
+				if (extradataSize - index < unitSize)
+				{
+					return AVERROR_INVALIDDATA;
+				}
+
+				parameterSets.insert(parameterSets.end(), StartCode, StartCode + sizeof(StartCode));
+				parameterSets.insert(parameterSets.end(), extradata + index, extradata + index + unitSize);
+				index += unitSize;
+			}
+		}
+	}
+	catch (std::bad_alloc&)
+	{
+		return AVERROR(ENOMEM);
+	}
+
+	m_lengthSize = lengthSize;
+	m_parameterSets.swap(parameterSets);
+	return 0;
+}
+
+int64_t AnnexBConverter::GetConvertedSize(const uint8_t* data, size_t size, bool writeParameterSets) const
+{
+	int64_t outputSize = writeParameterSets ? (int64_t)m_parameterSets.size() : 0;
+	size_t index = 0;
+
+	// Only hop over the length prefixes, the payload is not touched until the copy
+	while (index < size)
+	{
+		if (size - index < (size_t)m_lengthSize)
+		{
+			return AVERROR_INVALIDDATA;
+		}
+
+		size_t unitSize = ReadLength(data + index, m_lengthSize);
+		index += m_lengthSize;
+		if (size - index < unitSize)
+		{
+			return AVERROR_INVALIDDATA;
+		}
+
+		if (unitSize > 0)
+		{
+			outputSize += sizeof(StartCode) + unitSize;
+		}
+		index += unitSize;
+	}
+
+	return outputSize;
+}
+
+int64_t AnnexBConverter::ConvertTo(const uint8_t* data, size_t size, bool writeParameterSets, uint8_t* output, size_t outputSize) const
+{
+	int64_t convertedSize = GetConvertedSize(data, size, writeParameterSets);
+	if (convertedSize < 0)
+	{
+		return convertedSize;
+	}
+
+	if ((uint64_t)convertedSize > outputSize)
+	{
+		return AVERROR(EINVAL);
+	}
+
+	WriteConverted(data, size, writeParameterSets, output);
+	return convertedSize;
+}
+
+void AnnexBConverter::WriteConverted(const uint8_t* data, size_t size, bool writeParameterSets, uint8_t* output) const
+{
+	if (writeParameterSets && !m_parameterSets.empty())
+	{
+		memcpy(output, m_parameterSets.data(), m_parameterSets.size());
+		output += m_parameterSets.size();
+	}
+
+	// GetConvertedSize validated every length so the copy needs no further checks
+	size_t index = 0;
+	while (index < size)
+	{
+		size_t unitSize = ReadLength(data + index, m_lengthSize);
+		index += m_lengthSize;
+		if (unitSize > 0)
+		{
+			memcpy(output, StartCode, sizeof(StartCode));
+			memcpy(output + sizeof(StartCode), data + index, unitSize);
+			output += sizeof(StartCode) + unitSize;
+		}
+		index += unitSize;
+	}
+}
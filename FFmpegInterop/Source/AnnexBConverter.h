@@ -0,0 +1,52 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace FFmpegInterop
+{
+	// Converts H.264 AVC (length prefixed) packets to Annex B (start code prefixed) byte streams.
+	class AnnexBConverter
+	{
+	public:
+		AnnexBConverter();
+
+		// Parse the avcC configuration record. Returns 0 on success or a negative AVERROR code
+		int SetExtradata(const uint8_t* extradata, size_t extradataSize);
+
+		// Compute the exact Annex B size of a packet, including the parameter sets if requested.
+		// Returns a negative AVERROR code if the packet is malformed
+		int64_t GetConvertedSize(const uint8_t* data, size_t size, bool writeParameterSets) const;
+
+		// Convert a packet into a caller provided buffer of at least GetConvertedSize() bytes.
+		// Returns the number of bytes written or a negative AVERROR code
+		int64_t ConvertTo(const uint8_t* data, size_t size, bool writeParameterSets, uint8_t* output, size_t outputSize) const;
+
+		int GetLengthSize() const { return m_lengthSize; }
+		const std::vector<uint8_t>& GetParameterSets() const { return m_parameterSets; }
+
+	private:
+		void WriteConverted(const uint8_t* data, size_t size, bool writeParameterSets, uint8_t* output) const;
+
+		int m_lengthSize;
+		std::vector<uint8_t> m_parameterSets;
+	};
+}
@@ -0,0 +1,141 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "AudioConverter.h"
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+}
+
+using namespace FFmpegInterop;
+
+AudioConverter::AudioConverter()
+	: m_pSwrCtx(nullptr)
+	, m_path(PathNone)
+	, m_outSampleFormat(AV_SAMPLE_FMT_NONE)
+	, m_outFrameSize(0)
+	, m_outChannels(0)
+	, m_outChannelLayout(0)
+	, m_outSampleRate(0)
+	, m_inSampleFormat(AV_SAMPLE_FMT_NONE)
+	, m_inChannelLayout(0)
+	, m_inSampleRate(0)
+{
+}
+
+AudioConverter::~AudioConverter()
+{
+	swr_free(&m_pSwrCtx);
+}
+
+int AudioConverter::Configure(AVSampleFormat outSampleFormat, int channels, int sampleRate, AVSampleFormat inSampleFormat, int64_t inChannelLayout)
+{
+	if (channels <= 0 || sampleRate <= 0 || av_get_bytes_per_sample(outSampleFormat) <= 0)
+	{
+		return AVERROR(EINVAL);
+	}
+
+	m_outSampleFormat = outSampleFormat;
+	m_outChannels = channels;
+	m_outChannelLayout = av_get_default_channel_layout(channels);
+	m_outSampleRate = sampleRate;
+	m_outFrameSize = av_get_bytes_per_sample(outSampleFormat) * channels;
+	m_path = PathNone;
+
+	// The resampler is kept even when the decoder output needs no conversion, in case the decoder
+	// switches formats mid-stream
+	return ConfigureResampler(inSampleFormat, inChannelLayout ? inChannelLayout : m_outChannelLayout, sampleRate);
+}
+
+int AudioConverter::ConfigureResampler(AVSampleFormat inSampleFormat, int64_t inChannelLayout, int inSampleRate)
+{
+	m_inSampleFormat = AV_SAMPLE_FMT_NONE;
+	m_pSwrCtx = swr_alloc_set_opts(
+		m_pSwrCtx,
+		m_outChannelLayout,
+		m_outSampleFormat,
+		m_outSampleRate,
+		inChannelLayout,
+		inSampleFormat,
+		inSampleRate,
+		0,
+		NULL);
+
+	if (m_pSwrCtx == nullptr)
+	{
+		return AVERROR(ENOMEM);
+	}
+
+	int ret = swr_init(m_pSwrCtx);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	m_inSampleFormat = inSampleFormat;
+	m_inChannelLayout = inChannelLayout;
+	m_inSampleRate = inSampleRate;
+	return 0;
+}
+
+int AudioConverter::Convert(const AVFrame* frame, SampleBuffer* sampleBuffer)
+{
+	AVSampleFormat format = (AVSampleFormat)frame->format;
+	int64_t channelLayout = frame->channel_layout ? frame->channel_layout : av_get_default_channel_layout(frame->channels);
+
+	// m_outFrameSize only describes frames with the output channel count, so anything that
+	// differs in any way must not be copied
+	if (format == m_outSampleFormat && frame->channels == m_outChannels &&
+		channelLayout == m_outChannelLayout && frame->sample_rate == m_outSampleRate)
+	{
+		m_path = PathCopy;
+		return sampleBuffer->Append(frame->data[0], (size_t)frame->nb_samples * m_outFrameSize) ? 0 : AVERROR(ENOMEM);
+	}
+
+	m_path = PathResample;
+	if (format != m_inSampleFormat || channelLayout != m_inChannelLayout || frame->sample_rate != m_inSampleRate)
+	{
+		int ret = ConfigureResampler(format, channelLayout, frame->sample_rate);
+		if (ret < 0)
+		{
+			return ret;
+		}
+	}
+
+	int outSamples = swr_get_out_samples(m_pSwrCtx, frame->nb_samples);
+	if (outSamples < 0)
+	{
+		return outSamples;
+	}
+
+	uint8_t* output = sampleBuffer->Reserve((size_t)outSamples * m_outFrameSize);
+	if (output == nullptr)
+	{
+		return AVERROR(ENOMEM);
+	}
+
+	int converted = swr_convert(m_pSwrCtx, &output, outSamples, (const uint8_t**)frame->extended_data, frame->nb_samples);
+	if (converted < 0)
+	{
+		return converted;
+	}
+
+	sampleBuffer->Commit((size_t)converted * m_outFrameSize);
+	return 0;
+}
@@ -0,0 +1,81 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include "SampleBufferPool.h"
+#include <stdint.h>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libswresample/swresample.h>
+}
+
+namespace FFmpegInterop
+{
+	// Appends decoded audio frames to a sample buffer as interleaved samples of a fixed format,
+	// channel count and sample rate. Decoders may change the format, the channels or the rate
+	// mid-stream, so a frame is only copied as is when all of them match the output; anything
+	// else goes through swresample, which is set up again whenever the input changes.
+	class AudioConverter
+	{
+	public:
+		enum ConversionPath
+		{
+			PathNone,
+			PathCopy,
+			PathResample
+		};
+
+		AudioConverter();
+		~AudioConverter();
+
+		// Set the output and the input the decoder is expected to produce. The output keeps the
+		// channel count and sample rate the stream was announced with. A channel layout of 0 stands
+		// for the default layout of the channel count
+		int Configure(AVSampleFormat outSampleFormat, int channels, int sampleRate, AVSampleFormat inSampleFormat, int64_t inChannelLayout);
+
+		// Size in bytes of one sample of every channel in the output
+		int GetOutputFrameSize() const { return m_outFrameSize; }
+
+		// Convert the frame and append it to sampleBuffer
+		int Convert(const AVFrame* frame, SampleBuffer* sampleBuffer);
+
+		// Path of the last converted frame
+		ConversionPath GetPath() const { return m_path; }
+
+	private:
+		AudioConverter(const AudioConverter&);
+		AudioConverter& operator=(const AudioConverter&);
+
+		int ConfigureResampler(AVSampleFormat inSampleFormat, int64_t inChannelLayout, int inSampleRate);
+
+		SwrContext* m_pSwrCtx;
+		ConversionPath m_path;
+		AVSampleFormat m_outSampleFormat;
+		int m_outFrameSize;
+		int m_outChannels;
+		int64_t m_outChannelLayout;
+		int m_outSampleRate;
+
+		// Input the resampler is set up for
+		AVSampleFormat m_inSampleFormat;
+		int64_t m_inChannelLayout;
+		int m_inSampleRate;
+	};
+}
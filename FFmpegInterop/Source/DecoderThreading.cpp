@@ -0,0 +1,107 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "DecoderThreading.h"
+#include <string.h>
+
+extern "C"
+{
+#include <libavutil/cpu.h>
+}
+
+using namespace FFmpegInterop;
+
+// Same limit libavcodec applies to its own automatic thread count
+const int MAXAUTOTHREADS = 16;
+
+void FFmpegInterop::ConfigureDecoderThreading(AVCodecContext* avCodecCtx, const AVCodec* avCodec, const DecoderThreadingOptions& options)
+{
+	bool frameThreads = (avCodec->capabilities & AV_CODEC_CAP_FRAME_THREADS) != 0;
+	bool sliceThreads = (avCodec->capabilities & AV_CODEC_CAP_SLICE_THREADS) != 0;
+
+	int threadType = 0;
+	switch (options.Mode)
+	{
+	case ThreadingAuto:
+		if (options.LowLatency)
+		{
+			// Slice threads add no delay. Frame threads are still better than a single core
+			threadType = sliceThreads ? FF_THREAD_SLICE : frameThreads ? FF_THREAD_FRAME : 0;
+		}
+		else
+		{
+			threadType = frameThreads ? FF_THREAD_FRAME : sliceThreads ? FF_THREAD_SLICE : 0;
+		}
+		break;
+	case ThreadingFrame:
+		threadType = frameThreads ? FF_THREAD_FRAME : sliceThreads ? FF_THREAD_SLICE : 0;
+		break;
+	case ThreadingSlice:
+		threadType = sliceThreads ? FF_THREAD_SLICE : frameThreads ? FF_THREAD_FRAME : 0;
+		break;
+	default:
+		break;
+	}
+
+	int threadCount = options.ThreadCount;
+	if (threadCount <= 0)
+	{
+		threadCount = av_cpu_count();
+		if (threadCount > MAXAUTOTHREADS)
+		{
+			threadCount = MAXAUTOTHREADS;
+		}
+	}
+
+	if (threadType == 0 || threadCount <= 1)
+	{
+		avCodecCtx->thread_count = 1;
+		avCodecCtx->thread_type = 0;
+	}
+	else
+	{
+		avCodecCtx->thread_count = threadCount;
+		avCodecCtx->thread_type = threadType;
+	}
+}
+
+bool FFmpegInterop::ParseDecoderThreadingMode(const char* value, DecoderThreadingMode* mode)
+{
+	if (strcmp(value, "auto") == 0)
+	{
+		*mode = ThreadingAuto;
+	}
+	else if (strcmp(value, "frame") == 0)
+	{
+		*mode = ThreadingFrame;
+	}
+	else if (strcmp(value, "slice") == 0)
+	{
+		*mode = ThreadingSlice;
+	}
+	else if (strcmp(value, "none") == 0)
+	{
+		*mode = ThreadingNone;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
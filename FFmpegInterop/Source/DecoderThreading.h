@@ -0,0 +1,59 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace FFmpegInterop
+{
+	enum DecoderThreadingMode
+	{
+		// Frame threads when the codec supports them, slice threads otherwise
+		ThreadingAuto,
+		ThreadingFrame,
+		ThreadingSlice,
+		ThreadingNone
+	};
+
+	struct DecoderThreadingOptions
+	{
+		DecoderThreadingOptions()
+			: ThreadCount(0)
+			, Mode(ThreadingAuto)
+			, LowLatency(false)
+		{
+		}
+
+		// 0 uses one thread per core
+		int ThreadCount;
+		DecoderThreadingMode Mode;
+		// Prefer slice threads, frame threads delay the output by one frame per extra thread
+		bool LowLatency;
+	};
+
+	// Set thread_count and thread_type of a decoder context before avcodec_open2.
+	// Modes the codec does not support fall back to the other one, or to a single thread.
+	void ConfigureDecoderThreading(AVCodecContext* avCodecCtx, const AVCodec* avCodec, const DecoderThreadingOptions& options);
+
+	// Parse "auto", "frame", "slice" or "none". Returns false for anything else
+	bool ParseDecoderThreadingMode(const char* value, DecoderThreadingMode* mode);
+}
@@ -40,9 +40,16 @@ using namespace Windows::Media::MediaProperties;
 // Size of the buffer when reading a stream
 const int FILESTREAMBUFFERSZ = 16384;
 
+// Largest read of the adaptive read-ahead on the stream (1 MB)
+const int FILESTREAMREADAHEADMAX = 1024 * 1024;
+
 // Minimum duration for audio samples (50 ms)
 const TimeSpan MINAUDIOSAMPLEDURATION = { 500000 };
 
+// Default limits of each read-ahead packet queue (16 MB or 5 seconds)
+const int64_t READAHEADMAXBYTES = 16 * 1024 * 1024;
+const int64_t READAHEADMAXDURATION = 5 * AV_TIME_BASE;
+
 // Static functions passed to FFmpeg for stream interop
 static int FileStreamRead(void* ptr, uint8_t* buf, int bufSize);
 static int64_t FileStreamSeek(void* ptr, int64_t pos, int whence);
@@ -58,6 +65,12 @@ FFmpegInteropMSS::FFmpegInteropMSS()
 	, videoStreamIndex(AVERROR_STREAM_NOT_FOUND)
 	, fileStreamData(nullptr)
 	, fileStreamBuffer(nullptr)
+	, readAheadEnabled(false)
+	, readAheadMaxBytes(READAHEADMAXBYTES)
+	, readAheadMaxDuration(READAHEADMAXDURATION)
+	, audioOutputFloat(false)
+	, lowLatencyForced(false)
+	, lowLatencySet(false)
 {
 	av_register_all();
 }
@@ -72,6 +85,14 @@ FFmpegInteropMSS::~FFmpegInteropMSS()
 		mss = nullptr;
 	}
 
+	// Stop the demux thread first, this releases sample requests waiting on a read-ahead queue
+	if (m_pReader != nullptr)
+	{
+		m_pReader->StopReadAhead();
+	}
+	audioMutexGuard.lock();
+	videoMutexGuard.lock();
+
 	// Clear our data
 	audioSampleProvider = nullptr;
 	videoSampleProvider = nullptr;
@@ -86,13 +107,20 @@ FFmpegInteropMSS::~FFmpegInteropMSS()
 	avcodec_close(avVideoCodecCtx);
 	avcodec_close(avAudioCodecCtx);
 	avformat_close_input(&avFormatCtx);
-	av_free(avIOCtx);
+	if (avIOCtx != nullptr)
+	{
+		// The buffer may have been replaced by a larger one while reading
+		av_freep(&avIOCtx->buffer);
+		av_freep(&avIOCtx);
+	}
 	av_dict_free(&avDict);
 	
 	if (fileStreamData != nullptr)
 	{
 		fileStreamData->Release();
 	}
+	videoMutexGuard.unlock();
+	audioMutexGuard.unlock();
 	mutexGuard.unlock();
 }
 
@@ -226,6 +254,11 @@ HRESULT FFmpegInteropMSS::CreateMediaStreamSource(IRandomAccessStream^ stream, b
 		{
 			hr = E_OUTOFMEMORY;
 		}
+		else
+		{
+			// Grow the reads while the stream is read sequentially, a single IStream::Read per 16 KB is slow on network shares
+			avIOCtx->read_ahead_max = FILESTREAMREADAHEADMAX;
+		}
 	}
 
 	if (SUCCEEDED(hr))
@@ -294,6 +327,19 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 		}
 	}
 
+	if (SUCCEEDED(hr))
+	{
+		// Audio and video samples are written into blocks from the same pool
+		try
+		{
+			sampleBufferPool = std::make_shared<SampleBufferPool>();
+		}
+		catch (std::bad_alloc&)
+		{
+			hr = E_OUTOFMEMORY;
+		}
+	}
+
 	if (SUCCEEDED(hr))
 	{
 		// Find the audio stream and its decoder
@@ -333,6 +379,7 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 						hr = CreateAudioStreamDescriptor(forceAudioDecode);
 						if (SUCCEEDED(hr))
 						{
+							audioSampleProvider->SetBufferPool(sampleBufferPool);
 							hr = audioSampleProvider->AllocateResources();
 							if (SUCCEEDED(hr))
 							{
@@ -397,6 +444,15 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 					}
 				}
 
+				if (SUCCEEDED(hr) && (forceVideoDecode || avVideoCodecCtx->codec_id != AV_CODEC_ID_H264))
+				{
+					// Only frames decoded here benefit from threads. Streams without a duration are live,
+					// like the zero BufferTime below they prefer threading that does not delay the output
+					DecoderThreadingOptions threading = videoThreading;
+					threading.LowLatency = lowLatencySet ? lowLatencyForced : avFormatCtx->duration <= 0;
+					ConfigureDecoderThreading(avVideoCodecCtx, avVideoCodec, threading);
+				}
+
 				if (SUCCEEDED(hr))
 				{
 					if (avcodec_open2(avVideoCodecCtx, avVideoCodec, NULL) < 0)
@@ -410,6 +466,7 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 						hr = CreateVideoStreamDescriptor(forceVideoDecode);
 						if (SUCCEEDED(hr))
 						{
+							videoSampleProvider->SetBufferPool(sampleBufferPool);
 							hr = videoSampleProvider->AllocateResources();
 							if (SUCCEEDED(hr))
 							{
@@ -428,6 +485,12 @@ HRESULT FFmpegInteropMSS::InitFFmpegContext(bool forceAudioDecode, bool forceVid
 		}
 	}
 
+	if (SUCCEEDED(hr) && readAheadEnabled)
+	{
+		// Both streams are set, start filling their queues in the background
+		hr = m_pReader->StartReadAhead(readAheadMaxBytes, readAheadMaxDuration);
+	}
+
 	if (SUCCEEDED(hr))
 	{
 		// Convert media duration from AV_TIME_BASE to TimeSpan unit
@@ -545,9 +608,21 @@ HRESULT FFmpegInteropMSS::CreateAudioStreamDescriptor(bool forceAudioDecode)
 	}
 	else
 	{
-		// We always convert to 16-bit audio so set the size here
-		audioStreamDescriptor = ref new AudioStreamDescriptor(AudioEncodingProperties::CreatePcm(avAudioCodecCtx->sample_rate, avAudioCodecCtx->channels, 16));
-		audioSampleProvider = ref new UncompressedAudioSampleProvider(m_pReader, avFormatCtx, avAudioCodecCtx);
+		AudioEncodingProperties^ audioProperties;
+		if (audioOutputFloat)
+		{
+			// 32-bit float keeps the decoder precision, the media pipeline mixes in float anyway
+			audioProperties = AudioEncodingProperties::CreatePcm(avAudioCodecCtx->sample_rate, avAudioCodecCtx->channels, 32);
+			audioProperties->Subtype = MediaEncodingSubtypes::Float;
+		}
+		else
+		{
+			// Otherwise we always convert to 16-bit audio so set the size here
+			audioProperties = AudioEncodingProperties::CreatePcm(avAudioCodecCtx->sample_rate, avAudioCodecCtx->channels, 16);
+		}
+
+		audioStreamDescriptor = ref new AudioStreamDescriptor(audioProperties);
+		audioSampleProvider = ref new UncompressedAudioSampleProvider(m_pReader, avFormatCtx, avAudioCodecCtx, audioOutputFloat ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16);
 	}
 
 	return (audioStreamDescriptor != nullptr && audioSampleProvider != nullptr) ? S_OK : E_OUTOFMEMORY;
@@ -586,6 +661,12 @@ HRESULT FFmpegInteropMSS::CreateVideoStreamDescriptor(bool forceVideoDecode)
 		}
 
 		videoProperties->Properties->Insert(MF_MT_INTERLACE_MODE, (uint32)_MFVideoInterlaceMode::MFVideoInterlace_MixedInterlaceOrProgressive);
+
+		// Full range frames are passed through without range conversion
+		if (Nv12Converter::IsFullRange(avVideoCodecCtx->pix_fmt))
+		{
+			videoProperties->Properties->Insert(MF_MT_VIDEO_NOMINAL_RANGE, (uint32)MFNominalRange_0_255);
+		}
 	}
 	if (rotateVideo)
 	{
@@ -632,8 +713,44 @@ HRESULT FFmpegInteropMSS::ParseOptions(PropertySet^ ffmpegOptions)
 			std::string valueA(valueW.begin(), valueW.end());
 			const char* valueChar = valueA.c_str();
 
+			// Options for the interop itself are consumed here rather than passed to FFmpeg
+			if (keyA == "interop_readahead")
+			{
+				readAheadEnabled = valueA == "1" || _stricmp(valueChar, "true") == 0;
+			}
+			else if (keyA == "interop_readahead_max_bytes")
+			{
+				readAheadMaxBytes = _atoi64(valueChar);
+			}
+			else if (keyA == "interop_readahead_max_duration")
+			{
+				// Given in milliseconds
+				readAheadMaxDuration = av_rescale(_atoi64(valueChar), AV_TIME_BASE, 1000);
+			}
+			else if (keyA == "interop_audio_float")
+			{
+				audioOutputFloat = valueA == "1" || _stricmp(valueChar, "true") == 0;
+			}
+			else if (keyA == "interop_video_threads")
+			{
+				// 0 uses one thread per core
+				videoThreading.ThreadCount = atoi(valueChar);
+			}
+			else if (keyA == "interop_video_thread_type")
+			{
+				if (!ParseDecoderThreadingMode(valueChar, &videoThreading.Mode))
+				{
+					hr = E_INVALIDARG;
+					break;
+				}
+			}
+			else if (keyA == "interop_low_latency")
+			{
+				lowLatencySet = true;
+				lowLatencyForced = valueA == "1" || _stricmp(valueChar, "true") == 0;
+			}
 			// Add key and value pair entry
-			if (av_dict_set(&avDict, keyChar, valueChar, 0) < 0)
+			else if (av_dict_set(&avDict, keyChar, valueChar, 0) < 0)
 			{
 				hr = E_INVALIDARG;
 				break;
@@ -650,6 +767,11 @@ void FFmpegInteropMSS::OnStarting(MediaStreamSource ^sender, MediaStreamSourceSt
 {
 	MediaStreamSourceStartingRequest^ request = args->Request;
 
+	// Seeking touches both sample providers and the demuxer. Locks are always taken in this order
+	std::lock_guard<std::recursive_mutex> lock(mutexGuard);
+	std::lock_guard<std::recursive_mutex> audioLock(audioMutexGuard);
+	std::lock_guard<std::recursive_mutex> videoLock(videoMutexGuard);
+
 	// Perform seek operation when MediaStreamSource received seek event from MediaElement
 	if (request->StartPosition && request->StartPosition->Value.Duration <= mediaDuration.Duration)
 	{
@@ -661,7 +783,7 @@ void FFmpegInteropMSS::OnStarting(MediaStreamSource ^sender, MediaStreamSourceSt
 			// Convert TimeSpan unit to AV_TIME_BASE
 			int64_t seekTarget = static_cast<int64_t>(request->StartPosition->Value.Duration / (av_q2d(avFormatCtx->streams[streamIndex]->time_base) * 10000000));
 
-			if (av_seek_frame(avFormatCtx, streamIndex, seekTarget, 0) < 0)
+			if (m_pReader->Seek(streamIndex, seekTarget, 0) < 0)
 			{
 				DebugMessage(L" - ### Error while seeking\n");
 			}
@@ -691,7 +813,12 @@ void FFmpegInteropMSS::OnStarting(MediaStreamSource ^sender, MediaStreamSourceSt
 
 void FFmpegInteropMSS::OnSampleRequested(Windows::Media::Core::MediaStreamSource ^sender, MediaStreamSourceSampleRequestedEventArgs ^args)
 {
-	mutexGuard.lock();
+	// With read-ahead each stream only pops from its own queue so audio and video requests don't
+	// have to wait for each other. Otherwise both share the demuxer and take the same lock
+	std::recursive_mutex& streamGuard = !readAheadEnabled ? mutexGuard :
+		args->Request->StreamDescriptor == audioStreamDescriptor ? audioMutexGuard : videoMutexGuard;
+
+	streamGuard.lock();
 	if (mss != nullptr)
 	{
 		if (args->Request->StreamDescriptor == audioStreamDescriptor && audioSampleProvider != nullptr)
@@ -708,7 +835,7 @@ void FFmpegInteropMSS::OnSampleRequested(Windows::Media::Core::MediaStreamSource
 			args->Request->Sample = nullptr;
 		}
 	}
-	mutexGuard.unlock();
+	streamGuard.unlock();
 }
 
 // Static function to read file stream and pass data to FFmpeg. Credit to Philipp Sch http://www.codeproject.com/Tips/489450/Creating-Custom-FFmpeg-IO-Context
@@ -20,6 +20,7 @@
 #include <queue>
 #include <mutex>
 #include "MediaSampleProvider.h"
+#include "DecoderThreading.h"
 #include "FFmpegReader.h"
 
 using namespace Platform;
@@ -120,6 +121,8 @@ namespace FFmpegInterop
 		bool rotateVideo;
 		int rotationAngle;
 		std::recursive_mutex mutexGuard;
+		std::recursive_mutex audioMutexGuard;
+		std::recursive_mutex videoMutexGuard;
 		
 		MediaSampleProvider^ audioSampleProvider;
 		MediaSampleProvider^ videoSampleProvider;
@@ -130,5 +133,13 @@ namespace FFmpegInterop
 		IStream* fileStreamData;
 		unsigned char* fileStreamBuffer;
 		FFmpegReader^ m_pReader;
+		std::shared_ptr<SampleBufferPool> sampleBufferPool;
+		bool readAheadEnabled;
+		int64_t readAheadMaxBytes;
+		int64_t readAheadMaxDuration;
+		bool audioOutputFloat;
+		DecoderThreadingOptions videoThreading;
+		bool lowLatencyForced;
+		bool lowLatencySet;
 	};
 }
@@ -30,11 +30,69 @@ FFmpegReader::FFmpegReader(AVFormatContext* avFormatCtx)
 
 FFmpegReader::~FFmpegReader()
 {
+	StopReadAhead();
+}
+
+// Start demuxing on a background thread into bounded per stream queues.
+// Must be called after the audio and video streams are set
+HRESULT FFmpegReader::StartReadAhead(int64_t maxQueueBytes, int64_t maxQueueDuration)
+{
+	HRESULT hr = S_OK;
+
+	try
+	{
+		m_pReadAhead.reset(new ReadAheadDemuxer(m_pAvFormatCtx, maxQueueBytes, maxQueueDuration));
+		if (m_audioSampleProvider != nullptr)
+		{
+			m_pReadAhead->AddStream(m_audioStreamIndex);
+		}
+		if (m_videoSampleProvider != nullptr)
+		{
+			m_pReadAhead->AddStream(m_videoStreamIndex);
+		}
+	}
+	catch (std::bad_alloc&)
+	{
+		hr = E_OUTOFMEMORY;
+	}
+
+	if (SUCCEEDED(hr) && m_pReadAhead->Start() < 0)
+	{
+		hr = E_FAIL;
+	}
+
+	if (FAILED(hr))
+	{
+		m_pReadAhead.reset();
+	}
+
+	return hr;
+}
+
+void FFmpegReader::StopReadAhead()
+{
+	if (m_pReadAhead != nullptr)
+	{
+		// Wakes any sample request waiting for a packet
+		m_pReadAhead->Stop();
+	}
+}
+
+int FFmpegReader::Seek(int streamIndex, int64_t timestamp, int flags)
+{
+	if (m_pReadAhead != nullptr)
+	{
+		// The demux thread is parked while seeking and its queues are dropped
+		return m_pReadAhead->Seek(streamIndex, timestamp, flags);
+	}
+
+	return av_seek_frame(m_pAvFormatCtx, streamIndex, timestamp, flags);
 }
 
 // Read the next packet from the stream and push it into the appropriate
-// sample provider
-int FFmpegReader::ReadPacket()
+// sample provider. With read-ahead the packet comes from the queue of the
+// requesting stream, otherwise whatever packet is next in the file is read
+int FFmpegReader::ReadPacket(int streamIndex)
 {
 	int ret;
 	AVPacket avPacket;
@@ -42,7 +100,15 @@ int FFmpegReader::ReadPacket()
 	avPacket.data = NULL;
 	avPacket.size = 0;
 
-	ret = av_read_frame(m_pAvFormatCtx, &avPacket);
+	if (m_pReadAhead != nullptr)
+	{
+		ret = m_pReadAhead->PopPacket(streamIndex, &avPacket);
+	}
+	else
+	{
+		ret = av_read_frame(m_pAvFormatCtx, &avPacket);
+	}
+
 	if (ret < 0)
 	{
 		return ret;
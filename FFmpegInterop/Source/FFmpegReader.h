@@ -18,7 +18,9 @@
 
 #pragma once
 
+#include <memory>
 #include "MediaSampleProvider.h"
+#include "ReadAheadDemuxer.h"
 
 namespace FFmpegInterop
 {
@@ -27,15 +29,19 @@ namespace FFmpegInterop
 	{
 	public:
 		virtual ~FFmpegReader();
-		int ReadPacket();
+		int ReadPacket(int streamIndex);
 		void SetAudioStream(int audioStreamIndex, MediaSampleProvider^ audioSampleProvider);
 		void SetVideoStream(int videoStreamIndex, MediaSampleProvider^ videoSampleProvider);
 
 	internal:
 		FFmpegReader(AVFormatContext* avFormatCtx);
+		HRESULT StartReadAhead(int64_t maxQueueBytes, int64_t maxQueueDuration);
+		void StopReadAhead();
+		int Seek(int streamIndex, int64_t timestamp, int flags);
 
 	private:
 		AVFormatContext* m_pAvFormatCtx;
+		std::unique_ptr<ReadAheadDemuxer> m_pReadAhead;
 		MediaSampleProvider^ m_audioSampleProvider;
 		int m_audioStreamIndex;
 		MediaSampleProvider^ m_videoSampleProvider;
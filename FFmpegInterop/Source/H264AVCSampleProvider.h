@@ -18,6 +18,7 @@
 
 #pragma once
 #include "MediaSampleProvider.h"
+#include "AnnexBConverter.h"
 
 namespace FFmpegInterop
 {
@@ -28,14 +29,14 @@ namespace FFmpegInterop
 		virtual ~H264AVCSampleProvider();
 
 	private:
-		HRESULT WriteNALPacket(DataWriter^ dataWriter, AVPacket* avPacket);
-		HRESULT GetSPSAndPPSBuffer(DataWriter^ dataWriter);
+		AnnexBConverter m_converter;
 
 	internal:
 		H264AVCSampleProvider(
 			FFmpegReader^ reader,
 			AVFormatContext* avFormatCtx,
 			AVCodecContext* avCodecCtx);
-		virtual HRESULT WriteAVPacketToStream(DataWriter^ writer, AVPacket* avPacket) override;
+		virtual HRESULT AllocateResources() override;
+		virtual HRESULT WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket) override;
 	};
 }
@@ -33,26 +33,26 @@ H264SampleProvider::~H264SampleProvider()
 {
 }
 
-HRESULT H264SampleProvider::WriteAVPacketToStream(DataWriter^ dataWriter, AVPacket* avPacket)
+HRESULT H264SampleProvider::WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket)
 {
 	HRESULT hr = S_OK;
 	// On a KeyFrame, write the SPS and PPS
 	if (avPacket->flags & AV_PKT_FLAG_KEY)
 	{
-		hr = GetSPSAndPPSBuffer(dataWriter);
+		hr = GetSPSAndPPSBuffer(sampleBuffer);
 	}
 
 	if (SUCCEEDED(hr))
 	{
 		// Call base class method that simply write the packet to stream as is
-		hr = MediaSampleProvider::WriteAVPacketToStream(dataWriter, avPacket);
+		hr = MediaSampleProvider::WriteAVPacketToStream(sampleBuffer, avPacket);
 	}
 
 	// We have a complete frame
 	return hr;
 }
 
-HRESULT H264SampleProvider::GetSPSAndPPSBuffer(DataWriter^ dataWriter)
+HRESULT H264SampleProvider::GetSPSAndPPSBuffer(SampleBuffer* sampleBuffer)
 {
 	HRESULT hr = S_OK;
 
@@ -64,8 +64,10 @@ HRESULT H264SampleProvider::GetSPSAndPPSBuffer(DataWriter^ dataWriter)
 	else
 	{
 		// Write both SPS and PPS sequence as is from extradata
-		auto vSPSPPS = ref new Platform::Array<uint8_t>(m_pAvCodecCtx->extradata, m_pAvCodecCtx->extradata_size);
-		dataWriter->WriteBytes(vSPSPPS);
+		if (!sampleBuffer->Append(m_pAvCodecCtx->extradata, m_pAvCodecCtx->extradata_size))
+		{
+			hr = E_OUTOFMEMORY;
+		}
 	}
 
 	return hr;
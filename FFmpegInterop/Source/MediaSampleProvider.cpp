@@ -20,6 +20,7 @@
 #include "MediaSampleProvider.h"
 #include "FFmpegInteropMSS.h"
 #include "FFmpegReader.h"
+#include "NativeBuffer.h"
 
 using namespace FFmpegInterop;
 
@@ -40,6 +41,11 @@ HRESULT MediaSampleProvider::AllocateResources()
 {
 	DebugMessage(L"AllocateResources\n");
 	m_startOffset = -1;
+	if (m_pBufferPool == nullptr)
+	{
+		// Not sharing a pool with other streams, use a private one
+		m_pBufferPool = std::make_shared<SampleBufferPool>();
+	}
 	return S_OK;
 }
 
@@ -48,12 +54,18 @@ MediaSampleProvider::~MediaSampleProvider()
 	DebugMessage(L"~MediaSampleProvider\n");
 }
 
+void MediaSampleProvider::SetBufferPool(const std::shared_ptr<SampleBufferPool>& bufferPool)
+{
+	m_pBufferPool = bufferPool;
+}
+
 void MediaSampleProvider::SetCurrentStreamIndex(int streamIndex)
 {
 	DebugMessage(L"SetCurrentStreamIndex\n");
 	if (m_pAvCodecCtx != nullptr && m_pAvFormatCtx->nb_streams > (unsigned int)streamIndex)
 	{
 		m_streamIndex = streamIndex;
+		m_packetQueue.SetTimeBase(m_pAvFormatCtx->streams[streamIndex]->time_base);
 	}
 	else
 	{
@@ -75,7 +87,7 @@ MediaStreamSample^ MediaSampleProvider::GetNextSample(Windows::Foundation::TimeS
 
 	MediaStreamSample^ sample;
 	AVPacket avPacket;
-	DataWriter^ dataWriter = ref new DataWriter();
+	SampleBuffer sampleBuffer(m_pBufferPool, m_sampleSizes.GetSuggestedCapacity());
 
 	Windows::Foundation::TimeSpan pts = { 0 };
 	Windows::Foundation::TimeSpan dur = { 0 };
@@ -93,17 +105,16 @@ MediaStreamSample^ MediaSampleProvider::GetNextSample(Windows::Foundation::TimeS
 		while (SUCCEEDED(hr) && !frameComplete)
 		{
 			// Continue reading until there is an appropriate packet in the stream
-			while (m_packetQueue.empty())
+			while (m_packetQueue.IsEmpty())
 			{
-				if (m_pReader->ReadPacket() < 0)
+				if (m_pReader->ReadPacket(m_streamIndex) < 0)
 				{
 					DebugMessage(L"GetNextSample reaching EOF\n");
-					hr = E_FAIL;
 					break;
 				}
 			}
 
-			if (!m_packetQueue.empty())
+			if (!m_packetQueue.IsEmpty())
 			{
 				// Pick the packets from the queue one at a time
 				avPacket = PopPacket();
@@ -111,15 +122,25 @@ MediaStreamSample^ MediaSampleProvider::GetNextSample(Windows::Foundation::TimeS
 				frameDuration = avPacket.duration;
 
 				// Decode the packet if necessary, it will update the presentation time if necessary
-				hr = DecodeAVPacket(dataWriter, &avPacket, framePts, frameDuration);
+				hr = DecodeAVPacket(&sampleBuffer, &avPacket, framePts, frameDuration);
 				frameComplete = (hr == S_OK);
 			}
+			else
+			{
+				// The stream ended, decoders may still hold delayed frames
+				hr = DecodeEndOfStream(&sampleBuffer, framePts, frameDuration);
+				frameComplete = (hr == S_OK);
+				if (!frameComplete)
+				{
+					hr = E_FAIL;
+				}
+			}
 		}
 
 		if (SUCCEEDED(hr))
 		{
 			// Write the packet out
-			hr = WriteAVPacketToStream(dataWriter, &avPacket);
+			hr = WriteAVPacketToStream(&sampleBuffer, &avPacket);
 
 			if (m_startOffset == -1)
 			{
@@ -144,23 +165,28 @@ MediaStreamSample^ MediaSampleProvider::GetNextSample(Windows::Foundation::TimeS
 
 	if (dur.Duration > 0)
 	{
-		sample = MediaStreamSample::CreateFromBuffer(dataWriter->DetachBuffer(), pts);
-		sample->Duration = dur;
+		m_sampleSizes.Add(sampleBuffer.GetSize());
+
+		// The sample reads straight from the pooled block, which is recycled when the sample is released
+		IBuffer^ buffer = NativeBuffer::Create(m_pBufferPool, sampleBuffer);
+		if (buffer != nullptr)
+		{
+			sample = MediaStreamSample::CreateFromBuffer(buffer, pts);
+			sample->Duration = dur;
+		}
 	}
 
 	return sample;
 }
 
-HRESULT MediaSampleProvider::WriteAVPacketToStream(DataWriter^ dataWriter, AVPacket* avPacket)
+HRESULT MediaSampleProvider::WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket)
 {
 	// This is the simplest form of transfer. Copy the packet directly to the stream
 	// This works for most compressed formats
-	auto aBuffer = ref new Platform::Array<uint8_t>(avPacket->data, avPacket->size);
-	dataWriter->WriteBytes(aBuffer);
-	return S_OK;
+	return sampleBuffer->Append(avPacket->data, avPacket->size) ? S_OK : E_OUTOFMEMORY;
 }
 
-HRESULT MediaSampleProvider::DecodeAVPacket(DataWriter^ dataWriter, AVPacket *avPacket, int64_t &framePts, int64_t &frameDuration)
+HRESULT MediaSampleProvider::DecodeAVPacket(SampleBuffer* sampleBuffer, AVPacket *avPacket, int64_t &framePts, int64_t &frameDuration)
 {
 	// For the simple case of compressed samples, each packet is a sample
 	if (avPacket != nullptr && avPacket->pts != AV_NOPTS_VALUE)
@@ -171,11 +197,21 @@ HRESULT MediaSampleProvider::DecodeAVPacket(DataWriter^ dataWriter, AVPacket *av
 	return S_OK;
 }
 
+HRESULT MediaSampleProvider::DecodeEndOfStream(SampleBuffer* sampleBuffer, int64_t& framePts, int64_t& frameDuration)
+{
+	// Compressed samples are passed through, nothing is left once the packets run out
+	return E_FAIL;
+}
+
 void MediaSampleProvider::QueuePacket(AVPacket packet)
 {
 	DebugMessage(L" - QueuePacket\n");
 
-	m_packetQueue.push_back(packet);
+	if (m_packetQueue.Push(packet) < 0)
+	{
+		// Out of memory, drop the packet rather than leak it
+		av_packet_unref(&packet);
+	}
 }
 
 AVPacket MediaSampleProvider::PopPacket()
@@ -187,11 +223,7 @@ AVPacket MediaSampleProvider::PopPacket()
 	avPacket.data = NULL;
 	avPacket.size = 0;
 
-	if (!m_packetQueue.empty())
-	{
-		avPacket = m_packetQueue.front();
-		m_packetQueue.erase(m_packetQueue.begin());
-	}
+	m_packetQueue.Pop(&avPacket);
 
 	return avPacket;
 }
@@ -199,8 +231,5 @@ AVPacket MediaSampleProvider::PopPacket()
 void MediaSampleProvider::Flush()
 {
 	DebugMessage(L"Flush\n");
-	while (!m_packetQueue.empty())
-	{
-		av_packet_unref(&PopPacket());
-	}
+	m_packetQueue.Flush();
 }
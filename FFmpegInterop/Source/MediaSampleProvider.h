@@ -18,6 +18,9 @@
 
 #pragma once
 #include <queue>
+#include <memory>
+#include "PacketQueue.h"
+#include "SampleBufferPool.h"
 
 extern "C"
 {
@@ -44,9 +47,14 @@ namespace FFmpegInterop
 	internal:
 		void QueuePacket(AVPacket packet);
 		AVPacket PopPacket();
+		int64_t GetQueuedBytes() { return m_packetQueue.GetBytes(); }
+		int64_t GetQueuedDuration() { return m_packetQueue.GetDuration(); }
+		void SetBufferPool(const std::shared_ptr<SampleBufferPool>& bufferPool);
 
 	private:
-		std::vector<AVPacket> m_packetQueue;
+		PacketQueue m_packetQueue;
+		std::shared_ptr<SampleBufferPool> m_pBufferPool;
+		SampleSizeHistory m_sampleSizes;
 		int m_streamIndex;
 		int64 m_startOffset = 0;
 
@@ -64,7 +72,9 @@ namespace FFmpegInterop
 			AVFormatContext* avFormatCtx,
 			AVCodecContext* avCodecCtx);
 		virtual HRESULT AllocateResources();
-		virtual HRESULT WriteAVPacketToStream(DataWriter^ writer, AVPacket* avPacket);
-		virtual HRESULT DecodeAVPacket(DataWriter^ dataWriter, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration);
+		virtual HRESULT WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket);
+		virtual HRESULT DecodeAVPacket(SampleBuffer* sampleBuffer, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration);
+		// Called once no packet is left. Returns S_OK while a sample could still be produced
+		virtual HRESULT DecodeEndOfStream(SampleBuffer* sampleBuffer, int64_t& framePts, int64_t& frameDuration);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include <wrl.h>
+#include <robuffer.h>
+#include <windows.storage.streams.h>
+#include "SampleBufferPool.h"
+
+namespace FFmpegInterop
+{
+	// IBuffer over a pooled block. The media pipeline reads the sample straight from pool
+	// memory and the block goes back to the pool once the last reference is released
+	class NativeBuffer : public Microsoft::WRL::RuntimeClass<
+		Microsoft::WRL::RuntimeClassFlags<Microsoft::WRL::RuntimeClassType::WinRtClassicComMix>,
+		ABI::Windows::Storage::Streams::IBuffer,
+		Windows::Storage::Streams::IBufferByteAccess>
+	{
+		InspectableClass(L"FFmpegInterop.NativeBuffer", BaseTrust)
+
+	public:
+		NativeBuffer()
+			: m_block(nullptr)
+			, m_length(0)
+		{
+		}
+
+		virtual ~NativeBuffer()
+		{
+			if (m_pool)
+			{
+				m_pool->Release(m_block);
+			}
+		}
+
+		HRESULT RuntimeClassInitialize(const std::shared_ptr<SampleBufferPool>& pool, PooledBlock* block, UINT32 length)
+		{
+			m_pool = pool;
+			m_block = block;
+			m_length = length;
+			return S_OK;
+		}
+
+		// IBufferByteAccess
+		STDMETHODIMP Buffer(byte** value)
+		{
+			*value = m_block->Data;
+			return S_OK;
+		}
+
+		// IBuffer
+		STDMETHODIMP get_Capacity(UINT32* value)
+		{
+			*value = (UINT32)m_block->Capacity;
+			return S_OK;
+		}
+
+		STDMETHODIMP get_Length(UINT32* value)
+		{
+			*value = m_length;
+			return S_OK;
+		}
+
+		STDMETHODIMP put_Length(UINT32 value)
+		{
+			if (value > m_block->Capacity)
+			{
+				return E_INVALIDARG;
+			}
+			m_length = value;
+			return S_OK;
+		}
+
+		// Wrap the detached contents of a SampleBuffer. Returns nullptr if the buffer is empty
+		static Windows::Storage::Streams::IBuffer^ Create(const std::shared_ptr<SampleBufferPool>& pool, SampleBuffer& sampleBuffer)
+		{
+			UINT32 length = (UINT32)sampleBuffer.GetSize();
+			PooledBlock* block = sampleBuffer.Detach();
+			if (block == nullptr)
+			{
+				return nullptr;
+			}
+
+			Microsoft::WRL::ComPtr<NativeBuffer> nativeBuffer;
+			if (FAILED(Microsoft::WRL::MakeAndInitialize<NativeBuffer>(&nativeBuffer, pool, block, length)))
+			{
+				pool->Release(block);
+				return nullptr;
+			}
+
+			return reinterpret_cast<Windows::Storage::Streams::IBuffer^>(static_cast<ABI::Windows::Storage::Streams::IBuffer*>(nativeBuffer.Get()));
+		}
+
+	private:
+		std::shared_ptr<SampleBufferPool> m_pool;
+		PooledBlock* m_block;
+		UINT32 m_length;
+	};
+}
@@ -0,0 +1,243 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "Nv12Converter.h"
+#include <string.h>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+}
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NV12_INTERLEAVE_SSE2
+#elif defined(_M_ARM) || defined(_M_ARM64) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NV12_INTERLEAVE_NEON
+#endif
+
+using namespace FFmpegInterop;
+
+static void CopyPlane(uint8_t* dst, int dstLineSize, const uint8_t* src, int srcLineSize, int rowBytes, int rows)
+{
+	if (dstLineSize == srcLineSize && rowBytes == srcLineSize)
+	{
+		memcpy(dst, src, (size_t)rowBytes * rows);
+		return;
+	}
+
+	for (int y = 0; y < rows; y++)
+	{
+		memcpy(dst, src, rowBytes);
+		dst += dstLineSize;
+		src += srcLineSize;
+	}
+}
+
+// Interleave one row of U and V samples into UVUV...
+static void InterleaveRow(uint8_t* dst, const uint8_t* u, const uint8_t* v, int count)
+{
+	int x = 0;
+#if defined(NV12_INTERLEAVE_SSE2)
+	for (; x + 16 <= count; x += 16)
+	{
+		__m128i u16 = _mm_loadu_si128((const __m128i*)(u + x));
+		__m128i v16 = _mm_loadu_si128((const __m128i*)(v + x));
+		_mm_storeu_si128((__m128i*)(dst + 2 * x), _mm_unpacklo_epi8(u16, v16));
+		_mm_storeu_si128((__m128i*)(dst + 2 * x + 16), _mm_unpackhi_epi8(u16, v16));
+	}
+#elif defined(NV12_INTERLEAVE_NEON)
+	for (; x + 16 <= count; x += 16)
+	{
+		uint8x16x2_t uv;
+		uv.val[0] = vld1q_u8(u + x);
+		uv.val[1] = vld1q_u8(v + x);
+		vst2q_u8(dst + 2 * x, uv);
+	}
+#endif
+	for (; x < count; x++)
+	{
+		dst[2 * x] = u[x];
+		dst[2 * x + 1] = v[x];
+	}
+}
+
+Nv12Converter::Nv12Converter()
+	: m_pSwsCtx(nullptr)
+	, m_path(PathNone)
+	, m_sourceFormat(AV_PIX_FMT_NONE)
+	, m_sourceWidth(0)
+	, m_sourceHeight(0)
+	, m_width(0)
+	, m_height(0)
+	, m_fullRange(false)
+	, m_outputSize(0)
+{
+	memset(m_lineSize, 0, sizeof(m_lineSize));
+}
+
+Nv12Converter::~Nv12Converter()
+{
+	sws_freeContext(m_pSwsCtx);
+}
+
+bool Nv12Converter::IsFullRange(AVPixelFormat format)
+{
+	return format == AV_PIX_FMT_YUVJ420P || format == AV_PIX_FMT_YUVJ422P || format == AV_PIX_FMT_YUVJ440P || format == AV_PIX_FMT_YUVJ444P;
+}
+
+int Nv12Converter::Configure(AVPixelFormat sourceFormat, int width, int height)
+{
+	int ret = av_image_fill_linesizes(m_lineSize, AV_PIX_FMT_NV12, width);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	ret = av_image_get_buffer_size(AV_PIX_FMT_NV12, width, height, 1);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	m_outputSize = ret;
+	m_width = width;
+	m_height = height;
+	m_fullRange = IsFullRange(sourceFormat);
+
+	// Some decoders only know their format after the first frame, the path is selected then
+	if (sourceFormat == AV_PIX_FMT_NONE)
+	{
+		m_path = PathNone;
+		return 0;
+	}
+
+	return SelectPath(sourceFormat, width, height);
+}
+
+int Nv12Converter::Convert(const AVFrame* frame, uint8_t* output)
+{
+	AVPixelFormat format = (AVPixelFormat)frame->format;
+	if (m_path == PathNone || format != m_sourceFormat || frame->width != m_sourceWidth || frame->height != m_sourceHeight)
+	{
+		int ret = SelectPath(format, frame->width, frame->height);
+		if (ret < 0)
+		{
+			return ret;
+		}
+	}
+
+	switch (m_path)
+	{
+	case PathCopy:
+		CopyPlanes(frame, output);
+		return 0;
+	case PathInterleave:
+		InterleavePlanes(frame, output);
+		return 0;
+	default:
+		return ScalePlanes(frame, output);
+	}
+}
+
+int Nv12Converter::SelectPath(AVPixelFormat sourceFormat, int sourceWidth, int sourceHeight)
+{
+	m_sourceFormat = sourceFormat;
+	m_sourceWidth = sourceWidth;
+	m_sourceHeight = sourceHeight;
+
+	// Only a plain copy or interleave when neither the size nor the range changes
+	bool sameGeometry = sourceWidth == m_width && sourceHeight == m_height && IsFullRange(sourceFormat) == m_fullRange;
+	if (sameGeometry && sourceFormat == AV_PIX_FMT_NV12)
+	{
+		m_path = PathCopy;
+		return 0;
+	}
+	if (sameGeometry && (sourceFormat == AV_PIX_FMT_YUV420P || sourceFormat == AV_PIX_FMT_YUVJ420P))
+	{
+		m_path = PathInterleave;
+		return 0;
+	}
+
+	m_path = PathNone;
+	m_pSwsCtx = sws_getCachedContext(
+		m_pSwsCtx,
+		sourceWidth,
+		sourceHeight,
+		sourceFormat,
+		m_width,
+		m_height,
+		AV_PIX_FMT_NV12,
+		SWS_BICUBIC,
+		NULL,
+		NULL,
+		NULL);
+
+	if (m_pSwsCtx == nullptr)
+	{
+		return AVERROR(ENOMEM);
+	}
+
+	if (m_fullRange)
+	{
+		// The output was announced as full range, keep it that way whatever the source is
+		int* invTable;
+		int* table;
+		int srcRange, dstRange, brightness, contrast, saturation;
+		if (sws_getColorspaceDetails(m_pSwsCtx, &invTable, &srcRange, &table, &dstRange, &brightness, &contrast, &saturation) >= 0)
+		{
+			sws_setColorspaceDetails(m_pSwsCtx, invTable, srcRange, table, 1, brightness, contrast, saturation);
+		}
+	}
+
+	m_path = PathScale;
+	return 0;
+}
+
+void Nv12Converter::CopyPlanes(const AVFrame* frame, uint8_t* output) const
+{
+	int chromaHeight = (m_height + 1) >> 1;
+	CopyPlane(output, m_lineSize[0], frame->data[0], frame->linesize[0], m_lineSize[0], m_height);
+	CopyPlane(output + (size_t)m_lineSize[0] * m_height, m_lineSize[1], frame->data[1], frame->linesize[1], m_lineSize[1], chromaHeight);
+}
+
+void Nv12Converter::InterleavePlanes(const AVFrame* frame, uint8_t* output) const
+{
+	int chromaWidth = (m_width + 1) >> 1;
+	int chromaHeight = (m_height + 1) >> 1;
+	CopyPlane(output, m_lineSize[0], frame->data[0], frame->linesize[0], m_lineSize[0], m_height);
+
+	uint8_t* uv = output + (size_t)m_lineSize[0] * m_height;
+	const uint8_t* u = frame->data[1];
+	const uint8_t* v = frame->data[2];
+	for (int y = 0; y < chromaHeight; y++)
+	{
+		InterleaveRow(uv, u, v, chromaWidth);
+		uv += m_lineSize[1];
+		u += frame->linesize[1];
+		v += frame->linesize[2];
+	}
+}
+
+int Nv12Converter::ScalePlanes(const AVFrame* frame, uint8_t* output) const
+{
+	uint8_t* data[4] = { output, output + (size_t)m_lineSize[0] * m_height, nullptr, nullptr };
+	int ret = sws_scale(m_pSwsCtx, frame->data, frame->linesize, 0, frame->height, data, m_lineSize);
+	return ret < 0 ? ret : 0;
+}
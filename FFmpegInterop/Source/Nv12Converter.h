@@ -0,0 +1,83 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace FFmpegInterop
+{
+	// Writes decoded frames as one contiguous NV12 image of a fixed size.
+	// NV12 frames are copied plane by plane, YUV420P frames have their chroma planes interleaved,
+	// anything else goes through swscale. The path is picked again whenever the frame format or
+	// size changes.
+	class Nv12Converter
+	{
+	public:
+		enum ConversionPath
+		{
+			PathNone,
+			PathCopy,
+			PathInterleave,
+			PathScale
+		};
+
+		Nv12Converter();
+		~Nv12Converter();
+
+		// Set the output size and the format the decoder is expected to produce.
+		// Full range sources (YUVJ) keep their range, the caller has to signal it downstream
+		int Configure(AVPixelFormat sourceFormat, int width, int height);
+
+		// Size in bytes of one output image
+		size_t GetOutputSize() const { return m_outputSize; }
+
+		// Convert the frame into output, which must hold GetOutputSize bytes
+		int Convert(const AVFrame* frame, uint8_t* output);
+
+		ConversionPath GetPath() const { return m_path; }
+
+		static bool IsFullRange(AVPixelFormat format);
+
+	private:
+		Nv12Converter(const Nv12Converter&);
+		Nv12Converter& operator=(const Nv12Converter&);
+
+		int SelectPath(AVPixelFormat sourceFormat, int sourceWidth, int sourceHeight);
+		void CopyPlanes(const AVFrame* frame, uint8_t* output) const;
+		void InterleavePlanes(const AVFrame* frame, uint8_t* output) const;
+		int ScalePlanes(const AVFrame* frame, uint8_t* output) const;
+
+		SwsContext* m_pSwsCtx;
+		ConversionPath m_path;
+		AVPixelFormat m_sourceFormat;
+		int m_sourceWidth;
+		int m_sourceHeight;
+		int m_width;
+		int m_height;
+		bool m_fullRange;
+		int m_lineSize[4];
+		size_t m_outputSize;
+	};
+}
@@ -0,0 +1,152 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "PacketQueue.h"
+#include <string.h>
+
+using namespace FFmpegInterop;
+
+// Must be a power of two so the ring index can be masked
+const size_t INITIALQUEUECAPACITY = 16;
+
+PacketQueue::PacketQueue()
+	: m_packets(nullptr)
+	, m_capacity(0)
+	, m_head(0)
+	, m_count(0)
+	, m_bytes(0)
+	, m_duration(0)
+{
+	m_timeBase.num = 1;
+	m_timeBase.den = AV_TIME_BASE;
+}
+
+PacketQueue::~PacketQueue()
+{
+	Flush();
+	av_free(m_packets);
+}
+
+void PacketQueue::SetTimeBase(AVRational timeBase)
+{
+	m_timeBase = timeBase;
+}
+
+int PacketQueue::Push(const AVPacket& avPacket)
+{
+	if (m_count == m_capacity)
+	{
+		int ret = Grow();
+		if (ret < 0)
+		{
+			return ret;
+		}
+	}
+
+	m_packets[(m_head + m_count) & (m_capacity - 1)] = avPacket;
+	m_count++;
+	m_bytes += avPacket.size;
+	m_duration += GetPacketDuration(avPacket);
+	return 0;
+}
+
+bool PacketQueue::Pop(AVPacket* avPacket)
+{
+	if (m_count == 0)
+	{
+		return false;
+	}
+
+	*avPacket = m_packets[m_head];
+	m_head = (m_head + 1) & (m_capacity - 1);
+	m_count--;
+	m_bytes -= avPacket->size;
+	m_duration -= GetPacketDuration(*avPacket);
+	return true;
+}
+
+const AVPacket* PacketQueue::Peek(size_t index) const
+{
+	if (index >= m_count)
+	{
+		return nullptr;
+	}
+
+	return &m_packets[(m_head + index) & (m_capacity - 1)];
+}
+
+const AVPacket* PacketQueue::PeekNextKeyFrame(size_t* index) const
+{
+	for (size_t i = *index; i < m_count; i++)
+	{
+		const AVPacket* avPacket = &m_packets[(m_head + i) & (m_capacity - 1)];
+		if (avPacket->flags & AV_PKT_FLAG_KEY)
+		{
+			*index = i;
+			return avPacket;
+		}
+	}
+
+	return nullptr;
+}
+
+void PacketQueue::Flush()
+{
+	AVPacket avPacket;
+	while (Pop(&avPacket))
+	{
+		av_packet_unref(&avPacket);
+	}
+
+	m_head = 0;
+	m_bytes = 0;
+	m_duration = 0;
+}
+
+int PacketQueue::Grow()
+{
+	size_t capacity = m_capacity ? m_capacity * 2 : INITIALQUEUECAPACITY;
+	AVPacket* packets = (AVPacket*)av_malloc_array(capacity, sizeof(AVPacket));
+	if (packets == nullptr)
+	{
+		return AVERROR(ENOMEM);
+	}
+
+	// Unwrap the ring so the queued packets start at the beginning of the new array
+	if (m_count > 0)
+	{
+		size_t firstPart = m_capacity - m_head;
+		if (firstPart > m_count)
+		{
+			firstPart = m_count;
+		}
+		memcpy(packets, m_packets + m_head, firstPart * sizeof(AVPacket));
+		memcpy(packets + firstPart, m_packets, (m_count - firstPart) * sizeof(AVPacket));
+	}
+
+	av_free(m_packets);
+	m_packets = packets;
+	m_capacity = capacity;
+	m_head = 0;
+	return 0;
+}
+
+int64_t PacketQueue::GetPacketDuration(const AVPacket& avPacket) const
+{
+	return avPacket.duration > 0 ? av_rescale_q(avPacket.duration, m_timeBase, AV_TIME_BASE_Q) : 0;
+}
@@ -0,0 +1,79 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+namespace FFmpegInterop
+{
+	// FIFO of demuxed packets stored in a growable ring, so push and pop are O(1).
+	// The queue keeps running totals of the bytes and the duration (AV_TIME_BASE units)
+	// it holds so callers can enforce memory limits.
+	class PacketQueue
+	{
+	public:
+		PacketQueue();
+		~PacketQueue();
+
+		// Time base of the queued packets, used to convert their durations
+		void SetTimeBase(AVRational timeBase);
+
+		// Take ownership of the packet. Returns AVERROR(ENOMEM) if the ring could not grow
+		int Push(const AVPacket& avPacket);
+
+		// Hand the oldest packet over to the caller. Returns false if the queue is empty
+		bool Pop(AVPacket* avPacket);
+
+		// The packet stays owned by the queue. Growing the ring moves the AVPacket structs,
+		// so the pointer is only valid until the next Push, Pop or Flush
+		const AVPacket* Peek(size_t index) const;
+
+		// First key frame at or after *index, whose position is stored in *index. Returns nullptr
+		// when there is none. Like Peek, the packet is not copied and stays owned by the queue
+		const AVPacket* PeekNextKeyFrame(size_t* index) const;
+
+		// Unreference and drop every queued packet
+		void Flush();
+
+		bool IsEmpty() const { return m_count == 0; }
+		size_t GetCount() const { return m_count; }
+		int64_t GetBytes() const { return m_bytes; }
+		int64_t GetDuration() const { return m_duration; }
+
+	private:
+		PacketQueue(const PacketQueue&);
+		PacketQueue& operator=(const PacketQueue&);
+
+		int Grow();
+		int64_t GetPacketDuration(const AVPacket& avPacket) const;
+
+		AVPacket* m_packets;
+		size_t m_capacity;
+		size_t m_head;
+		size_t m_count;
+		int64_t m_bytes;
+		int64_t m_duration;
+		AVRational m_timeBase;
+	};
+}
@@ -0,0 +1,362 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "ReadAheadDemuxer.h"
+#include <algorithm>
+#include <system_error>
+
+using namespace FFmpegInterop;
+
+ReadAheadDemuxer::ReadAheadDemuxer(AVFormatContext* avFormatCtx, int64_t maxQueueBytes, int64_t maxQueueDuration)
+	: m_pAvFormatCtx(avFormatCtx)
+	, m_maxQueueBytes(maxQueueBytes)
+	, m_maxQueueDuration(maxQueueDuration)
+	, m_running(false)
+	, m_stopRequested(false)
+	, m_pauseRequested(false)
+	, m_reading(false)
+	, m_waitingConsumers(0)
+	, m_readResult(0)
+{
+}
+
+ReadAheadDemuxer::~ReadAheadDemuxer()
+{
+	Stop();
+	FlushQueues();
+}
+
+void ReadAheadDemuxer::AddStream(int streamIndex)
+{
+	std::unique_ptr<StreamQueue> queue(new StreamQueue);
+	queue->StreamIndex = streamIndex;
+	queue->Packets.SetTimeBase(m_pAvFormatCtx->streams[streamIndex]->time_base);
+	m_queues.push_back(std::move(queue));
+}
+
+int ReadAheadDemuxer::Start()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_running)
+	{
+		return 0;
+	}
+
+	m_stopRequested = false;
+	try
+	{
+		m_thread = std::thread(&ReadAheadDemuxer::DemuxLoop, this);
+	}
+	catch (std::system_error&)
+	{
+		return AVERROR(EAGAIN);
+	}
+
+	m_running = true;
+	return 0;
+}
+
+void ReadAheadDemuxer::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_running)
+		{
+			return;
+		}
+
+		// Consumers blocked in PopPacket see the stop and return
+		m_stopRequested = true;
+		m_demuxCondition.notify_all();
+		m_packetCondition.notify_all();
+	}
+
+	// A read already in progress has to complete before the thread can exit
+	m_thread.join();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_running = false;
+}
+
+int ReadAheadDemuxer::PopPacket(int streamIndex, AVPacket* avPacket)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	StreamQueue* queue = FindQueue(streamIndex);
+	if (queue == nullptr)
+	{
+		return AVERROR_STREAM_NOT_FOUND;
+	}
+
+	while (queue->Packets.IsEmpty())
+	{
+		if (m_stopRequested || !m_running)
+		{
+			return AVERROR_EXIT;
+		}
+
+		if (m_readResult < 0)
+		{
+			return m_readResult;
+		}
+
+		// Let the thread read past the limits of the other queues until this one gets a packet
+		m_waitingConsumers++;
+		m_demuxCondition.notify_all();
+		m_packetCondition.wait(lock);
+		m_waitingConsumers--;
+	}
+
+	queue->Packets.Pop(avPacket);
+
+	// There is room again, wake the thread if it parked on this queue
+	m_demuxCondition.notify_all();
+	return 0;
+}
+
+int ReadAheadDemuxer::Seek(int streamIndex, int64_t timestamp, int flags)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// Park the thread outside of av_read_frame so the format context can be used from here
+	m_pauseRequested = true;
+	m_demuxCondition.notify_all();
+	while (m_reading)
+	{
+		m_packetCondition.wait(lock);
+	}
+
+	int ret = 0;
+	if (!SeekInQueues(streamIndex, timestamp, flags))
+	{
+		ret = av_seek_frame(m_pAvFormatCtx, streamIndex, timestamp, flags);
+		if (ret >= 0)
+		{
+			FlushQueues();
+			m_readResult = 0;
+		}
+	}
+
+	m_pauseRequested = false;
+	m_demuxCondition.notify_all();
+	return ret;
+}
+
+int64_t ReadAheadDemuxer::GetQueuedBytes(int streamIndex)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	StreamQueue* queue = FindQueue(streamIndex);
+	return queue != nullptr ? queue->Packets.GetBytes() : 0;
+}
+
+int64_t ReadAheadDemuxer::GetQueuedDuration(int streamIndex)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	StreamQueue* queue = FindQueue(streamIndex);
+	return queue != nullptr ? queue->Packets.GetDuration() : 0;
+}
+
+void ReadAheadDemuxer::DemuxLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stopRequested)
+	{
+		// Park while seeking, after the end of the stream or while the queues are full
+		if (m_pauseRequested || m_readResult < 0 || ShouldPark())
+		{
+			m_demuxCondition.wait(lock);
+			continue;
+		}
+
+		// Read without holding the lock so consumers can keep popping during slow I/O
+		m_reading = true;
+		lock.unlock();
+
+		AVPacket avPacket;
+		av_init_packet(&avPacket);
+		avPacket.data = NULL;
+		avPacket.size = 0;
+		int ret = av_read_frame(m_pAvFormatCtx, &avPacket);
+
+		lock.lock();
+		m_reading = false;
+
+		if (ret < 0)
+		{
+			m_readResult = ret;
+		}
+		else
+		{
+			StreamQueue* queue = FindQueue(avPacket.stream_index);
+			if (queue == nullptr)
+			{
+				av_packet_unref(&avPacket);
+			}
+			else if (queue->Packets.Push(avPacket) < 0)
+			{
+				av_packet_unref(&avPacket);
+				m_readResult = AVERROR(ENOMEM);
+			}
+		}
+
+		// Wake consumers waiting for a packet and a seek waiting for the read to complete
+		m_packetCondition.notify_all();
+	}
+}
+
+bool ReadAheadDemuxer::ShouldPark() const
+{
+	if (m_waitingConsumers > 0)
+	{
+		return false;
+	}
+
+	for (auto& queue : m_queues)
+	{
+		if (IsFull(*queue))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool ReadAheadDemuxer::IsFull(const StreamQueue& queue) const
+{
+	return queue.Packets.GetBytes() >= m_maxQueueBytes || (m_maxQueueDuration > 0 && queue.Packets.GetDuration() >= m_maxQueueDuration);
+}
+
+static int64_t GetPacketTime(const AVPacket* avPacket)
+{
+	return avPacket->pts != AV_NOPTS_VALUE ? avPacket->pts : avPacket->dts;
+}
+
+// The queue of a stream holds the packets that follow the read position without gaps. Once it
+// reaches past the target it contains the key frame av_seek_frame would pick, the last one at or
+// before the target for AVSEEK_FLAG_BACKWARD and the first one at or after it otherwise. The
+// packets queued before that key frame are dropped
+bool ReadAheadDemuxer::SeekInQueues(int streamIndex, int64_t timestamp, int flags)
+{
+	StreamQueue* queue = FindQueue(streamIndex);
+	if (queue == nullptr || queue->Packets.IsEmpty() || (flags & ~AVSEEK_FLAG_BACKWARD) != 0)
+	{
+		return false;
+	}
+
+	bool backward = (flags & AVSEEK_FLAG_BACKWARD) != 0;
+	bool found = false;
+	bool passed = false;
+	size_t keyFrameIndex = 0;
+	const AVPacket* keyFrame;
+	for (size_t index = 0; (keyFrame = queue->Packets.PeekNextKeyFrame(&index)) != nullptr; index++)
+	{
+		int64_t time = GetPacketTime(keyFrame);
+		if (time == AV_NOPTS_VALUE)
+		{
+			continue;
+		}
+
+		if (backward && time <= timestamp)
+		{
+			keyFrameIndex = index;
+			found = true;
+		}
+		else if (time >= timestamp)
+		{
+			if (!backward)
+			{
+				keyFrameIndex = index;
+				found = true;
+			}
+			passed = true;
+			break;
+		}
+	}
+
+	if (backward)
+	{
+		// A later key frame could still be in the file unless the queue goes past the target
+		const AVPacket* last = queue->Packets.Peek(queue->Packets.GetCount() - 1);
+		passed = passed || (last->dts != AV_NOPTS_VALUE && last->dts > timestamp) || m_readResult == AVERROR_EOF;
+	}
+	else
+	{
+		// An earlier key frame could have been popped already unless the queue starts before the target
+		int64_t firstTime = GetPacketTime(queue->Packets.Peek(0));
+		passed = passed && firstTime != AV_NOPTS_VALUE && firstTime <= timestamp;
+	}
+
+	if (!found || !passed)
+	{
+		return false;
+	}
+
+	AVPacket avPacket;
+	for (size_t i = 0; i < keyFrameIndex; i++)
+	{
+		queue->Packets.Pop(&avPacket);
+		av_packet_unref(&avPacket);
+	}
+
+	// Like the demuxers do after a seek, the other streams resume with the packet that covers the
+	// time of the key frame
+	AVRational timeBase = m_pAvFormatCtx->streams[streamIndex]->time_base;
+	int64_t keyFrameTime = GetPacketTime(queue->Packets.Peek(0));
+	for (auto& other : m_queues)
+	{
+		AVRational otherTimeBase = m_pAvFormatCtx->streams[other->StreamIndex]->time_base;
+		const AVPacket* next;
+		while (other.get() != queue && (next = other->Packets.Peek(0)) != nullptr)
+		{
+			int64_t time = GetPacketTime(next);
+			if (time == AV_NOPTS_VALUE || av_compare_ts(time, otherTimeBase, keyFrameTime, timeBase) >= 0 ||
+				av_compare_ts(time + std::max(next->duration, (int64_t)0), otherTimeBase, keyFrameTime, timeBase) > 0)
+			{
+				break;
+			}
+
+			other->Packets.Pop(&avPacket);
+			av_packet_unref(&avPacket);
+		}
+	}
+
+	return true;
+}
+
+ReadAheadDemuxer::StreamQueue* ReadAheadDemuxer::FindQueue(int streamIndex)
+{
+	for (auto& queue : m_queues)
+	{
+		if (queue->StreamIndex == streamIndex)
+		{
+			return queue.get();
+		}
+	}
+
+	return nullptr;
+}
+
+void ReadAheadDemuxer::FlushQueues()
+{
+	for (auto& queue : m_queues)
+	{
+		queue->Packets.Flush();
+	}
+}
@@ -0,0 +1,90 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include <stdint.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PacketQueue.h"
+
+namespace FFmpegInterop
+{
+	// Demuxes on a dedicated thread into one bounded packet queue per selected stream.
+	// The thread parks once a queue holds maxQueueBytes or maxQueueDuration (AV_TIME_BASE units)
+	// unless a consumer is waiting on an empty queue, which keeps badly interleaved files from
+	// deadlocking.
+	class ReadAheadDemuxer
+	{
+	public:
+		ReadAheadDemuxer(AVFormatContext* avFormatCtx, int64_t maxQueueBytes, int64_t maxQueueDuration);
+		~ReadAheadDemuxer();
+
+		// Streams must be added before Start
+		void AddStream(int streamIndex);
+		int Start();
+		void Stop();
+
+		// Wait until a packet of the stream is available. The caller owns the returned packet.
+		// Returns 0 on success, AVERROR_EOF or the error that stopped the demuxer
+		int PopPacket(int streamIndex, AVPacket* avPacket);
+
+		// Park the thread, drop everything queued and seek. The thread resumes from the new position.
+		// When the key frame the seek would land on is already queued, only the packets before it
+		// are dropped and the file is not touched
+		int Seek(int streamIndex, int64_t timestamp, int flags);
+
+		int64_t GetQueuedBytes(int streamIndex);
+		int64_t GetQueuedDuration(int streamIndex);
+
+	private:
+		struct StreamQueue
+		{
+			int StreamIndex;
+			PacketQueue Packets;
+		};
+
+		ReadAheadDemuxer(const ReadAheadDemuxer&);
+		ReadAheadDemuxer& operator=(const ReadAheadDemuxer&);
+
+		void DemuxLoop();
+		bool ShouldPark() const;
+		bool IsFull(const StreamQueue& queue) const;
+		bool SeekInQueues(int streamIndex, int64_t timestamp, int flags);
+		StreamQueue* FindQueue(int streamIndex);
+		void FlushQueues();
+
+		AVFormatContext* m_pAvFormatCtx;
+		int64_t m_maxQueueBytes;
+		int64_t m_maxQueueDuration;
+		std::vector<std::unique_ptr<StreamQueue>> m_queues;
+
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_demuxCondition;
+		std::condition_variable m_packetCondition;
+		bool m_running;
+		bool m_stopRequested;
+		bool m_pauseRequested;
+		bool m_reading;
+		int m_waitingConsumers;
+		int m_readResult;
+	};
+}
@@ -0,0 +1,248 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#include "SampleBufferPool.h"
+#include <string.h>
+#include <new>
+
+extern "C"
+{
+#include <libavutil/mem.h>
+}
+
+using namespace FFmpegInterop;
+
+// Allocations are rounded up to whole pages so similar sample sizes share blocks
+const size_t BLOCKGRANULARITY = 4096;
+
+static size_t RoundUpCapacity(size_t size)
+{
+	if (size == 0)
+	{
+		size = 1;
+	}
+	return (size + BLOCKGRANULARITY - 1) & ~(BLOCKGRANULARITY - 1);
+}
+
+SampleBufferPool::SampleBufferPool(size_t maxFreeBlocks, size_t maxFreeBytes)
+	: m_freeBytes(0)
+	, m_maxFreeBlocks(maxFreeBlocks)
+	, m_maxFreeBytes(maxFreeBytes)
+	, m_allocationCount(0)
+{
+}
+
+SampleBufferPool::~SampleBufferPool()
+{
+	for (auto block : m_freeBlocks)
+	{
+		FreeBlock(block);
+	}
+}
+
+PooledBlock* SampleBufferPool::Acquire(size_t minCapacity)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// Best fit so small audio samples don't take the blocks sized for video
+		size_t bestIndex = m_freeBlocks.size();
+		for (size_t i = 0; i < m_freeBlocks.size(); i++)
+		{
+			if (m_freeBlocks[i]->Capacity >= minCapacity &&
+				(bestIndex == m_freeBlocks.size() || m_freeBlocks[i]->Capacity < m_freeBlocks[bestIndex]->Capacity))
+			{
+				bestIndex = i;
+			}
+		}
+
+		if (bestIndex < m_freeBlocks.size())
+		{
+			PooledBlock* block = m_freeBlocks[bestIndex];
+			m_freeBlocks[bestIndex] = m_freeBlocks.back();
+			m_freeBlocks.pop_back();
+			m_freeBytes -= block->Capacity;
+			return block;
+		}
+
+		m_allocationCount++;
+	}
+
+	// Nothing reusable, allocate outside of the lock
+	PooledBlock* block = new (std::nothrow) PooledBlock;
+	if (block != nullptr)
+	{
+		block->Capacity = RoundUpCapacity(minCapacity);
+		block->Data = (uint8_t*)av_malloc(block->Capacity);
+		if (block->Data == nullptr)
+		{
+			delete block;
+			block = nullptr;
+		}
+	}
+
+	return block;
+}
+
+void SampleBufferPool::Release(PooledBlock* block)
+{
+	if (block == nullptr)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_freeBlocks.size() < m_maxFreeBlocks && m_freeBytes + block->Capacity <= m_maxFreeBytes)
+		{
+			try
+			{
+				m_freeBlocks.push_back(block);
+				m_freeBytes += block->Capacity;
+				return;
+			}
+			catch (std::bad_alloc&)
+			{
+			}
+		}
+	}
+
+	FreeBlock(block);
+}
+
+size_t SampleBufferPool::GetFreeBlockCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_freeBlocks.size();
+}
+
+size_t SampleBufferPool::GetAllocationCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_allocationCount;
+}
+
+void SampleBufferPool::FreeBlock(PooledBlock* block)
+{
+	av_free(block->Data);
+	delete block;
+}
+
+SampleSizeHistory::SampleSizeHistory()
+	: m_next(0)
+	, m_count(0)
+{
+	memset(m_sizes, 0, sizeof(m_sizes));
+}
+
+void SampleSizeHistory::Add(size_t sampleSize)
+{
+	m_sizes[m_next] = sampleSize;
+	m_next = (m_next + 1) % HistoryLength;
+	if (m_count < HistoryLength)
+	{
+		m_count++;
+	}
+}
+
+size_t SampleSizeHistory::GetSuggestedCapacity() const
+{
+	size_t largest = 0;
+	for (int i = 0; i < m_count; i++)
+	{
+		if (m_sizes[i] > largest)
+		{
+			largest = m_sizes[i];
+		}
+	}
+
+	// Leave some headroom so a slightly larger sample still fits
+	return RoundUpCapacity(largest + largest / 8);
+}
+
+SampleBuffer::SampleBuffer(const std::shared_ptr<SampleBufferPool>& pool, size_t expectedSize)
+	: m_pool(pool)
+	, m_block(nullptr)
+	, m_size(0)
+	, m_expectedSize(expectedSize)
+{
+}
+
+SampleBuffer::~SampleBuffer()
+{
+	m_pool->Release(m_block);
+}
+
+uint8_t* SampleBuffer::Reserve(size_t size)
+{
+	if (m_block == nullptr)
+	{
+		m_block = m_pool->Acquire(size > m_expectedSize ? size : m_expectedSize);
+		if (m_block == nullptr)
+		{
+			return nullptr;
+		}
+	}
+	else if (m_block->Capacity - m_size < size)
+	{
+		// Grow geometrically, the size history should make this rare
+		size_t capacity = m_block->Capacity * 2;
+		if (capacity < m_size + size)
+		{
+			capacity = m_size + size;
+		}
+
+		PooledBlock* block = m_pool->Acquire(capacity);
+		if (block == nullptr)
+		{
+			return nullptr;
+		}
+
+		memcpy(block->Data, m_block->Data, m_size);
+		m_pool->Release(m_block);
+		m_block = block;
+	}
+
+	return m_block->Data + m_size;
+}
+
+void SampleBuffer::Commit(size_t size)
+{
+	m_size += size;
+}
+
+bool SampleBuffer::Append(const uint8_t* data, size_t size)
+{
+	uint8_t* dest = Reserve(size);
+	if (dest == nullptr)
+	{
+		return false;
+	}
+
+	memcpy(dest, data, size);
+	Commit(size);
+	return true;
+}
+
+PooledBlock* SampleBuffer::Detach()
+{
+	PooledBlock* block = m_block;
+	m_block = nullptr;
+	m_size = 0;
+	return block;
+}
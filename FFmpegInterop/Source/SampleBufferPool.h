@@ -0,0 +1,110 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace FFmpegInterop
+{
+	// A block of sample memory handed out by SampleBufferPool
+	struct PooledBlock
+	{
+		uint8_t* Data;
+		size_t Capacity;
+	};
+
+	// Thread safe pool of sample memory blocks. Blocks are returned from whichever thread
+	// the media pipeline releases the sample on, so the pool is always held by shared_ptr.
+	class SampleBufferPool
+	{
+	public:
+		SampleBufferPool(size_t maxFreeBlocks = 32, size_t maxFreeBytes = 64 * 1024 * 1024);
+		~SampleBufferPool();
+
+		// Get a block of at least minCapacity bytes, reusing a free block when one is large enough.
+		// Returns nullptr when out of memory
+		PooledBlock* Acquire(size_t minCapacity);
+		void Release(PooledBlock* block);
+
+		size_t GetFreeBlockCount();
+		size_t GetAllocationCount();
+
+	private:
+		SampleBufferPool(const SampleBufferPool&);
+		SampleBufferPool& operator=(const SampleBufferPool&);
+
+		static void FreeBlock(PooledBlock* block);
+
+		std::mutex m_mutex;
+		std::vector<PooledBlock*> m_freeBlocks;
+		size_t m_freeBytes;
+		size_t m_maxFreeBlocks;
+		size_t m_maxFreeBytes;
+		size_t m_allocationCount;
+	};
+
+	// Remembers the size of the most recent samples of one stream so new buffers
+	// can be created large enough to avoid growing while the sample is written
+	class SampleSizeHistory
+	{
+	public:
+		SampleSizeHistory();
+		void Add(size_t sampleSize);
+		size_t GetSuggestedCapacity() const;
+
+	private:
+		static const int HistoryLength = 32;
+		size_t m_sizes[HistoryLength];
+		int m_next;
+		int m_count;
+	};
+
+	// A contiguous sample assembled in a pooled block. The block goes back to the pool
+	// on destruction unless it was detached to hand it over to the media pipeline
+	class SampleBuffer
+	{
+	public:
+		SampleBuffer(const std::shared_ptr<SampleBufferPool>& pool, size_t expectedSize);
+		~SampleBuffer();
+
+		// Get a pointer where size bytes can be written, growing the block if necessary.
+		// Call Commit with the number of bytes actually written. Returns nullptr when out of memory
+		uint8_t* Reserve(size_t size);
+		void Commit(size_t size);
+		bool Append(const uint8_t* data, size_t size);
+
+		const uint8_t* GetData() const { return m_block ? m_block->Data : nullptr; }
+		size_t GetSize() const { return m_size; }
+
+		// Transfer ownership of the block to the caller, which must give it back to the pool
+		PooledBlock* Detach();
+
+	private:
+		SampleBuffer(const SampleBuffer&);
+		SampleBuffer& operator=(const SampleBuffer&);
+
+		std::shared_ptr<SampleBufferPool> m_pool;
+		PooledBlock* m_block;
+		size_t m_size;
+		size_t m_expectedSize;
+	};
+}
@@ -25,9 +25,10 @@ using namespace FFmpegInterop;
 UncompressedAudioSampleProvider::UncompressedAudioSampleProvider(
 	FFmpegReader^ reader,
 	AVFormatContext* avFormatCtx,
-	AVCodecContext* avCodecCtx)
+	AVCodecContext* avCodecCtx,
+	AVSampleFormat outSampleFormat)
 	: UncompressedSampleProvider(reader, avFormatCtx, avCodecCtx)
-	, m_pSwrCtx(nullptr)
+	, m_outSampleFormat(outSampleFormat)
 {
 }
 
@@ -37,32 +38,14 @@ HRESULT UncompressedAudioSampleProvider::AllocateResources()
 	hr = UncompressedSampleProvider::AllocateResources();
 	if (SUCCEEDED(hr))
 	{
-		// Set default channel layout when the value is unknown (0)
-		int64 inChannelLayout = m_pAvCodecCtx->channel_layout ? m_pAvCodecCtx->channel_layout : av_get_default_channel_layout(m_pAvCodecCtx->channels);
-		int64 outChannelLayout = av_get_default_channel_layout(m_pAvCodecCtx->channels);
-
-		// Set up resampler to convert any PCM format (e.g. AV_SAMPLE_FMT_FLTP) to AV_SAMPLE_FMT_S16 PCM format that is expected by Media Element.
-		// Additional logic can be added to avoid resampling PCM data that is already in AV_SAMPLE_FMT_S16_PCM.
-		m_pSwrCtx = swr_alloc_set_opts(
-			NULL,
-			outChannelLayout,
-			AV_SAMPLE_FMT_S16,
-			m_pAvCodecCtx->sample_rate,
-			inChannelLayout,
-			m_pAvCodecCtx->sample_fmt,
-			m_pAvCodecCtx->sample_rate,
-			0,
-			NULL);
-
-		if (!m_pSwrCtx)
+		// Convert any other PCM format (e.g. AV_SAMPLE_FMT_FLTP) to the interleaved format that is expected by Media Element,
+		// keeping the channel count and sample rate the stream was announced with
+		int ret = m_converter.Configure(m_outSampleFormat, m_pAvCodecCtx->channels, m_pAvCodecCtx->sample_rate, m_pAvCodecCtx->sample_fmt, m_pAvCodecCtx->channel_layout);
+		if (ret == AVERROR(ENOMEM))
 		{
 			hr = E_OUTOFMEMORY;
 		}
-	}
-
-	if (SUCCEEDED(hr))
-	{
-		if (swr_init(m_pSwrCtx) < 0)
+		else if (ret < 0)
 		{
 			hr = E_FAIL;
 		}
@@ -77,29 +60,33 @@ UncompressedAudioSampleProvider::~UncompressedAudioSampleProvider()
 	{
 		av_frame_free(&m_pAvFrame);
 	}
-
-	// Free 
-	swr_free(&m_pSwrCtx);
 }
 
-HRESULT UncompressedAudioSampleProvider::WriteAVPacketToStream(DataWriter^ dataWriter, AVPacket* avPacket)
+HRESULT UncompressedAudioSampleProvider::WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket)
 {
 	// Because each packet can contain multiple frames, we have already written the packet to the stream
 	// during the decode stage.
 	return S_OK;
 }
 
-HRESULT UncompressedAudioSampleProvider::ProcessDecodedFrame(DataWriter^ dataWriter)
+HRESULT UncompressedAudioSampleProvider::ProcessDecodedFrame(SampleBuffer* sampleBuffer)
 {
-	// Resample uncompressed frame to AV_SAMPLE_FMT_S16 PCM format that is expected by Media Element
-	uint8_t *resampledData = nullptr;
-	unsigned int aBufferSize = av_samples_alloc(&resampledData, NULL, m_pAvFrame->channels, m_pAvFrame->nb_samples, AV_SAMPLE_FMT_S16, 0);
-	int resampledDataSize = swr_convert(m_pSwrCtx, &resampledData, aBufferSize, (const uint8_t **)m_pAvFrame->extended_data, m_pAvFrame->nb_samples);
-	auto aBuffer = ref new Platform::Array<uint8_t>(resampledData, min(aBufferSize, (unsigned int)(resampledDataSize * m_pAvFrame->channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16))));
-	dataWriter->WriteBytes(aBuffer);
-	av_freep(&resampledData);
+	HRESULT hr = S_OK;
+
+	// Samples are written straight into the sample buffer, which accumulates
+	// all frames of the sample in one contiguous block
+	int ret = m_converter.Convert(m_pAvFrame, sampleBuffer);
+	if (ret == AVERROR(ENOMEM))
+	{
+		hr = E_OUTOFMEMORY;
+	}
+	else if (ret < 0)
+	{
+		hr = E_FAIL;
+	}
+
 	av_frame_unref(m_pAvFrame);
 	av_frame_free(&m_pAvFrame);
 
-	return S_OK;
-}
\ No newline at end of file
+	return hr;
+}
@@ -18,11 +18,7 @@
 
 #pragma once
 #include "UncompressedSampleProvider.h"
-
-extern "C"
-{
-#include <libswresample/swresample.h>
-}
+#include "AudioConverter.h"
 
 namespace FFmpegInterop
 {
@@ -35,13 +31,15 @@ namespace FFmpegInterop
 		UncompressedAudioSampleProvider(
 			FFmpegReader^ reader,
 			AVFormatContext* avFormatCtx,
-			AVCodecContext* avCodecCtx);
-		virtual HRESULT WriteAVPacketToStream(DataWriter^ writer, AVPacket* avPacket) override;
-		virtual HRESULT ProcessDecodedFrame(DataWriter^ dataWriter) override;
+			AVCodecContext* avCodecCtx,
+			AVSampleFormat outSampleFormat);
+		virtual HRESULT WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket) override;
+		virtual HRESULT ProcessDecodedFrame(SampleBuffer* sampleBuffer) override;
 		virtual HRESULT AllocateResources() override;
 
 	private:
-		SwrContext* m_pSwrCtx;
+		AudioConverter m_converter;
+		AVSampleFormat m_outSampleFormat;
 	};
 }
 
@@ -24,10 +24,18 @@ using namespace FFmpegInterop;
 UncompressedSampleProvider::UncompressedSampleProvider(FFmpegReader^ reader, AVFormatContext* avFormatCtx, AVCodecContext* avCodecCtx)
 	: MediaSampleProvider(reader, avFormatCtx, avCodecCtx)
 	, m_pAvFrame(nullptr)
+	, m_draining(false)
 {
 }
 
-HRESULT UncompressedSampleProvider::ProcessDecodedFrame(DataWriter^ dataWriter)
+void UncompressedSampleProvider::Flush()
+{
+	// The caller flushes the decoder, which leaves draining mode
+	MediaSampleProvider::Flush();
+	m_draining = false;
+}
+
+HRESULT UncompressedSampleProvider::ProcessDecodedFrame(SampleBuffer* sampleBuffer)
 {
 	return S_OK;
 }
@@ -69,6 +77,12 @@ HRESULT UncompressedSampleProvider::GetFrameFromFFmpegDecoder(AVPacket* avPacket
 			av_frame_unref(pFrame);
 			av_frame_free(&pFrame);
 		}
+		else if (decodeFrame == AVERROR_EOF)
+		{
+			// The decoder has been fully drained
+			hr = S_FALSE;
+			av_frame_free(&pFrame);
+		}
 		else if (decodeFrame < 0)
 		{
 			hr = E_FAIL;
@@ -85,7 +99,7 @@ HRESULT UncompressedSampleProvider::GetFrameFromFFmpegDecoder(AVPacket* avPacket
 	return hr;
 }
 
-HRESULT UncompressedSampleProvider::DecodeAVPacket(DataWriter^ dataWriter, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration)
+HRESULT UncompressedSampleProvider::DecodeAVPacket(SampleBuffer* sampleBuffer, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration)
 {
 	HRESULT hr = S_OK;
 	bool fGotFrame  = false;
@@ -115,9 +129,32 @@ HRESULT UncompressedSampleProvider::DecodeAVPacket(DataWriter^ dataWriter, AVPac
 			}
 			fGotFrame = true;
 
-			hr = ProcessDecodedFrame(dataWriter);
+			hr = ProcessDecodedFrame(sampleBuffer);
+
+			// While draining every call returns the next frame. One that was not consumed here
+			// is written out by WriteAVPacketToStream and must not be replaced by the next one
+			if (SUCCEEDED(hr) && m_draining && m_pAvFrame != nullptr)
+			{
+				break;
+			}
 		}
 	}
 
 	return hr;
 }
+
+HRESULT UncompressedSampleProvider::DecodeEndOfStream(SampleBuffer* sampleBuffer, int64_t& framePts, int64_t& frameDuration)
+{
+	// Frame threading and reordering delay the output, signal the end of the stream once
+	// and then keep taking the remaining frames until the decoder reports it is empty
+	if (!m_draining)
+	{
+		m_draining = true;
+		if (avcodec_send_packet(m_pAvCodecCtx, nullptr) < 0)
+		{
+			return E_FAIL;
+		}
+	}
+
+	return DecodeAVPacket(sampleBuffer, nullptr, framePts, frameDuration);
+}
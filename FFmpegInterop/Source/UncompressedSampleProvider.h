@@ -28,11 +28,15 @@ namespace FFmpegInterop
 {
 	ref class UncompressedSampleProvider abstract : public MediaSampleProvider
 	{
+	public:
+		virtual void Flush() override;
+
 	internal:
 		// Try to get a frame from FFmpeg, otherwise, feed a frame to start decoding
 		virtual HRESULT GetFrameFromFFmpegDecoder(AVPacket* avPacket);
-		virtual HRESULT DecodeAVPacket(DataWriter^ dataWriter, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration) override;
-		virtual HRESULT ProcessDecodedFrame(DataWriter^ dataWriter);
+		virtual HRESULT DecodeAVPacket(SampleBuffer* sampleBuffer, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration) override;
+		virtual HRESULT DecodeEndOfStream(SampleBuffer* sampleBuffer, int64_t& framePts, int64_t& frameDuration) override;
+		virtual HRESULT ProcessDecodedFrame(SampleBuffer* sampleBuffer);
 		UncompressedSampleProvider(
 			FFmpegReader^ reader,
 			AVFormatContext* avFormatCtx,
@@ -40,6 +44,9 @@ namespace FFmpegInterop
 
 	internal:
 		AVFrame* m_pAvFrame;
+
+	private:
+		bool m_draining;
 	};
 }
 
@@ -20,12 +20,6 @@
 #include "UncompressedVideoSampleProvider.h"
 #include <mfapi.h>
 
-extern "C"
-{
-#include <libavutil/imgutils.h>
-}
-
-
 using namespace FFmpegInterop;
 
 UncompressedVideoSampleProvider::UncompressedVideoSampleProvider(
@@ -33,13 +27,7 @@ UncompressedVideoSampleProvider::UncompressedVideoSampleProvider(
 	AVFormatContext* avFormatCtx,
 	AVCodecContext* avCodecCtx)
 	: UncompressedSampleProvider(reader, avFormatCtx, avCodecCtx)
-	, m_pSwsCtx(nullptr)
 {
-	for (int i = 0; i < 4; i++)
-	{
-		m_rgVideoBufferLineSize[i] = 0;
-		m_rgVideoBufferData[i] = nullptr;
-	}
 }
 
 HRESULT UncompressedVideoSampleProvider::AllocateResources()
@@ -48,23 +36,17 @@ HRESULT UncompressedVideoSampleProvider::AllocateResources()
 	hr = UncompressedSampleProvider::AllocateResources();
 	if (SUCCEEDED(hr))
 	{
-		// Setup software scaler to convert any decoder pixel format (e.g. YUV420P) to NV12 that is supported in Windows & Windows Phone MediaElement
-		m_pSwsCtx = sws_getContext(
-			m_pAvCodecCtx->width,
-			m_pAvCodecCtx->height,
-			m_pAvCodecCtx->pix_fmt,
-			m_pAvCodecCtx->width,
-			m_pAvCodecCtx->height,
-			AV_PIX_FMT_NV12,
-			SWS_BICUBIC,
-			NULL,
-			NULL,
-			NULL);
-
-		if (m_pSwsCtx == nullptr)
+		// Convert any decoder pixel format to NV12 that is supported in Windows & Windows Phone MediaElement.
+		// NV12 and YUV420P are copied directly, other formats fall back to the software scaler
+		int ret = m_converter.Configure(m_pAvCodecCtx->pix_fmt, m_pAvCodecCtx->width, m_pAvCodecCtx->height);
+		if (ret == AVERROR(ENOMEM))
 		{
 			hr = E_OUTOFMEMORY;
 		}
+		else if (ret < 0)
+		{
+			hr = E_FAIL;
+		}
 	}
 
 	if (SUCCEEDED(hr))
@@ -76,14 +58,6 @@ HRESULT UncompressedVideoSampleProvider::AllocateResources()
 		}
 	}
 
-	if (SUCCEEDED(hr))
-	{
-		if (av_image_alloc(m_rgVideoBufferData, m_rgVideoBufferLineSize, m_pAvCodecCtx->width, m_pAvCodecCtx->height, AV_PIX_FMT_NV12, 1) < 0)
-		{
-			hr = E_FAIL;
-		}
-	}
-
 	return hr;
 }
 
@@ -93,23 +67,24 @@ UncompressedVideoSampleProvider::~UncompressedVideoSampleProvider()
 	{
 		av_frame_free(&m_pAvFrame);
 	}
-
-	if (m_rgVideoBufferData)
-	{
-		av_freep(m_rgVideoBufferData);
-	}
 }
 
-HRESULT UncompressedVideoSampleProvider::DecodeAVPacket(DataWriter^ dataWriter, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration)
+HRESULT UncompressedVideoSampleProvider::DecodeAVPacket(SampleBuffer* sampleBuffer, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration)
 {
 	HRESULT hr = S_OK;
-	hr = UncompressedSampleProvider::DecodeAVPacket(dataWriter, avPacket, framePts, frameDuration);
+	hr = UncompressedSampleProvider::DecodeAVPacket(sampleBuffer, avPacket, framePts, frameDuration);
 
 	// Don't set a timestamp on S_FALSE
 	if (hr == S_OK)
 	{
 		// Try to get the best effort timestamp for the frame.
+		// With frame threads the frame comes from an earlier packet than the one just sent, so
+		// its timing is taken from the frame rather than from the current packet
 		framePts = av_frame_get_best_effort_timestamp(m_pAvFrame);
+		if (m_pAvFrame->pkt_duration > 0)
+		{
+			frameDuration = m_pAvFrame->pkt_duration;
+		}
 		m_interlaced_frame = m_pAvFrame->interlaced_frame == 1;
 		m_top_field_first = m_pAvFrame->top_field_first == 1;
 	}
@@ -138,20 +113,28 @@ MediaStreamSample^ UncompressedVideoSampleProvider::GetNextSample()
 	return sample;
 }
 
-HRESULT UncompressedVideoSampleProvider::WriteAVPacketToStream(DataWriter^ dataWriter, AVPacket* avPacket)
+HRESULT UncompressedVideoSampleProvider::WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket)
 {
-	// Convert decoded video pixel format to NV12 using FFmpeg software scaler
-	if (sws_scale(m_pSwsCtx, (const uint8_t **)(m_pAvFrame->data), m_pAvFrame->linesize, 0, m_pAvCodecCtx->height, m_rgVideoBufferData, m_rgVideoBufferLineSize) < 0)
+	HRESULT hr = S_OK;
+
+	// Convert the decoded frame to NV12 straight into the sample buffer
+	size_t outputSize = m_converter.GetOutputSize();
+	uint8_t* output = sampleBuffer->Reserve(outputSize);
+	if (output == nullptr)
+	{
+		hr = E_OUTOFMEMORY;
+	}
+	else if (m_converter.Convert(m_pAvFrame, output) < 0)
 	{
-		return E_FAIL;
+		hr = E_FAIL;
+	}
+	else
+	{
+		sampleBuffer->Commit(outputSize);
 	}
 
-	auto YBuffer = ref new Platform::Array<uint8_t>(m_rgVideoBufferData[0], m_rgVideoBufferLineSize[0] * m_pAvCodecCtx->height);
-	auto UVBuffer = ref new Platform::Array<uint8_t>(m_rgVideoBufferData[1], m_rgVideoBufferLineSize[1] * m_pAvCodecCtx->height / 2);
-	dataWriter->WriteBytes(YBuffer);
-	dataWriter->WriteBytes(UVBuffer);
 	av_frame_unref(m_pAvFrame);
 	av_frame_free(&m_pAvFrame);
 
-	return S_OK;
+	return hr;
 }
@@ -18,12 +18,7 @@
 
 #pragma once
 #include "UncompressedSampleProvider.h"
-
-extern "C"
-{
-#include <libswscale/swscale.h>
-}
-
+#include "Nv12Converter.h"
 
 namespace FFmpegInterop
 {
@@ -37,14 +32,12 @@ namespace FFmpegInterop
 			FFmpegReader^ reader,
 			AVFormatContext* avFormatCtx,
 			AVCodecContext* avCodecCtx);
-		virtual HRESULT WriteAVPacketToStream(DataWriter^ writer, AVPacket* avPacket) override;
-		virtual HRESULT DecodeAVPacket(DataWriter^ dataWriter, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration) override;
+		virtual HRESULT WriteAVPacketToStream(SampleBuffer* sampleBuffer, AVPacket* avPacket) override;
+		virtual HRESULT DecodeAVPacket(SampleBuffer* sampleBuffer, AVPacket* avPacket, int64_t& framePts, int64_t& frameDuration) override;
 		virtual HRESULT AllocateResources() override;
 
 	private:
-		SwsContext* m_pSwsCtx;
-		int m_rgVideoBufferLineSize[4];
-		uint8_t* m_rgVideoBufferData[4];
+		Nv12Converter m_converter;
 		bool m_interlaced_frame;
 		bool m_top_field_first;
 	};
@@ -0,0 +1,124 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Times AnnexBConverter against the h264_mp4toannexb bitstream filter on the H.264
+// packets of a file, held in memory so only the conversion is measured.
+//
+// Usage: AnnexBConverterBench file [passes]
+
+#include "AnnexBConverter.h"
+#include "TestCommon.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s file [passes]\n", argv[0]);
+		return 1;
+	}
+	int passes = argc > 2 ? atoi(argv[2]) : 20;
+
+	StreamPackets stream;
+	if (LoadStreamPackets(argv[1], AVMEDIA_TYPE_VIDEO, stream) < 0 || stream.Parameters->codec_id != AV_CODEC_ID_H264)
+	{
+		fprintf(stderr, "%s: no H.264 video stream\n", argv[1]);
+		return 1;
+	}
+
+	size_t totalBytes = 0;
+	for (AVPacket* packet : stream.Packets)
+	{
+		totalBytes += packet->size;
+	}
+
+	// The filter is used the way a player would: a reference in, a new packet out
+	AVBSFContext* bsf = nullptr;
+	if (av_bsf_alloc(av_bsf_get_by_name("h264_mp4toannexb"), &bsf) < 0 ||
+		avcodec_parameters_copy(bsf->par_in, stream.Parameters) < 0 || av_bsf_init(bsf) < 0)
+	{
+		fprintf(stderr, "Cannot open h264_mp4toannexb\n");
+		return 1;
+	}
+
+	AVPacket* out = av_packet_alloc();
+	double start = CpuSeconds();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (AVPacket* packet : stream.Packets)
+		{
+			AVPacket* ref = av_packet_clone(packet);
+			av_bsf_send_packet(bsf, ref);
+			av_packet_free(&ref);
+			while (av_bsf_receive_packet(bsf, out) >= 0)
+			{
+				av_packet_unref(out);
+			}
+		}
+	}
+	double bsfTime = CpuSeconds() - start;
+	av_packet_free(&out);
+	av_bsf_free(&bsf);
+
+	// The converter sizes the output and writes it into one reused buffer, as the
+	// sample provider does with the pooled sample buffers
+	AnnexBConverter converter;
+	if (converter.SetExtradata(stream.Parameters->extradata, stream.Parameters->extradata_size) < 0)
+	{
+		fprintf(stderr, "Invalid avcC record\n");
+		return 1;
+	}
+
+	std::vector<uint8_t> buffer;
+	int64_t checksum = 0;
+	start = CpuSeconds();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (AVPacket* packet : stream.Packets)
+		{
+			bool key = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+			int64_t size = converter.GetConvertedSize(packet->data, packet->size, key);
+			if (size < 0)
+			{
+				continue;
+			}
+			if (buffer.size() < (size_t)size)
+			{
+				buffer.resize((size_t)size);
+			}
+			checksum += converter.ConvertTo(packet->data, packet->size, key, buffer.data(), buffer.size());
+		}
+	}
+	double converterTime = CpuSeconds() - start;
+
+	double packets = (double)stream.Packets.size() * passes;
+	double megabytes = (double)totalBytes * passes / (1024 * 1024);
+	printf("%s: %zu packets, %.1f KB average, %d passes\n", argv[1], stream.Packets.size(),
+		(double)totalBytes / stream.Packets.size() / 1024, passes);
+	printf("h264_mp4toannexb: %8.1f ns/packet %8.1f MB/s\n", bsfTime * 1e9 / packets, megabytes / bsfTime);
+	printf("AnnexBConverter:  %8.1f ns/packet %8.1f MB/s (%.2fx)\n", converterTime * 1e9 / packets,
+		megabytes / converterTime, bsfTime / converterTime);
+	return checksum < 0;
+}
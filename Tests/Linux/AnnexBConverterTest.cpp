@@ -0,0 +1,319 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Checks AnnexBConverter against the h264_mp4toannexb bitstream filter on synthetic
+// streams with 1, 2 and 4 byte NAL lengths, and on the H.264 stream of every file
+// given on the command line. Files without one are skipped.
+//
+// The filter inserts the parameter sets before the first IDR slice and uses 3 byte start
+// codes after the first NAL unit, while the converter always writes 4 byte start codes and
+// puts the parameter sets first. The outputs are therefore compared as lists of NAL units:
+// everything but the SPS and PPS must be identical and in the same order, and key frames
+// must start with the parameter sets of the configuration record.
+
+#include "AnnexBConverter.h"
+#include "TestCommon.h"
+#include <string.h>
+#include <string>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/lfg.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+typedef std::vector<std::string> NalList;
+
+enum
+{
+	NalSlice = 1,
+	NalIdr = 5,
+	NalSei = 6,
+	NalSps = 7,
+	NalPps = 8,
+};
+
+// Split an Annex B byte stream at its 3 and 4 byte start codes
+static NalList SplitAnnexB(const uint8_t* data, size_t size, bool withParameterSets)
+{
+	NalList units;
+	size_t start = SIZE_MAX;
+	size_t i = 0;
+	while (i + 3 <= size)
+	{
+		if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+		{
+			if (start != SIZE_MAX)
+			{
+				size_t end = i;
+				if (end > start && data[end - 1] == 0)
+				{
+					end--;
+				}
+				units.push_back(std::string((const char*)data + start, end - start));
+			}
+			i += 3;
+			start = i;
+		}
+		else
+		{
+			i++;
+		}
+	}
+	if (start != SIZE_MAX)
+	{
+		units.push_back(std::string((const char*)data + start, size - start));
+	}
+
+	if (!withParameterSets)
+	{
+		NalList filtered;
+		for (const std::string& unit : units)
+		{
+			int type = unit.empty() ? 0 : unit[0] & 0x1f;
+			if (type != NalSps && type != NalPps)
+			{
+				filtered.push_back(unit);
+			}
+		}
+		units.swap(filtered);
+	}
+	return units;
+}
+
+// Wraps h264_mp4toannexb for one stream
+class ReferenceFilter
+{
+public:
+	ReferenceFilter(const AVCodecParameters* parameters) : m_bsf(nullptr)
+	{
+		const AVBitStreamFilter* filter = av_bsf_get_by_name("h264_mp4toannexb");
+		if (filter && av_bsf_alloc(filter, &m_bsf) >= 0)
+		{
+			if (avcodec_parameters_copy(m_bsf->par_in, parameters) < 0 || av_bsf_init(m_bsf) < 0)
+			{
+				av_bsf_free(&m_bsf);
+			}
+		}
+	}
+
+	~ReferenceFilter()
+	{
+		av_bsf_free(&m_bsf);
+	}
+
+	bool IsValid() const { return m_bsf != nullptr; }
+
+	int Filter(const AVPacket* in, AVPacket* out)
+	{
+		AVPacket* ref = av_packet_clone(in);
+		int ret = ref ? av_bsf_send_packet(m_bsf, ref) : AVERROR(ENOMEM);
+		av_packet_free(&ref);
+		return ret < 0 ? ret : av_bsf_receive_packet(m_bsf, out);
+	}
+
+private:
+	AVBSFContext* m_bsf;
+};
+
+// Compare one packet. The filter only prepends parameter sets to IDR pictures, so the
+// parameter set check is limited to those
+static void ComparePacket(AnnexBConverter& converter, ReferenceFilter& reference, const AVPacket* packet)
+{
+	bool key = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+	int64_t size = converter.GetConvertedSize(packet->data, packet->size, key);
+	CHECK(size > 0);
+	if (size <= 0)
+	{
+		return;
+	}
+
+	std::vector<uint8_t> output((size_t)size);
+	CHECK(converter.ConvertTo(packet->data, packet->size, key, output.data(), output.size()) == size);
+	CHECK(converter.ConvertTo(packet->data, packet->size, key, output.data(), output.size() - 1) == AVERROR(EINVAL));
+
+	AVPacket* filtered = av_packet_alloc();
+	CHECK(reference.Filter(packet, filtered) >= 0);
+	CHECK(SplitAnnexB(output.data(), output.size(), false) == SplitAnnexB(filtered->data, filtered->size, false));
+
+	if (key)
+	{
+		const std::vector<uint8_t>& parameterSets = converter.GetParameterSets();
+		CHECK(memcmp(output.data(), parameterSets.data(), parameterSets.size()) == 0);
+	}
+	av_packet_free(&filtered);
+}
+
+static void WriteLength(std::string& out, size_t length, int lengthSize)
+{
+	for (int i = lengthSize - 1; i >= 0; i--)
+	{
+		out.push_back((char)(length >> (8 * i)));
+	}
+}
+
+// Random NAL payload without start code emulation
+static std::string RandomNal(AVLFG* lfg, int type, size_t size)
+{
+	std::string unit(1, (char)(0x60 | type));
+	for (size_t i = 1; i < size; i++)
+	{
+		unit.push_back((char)(av_lfg_get(lfg) % 255 + 1));
+	}
+	if (type == NalIdr || type == NalSlice)
+	{
+		// first_mb_in_slice is 0 for the first slice of a picture
+		unit[1] |= 0x80;
+	}
+	return unit;
+}
+
+static void TestSyntheticStream(int lengthSize)
+{
+	AVLFG lfg;
+	av_lfg_init(&lfg, 0x1234 + lengthSize);
+
+	// 1 byte lengths limit NAL units to 255 bytes
+	size_t maxSize = lengthSize == 1 ? 255 : 3000;
+
+	std::string sps = RandomNal(&lfg, NalSps, 20);
+	std::string pps = RandomNal(&lfg, NalPps, 6);
+	std::string avcc;
+	avcc.push_back(1);
+	avcc.append(sps.substr(1, 3));
+	avcc.push_back((char)(0xfc | (lengthSize - 1)));
+	avcc.push_back((char)0xe1);
+	WriteLength(avcc, sps.size(), 2);
+	avcc.append(sps);
+	avcc.push_back(1);
+	WriteLength(avcc, pps.size(), 2);
+	avcc.append(pps);
+
+	AVCodecParameters* parameters = avcodec_parameters_alloc();
+	parameters->codec_type = AVMEDIA_TYPE_VIDEO;
+	parameters->codec_id = AV_CODEC_ID_H264;
+	parameters->extradata = (uint8_t*)av_mallocz(avcc.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+	parameters->extradata_size = (int)avcc.size();
+	memcpy(parameters->extradata, avcc.data(), avcc.size());
+
+	AnnexBConverter converter;
+	CHECK(converter.SetExtradata(parameters->extradata, parameters->extradata_size) == 0);
+	CHECK(converter.GetLengthSize() == lengthSize);
+	CHECK(SplitAnnexB(converter.GetParameterSets().data(), converter.GetParameterSets().size(), true) == NalList({ sps, pps }));
+
+	ReferenceFilter reference(parameters);
+	CHECK(reference.IsValid());
+
+	AVPacket* packet = av_packet_alloc();
+	for (int frame = 0; frame < 200 && reference.IsValid(); frame++)
+	{
+		bool key = frame % 30 == 0;
+		int slices = 1 + av_lfg_get(&lfg) % 8;
+		std::string data;
+		if (frame % 7 == 0)
+		{
+			std::string sei = RandomNal(&lfg, NalSei, 1 + av_lfg_get(&lfg) % 40);
+			WriteLength(data, sei.size(), lengthSize);
+			data.append(sei);
+		}
+		for (int i = 0; i < slices; i++)
+		{
+			std::string slice = RandomNal(&lfg, key ? NalIdr : NalSlice, 2 + av_lfg_get(&lfg) % (maxSize - 1));
+			if (i > 0)
+			{
+				slice[1] &= 0x7f;
+			}
+			WriteLength(data, slice.size(), lengthSize);
+			data.append(slice);
+		}
+
+		CHECK(av_new_packet(packet, (int)data.size()) == 0);
+		memcpy(packet->data, data.data(), data.size());
+		packet->flags = key ? AV_PKT_FLAG_KEY : 0;
+		ComparePacket(converter, reference, packet);
+		av_packet_unref(packet);
+	}
+	av_packet_free(&packet);
+	avcodec_parameters_free(&parameters);
+}
+
+static void TestMalformed()
+{
+	static const uint8_t avcc[] = { 1, 0x64, 0, 0x1f, 0xff, 0xe1, 0, 2, 0x67, 0x64, 1, 0, 1, 0x68 };
+	AnnexBConverter converter;
+
+	// Truncated records and 3 byte lengths are rejected and leave the converter unchanged
+	CHECK(converter.SetExtradata(avcc, 6) < 0);
+	CHECK(converter.SetExtradata(avcc, sizeof(avcc) - 1) < 0);
+	uint8_t threeByteLengths[sizeof(avcc)];
+	memcpy(threeByteLengths, avcc, sizeof(avcc));
+	threeByteLengths[4] = 0xfe;
+	CHECK(converter.SetExtradata(threeByteLengths, sizeof(avcc)) < 0);
+	CHECK(converter.GetParameterSets().empty());
+	CHECK(converter.SetExtradata(avcc, sizeof(avcc)) == 0);
+	CHECK(converter.GetParameterSets().size() == 2 + 4 + 1 + 4);
+
+	// Lengths that run past the end of the packet
+	static const uint8_t truncatedLength[] = { 0, 0, 0, 2, 0x65, 0x88, 0, 0 };
+	static const uint8_t truncatedUnit[] = { 0, 0, 0, 3, 0x65, 0x88 };
+	CHECK(converter.GetConvertedSize(truncatedLength, sizeof(truncatedLength), false) == AVERROR_INVALIDDATA);
+	CHECK(converter.GetConvertedSize(truncatedUnit, sizeof(truncatedUnit), false) == AVERROR_INVALIDDATA);
+
+	// Empty NAL units are dropped
+	static const uint8_t emptyUnit[] = { 0, 0, 0, 0, 0, 0, 0, 1, 0x41 };
+	uint8_t output[16];
+	CHECK(converter.ConvertTo(emptyUnit, sizeof(emptyUnit), false, output, sizeof(output)) == 5);
+	CHECK(memcmp(output, "\0\0\0\1\x41", 5) == 0);
+}
+
+static void TestFile(const char* path)
+{
+	StreamPackets stream;
+	CHECK(LoadStreamPackets(path, AVMEDIA_TYPE_VIDEO, stream) >= 0);
+	if (stream.Parameters->codec_id != AV_CODEC_ID_H264 || !stream.Parameters->extradata_size)
+	{
+		printf("%s: no AVC H.264 stream, skipped\n", path);
+		return;
+	}
+
+	AnnexBConverter converter;
+	CHECK(converter.SetExtradata(stream.Parameters->extradata, stream.Parameters->extradata_size) == 0);
+	ReferenceFilter reference(stream.Parameters);
+	CHECK(reference.IsValid());
+	for (size_t i = 0; i < stream.Packets.size() && reference.IsValid(); i++)
+	{
+		ComparePacket(converter, reference, stream.Packets[i]);
+	}
+	printf("%s: %zu packets compared\n", path, stream.Packets.size());
+}
+
+int main(int argc, char** argv)
+{
+	TestSyntheticStream(1);
+	TestSyntheticStream(2);
+	TestSyntheticStream(4);
+	TestMalformed();
+	for (int i = 1; i < argc; i++)
+	{
+		TestFile(argv[i]);
+	}
+	return TestResult("AnnexBConverterTest");
+}
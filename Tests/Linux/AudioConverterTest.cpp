@@ -0,0 +1,265 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Checks AudioConverter on random frames:
+// - a frame is copied byte for byte only when its sample format, channel count, channel layout
+//   and sample rate all match the output, with a layout of 0 standing for the default one;
+// - a frame that differs in any one of them goes through swresample and gives the same samples
+//   as a SwrContext set up for it, including a channel count or rate change mid-stream;
+// - float output is exact for float and S16 input, so nothing is quantized on the way.
+
+#include "AudioConverter.h"
+#include "TestCommon.h"
+#include <string.h>
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+#include <libavutil/lfg.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+static const int OutChannels = 2;
+static const int OutSampleRate = 48000;
+
+// Frame of random samples, floats are kept within [-1, 1]
+static AVFrame* RandomFrame(AVLFG* lfg, AVSampleFormat format, int channels, int64_t channelLayout, int sampleRate, int samples)
+{
+	AVFrame* frame = av_frame_alloc();
+	frame->format = format;
+	frame->channels = channels;
+	frame->channel_layout = channelLayout;
+	frame->sample_rate = sampleRate;
+	frame->nb_samples = samples;
+	if (av_frame_get_buffer(frame, 0) < 0)
+	{
+		av_frame_free(&frame);
+		return nullptr;
+	}
+
+	int planes = av_sample_fmt_is_planar(format) ? channels : 1;
+	int count = samples * (av_sample_fmt_is_planar(format) ? 1 : channels);
+	for (int plane = 0; plane < planes; plane++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (av_get_packed_sample_fmt(format) == AV_SAMPLE_FMT_FLT)
+			{
+				((float*)frame->extended_data[plane])[i] = (float)((int)(av_lfg_get(lfg) & 0xffff) - 0x8000) / 0x8000;
+			}
+			else
+			{
+				((int16_t*)frame->extended_data[plane])[i] = (int16_t)av_lfg_get(lfg);
+			}
+		}
+	}
+	return frame;
+}
+
+// Converts frames the way AudioConverter is expected to when they need swresample
+struct ReferenceResampler
+{
+	ReferenceResampler(AVSampleFormat outFormat, const AVFrame* frame)
+		: Context(swr_alloc_set_opts(nullptr, av_get_default_channel_layout(OutChannels), outFormat, OutSampleRate,
+			frame->channel_layout ? frame->channel_layout : av_get_default_channel_layout(frame->channels),
+			(AVSampleFormat)frame->format, frame->sample_rate, 0, nullptr))
+		, FrameSize(av_get_bytes_per_sample(outFormat) * OutChannels)
+	{
+		CHECK(Context != nullptr && swr_init(Context) >= 0);
+	}
+
+	~ReferenceResampler()
+	{
+		swr_free(&Context);
+	}
+
+	void Convert(const AVFrame* frame, std::vector<uint8_t>& output)
+	{
+		int outSamples = swr_get_out_samples(Context, frame->nb_samples);
+		size_t offset = output.size();
+		output.resize(offset + (size_t)outSamples * FrameSize);
+		uint8_t* data = output.data() + offset;
+		int converted = swr_convert(Context, &data, outSamples, (const uint8_t**)frame->extended_data, frame->nb_samples);
+		CHECK(converted >= 0);
+		output.resize(offset + (size_t)std::max(converted, 0) * FrameSize);
+	}
+
+	SwrContext* Context;
+	int FrameSize;
+};
+
+static bool SameBytes(const SampleBuffer& sample, const std::vector<uint8_t>& expected)
+{
+	return sample.GetSize() == expected.size() && (expected.empty() || memcmp(sample.GetData(), expected.data(), expected.size()) == 0);
+}
+
+static void TestPassthrough(AVLFG* lfg, const std::shared_ptr<SampleBufferPool>& pool, AVSampleFormat outFormat)
+{
+	AudioConverter converter;
+	CHECK(converter.Configure(outFormat, OutChannels, OutSampleRate, outFormat, 0) == 0);
+	CHECK(converter.GetOutputFrameSize() == av_get_bytes_per_sample(outFormat) * OutChannels);
+
+	// The stereo layout itself and the unknown layout of a stereo frame
+	static const int64_t layouts[] = { AV_CH_LAYOUT_STEREO, 0 };
+	SampleBuffer sample(pool, 0);
+	std::vector<uint8_t> expected;
+	for (int64_t layout : layouts)
+	{
+		AVFrame* frame = RandomFrame(lfg, outFormat, OutChannels, layout, OutSampleRate, 1024);
+		CHECK(converter.Convert(frame, &sample) == 0);
+		CHECK(converter.GetPath() == AudioConverter::PathCopy);
+		expected.insert(expected.end(), frame->data[0], frame->data[0] + 1024 * converter.GetOutputFrameSize());
+		av_frame_free(&frame);
+	}
+	CHECK(SameBytes(sample, expected));
+}
+
+// Frames that differ from the output in one property each, as if the decoder switched mid-stream
+static void TestMismatch(AVLFG* lfg, const std::shared_ptr<SampleBufferPool>& pool, AVSampleFormat outFormat)
+{
+	AVSampleFormat otherFormat = outFormat == AV_SAMPLE_FMT_S16 ? AV_SAMPLE_FMT_FLT : AV_SAMPLE_FMT_S16;
+	struct Case
+	{
+		const char* Name;
+		AVSampleFormat Format;
+		int Channels;
+		int64_t Layout;
+		int SampleRate;
+	};
+	const Case cases[] = {
+		{ "format", otherFormat, OutChannels, AV_CH_LAYOUT_STEREO, OutSampleRate },
+		{ "planar format", av_get_planar_sample_fmt(outFormat), OutChannels, AV_CH_LAYOUT_STEREO, OutSampleRate },
+		{ "mono", outFormat, 1, AV_CH_LAYOUT_MONO, OutSampleRate },
+		{ "5.1", outFormat, 6, AV_CH_LAYOUT_5POINT1, OutSampleRate },
+		{ "downmix layout", outFormat, OutChannels, AV_CH_LAYOUT_STEREO_DOWNMIX, OutSampleRate },
+		{ "rate", outFormat, OutChannels, AV_CH_LAYOUT_STEREO, 44100 },
+	};
+
+	for (const Case& c : cases)
+	{
+		AudioConverter converter;
+		CHECK(converter.Configure(outFormat, OutChannels, OutSampleRate, outFormat, AV_CH_LAYOUT_STEREO) == 0);
+
+		// Start and end with frames that match, the resampler is set up for the others
+		// when they arrive and the frames around them are still copied
+		SampleBuffer sample(pool, 0);
+		std::vector<uint8_t> expected;
+		AVFrame* matching = RandomFrame(lfg, outFormat, OutChannels, AV_CH_LAYOUT_STEREO, OutSampleRate, 960);
+		size_t matchingSize = 960 * (size_t)converter.GetOutputFrameSize();
+		CHECK(converter.Convert(matching, &sample) == 0);
+		CHECK(converter.GetPath() == AudioConverter::PathCopy);
+		expected.insert(expected.end(), matching->data[0], matching->data[0] + matchingSize);
+
+		AVFrame* frame = RandomFrame(lfg, c.Format, c.Channels, c.Layout, c.SampleRate, 1152);
+		ReferenceResampler reference(outFormat, frame);
+		for (int i = 0; i < 4; i++)
+		{
+			CHECK(converter.Convert(frame, &sample) == 0);
+			CHECK(converter.GetPath() == AudioConverter::PathResample);
+			reference.Convert(frame, expected);
+		}
+
+		CHECK(converter.Convert(matching, &sample) == 0);
+		CHECK(converter.GetPath() == AudioConverter::PathCopy);
+		expected.insert(expected.end(), matching->data[0], matching->data[0] + matchingSize);
+
+		if (!SameBytes(sample, expected))
+		{
+			fprintf(stderr, "%s output, %s frame: %zu bytes, expected %zu\n", av_get_sample_fmt_name(outFormat), c.Name,
+				sample.GetSize(), expected.size());
+			CHECK(SameBytes(sample, expected));
+		}
+		av_frame_free(&frame);
+		av_frame_free(&matching);
+	}
+}
+
+// Float output keeps every sample of float and S16 input exactly
+static void TestFloatOutput(AVLFG* lfg, const std::shared_ptr<SampleBufferPool>& pool)
+{
+	static const AVSampleFormat formats[] = { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_S16P };
+	for (AVSampleFormat format : formats)
+	{
+		AudioConverter converter;
+		CHECK(converter.Configure(AV_SAMPLE_FMT_FLT, OutChannels, OutSampleRate, format, 0) == 0);
+		CHECK(converter.GetOutputFrameSize() == 4 * OutChannels);
+
+		const int samples = 1024;
+		AVFrame* frame = RandomFrame(lfg, format, OutChannels, AV_CH_LAYOUT_STEREO, OutSampleRate, samples);
+		SampleBuffer sample(pool, 0);
+		CHECK(converter.Convert(frame, &sample) == 0);
+		CHECK(converter.GetPath() == (format == AV_SAMPLE_FMT_FLT ? AudioConverter::PathCopy : AudioConverter::PathResample));
+		CHECK(sample.GetSize() == (size_t)samples * converter.GetOutputFrameSize());
+
+		if (sample.GetSize() == (size_t)samples * converter.GetOutputFrameSize())
+		{
+			const float* output = (const float*)sample.GetData();
+			bool planar = av_sample_fmt_is_planar(format) != 0;
+			int mismatches = 0;
+			for (int i = 0; i < samples; i++)
+			{
+				for (int ch = 0; ch < OutChannels; ch++)
+				{
+					int plane = planar ? ch : 0;
+					int index = planar ? i : i * OutChannels + ch;
+					float expected = av_get_packed_sample_fmt(format) == AV_SAMPLE_FMT_FLT ?
+						((const float*)frame->extended_data[plane])[index] :
+						((const int16_t*)frame->extended_data[plane])[index] / 32768.0f;
+					mismatches += output[i * OutChannels + ch] != expected;
+				}
+			}
+			if (mismatches)
+			{
+				fprintf(stderr, "%s to flt: %d samples differ\n", av_get_sample_fmt_name(format), mismatches);
+				CHECK(mismatches == 0);
+			}
+		}
+		av_frame_free(&frame);
+	}
+}
+
+static void TestConfigure()
+{
+	AudioConverter converter;
+	CHECK(converter.Configure(AV_SAMPLE_FMT_S16, 0, OutSampleRate, AV_SAMPLE_FMT_S16, 0) == AVERROR(EINVAL));
+	CHECK(converter.Configure(AV_SAMPLE_FMT_S16, OutChannels, 0, AV_SAMPLE_FMT_S16, 0) == AVERROR(EINVAL));
+	CHECK(converter.Configure(AV_SAMPLE_FMT_NONE, OutChannels, OutSampleRate, AV_SAMPLE_FMT_S16, 0) == AVERROR(EINVAL));
+
+	// A stream announced as 5.1 keeps 6 channels in its output
+	CHECK(converter.Configure(AV_SAMPLE_FMT_S16, 6, OutSampleRate, AV_SAMPLE_FMT_FLTP, AV_CH_LAYOUT_5POINT1) == 0);
+	CHECK(converter.GetOutputFrameSize() == 12);
+}
+
+int main()
+{
+	AVLFG lfg;
+	av_lfg_init(&lfg, 0x415544);
+	std::shared_ptr<SampleBufferPool> pool = std::make_shared<SampleBufferPool>();
+
+	static const AVSampleFormat outFormats[] = { AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_FLT };
+	for (AVSampleFormat outFormat : outFormats)
+	{
+		TestPassthrough(&lfg, pool, outFormat);
+		TestMismatch(&lfg, pool, outFormat);
+	}
+	TestFloatOutput(&lfg, pool);
+	TestConfigure();
+	return TestResult("AudioConverterTest");
+}
@@ -0,0 +1,326 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Decodes the audio of media files into memory and replays the frames into samples of
+// MINAUDIOSAMPLEDURATION (50 ms), as UncompressedAudioSampleProvider builds them, through
+// - the previous path, which resampled every frame to S16 in a buffer from av_samples_alloc
+//   and copied it into the sample;
+// - AudioConverter with S16 output, which copies matching frames as is and resamples the
+//   others straight into the pooled sample buffer;
+// - AudioConverter with float output.
+// Prints the heap allocations per second of audio and the CPU time per second of audio of each.
+// The media pipeline holds on to a few samples before releasing them, modelled here by keeping
+// the last "inflight" samples alive.
+//
+// Usage: AudioSampleProviderBench [-p passes] [-i inflight] file...
+
+#include "AudioConverter.h"
+#include "TestCommon.h"
+#include <unistd.h>
+#include <deque>
+#include <memory>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/channel_layout.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+// MINAUDIOSAMPLEDURATION in FFmpegInteropMSS.cpp
+static const double SampleDuration = 0.05;
+
+struct DecodedAudio
+{
+	~DecodedAudio()
+	{
+		for (AVFrame* frame : Frames)
+		{
+			av_frame_free(&frame);
+		}
+	}
+
+	std::vector<AVFrame*> Frames;
+	AVSampleFormat Format;
+	int Channels;
+	int64_t ChannelLayout;
+	int SampleRate;
+	double Seconds;
+	const char* CodecName;
+};
+
+static int DecodeAudio(const char* path, DecodedAudio& audio)
+{
+	StreamPackets stream;
+	int ret = LoadStreamPackets(path, AVMEDIA_TYPE_AUDIO, stream);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	AVCodec* codec = avcodec_find_decoder(stream.Parameters->codec_id);
+	AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+	if (codecCtx == nullptr)
+	{
+		return AVERROR_DECODER_NOT_FOUND;
+	}
+
+	ret = avcodec_parameters_to_context(codecCtx, stream.Parameters);
+	if (ret >= 0)
+	{
+		ret = avcodec_open2(codecCtx, codec, nullptr);
+	}
+
+	int64_t samples = 0;
+	AVFrame* frame = av_frame_alloc();
+	for (size_t i = 0; ret >= 0 && i <= stream.Packets.size(); i++)
+	{
+		// A null packet after the last one drains the decoder
+		ret = avcodec_send_packet(codecCtx, i < stream.Packets.size() ? stream.Packets[i] : nullptr);
+		if (ret == AVERROR_INVALIDDATA)
+		{
+			ret = 0;
+			continue;
+		}
+		while (ret >= 0 && (ret = avcodec_receive_frame(codecCtx, frame)) >= 0)
+		{
+			samples += frame->nb_samples;
+			audio.Frames.push_back(av_frame_clone(frame));
+			av_frame_unref(frame);
+		}
+		if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+		{
+			ret = 0;
+		}
+	}
+	av_frame_free(&frame);
+
+	// The stream as announced to the media pipeline, which the output keeps
+	audio.Format = codecCtx->sample_fmt;
+	audio.Channels = codecCtx->channels;
+	audio.ChannelLayout = codecCtx->channel_layout;
+	audio.SampleRate = codecCtx->sample_rate;
+	audio.Seconds = codecCtx->sample_rate > 0 ? (double)samples / codecCtx->sample_rate : 0;
+	audio.CodecName = codec->name;
+	avcodec_free_context(&codecCtx);
+	return ret < 0 ? ret : audio.Frames.empty() ? AVERROR_INVALIDDATA : 0;
+}
+
+// UncompressedAudioSampleProvider before AudioConverter, always converting to S16
+struct PreviousPath
+{
+	PreviousPath(const DecodedAudio& audio)
+		: Allocations(0)
+	{
+		int64_t layout = audio.ChannelLayout ? audio.ChannelLayout : av_get_default_channel_layout(audio.Channels);
+		Context = swr_alloc_set_opts(nullptr, layout, AV_SAMPLE_FMT_S16, audio.SampleRate,
+			layout, audio.Format, audio.SampleRate, 0, nullptr);
+		if (Context != nullptr && swr_init(Context) < 0)
+		{
+			swr_free(&Context);
+		}
+	}
+
+	~PreviousPath()
+	{
+		swr_free(&Context);
+	}
+
+	int Convert(const AVFrame* frame, SampleBuffer* sampleBuffer)
+	{
+		uint8_t* resampledData = nullptr;
+		int bufferSize = av_samples_alloc(&resampledData, nullptr, frame->channels, frame->nb_samples, AV_SAMPLE_FMT_S16, 0);
+		if (bufferSize < 0)
+		{
+			return bufferSize;
+		}
+		Allocations++;
+
+		int resampled = swr_convert(Context, &resampledData, bufferSize, (const uint8_t**)frame->extended_data, frame->nb_samples);
+		bool written = resampled >= 0 && sampleBuffer->Append(resampledData,
+			std::min(bufferSize, resampled * frame->channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16)));
+		av_freep(&resampledData);
+		return written ? 0 : AVERROR(ENOMEM);
+	}
+
+	SwrContext* Context;
+	size_t Allocations;
+};
+
+struct RunResult
+{
+	double CpuSeconds;
+	size_t Allocations;
+	size_t Copied;
+	size_t Frames;
+};
+
+// Builds the samples of every pass through convert, which returns < 0 on failure
+template <typename Convert>
+static int Replay(const DecodedAudio& audio, int passes, size_t inflightCount, Convert convert, RunResult& result)
+{
+	std::shared_ptr<SampleBufferPool> pool = std::make_shared<SampleBufferPool>();
+	SampleSizeHistory history;
+	std::deque<PooledBlock*> inflight;
+	int64_t samplesPerSample = (int64_t)(SampleDuration * audio.SampleRate);
+
+	double start = CpuSeconds();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		size_t i = 0;
+		while (i < audio.Frames.size())
+		{
+			// Frames are added until the sample lasts MINAUDIOSAMPLEDURATION, as in GetNextSample
+			SampleBuffer sample(pool, history.GetSuggestedCapacity());
+			int64_t samples = 0;
+			while (i < audio.Frames.size() && samples < samplesPerSample)
+			{
+				if (convert(audio.Frames[i], &sample) < 0)
+				{
+					return -1;
+				}
+				samples += audio.Frames[i++]->nb_samples;
+			}
+			history.Add(sample.GetSize());
+
+			inflight.push_back(sample.Detach());
+			if (inflight.size() > inflightCount)
+			{
+				pool->Release(inflight.front());
+				inflight.pop_front();
+			}
+		}
+	}
+	for (PooledBlock* block : inflight)
+	{
+		pool->Release(block);
+	}
+
+	result.CpuSeconds = CpuSeconds() - start;
+	result.Allocations = pool->GetAllocationCount();
+	return 0;
+}
+
+static void PrintResult(const char* name, const RunResult& result, double audioSeconds)
+{
+	printf("  %-18s %8.2f allocations/s %8.1f us CPU/s", name, result.Allocations / audioSeconds,
+		result.CpuSeconds * 1e6 / audioSeconds);
+	if (result.Frames)
+	{
+		printf("  %zu of %zu frames copied", result.Copied, result.Frames);
+	}
+	printf("\n");
+}
+
+static int RunFile(const char* path, int passes, size_t inflightCount)
+{
+	DecodedAudio audio;
+	if (DecodeAudio(path, audio) < 0)
+	{
+		fprintf(stderr, "Cannot decode the audio of %s\n", path);
+		return -1;
+	}
+
+	double audioSeconds = audio.Seconds * passes;
+	char layout[64];
+	av_get_channel_layout_string(layout, sizeof(layout), audio.Channels, audio.ChannelLayout);
+	printf("%s: %s %s %s %d Hz, %.1f s, %zu frames, %d passes, %zu in flight\n", path, audio.CodecName,
+		av_get_sample_fmt_name(audio.Format), layout, audio.SampleRate, audio.Seconds, audio.Frames.size(), passes, inflightCount);
+
+	PreviousPath previous(audio);
+	if (previous.Context == nullptr)
+	{
+		fprintf(stderr, "Cannot set up the resampler for %s\n", path);
+		return -1;
+	}
+	RunResult result = {};
+	if (Replay(audio, passes, inflightCount, [&](const AVFrame* frame, SampleBuffer* sample) { return previous.Convert(frame, sample); }, result) < 0)
+	{
+		fprintf(stderr, "Previous path failed on %s\n", path);
+		return -1;
+	}
+	result.Allocations += previous.Allocations;
+	PrintResult("previous S16", result, audioSeconds);
+
+	static const AVSampleFormat formats[] = { AV_SAMPLE_FMT_S16, AV_SAMPLE_FMT_FLT };
+	for (AVSampleFormat format : formats)
+	{
+		AudioConverter converter;
+		if (converter.Configure(format, audio.Channels, audio.SampleRate, audio.Format, audio.ChannelLayout) < 0)
+		{
+			fprintf(stderr, "Cannot set up the converter for %s\n", path);
+			return -1;
+		}
+
+		result = RunResult();
+		auto convert = [&](const AVFrame* frame, SampleBuffer* sample)
+		{
+			int ret = converter.Convert(frame, sample);
+			result.Copied += converter.GetPath() == AudioConverter::PathCopy;
+			result.Frames++;
+			return ret;
+		};
+		if (Replay(audio, passes, inflightCount, convert, result) < 0)
+		{
+			fprintf(stderr, "AudioConverter failed on %s\n", path);
+			return -1;
+		}
+		PrintResult(format == AV_SAMPLE_FMT_S16 ? "AudioConverter S16" : "AudioConverter FLT", result, audioSeconds);
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	int passes = 10;
+	size_t inflightCount = 8;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:i:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p':
+			passes = atoi(optarg);
+			break;
+		case 'i':
+			inflightCount = (size_t)atoi(optarg);
+			break;
+		default:
+			optind = argc + 1;
+			break;
+		}
+	}
+	if (optind >= argc || passes <= 0)
+	{
+		fprintf(stderr, "Usage: %s [-p passes] [-i inflight] file...\n", argv[0]);
+		return 1;
+	}
+
+	av_register_all();
+	av_log_set_level(AV_LOG_ERROR);
+	for (int i = optind; i < argc; i++)
+	{
+		if (RunFile(argv[i], passes, inflightCount) < 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,144 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Decodes the video stream of a file with the thread settings ConfigureDecoderThreading picks
+// for 1, 2, 4 and 8 threads, in auto and low latency mode, and prints the decoding speed and
+// how many packets go in before the first frame comes out.
+// Wall time is measured, so the speed only scales with as many cores as are free.
+//
+// Usage: DecoderThreadingBench [-p passes] file
+
+#include "DecoderThreading.h"
+#include "TestCommon.h"
+#include <unistd.h>
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+struct BenchResult
+{
+	int ThreadCount;
+	int ThreadType;
+	size_t Frames;
+	size_t OutputDelay;
+	double Seconds;
+};
+
+static int Decode(const StreamPackets& stream, const DecoderThreadingOptions& options, BenchResult& result)
+{
+	AVCodec* codec = avcodec_find_decoder(stream.Parameters->codec_id);
+	AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+	if (codecCtx == nullptr)
+	{
+		return AVERROR_DECODER_NOT_FOUND;
+	}
+
+	int ret = avcodec_parameters_to_context(codecCtx, stream.Parameters);
+	if (ret >= 0)
+	{
+		codecCtx->pkt_timebase = stream.TimeBase;
+		ConfigureDecoderThreading(codecCtx, codec, options);
+		result.ThreadCount = codecCtx->thread_count;
+		result.ThreadType = codecCtx->thread_type;
+		ret = avcodec_open2(codecCtx, codec, nullptr);
+	}
+
+	AVFrame* frame = av_frame_alloc();
+	double start = NowSeconds();
+	for (size_t i = 0; ret >= 0 && i <= stream.Packets.size(); i++)
+	{
+		ret = avcodec_send_packet(codecCtx, i < stream.Packets.size() ? stream.Packets[i] : nullptr);
+		while (ret >= 0 && (ret = avcodec_receive_frame(codecCtx, frame)) >= 0)
+		{
+			if (result.Frames++ == 0)
+			{
+				result.OutputDelay = i;
+			}
+			av_frame_unref(frame);
+		}
+		if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+		{
+			ret = 0;
+		}
+	}
+	result.Seconds += NowSeconds() - start;
+
+	av_frame_free(&frame);
+	avcodec_free_context(&codecCtx);
+	return ret;
+}
+
+int main(int argc, char** argv)
+{
+	int passes = 3;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p':
+			passes = atoi(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1 || passes <= 0)
+	{
+		fprintf(stderr, "Usage: %s [-p passes] file\n", argv[0]);
+		return 1;
+	}
+
+	StreamPackets stream;
+	if (LoadStreamPackets(argv[optind], AVMEDIA_TYPE_VIDEO, stream) < 0)
+	{
+		fprintf(stderr, "Cannot read the video stream of %s\n", argv[optind]);
+		return 1;
+	}
+
+	printf("%s: %s %dx%d, %zu packets, %d passes, %d cores\n", argv[optind], avcodec_get_name(stream.Parameters->codec_id),
+		stream.Parameters->width, stream.Parameters->height, stream.Packets.size(), passes, av_cpu_count());
+	static const int threadCounts[] = { 1, 2, 4, 8 };
+	for (int lowLatency = 0; lowLatency < 2; lowLatency++)
+	{
+		for (int threadCount : threadCounts)
+		{
+			DecoderThreadingOptions options;
+			options.ThreadCount = threadCount;
+			options.LowLatency = lowLatency != 0;
+
+			BenchResult result = {};
+			for (int pass = 0; pass < passes; pass++)
+			{
+				result.Frames = 0;
+				if (Decode(stream, options, result) < 0)
+				{
+					fprintf(stderr, "Decoding failed with %d threads\n", threadCount);
+					return 1;
+				}
+			}
+
+			const char* threadType = result.ThreadType == FF_THREAD_FRAME ? "frame" : result.ThreadType == FF_THREAD_SLICE ? "slice" : "none";
+			printf("%-11s %d threads: %-5s x%d %5zu frames %8.1f fps, first frame after %zu packets\n",
+				lowLatency ? "low latency" : "auto", threadCount, threadType, result.ThreadCount, result.Frames,
+				result.Frames * passes / result.Seconds, result.OutputDelay + 1);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,227 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Checks the thread policy of ConfigureDecoderThreading for codecs with frame threads, slice
+// threads, both or none, and the parsing of the thread type option.
+//
+// Then decodes the video stream of every file given on the command line the way
+// UncompressedSampleProvider does (send a packet, receive frames until EAGAIN, drain at the
+// end of the stream) with 1, 2, 4 and 8 threads in every mode. The frame count, PTS,
+// durations and the MD5 of the pictures must match the single thread decode.
+
+#include "DecoderThreading.h"
+#include "TestCommon.h"
+#include <string.h>
+#include <string>
+
+extern "C"
+{
+#include <libavutil/cpu.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/md5.h>
+#include <libavutil/pixdesc.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+struct DecodedFrame
+{
+	int64_t Pts;
+	int64_t Duration;
+	std::string Md5;
+
+	bool operator==(const DecodedFrame& other) const
+	{
+		return Pts == other.Pts && Duration == other.Duration && Md5 == other.Md5;
+	}
+};
+
+static DecoderThreadingOptions MakeOptions(int threadCount, DecoderThreadingMode mode, bool lowLatency)
+{
+	DecoderThreadingOptions options;
+	options.ThreadCount = threadCount;
+	options.Mode = mode;
+	options.LowLatency = lowLatency;
+	return options;
+}
+
+// thread_type chosen for a codec, 0 for a single thread
+static int ThreadTypeFor(AVCodecID codecId, const DecoderThreadingOptions& options)
+{
+	AVCodec* codec = avcodec_find_decoder(codecId);
+	AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+	if (codecCtx == nullptr)
+	{
+		return -1;
+	}
+
+	ConfigureDecoderThreading(codecCtx, codec, options);
+	int threadType = codecCtx->thread_count > 1 ? codecCtx->thread_type : 0;
+	CHECK(threadType != 0 || (codecCtx->thread_count == 1 && codecCtx->thread_type == 0));
+	CHECK(threadType == 0 || codecCtx->thread_count == (options.ThreadCount > 0 ? options.ThreadCount : std::min(av_cpu_count(), 16)));
+	avcodec_free_context(&codecCtx);
+	return threadType;
+}
+
+static void TestPolicy()
+{
+	avcodec_register_all();
+
+	// H.264 has both thread types, MPEG-4 only frame threads, PCM none
+	CHECK(ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(4, ThreadingAuto, false)) == FF_THREAD_FRAME);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(4, ThreadingAuto, true)) == FF_THREAD_SLICE);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(4, ThreadingFrame, true)) == FF_THREAD_FRAME);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(4, ThreadingSlice, false)) == FF_THREAD_SLICE);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(4, ThreadingNone, false)) == 0);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(1, ThreadingAuto, false)) == 0);
+
+	CHECK(ThreadTypeFor(AV_CODEC_ID_MPEG4, MakeOptions(4, ThreadingAuto, true)) == FF_THREAD_FRAME);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_MPEG4, MakeOptions(4, ThreadingSlice, false)) == FF_THREAD_FRAME);
+	CHECK(ThreadTypeFor(AV_CODEC_ID_PCM_S16LE, MakeOptions(4, ThreadingAuto, false)) == 0);
+
+	// 0 threads is one per core
+	int automatic = ThreadTypeFor(AV_CODEC_ID_H264, MakeOptions(0, ThreadingAuto, false));
+	CHECK(automatic == (av_cpu_count() > 1 ? FF_THREAD_FRAME : 0));
+
+	DecoderThreadingMode mode = ThreadingAuto;
+	CHECK(ParseDecoderThreadingMode("slice", &mode) && mode == ThreadingSlice);
+	CHECK(ParseDecoderThreadingMode("frame", &mode) && mode == ThreadingFrame);
+	CHECK(ParseDecoderThreadingMode("none", &mode) && mode == ThreadingNone);
+	CHECK(ParseDecoderThreadingMode("auto", &mode) && mode == ThreadingAuto);
+	CHECK(!ParseDecoderThreadingMode("Slice", &mode) && mode == ThreadingAuto);
+	CHECK(!ParseDecoderThreadingMode("", &mode));
+}
+
+static std::string PictureMd5(const AVFrame* frame)
+{
+	const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get((AVPixelFormat)frame->format);
+	AVMD5* md5 = av_md5_alloc();
+	av_md5_init(md5);
+	for (int plane = 0; plane < 4 && frame->data[plane]; plane++)
+	{
+		bool chroma = plane == 1 || plane == 2;
+		int rows = chroma ? AV_CEIL_RSHIFT(frame->height, descriptor->log2_chroma_h) : frame->height;
+		int rowBytes = av_image_get_linesize((AVPixelFormat)frame->format, frame->width, plane);
+		for (int y = 0; y < rows; y++)
+		{
+			av_md5_update(md5, frame->data[plane] + y * frame->linesize[plane], rowBytes);
+		}
+	}
+
+	uint8_t digest[16];
+	av_md5_final(md5, digest);
+	av_free(md5);
+	char hex[33];
+	for (int i = 0; i < 16; i++)
+	{
+		snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+	}
+	return hex;
+}
+
+// Returns false when the decoder cannot be opened or fails
+static bool DecodeStream(const StreamPackets& stream, const DecoderThreadingOptions& options, std::vector<DecodedFrame>& frames)
+{
+	AVCodec* codec = avcodec_find_decoder(stream.Parameters->codec_id);
+	AVCodecContext* codecCtx = codec ? avcodec_alloc_context3(codec) : nullptr;
+	if (codecCtx == nullptr || avcodec_parameters_to_context(codecCtx, stream.Parameters) < 0)
+	{
+		avcodec_free_context(&codecCtx);
+		return false;
+	}
+	codecCtx->pkt_timebase = stream.TimeBase;
+	ConfigureDecoderThreading(codecCtx, codec, options);
+	if (avcodec_open2(codecCtx, codec, nullptr) < 0)
+	{
+		avcodec_free_context(&codecCtx);
+		return false;
+	}
+
+	bool result = true;
+	AVFrame* frame = av_frame_alloc();
+	for (size_t i = 0; i <= stream.Packets.size() && result; i++)
+	{
+		// A null packet after the last one drains the decoder
+		if (avcodec_send_packet(codecCtx, i < stream.Packets.size() ? stream.Packets[i] : nullptr) < 0)
+		{
+			result = false;
+			break;
+		}
+
+		int ret;
+		while ((ret = avcodec_receive_frame(codecCtx, frame)) >= 0)
+		{
+			frames.push_back({ frame->pts, frame->pkt_duration, PictureMd5(frame) });
+			av_frame_unref(frame);
+		}
+		result = ret == AVERROR(EAGAIN) || ret == AVERROR_EOF;
+	}
+
+	av_frame_free(&frame);
+	avcodec_free_context(&codecCtx);
+	return result;
+}
+
+static void TestFile(const char* path)
+{
+	StreamPackets stream;
+	CHECK(LoadStreamPackets(path, AVMEDIA_TYPE_VIDEO, stream) >= 0);
+
+	std::vector<DecodedFrame> reference;
+	CHECK(DecodeStream(stream, MakeOptions(1, ThreadingNone, false), reference));
+	CHECK(!reference.empty());
+
+	static const struct
+	{
+		DecoderThreadingMode Mode;
+		bool LowLatency;
+		const char* Name;
+	} modes[] = {
+		{ ThreadingAuto, false, "auto" },
+		{ ThreadingAuto, true, "low latency" },
+		{ ThreadingFrame, false, "frame" },
+		{ ThreadingSlice, false, "slice" },
+	};
+	static const int threadCounts[] = { 1, 2, 4, 8 };
+	for (const auto& mode : modes)
+	{
+		for (int threadCount : threadCounts)
+		{
+			std::vector<DecodedFrame> frames;
+			CHECK(DecodeStream(stream, MakeOptions(threadCount, mode.Mode, mode.LowLatency), frames));
+			if (frames != reference)
+			{
+				fprintf(stderr, "%s: %s, %d threads: %zu frames differ from the %zu single thread frames\n",
+					path, mode.Name, threadCount, frames.size(), reference.size());
+				FailureCount++;
+			}
+		}
+	}
+	printf("%s: %s, %zu frames compared\n", path, avcodec_get_name(stream.Parameters->codec_id), reference.size());
+}
+
+int main(int argc, char** argv)
+{
+	TestPolicy();
+	for (int i = 1; i < argc; i++)
+	{
+		TestFile(argv[i]);
+	}
+	return TestResult("DecoderThreadingTest");
+}
@@ -0,0 +1,160 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Measures the frames per second of writing decoded YUV420P and NV12 frames into an NV12
+// sample buffer:
+// - the previous route, a bicubic SwsContext into an intermediate image that was then
+//   appended to the sample;
+// - Nv12Converter writing straight into the sample.
+//
+// Usage: Nv12ConverterBench [-f frames] WIDTHxHEIGHT...
+
+#include "Nv12Converter.h"
+#include "TestCommon.h"
+#include <string.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+static AVFrame* GradientFrame(AVPixelFormat format, int width, int height)
+{
+	AVFrame* frame = av_frame_alloc();
+	frame->format = format;
+	frame->width = width;
+	frame->height = height;
+	if (av_frame_get_buffer(frame, 64) < 0)
+	{
+		av_frame_free(&frame);
+		return nullptr;
+	}
+
+	for (int plane = 0; plane < 4 && frame->data[plane]; plane++)
+	{
+		int rows = plane ? (height + 1) >> 1 : height;
+		for (int y = 0; y < rows; y++)
+		{
+			for (int x = 0; x < frame->linesize[plane]; x++)
+			{
+				frame->data[plane][y * frame->linesize[plane] + x] = (uint8_t)(x + y * 3 + plane * 64);
+			}
+		}
+	}
+	return frame;
+}
+
+// UncompressedVideoSampleProvider before Nv12Converter
+static double RunSwscale(const AVFrame* frame, uint8_t* sample, int frames)
+{
+	SwsContext* swsCtx = sws_getContext(frame->width, frame->height, (AVPixelFormat)frame->format,
+		frame->width, frame->height, AV_PIX_FMT_NV12, SWS_BICUBIC, nullptr, nullptr, nullptr);
+	uint8_t* data[4];
+	int lineSize[4];
+	if (swsCtx == nullptr || av_image_alloc(data, lineSize, frame->width, frame->height, AV_PIX_FMT_NV12, 1) < 0)
+	{
+		sws_freeContext(swsCtx);
+		return -1;
+	}
+
+	double start = CpuSeconds();
+	for (int i = 0; i < frames; i++)
+	{
+		sws_scale(swsCtx, frame->data, frame->linesize, 0, frame->height, data, lineSize);
+		size_t lumaSize = (size_t)lineSize[0] * frame->height;
+		memcpy(sample, data[0], lumaSize);
+		memcpy(sample + lumaSize, data[1], (size_t)lineSize[1] * frame->height / 2);
+	}
+	double elapsed = CpuSeconds() - start;
+
+	av_freep(&data[0]);
+	sws_freeContext(swsCtx);
+	return elapsed;
+}
+
+static double RunConverter(const AVFrame* frame, uint8_t* sample, int frames)
+{
+	Nv12Converter converter;
+	if (converter.Configure((AVPixelFormat)frame->format, frame->width, frame->height) < 0)
+	{
+		return -1;
+	}
+
+	double start = CpuSeconds();
+	for (int i = 0; i < frames; i++)
+	{
+		converter.Convert(frame, sample);
+	}
+	return CpuSeconds() - start;
+}
+
+int main(int argc, char** argv)
+{
+	int frames = 300;
+	int opt;
+	while ((opt = getopt(argc, argv, "f:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'f':
+			frames = atoi(optarg);
+			break;
+		default:
+			optind = argc + 1;
+			break;
+		}
+	}
+	if (optind >= argc || frames <= 0)
+	{
+		fprintf(stderr, "Usage: %s [-f frames] WIDTHxHEIGHT...\n", argv[0]);
+		return 1;
+	}
+
+	static const AVPixelFormat formats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12 };
+	for (int i = optind; i < argc; i++)
+	{
+		int width, height;
+		if (sscanf(argv[i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0)
+		{
+			fprintf(stderr, "Invalid size %s\n", argv[i]);
+			return 1;
+		}
+
+		std::vector<uint8_t> sample((size_t)av_image_get_buffer_size(AV_PIX_FMT_NV12, width, height, 1));
+		for (AVPixelFormat format : formats)
+		{
+			AVFrame* frame = GradientFrame(format, width, height);
+			double swscaleTime = frame ? RunSwscale(frame, sample.data(), frames) : -1;
+			double converterTime = frame ? RunConverter(frame, sample.data(), frames) : -1;
+			av_frame_free(&frame);
+			if (swscaleTime < 0 || converterTime < 0)
+			{
+				fprintf(stderr, "Cannot convert %s %s\n", argv[i], av_get_pix_fmt_name(format));
+				return 1;
+			}
+
+			printf("%dx%d %-8s swscale + copy %7.1f fps, Nv12Converter %7.1f fps\n", width, height,
+				av_get_pix_fmt_name(format), frames / swscaleTime, frames / converterTime);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,207 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Checks Nv12Converter on random frames:
+// - NV12 and YUV420P frames of the output size are copied or interleaved byte for byte,
+//   including odd sizes and widths that leave a scalar tail after the SIMD kernel;
+// - other formats and sizes go through swscale and give the same image as a SwsContext
+//   set up the same way;
+// - a format or size change between frames selects the path again.
+
+#include "Nv12Converter.h"
+#include "TestCommon.h"
+#include <string.h>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+#include <libavutil/lfg.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+// Frame with random samples and line sizes larger than the rows
+static AVFrame* RandomFrame(AVLFG* lfg, AVPixelFormat format, int width, int height)
+{
+	AVFrame* frame = av_frame_alloc();
+	frame->format = format;
+	frame->width = width;
+	frame->height = height;
+	if (av_frame_get_buffer(frame, 64) < 0)
+	{
+		av_frame_free(&frame);
+		return nullptr;
+	}
+
+	for (int plane = 0; plane < 4 && frame->buf[plane]; plane++)
+	{
+		for (int i = 0; i < frame->buf[plane]->size; i++)
+		{
+			frame->buf[plane]->data[i] = (uint8_t)av_lfg_get(lfg);
+		}
+	}
+	return frame;
+}
+
+// The NV12 image Convert should write for an NV12 or YUV420P frame of the output size
+static std::vector<uint8_t> ExpectedImage(const AVFrame* frame)
+{
+	int chromaWidth = (frame->width + 1) >> 1;
+	int chromaHeight = (frame->height + 1) >> 1;
+	std::vector<uint8_t> image((size_t)frame->width * frame->height + (size_t)chromaWidth * 2 * chromaHeight);
+	uint8_t* dst = image.data();
+	for (int y = 0; y < frame->height; y++)
+	{
+		memcpy(dst, frame->data[0] + y * frame->linesize[0], frame->width);
+		dst += frame->width;
+	}
+	for (int y = 0; y < chromaHeight; y++)
+	{
+		for (int x = 0; x < chromaWidth; x++)
+		{
+			if (frame->format == AV_PIX_FMT_NV12)
+			{
+				*dst++ = frame->data[1][y * frame->linesize[1] + 2 * x];
+				*dst++ = frame->data[1][y * frame->linesize[1] + 2 * x + 1];
+			}
+			else
+			{
+				*dst++ = frame->data[1][y * frame->linesize[1] + x];
+				*dst++ = frame->data[2][y * frame->linesize[2] + x];
+			}
+		}
+	}
+	return image;
+}
+
+// The image the converter should produce through swscale
+static std::vector<uint8_t> ScaledImage(const AVFrame* frame, int width, int height)
+{
+	std::vector<uint8_t> image((size_t)av_image_get_buffer_size(AV_PIX_FMT_NV12, width, height, 1));
+	uint8_t* data[4];
+	int lineSize[4];
+	av_image_fill_arrays(data, lineSize, image.data(), AV_PIX_FMT_NV12, width, height, 1);
+	SwsContext* swsCtx = sws_getContext(frame->width, frame->height, (AVPixelFormat)frame->format,
+		width, height, AV_PIX_FMT_NV12, SWS_BICUBIC, nullptr, nullptr, nullptr);
+	CHECK(swsCtx != nullptr);
+	if (swsCtx != nullptr)
+	{
+		sws_scale(swsCtx, frame->data, frame->linesize, 0, frame->height, data, lineSize);
+		sws_freeContext(swsCtx);
+	}
+	return image;
+}
+
+static void ConvertAndCompare(AVLFG* lfg, Nv12Converter& converter, AVPixelFormat format, int width, int height,
+	int outputWidth, int outputHeight, Nv12Converter::ConversionPath expectedPath)
+{
+	AVFrame* frame = RandomFrame(lfg, format, width, height);
+	CHECK(frame != nullptr);
+	if (frame == nullptr)
+	{
+		return;
+	}
+
+	// Guard bytes after the image catch writes past GetOutputSize
+	std::vector<uint8_t> output(converter.GetOutputSize() + 64, 0xa5);
+	CHECK(converter.Convert(frame, output.data()) == 0);
+	CHECK(converter.GetPath() == expectedPath);
+	for (size_t i = converter.GetOutputSize(); i < output.size(); i++)
+	{
+		CHECK(output[i] == 0xa5);
+	}
+	output.resize(converter.GetOutputSize());
+
+	if (expectedPath == Nv12Converter::PathScale)
+	{
+		CHECK(output == ScaledImage(frame, outputWidth, outputHeight));
+	}
+	else
+	{
+		CHECK(output == ExpectedImage(frame));
+	}
+	av_frame_free(&frame);
+}
+
+static void TestDirectPaths(AVLFG* lfg, int width, int height)
+{
+	Nv12Converter converter;
+	CHECK(converter.Configure(AV_PIX_FMT_YUV420P, width, height) == 0);
+	CHECK(converter.GetPath() == Nv12Converter::PathInterleave);
+	CHECK(converter.GetOutputSize() == (size_t)av_image_get_buffer_size(AV_PIX_FMT_NV12, width, height, 1));
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_YUV420P, width, height, width, height, Nv12Converter::PathInterleave);
+
+	// The decoder switching to NV12 and back
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_NV12, width, height, width, height, Nv12Converter::PathCopy);
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_YUV420P, width, height, width, height, Nv12Converter::PathInterleave);
+}
+
+static void TestScalePaths(AVLFG* lfg)
+{
+	// Formats without a direct path
+	Nv12Converter converter;
+	CHECK(converter.Configure(AV_PIX_FMT_YUV422P, 640, 360) == 0);
+	CHECK(converter.GetPath() == Nv12Converter::PathScale);
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_YUV422P, 640, 360, 640, 360, Nv12Converter::PathScale);
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_RGB24, 640, 360, 640, 360, Nv12Converter::PathScale);
+
+	// A frame of another size is scaled to the stream size, and the next frame of the stream
+	// size goes back to the interleave path
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_YUV420P, 320, 180, 640, 360, Nv12Converter::PathScale);
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_YUV420P, 640, 360, 640, 360, Nv12Converter::PathInterleave);
+
+	// The format is only known with the first frame
+	Nv12Converter late;
+	CHECK(late.Configure(AV_PIX_FMT_NONE, 64, 48) == 0);
+	CHECK(late.GetPath() == Nv12Converter::PathNone);
+	ConvertAndCompare(lfg, late, AV_PIX_FMT_NV12, 64, 48, 64, 48, Nv12Converter::PathCopy);
+}
+
+static void TestFullRange(AVLFG* lfg)
+{
+	// YUVJ420P keeps its range and is interleaved as is
+	Nv12Converter converter;
+	CHECK(Nv12Converter::IsFullRange(AV_PIX_FMT_YUVJ420P));
+	CHECK(!Nv12Converter::IsFullRange(AV_PIX_FMT_YUV420P));
+	CHECK(converter.Configure(AV_PIX_FMT_YUVJ420P, 128, 72) == 0);
+	CHECK(converter.GetPath() == Nv12Converter::PathInterleave);
+	ConvertAndCompare(lfg, converter, AV_PIX_FMT_YUVJ420P, 128, 72, 128, 72, Nv12Converter::PathInterleave);
+
+	// A limited range frame in a full range stream has to be expanded by swscale
+	AVFrame* frame = RandomFrame(lfg, AV_PIX_FMT_YUV420P, 128, 72);
+	std::vector<uint8_t> output(converter.GetOutputSize());
+	CHECK(converter.Convert(frame, output.data()) == 0);
+	CHECK(converter.GetPath() == Nv12Converter::PathScale);
+	av_frame_free(&frame);
+}
+
+int main()
+{
+	AVLFG lfg;
+	av_lfg_init(&lfg, 0x4e5631);
+
+	static const int sizes[][2] = { { 1920, 1080 }, { 1281, 721 }, { 34, 2 }, { 2, 2 }, { 1, 1 } };
+	for (const int* size : sizes)
+	{
+		TestDirectPaths(&lfg, size[0], size[1]);
+	}
+	TestScalePaths(&lfg);
+	TestFullRange(&lfg);
+	return TestResult("Nv12ConverterTest");
+}
@@ -0,0 +1,162 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Pushes the demuxed packets of a file through a queue that is kept at a fixed depth, as when
+// one stream is read far ahead of the other, and prints the CPU time per packet of
+// - the previous queue, a std::vector popped with erase(begin());
+// - PacketQueue.
+// The AVPacket structs are queued without taking references, so only the queue is measured.
+//
+// Usage: PacketQueueBench [-p passes] [-d depth] file
+
+#include "PacketQueue.h"
+#include "TestCommon.h"
+#include <unistd.h>
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+static int LoadPackets(const char* path, std::vector<AVPacket>& packets, AVRational& timeBase)
+{
+	av_register_all();
+
+	AVFormatContext* formatCtx = nullptr;
+	int ret = avformat_open_input(&formatCtx, path, nullptr, nullptr);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	// Every stream, with the time base of the first one for the duration totals
+	timeBase = formatCtx->nb_streams ? formatCtx->streams[0]->time_base : AV_TIME_BASE_Q;
+	AVPacket packet;
+	av_init_packet(&packet);
+	while (av_read_frame(formatCtx, &packet) >= 0)
+	{
+		packets.push_back(packet);
+	}
+	avformat_close_input(&formatCtx);
+	return 0;
+}
+
+// MediaSampleProvider before PacketQueue
+static double RunVector(const std::vector<AVPacket>& packets, size_t depth)
+{
+	std::vector<AVPacket> queue;
+	double start = CpuSeconds();
+	for (const AVPacket& packet : packets)
+	{
+		queue.push_back(packet);
+		if (queue.size() > depth)
+		{
+			AVPacket popped = queue.front();
+			queue.erase(queue.begin());
+			(void)popped;
+		}
+	}
+	while (!queue.empty())
+	{
+		queue.erase(queue.begin());
+	}
+	return CpuSeconds() - start;
+}
+
+static double RunRing(const std::vector<AVPacket>& packets, size_t depth, AVRational timeBase)
+{
+	PacketQueue queue;
+	queue.SetTimeBase(timeBase);
+	AVPacket popped;
+	double start = CpuSeconds();
+	for (const AVPacket& packet : packets)
+	{
+		queue.Push(packet);
+		if (queue.GetCount() > depth)
+		{
+			queue.Pop(&popped);
+		}
+	}
+
+	// Pop instead of Flush, the packets are not referenced by the queue
+	while (queue.Pop(&popped))
+	{
+	}
+	return CpuSeconds() - start;
+}
+
+int main(int argc, char** argv)
+{
+	int passes = 5;
+	int depth = 0;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:d:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p':
+			passes = atoi(optarg);
+			break;
+		case 'd':
+			depth = atoi(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1 || passes <= 0 || depth < 0)
+	{
+		fprintf(stderr, "Usage: %s [-p passes] [-d depth] file\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<AVPacket> packets;
+	AVRational timeBase;
+	if (LoadPackets(argv[optind], packets, timeBase) < 0 || packets.empty())
+	{
+		fprintf(stderr, "Cannot read the packets of %s\n", argv[optind]);
+		return 1;
+	}
+
+	printf("%s: %zu packets, best of %d passes\n", argv[optind], packets.size(), passes);
+	static const int depths[] = { 16, 256, 4096 };
+	for (int i = 0; i < 3; i++)
+	{
+		size_t queueDepth = depth ? depth : depths[i];
+		double vectorTime = 0, ringTime = 0;
+		for (int pass = 0; pass < passes; pass++)
+		{
+			double time = RunVector(packets, queueDepth);
+			vectorTime = pass ? std::min(vectorTime, time) : time;
+			time = RunRing(packets, queueDepth, timeBase);
+			ringTime = pass ? std::min(ringTime, time) : time;
+		}
+
+		printf("depth %5zu: vector erase %8.1f ns per packet, PacketQueue %6.1f ns per packet\n", queueDepth,
+			vectorTime * 1e9 / packets.size(), ringTime * 1e9 / packets.size());
+		if (depth)
+		{
+			break;
+		}
+	}
+
+	for (AVPacket& packet : packets)
+	{
+		av_packet_unref(&packet);
+	}
+	return 0;
+}
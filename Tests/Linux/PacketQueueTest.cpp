@@ -0,0 +1,194 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Drives PacketQueue with generated packets and with the demuxed video and audio packets of
+// every file given on the command line, and checks that
+// - packets come out in push order while the ring grows with a wrapped head;
+// - the byte and duration totals match the queued packets after every push and pop;
+// - PeekNextKeyFrame finds every key frame in place, without copying it;
+// - Flush empties the queue and resets the totals.
+
+#include "PacketQueue.h"
+#include "TestCommon.h"
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+static int64_t ExpectedDuration(const AVPacket* packet, AVRational timeBase)
+{
+	return packet->duration > 0 ? av_rescale_q(packet->duration, timeBase, AV_TIME_BASE_Q) : 0;
+}
+
+static void PushReference(PacketQueue& queue, const AVPacket* packet)
+{
+	AVPacket reference;
+	av_init_packet(&reference);
+	CHECK(av_packet_ref(&reference, packet) == 0);
+	CHECK(queue.Push(reference) == 0);
+}
+
+static void TestOrderAndTotals(const std::vector<AVPacket*>& packets, AVRational timeBase)
+{
+	PacketQueue queue;
+	queue.SetTimeBase(timeBase);
+
+	// Push three, pop two, so the head keeps moving and the ring grows while it is wrapped
+	size_t pushed = 0, popped = 0;
+	int64_t bytes = 0, duration = 0;
+	AVPacket packet;
+	while (popped < packets.size())
+	{
+		for (int i = 0; i < 3 && pushed < packets.size(); i++, pushed++)
+		{
+			PushReference(queue, packets[pushed]);
+			bytes += packets[pushed]->size;
+			duration += ExpectedDuration(packets[pushed], timeBase);
+		}
+		for (int i = 0; popped < pushed && (i < 2 || pushed == packets.size()); i++, popped++)
+		{
+			CHECK(queue.Pop(&packet));
+			CHECK(packet.data == packets[popped]->data && packet.size == packets[popped]->size);
+			CHECK(packet.pts == packets[popped]->pts && packet.flags == packets[popped]->flags);
+			bytes -= packet.size;
+			duration -= ExpectedDuration(&packet, timeBase);
+			av_packet_unref(&packet);
+		}
+
+		CHECK(queue.GetCount() == pushed - popped);
+		CHECK(queue.GetBytes() == bytes);
+		CHECK(queue.GetDuration() == duration);
+	}
+
+	CHECK(queue.IsEmpty());
+	CHECK(!queue.Pop(&packet));
+	CHECK(queue.GetBytes() == 0 && queue.GetDuration() == 0);
+}
+
+// From every position, the next key frame is the queued packet itself and not a copy
+static void CheckKeyFrames(const PacketQueue& queue, const std::vector<AVPacket*>& packets, size_t first)
+{
+	size_t expected = queue.GetCount();
+	for (size_t i = queue.GetCount(); i-- > 0;)
+	{
+		if (packets[first + i]->flags & AV_PKT_FLAG_KEY)
+		{
+			expected = i;
+		}
+
+		size_t index = i;
+		const AVPacket* keyFrame = queue.PeekNextKeyFrame(&index);
+		CHECK(keyFrame == queue.Peek(expected));
+		if (keyFrame != nullptr)
+		{
+			CHECK(index == expected);
+			CHECK(keyFrame->data == packets[first + index]->data);
+		}
+	}
+}
+
+static void TestKeyFramePeek(const std::vector<AVPacket*>& packets, AVRational timeBase)
+{
+	PacketQueue queue;
+	queue.SetTimeBase(timeBase);
+
+	// Slide a window of 100 packets over the stream, so the head goes around the ring
+	const size_t window = 100;
+	size_t first = 0;
+	for (size_t i = 0; i < packets.size(); i++)
+	{
+		PushReference(queue, packets[i]);
+		if (queue.GetCount() > window)
+		{
+			AVPacket packet;
+			CHECK(queue.Pop(&packet));
+			av_packet_unref(&packet);
+			first++;
+		}
+		CheckKeyFrames(queue, packets, first);
+	}
+
+	size_t keyFrames = 0;
+	for (size_t i = first; i < packets.size(); i++)
+	{
+		keyFrames += (packets[i]->flags & AV_PKT_FLAG_KEY) != 0;
+	}
+
+	size_t found = 0;
+	size_t index = 0;
+	while (queue.PeekNextKeyFrame(&index) != nullptr)
+	{
+		found++;
+		index++;
+	}
+	CHECK(found == keyFrames);
+
+	queue.Flush();
+	CHECK(queue.IsEmpty());
+	CHECK(queue.GetBytes() == 0 && queue.GetDuration() == 0);
+	index = 0;
+	CHECK(queue.PeekNextKeyFrame(&index) == nullptr);
+}
+
+static void TestPackets(const std::vector<AVPacket*>& packets, AVRational timeBase)
+{
+	TestOrderAndTotals(packets, timeBase);
+	TestKeyFramePeek(packets, timeBase);
+}
+
+// Packets of different sizes and durations with a key frame every 25
+static void TestGenerated()
+{
+	std::vector<AVPacket*> packets;
+	for (int i = 0; i < 1000; i++)
+	{
+		AVPacket* packet = av_packet_alloc();
+		CHECK(av_new_packet(packet, 100 + i % 37 * 50) == 0);
+		packet->pts = packet->dts = i * 3003;
+		packet->duration = i % 10 == 9 ? 0 : 3003;
+		packet->flags = i % 25 == 0 ? AV_PKT_FLAG_KEY : 0;
+		packets.push_back(packet);
+	}
+
+	TestPackets(packets, { 1, 90000 });
+	for (AVPacket* packet : packets)
+	{
+		av_packet_free(&packet);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	TestGenerated();
+
+	for (int i = 1; i < argc; i++)
+	{
+		static const AVMediaType types[] = { AVMEDIA_TYPE_VIDEO, AVMEDIA_TYPE_AUDIO };
+		for (AVMediaType type : types)
+		{
+			StreamPackets stream;
+			if (LoadStreamPackets(argv[i], type, stream) < 0)
+			{
+				continue;
+			}
+
+			TestPackets(stream.Packets, stream.TimeBase);
+			printf("%s: %zu %s packets\n", argv[i], stream.Packets.size(), av_get_media_type_string(type));
+		}
+	}
+	return TestResult("PacketQueueTest");
+}
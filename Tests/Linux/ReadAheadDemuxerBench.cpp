@@ -0,0 +1,275 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Measures how long audio and video sample requests wait for their packet while the input
+// is throttled, with the synchronous reader and with ReadAheadDemuxer.
+//
+// An audio and a video thread request packets at their presentation times, as the media
+// pipeline does. The video thread also spends a fixed time decoding every packet.
+// - synchronous: like FFmpegReader without read-ahead, a request holds the global lock
+//   of FFmpegInteropMSS while it calls av_read_frame until a packet of its stream
+//   arrives, queueing packets of the other stream, and while the sample is decoded;
+// - read-ahead: a request pops from the ReadAheadDemuxer queue of its stream and only
+//   holds a lock of its own.
+//
+// Usage: ReadAheadDemuxerBench [-t us per 16 KB read] [-d video decode ms] [-l seconds] file
+
+#include "PacketQueue.h"
+#include "ReadAheadDemuxer.h"
+#include "TestCommon.h"
+#include <unistd.h>
+#include <mutex>
+#include <thread>
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+struct BenchOptions
+{
+	int64_t MicrosecondsPer16K;
+	int DecodeMilliseconds;
+	double Seconds;
+};
+
+class Source
+{
+public:
+	virtual ~Source() {}
+	virtual int Pop(int stream, AVPacket* packet) = 0;
+	virtual std::mutex& DecodeLock(int stream) = 0;
+};
+
+// FFmpegReader::ReadPacket without read-ahead, under the global lock of OnSampleRequested
+class SynchronousSource : public Source
+{
+public:
+	SynchronousSource(AVFormatContext* formatCtx, const int* streams) : m_formatCtx(formatCtx)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			m_streams[i] = streams[i];
+			m_queues[i].SetTimeBase(formatCtx->streams[streams[i]]->time_base);
+		}
+	}
+
+	int Pop(int stream, AVPacket* packet) override
+	{
+		while (m_queues[stream].IsEmpty())
+		{
+			AVPacket read;
+			av_init_packet(&read);
+			read.data = nullptr;
+			read.size = 0;
+			int ret = av_read_frame(m_formatCtx, &read);
+			if (ret < 0)
+			{
+				return ret;
+			}
+
+			int target = read.stream_index == m_streams[0] ? 0 : read.stream_index == m_streams[1] ? 1 : -1;
+			if (target < 0 || m_queues[target].Push(read) < 0)
+			{
+				av_packet_unref(&read);
+			}
+		}
+		m_queues[stream].Pop(packet);
+		return 0;
+	}
+
+	// Both streams share the lock, so it is taken for the read as well as for the decode
+	std::mutex& DecodeLock(int) override { return m_globalLock; }
+
+private:
+	AVFormatContext* m_formatCtx;
+	int m_streams[2];
+	PacketQueue m_queues[2];
+	std::mutex m_globalLock;
+};
+
+class ReadAheadSource : public Source
+{
+public:
+	ReadAheadSource(AVFormatContext* formatCtx, const int* streams)
+		: m_demuxer(formatCtx, 16 * 1024 * 1024, 5 * AV_TIME_BASE)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			m_streams[i] = streams[i];
+			m_demuxer.AddStream(streams[i]);
+		}
+		m_demuxer.Start();
+	}
+
+	int Pop(int stream, AVPacket* packet) override
+	{
+		return m_demuxer.PopPacket(m_streams[stream], packet);
+	}
+
+	std::mutex& DecodeLock(int stream) override { return m_streamLocks[stream]; }
+
+private:
+	ReadAheadDemuxer m_demuxer;
+	int m_streams[2];
+	std::mutex m_streamLocks[2];
+};
+
+// Request the packets of one stream at their presentation time and record how long each waited
+static void Consume(Source* source, int stream, AVRational timeBase, const BenchOptions* options,
+	double startTime, std::vector<double>* latencies)
+{
+	AVPacket* packet = av_packet_alloc();
+	int64_t firstPts = AV_NOPTS_VALUE;
+	double due = startTime;
+	while (NowSeconds() - startTime < options->Seconds)
+	{
+		double now = NowSeconds();
+		if (due > now)
+		{
+			std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+		}
+
+		double requested = NowSeconds();
+		{
+			std::lock_guard<std::mutex> lock(source->DecodeLock(stream));
+			int ret = source->Pop(stream, packet);
+			if (ret < 0)
+			{
+				break;
+			}
+			latencies->push_back(NowSeconds() - requested);
+
+			if (stream == 0 && options->DecodeMilliseconds > 0)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(options->DecodeMilliseconds));
+			}
+		}
+
+		if (packet->pts != AV_NOPTS_VALUE)
+		{
+			if (firstPts == AV_NOPTS_VALUE)
+			{
+				firstPts = packet->pts;
+			}
+			due = startTime + (packet->pts - firstPts) * av_q2d(timeBase);
+		}
+		av_packet_unref(packet);
+	}
+	av_packet_free(&packet);
+}
+
+static int Run(const char* path, const BenchOptions& options, bool readAhead)
+{
+	AVFormatContext* formatCtx = nullptr;
+	int ret = OpenThrottledInput(path, options.MicrosecondsPer16K, &formatCtx);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	int streams[2] = {
+		av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0),
+		av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0),
+	};
+	if (streams[0] < 0 || streams[1] < 0)
+	{
+		CloseThrottledInput(&formatCtx);
+		return AVERROR_STREAM_NOT_FOUND;
+	}
+
+	std::vector<double> latencies[2];
+	{
+		std::unique_ptr<Source> source;
+		if (readAhead)
+		{
+			source.reset(new ReadAheadSource(formatCtx, streams));
+		}
+		else
+		{
+			source.reset(new SynchronousSource(formatCtx, streams));
+		}
+
+		double startTime = NowSeconds();
+		std::thread consumers[2];
+		for (int i = 0; i < 2; i++)
+		{
+			consumers[i] = std::thread(Consume, source.get(), i, formatCtx->streams[streams[i]]->time_base,
+				&options, startTime, &latencies[i]);
+		}
+		for (int i = 0; i < 2; i++)
+		{
+			consumers[i].join();
+		}
+	}
+
+	static const char* const names[2] = { "video", "audio" };
+	for (int i = 0; i < 2; i++)
+	{
+		printf("%-11s %s: %5zu requests, wait p50 %6.2f ms p90 %6.2f ms p99 %6.2f ms max %6.2f ms\n",
+			readAhead ? "read-ahead" : "synchronous", names[i], latencies[i].size(),
+			Percentile(latencies[i], 50) * 1e3, Percentile(latencies[i], 90) * 1e3,
+			Percentile(latencies[i], 99) * 1e3, Percentile(latencies[i], 100) * 1e3);
+	}
+
+	CloseThrottledInput(&formatCtx);
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	options.MicrosecondsPer16K = 2000;
+	options.DecodeMilliseconds = 10;
+	options.Seconds = 10;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "t:d:l:")) != -1)
+	{
+		switch (opt)
+		{
+		case 't':
+			options.MicrosecondsPer16K = atoi(optarg);
+			break;
+		case 'd':
+			options.DecodeMilliseconds = atoi(optarg);
+			break;
+		case 'l':
+			options.Seconds = atof(optarg);
+			break;
+		default:
+			optind = argc;
+			break;
+		}
+	}
+	if (optind != argc - 1)
+	{
+		fprintf(stderr, "Usage: %s [-t us per 16 KB read] [-d video decode ms] [-l seconds] file\n", argv[0]);
+		return 1;
+	}
+
+	printf("%s: reads throttled to %d us per 16 KB, %d ms video decode, %.0f s\n", argv[optind],
+		(int)options.MicrosecondsPer16K, options.DecodeMilliseconds, options.Seconds);
+	for (int readAhead = 0; readAhead < 2; readAhead++)
+	{
+		if (Run(argv[optind], options, readAhead != 0) < 0)
+		{
+			fprintf(stderr, "Cannot read the audio and video streams of %s\n", argv[optind]);
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,404 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Runs ReadAheadDemuxer on every file given on the command line and checks that
+// - each stream delivers the same packets in the same order as av_read_frame,
+//   with audio and video popped from concurrent threads;
+// - the thread parks with every queue within its limits plus one packet;
+// - a seek drops the queued packets and resumes at a key frame before the target;
+// - a seek to a key frame that is already queued delivers the same video as a seek of the file,
+//   and the audio resumes with the packet that covers the key frame;
+// - Stop wakes a consumer waiting on slow input.
+
+#include "ReadAheadDemuxer.h"
+#include "TestCommon.h"
+#include <thread>
+
+extern "C"
+{
+#include <libavutil/crc.h>
+}
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+struct PacketInfo
+{
+	int64_t Pts;
+	int64_t Dts;
+	int Size;
+	int Flags;
+	uint32_t Crc;
+
+	// Demuxers do not always know the dts of the first packet after a seek
+	bool SamePacket(const PacketInfo& other) const
+	{
+		return Pts == other.Pts && Size == other.Size && Flags == other.Flags && Crc == other.Crc;
+	}
+
+	bool operator==(const PacketInfo& other) const
+	{
+		return SamePacket(other) && Dts == other.Dts;
+	}
+};
+
+static PacketInfo GetInfo(const AVPacket* packet)
+{
+	PacketInfo info;
+	info.Pts = packet->pts;
+	info.Dts = packet->dts;
+	info.Size = packet->size;
+	info.Flags = packet->flags;
+	info.Crc = av_crc(av_crc_get_table(AV_CRC_32_IEEE), 0, packet->data, packet->size);
+	return info;
+}
+
+struct TestStreams
+{
+	int Index[2];
+	std::vector<PacketInfo> Reference[2];
+	int MaxPacketSize;
+};
+
+static bool ReadReference(const char* path, TestStreams& streams)
+{
+	AVFormatContext* formatCtx = nullptr;
+	if (OpenThrottledInput(path, 0, &formatCtx) < 0)
+	{
+		return false;
+	}
+
+	streams.Index[0] = av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+	streams.Index[1] = av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+	streams.MaxPacketSize = 0;
+
+	AVPacket* packet = av_packet_alloc();
+	while (av_read_frame(formatCtx, packet) >= 0)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			if (packet->stream_index == streams.Index[i])
+			{
+				streams.Reference[i].push_back(GetInfo(packet));
+				streams.MaxPacketSize = std::max(streams.MaxPacketSize, packet->size);
+			}
+		}
+		av_packet_unref(packet);
+	}
+	av_packet_free(&packet);
+	CloseThrottledInput(&formatCtx);
+	return true;
+}
+
+static void PopAll(ReadAheadDemuxer* demuxer, int streamIndex, std::vector<PacketInfo>* result, int* lastError)
+{
+	AVPacket* packet = av_packet_alloc();
+	int ret;
+	while ((ret = demuxer->PopPacket(streamIndex, packet)) >= 0)
+	{
+		result->push_back(GetInfo(packet));
+		av_packet_unref(packet);
+	}
+	*lastError = ret;
+	av_packet_free(&packet);
+}
+
+static void TestConcurrentOrder(const char* path, const TestStreams& streams)
+{
+	AVFormatContext* formatCtx = nullptr;
+	CHECK(OpenThrottledInput(path, 200, &formatCtx) >= 0);
+	if (formatCtx == nullptr)
+	{
+		return;
+	}
+
+	// Small limits so the thread parks and resumes many times
+	ReadAheadDemuxer demuxer(formatCtx, 256 * 1024, AV_TIME_BASE / 2);
+	std::vector<PacketInfo> result[2];
+	int lastError[2] = { 0, 0 };
+	for (int i = 0; i < 2; i++)
+	{
+		if (streams.Index[i] >= 0)
+		{
+			demuxer.AddStream(streams.Index[i]);
+		}
+	}
+	CHECK(demuxer.Start() == 0);
+
+	std::thread consumers[2];
+	for (int i = 0; i < 2; i++)
+	{
+		if (streams.Index[i] >= 0)
+		{
+			consumers[i] = std::thread(PopAll, &demuxer, streams.Index[i], &result[i], &lastError[i]);
+		}
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		if (consumers[i].joinable())
+		{
+			consumers[i].join();
+			CHECK(lastError[i] == AVERROR_EOF);
+			CHECK(result[i] == streams.Reference[i]);
+			CHECK(demuxer.GetQueuedBytes(streams.Index[i]) == 0);
+		}
+	}
+
+	demuxer.Stop();
+	CloseThrottledInput(&formatCtx);
+}
+
+static void WaitUntilParked(ReadAheadDemuxer& demuxer, const TestStreams& streams)
+{
+	int64_t previous = -1;
+	for (int wait = 0; wait < 100; wait++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		int64_t queued = 0;
+		for (int i = 0; i < 2; i++)
+		{
+			queued += streams.Index[i] >= 0 ? demuxer.GetQueuedBytes(streams.Index[i]) : 0;
+		}
+		if (queued == previous)
+		{
+			break;
+		}
+		previous = queued;
+	}
+}
+
+static void TestLimitsAndSeek(const char* path, const TestStreams& streams)
+{
+	const int64_t maxBytes = 512 * 1024;
+	const int64_t maxDuration = AV_TIME_BASE;
+
+	AVFormatContext* formatCtx = nullptr;
+	CHECK(OpenThrottledInput(path, 0, &formatCtx) >= 0);
+	if (formatCtx == nullptr)
+	{
+		return;
+	}
+
+	ReadAheadDemuxer demuxer(formatCtx, maxBytes, maxDuration);
+	for (int i = 0; i < 2; i++)
+	{
+		if (streams.Index[i] >= 0)
+		{
+			demuxer.AddStream(streams.Index[i]);
+		}
+	}
+	CHECK(demuxer.Start() == 0);
+
+	// Without consumers the thread fills the queues and parks
+	WaitUntilParked(demuxer, streams);
+
+	// The last packet read may overshoot the limit of the queue that became full
+	AVPacket* packet = av_packet_alloc();
+	for (int i = 0; i < 2; i++)
+	{
+		if (streams.Index[i] >= 0)
+		{
+			CHECK(demuxer.GetQueuedBytes(streams.Index[i]) <= maxBytes + streams.MaxPacketSize);
+			CHECK(demuxer.GetQueuedDuration(streams.Index[i]) <= maxDuration + AV_TIME_BASE / 2);
+		}
+	}
+
+	// Seek the video stream to the middle of the file
+	int video = streams.Index[0];
+	if (video >= 0 && streams.Reference[0].size() > 10)
+	{
+		int64_t target = streams.Reference[0][streams.Reference[0].size() / 2].Pts;
+		CHECK(demuxer.Seek(video, target, AVSEEK_FLAG_BACKWARD) >= 0);
+		CHECK(demuxer.PopPacket(video, packet) == 0);
+		CHECK(packet->flags & AV_PKT_FLAG_KEY);
+		CHECK(packet->pts <= target);
+
+		// The packet after the seek is one of the file, and the next ones follow it
+		PacketInfo info = GetInfo(packet);
+		auto found = std::find_if(streams.Reference[0].begin(), streams.Reference[0].end(),
+			[&info](const PacketInfo& reference) { return reference.SamePacket(info); });
+		CHECK(found != streams.Reference[0].end());
+		av_packet_unref(packet);
+		for (int i = 0; i < 10 && found != streams.Reference[0].end() && ++found != streams.Reference[0].end(); i++)
+		{
+			CHECK(demuxer.PopPacket(video, packet) == 0);
+			CHECK(GetInfo(packet).SamePacket(*found));
+			av_packet_unref(packet);
+		}
+	}
+
+	av_packet_free(&packet);
+	demuxer.Stop();
+	CloseThrottledInput(&formatCtx);
+}
+
+static void PopSome(ReadAheadDemuxer& demuxer, const TestStreams& streams, std::vector<PacketInfo>* result)
+{
+	AVPacket* packet = av_packet_alloc();
+	for (int i = 0; i < 2; i++)
+	{
+		for (int count = 0; streams.Index[i] >= 0 && count < 10 && demuxer.PopPacket(streams.Index[i], packet) == 0; count++)
+		{
+			result[i].push_back(GetInfo(packet));
+			av_packet_unref(packet);
+		}
+	}
+	av_packet_free(&packet);
+}
+
+static void TestSeekInQueue(const char* path, const TestStreams& streams)
+{
+	AVFormatContext* formatCtx[2] = { nullptr, nullptr };
+	for (int i = 0; i < 2; i++)
+	{
+		CHECK(OpenThrottledInput(path, 0, &formatCtx[i]) >= 0);
+	}
+
+	// The second key frame, if it is within the first second that gets queued
+	int video = streams.Index[0];
+	const std::vector<PacketInfo>& reference = streams.Reference[0];
+	size_t keyFrame = 1;
+	while (keyFrame < reference.size() && !(reference[keyFrame].Flags & AV_PKT_FLAG_KEY))
+	{
+		keyFrame++;
+	}
+	if (formatCtx[0] == nullptr || formatCtx[1] == nullptr || video < 0 || keyFrame >= reference.size() ||
+		av_rescale_q(reference[keyFrame].Pts - reference[0].Pts, formatCtx[0]->streams[video]->time_base, AV_TIME_BASE_Q) > AV_TIME_BASE)
+	{
+		CloseThrottledInput(&formatCtx[0]);
+		CloseThrottledInput(&formatCtx[1]);
+		return;
+	}
+
+	// One demuxer seeks in its full queues, the other one seeks the file before it starts
+	std::unique_ptr<ReadAheadDemuxer> demuxers[2];
+	std::vector<PacketInfo> result[2][2];
+	int64_t target = reference[keyFrame].Pts + 1;
+	for (int d = 0; d < 2; d++)
+	{
+		demuxers[d].reset(new ReadAheadDemuxer(formatCtx[d], 64 * 1024 * 1024, 2 * AV_TIME_BASE));
+		for (int i = 0; i < 2; i++)
+		{
+			if (streams.Index[i] >= 0)
+			{
+				demuxers[d]->AddStream(streams.Index[i]);
+			}
+		}
+		if (d == 0)
+		{
+			CHECK(demuxers[d]->Start() == 0);
+			WaitUntilParked(*demuxers[d], streams);
+		}
+		CHECK(demuxers[d]->Seek(video, target, AVSEEK_FLAG_BACKWARD) >= 0);
+		if (d == 1)
+		{
+			CHECK(demuxers[d]->Start() == 0);
+		}
+		PopSome(*demuxers[d], streams, result[d]);
+		demuxers[d]->Stop();
+	}
+
+	CHECK(!result[0][0].empty() && result[0][0][0].SamePacket(reference[keyFrame]));
+	CHECK(result[0][0].size() == result[1][0].size());
+	for (size_t p = 0; p < std::min(result[0][0].size(), result[1][0].size()); p++)
+	{
+		CHECK(result[0][0][p].SamePacket(result[1][0][p]));
+	}
+
+	// Demuxers differ in where the other streams resume after a seek of the file, so the audio is
+	// checked against the rule of the queues: it follows on from the packet playing at the key frame
+	const std::vector<PacketInfo>& audio = streams.Reference[1];
+	if (streams.Index[1] >= 0 && !result[0][1].empty())
+	{
+		AVRational videoTimeBase = formatCtx[0]->streams[video]->time_base;
+		AVRational audioTimeBase = formatCtx[0]->streams[streams.Index[1]]->time_base;
+		auto first = std::find_if(audio.begin(), audio.end(),
+			[&result](const PacketInfo& packet) { return packet.SamePacket(result[0][1][0]); });
+		CHECK(first != audio.end());
+		size_t start = first - audio.begin();
+		for (size_t p = 0; first != audio.end() && p < result[0][1].size(); p++)
+		{
+			CHECK(start + p < audio.size() && result[0][1][p].SamePacket(audio[start + p]));
+		}
+		if (first != audio.end() && start + 1 < audio.size())
+		{
+			CHECK(start == 0 || av_compare_ts(audio[start].Pts, audioTimeBase, reference[keyFrame].Pts, videoTimeBase) <= 0);
+			CHECK(av_compare_ts(audio[start + 1].Pts, audioTimeBase, reference[keyFrame].Pts, videoTimeBase) > 0);
+		}
+	}
+
+	demuxers[0].reset();
+	demuxers[1].reset();
+	CloseThrottledInput(&formatCtx[0]);
+	CloseThrottledInput(&formatCtx[1]);
+}
+
+static void TestStopWakesConsumer(const char* path, const TestStreams& streams)
+{
+	// 50 ms per 16 KB, the consumer is waiting while the thread is inside av_read_frame
+	AVFormatContext* formatCtx = nullptr;
+	CHECK(OpenThrottledInput(path, 50000, &formatCtx) >= 0);
+	if (formatCtx == nullptr)
+	{
+		return;
+	}
+
+	int stream = streams.Index[1] >= 0 ? streams.Index[1] : streams.Index[0];
+	ReadAheadDemuxer demuxer(formatCtx, 64 * 1024 * 1024, 0);
+	demuxer.AddStream(stream);
+	CHECK(demuxer.Start() == 0);
+
+	std::vector<PacketInfo> result;
+	int lastError = 0;
+	std::thread consumer(PopAll, &demuxer, stream, &result, &lastError);
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+	double start = NowSeconds();
+	demuxer.Stop();
+	consumer.join();
+	CHECK(lastError == AVERROR_EXIT);
+	CHECK(NowSeconds() - start < 1.0);
+	CloseThrottledInput(&formatCtx);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("ReadAheadDemuxerTest: no SAMPLES given, skipped\n");
+		return 0;
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		TestStreams streams;
+		if (!ReadReference(argv[i], streams))
+		{
+			fprintf(stderr, "Cannot read %s\n", argv[i]);
+			FailureCount++;
+			continue;
+		}
+
+		TestConcurrentOrder(argv[i], streams);
+		TestLimitsAndSeek(argv[i], streams);
+		TestSeekInQueue(argv[i], streams);
+		TestStopWakesConsumer(argv[i], streams);
+		printf("%s: %zu video and %zu audio packets\n", argv[i], streams.Reference[0].size(), streams.Reference[1].size());
+	}
+	return TestResult("ReadAheadDemuxerTest");
+}
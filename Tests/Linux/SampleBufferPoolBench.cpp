@@ -0,0 +1,197 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Replays the audio and video packets of media files, in demuxing order, through two
+// ways of building samples:
+// - the previous one, which copied each packet into a temporary array and then into a
+//   DataWriter whose buffer was detached for the sample;
+// - SampleBuffer writing straight into a block of a SampleBufferPool shared by the
+//   streams, sized from the SampleSizeHistory of each stream.
+// The media pipeline holds on to a few samples before releasing them, modelled here
+// by keeping the last "inflight" samples alive.
+//
+// Usage: SampleBufferPoolBench [-p passes] [-i inflight] file...
+
+#include "SampleBufferPool.h"
+#include "TestCommon.h"
+#include <string.h>
+#include <unistd.h>
+#include <deque>
+#include <memory>
+
+using namespace FFmpegInterop;
+using namespace FFmpegInteropTest;
+
+struct TracePacket
+{
+	int Stream;
+	AVPacket* Packet;
+};
+
+static int LoadTrace(const char* path, std::vector<TracePacket>& trace)
+{
+	av_register_all();
+
+	AVFormatContext* formatCtx = nullptr;
+	int ret = avformat_open_input(&formatCtx, path, nullptr, nullptr);
+	if (ret < 0)
+	{
+		return ret;
+	}
+
+	int streams[2] = {
+		av_find_best_stream(formatCtx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0),
+		av_find_best_stream(formatCtx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0),
+	};
+
+	AVPacket* packet = av_packet_alloc();
+	while (av_read_frame(formatCtx, packet) >= 0)
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			if (packet->stream_index == streams[i])
+			{
+				trace.push_back({ i, av_packet_clone(packet) });
+			}
+		}
+		av_packet_unref(packet);
+	}
+	av_packet_free(&packet);
+	avformat_close_input(&formatCtx);
+	return 0;
+}
+
+// Counts the heap allocations of the previous path, which made two per sample
+struct ArrayPath
+{
+	ArrayPath() : Allocations(0) {}
+
+	void Write(const AVPacket* packet, std::deque<std::unique_ptr<uint8_t[]>>& inflight)
+	{
+		// The packet was copied to a Platform::Array for DataWriter::WriteBytes
+		std::unique_ptr<uint8_t[]> temporary(new uint8_t[packet->size]);
+		memcpy(temporary.get(), packet->data, packet->size);
+
+		// and from there into the DataWriter buffer handed to the sample
+		std::unique_ptr<uint8_t[]> sample(new uint8_t[packet->size]);
+		memcpy(sample.get(), temporary.get(), packet->size);
+		Allocations += 2;
+		inflight.push_back(std::move(sample));
+	}
+
+	size_t Allocations;
+};
+
+int main(int argc, char** argv)
+{
+	int passes = 50;
+	size_t inflightCount = 8;
+	int opt;
+	while ((opt = getopt(argc, argv, "p:i:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p':
+			passes = atoi(optarg);
+			break;
+		case 'i':
+			inflightCount = (size_t)atoi(optarg);
+			break;
+		default:
+			optind = argc + 1;
+			break;
+		}
+	}
+	if (optind >= argc || passes <= 0)
+	{
+		fprintf(stderr, "Usage: %s [-p passes] [-i inflight] file...\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<TracePacket> trace;
+	for (int i = optind; i < argc; i++)
+	{
+		if (LoadTrace(argv[i], trace) < 0)
+		{
+			fprintf(stderr, "Cannot read %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	// Previous path
+	ArrayPath arrays;
+	std::deque<std::unique_ptr<uint8_t[]>> inflightArrays;
+	double start = CpuSeconds();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (const TracePacket& entry : trace)
+		{
+			arrays.Write(entry.Packet, inflightArrays);
+			if (inflightArrays.size() > inflightCount)
+			{
+				inflightArrays.pop_front();
+			}
+		}
+	}
+	inflightArrays.clear();
+	double arrayTime = CpuSeconds() - start;
+
+	// Pooled path, as MediaSampleProvider::GetNextSample and NativeBuffer use it
+	std::shared_ptr<SampleBufferPool> pool = std::make_shared<SampleBufferPool>();
+	SampleSizeHistory history[2];
+	std::deque<PooledBlock*> inflightBlocks;
+	start = CpuSeconds();
+	for (int pass = 0; pass < passes; pass++)
+	{
+		for (const TracePacket& entry : trace)
+		{
+			SampleBuffer sample(pool, history[entry.Stream].GetSuggestedCapacity());
+			if (!sample.Append(entry.Packet->data, entry.Packet->size))
+			{
+				fprintf(stderr, "Out of memory\n");
+				return 1;
+			}
+			history[entry.Stream].Add(sample.GetSize());
+
+			inflightBlocks.push_back(sample.Detach());
+			if (inflightBlocks.size() > inflightCount)
+			{
+				pool->Release(inflightBlocks.front());
+				inflightBlocks.pop_front();
+			}
+		}
+	}
+	for (PooledBlock* block : inflightBlocks)
+	{
+		pool->Release(block);
+	}
+	double poolTime = CpuSeconds() - start;
+
+	size_t samples = trace.size() * passes;
+	printf("%zu samples (%zu per pass, %d passes), %zu in flight\n", samples, trace.size(), passes, inflightCount);
+	printf("array + DataWriter: %8zu allocations %8.1f ms %6.1f ns/sample\n", arrays.Allocations,
+		arrayTime * 1e3, arrayTime * 1e9 / samples);
+	printf("SampleBufferPool:   %8zu allocations %8.1f ms %6.1f ns/sample\n", pool->GetAllocationCount(),
+		poolTime * 1e3, poolTime * 1e9 / samples);
+
+	for (TracePacket& entry : trace)
+	{
+		av_packet_free(&entry.Packet);
+	}
+	return 0;
+}
@@ -0,0 +1,239 @@
+//*****************************************************************************
+//
+//	Copyright 2017 Microsoft Corporation
+//
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+//
+//	http ://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+//
+//*****************************************************************************
+
+// Helpers shared by the Linux tests and benchmarks
+
+#pragma once
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+// Report a failed check and keep going so one run shows every failure
+#define CHECK(cond) \
+	do \
+	{ \
+		if (!(cond)) \
+		{ \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			FFmpegInteropTest::FailureCount++; \
+		} \
+	} while (0)
+
+namespace FFmpegInteropTest
+{
+	static int FailureCount = 0;
+
+	inline int TestResult(const char* name)
+	{
+		if (FailureCount)
+		{
+			fprintf(stderr, "%s: %d checks failed\n", name, FailureCount);
+			return 1;
+		}
+		printf("%s: all checks passed\n", name);
+		return 0;
+	}
+
+	inline double NowSeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// CPU time of the process, which unlike wall time is not inflated by other load
+	inline double CpuSeconds()
+	{
+		return (double)clock() / CLOCKS_PER_SEC;
+	}
+
+	inline double Percentile(std::vector<double> values, double p)
+	{
+		if (values.empty())
+		{
+			return 0;
+		}
+		std::sort(values.begin(), values.end());
+		size_t index = (size_t)(p / 100 * (values.size() - 1) + 0.5);
+		return values[std::min(index, values.size() - 1)];
+	}
+
+	// All packets of the best stream of a type, read into memory
+	struct StreamPackets
+	{
+		StreamPackets() : Parameters(avcodec_parameters_alloc()), TimeBase({ 1, AV_TIME_BASE }) {}
+		~StreamPackets()
+		{
+			for (AVPacket* packet : Packets)
+			{
+				av_packet_free(&packet);
+			}
+			avcodec_parameters_free(&Parameters);
+		}
+
+		std::vector<AVPacket*> Packets;
+		AVCodecParameters* Parameters;
+		AVRational TimeBase;
+	};
+
+	// Returns 0 on success or a negative AVERROR code. maxPackets 0 reads the whole stream
+	inline int LoadStreamPackets(const char* path, AVMediaType type, StreamPackets& result, size_t maxPackets = 0)
+	{
+		av_register_all();
+
+		AVFormatContext* formatCtx = nullptr;
+		int ret = avformat_open_input(&formatCtx, path, nullptr, nullptr);
+		if (ret < 0)
+		{
+			return ret;
+		}
+
+		ret = avformat_find_stream_info(formatCtx, nullptr);
+		int streamIndex = ret < 0 ? ret : av_find_best_stream(formatCtx, type, -1, -1, nullptr, 0);
+		if (streamIndex >= 0)
+		{
+			AVStream* stream = formatCtx->streams[streamIndex];
+			result.TimeBase = stream->time_base;
+			ret = avcodec_parameters_copy(result.Parameters, stream->codecpar);
+
+			AVPacket* packet = av_packet_alloc();
+			while (ret >= 0 && (!maxPackets || result.Packets.size() < maxPackets) && av_read_frame(formatCtx, packet) >= 0)
+			{
+				if (packet->stream_index == streamIndex)
+				{
+					result.Packets.push_back(av_packet_clone(packet));
+				}
+				av_packet_unref(packet);
+			}
+			av_packet_free(&packet);
+		}
+		else
+		{
+			ret = streamIndex;
+		}
+
+		avformat_close_input(&formatCtx);
+		return ret < 0 ? ret : 0;
+	}
+
+	// File input whose reads sleep in proportion to their size, to stand in for a slow IStream
+	struct ThrottledFile
+	{
+		FILE* File;
+		int64_t MicrosecondsPer16K;
+	};
+
+	inline int ThrottledRead(void* opaque, uint8_t* buf, int size)
+	{
+		ThrottledFile* input = (ThrottledFile*)opaque;
+		size_t read = fread(buf, 1, size, input->File);
+		if (input->MicrosecondsPer16K > 0)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(input->MicrosecondsPer16K * (int64_t)read / 16384));
+		}
+		return read > 0 ? (int)read : AVERROR_EOF;
+	}
+
+	inline int64_t ThrottledSeek(void* opaque, int64_t offset, int whence)
+	{
+		ThrottledFile* input = (ThrottledFile*)opaque;
+		if (whence == AVSEEK_SIZE)
+		{
+			int64_t position = ftello(input->File);
+			fseeko(input->File, 0, SEEK_END);
+			int64_t size = ftello(input->File);
+			fseeko(input->File, position, SEEK_SET);
+			return size;
+		}
+		return fseeko(input->File, offset, whence & ~AVSEEK_FORCE) < 0 ? AVERROR(errno) : ftello(input->File);
+	}
+
+	// Open a file through a throttled AVIOContext. Close it with CloseThrottledInput
+	inline int OpenThrottledInput(const char* path, int64_t microsecondsPer16K, AVFormatContext** formatCtx)
+	{
+		av_register_all();
+
+		ThrottledFile* input = new ThrottledFile;
+		input->File = fopen(path, "rb");
+		input->MicrosecondsPer16K = microsecondsPer16K;
+		if (input->File == nullptr)
+		{
+			delete input;
+			return AVERROR(errno);
+		}
+
+		const int bufferSize = 16384;
+		uint8_t* buffer = (uint8_t*)av_malloc(bufferSize);
+		AVIOContext* ioCtx = buffer ? avio_alloc_context(buffer, bufferSize, 0, input, ThrottledRead, nullptr, ThrottledSeek) : nullptr;
+		*formatCtx = avformat_alloc_context();
+		int ret = AVERROR(ENOMEM);
+		if (ioCtx != nullptr && *formatCtx != nullptr)
+		{
+			(*formatCtx)->pb = ioCtx;
+			ret = avformat_open_input(formatCtx, path, nullptr, nullptr);
+			if (ret >= 0)
+			{
+				ret = avformat_find_stream_info(*formatCtx, nullptr);
+			}
+			if (ret >= 0)
+			{
+				return 0;
+			}
+			avformat_close_input(formatCtx);
+		}
+
+		avformat_free_context(*formatCtx);
+		*formatCtx = nullptr;
+		if (ioCtx != nullptr)
+		{
+			av_freep(&ioCtx->buffer);
+			av_free(ioCtx);
+		}
+		else
+		{
+			av_free(buffer);
+		}
+		fclose(input->File);
+		delete input;
+		return ret;
+	}
+
+	inline void CloseThrottledInput(AVFormatContext** formatCtx)
+	{
+		if (*formatCtx == nullptr)
+		{
+			return;
+		}
+
+		AVIOContext* ioCtx = (*formatCtx)->pb;
+		avformat_close_input(formatCtx);
+		ThrottledFile* input = (ThrottledFile*)ioCtx->opaque;
+		fclose(input->File);
+		delete input;
+		av_freep(&ioCtx->buffer);
+		av_free(ioCtx);
+	}
+}
@@ -447,19 +447,40 @@ static const uint8_t diag_scan8x8_inv[8][8] = {
     { 28, 36, 43, 49, 54, 58, 61, 63, },
 };
 
+/* With WPP, the context variables are synchronized at the start of each CTB
+ * row of a tile, from the storage written after the second CTB of the row
+ * above. Each tile has its own storage. */
+static uint8_t *wpp_states(HEVCContext *s, int ctb_addr_ts)
+{
+    return s->cabac_state + s->ps.pps->tile_id[ctb_addr_ts] * HEVC_CONTEXTS;
+}
+
+/* Column of a CTB relative to the start of its tile */
+static int ctb_x_in_tile(HEVCContext *s, int ctb_addr_ts)
+{
+    int x_ctb = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts] % s->ps.sps->ctb_width;
+
+    return x_ctb - s->ps.pps->col_bd[s->ps.pps->col_idxX[x_ctb]];
+}
+
+static int tile_column_width(HEVCContext *s, int ctb_addr_ts)
+{
+    int x_ctb = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts] % s->ps.sps->ctb_width;
+
+    return s->ps.pps->column_width[s->ps.pps->col_idxX[x_ctb]];
+}
+
 void ff_hevc_save_states(HEVCContext *s, int ctb_addr_ts)
 {
     if (s->ps.pps->entropy_coding_sync_enabled_flag &&
-        (ctb_addr_ts % s->ps.sps->ctb_width == 2 ||
-         (s->ps.sps->ctb_width == 2 &&
-          ctb_addr_ts % s->ps.sps->ctb_width == 0))) {
-        memcpy(s->cabac_state, s->HEVClc->cabac_state, HEVC_CONTEXTS);
+        ctb_x_in_tile(s, ctb_addr_ts - 1) == 1) {
+        memcpy(wpp_states(s, ctb_addr_ts - 1), s->HEVClc->cabac_state, HEVC_CONTEXTS);
     }
 }
 
-static void load_states(HEVCContext *s)
+static void load_states(HEVCContext *s, int ctb_addr_ts)
 {
-    memcpy(s->HEVClc->cabac_state, s->cabac_state, HEVC_CONTEXTS);
+    memcpy(s->HEVClc->cabac_state, wpp_states(s, ctb_addr_ts), HEVC_CONTEXTS);
 }
 
 static void cabac_reinit(HEVCLocalContext *lc)
@@ -503,27 +524,26 @@ static void cabac_init_state(HEVCContext *s)
 
 int ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts)
 {
+    int tile_start = s->ps.pps->tiles_enabled_flag && ctb_addr_ts &&
+                     s->ps.pps->tile_id[ctb_addr_ts] != s->ps.pps->tile_id[ctb_addr_ts - 1];
+    int row_start  = s->ps.pps->entropy_coding_sync_enabled_flag && !tile_start &&
+                     !ctb_x_in_tile(s, ctb_addr_ts);
+
     if (ctb_addr_ts == s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs]) {
         int ret = cabac_init_decoder(s);
         if (ret < 0)
             return ret;
-        if (s->sh.dependent_slice_segment_flag == 0 ||
-            (s->ps.pps->tiles_enabled_flag &&
-             s->ps.pps->tile_id[ctb_addr_ts] != s->ps.pps->tile_id[ctb_addr_ts - 1]))
+        if (s->sh.dependent_slice_segment_flag == 0 || tile_start)
             cabac_init_state(s);
-
-        if (!s->sh.first_slice_in_pic_flag &&
-            s->ps.pps->entropy_coding_sync_enabled_flag) {
-            if (ctb_addr_ts % s->ps.sps->ctb_width == 0) {
-                if (s->ps.sps->ctb_width == 1)
-                    cabac_init_state(s);
-                else if (s->sh.dependent_slice_segment_flag == 1)
-                    load_states(s);
-            }
+        else if (row_start) {
+            // the upper right CTB is in another tile when the tile is one CTB wide
+            if (tile_column_width(s, ctb_addr_ts) == 1)
+                cabac_init_state(s);
+            else
+                load_states(s, ctb_addr_ts);
         }
     } else {
-        if (s->ps.pps->tiles_enabled_flag &&
-            s->ps.pps->tile_id[ctb_addr_ts] != s->ps.pps->tile_id[ctb_addr_ts - 1]) {
+        if (tile_start) {
             if (s->threads_number == 1)
                 cabac_reinit(s->HEVClc);
             else {
@@ -532,23 +552,20 @@ int ff_hevc_cabac_init(HEVCContext *s, int ctb_addr_ts)
                     return ret;
             }
             cabac_init_state(s);
-        }
-        if (s->ps.pps->entropy_coding_sync_enabled_flag) {
-            if (ctb_addr_ts % s->ps.sps->ctb_width == 0) {
-                get_cabac_terminate(&s->HEVClc->cc);
-                if (s->threads_number == 1)
-                    cabac_reinit(s->HEVClc);
-                else {
-                    int ret = cabac_init_decoder(s);
-                    if (ret < 0)
-                        return ret;
-                }
-
-                if (s->ps.sps->ctb_width == 1)
-                    cabac_init_state(s);
-                else
-                    load_states(s);
+        } else if (row_start) {
+            get_cabac_terminate(&s->HEVClc->cc);
+            if (s->threads_number == 1)
+                cabac_reinit(s->HEVClc);
+            else {
+                int ret = cabac_init_decoder(s);
+                if (ret < 0)
+                    return ret;
             }
+
+            if (tile_column_width(s, ctb_addr_ts) == 1)
+                cabac_init_state(s);
+            else
+                load_states(s, ctb_addr_ts);
         }
     }
     return 0;
@@ -1335,7 +1335,7 @@ static inline int setup_pps(AVCodecContext *avctx, GetBitContext *gb,
         pps->row_bd[i + 1] = pps->row_bd[i] + pps->row_height[i];
 
     for (i = 0, j = 0; i < sps->ctb_width; i++) {
-        if (i > pps->col_bd[j])
+        if (i >= pps->col_bd[j + 1])
             j++;
         pps->col_idxX[i] = j;
     }
@@ -814,8 +814,13 @@ static int hls_slice_header(HEVCContext *s)
                 sh->entry_point_offset[i] = val + 1; // +1; // +1 to get the size
             }
             if (s->threads_number > 1 && (s->ps.pps->num_tile_rows > 1 || s->ps.pps->num_tile_columns > 1)) {
-                s->enable_parallel_tiles = 0; // TODO: you can enable tiles in parallel here
-                s->threads_number = 1;
+                // without tile_threads the WPP entry points assume CTB rows spanning the picture
+                if (s->tile_threads) {
+                    s->enable_parallel_tiles = 1;
+                } else {
+                    s->enable_parallel_tiles = 0;
+                    s->threads_number = 1;
+                }
             } else
                 s->enable_parallel_tiles = 0;
         } else
@@ -2306,17 +2311,23 @@ static void hls_decode_neighbour(HEVCContext *s, int x_ctb, int y_ctb,
     int ctb_addr_in_slice = ctb_addr_rs - s->sh.slice_addr;
 
     s->tab_slice_address[ctb_addr_rs] = s->sh.slice_addr;
+    s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
+    s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
+    s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
+
+    if (s->ps.pps->tiles_enabled_flag) {
+        int idxX = s->ps.pps->col_idxX[x_ctb >> s->ps.sps->log2_ctb_size];
 
-    if (s->ps.pps->entropy_coding_sync_enabled_flag) {
+        // with WPP, each CTB row of a tile starts a quantization group
+        if ((ctb_addr_ts && s->ps.pps->tile_id[ctb_addr_ts] != s->ps.pps->tile_id[ctb_addr_ts - 1]) ||
+            (s->ps.pps->entropy_coding_sync_enabled_flag &&
+             x_ctb >> s->ps.sps->log2_ctb_size == s->ps.pps->col_bd[idxX]))
+            lc->first_qp_group = 1;
+        lc->end_of_tiles_x = s->ps.pps->col_bd[idxX + 1] << s->ps.sps->log2_ctb_size;
+    } else if (s->ps.pps->entropy_coding_sync_enabled_flag) {
         if (x_ctb == 0 && (y_ctb & (ctb_size - 1)) == 0)
             lc->first_qp_group = 1;
         lc->end_of_tiles_x = s->ps.sps->width;
-    } else if (s->ps.pps->tiles_enabled_flag) {
-        if (ctb_addr_ts && s->ps.pps->tile_id[ctb_addr_ts] != s->ps.pps->tile_id[ctb_addr_ts - 1]) {
-            int idxX = s->ps.pps->col_idxX[x_ctb >> s->ps.sps->log2_ctb_size];
-            lc->end_of_tiles_x   = x_ctb + (s->ps.pps->column_width[idxX] << s->ps.sps->log2_ctb_size);
-            lc->first_qp_group   = 1;
-        }
     } else {
         lc->end_of_tiles_x = s->ps.sps->width;
     }
@@ -2384,10 +2395,6 @@ static int hls_decode_entry(AVCodecContext *avctxt, void *isFilterThread)
 
         hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
 
-        s->deblock[ctb_addr_rs].beta_offset = s->sh.beta_offset;
-        s->deblock[ctb_addr_rs].tc_offset   = s->sh.tc_offset;
-        s->filter_slice_edges[ctb_addr_rs]  = s->sh.slice_loop_filter_across_slices_enabled_flag;
-
         more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
         if (more_data < 0) {
             s->tab_slice_address[ctb_addr_rs] = -1;
@@ -2433,6 +2440,8 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
 
     s = s1->sList[self_id];
     lc = s->HEVClc;
+    if (ctb_row == s->sh.num_entry_point_offsets)
+        s1->last_lc = lc;
 
     if(ctb_row) {
         ret = init_get_bits8(&lc->gb, s->data + s->sh.offset[ctb_row - 1], s->sh.size[ctb_row - 1]);
@@ -2468,8 +2477,9 @@ static int hls_decode_entry_wpp(AVCodecContext *avctxt, void *input_ctb_row, int
         ctb_addr_ts++;
 
         ff_hevc_save_states(s, ctb_addr_ts);
-        ff_thread_report_progress2(s->avctx, ctb_row, thread, 1);
+        // the row below filters next to this one, so it waits for the filters too
         ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+        ff_thread_report_progress2(s->avctx, ctb_row, thread, 1);
 
         if (!more_data && (x_ctb+ctb_size) < s->ps.sps->width && ctb_row != s->sh.num_entry_point_offsets) {
             atomic_store(&s1->wpp_err, 1);
@@ -2499,6 +2509,130 @@ error:
     return ret;
 }
 
+/* Decode the substream starting at CTB input_ts[job]: a tile, or with WPP
+ * one CTB row of a tile. The rows of a tile run as wavefronts, each job
+ * waiting on the progress of the row above, i.e. the previous job. */
+static int hls_decode_entry_tiles(AVCodecContext *avctxt, void *input_ts, int job, int self_id)
+{
+    HEVCContext *s1  = avctxt->priv_data, *s;
+    HEVCLocalContext *lc;
+    int more_data   = 1;
+    int *ts_p       = input_ts;
+    int ctb_addr_ts = ts_p[job];
+    int ctb_addr_rs = s1->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+    int tile        = s1->ps.pps->tile_id[ctb_addr_ts];
+    int wpp         = s1->ps.pps->entropy_coding_sync_enabled_flag;
+    int thread      = job % s1->threads_number;
+    int row_above   = wpp && ctb_addr_ts && s1->ps.pps->tile_id[ctb_addr_ts - 1] == tile;
+    int ret;
+
+    s = s1->sList[self_id];
+    lc = s->HEVClc;
+    if (job == s->sh.num_entry_point_offsets)
+        s1->last_lc = lc;
+
+    if (job) {
+        ret = init_get_bits8(&lc->gb, s->data + s->sh.offset[job - 1], s->sh.size[job - 1]);
+        if (ret < 0)
+            goto error;
+    } else {
+        lc->gb = s->slice_data_gb;
+    }
+    lc->first_qp_group = 1;
+
+    while (more_data && ctb_addr_ts < s->ps.sps->ctb_size) {
+        int x_ctb, y_ctb;
+
+        ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+
+        if (row_above)
+            ff_thread_await_progress2(s->avctx, job, thread, SHIFT_CTB_WPP);
+
+        if (atomic_load(&s1->wpp_err)) {
+            ff_thread_report_progress2(s->avctx, job, thread, SHIFT_CTB_WPP);
+            return 0;
+        }
+
+        ret = ff_hevc_cabac_init(s, ctb_addr_ts);
+        if (ret < 0)
+            goto error;
+
+        hls_sao_param(s, x_ctb >> s->ps.sps->log2_ctb_size, y_ctb >> s->ps.sps->log2_ctb_size);
+
+        more_data = hls_coding_quadtree(s, x_ctb, y_ctb, s->ps.sps->log2_ctb_size, 0);
+        if (more_data < 0) {
+            ret = more_data;
+            goto error;
+        }
+
+        ctb_addr_ts++;
+        ff_hevc_save_states(s, ctb_addr_ts);
+        ff_thread_report_progress2(s->avctx, job, thread, 1);
+
+        if (ctb_addr_ts < s->ps.sps->ctb_size &&
+            (s->ps.pps->tile_id[ctb_addr_ts] != tile ||
+             (wpp && x_ctb + (1 << s->ps.sps->log2_ctb_size) >= lc->end_of_tiles_x)))
+            break;
+    }
+
+    if (!more_data && job != s->sh.num_entry_point_offsets) {
+        av_log(s->avctx, AV_LOG_ERROR, "Slice ended in substream %d before its last one\n", job);
+        ret = AVERROR_INVALIDDATA;
+        goto error;
+    }
+    ff_thread_report_progress2(s->avctx, job, thread, SHIFT_CTB_WPP);
+
+    return ctb_addr_ts;
+error:
+    s->tab_slice_address[ctb_addr_rs] = -1;
+    atomic_store(&s1->wpp_err, 1);
+    ff_thread_report_progress2(s->avctx, job, thread, SHIFT_CTB_WPP);
+    return ret;
+}
+
+/* First CTB of the substream following the one of ctb_addr_ts, substreams
+ * starting at each tile, and with WPP at each CTB row of a tile */
+static int next_substream(HEVCContext *s, int ctb_addr_ts)
+{
+    int tile = s->ps.pps->tile_id[ctb_addr_ts];
+
+    for (ctb_addr_ts++; ctb_addr_ts < s->ps.sps->ctb_size; ctb_addr_ts++) {
+        int x_ctb = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts] % s->ps.sps->ctb_width;
+
+        if (s->ps.pps->tile_id[ctb_addr_ts] != tile ||
+            (s->ps.pps->entropy_coding_sync_enabled_flag &&
+             x_ctb == s->ps.pps->col_bd[s->ps.pps->col_idxX[x_ctb]]))
+            break;
+    }
+    return ctb_addr_ts;
+}
+
+/* The loop filters of tile parallel slices run once all tiles are decoded,
+ * in the order the serial decoder would have run them. */
+static void hls_filters_tiles(HEVCContext *s, int ctb_addr_ts, int end_ts)
+{
+    int ctb_size = 1 << s->ps.sps->log2_ctb_size;
+    int x_ctb    = 0;
+    int y_ctb    = 0;
+
+    for (; ctb_addr_ts < end_ts; ctb_addr_ts++) {
+        int ctb_addr_rs = s->ps.pps->ctb_addr_ts_to_rs[ctb_addr_ts];
+
+        x_ctb = (ctb_addr_rs % s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        y_ctb = (ctb_addr_rs / s->ps.sps->ctb_width) << s->ps.sps->log2_ctb_size;
+        hls_decode_neighbour(s, x_ctb, y_ctb, ctb_addr_ts);
+        ff_hevc_deblocking_boundary_strengths_tiles(s, x_ctb, y_ctb, ctb_size);
+        ff_hevc_hls_filters(s, x_ctb, y_ctb, ctb_size);
+    }
+
+    if (x_ctb + ctb_size >= s->ps.sps->width &&
+        y_ctb + ctb_size >= s->ps.sps->height)
+        ff_hevc_hls_filter(s, x_ctb, y_ctb, ctb_size);
+}
+
 static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 {
     const uint8_t *data = nal->data;
@@ -2516,7 +2650,23 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
         return AVERROR(ENOMEM);
     }
 
-    if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
+    if (s->enable_parallel_tiles) {
+        int start_ts = s->ps.pps->ctb_addr_rs_to_ts[s->sh.slice_ctb_addr_rs];
+        int ctb_addr_ts = start_ts;
+
+        for (i = 0; i <= s->sh.num_entry_point_offsets && ctb_addr_ts < s->ps.sps->ctb_size; i++) {
+            arg[i]      = ctb_addr_ts;
+            ctb_addr_ts = next_substream(s, ctb_addr_ts);
+        }
+        if (i <= s->sh.num_entry_point_offsets ||
+            (start_ts && next_substream(s, start_ts - 1) != start_ts) ||
+            (!start_ts && s->sh.dependent_slice_segment_flag)) {
+            av_log(s->avctx, AV_LOG_ERROR, "Tile entry points are wrong (%d %d)\n",
+                   start_ts, s->sh.num_entry_point_offsets);
+            res = AVERROR_INVALIDDATA;
+            goto error;
+        }
+    } else if (s->sh.slice_ctb_addr_rs + s->sh.num_entry_point_offsets * s->ps.sps->ctb_width >= s->ps.sps->ctb_width * s->ps.sps->ctb_height) {
         av_log(s->avctx, AV_LOG_ERROR, "WPP ctb addresses are wrong (%d %d %d %d)\n",
             s->sh.slice_ctb_addr_rs, s->sh.num_entry_point_offsets,
             s->ps.sps->ctb_width, s->ps.sps->ctb_height
@@ -2570,6 +2720,7 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
 
     }
     s->data = data;
+    s->slice_data_gb = lc->gb;
 
     for (i = 1; i < s->threads_number; i++) {
         s->sList[i]->HEVClc->first_qp_group = 1;
@@ -2581,16 +2732,43 @@ static int hls_slice_data_wpp(HEVCContext *s, const H2645NAL *nal)
     atomic_store(&s->wpp_err, 0);
     ff_reset_entries(s->avctx);
 
-    for (i = 0; i <= s->sh.num_entry_point_offsets; i++) {
-        arg[i] = i;
+    for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
         ret[i] = 0;
-    }
 
-    if (s->ps.pps->entropy_coding_sync_enabled_flag)
-        s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+    if (s->enable_parallel_tiles) {
+        int start_ts = arg[0];
+        int end_ts   = next_substream(s, arg[s->sh.num_entry_point_offsets]);
 
-    for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
-        res += ret[i];
+        // the neighbouring tiles of this slice are decoded concurrently
+        for (i = start_ts; i < end_ts; i++)
+            s->tab_slice_address[s->ps.pps->ctb_addr_ts_to_rs[i]] = s->sh.slice_addr;
+
+        s->avctx->execute2(s->avctx, hls_decode_entry_tiles, arg, ret, s->sh.num_entry_point_offsets + 1);
+
+        res = ret[s->sh.num_entry_point_offsets];
+        for (i = 0; i < s->sh.num_entry_point_offsets; i++)
+            if (ret[i] < 0)
+                res = ret[i];
+        if (res >= 0)
+            hls_filters_tiles(s, start_ts, res);
+    } else {
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
+            arg[i] = i;
+
+        if (s->ps.pps->entropy_coding_sync_enabled_flag)
+            s->avctx->execute2(s->avctx, hls_decode_entry_wpp, arg, ret, s->sh.num_entry_point_offsets + 1);
+
+        for (i = 0; i <= s->sh.num_entry_point_offsets; i++)
+            res += ret[i];
+    }
+
+    // a following dependent slice segment continues from the last substream
+    if (res >= 0 && s->last_lc != lc) {
+        memcpy(lc->cabac_state, s->last_lc->cabac_state, HEVC_CONTEXTS);
+        memcpy(lc->stat_coeff, s->last_lc->stat_coeff, sizeof(lc->stat_coeff));
+        lc->qp_y     = s->last_lc->qp_y;
+        lc->qPy_pred = s->last_lc->qPy_pred;
+    }
 error:
     av_free(ret);
     av_free(arg);
@@ -2741,6 +2919,12 @@ static int hevc_frame_start(HEVCContext *s)
                            ((s->ps.sps->height >> s->ps.sps->log2_min_cb_size) + 1);
     int ret;
 
+    // the wavefronts of the tiles may run in parallel
+    av_fast_malloc(&s->cabac_state, &s->cabac_state_size,
+                   s->ps.pps->num_tile_columns * s->ps.pps->num_tile_rows * HEVC_CONTEXTS);
+    if (!s->cabac_state)
+        return AVERROR(ENOMEM);
+
     memset(s->horizontal_bs, 0, s->bs_width * s->bs_height);
     memset(s->vertical_bs,   0, s->bs_width * s->bs_height);
     memset(s->cbf_luma,      0, s->ps.sps->min_tb_width * s->ps.sps->min_tb_height);
@@ -3247,7 +3431,7 @@ static av_cold int hevc_init_context(AVCodecContext *avctx)
     s->HEVClcList[0] = s->HEVClc;
     s->sList[0] = s;
 
-    s->cabac_state = av_malloc(HEVC_CONTEXTS);
+    av_fast_malloc(&s->cabac_state, &s->cabac_state_size, HEVC_CONTEXTS);
     if (!s->cabac_state)
         goto fail;
 
@@ -3432,6 +3616,8 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "tile_threads", "decode the tiles of a slice in parallel with slice threads", OFFSET(tile_threads),
+        AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { NULL },
 };
 
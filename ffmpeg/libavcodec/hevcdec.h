@@ -394,7 +394,9 @@ typedef struct HEVCContext {
     int                 width;
     int                 height;
 
+    /** WPP storage of the context variables, one HEVC_CONTEXTS block per tile */
     uint8_t *cabac_state;
+    unsigned int cabac_state_size;
 
     /** 1 if the independent slice segment header was successfully parsed */
     uint8_t slice_initialized;
@@ -466,8 +468,10 @@ typedef struct HEVCContext {
 
     int enable_parallel_tiles;
     atomic_int wpp_err;
+    HEVCLocalContext *last_lc; ///< local context that decoded the last substream of the slice segment
 
     const uint8_t *data;
+    GetBitContext slice_data_gb; ///< slice data of the first tile for parallel tile decoding
 
     H2645Packet pkt;
     // type of the first VCL NAL of the current frame
@@ -477,6 +481,7 @@ typedef struct HEVCContext {
     int is_nalff;           ///< this flag is != 0 if bitstream is encapsulated
                             ///< as a format defined in 14496-15
     int apply_defdispwin;
+    int tile_threads;
 
     int nal_length_size;    ///< Number of bytes used for nal length (1, 2 or 4)
     int nuh_layer_id;
@@ -570,6 +575,8 @@ void ff_hevc_set_qPy(HEVCContext *s, int xBase, int yBase,
                      int log2_cb_size);
 void ff_hevc_deblocking_boundary_strengths(HEVCContext *s, int x0, int y0,
                                            int log2_trafo_size);
+void ff_hevc_deblocking_boundary_strengths_tiles(HEVCContext *s, int x_ctb, int y_ctb,
+                                                 int ctb_size);
 int ff_hevc_cu_qp_delta_sign_flag(HEVCContext *s);
 int ff_hevc_cu_qp_delta_abs(HEVCContext *s);
 int ff_hevc_cu_chroma_qp_offset_flag(HEVCContext *s);
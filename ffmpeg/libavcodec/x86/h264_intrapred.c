@@ -0,0 +1,233 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+/**
+ * @file
+ * H.264 16x16 luma and 8x8 chroma intra prediction, SSE2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/avcodec.h"
+#include "libavcodec/h264pred.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+
+static av_always_inline void fill16(uint8_t *src, ptrdiff_t stride, __m128i v)
+{
+    int i;
+    for (i = 0; i < 16; i++, src += stride)
+        _mm_storeu_si128((__m128i *)src, v);
+}
+
+static av_always_inline void fill8(uint8_t *src, ptrdiff_t stride, __m128i v)
+{
+    int i;
+    for (i = 0; i < 8; i++, src += stride)
+        _mm_storel_epi64((__m128i *)src, v);
+}
+
+static av_always_inline int sum_top16(const uint8_t *top)
+{
+    __m128i s = _mm_sad_epu8(_mm_loadu_si128((const __m128i *)top), _mm_setzero_si128());
+    return _mm_cvtsi128_si32(_mm_add_epi32(s, _mm_srli_si128(s, 8)));
+}
+
+static av_always_inline int sum_left(const uint8_t *src, ptrdiff_t stride, int n)
+{
+    int i, sum = 0;
+    for (i = 0; i < n; i++)
+        sum += src[-1 + i * stride];
+    return sum;
+}
+
+static void pred16x16_vertical_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    fill16(src, stride, _mm_loadu_si128((const __m128i *)(src - stride)));
+}
+
+static void pred16x16_horizontal_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    int i;
+    for (i = 0; i < 16; i++, src += stride)
+        _mm_storeu_si128((__m128i *)src, _mm_set1_epi8(src[-1]));
+}
+
+static void pred16x16_dc_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    int dc = sum_top16(src - stride) + sum_left(src, stride, 16);
+    fill16(src, stride, _mm_set1_epi8((dc + 16) >> 5));
+}
+
+static void pred16x16_left_dc_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    fill16(src, stride, _mm_set1_epi8((sum_left(src, stride, 16) + 8) >> 4));
+}
+
+static void pred16x16_top_dc_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    fill16(src, stride, _mm_set1_epi8((sum_top16(src - stride) + 8) >> 4));
+}
+
+static void pred16x16_128_dc_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    fill16(src, stride, _mm_set1_epi8(128));
+}
+
+/* The plane values stay within 16 bits for 8-bit samples */
+static void pred16x16_plane_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    const uint8_t *src0 = src + 7 - stride;
+    const uint8_t *src1 = src + 8 * stride - 1;
+    const uint8_t *src2 = src1 - 2 * stride;
+    __m128i b, vh, vv, h8;
+    int H = src0[1] - src0[-1];
+    int V = src1[0] - src2[0];
+    int a, j, k;
+
+    for (k = 2; k <= 8; k++) {
+        src1 += stride;
+        src2 -= stride;
+        H += k * (src0[k] - src0[-k]);
+        V += k * (src1[0] - src2[0]);
+    }
+    H = (5 * H + 32) >> 6;
+    V = (5 * V + 32) >> 6;
+    a = 16 * (src1[0] + src2[16] + 1) - 7 * (V + H);
+
+    vh = _mm_set1_epi16(H);
+    vv = _mm_set1_epi16(V);
+    b  = _mm_add_epi16(_mm_set1_epi16(a),
+                       _mm_mullo_epi16(vh, _mm_set_epi16(7, 6, 5, 4, 3, 2, 1, 0)));
+    h8 = _mm_slli_epi16(vh, 3);
+
+    for (j = 0; j < 16; j++, src += stride) {
+        __m128i lo = _mm_srai_epi16(b, 5);
+        __m128i hi = _mm_srai_epi16(_mm_add_epi16(b, h8), 5);
+        _mm_storeu_si128((__m128i *)src, _mm_packus_epi16(lo, hi));
+        b = _mm_add_epi16(b, vv);
+    }
+}
+
+static void pred8x8_vertical_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    fill8(src, stride, _mm_loadl_epi64((const __m128i *)(src - stride)));
+}
+
+static void pred8x8_horizontal_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    int i;
+    for (i = 0; i < 8; i++, src += stride)
+        _mm_storel_epi64((__m128i *)src, _mm_set1_epi8(src[-1]));
+}
+
+static void pred8x8_128_dc_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    fill8(src, stride, _mm_set1_epi8(128));
+}
+
+static void pred8x8_dc_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    const uint8_t *top = src - stride;
+    int dc0 = sum_left(src, stride, 4) + top[0] + top[1] + top[2] + top[3];
+    int dc1 = top[4] + top[5] + top[6] + top[7];
+    int dc2 = sum_left(src + 4 * stride, stride, 4);
+    __m128i up   = _mm_unpacklo_epi32(_mm_set1_epi8((dc0 + 4) >> 3),
+                                      _mm_set1_epi8((dc1 + 2) >> 2));
+    __m128i down = _mm_unpacklo_epi32(_mm_set1_epi8((dc2 + 2) >> 2),
+                                      _mm_set1_epi8((dc1 + dc2 + 4) >> 3));
+    int i;
+
+    for (i = 0; i < 4; i++)
+        _mm_storel_epi64((__m128i *)(src + i * stride), up);
+    for (; i < 8; i++)
+        _mm_storel_epi64((__m128i *)(src + i * stride), down);
+}
+
+static void pred8x8_plane_sse2(uint8_t *src, ptrdiff_t stride)
+{
+    const uint8_t *src0 = src + 3 - stride;
+    const uint8_t *src1 = src + 4 * stride - 1;
+    const uint8_t *src2 = src1 - 2 * stride;
+    __m128i b, vv;
+    int H = src0[1] - src0[-1];
+    int V = src1[0] - src2[0];
+    int a, j, k;
+
+    for (k = 2; k <= 4; k++) {
+        src1 += stride;
+        src2 -= stride;
+        H += k * (src0[k] - src0[-k]);
+        V += k * (src1[0] - src2[0]);
+    }
+    H = (17 * H + 16) >> 5;
+    V = (17 * V + 16) >> 5;
+    a = 16 * (src1[0] + src2[8] + 1) - 3 * (V + H);
+
+    vv = _mm_set1_epi16(V);
+    b  = _mm_add_epi16(_mm_set1_epi16(a),
+                       _mm_mullo_epi16(_mm_set1_epi16(H),
+                                       _mm_set_epi16(7, 6, 5, 4, 3, 2, 1, 0)));
+
+    for (j = 0; j < 8; j++, src += stride) {
+        __m128i v = _mm_srai_epi16(b, 5);
+        _mm_storel_epi64((__m128i *)src, _mm_packus_epi16(v, v));
+        b = _mm_add_epi16(b, vv);
+    }
+}
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_h264_pred_init_x86(H264PredContext *h, int codec_id,
+                                   const int bit_depth,
+                                   const int chroma_format_idc)
+{
+#if HAVE_INTRINSICS_SSE2
+    if (bit_depth != 8 || !INTRINSICS_SSE2(av_get_cpu_flags()))
+        return;
+
+    h->pred16x16[VERT_PRED8x8   ] = pred16x16_vertical_sse2;
+    h->pred16x16[HOR_PRED8x8    ] = pred16x16_horizontal_sse2;
+    h->pred16x16[DC_PRED8x8     ] = pred16x16_dc_sse2;
+    h->pred16x16[LEFT_DC_PRED8x8] = pred16x16_left_dc_sse2;
+    h->pred16x16[TOP_DC_PRED8x8 ] = pred16x16_top_dc_sse2;
+    h->pred16x16[DC_128_PRED8x8 ] = pred16x16_128_dc_sse2;
+    if (codec_id != AV_CODEC_ID_SVQ3 && codec_id != AV_CODEC_ID_RV40 &&
+        codec_id != AV_CODEC_ID_VP7  && codec_id != AV_CODEC_ID_VP8)
+        h->pred16x16[PLANE_PRED8x8] = pred16x16_plane_sse2;
+
+    if (chroma_format_idc <= 1) {
+        h->pred8x8[VERT_PRED8x8  ] = pred8x8_vertical_sse2;
+        h->pred8x8[HOR_PRED8x8   ] = pred8x8_horizontal_sse2;
+        h->pred8x8[DC_128_PRED8x8] = pred8x8_128_dc_sse2;
+        if (codec_id != AV_CODEC_ID_VP7 && codec_id != AV_CODEC_ID_VP8)
+            h->pred8x8[PLANE_PRED8x8] = pred8x8_plane_sse2;
+        if (codec_id != AV_CODEC_ID_RV40 &&
+            codec_id != AV_CODEC_ID_VP7  && codec_id != AV_CODEC_ID_VP8)
+            h->pred8x8[DC_PRED8x8] = pred8x8_dc_sse2;
+    }
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
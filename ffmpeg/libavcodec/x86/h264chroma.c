@@ -0,0 +1,142 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+/**
+ * @file
+ * H.264 chroma motion compensation, SSE2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/h264chroma.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+
+/* Same branches as the C version so the same source pixels are read:
+ * bilinear when both fractions are set, 2-tap along the one set direction,
+ * plain copy otherwise. */
+
+static av_always_inline __m128i load_px(const uint8_t *src, int w)
+{
+    __m128i v = w == 8 ? _mm_loadl_epi64((const __m128i *)src)
+                       : _mm_cvtsi32_si128(AV_RN32(src));
+    return _mm_unpacklo_epi8(v, _mm_setzero_si128());
+}
+
+static av_always_inline void store_px(uint8_t *dst, __m128i v, int w, int avg)
+{
+    v = _mm_srli_epi16(_mm_add_epi16(v, _mm_set1_epi16(32)), 6);
+    v = _mm_packus_epi16(v, v);
+    if (w == 8) {
+        if (avg)
+            v = _mm_avg_epu8(v, _mm_loadl_epi64((const __m128i *)dst));
+        _mm_storel_epi64((__m128i *)dst, v);
+    } else {
+        if (avg)
+            v = _mm_avg_epu8(v, _mm_cvtsi32_si128(AV_RN32(dst)));
+        AV_WN32(dst, _mm_cvtsi128_si32(v));
+    }
+}
+
+static av_always_inline void chroma_mc(uint8_t *dst, uint8_t *src,
+                                       ptrdiff_t stride, int h, int x, int y,
+                                       int w, int avg)
+{
+    const int A = (8 - x) * (8 - y);
+    const int B = (    x) * (8 - y);
+    const int C = (8 - x) * (    y);
+    const int D = (    x) * (    y);
+    int i;
+
+    if (D) {
+        const __m128i va = _mm_set1_epi16(A), vb = _mm_set1_epi16(B);
+        const __m128i vc = _mm_set1_epi16(C), vd = _mm_set1_epi16(D);
+        __m128i t0 = load_px(src, w), t1 = load_px(src + 1, w);
+
+        for (i = 0; i < h; i++) {
+            __m128i b0 = load_px(src + stride, w), b1 = load_px(src + stride + 1, w);
+            __m128i v  = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(t0, va),
+                                                     _mm_mullo_epi16(t1, vb)),
+                                       _mm_add_epi16(_mm_mullo_epi16(b0, vc),
+                                                     _mm_mullo_epi16(b1, vd)));
+            store_px(dst, v, w, avg);
+            t0   = b0;
+            t1   = b1;
+            dst += stride;
+            src += stride;
+        }
+    } else if (B + C) {
+        const __m128i va = _mm_set1_epi16(A), ve = _mm_set1_epi16(B + C);
+        const ptrdiff_t step = C ? stride : 1;
+
+        for (i = 0; i < h; i++) {
+            __m128i v = _mm_add_epi16(_mm_mullo_epi16(load_px(src, w), va),
+                                      _mm_mullo_epi16(load_px(src + step, w), ve));
+            store_px(dst, v, w, avg);
+            dst += stride;
+            src += stride;
+        }
+    } else {
+        for (i = 0; i < h; i++) {
+            store_px(dst, _mm_slli_epi16(load_px(src, w), 6), w, avg);
+            dst += stride;
+            src += stride;
+        }
+    }
+}
+
+#define CHROMA_MC(OPNAME, W, AVG)                                               \
+static void OPNAME ## h264_chroma_mc ## W ## _sse2(uint8_t *dst, uint8_t *src,    \
+                                                   ptrdiff_t stride, int h,     \
+                                                   int x, int y)                \
+{                                                                               \
+    chroma_mc(dst, src, stride, h, x, y, W, AVG);                               \
+}
+
+CHROMA_MC(put_, 8, 0)
+CHROMA_MC(avg_, 8, 1)
+CHROMA_MC(put_, 4, 0)
+CHROMA_MC(avg_, 4, 1)
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_h264chroma_init_x86(H264ChromaContext *c, int bit_depth)
+{
+#if HAVE_INTRINSICS_SSE2
+    const int high_bit_depth = bit_depth > 8;
+
+    if (!INTRINSICS_SSE2(av_get_cpu_flags()))
+        return;
+
+    if (!high_bit_depth) {
+        c->put_h264_chroma_pixels_tab[0] = put_h264_chroma_mc8_sse2;
+        c->avg_h264_chroma_pixels_tab[0] = avg_h264_chroma_mc8_sse2;
+        c->put_h264_chroma_pixels_tab[1] = put_h264_chroma_mc4_sse2;
+        c->avg_h264_chroma_pixels_tab[1] = avg_h264_chroma_mc4_sse2;
+    }
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
@@ -0,0 +1,670 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+/**
+ * @file
+ * H.264 IDCT and loop filter, SSE2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/h264dec.h"
+#include "libavcodec/h264dsp.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+
+/****************************************************************************
+ * IDCT transform:
+ ****************************************************************************/
+
+#define LOAD4(p)      _mm_cvtsi32_si128(AV_RN32(p))
+#define STORE4(p, v)  AV_WN32(p, _mm_cvtsi128_si32(v))
+
+static av_always_inline void transpose4x4_epi16(__m128i *r)
+{
+    __m128i t0  = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i t1  = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i c01 = _mm_unpacklo_epi32(t0, t1);
+    __m128i c23 = _mm_unpackhi_epi32(t0, t1);
+
+    r[0] = c01;
+    r[1] = _mm_unpackhi_epi64(c01, c01);
+    r[2] = c23;
+    r[3] = _mm_unpackhi_epi64(c23, c23);
+}
+
+static av_always_inline void transpose8x8_epi16(__m128i *r)
+{
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+static av_always_inline void idct4_1d(__m128i *r)
+{
+    __m128i z0 = _mm_add_epi16(r[0], r[2]);
+    __m128i z1 = _mm_sub_epi16(r[0], r[2]);
+    __m128i z2 = _mm_sub_epi16(_mm_srai_epi16(r[1], 1), r[3]);
+    __m128i z3 = _mm_add_epi16(r[1], _mm_srai_epi16(r[3], 1));
+
+    r[0] = _mm_add_epi16(z0, z3);
+    r[1] = _mm_add_epi16(z1, z2);
+    r[2] = _mm_sub_epi16(z1, z2);
+    r[3] = _mm_sub_epi16(z0, z3);
+}
+
+static av_always_inline void idct8_1d(__m128i *r)
+{
+    __m128i a0 = _mm_add_epi16(r[0], r[4]);
+    __m128i a2 = _mm_sub_epi16(r[0], r[4]);
+    __m128i a4 = _mm_sub_epi16(_mm_srai_epi16(r[2], 1), r[6]);
+    __m128i a6 = _mm_add_epi16(_mm_srai_epi16(r[6], 1), r[2]);
+
+    __m128i b0 = _mm_add_epi16(a0, a6);
+    __m128i b2 = _mm_add_epi16(a2, a4);
+    __m128i b4 = _mm_sub_epi16(a2, a4);
+    __m128i b6 = _mm_sub_epi16(a0, a6);
+
+    __m128i a1 = _mm_sub_epi16(_mm_sub_epi16(r[5], r[3]),
+                               _mm_add_epi16(r[7], _mm_srai_epi16(r[7], 1)));
+    __m128i a3 = _mm_sub_epi16(_mm_add_epi16(r[1], r[7]),
+                               _mm_add_epi16(r[3], _mm_srai_epi16(r[3], 1)));
+    __m128i a5 = _mm_add_epi16(_mm_sub_epi16(r[7], r[1]),
+                               _mm_add_epi16(r[5], _mm_srai_epi16(r[5], 1)));
+    __m128i a7 = _mm_add_epi16(_mm_add_epi16(r[3], r[5]),
+                               _mm_add_epi16(r[1], _mm_srai_epi16(r[1], 1)));
+
+    __m128i b1 = _mm_add_epi16(_mm_srai_epi16(a7, 2), a1);
+    __m128i b3 = _mm_add_epi16(a3, _mm_srai_epi16(a5, 2));
+    __m128i b5 = _mm_sub_epi16(_mm_srai_epi16(a3, 2), a5);
+    __m128i b7 = _mm_sub_epi16(a7, _mm_srai_epi16(a1, 2));
+
+    r[0] = _mm_add_epi16(b0, b7);
+    r[7] = _mm_sub_epi16(b0, b7);
+    r[1] = _mm_add_epi16(b2, b5);
+    r[6] = _mm_sub_epi16(b2, b5);
+    r[2] = _mm_add_epi16(b4, b3);
+    r[5] = _mm_sub_epi16(b4, b3);
+    r[3] = _mm_add_epi16(b6, b1);
+    r[4] = _mm_sub_epi16(b6, b1);
+}
+
+static void h264_idct_add_sse2(uint8_t *dst, int16_t *block, int stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+        r[i] = _mm_loadl_epi64((const __m128i *)(block + 4 * i));
+    r[0] = _mm_add_epi16(r[0], _mm_cvtsi32_si128(1 << 5));
+
+    idct4_1d(r);
+    transpose4x4_epi16(r);
+    idct4_1d(r);
+
+    for (i = 0; i < 4; i++) {
+        __m128i pix = _mm_unpacklo_epi8(LOAD4(dst), zero);
+        pix = _mm_add_epi16(pix, _mm_srai_epi16(r[i], 6));
+        STORE4(dst, _mm_packus_epi16(pix, pix));
+        dst += stride;
+    }
+
+    _mm_storeu_si128((__m128i *)(block + 0), zero);
+    _mm_storeu_si128((__m128i *)(block + 8), zero);
+}
+
+static void h264_idct8_add_sse2(uint8_t *dst, int16_t *block, int stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+        r[i] = _mm_loadu_si128((const __m128i *)(block + 8 * i));
+    r[0] = _mm_add_epi16(r[0], _mm_cvtsi32_si128(32));
+
+    idct8_1d(r);
+    transpose8x8_epi16(r);
+    idct8_1d(r);
+
+    for (i = 0; i < 8; i++) {
+        __m128i pix = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dst), zero);
+        pix = _mm_add_epi16(pix, _mm_srai_epi16(r[i], 6));
+        _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(pix, pix));
+        dst += stride;
+        _mm_storeu_si128((__m128i *)(block + 8 * i), zero);
+    }
+}
+
+/* clip(pix + dc) as one saturating add and one saturating subtract, one of
+ * the two splats is always zero */
+#define DC_SPLAT(block, dcp, dcn)                                       \
+    do {                                                                \
+        int dc = ((block)[0] + 32) >> 6;                                \
+        __m128i v = _mm_set1_epi16(dc);                                 \
+        (block)[0] = 0;                                                 \
+        dcp = _mm_packus_epi16(v, v);                                   \
+        v   = _mm_sub_epi16(_mm_setzero_si128(), v);                    \
+        dcn = _mm_packus_epi16(v, v);                                   \
+    } while (0)
+
+static void h264_idct_dc_add_sse2(uint8_t *dst, int16_t *block, int stride)
+{
+    __m128i dcp, dcn;
+    int i;
+
+    DC_SPLAT(block, dcp, dcn);
+    for (i = 0; i < 4; i++) {
+        __m128i pix = LOAD4(dst);
+        STORE4(dst, _mm_subs_epu8(_mm_adds_epu8(pix, dcp), dcn));
+        dst += stride;
+    }
+}
+
+static void h264_idct8_dc_add_sse2(uint8_t *dst, int16_t *block, int stride)
+{
+    __m128i dcp, dcn;
+    int i;
+
+    DC_SPLAT(block, dcp, dcn);
+    for (i = 0; i < 8; i++) {
+        __m128i pix = _mm_loadl_epi64((const __m128i *)dst);
+        _mm_storel_epi64((__m128i *)dst, _mm_subs_epu8(_mm_adds_epu8(pix, dcp), dcn));
+        dst += stride;
+    }
+}
+
+static void h264_idct_add16_sse2(uint8_t *dst, const int *block_offset,
+                                 int16_t *block, int stride,
+                                 const uint8_t nnzc[15 * 8])
+{
+    int i;
+    for (i = 0; i < 16; i++) {
+        int nnz = nnzc[scan8[i]];
+        if (nnz) {
+            if (nnz == 1 && block[i * 16])
+                h264_idct_dc_add_sse2(dst + block_offset[i], block + i * 16, stride);
+            else
+                h264_idct_add_sse2(dst + block_offset[i], block + i * 16, stride);
+        }
+    }
+}
+
+static void h264_idct_add16intra_sse2(uint8_t *dst, const int *block_offset,
+                                      int16_t *block, int stride,
+                                      const uint8_t nnzc[15 * 8])
+{
+    int i;
+    for (i = 0; i < 16; i++) {
+        if (nnzc[scan8[i]])
+            h264_idct_add_sse2(dst + block_offset[i], block + i * 16, stride);
+        else if (block[i * 16])
+            h264_idct_dc_add_sse2(dst + block_offset[i], block + i * 16, stride);
+    }
+}
+
+static void h264_idct8_add4_sse2(uint8_t *dst, const int *block_offset,
+                                 int16_t *block, int stride,
+                                 const uint8_t nnzc[15 * 8])
+{
+    int i;
+    for (i = 0; i < 16; i += 4) {
+        int nnz = nnzc[scan8[i]];
+        if (nnz) {
+            if (nnz == 1 && block[i * 16])
+                h264_idct8_dc_add_sse2(dst + block_offset[i], block + i * 16, stride);
+            else
+                h264_idct8_add_sse2(dst + block_offset[i], block + i * 16, stride);
+        }
+    }
+}
+
+static void h264_idct_add8_sse2(uint8_t **dest, const int *block_offset,
+                                int16_t *block, int stride,
+                                const uint8_t nnzc[15 * 8])
+{
+    int i, j;
+    for (j = 1; j < 3; j++) {
+        for (i = j * 16; i < j * 16 + 4; i++) {
+            if (nnzc[scan8[i]])
+                h264_idct_add_sse2(dest[j - 1] + block_offset[i], block + i * 16, stride);
+            else if (block[i * 16])
+                h264_idct_dc_add_sse2(dest[j - 1] + block_offset[i], block + i * 16, stride);
+        }
+    }
+}
+
+/****************************************************************************
+ * Loop filter:
+ ****************************************************************************/
+
+/* The filters work on 8 lines of 16-bit samples, one line per lane. Vertical
+ * edges are transposed on load and store so both directions share them. */
+
+#define LOAD8(p)      _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(p)), _mm_setzero_si128())
+#define STORE8(p, v)  _mm_storel_epi64((__m128i *)(p), _mm_packus_epi16(v, v))
+
+static av_always_inline __m128i abs_diff(__m128i a, __m128i b)
+{
+    return _mm_max_epi16(_mm_sub_epi16(a, b), _mm_sub_epi16(b, a));
+}
+
+static av_always_inline __m128i blend(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static av_always_inline __m128i clip_tc(__m128i v, __m128i tc)
+{
+    return _mm_min_epi16(_mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), tc)), tc);
+}
+
+static av_always_inline __m128i edge_mask(__m128i p1, __m128i p0, __m128i q0,
+                                          __m128i q1, __m128i alpha, __m128i beta)
+{
+    return _mm_and_si128(_mm_cmplt_epi16(abs_diff(p0, q0), alpha),
+                         _mm_and_si128(_mm_cmplt_epi16(abs_diff(p1, p0), beta),
+                                       _mm_cmplt_epi16(abs_diff(q1, q0), beta)));
+}
+
+/* p0' and q0' from the bounded delta shared by luma and chroma */
+static av_always_inline void filter_p0q0(__m128i *p0, __m128i *q0, __m128i p1,
+                                         __m128i q1, __m128i tc, __m128i mask)
+{
+    __m128i delta = _mm_add_epi16(_mm_slli_epi16(_mm_sub_epi16(*q0, *p0), 2),
+                                  _mm_sub_epi16(p1, q1));
+    delta = _mm_srai_epi16(_mm_add_epi16(delta, _mm_set1_epi16(4)), 3);
+    delta = clip_tc(delta, tc);
+
+    *p0 = blend(mask, _mm_add_epi16(*p0, delta), *p0);
+    *q0 = blend(mask, _mm_sub_epi16(*q0, delta), *q0);
+}
+
+static av_always_inline void luma_filter(__m128i *r, int alpha, int beta,
+                                         __m128i tc0)
+{
+    const __m128i va = _mm_set1_epi16(alpha);
+    const __m128i vb = _mm_set1_epi16(beta);
+    __m128i p2 = r[1], p1 = r[2], p0 = r[3];
+    __m128i q0 = r[4], q1 = r[5], q2 = r[6];
+    __m128i mask, ap, aq, avg, tc;
+
+    mask = edge_mask(p1, p0, q0, q1, va, vb);
+    mask = _mm_and_si128(mask, _mm_cmpgt_epi16(tc0, _mm_set1_epi16(-1)));
+    ap   = _mm_and_si128(mask, _mm_cmplt_epi16(abs_diff(p2, p0), vb));
+    aq   = _mm_and_si128(mask, _mm_cmplt_epi16(abs_diff(q2, q0), vb));
+    tc   = _mm_sub_epi16(_mm_sub_epi16(tc0, ap), aq);
+
+    avg  = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p0, q0), _mm_set1_epi16(1)), 1);
+    r[2] = blend(ap, _mm_add_epi16(p1, clip_tc(_mm_sub_epi16(_mm_srli_epi16(_mm_add_epi16(p2, avg), 1), p1), tc0)), p1);
+    r[5] = blend(aq, _mm_add_epi16(q1, clip_tc(_mm_sub_epi16(_mm_srli_epi16(_mm_add_epi16(q2, avg), 1), q1), tc0)), q1);
+
+    filter_p0q0(&p0, &q0, p1, q1, tc, mask);
+    r[3] = p0;
+    r[4] = q0;
+}
+
+static av_always_inline void luma_intra_filter(__m128i *r, int alpha, int beta)
+{
+    const __m128i va  = _mm_set1_epi16(alpha);
+    const __m128i vb  = _mm_set1_epi16(beta);
+    const __m128i two = _mm_set1_epi16(2);
+    const __m128i four = _mm_set1_epi16(4);
+    __m128i p3 = r[0], p2 = r[1], p1 = r[2], p0 = r[3];
+    __m128i q0 = r[4], q1 = r[5], q2 = r[6], q3 = r[7];
+    __m128i mask, strong, ap, aq, p0q0, s, p0w, q0w;
+
+    mask   = edge_mask(p1, p0, q0, q1, va, vb);
+    strong = _mm_and_si128(mask, _mm_cmplt_epi16(abs_diff(p0, q0),
+                                                 _mm_set1_epi16((alpha >> 2) + 2)));
+    ap     = _mm_and_si128(strong, _mm_cmplt_epi16(abs_diff(p2, p0), vb));
+    aq     = _mm_and_si128(strong, _mm_cmplt_epi16(abs_diff(q2, q0), vb));
+
+    p0q0 = _mm_add_epi16(p0, q0);
+
+    /* weak p0'/q0' */
+    p0w = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(p1, 1), p0),
+                                       _mm_add_epi16(q1, two)), 2);
+    q0w = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(q1, 1), q0),
+                                       _mm_add_epi16(p1, two)), 2);
+
+    /* p side: s = p1 + p0 + q0 */
+    s    = _mm_add_epi16(p1, p0q0);
+    r[3] = blend(ap, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p2, _mm_slli_epi16(s, 1)),
+                                                  _mm_add_epi16(q1, four)), 3),
+                 blend(mask, p0w, p0));
+    r[2] = blend(ap, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p2, s), two), 2), p1);
+    r[1] = blend(ap, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(_mm_add_epi16(p3, p2), 1), p2),
+                                                  _mm_add_epi16(s, four)), 3), p2);
+
+    /* q side: s = q1 + q0 + p0 */
+    s    = _mm_add_epi16(q1, p0q0);
+    r[4] = blend(aq, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(q2, _mm_slli_epi16(s, 1)),
+                                                  _mm_add_epi16(p1, four)), 3),
+                 blend(mask, q0w, q0));
+    r[5] = blend(aq, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(q2, s), two), 2), q1);
+    r[6] = blend(aq, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(_mm_add_epi16(q3, q2), 1), q2),
+                                                  _mm_add_epi16(s, four)), 3), q2);
+}
+
+static av_always_inline void chroma_filter(__m128i *r, int alpha, int beta,
+                                           __m128i tc)
+{
+    __m128i mask = edge_mask(r[0], r[1], r[2], r[3],
+                             _mm_set1_epi16(alpha), _mm_set1_epi16(beta));
+    mask = _mm_and_si128(mask, _mm_cmpgt_epi16(tc, _mm_setzero_si128()));
+    filter_p0q0(&r[1], &r[2], r[0], r[3], tc, mask);
+}
+
+static av_always_inline void chroma_intra_filter(__m128i *r, int alpha, int beta)
+{
+    const __m128i two = _mm_set1_epi16(2);
+    __m128i p1 = r[0], p0 = r[1], q0 = r[2], q1 = r[3];
+    __m128i mask = edge_mask(p1, p0, q0, q1,
+                             _mm_set1_epi16(alpha), _mm_set1_epi16(beta));
+
+    r[1] = blend(mask, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(p1, 1), p0),
+                                                    _mm_add_epi16(q1, two)), 2), p0);
+    r[2] = blend(mask, _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(q1, 1), q0),
+                                                    _mm_add_epi16(p1, two)), 2), q0);
+}
+
+/* tc0[0] for lanes 0-3, tc0[1] for lanes 4-7 */
+#define LUMA_TC(tc0) _mm_set_epi16(tc0[1], tc0[1], tc0[1], tc0[1], \
+                                   tc0[0], tc0[0], tc0[0], tc0[0])
+/* each of the 4 tc0 values covers 2 lanes */
+#define CHROMA_TC(tc0) _mm_set_epi16(tc0[3], tc0[3], tc0[2], tc0[2], \
+                                     tc0[1], tc0[1], tc0[0], tc0[0])
+
+/* 16 rows of 8 pixels to 8 columns of 16 pixels */
+static av_always_inline void transpose16x8_load(__m128i *col, const uint8_t *src,
+                                                int stride)
+{
+    __m128i a[8], b[8], c[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+        a[i] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + (2 * i    ) * stride)),
+                                 _mm_loadl_epi64((const __m128i *)(src + (2 * i + 1) * stride)));
+    for (i = 0; i < 4; i++) {
+        b[2 * i    ] = _mm_unpacklo_epi16(a[2 * i], a[2 * i + 1]);
+        b[2 * i + 1] = _mm_unpackhi_epi16(a[2 * i], a[2 * i + 1]);
+    }
+    for (i = 0; i < 2; i++) {
+        c[4 * i    ] = _mm_unpacklo_epi32(b[4 * i    ], b[4 * i + 2]);
+        c[4 * i + 1] = _mm_unpackhi_epi32(b[4 * i    ], b[4 * i + 2]);
+        c[4 * i + 2] = _mm_unpacklo_epi32(b[4 * i + 1], b[4 * i + 3]);
+        c[4 * i + 3] = _mm_unpackhi_epi32(b[4 * i + 1], b[4 * i + 3]);
+    }
+    for (i = 0; i < 4; i++) {
+        col[2 * i    ] = _mm_unpacklo_epi64(c[i], c[i + 4]);
+        col[2 * i + 1] = _mm_unpackhi_epi64(c[i], c[i + 4]);
+    }
+}
+
+/* 8 columns of 16 pixels back to 16 rows of 8 pixels */
+static av_always_inline void transpose8x16_store(uint8_t *dst, int stride,
+                                                 const __m128i *col)
+{
+    int h, i;
+
+    for (h = 0; h < 2; h++, dst += 8 * stride) {
+        __m128i a[4], b[4], d;
+        for (i = 0; i < 4; i++)
+            a[i] = h ? _mm_unpackhi_epi8(col[2 * i], col[2 * i + 1])
+                     : _mm_unpacklo_epi8(col[2 * i], col[2 * i + 1]);
+        b[0] = _mm_unpacklo_epi16(a[0], a[1]);
+        b[1] = _mm_unpackhi_epi16(a[0], a[1]);
+        b[2] = _mm_unpacklo_epi16(a[2], a[3]);
+        b[3] = _mm_unpackhi_epi16(a[2], a[3]);
+        for (i = 0; i < 4; i++) {
+            d = i & 1 ? _mm_unpackhi_epi32(b[i >> 1], b[(i >> 1) + 2])
+                      : _mm_unpacklo_epi32(b[i >> 1], b[(i >> 1) + 2]);
+            _mm_storel_epi64((__m128i *)(dst + (2 * i    ) * stride), d);
+            _mm_storel_epi64((__m128i *)(dst + (2 * i + 1) * stride),
+                             _mm_unpackhi_epi64(d, d));
+        }
+    }
+}
+
+/* Filter 16 lines given as rows p3..q3, each register holding one sample of
+ * all 16 lines */
+static av_always_inline void luma_filter16(__m128i *row, int alpha, int beta,
+                                           const int8_t *tc0, int intra)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo[8], hi[8];
+    int k;
+
+    for (k = 0; k < 8; k++) {
+        lo[k] = _mm_unpacklo_epi8(row[k], zero);
+        hi[k] = _mm_unpackhi_epi8(row[k], zero);
+    }
+    if (intra) {
+        luma_intra_filter(lo, alpha, beta);
+        luma_intra_filter(hi, alpha, beta);
+    } else {
+        luma_filter(lo, alpha, beta, LUMA_TC(tc0));
+        luma_filter(hi, alpha, beta, LUMA_TC((tc0 + 2)));
+    }
+    for (k = 1; k < 7; k++)
+        row[k] = _mm_packus_epi16(lo[k], hi[k]);
+}
+
+static av_always_inline void v_loop_filter_luma(uint8_t *pix, int stride,
+                                                int alpha, int beta,
+                                                const int8_t *tc0, int intra)
+{
+    /* the normal filter reads only p2..q2 */
+    const int start = intra ? 0 : 1, end = intra ? 8 : 7;
+    __m128i row[8];
+    int k;
+
+    for (k = 0; k < 8; k++)
+        row[k] = k >= start && k < end ? _mm_loadu_si128((const __m128i *)(pix + (k - 4) * stride))
+                                       : _mm_setzero_si128();
+    luma_filter16(row, alpha, beta, tc0, intra);
+    for (k = start + 1; k < end - 1; k++)
+        _mm_storeu_si128((__m128i *)(pix + (k - 4) * stride), row[k]);
+}
+
+static av_always_inline void h_loop_filter_luma(uint8_t *pix, int stride,
+                                                int alpha, int beta,
+                                                const int8_t *tc0, int intra)
+{
+    __m128i col[8];
+
+    transpose16x8_load(col, pix - 4, stride);
+    luma_filter16(col, alpha, beta, tc0, intra);
+    transpose8x16_store(pix - 4, stride, col);
+}
+
+static void h264_v_loop_filter_luma_sse2(uint8_t *pix, int stride,
+                                         int alpha, int beta, int8_t *tc0)
+{
+    if ((tc0[0] & tc0[1] & tc0[2] & tc0[3]) < 0)
+        return;
+    v_loop_filter_luma(pix, stride, alpha, beta, tc0, 0);
+}
+
+static void h264_h_loop_filter_luma_sse2(uint8_t *pix, int stride,
+                                         int alpha, int beta, int8_t *tc0)
+{
+    if ((tc0[0] & tc0[1] & tc0[2] & tc0[3]) < 0)
+        return;
+    h_loop_filter_luma(pix, stride, alpha, beta, tc0, 0);
+}
+
+static void h264_v_loop_filter_luma_intra_sse2(uint8_t *pix, int stride,
+                                               int alpha, int beta)
+{
+    v_loop_filter_luma(pix, stride, alpha, beta, NULL, 1);
+}
+
+static void h264_h_loop_filter_luma_intra_sse2(uint8_t *pix, int stride,
+                                               int alpha, int beta)
+{
+    h_loop_filter_luma(pix, stride, alpha, beta, NULL, 1);
+}
+
+/* 8 rows of p1 p0 q0 q1 to one register per sample position */
+static av_always_inline void load_chroma_h(__m128i *r, const uint8_t *src,
+                                           int stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i a[4], b0, b1, c0, c1;
+    int i;
+
+    for (i = 0; i < 4; i++)
+        a[i] = _mm_unpacklo_epi8(LOAD4(src + (2 * i    ) * stride),
+                                 LOAD4(src + (2 * i + 1) * stride));
+    b0 = _mm_unpacklo_epi16(a[0], a[1]);
+    b1 = _mm_unpacklo_epi16(a[2], a[3]);
+    c0 = _mm_unpacklo_epi32(b0, b1);
+    c1 = _mm_unpackhi_epi32(b0, b1);
+
+    r[0] = _mm_unpacklo_epi8(c0, zero);
+    r[1] = _mm_unpackhi_epi8(c0, zero);
+    r[2] = _mm_unpacklo_epi8(c1, zero);
+    r[3] = _mm_unpackhi_epi8(c1, zero);
+}
+
+static av_always_inline void store_chroma_h(uint8_t *dst, int stride,
+                                            const __m128i *r)
+{
+    __m128i c0 = _mm_packus_epi16(r[0], r[1]);
+    __m128i c1 = _mm_packus_epi16(r[2], r[3]);
+    __m128i e0 = _mm_unpacklo_epi8(c0, _mm_unpackhi_epi64(c0, c0));
+    __m128i e1 = _mm_unpacklo_epi8(c1, _mm_unpackhi_epi64(c1, c1));
+    __m128i f[2];
+    int i;
+
+    f[0] = _mm_unpacklo_epi16(e0, e1);
+    f[1] = _mm_unpackhi_epi16(e0, e1);
+    for (i = 0; i < 8; i++) {
+        STORE4(dst, f[i >> 2]);
+        f[i >> 2] = _mm_srli_si128(f[i >> 2], 4);
+        dst += stride;
+    }
+}
+
+static void h264_v_loop_filter_chroma_sse2(uint8_t *pix, int stride,
+                                           int alpha, int beta, int8_t *tc0)
+{
+    __m128i r[4];
+    int k;
+    for (k = 0; k < 4; k++)
+        r[k] = LOAD8(pix + (k - 2) * stride);
+    chroma_filter(r, alpha, beta, CHROMA_TC(tc0));
+    STORE8(pix - stride, r[1]);
+    STORE8(pix,          r[2]);
+}
+
+static void h264_h_loop_filter_chroma_sse2(uint8_t *pix, int stride,
+                                           int alpha, int beta, int8_t *tc0)
+{
+    __m128i r[4];
+    load_chroma_h(r, pix - 2, stride);
+    chroma_filter(r, alpha, beta, CHROMA_TC(tc0));
+    store_chroma_h(pix - 2, stride, r);
+}
+
+static void h264_v_loop_filter_chroma_intra_sse2(uint8_t *pix, int stride,
+                                                 int alpha, int beta)
+{
+    __m128i r[4];
+    int k;
+    for (k = 0; k < 4; k++)
+        r[k] = LOAD8(pix + (k - 2) * stride);
+    chroma_intra_filter(r, alpha, beta);
+    STORE8(pix - stride, r[1]);
+    STORE8(pix,          r[2]);
+}
+
+static void h264_h_loop_filter_chroma_intra_sse2(uint8_t *pix, int stride,
+                                                 int alpha, int beta)
+{
+    __m128i r[4];
+    load_chroma_h(r, pix - 2, stride);
+    chroma_intra_filter(r, alpha, beta);
+    store_chroma_h(pix - 2, stride, r);
+}
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_h264dsp_init_x86(H264DSPContext *c, const int bit_depth,
+                                 const int chroma_format_idc)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+
+    if (bit_depth == 8 && INTRINSICS_SSE2(cpu_flags)) {
+        c->h264_idct_add        = h264_idct_add_sse2;
+        c->h264_idct8_add       = h264_idct8_add_sse2;
+        c->h264_idct_dc_add     = h264_idct_dc_add_sse2;
+        c->h264_idct8_dc_add    = h264_idct8_dc_add_sse2;
+        c->h264_idct_add16      = h264_idct_add16_sse2;
+        c->h264_idct_add16intra = h264_idct_add16intra_sse2;
+        c->h264_idct8_add4      = h264_idct8_add4_sse2;
+        if (chroma_format_idc <= 1)
+            c->h264_idct_add8   = h264_idct_add8_sse2;
+
+        c->h264_v_loop_filter_luma       = h264_v_loop_filter_luma_sse2;
+        c->h264_h_loop_filter_luma       = h264_h_loop_filter_luma_sse2;
+        c->h264_v_loop_filter_luma_intra = h264_v_loop_filter_luma_intra_sse2;
+        c->h264_h_loop_filter_luma_intra = h264_h_loop_filter_luma_intra_sse2;
+        c->h264_v_loop_filter_chroma       = h264_v_loop_filter_chroma_sse2;
+        c->h264_v_loop_filter_chroma_intra = h264_v_loop_filter_chroma_intra_sse2;
+        if (chroma_format_idc <= 1) {
+            c->h264_h_loop_filter_chroma       = h264_h_loop_filter_chroma_sse2;
+            c->h264_h_loop_filter_chroma_intra = h264_h_loop_filter_chroma_intra_sse2;
+        }
+    }
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
@@ -0,0 +1,551 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+/**
+ * @file
+ * H.264 quarter-pel motion compensation, SSE2 and AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/h264qpel.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+/* All filters apply the 6-tap (1, -5, 20, 20, -5, 1) kernel on 16-bit lanes.
+ * Every function is instantiated for one block size, the avg flag selects
+ * between storing and averaging with the destination. */
+
+static av_always_inline __m128i load_row(const uint8_t *src, int w)
+{
+    return w == 16 ? _mm_loadu_si128((const __m128i *)src)
+                   : _mm_loadl_epi64((const __m128i *)src);
+}
+
+static av_always_inline void store_row(uint8_t *dst, __m128i v, int w, int avg)
+{
+    if (avg)
+        v = _mm_avg_epu8(v, load_row(dst, w));
+    if (w == 16)
+        _mm_storeu_si128((__m128i *)dst, v);
+    else
+        _mm_storel_epi64((__m128i *)dst, v);
+}
+
+static av_always_inline __m128i tap6(__m128i t0, __m128i t1, __m128i t2,
+                                     __m128i t3, __m128i t4, __m128i t5)
+{
+    __m128i v = _mm_mullo_epi16(_mm_add_epi16(t2, t3), _mm_set1_epi16(20));
+    v = _mm_sub_epi16(v, _mm_mullo_epi16(_mm_add_epi16(t1, t4), _mm_set1_epi16(5)));
+    return _mm_add_epi16(v, _mm_add_epi16(t0, t5));
+}
+
+static av_always_inline __m128i round5(__m128i v)
+{
+    return _mm_srai_epi16(_mm_add_epi16(v, _mm_set1_epi16(16)), 5);
+}
+
+/* 8 unfiltered horizontal sums from the 13 bytes at bytes[0..12] */
+static av_always_inline __m128i h_sum8(__m128i bytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return tap6(_mm_unpacklo_epi8(bytes, zero),
+                _mm_unpacklo_epi8(_mm_srli_si128(bytes, 1), zero),
+                _mm_unpacklo_epi8(_mm_srli_si128(bytes, 2), zero),
+                _mm_unpacklo_epi8(_mm_srli_si128(bytes, 3), zero),
+                _mm_unpacklo_epi8(_mm_srli_si128(bytes, 4), zero),
+                _mm_unpacklo_epi8(_mm_srli_si128(bytes, 5), zero));
+}
+
+/* Unfiltered horizontal sums of one row. The loads cover exactly
+ * src[-2] to src[w + 2], like the C code. */
+static av_always_inline void h_sums(__m128i *lo, __m128i *hi,
+                                    const uint8_t *src, int w)
+{
+    if (w == 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src - 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 3));
+        *lo = h_sum8(a);
+        *hi = h_sum8(_mm_srli_si128(b, 3));
+    } else {
+        __m128i a = _mm_loadl_epi64((const __m128i *)(src - 2));
+        __m128i b = _mm_loadl_epi64((const __m128i *)(src + 3));
+        *lo = h_sum8(_mm_or_si128(a, _mm_slli_si128(b, 5)));
+    }
+}
+
+static av_always_inline void h_lowpass(uint8_t *dst, const uint8_t *src,
+                                       ptrdiff_t dstStride, ptrdiff_t srcStride,
+                                       int w, int avg)
+{
+    int y;
+    for (y = 0; y < w; y++) {
+        __m128i lo, hi = _mm_setzero_si128();
+        h_sums(&lo, &hi, src, w);
+        store_row(dst, _mm_packus_epi16(round5(lo), round5(hi)), w, avg);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static av_always_inline void v_lowpass(uint8_t *dst, const uint8_t *src,
+                                       ptrdiff_t dstStride, ptrdiff_t srcStride,
+                                       int w, int avg)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo[6], hi[6];
+    int y, i;
+
+    src -= 2 * srcStride;
+    for (i = 0; i < 5; i++) {
+        __m128i row = load_row(src + i * srcStride, w);
+        lo[i] = _mm_unpacklo_epi8(row, zero);
+        hi[i] = _mm_unpackhi_epi8(row, zero);
+    }
+    src += 5 * srcStride;
+
+    for (y = 0; y < w; y++) {
+        __m128i row = load_row(src, w), rlo, rhi = zero;
+        lo[5] = _mm_unpacklo_epi8(row, zero);
+        rlo   = round5(tap6(lo[0], lo[1], lo[2], lo[3], lo[4], lo[5]));
+        if (w == 16) {
+            hi[5] = _mm_unpackhi_epi8(row, zero);
+            rhi   = round5(tap6(hi[0], hi[1], hi[2], hi[3], hi[4], hi[5]));
+        }
+        store_row(dst, _mm_packus_epi16(rlo, rhi), w, avg);
+
+        for (i = 0; i < 5; i++) {
+            lo[i] = lo[i + 1];
+            hi[i] = hi[i + 1];
+        }
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+/* Vertical pass over the 16-bit horizontal sums. The sums of symmetric taps
+ * still fit 16 bits, the weighting is done in 32 bits with pmaddwd. */
+static av_always_inline __m128i hv_tap6(__m128i t0, __m128i t1, __m128i t2,
+                                        __m128i t3, __m128i t4, __m128i t5)
+{
+    const __m128i coeffs = _mm_set_epi16(-5, 20, -5, 20, -5, 20, -5, 20);
+    const __m128i rnd    = _mm_set1_epi32(512);
+    __m128i s23 = _mm_add_epi16(t2, t3);
+    __m128i s14 = _mm_add_epi16(t1, t4);
+    __m128i s05 = _mm_add_epi16(t0, t5);
+    __m128i sgn = _mm_srai_epi16(s05, 15);
+    __m128i lo  = _mm_madd_epi16(_mm_unpacklo_epi16(s23, s14), coeffs);
+    __m128i hi  = _mm_madd_epi16(_mm_unpackhi_epi16(s23, s14), coeffs);
+
+    lo = _mm_add_epi32(lo, _mm_add_epi32(_mm_unpacklo_epi16(s05, sgn), rnd));
+    hi = _mm_add_epi32(hi, _mm_add_epi32(_mm_unpackhi_epi16(s05, sgn), rnd));
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 10), _mm_srai_epi32(hi, 10));
+}
+
+static av_always_inline void hv_lowpass(uint8_t *dst, const uint8_t *src,
+                                        ptrdiff_t dstStride, ptrdiff_t srcStride,
+                                        int w, int avg)
+{
+    __m128i lo[6], hi[6];
+    int y, i;
+
+    src -= 2 * srcStride;
+    for (i = 0; i < 5; i++) {
+        hi[i] = _mm_setzero_si128();
+        h_sums(&lo[i], &hi[i], src, w);
+        src += srcStride;
+    }
+
+    for (y = 0; y < w; y++) {
+        __m128i rlo, rhi = _mm_setzero_si128();
+        hi[5] = _mm_setzero_si128();
+        h_sums(&lo[5], &hi[5], src, w);
+        rlo = hv_tap6(lo[0], lo[1], lo[2], lo[3], lo[4], lo[5]);
+        if (w == 16)
+            rhi = hv_tap6(hi[0], hi[1], hi[2], hi[3], hi[4], hi[5]);
+        store_row(dst, _mm_packus_epi16(rlo, rhi), w, avg);
+
+        for (i = 0; i < 5; i++) {
+            lo[i] = lo[i + 1];
+            hi[i] = hi[i + 1];
+        }
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static av_always_inline void pixels_l2(uint8_t *dst, const uint8_t *src1,
+                                       const uint8_t *src2, ptrdiff_t dstStride,
+                                       ptrdiff_t src1Stride, ptrdiff_t src2Stride,
+                                       int w, int avg)
+{
+    int y;
+    for (y = 0; y < w; y++) {
+        store_row(dst, _mm_avg_epu8(load_row(src1, w), load_row(src2, w)), w, avg);
+        dst  += dstStride;
+        src1 += src1Stride;
+        src2 += src2Stride;
+    }
+}
+
+static av_always_inline void pixels_copy(uint8_t *dst, const uint8_t *src,
+                                         ptrdiff_t stride, int w, int avg)
+{
+    int y;
+    for (y = 0; y < w; y++) {
+        store_row(dst, load_row(src, w), w, avg);
+        dst += stride;
+        src += stride;
+    }
+}
+
+#if HAVE_INTRINSICS_AVX2
+/* 16 pixels per row in one register */
+
+static av_always_inline av_target_avx2 __m256i load_row16_avx2(const uint8_t *src)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src));
+}
+
+static av_always_inline av_target_avx2 void store_row16_avx2(uint8_t *dst, __m256i v,
+                                                             int avg)
+{
+    __m256i p = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i r = _mm256_castsi256_si128(p);
+    if (avg)
+        r = _mm_avg_epu8(r, _mm_loadu_si128((const __m128i *)dst));
+    _mm_storeu_si128((__m128i *)dst, r);
+}
+
+static av_always_inline av_target_avx2 __m256i tap6_avx2(__m256i t0, __m256i t1,
+                                                         __m256i t2, __m256i t3,
+                                                         __m256i t4, __m256i t5)
+{
+    __m256i v = _mm256_mullo_epi16(_mm256_add_epi16(t2, t3), _mm256_set1_epi16(20));
+    v = _mm256_sub_epi16(v, _mm256_mullo_epi16(_mm256_add_epi16(t1, t4),
+                                               _mm256_set1_epi16(5)));
+    return _mm256_add_epi16(v, _mm256_add_epi16(t0, t5));
+}
+
+static av_always_inline av_target_avx2 __m256i round5_avx2(__m256i v)
+{
+    return _mm256_srai_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(16)), 5);
+}
+
+static av_always_inline av_target_avx2 __m256i h_sums16_avx2(const uint8_t *src)
+{
+    return tap6_avx2(load_row16_avx2(src - 2), load_row16_avx2(src - 1),
+                     load_row16_avx2(src),     load_row16_avx2(src + 1),
+                     load_row16_avx2(src + 2), load_row16_avx2(src + 3));
+}
+
+static av_always_inline av_target_avx2 void h_lowpass16_avx2(uint8_t *dst, const uint8_t *src,
+                                                             ptrdiff_t dstStride,
+                                                             ptrdiff_t srcStride,
+                                                             int w, int avg)
+{
+    int y;
+    for (y = 0; y < 16; y++) {
+        store_row16_avx2(dst, round5_avx2(h_sums16_avx2(src)), avg);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static av_always_inline av_target_avx2 void v_lowpass16_avx2(uint8_t *dst, const uint8_t *src,
+                                                             ptrdiff_t dstStride,
+                                                             ptrdiff_t srcStride,
+                                                             int w, int avg)
+{
+    __m256i r[6];
+    int y, i;
+
+    src -= 2 * srcStride;
+    for (i = 0; i < 5; i++)
+        r[i] = load_row16_avx2(src + i * srcStride);
+    src += 5 * srcStride;
+
+    for (y = 0; y < 16; y++) {
+        r[5] = load_row16_avx2(src);
+        store_row16_avx2(dst, round5_avx2(tap6_avx2(r[0], r[1], r[2], r[3], r[4], r[5])), avg);
+        for (i = 0; i < 5; i++)
+            r[i] = r[i + 1];
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static av_always_inline av_target_avx2 __m256i hv_tap6_avx2(__m256i t0, __m256i t1,
+                                                            __m256i t2, __m256i t3,
+                                                            __m256i t4, __m256i t5)
+{
+    const __m256i coeffs = _mm256_set1_epi32((-5 << 16) | 20);
+    const __m256i rnd    = _mm256_set1_epi32(512);
+    __m256i s23 = _mm256_add_epi16(t2, t3);
+    __m256i s14 = _mm256_add_epi16(t1, t4);
+    __m256i s05 = _mm256_add_epi16(t0, t5);
+    __m256i sgn = _mm256_srai_epi16(s05, 15);
+    __m256i lo  = _mm256_madd_epi16(_mm256_unpacklo_epi16(s23, s14), coeffs);
+    __m256i hi  = _mm256_madd_epi16(_mm256_unpackhi_epi16(s23, s14), coeffs);
+
+    lo = _mm256_add_epi32(lo, _mm256_add_epi32(_mm256_unpacklo_epi16(s05, sgn), rnd));
+    hi = _mm256_add_epi32(hi, _mm256_add_epi32(_mm256_unpackhi_epi16(s05, sgn), rnd));
+    return _mm256_packs_epi32(_mm256_srai_epi32(lo, 10), _mm256_srai_epi32(hi, 10));
+}
+
+static av_always_inline av_target_avx2 void hv_lowpass16_avx2(uint8_t *dst, const uint8_t *src,
+                                                              ptrdiff_t dstStride,
+                                                              ptrdiff_t srcStride,
+                                                              int w, int avg)
+{
+    __m256i t[6];
+    int y, i;
+
+    src -= 2 * srcStride;
+    for (i = 0; i < 5; i++) {
+        t[i] = h_sums16_avx2(src);
+        src += srcStride;
+    }
+
+    for (y = 0; y < 16; y++) {
+        t[5] = h_sums16_avx2(src);
+        store_row16_avx2(dst, hv_tap6_avx2(t[0], t[1], t[2], t[3], t[4], t[5]), avg);
+        for (i = 0; i < 5; i++)
+            t[i] = t[i + 1];
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+#define H264_MC(OPNAME, SIZE, AVG, EXT, H, V, HV, ATTR)                          \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc00_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    pixels_copy(dst, src, stride, SIZE, AVG);                                    \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc10_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, half)[SIZE * SIZE];                             \
+    H(half, src, SIZE, stride, SIZE, 0);                                         \
+    pixels_l2(dst, src, half, stride, stride, SIZE, SIZE, AVG);                  \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc20_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    H(dst, src, stride, stride, SIZE, AVG);                                      \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc30_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, half)[SIZE * SIZE];                             \
+    H(half, src, SIZE, stride, SIZE, 0);                                         \
+    pixels_l2(dst, src + 1, half, stride, stride, SIZE, SIZE, AVG);              \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc01_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, half)[SIZE * SIZE];                             \
+    V(half, src, SIZE, stride, SIZE, 0);                                         \
+    pixels_l2(dst, src, half, stride, stride, SIZE, SIZE, AVG);                  \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc02_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    V(dst, src, stride, stride, SIZE, AVG);                                      \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc03_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, half)[SIZE * SIZE];                             \
+    V(half, src, SIZE, stride, SIZE, 0);                                         \
+    pixels_l2(dst, src + stride, half, stride, stride, SIZE, SIZE, AVG);         \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc22_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    HV(dst, src, stride, stride, SIZE, AVG);                                     \
+}                                                                                \
+                                                                                 \
+/* diagonal quarter positions: average of a horizontal and a vertical half */   \
+static av_always_inline ATTR void                                                \
+OPNAME ## h264_qpel ## SIZE ## _hv_l2_ ## EXT(uint8_t *dst, const uint8_t *src,   \
+                                              ptrdiff_t stride,                  \
+                                              int dx, int dy)                    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, halfH)[SIZE * SIZE];                            \
+    DECLARE_ALIGNED(16, uint8_t, halfV)[SIZE * SIZE];                            \
+    H(halfH, src + dy * stride, SIZE, stride, SIZE, 0);                          \
+    V(halfV, src + dx, SIZE, stride, SIZE, 0);                                   \
+    pixels_l2(dst, halfH, halfV, stride, SIZE, SIZE, SIZE, AVG);                 \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc11_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    OPNAME ## h264_qpel ## SIZE ## _hv_l2_ ## EXT(dst, src, stride, 0, 0);         \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc31_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    OPNAME ## h264_qpel ## SIZE ## _hv_l2_ ## EXT(dst, src, stride, 1, 0);         \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc13_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    OPNAME ## h264_qpel ## SIZE ## _hv_l2_ ## EXT(dst, src, stride, 0, 1);         \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc33_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    OPNAME ## h264_qpel ## SIZE ## _hv_l2_ ## EXT(dst, src, stride, 1, 1);         \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc21_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, halfH)[SIZE * SIZE];                            \
+    DECLARE_ALIGNED(16, uint8_t, halfHV)[SIZE * SIZE];                           \
+    H(halfH, src, SIZE, stride, SIZE, 0);                                        \
+    HV(halfHV, src, SIZE, stride, SIZE, 0);                                      \
+    pixels_l2(dst, halfH, halfHV, stride, SIZE, SIZE, SIZE, AVG);                \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc23_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, halfH)[SIZE * SIZE];                            \
+    DECLARE_ALIGNED(16, uint8_t, halfHV)[SIZE * SIZE];                           \
+    H(halfH, src + stride, SIZE, stride, SIZE, 0);                               \
+    HV(halfHV, src, SIZE, stride, SIZE, 0);                                      \
+    pixels_l2(dst, halfH, halfHV, stride, SIZE, SIZE, SIZE, AVG);                \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc12_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, halfV)[SIZE * SIZE];                            \
+    DECLARE_ALIGNED(16, uint8_t, halfHV)[SIZE * SIZE];                           \
+    V(halfV, src, SIZE, stride, SIZE, 0);                                        \
+    HV(halfHV, src, SIZE, stride, SIZE, 0);                                      \
+    pixels_l2(dst, halfV, halfHV, stride, SIZE, SIZE, SIZE, AVG);                \
+}                                                                                \
+                                                                                 \
+static ATTR void OPNAME ## h264_qpel ## SIZE ## _mc32_ ## EXT(uint8_t *dst,        \
+                                                            const uint8_t *src,  \
+                                                            ptrdiff_t stride)    \
+{                                                                                \
+    DECLARE_ALIGNED(16, uint8_t, halfV)[SIZE * SIZE];                            \
+    DECLARE_ALIGNED(16, uint8_t, halfHV)[SIZE * SIZE];                           \
+    V(halfV, src + 1, SIZE, stride, SIZE, 0);                                    \
+    HV(halfHV, src, SIZE, stride, SIZE, 0);                                      \
+    pixels_l2(dst, halfV, halfHV, stride, SIZE, SIZE, SIZE, AVG);                \
+}                                                                                \
+
+H264_MC(put_,  8, 0, sse2, h_lowpass, v_lowpass, hv_lowpass, )
+H264_MC(avg_,  8, 1, sse2, h_lowpass, v_lowpass, hv_lowpass, )
+H264_MC(put_, 16, 0, sse2, h_lowpass, v_lowpass, hv_lowpass, )
+H264_MC(avg_, 16, 1, sse2, h_lowpass, v_lowpass, hv_lowpass, )
+#if HAVE_INTRINSICS_AVX2
+H264_MC(put_, 16, 0, avx2, h_lowpass16_avx2, v_lowpass16_avx2, hv_lowpass16_avx2, av_target_avx2)
+H264_MC(avg_, 16, 1, avx2, h_lowpass16_avx2, v_lowpass16_avx2, hv_lowpass16_avx2, av_target_avx2)
+#endif
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_h264qpel_init_x86(H264QpelContext *c, int bit_depth)
+{
+#if HAVE_INTRINSICS_SSE2
+    const int high_bit_depth = bit_depth > 8;
+    int cpu_flags = av_get_cpu_flags();
+
+    if (high_bit_depth)
+        return;
+
+#define dspfunc(PFX, IDX, NUM, EXT)                                 \
+    c->PFX ## _pixels_tab[IDX][ 0] = PFX ## NUM ## _mc00_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 1] = PFX ## NUM ## _mc10_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 2] = PFX ## NUM ## _mc20_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 3] = PFX ## NUM ## _mc30_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 4] = PFX ## NUM ## _mc01_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 5] = PFX ## NUM ## _mc11_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 6] = PFX ## NUM ## _mc21_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 7] = PFX ## NUM ## _mc31_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 8] = PFX ## NUM ## _mc02_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][ 9] = PFX ## NUM ## _mc12_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][10] = PFX ## NUM ## _mc22_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][11] = PFX ## NUM ## _mc32_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][12] = PFX ## NUM ## _mc03_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][13] = PFX ## NUM ## _mc13_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][14] = PFX ## NUM ## _mc23_ ## EXT;   \
+    c->PFX ## _pixels_tab[IDX][15] = PFX ## NUM ## _mc33_ ## EXT
+
+    if (INTRINSICS_SSE2(cpu_flags)) {
+        dspfunc(put_h264_qpel, 0, 16, sse2);
+        dspfunc(put_h264_qpel, 1,  8, sse2);
+        dspfunc(avg_h264_qpel, 0, 16, sse2);
+        dspfunc(avg_h264_qpel, 1,  8, sse2);
+    }
+#if HAVE_INTRINSICS_AVX2
+    if (INTRINSICS_AVX2(cpu_flags)) {
+        dspfunc(put_h264_qpel, 0, 16, avx2);
+        dspfunc(avg_h264_qpel, 0, 16, avx2);
+    }
+#endif
+#undef dspfunc
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
@@ -0,0 +1,253 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * HEVC motion compensation template, included by hevcdsp.c once per
+ * vector width. STEP output samples are computed per iteration as int16
+ * lanes; filter sums, rounding and weighting are done in 32 bits so the
+ * results match the C code for all inputs.
+ *
+ * The includer defines VEC, STEP, TARGET, V(), SETZERO, LOADU and FN()
+ * and provides FN(load_pixels), FN(store_words) and FN(store_pixels).
+ */
+
+/* Sign extend to 32 bits, lo/hi follow the lane order of punpck[lh]wd */
+static av_always_inline TARGET void FN(widen)(VEC *lo, VEC *hi, VEC v)
+{
+    *lo = V(srai_epi32)(V(unpacklo_epi16)(v, v), 16);
+    *hi = V(srai_epi32)(V(unpackhi_epi16)(v, v), 16);
+}
+
+/* Truncate to int16 like the int16_t stores of the C code */
+static av_always_inline TARGET VEC FN(narrow)(VEC lo, VEC hi)
+{
+    lo = V(srai_epi32)(V(slli_epi32)(lo, 16), 16);
+    hi = V(srai_epi32)(V(slli_epi32)(hi, 16), 16);
+    return V(packs_epi32)(lo, hi);
+}
+
+/* c[] holds pairs of filter taps for pmaddwd */
+static av_always_inline TARGET void FN(filter)(VEC *lo, VEC *hi, const VEC *r,
+                                               const VEC *c, int taps)
+{
+    VEC l = V(madd_epi16)(V(unpacklo_epi16)(r[0], r[1]), c[0]);
+    VEC h = V(madd_epi16)(V(unpackhi_epi16)(r[0], r[1]), c[0]);
+    int k;
+
+    for (k = 2; k < taps; k += 2) {
+        l = V(add_epi32)(l, V(madd_epi16)(V(unpacklo_epi16)(r[k], r[k + 1]), c[k >> 1]));
+        h = V(add_epi32)(h, V(madd_epi16)(V(unpackhi_epi16)(r[k], r[k + 1]), c[k >> 1]));
+    }
+    *lo = l;
+    *hi = h;
+}
+
+static av_always_inline TARGET void FN(filter_h)(VEC *lo, VEC *hi, const uint8_t *src,
+                                                 const VEC *c, int taps, int bit_depth)
+{
+    const int ps = bit_depth > 8;
+    VEC r[8];
+    int k;
+
+    for (k = 0; k < taps; k++)
+        r[k] = FN(load_pixels)(src + ((k - taps / 2 + 1) << ps), bit_depth);
+    FN(filter)(lo, hi, r, c, taps);
+    if (bit_depth > 8) {
+        *lo = V(srai_epi32)(*lo, bit_depth - 8);
+        *hi = V(srai_epi32)(*hi, bit_depth - 8);
+    }
+}
+
+static av_always_inline TARGET void FN(output)(uint8_t *dst, const int16_t *src2,
+                                               VEC lo, VEC hi, int n, int mode, int bit_depth,
+                                               VEC offset, VEC w0, VEC w1, VEC ox,
+                                               __m128i shift)
+{
+    VEC s2lo, s2hi;
+
+    if (mode == MC_PUT) {
+        FN(store_words)(dst, FN(narrow)(lo, hi), n);
+        return;
+    }
+
+    if (mode == MC_BI || mode == MC_BI_W)
+        FN(widen)(&s2lo, &s2hi, LOADU(src2));
+
+    switch (mode) {
+    case MC_UNI:
+        lo = V(add_epi32)(lo, offset);
+        hi = V(add_epi32)(hi, offset);
+        break;
+    case MC_BI:
+        lo = V(add_epi32)(V(add_epi32)(lo, s2lo), offset);
+        hi = V(add_epi32)(V(add_epi32)(hi, s2hi), offset);
+        break;
+    case MC_UNI_W:
+        lo = V(add_epi32)(V(mullo_epi32)(lo, w1), offset);
+        hi = V(add_epi32)(V(mullo_epi32)(hi, w1), offset);
+        break;
+    case MC_BI_W:
+        lo = V(add_epi32)(V(add_epi32)(V(mullo_epi32)(lo, w1),
+                                       V(mullo_epi32)(s2lo, w0)), offset);
+        hi = V(add_epi32)(V(add_epi32)(V(mullo_epi32)(hi, w1),
+                                       V(mullo_epi32)(s2hi, w0)), offset);
+        break;
+    }
+    lo = V(sra_epi32)(lo, shift);
+    hi = V(sra_epi32)(hi, shift);
+    if (mode == MC_UNI_W) {
+        lo = V(add_epi32)(lo, ox);
+        hi = V(add_epi32)(hi, ox);
+    }
+
+    /* saturation to int16 does not change the result of the final clip */
+    FN(store_pixels)(dst, V(packs_epi32)(lo, hi), n, bit_depth);
+}
+
+/**
+ * Generic motion compensation of a width x height block.
+ * The vertical filters keep a sliding window of taps input rows per
+ * column strip, the hv case filters each source row horizontally once.
+ */
+static av_always_inline TARGET void FN(mc)(uint8_t *dst, ptrdiff_t dststride,
+                                           const uint8_t *src, ptrdiff_t srcstride,
+                                           const int16_t *src2, int height, int width,
+                                           const int8_t *fh, const int8_t *fv,
+                                           int taps, int type, int mode, int bit_depth,
+                                           int denom, int wx0, int wx1, int ox0, int ox1)
+{
+    const int ps     = bit_depth > 8;
+    const int dps    = mode == MC_PUT ? 1 : ps;
+    const int before = taps / 2 - 1;
+    const int w      = STEP > 8 ? width & ~(STEP - 1) : width;
+    VEC ch[4], cv[4];
+    VEC offset = SETZERO(), w0 = SETZERO(), w1 = SETZERO(), ox = SETZERO();
+    __m128i shift = _mm_setzero_si128();
+    int x, y, k;
+
+    for (k = 0; k < taps / 2; k++) {
+        if (type == MC_H || type == MC_HV)
+            ch[k] = V(set1_epi32)((fh[2 * k] & 0xFFFF) + fh[2 * k + 1] * 65536);
+        if (type == MC_V || type == MC_HV)
+            cv[k] = V(set1_epi32)((fv[2 * k] & 0xFFFF) + fv[2 * k + 1] * 65536);
+    }
+
+    switch (mode) {
+    case MC_UNI:
+    case MC_BI: {
+        int s  = 14 + (mode == MC_BI) - bit_depth;
+        shift  = _mm_cvtsi32_si128(s);
+        offset = V(set1_epi32)(1 << (s - 1));
+        break;
+    }
+    case MC_UNI_W: {
+        int s  = denom + 14 - bit_depth;
+        shift  = _mm_cvtsi32_si128(s);
+        offset = V(set1_epi32)(1 << (s - 1));
+        w1     = V(set1_epi32)(wx1);
+        ox     = V(set1_epi32)(ox1 * (1 << (bit_depth - 8)));
+        break;
+    }
+    case MC_BI_W: {
+        int log2Wd = denom + 14 - bit_depth;
+        int o0     = ox0 * (1 << (bit_depth - 8));
+        int o1     = ox1 * (1 << (bit_depth - 8));
+        shift  = _mm_cvtsi32_si128(log2Wd + 1);
+        offset = V(set1_epi32)((o0 + o1 + 1) * (1 << log2Wd));
+        w0     = V(set1_epi32)(wx0);
+        w1     = V(set1_epi32)(wx1);
+        break;
+    }
+    }
+
+    for (x = 0; x < w; x += STEP) {
+        const int n      = FFMIN(STEP, width - x);
+        const uint8_t *s = src + (x << ps);
+        uint8_t *d       = dst + (x << dps);
+        VEC r[8], lo, hi;
+
+        if (type == MC_V) {
+            for (k = 0; k < taps - 1; k++)
+                r[k] = FN(load_pixels)(s + (k - before) * srcstride, bit_depth);
+        } else if (type == MC_HV) {
+            for (k = 0; k < taps - 1; k++) {
+                FN(filter_h)(&lo, &hi, s + (k - before) * srcstride, ch, taps, bit_depth);
+                r[k] = V(packs_epi32)(lo, hi);
+            }
+        }
+
+        for (y = 0; y < height; y++) {
+            const int16_t *s2 = NULL;
+
+            if (mode == MC_BI || mode == MC_BI_W)
+                s2 = src2 + y * MAX_PB_SIZE + x;
+
+            if (type == MC_PIXELS && (mode == MC_PUT || mode == MC_UNI)) {
+                VEC p = FN(load_pixels)(s, bit_depth);
+
+                if (mode == MC_UNI)
+                    FN(store_pixels)(d, p, n, bit_depth);
+                else
+                    FN(store_words)(d, V(slli_epi16)(p, 14 - bit_depth), n);
+            } else {
+                switch (type) {
+                case MC_PIXELS:
+                    FN(widen)(&lo, &hi, V(slli_epi16)(FN(load_pixels)(s, bit_depth),
+                                                      14 - bit_depth));
+                    break;
+                case MC_H:
+                    FN(filter_h)(&lo, &hi, s, ch, taps, bit_depth);
+                    break;
+                case MC_V:
+                    r[taps - 1] = FN(load_pixels)(s + (taps - 1 - before) * srcstride, bit_depth);
+                    FN(filter)(&lo, &hi, r, cv, taps);
+                    if (bit_depth > 8) {
+                        lo = V(srai_epi32)(lo, bit_depth - 8);
+                        hi = V(srai_epi32)(hi, bit_depth - 8);
+                    }
+                    break;
+                case MC_HV:
+                    FN(filter_h)(&lo, &hi, s + (taps - 1 - before) * srcstride,
+                                 ch, taps, bit_depth);
+                    r[taps - 1] = V(packs_epi32)(lo, hi);
+                    FN(filter)(&lo, &hi, r, cv, taps);
+                    lo = V(srai_epi32)(lo, 6);
+                    hi = V(srai_epi32)(hi, 6);
+                    break;
+                }
+                FN(output)(d, s2, lo, hi, n, mode, bit_depth, offset, w0, w1, ox, shift);
+            }
+
+            if (type == MC_V || type == MC_HV) {
+                for (k = 0; k < taps - 1; k++)
+                    r[k] = r[k + 1];
+            }
+            s += srcstride;
+            d += dststride;
+        }
+    }
+
+#if STEP > 8
+    /* columns left over by the wide version */
+    if (w < width)
+        mc_sse4(dst + (w << dps), dststride, src + (w << ps), srcstride,
+                src2 ? src2 + w : NULL, height, width - w, fh, fv, taps, type, mode,
+                bit_depth, denom, wx0, wx1, ox0, ox1);
+#endif
+}
@@ -0,0 +1,764 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+/**
+ * @file
+ * HEVC inverse transforms, residual add and motion compensation,
+ * SSE2, SSE4.1 and AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_SSE4
+#include <smmintrin.h>
+#endif
+#if HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+/****************************************************************************
+ * Inverse transforms
+ ****************************************************************************/
+
+/* Coefficient pairs for pmaddwd. The odd half of an n-point transform is
+ * computed on interleaved rows (1,3), (5,7), ..., entry [k * n / 4 + j] holds
+ * the factors of rows 4j+1 and 4j+3 for output k. */
+#define P(a, b) { a, b, a, b, a, b, a, b }
+
+DECLARE_ALIGNED(16, static const int16_t, idct4_even)[2][8] = {
+    P( 64,  64), P( 64, -64),
+};
+
+DECLARE_ALIGNED(16, static const int16_t, idct4_odd)[2][8] = {
+    P( 83,  36), P( 36, -83),
+};
+
+DECLARE_ALIGNED(16, static const int16_t, idct8_odd)[8][8] = {
+    P( 89,  75), P( 50,  18),
+    P( 75, -18), P(-89, -50),
+    P( 50, -89), P( 18,  75),
+    P( 18, -50), P( 75, -89),
+};
+
+DECLARE_ALIGNED(16, static const int16_t, idct16_odd)[32][8] = {
+    P( 90,  87), P( 80,  70), P( 57,  43), P( 25,   9),
+    P( 87,  57), P(  9, -43), P(-80, -90), P(-70, -25),
+    P( 80,   9), P(-70, -87), P(-25,  57), P( 90,  43),
+    P( 70, -43), P(-87,   9), P( 90,  25), P(-80, -57),
+    P( 57, -80), P(-25,  90), P( -9, -87), P( 43,  70),
+    P( 43, -90), P( 57,  25), P(-87,  70), P(  9, -80),
+    P( 25, -70), P( 90, -80), P( 43,   9), P(-57,  87),
+    P(  9, -25), P( 43, -57), P( 70, -80), P( 87, -90),
+};
+
+DECLARE_ALIGNED(16, static const int16_t, idct32_odd)[128][8] = {
+    P( 90,  90), P( 88,  85), P( 82,  78), P( 73,  67),
+    P( 61,  54), P( 46,  38), P( 31,  22), P( 13,   4),
+    P( 90,  82), P( 67,  46), P( 22,  -4), P(-31, -54),
+    P(-73, -85), P(-90, -88), P(-78, -61), P(-38, -13),
+    P( 88,  67), P( 31, -13), P(-54, -82), P(-90, -78),
+    P(-46,  -4), P( 38,  73), P( 90,  85), P( 61,  22),
+    P( 85,  46), P(-13, -67), P(-90, -73), P(-22,  38),
+    P( 82,  88), P( 54,  -4), P(-61, -90), P(-78, -31),
+    P( 82,  22), P(-54, -90), P(-61,  13), P( 78,  85),
+    P( 31, -46), P(-90, -67), P(  4,  73), P( 88,  38),
+    P( 78,  -4), P(-82, -73), P( 13,  85), P( 67, -22),
+    P(-88, -61), P( 31,  90), P( 54, -38), P(-90, -46),
+    P( 73, -31), P(-90, -22), P( 78,  67), P(-38, -90),
+    P(-13,  82), P( 61, -46), P(-88,  -4), P( 85,  54),
+    P( 67, -54), P(-78,  38), P( 85, -22), P(-90,   4),
+    P( 90,  13), P(-88, -31), P( 82,  46), P(-73, -61),
+    P( 61, -73), P(-46,  82), P( 31, -88), P(-13,  90),
+    P( -4, -90), P( 22,  85), P(-38, -78), P( 54,  67),
+    P( 54, -85), P( -4,  88), P(-46, -61), P( 82,  13),
+    P(-90,  38), P( 67, -78), P(-22,  90), P(-31, -73),
+    P( 46, -90), P( 38,  54), P(-90,  31), P( 61, -88),
+    P( 22,  67), P(-85,  13), P( 73, -82), P(  4,  78),
+    P( 38, -88), P( 73,  -4), P(-67,  90), P(-46, -31),
+    P( 85, -78), P( 13,  61), P(-90,  54), P( 22, -82),
+    P( 31, -78), P( 90, -61), P(  4,  54), P(-88,  82),
+    P(-38, -22), P( 73, -90), P( 67, -13), P(-46,  85),
+    P( 22, -61), P( 85, -90), P( 73, -38), P( -4,  46),
+    P(-78,  90), P(-82,  54), P(-13, -31), P( 67, -88),
+    P( 13, -38), P( 61, -78), P( 88, -90), P( 85, -73),
+    P( 54, -31), P(  4,  22), P(-46,  67), P(-82,  90),
+    P(  4, -13), P( 22, -31), P( 38, -46), P( 54, -61),
+    P( 67, -73), P( 78, -82), P( 85, -88), P( 90, -90),
+};
+
+#undef P
+
+/* The transforms work on eight columns at a time, row j of the input is r[j * step].
+ * Sums are kept in 32 bits, lo/hi hold the low and high four columns. */
+static av_always_inline void idct_odd(__m128i *lo, __m128i *hi, const __m128i *r,
+                                      int step, int n, const int16_t (*coeffs)[8])
+{
+    __m128i il[8], ih[8];
+    int j, k;
+
+    for (j = 0; j < n / 4; j++) {
+        il[j] = _mm_unpacklo_epi16(r[(4 * j + 1) * step], r[(4 * j + 3) * step]);
+        ih[j] = _mm_unpackhi_epi16(r[(4 * j + 1) * step], r[(4 * j + 3) * step]);
+    }
+
+    for (k = 0; k < n / 2; k++) {
+        const int16_t (*c)[8] = coeffs + k * n / 4;
+        __m128i f = _mm_load_si128((const __m128i *)c[0]);
+
+        lo[k] = _mm_madd_epi16(il[0], f);
+        hi[k] = _mm_madd_epi16(ih[0], f);
+        for (j = 1; j < n / 4; j++) {
+            f     = _mm_load_si128((const __m128i *)c[j]);
+            lo[k] = _mm_add_epi32(lo[k], _mm_madd_epi16(il[j], f));
+            hi[k] = _mm_add_epi32(hi[k], _mm_madd_epi16(ih[j], f));
+        }
+    }
+}
+
+static av_always_inline void idct_butterfly(__m128i *lo, __m128i *hi,
+                                            const __m128i *elo, const __m128i *ehi,
+                                            const __m128i *olo, const __m128i *ohi,
+                                            int n)
+{
+    int k;
+
+    for (k = 0; k < n / 2; k++) {
+        lo[k]         = _mm_add_epi32(elo[k], olo[k]);
+        hi[k]         = _mm_add_epi32(ehi[k], ohi[k]);
+        lo[n - 1 - k] = _mm_sub_epi32(elo[k], olo[k]);
+        hi[n - 1 - k] = _mm_sub_epi32(ehi[k], ohi[k]);
+    }
+}
+
+static av_always_inline void idct4_1d(__m128i *lo, __m128i *hi, const __m128i *r, int step)
+{
+    __m128i elo[2], ehi[2], olo[2], ohi[2];
+    __m128i il = _mm_unpacklo_epi16(r[0], r[2 * step]);
+    __m128i ih = _mm_unpackhi_epi16(r[0], r[2 * step]);
+    __m128i f0 = _mm_load_si128((const __m128i *)idct4_even[0]);
+    __m128i f1 = _mm_load_si128((const __m128i *)idct4_even[1]);
+
+    elo[0] = _mm_madd_epi16(il, f0);
+    ehi[0] = _mm_madd_epi16(ih, f0);
+    elo[1] = _mm_madd_epi16(il, f1);
+    ehi[1] = _mm_madd_epi16(ih, f1);
+    idct_odd(olo, ohi, r, step, 4, idct4_odd);
+    idct_butterfly(lo, hi, elo, ehi, olo, ohi, 4);
+}
+
+static av_always_inline void idct8_1d(__m128i *lo, __m128i *hi, const __m128i *r, int step)
+{
+    __m128i elo[4], ehi[4], olo[4], ohi[4];
+
+    idct4_1d(elo, ehi, r, 2 * step);
+    idct_odd(olo, ohi, r, step, 8, idct8_odd);
+    idct_butterfly(lo, hi, elo, ehi, olo, ohi, 8);
+}
+
+static av_always_inline void idct16_1d(__m128i *lo, __m128i *hi, const __m128i *r, int step)
+{
+    __m128i elo[8], ehi[8], olo[8], ohi[8];
+
+    idct8_1d(elo, ehi, r, 2 * step);
+    idct_odd(olo, ohi, r, step, 16, idct16_odd);
+    idct_butterfly(lo, hi, elo, ehi, olo, ohi, 16);
+}
+
+static av_always_inline void idct32_1d(__m128i *lo, __m128i *hi, const __m128i *r, int step)
+{
+    __m128i elo[16], ehi[16], olo[16], ohi[16];
+
+    idct16_1d(elo, ehi, r, 2 * step);
+    idct_odd(olo, ohi, r, step, 32, idct32_odd);
+    idct_butterfly(lo, hi, elo, ehi, olo, ohi, 32);
+}
+
+/* One pass over the columns; packssdw provides the clip to int16 of the C code */
+static av_always_inline void idct_pass(int16_t *coeffs, int n, int shift)
+{
+    const __m128i add = _mm_set1_epi32(1 << (shift - 1));
+    int g, j;
+
+    for (g = 0; g < n; g += 8) {
+        __m128i r[32], lo[32], hi[32];
+
+        for (j = 0; j < n; j++) {
+            if (n == 4)
+                r[j] = _mm_loadl_epi64((const __m128i *)(coeffs + j * n));
+            else
+                r[j] = _mm_loadu_si128((const __m128i *)(coeffs + j * n + g));
+        }
+
+        switch (n) {
+        case 4:  idct4_1d (lo, hi, r, 1); break;
+        case 8:  idct8_1d (lo, hi, r, 1); break;
+        case 16: idct16_1d(lo, hi, r, 1); break;
+        case 32: idct32_1d(lo, hi, r, 1); break;
+        }
+
+        for (j = 0; j < n; j++) {
+            __m128i v = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(lo[j], add), shift),
+                                        _mm_srai_epi32(_mm_add_epi32(hi[j], add), shift));
+            if (n == 4)
+                _mm_storel_epi64((__m128i *)(coeffs + j * n), v);
+            else
+                _mm_storeu_si128((__m128i *)(coeffs + j * n + g), v);
+        }
+    }
+}
+
+static av_always_inline void transpose8x8_epi16(__m128i *r)
+{
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+static av_always_inline void transpose(int16_t *coeffs, int n)
+{
+    __m128i a[8], b[8];
+    int i, j, k;
+
+    if (n == 4) {
+        for (k = 0; k < 4; k++)
+            a[k] = _mm_loadl_epi64((const __m128i *)(coeffs + 4 * k));
+        a[4] = a[5] = a[6] = a[7] = _mm_setzero_si128();
+        transpose8x8_epi16(a);
+        for (k = 0; k < 4; k++)
+            _mm_storel_epi64((__m128i *)(coeffs + 4 * k), a[k]);
+        return;
+    }
+
+    for (i = 0; i < n; i += 8) {
+        for (j = i; j < n; j += 8) {
+            for (k = 0; k < 8; k++) {
+                a[k] = _mm_loadu_si128((const __m128i *)(coeffs + (i + k) * n + j));
+                b[k] = _mm_loadu_si128((const __m128i *)(coeffs + (j + k) * n + i));
+            }
+            transpose8x8_epi16(a);
+            transpose8x8_epi16(b);
+            for (k = 0; k < 8; k++) {
+                _mm_storeu_si128((__m128i *)(coeffs + (j + k) * n + i), a[k]);
+                _mm_storeu_si128((__m128i *)(coeffs + (i + k) * n + j), b[k]);
+            }
+        }
+    }
+}
+
+/* Both passes run over columns, the second one on the transposed block.
+ * Zero coefficients beyond col_limit only shorten the C loops, all of them
+ * are processed here. */
+static av_always_inline void idct_sse2(int16_t *coeffs, int n, int bit_depth)
+{
+    idct_pass(coeffs, n, 7);
+    transpose(coeffs, n);
+    idct_pass(coeffs, n, 20 - bit_depth);
+    transpose(coeffs, n);
+}
+
+static av_always_inline void idct_dc_sse2(int16_t *coeffs, int n, int bit_depth)
+{
+    int shift  = 14 - bit_depth;
+    int coeff  = (((coeffs[0] + 1) >> 1) + (1 << (shift - 1))) >> shift;
+    __m128i dc = _mm_set1_epi16(coeff);
+    int i;
+
+    for (i = 0; i < n * n; i += 8)
+        _mm_storeu_si128((__m128i *)(coeffs + i), dc);
+}
+
+#define IDCT_FUNCS(n, depth)                                                  \
+static void idct_ ## n ## x ## n ## _ ## depth ## _sse2(int16_t *coeffs,     \
+                                                        int col_limit)       \
+{                                                                             \
+    idct_sse2(coeffs, n, depth);                                              \
+}                                                                             \
+                                                                              \
+static void idct_ ## n ## x ## n ## _dc_ ## depth ## _sse2(int16_t *coeffs)  \
+{                                                                             \
+    idct_dc_sse2(coeffs, n, depth);                                           \
+}
+
+IDCT_FUNCS( 4, 8)
+IDCT_FUNCS( 8, 8)
+IDCT_FUNCS(16, 8)
+IDCT_FUNCS(32, 8)
+IDCT_FUNCS( 4, 10)
+IDCT_FUNCS( 8, 10)
+IDCT_FUNCS(16, 10)
+IDCT_FUNCS(32, 10)
+
+/****************************************************************************
+ * Residual add
+ ****************************************************************************/
+
+/* The residual is added with saturation, the clip to the pixel range gives
+ * the same result as the unsaturated sum in the C code. */
+static av_always_inline void add_residual_sse2(uint8_t *dst, const int16_t *res,
+                                               ptrdiff_t stride, int n, int bit_depth)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max  = _mm_set1_epi16((1 << bit_depth) - 1);
+    int x, y;
+
+    for (y = 0; y < n; y++) {
+        if (bit_depth == 8) {
+            if (n == 4) {
+                __m128i p = _mm_unpacklo_epi8(_mm_cvtsi32_si128(AV_RN32(dst)), zero);
+                p = _mm_adds_epi16(p, _mm_loadl_epi64((const __m128i *)res));
+                AV_WN32(dst, _mm_cvtsi128_si32(_mm_packus_epi16(p, p)));
+            } else if (n == 8) {
+                __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dst), zero);
+                p = _mm_adds_epi16(p, _mm_loadu_si128((const __m128i *)res));
+                _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(p, p));
+            } else {
+                for (x = 0; x < n; x += 16) {
+                    __m128i p  = _mm_loadu_si128((const __m128i *)(dst + x));
+                    __m128i lo = _mm_unpacklo_epi8(p, zero);
+                    __m128i hi = _mm_unpackhi_epi8(p, zero);
+                    lo = _mm_adds_epi16(lo, _mm_loadu_si128((const __m128i *)(res + x)));
+                    hi = _mm_adds_epi16(hi, _mm_loadu_si128((const __m128i *)(res + x + 8)));
+                    _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+                }
+            }
+        } else {
+            uint16_t *dst16 = (uint16_t *)dst;
+
+            if (n == 4) {
+                __m128i p = _mm_loadl_epi64((const __m128i *)dst16);
+                p = _mm_adds_epi16(p, _mm_loadl_epi64((const __m128i *)res));
+                p = _mm_min_epi16(_mm_max_epi16(p, zero), max);
+                _mm_storel_epi64((__m128i *)dst16, p);
+            } else {
+                for (x = 0; x < n; x += 8) {
+                    __m128i p = _mm_loadu_si128((const __m128i *)(dst16 + x));
+                    p = _mm_adds_epi16(p, _mm_loadu_si128((const __m128i *)(res + x)));
+                    p = _mm_min_epi16(_mm_max_epi16(p, zero), max);
+                    _mm_storeu_si128((__m128i *)(dst16 + x), p);
+                }
+            }
+        }
+        dst += stride;
+        res += n;
+    }
+}
+
+#define ADD_RESIDUAL_FUNC(n, depth, opt, attr)                                 \
+static attr void add_residual ## n ## x ## n ## _ ## depth ## _ ## opt(uint8_t *dst,  \
+                                                                       int16_t *res,  \
+                                                                       ptrdiff_t stride) \
+{                                                                              \
+    add_residual_ ## opt(dst, res, stride, n, depth);                          \
+}
+
+ADD_RESIDUAL_FUNC( 4, 8,  sse2, )
+ADD_RESIDUAL_FUNC( 8, 8,  sse2, )
+ADD_RESIDUAL_FUNC(16, 8,  sse2, )
+ADD_RESIDUAL_FUNC(32, 8,  sse2, )
+ADD_RESIDUAL_FUNC( 4, 10, sse2, )
+ADD_RESIDUAL_FUNC( 8, 10, sse2, )
+ADD_RESIDUAL_FUNC(16, 10, sse2, )
+ADD_RESIDUAL_FUNC(32, 10, sse2, )
+
+#if HAVE_INTRINSICS_AVX2
+static av_always_inline av_target_avx2 void add_residual_avx2(uint8_t *dst, const int16_t *res,
+                                                              ptrdiff_t stride, int n, int bit_depth)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max  = _mm256_set1_epi16((1 << bit_depth) - 1);
+    int x, y;
+
+    for (y = 0; y < n; y++) {
+        if (bit_depth == 8) {
+            for (x = 0; x < n; x += 32) {
+                __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(dst + x)));
+                __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(dst + x + 16)));
+                lo = _mm256_adds_epi16(lo, _mm256_loadu_si256((const __m256i *)(res + x)));
+                hi = _mm256_adds_epi16(hi, _mm256_loadu_si256((const __m256i *)(res + x + 16)));
+                /* packuswb works within 128-bit lanes, restore the column order */
+                _mm256_storeu_si256((__m256i *)(dst + x),
+                                    _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8));
+            }
+        } else {
+            uint16_t *dst16 = (uint16_t *)dst;
+
+            for (x = 0; x < n; x += 16) {
+                __m256i p = _mm256_loadu_si256((const __m256i *)(dst16 + x));
+                p = _mm256_adds_epi16(p, _mm256_loadu_si256((const __m256i *)(res + x)));
+                p = _mm256_min_epi16(_mm256_max_epi16(p, zero), max);
+                _mm256_storeu_si256((__m256i *)(dst16 + x), p);
+            }
+        }
+        dst += stride;
+        res += n;
+    }
+}
+
+ADD_RESIDUAL_FUNC(32, 8,  avx2, av_target_avx2)
+ADD_RESIDUAL_FUNC(16, 10, avx2, av_target_avx2)
+ADD_RESIDUAL_FUNC(32, 10, avx2, av_target_avx2)
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+/****************************************************************************
+ * Motion compensation
+ ****************************************************************************/
+
+enum {
+    MC_PIXELS,
+    MC_H,
+    MC_V,
+    MC_HV,
+};
+
+enum {
+    MC_PUT,     ///< 14-bit intermediate into an int16_t MAX_PB_SIZE block
+    MC_UNI,
+    MC_BI,
+    MC_UNI_W,
+    MC_BI_W,
+};
+
+#if HAVE_INTRINSICS_SSE4
+static av_always_inline av_target_sse4 __m128i load_pixels_sse4(const uint8_t *src, int bit_depth)
+{
+    if (bit_depth == 8)
+        return _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)src));
+    return _mm_loadu_si128((const __m128i *)src);
+}
+
+static av_always_inline av_target_sse4 void store_words_sse4(uint8_t *dst, __m128i v, int n)
+{
+    switch (n) {
+    case 8:
+        _mm_storeu_si128((__m128i *)dst, v);
+        break;
+    case 6:
+        _mm_storel_epi64((__m128i *)dst, v);
+        AV_WN32(dst + 8, _mm_extract_epi32(v, 2));
+        break;
+    case 4:
+        _mm_storel_epi64((__m128i *)dst, v);
+        break;
+    case 2:
+        AV_WN32(dst, _mm_cvtsi128_si32(v));
+        break;
+    }
+}
+
+/* v holds n int16 samples, saturated and clipped here */
+static av_always_inline av_target_sse4 void store_pixels_sse4(uint8_t *dst, __m128i v,
+                                                              int n, int bit_depth)
+{
+    if (bit_depth == 8) {
+        v = _mm_packus_epi16(v, v);
+        switch (n) {
+        case 8:
+            _mm_storel_epi64((__m128i *)dst, v);
+            break;
+        case 6:
+            AV_WN32(dst, _mm_cvtsi128_si32(v));
+            AV_WN16(dst + 4, _mm_extract_epi16(v, 2));
+            break;
+        case 4:
+            AV_WN32(dst, _mm_cvtsi128_si32(v));
+            break;
+        case 2:
+            AV_WN16(dst, _mm_extract_epi16(v, 0));
+            break;
+        }
+    } else {
+        v = _mm_max_epi16(v, _mm_setzero_si128());
+        v = _mm_min_epi16(v, _mm_set1_epi16((1 << bit_depth) - 1));
+        store_words_sse4(dst, v, n);
+    }
+}
+
+#define VEC             __m128i
+#define STEP            8
+#define TARGET          av_target_sse4
+#define V(op)           _mm_ ## op
+#define SETZERO         _mm_setzero_si128
+#define LOADU(p)        _mm_loadu_si128((const __m128i *)(p))
+#define FN(name)        name ## _sse4
+#include "hevc_mc_template.c"
+#undef VEC
+#undef STEP
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef LOADU
+#undef FN
+#endif /* HAVE_INTRINSICS_SSE4 */
+
+#if HAVE_INTRINSICS_AVX2 && HAVE_INTRINSICS_SSE4
+static av_always_inline av_target_avx2 __m256i load_pixels_avx2(const uint8_t *src, int bit_depth)
+{
+    if (bit_depth == 8)
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src));
+    return _mm256_loadu_si256((const __m256i *)src);
+}
+
+static av_always_inline av_target_avx2 void store_words_avx2(uint8_t *dst, __m256i v, int n)
+{
+    _mm256_storeu_si256((__m256i *)dst, v);
+}
+
+static av_always_inline av_target_avx2 void store_pixels_avx2(uint8_t *dst, __m256i v,
+                                                              int n, int bit_depth)
+{
+    if (bit_depth == 8) {
+        v = _mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0x08);
+        _mm_storeu_si128((__m128i *)dst, _mm256_castsi256_si128(v));
+    } else {
+        v = _mm256_max_epi16(v, _mm256_setzero_si256());
+        v = _mm256_min_epi16(v, _mm256_set1_epi16((1 << bit_depth) - 1));
+        _mm256_storeu_si256((__m256i *)dst, v);
+    }
+}
+
+#define VEC             __m256i
+#define STEP            16
+#define TARGET          av_target_avx2
+#define V(op)           _mm256_ ## op
+#define SETZERO         _mm256_setzero_si256
+#define LOADU(p)        _mm256_loadu_si256((const __m256i *)(p))
+#define FN(name)        name ## _avx2
+#include "hevc_mc_template.c"
+#undef VEC
+#undef STEP
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef LOADU
+#undef FN
+#endif /* HAVE_INTRINSICS_AVX2 && HAVE_INTRINSICS_SSE4 */
+
+#define QPEL_FILTER(m) ((m) ? ff_hevc_qpel_filters[(m) - 1] : NULL)
+#define EPEL_FILTER(m) ((m) ? ff_hevc_epel_filters[(m) - 1] : NULL)
+
+#define MC_FUNCS(name, TYPE, TAPS, FILTER, depth, opt, attr)                                 \
+static attr void put_hevc_ ## name ## _ ## depth ## _ ## opt(int16_t *dst, uint8_t *src,      \
+                                                        ptrdiff_t srcstride, int height, \
+                                                        intptr_t mx, intptr_t my,        \
+                                                        int width)                       \
+{                                                                                        \
+    mc_ ## opt((uint8_t *)dst, MAX_PB_SIZE * sizeof(*dst), src, srcstride, NULL,        \
+               height, width, FILTER(mx), FILTER(my), TAPS, TYPE, MC_PUT, depth,        \
+               0, 0, 0, 0, 0);                                                          \
+}                                                                                        \
+                                                                                         \
+static attr void put_hevc_ ## name ## _uni_ ## depth ## _ ## opt(uint8_t *dst, ptrdiff_t dststride, \
+                                                            uint8_t *src, ptrdiff_t srcstride, \
+                                                            int height, intptr_t mx,     \
+                                                            intptr_t my, int width)      \
+{                                                                                        \
+    mc_ ## opt(dst, dststride, src, srcstride, NULL, height, width,                     \
+               FILTER(mx), FILTER(my), TAPS, TYPE, MC_UNI, depth, 0, 0, 0, 0, 0);       \
+}                                                                                        \
+                                                                                         \
+static attr void put_hevc_ ## name ## _bi_ ## depth ## _ ## opt(uint8_t *dst, ptrdiff_t dststride, \
+                                                           uint8_t *src, ptrdiff_t srcstride, \
+                                                           int16_t *src2, int height,    \
+                                                           intptr_t mx, intptr_t my,     \
+                                                           int width)                    \
+{                                                                                        \
+    mc_ ## opt(dst, dststride, src, srcstride, src2, height, width,                     \
+               FILTER(mx), FILTER(my), TAPS, TYPE, MC_BI, depth, 0, 0, 0, 0, 0);        \
+}                                                                                        \
+                                                                                         \
+static attr void put_hevc_ ## name ## _uni_w_ ## depth ## _ ## opt(uint8_t *dst, ptrdiff_t dststride, \
+                                                              uint8_t *src, ptrdiff_t srcstride, \
+                                                              int height, int denom,     \
+                                                              int wx, int ox,            \
+                                                              intptr_t mx, intptr_t my,  \
+                                                              int width)                 \
+{                                                                                        \
+    mc_ ## opt(dst, dststride, src, srcstride, NULL, height, width,                     \
+               FILTER(mx), FILTER(my), TAPS, TYPE, MC_UNI_W, depth,                     \
+               denom, 0, wx, 0, ox);                                                    \
+}                                                                                        \
+                                                                                         \
+static attr void put_hevc_ ## name ## _bi_w_ ## depth ## _ ## opt(uint8_t *dst, ptrdiff_t dststride, \
+                                                             uint8_t *src, ptrdiff_t srcstride, \
+                                                             int16_t *src2, int height,  \
+                                                             int denom, int wx0, int wx1, \
+                                                             int ox0, int ox1,           \
+                                                             intptr_t mx, intptr_t my,   \
+                                                             int width)                  \
+{                                                                                        \
+    mc_ ## opt(dst, dststride, src, srcstride, src2, height, width,                     \
+               FILTER(mx), FILTER(my), TAPS, TYPE, MC_BI_W, depth,                      \
+               denom, wx0, wx1, ox0, ox1);                                              \
+}
+
+#define MC_DEPTH_FUNCS(depth, opt, attr)                             \
+    MC_FUNCS(pel_pixels, MC_PIXELS, 8, QPEL_FILTER, depth, opt, attr) \
+    MC_FUNCS(qpel_h,     MC_H,      8, QPEL_FILTER, depth, opt, attr) \
+    MC_FUNCS(qpel_v,     MC_V,      8, QPEL_FILTER, depth, opt, attr) \
+    MC_FUNCS(qpel_hv,    MC_HV,     8, QPEL_FILTER, depth, opt, attr) \
+    MC_FUNCS(epel_h,     MC_H,      4, EPEL_FILTER, depth, opt, attr) \
+    MC_FUNCS(epel_v,     MC_V,      4, EPEL_FILTER, depth, opt, attr) \
+    MC_FUNCS(epel_hv,    MC_HV,     4, EPEL_FILTER, depth, opt, attr)
+
+#if HAVE_INTRINSICS_SSE4
+MC_DEPTH_FUNCS(8,  sse4, av_target_sse4)
+MC_DEPTH_FUNCS(10, sse4, av_target_sse4)
+#endif
+#if HAVE_INTRINSICS_AVX2 && HAVE_INTRINSICS_SSE4
+MC_DEPTH_FUNCS(8,  avx2, av_target_avx2)
+MC_DEPTH_FUNCS(10, avx2, av_target_avx2)
+#endif
+
+/* Table index i covers widths 2 (epel only), 4, 6, 8, 12, 16, 24, 32, 48 and 64,
+ * the AVX2 versions are used from 16 on. */
+#define PEL_FUNC(dst, v, h, fn, depth, opt, start)                           \
+    for (i = start; i < 10; i++)                                             \
+        c->dst[i][v][h] = fn ## _ ## depth ## _ ## opt
+
+#define PEL_FUNCS(dst, name, depth, opt, start)                              \
+    PEL_FUNC(dst,        0, 0, put_hevc_pel_pixels,          depth, opt, start); \
+    PEL_FUNC(dst,        0, 1, put_hevc_ ## name ## _h,      depth, opt, start); \
+    PEL_FUNC(dst,        1, 0, put_hevc_ ## name ## _v,      depth, opt, start); \
+    PEL_FUNC(dst,        1, 1, put_hevc_ ## name ## _hv,     depth, opt, start); \
+    PEL_FUNC(dst ## _uni, 0, 0, put_hevc_pel_pixels_uni,     depth, opt, start); \
+    PEL_FUNC(dst ## _uni, 0, 1, put_hevc_ ## name ## _h_uni, depth, opt, start); \
+    PEL_FUNC(dst ## _uni, 1, 0, put_hevc_ ## name ## _v_uni, depth, opt, start); \
+    PEL_FUNC(dst ## _uni, 1, 1, put_hevc_ ## name ## _hv_uni, depth, opt, start); \
+    PEL_FUNC(dst ## _bi,  0, 0, put_hevc_pel_pixels_bi,      depth, opt, start); \
+    PEL_FUNC(dst ## _bi,  0, 1, put_hevc_ ## name ## _h_bi,  depth, opt, start); \
+    PEL_FUNC(dst ## _bi,  1, 0, put_hevc_ ## name ## _v_bi,  depth, opt, start); \
+    PEL_FUNC(dst ## _bi,  1, 1, put_hevc_ ## name ## _hv_bi, depth, opt, start); \
+    PEL_FUNC(dst ## _uni_w, 0, 0, put_hevc_pel_pixels_uni_w,      depth, opt, start); \
+    PEL_FUNC(dst ## _uni_w, 0, 1, put_hevc_ ## name ## _h_uni_w,  depth, opt, start); \
+    PEL_FUNC(dst ## _uni_w, 1, 0, put_hevc_ ## name ## _v_uni_w,  depth, opt, start); \
+    PEL_FUNC(dst ## _uni_w, 1, 1, put_hevc_ ## name ## _hv_uni_w, depth, opt, start); \
+    PEL_FUNC(dst ## _bi_w,  0, 0, put_hevc_pel_pixels_bi_w,       depth, opt, start); \
+    PEL_FUNC(dst ## _bi_w,  0, 1, put_hevc_ ## name ## _h_bi_w,   depth, opt, start); \
+    PEL_FUNC(dst ## _bi_w,  1, 0, put_hevc_ ## name ## _v_bi_w,   depth, opt, start); \
+    PEL_FUNC(dst ## _bi_w,  1, 1, put_hevc_ ## name ## _hv_bi_w,  depth, opt, start)
+
+#define MC_INIT(depth, opt, start)                                           \
+    PEL_FUNCS(put_hevc_qpel, qpel, depth, opt, start);                       \
+    PEL_FUNCS(put_hevc_epel, epel, depth, opt, start)
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_hevc_dsp_init_x86(HEVCDSPContext *c, const int bit_depth)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+    int i;
+
+    if (bit_depth == 8) {
+        if (INTRINSICS_SSE2(cpu_flags)) {
+            c->add_residual[0] = add_residual4x4_8_sse2;
+            c->add_residual[1] = add_residual8x8_8_sse2;
+            c->add_residual[2] = add_residual16x16_8_sse2;
+            c->add_residual[3] = add_residual32x32_8_sse2;
+
+            c->idct[0]    = idct_4x4_8_sse2;
+            c->idct[1]    = idct_8x8_8_sse2;
+            c->idct[2]    = idct_16x16_8_sse2;
+            c->idct[3]    = idct_32x32_8_sse2;
+            c->idct_dc[0] = idct_4x4_dc_8_sse2;
+            c->idct_dc[1] = idct_8x8_dc_8_sse2;
+            c->idct_dc[2] = idct_16x16_dc_8_sse2;
+            c->idct_dc[3] = idct_32x32_dc_8_sse2;
+        }
+#if HAVE_INTRINSICS_SSE4
+        if (INTRINSICS_SSE4(cpu_flags)) {
+            MC_INIT(8, sse4, 0);
+        }
+#endif
+#if HAVE_INTRINSICS_AVX2
+        if (INTRINSICS_AVX2(cpu_flags)) {
+            c->add_residual[3] = add_residual32x32_8_avx2;
+#if HAVE_INTRINSICS_SSE4
+            MC_INIT(8, avx2, 5);
+#endif
+        }
+#endif
+    } else if (bit_depth == 10) {
+        if (INTRINSICS_SSE2(cpu_flags)) {
+            c->add_residual[0] = add_residual4x4_10_sse2;
+            c->add_residual[1] = add_residual8x8_10_sse2;
+            c->add_residual[2] = add_residual16x16_10_sse2;
+            c->add_residual[3] = add_residual32x32_10_sse2;
+
+            c->idct[0]    = idct_4x4_10_sse2;
+            c->idct[1]    = idct_8x8_10_sse2;
+            c->idct[2]    = idct_16x16_10_sse2;
+            c->idct[3]    = idct_32x32_10_sse2;
+            c->idct_dc[0] = idct_4x4_dc_10_sse2;
+            c->idct_dc[1] = idct_8x8_dc_10_sse2;
+            c->idct_dc[2] = idct_16x16_dc_10_sse2;
+            c->idct_dc[3] = idct_32x32_dc_10_sse2;
+        }
+#if HAVE_INTRINSICS_SSE4
+        if (INTRINSICS_SSE4(cpu_flags)) {
+            MC_INIT(10, sse4, 0);
+        }
+#endif
+#if HAVE_INTRINSICS_AVX2
+        if (INTRINSICS_AVX2(cpu_flags)) {
+            c->add_residual[2] = add_residual16x16_10_avx2;
+            c->add_residual[3] = add_residual32x32_10_avx2;
+#if HAVE_INTRINSICS_SSE4
+            MC_INIT(10, avx2, 5);
+#endif
+        }
+#endif
+    }
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
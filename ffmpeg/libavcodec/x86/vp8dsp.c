@@ -0,0 +1,541 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * VP8 motion compensation and loop filters, SSE2 and SSSE3 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/vp8dsp.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_SSSE3
+#include <tmmintrin.h>
+#endif
+
+/* n = 4, 8, 16 pixels */
+static av_always_inline __m128i load_pixels(const uint8_t *p, int n)
+{
+    switch (n) {
+    case 4:  return _mm_cvtsi32_si128(AV_RN32(p));
+    case 8:  return _mm_loadl_epi64((const __m128i *)p);
+    default: return _mm_loadu_si128((const __m128i *)p);
+    }
+}
+
+static av_always_inline void store_pixels(uint8_t *p, __m128i v, int n)
+{
+    switch (n) {
+    case 4:  AV_WN32(p, _mm_cvtsi128_si32(v));         break;
+    case 8:  _mm_storel_epi64((__m128i *)p, v);         break;
+    default: _mm_storeu_si128((__m128i *)p, v);         break;
+    }
+}
+
+/****************************************************************************
+ * Loop filter
+ ****************************************************************************/
+
+/* The filters work on 16 edge positions at once: the 16 rows or columns of
+ * a luma edge, or 8 of U followed by 8 of V. Pixels are biased by 0x80 so
+ * that the clip_int8() and crop table clamps of the C code become signed
+ * saturating byte arithmetic. */
+
+enum {
+    LF_SIMPLE,
+    LF_INNER,
+    LF_MBEDGE,
+};
+
+static av_always_inline __m128i absdiff_epu8(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+/* a <= lim for unsigned bytes */
+static av_always_inline __m128i cmple_epu8(__m128i a, __m128i lim)
+{
+    return _mm_cmpeq_epi8(_mm_subs_epu8(a, lim), _mm_setzero_si128());
+}
+
+static av_always_inline __m128i srai_epi8(__m128i a, int n)
+{
+    return _mm_packs_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(a, a), 8 + n),
+                           _mm_srai_epi16(_mm_unpackhi_epi8(a, a), 8 + n));
+}
+
+/* (w * c + 63) >> 7 for signed bytes w */
+static av_always_inline __m128i mbedge_tap(__m128i w, int c)
+{
+    const __m128i k   = _mm_set1_epi16(c);
+    const __m128i rnd = _mm_set1_epi16(63);
+    __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+    __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+
+    lo = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(lo, k), rnd), 7);
+    hi = _mm_srai_epi16(_mm_add_epi16(_mm_mullo_epi16(hi, k), rnd), 7);
+    return _mm_packs_epi16(lo, hi);
+}
+
+/**
+ * Filter 16 positions across an edge. p[0..7] hold p3..p0, q0..q3 as
+ * unsigned bytes. E, I and H are byte limits as used by the decoder.
+ */
+static av_always_inline void loop_filter_sse2(__m128i *p, int E, int I, int H, int type)
+{
+    const __m128i sign = _mm_set1_epi8(0x80);
+    __m128i mask, hev = _mm_setzero_si128(), d, f, f1, f2;
+    __m128i ps2, ps1, ps0, qs0, qs1, qs2;
+
+    /* 2 * |p0 - q0| + (|p1 - q1| >> 1) <= E */
+    d    = absdiff_epu8(p[3], p[4]);
+    f    = _mm_srli_epi16(_mm_and_si128(absdiff_epu8(p[2], p[5]), _mm_set1_epi8(0xFE)), 1);
+    mask = cmple_epu8(_mm_adds_epu8(_mm_adds_epu8(d, d), f), _mm_set1_epi8(E));
+
+    if (type != LF_SIMPLE) {
+        __m128i m = _mm_max_epu8(absdiff_epu8(p[0], p[1]), absdiff_epu8(p[1], p[2]));
+        __m128i h = _mm_max_epu8(absdiff_epu8(p[2], p[3]), absdiff_epu8(p[5], p[4]));
+
+        m    = _mm_max_epu8(m, _mm_max_epu8(absdiff_epu8(p[6], p[5]), absdiff_epu8(p[7], p[6])));
+        mask = _mm_and_si128(mask, cmple_epu8(_mm_max_epu8(m, h), _mm_set1_epi8(I)));
+        hev  = _mm_xor_si128(cmple_epu8(h, _mm_set1_epi8(H)), _mm_cmpeq_epi8(hev, hev));
+    }
+    if (!_mm_movemask_epi8(mask))
+        return;
+
+    ps2 = _mm_xor_si128(p[1], sign);
+    ps1 = _mm_xor_si128(p[2], sign);
+    ps0 = _mm_xor_si128(p[3], sign);
+    qs0 = _mm_xor_si128(p[4], sign);
+    qs1 = _mm_xor_si128(p[5], sign);
+    qs2 = _mm_xor_si128(p[6], sign);
+
+    /* clip_int8(clip_int8(p1 - q1) + 3 * (q0 - p0)), the saturating adds
+     * of a clamped q0 - p0 clip the same way as the C code */
+    f = _mm_subs_epi8(ps1, qs1);
+    if (type == LF_INNER)
+        f = _mm_and_si128(f, hev);
+    d = _mm_subs_epi8(qs0, ps0);
+    f = _mm_adds_epi8(f, d);
+    f = _mm_adds_epi8(f, d);
+    f = _mm_adds_epi8(f, d);
+    f = _mm_and_si128(f, mask);
+
+    if (type == LF_MBEDGE) {
+        __m128i w = _mm_andnot_si128(hev, f), a;
+
+        f  = _mm_and_si128(f, hev);
+        f1 = srai_epi8(_mm_adds_epi8(f, _mm_set1_epi8(4)), 3);
+        f2 = srai_epi8(_mm_adds_epi8(f, _mm_set1_epi8(3)), 3);
+        ps0 = _mm_adds_epi8(ps0, f2);
+        qs0 = _mm_subs_epi8(qs0, f1);
+
+        a   = mbedge_tap(w, 27);
+        ps0 = _mm_adds_epi8(ps0, a);
+        qs0 = _mm_subs_epi8(qs0, a);
+        a   = mbedge_tap(w, 18);
+        ps1 = _mm_adds_epi8(ps1, a);
+        qs1 = _mm_subs_epi8(qs1, a);
+        a   = mbedge_tap(w, 9);
+        ps2 = _mm_adds_epi8(ps2, a);
+        qs2 = _mm_subs_epi8(qs2, a);
+    } else {
+        f1 = srai_epi8(_mm_adds_epi8(f, _mm_set1_epi8(4)), 3);
+        f2 = srai_epi8(_mm_adds_epi8(f, _mm_set1_epi8(3)), 3);
+        ps0 = _mm_adds_epi8(ps0, f2);
+        qs0 = _mm_subs_epi8(qs0, f1);
+
+        if (type == LF_INNER) {
+            __m128i a = srai_epi8(_mm_add_epi8(f1, _mm_set1_epi8(1)), 1);
+
+            a   = _mm_and_si128(a, _mm_andnot_si128(hev, mask));
+            ps1 = _mm_adds_epi8(ps1, a);
+            qs1 = _mm_subs_epi8(qs1, a);
+        }
+    }
+
+    p[1] = _mm_xor_si128(ps2, sign);
+    p[2] = _mm_xor_si128(ps1, sign);
+    p[3] = _mm_xor_si128(ps0, sign);
+    p[4] = _mm_xor_si128(qs0, sign);
+    p[5] = _mm_xor_si128(qs1, sign);
+    p[6] = _mm_xor_si128(qs2, sign);
+}
+
+/* 16 rows of 8 pixels, rows 0-7 at a and 8-15 at b, to 8 columns */
+static av_always_inline void load_columns(__m128i *p, const uint8_t *a,
+                                          const uint8_t *b, ptrdiff_t stride)
+{
+    __m128i r[16], t[8], u[8], v[8];
+    int k;
+
+    for (k = 0; k < 8; k++) {
+        r[k]     = load_pixels(a + k * stride, 8);
+        r[k + 8] = load_pixels(b + k * stride, 8);
+    }
+    for (k = 0; k < 8; k++)
+        t[k] = _mm_unpacklo_epi8(r[2 * k], r[2 * k + 1]);
+    for (k = 0; k < 8; k += 2) {
+        u[k]     = _mm_unpacklo_epi16(t[k], t[k + 1]);
+        u[k + 1] = _mm_unpackhi_epi16(t[k], t[k + 1]);
+    }
+    for (k = 0; k < 8; k += 4) {
+        v[k]     = _mm_unpacklo_epi32(u[k],     u[k + 2]);
+        v[k + 1] = _mm_unpackhi_epi32(u[k],     u[k + 2]);
+        v[k + 2] = _mm_unpacklo_epi32(u[k + 1], u[k + 3]);
+        v[k + 3] = _mm_unpackhi_epi32(u[k + 1], u[k + 3]);
+    }
+    for (k = 0; k < 4; k++) {
+        p[2 * k]     = _mm_unpacklo_epi64(v[k], v[k + 4]);
+        p[2 * k + 1] = _mm_unpackhi_epi64(v[k], v[k + 4]);
+    }
+}
+
+static av_always_inline void store_columns(uint8_t *a, uint8_t *b,
+                                           ptrdiff_t stride, const __m128i *p)
+{
+    __m128i t[8], u[8], v[8];
+    int k;
+
+    for (k = 0; k < 4; k++) {
+        t[k]     = _mm_unpacklo_epi8(p[2 * k], p[2 * k + 1]);
+        t[k + 4] = _mm_unpackhi_epi8(p[2 * k], p[2 * k + 1]);
+    }
+    for (k = 0; k < 8; k += 4) {
+        u[k]     = _mm_unpacklo_epi16(t[k],     t[k + 1]);
+        u[k + 1] = _mm_unpackhi_epi16(t[k],     t[k + 1]);
+        u[k + 2] = _mm_unpacklo_epi16(t[k + 2], t[k + 3]);
+        u[k + 3] = _mm_unpackhi_epi16(t[k + 2], t[k + 3]);
+    }
+    for (k = 0; k < 8; k += 4) {
+        v[k]     = _mm_unpacklo_epi32(u[k],     u[k + 2]);
+        v[k + 1] = _mm_unpackhi_epi32(u[k],     u[k + 2]);
+        v[k + 2] = _mm_unpacklo_epi32(u[k + 1], u[k + 3]);
+        v[k + 3] = _mm_unpackhi_epi32(u[k + 1], u[k + 3]);
+    }
+    for (k = 0; k < 4; k++) {
+        store_pixels(a + (2 * k)     * stride, v[k], 8);
+        store_pixels(a + (2 * k + 1) * stride, _mm_unpackhi_epi64(v[k], v[k]), 8);
+        store_pixels(b + (2 * k)     * stride, v[k + 4], 8);
+        store_pixels(b + (2 * k + 1) * stride, _mm_unpackhi_epi64(v[k + 4], v[k + 4]), 8);
+    }
+}
+
+/* Positions 0-7 of the edge at a, 8-15 at b. dir 0 filters a vertical edge
+ * (columns), 1 a horizontal one (rows). */
+static av_always_inline void loop_filter_16px(uint8_t *a, uint8_t *b, ptrdiff_t stride,
+                                              int E, int I, int H, int type, int dir)
+{
+    const int first = type == LF_MBEDGE ? 1 : type == LF_INNER ? 2 : 3;
+    __m128i p[8];
+    int k;
+
+    if (dir) {
+        for (k = 0; k < 8; k++)
+            p[k] = _mm_unpacklo_epi64(load_pixels(a + (k - 4) * stride, 8),
+                                      load_pixels(b + (k - 4) * stride, 8));
+        loop_filter_sse2(p, E, I, H, type);
+        for (k = first; k < 8 - first; k++) {
+            store_pixels(a + (k - 4) * stride, p[k], 8);
+            store_pixels(b + (k - 4) * stride, _mm_unpackhi_epi64(p[k], p[k]), 8);
+        }
+    } else {
+        load_columns(p, a - 4, b - 4, stride);
+        loop_filter_sse2(p, E, I, H, type);
+        store_columns(a - 4, b - 4, stride, p);
+    }
+}
+
+#define LF_FNS(name, type)                                                         \
+static void vp8_v_loop_filter16 ## name ## _sse2(uint8_t *dst, ptrdiff_t stride,  \
+                                                 int E, int I, int H)             \
+{                                                                                  \
+    loop_filter_16px(dst, dst + 8, stride, E, I, H, type, 1);                      \
+}                                                                                  \
+                                                                                   \
+static void vp8_h_loop_filter16 ## name ## _sse2(uint8_t *dst, ptrdiff_t stride,  \
+                                                 int E, int I, int H)             \
+{                                                                                  \
+    loop_filter_16px(dst, dst + 8 * stride, stride, E, I, H, type, 0);             \
+}                                                                                  \
+                                                                                   \
+static void vp8_v_loop_filter8uv ## name ## _sse2(uint8_t *dstU, uint8_t *dstV,   \
+                                                  ptrdiff_t stride,               \
+                                                  int E, int I, int H)            \
+{                                                                                  \
+    loop_filter_16px(dstU, dstV, stride, E, I, H, type, 1);                        \
+}                                                                                  \
+                                                                                   \
+static void vp8_h_loop_filter8uv ## name ## _sse2(uint8_t *dstU, uint8_t *dstV,   \
+                                                  ptrdiff_t stride,               \
+                                                  int E, int I, int H)            \
+{                                                                                  \
+    loop_filter_16px(dstU, dstV, stride, E, I, H, type, 0);                        \
+}
+
+LF_FNS(,       LF_MBEDGE)
+LF_FNS(_inner, LF_INNER)
+
+static void vp8_v_loop_filter_simple_sse2(uint8_t *dst, ptrdiff_t stride, int flim)
+{
+    loop_filter_16px(dst, dst + 8, stride, flim, 0, 0, LF_SIMPLE, 1);
+}
+
+static void vp8_h_loop_filter_simple_sse2(uint8_t *dst, ptrdiff_t stride, int flim)
+{
+    loop_filter_16px(dst, dst + 8 * stride, stride, flim, 0, 0, LF_SIMPLE, 0);
+}
+
+/****************************************************************************
+ * Motion compensation
+ ****************************************************************************/
+
+#if HAVE_INTRINSICS_SSSE3
+static const uint8_t subpel_filters[7][6] = {
+    { 0,  6, 123,  12,  1, 0 },
+    { 2, 11, 108,  36,  8, 1 },
+    { 0,  9,  93,  50,  6, 0 },
+    { 3, 16,  77,  77, 16, 3 },
+    { 0,  6,  50,  93,  9, 0 },
+    { 1,  8,  36, 108, 11, 2 },
+    { 0,  1,  12, 123,  6, 0 },
+};
+
+/* Tap pairs for pmaddubsw: (-1, 0), (1, 2) and (-2, 3). Each pair keeps
+ * its positive tap below 128 and the first two sums cannot overflow for
+ * any VP8 filter, so only the last addition needs to saturate. Anything
+ * it clips is above 255 after rounding anyway. */
+static av_always_inline av_target_ssse3 void init_epel(__m128i *f, int mxy)
+{
+    const uint8_t *F = subpel_filters[mxy - 1];
+
+    f[0] = _mm_set1_epi16((int16_t)((-F[1] & 0xFF) | (F[2] << 8)));
+    f[1] = _mm_set1_epi16((int16_t)(F[3] | ((-F[4] & 0xFF) << 8)));
+    f[2] = _mm_set1_epi16((int16_t)(F[0] | (F[5] << 8)));
+}
+
+/* pmulhrsw with 256 rounds like (x + 64) >> 7 */
+static av_always_inline av_target_ssse3 __m128i sum_epel(const __m128i *r, const __m128i *f,
+                                                         int taps, int hi)
+{
+#define PAIR(a, b) (hi ? _mm_unpackhi_epi8(a, b) : _mm_unpacklo_epi8(a, b))
+    __m128i s = _mm_maddubs_epi16(PAIR(r[1], r[2]), f[0]);
+
+    if (taps == 6)
+        s = _mm_add_epi16(s, _mm_maddubs_epi16(PAIR(r[0], r[5]), f[2]));
+    s = _mm_adds_epi16(s, _mm_maddubs_epi16(PAIR(r[3], r[4]), f[1]));
+#undef PAIR
+
+    return _mm_mulhrs_epi16(s, _mm_set1_epi16(256));
+}
+
+/* (8 - m) * a + m * b rounded by pmulhrsw with 4096, i.e. (x + 4) >> 3 */
+static av_always_inline av_target_ssse3 __m128i sum_bilin(__m128i a, __m128i b,
+                                                          __m128i f, int hi)
+{
+    __m128i s = _mm_maddubs_epi16(hi ? _mm_unpackhi_epi8(a, b) : _mm_unpacklo_epi8(a, b), f);
+
+    return _mm_mulhrs_epi16(s, _mm_set1_epi16(4096));
+}
+
+/* taps = 0 selects the bilinear filter */
+static av_always_inline av_target_ssse3 void mc_1d(uint8_t *dst, ptrdiff_t dst_stride,
+                                                   const uint8_t *src, ptrdiff_t src_stride,
+                                                   int w, int h, ptrdiff_t step,
+                                                   int mxy, int taps)
+{
+    __m128i f[3], lo, hi;
+    int k;
+
+    if (taps)
+        init_epel(f, mxy);
+    else
+        f[0] = _mm_set1_epi16((8 - mxy) | (mxy << 8));
+
+    do {
+        if (taps) {
+            __m128i r[6];
+
+            for (k = 0; k < 6; k++)
+                if (taps == 6 || (k != 0 && k != 5))
+                    r[k] = load_pixels(src + (k - 2) * step, w);
+            lo = sum_epel(r, f, taps, 0);
+            hi = w > 8 ? sum_epel(r, f, taps, 1) : lo;
+        } else {
+            __m128i a = load_pixels(src, w), b = load_pixels(src + step, w);
+
+            lo = sum_bilin(a, b, f[0], 0);
+            hi = w > 8 ? sum_bilin(a, b, f[0], 1) : lo;
+        }
+        store_pixels(dst, _mm_packus_epi16(lo, hi), w);
+        dst += dst_stride;
+        src += src_stride;
+    } while (--h);
+}
+
+/* Like the C code, the horizontal pass is clipped to 8 bits in tmp */
+static av_always_inline av_target_ssse3 void mc_2d(uint8_t *dst, ptrdiff_t dst_stride,
+                                                   const uint8_t *src, ptrdiff_t src_stride,
+                                                   int w, int h, int mx, int my,
+                                                   int htaps, int vtaps)
+{
+    DECLARE_ALIGNED(16, uint8_t, tmp)[16 * (32 + 5)];
+    const int before = vtaps == 6 ? 2 : vtaps == 4 ? 1 : 0;
+    const int after  = vtaps == 6 ? 3 : vtaps == 4 ? 2 : 1;
+
+    mc_1d(tmp, 16, src - before * src_stride, src_stride, w, h + before + after,
+          1, mx, htaps);
+    mc_1d(dst, dst_stride, tmp + before * 16, 16, w, h, 16, my, vtaps);
+}
+
+#define EPEL_FNS(sz, htaps, vtaps)                                                      \
+static av_target_ssse3                                                                  \
+void put_vp8_epel ## sz ## _h ## htaps ## v ## vtaps ## _ssse3(uint8_t *dst,            \
+                                                               ptrdiff_t dst_stride,    \
+                                                               uint8_t *src,            \
+                                                               ptrdiff_t src_stride,    \
+                                                               int h, int mx, int my)   \
+{                                                                                       \
+    mc_2d(dst, dst_stride, src, src_stride, sz, h, mx, my, htaps, vtaps);               \
+}
+
+#define EPEL_1D_FNS(sz, taps)                                                           \
+static av_target_ssse3                                                                  \
+void put_vp8_epel ## sz ## _h ## taps ## _ssse3(uint8_t *dst, ptrdiff_t dst_stride,     \
+                                                uint8_t *src, ptrdiff_t src_stride,     \
+                                                int h, int mx, int my)                  \
+{                                                                                       \
+    mc_1d(dst, dst_stride, src, src_stride, sz, h, 1, mx, taps);                        \
+}                                                                                       \
+                                                                                        \
+static av_target_ssse3                                                                  \
+void put_vp8_epel ## sz ## _v ## taps ## _ssse3(uint8_t *dst, ptrdiff_t dst_stride,     \
+                                                uint8_t *src, ptrdiff_t src_stride,     \
+                                                int h, int mx, int my)                  \
+{                                                                                       \
+    mc_1d(dst, dst_stride, src, src_stride, sz, h, src_stride, my, taps);               \
+}
+
+#define BILIN_FNS(sz)                                                                   \
+static av_target_ssse3                                                                  \
+void put_vp8_bilinear ## sz ## _h_ssse3(uint8_t *dst, ptrdiff_t dst_stride,             \
+                                        uint8_t *src, ptrdiff_t src_stride,             \
+                                        int h, int mx, int my)                          \
+{                                                                                       \
+    mc_1d(dst, dst_stride, src, src_stride, sz, h, 1, mx, 0);                           \
+}                                                                                       \
+                                                                                        \
+static av_target_ssse3                                                                  \
+void put_vp8_bilinear ## sz ## _v_ssse3(uint8_t *dst, ptrdiff_t dst_stride,             \
+                                        uint8_t *src, ptrdiff_t src_stride,             \
+                                        int h, int mx, int my)                          \
+{                                                                                       \
+    mc_1d(dst, dst_stride, src, src_stride, sz, h, src_stride, my, 0);                  \
+}                                                                                       \
+                                                                                        \
+static av_target_ssse3                                                                  \
+void put_vp8_bilinear ## sz ## _hv_ssse3(uint8_t *dst, ptrdiff_t dst_stride,            \
+                                         uint8_t *src, ptrdiff_t src_stride,            \
+                                         int h, int mx, int my)                         \
+{                                                                                       \
+    mc_2d(dst, dst_stride, src, src_stride, sz, h, mx, my, 0, 0);                       \
+}
+
+#define MC_FNS(sz)          \
+    EPEL_1D_FNS(sz, 4)      \
+    EPEL_1D_FNS(sz, 6)      \
+    EPEL_FNS(sz, 4, 4)      \
+    EPEL_FNS(sz, 4, 6)      \
+    EPEL_FNS(sz, 6, 4)      \
+    EPEL_FNS(sz, 6, 6)      \
+    BILIN_FNS(sz)
+
+MC_FNS(16)
+MC_FNS(8)
+MC_FNS(4)
+#endif /* HAVE_INTRINSICS_SSSE3 */
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+#define INIT_MC(idx, sz)                                                                      \
+    c->put_vp8_epel_pixels_tab[idx][0][1]     = put_vp8_epel     ## sz ## _h4_ssse3;          \
+    c->put_vp8_epel_pixels_tab[idx][0][2]     = put_vp8_epel     ## sz ## _h6_ssse3;          \
+    c->put_vp8_epel_pixels_tab[idx][1][0]     = put_vp8_epel     ## sz ## _v4_ssse3;          \
+    c->put_vp8_epel_pixels_tab[idx][1][1]     = put_vp8_epel     ## sz ## _h4v4_ssse3;        \
+    c->put_vp8_epel_pixels_tab[idx][1][2]     = put_vp8_epel     ## sz ## _h6v4_ssse3;        \
+    c->put_vp8_epel_pixels_tab[idx][2][0]     = put_vp8_epel     ## sz ## _v6_ssse3;          \
+    c->put_vp8_epel_pixels_tab[idx][2][1]     = put_vp8_epel     ## sz ## _h4v6_ssse3;        \
+    c->put_vp8_epel_pixels_tab[idx][2][2]     = put_vp8_epel     ## sz ## _h6v6_ssse3;        \
+    c->put_vp8_bilinear_pixels_tab[idx][0][1] =                                               \
+    c->put_vp8_bilinear_pixels_tab[idx][0][2] = put_vp8_bilinear ## sz ## _h_ssse3;           \
+    c->put_vp8_bilinear_pixels_tab[idx][1][0] =                                               \
+    c->put_vp8_bilinear_pixels_tab[idx][2][0] = put_vp8_bilinear ## sz ## _v_ssse3;           \
+    c->put_vp8_bilinear_pixels_tab[idx][1][1] =                                               \
+    c->put_vp8_bilinear_pixels_tab[idx][1][2] =                                               \
+    c->put_vp8_bilinear_pixels_tab[idx][2][1] =                                               \
+    c->put_vp8_bilinear_pixels_tab[idx][2][2] = put_vp8_bilinear ## sz ## _hv_ssse3
+
+/* The full-pel copies are plain memcpy() in C and stay there. */
+av_cold void ff_vp78dsp_init_x86(VP8DSPContext *c)
+{
+#if HAVE_INTRINSICS_SSSE3
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INTRINSICS_SSSE3(cpu_flags)) {
+        INIT_MC(0, 16);
+        INIT_MC(1, 8);
+        INIT_MC(2, 4);
+    }
+#endif
+}
+
+/* The transforms stay in C. */
+av_cold void ff_vp8dsp_init_x86(VP8DSPContext *c)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INTRINSICS_SSE2(cpu_flags)) {
+        c->vp8_v_loop_filter16y       = vp8_v_loop_filter16_sse2;
+        c->vp8_h_loop_filter16y       = vp8_h_loop_filter16_sse2;
+        c->vp8_v_loop_filter8uv       = vp8_v_loop_filter8uv_sse2;
+        c->vp8_h_loop_filter8uv       = vp8_h_loop_filter8uv_sse2;
+
+        c->vp8_v_loop_filter16y_inner = vp8_v_loop_filter16_inner_sse2;
+        c->vp8_h_loop_filter16y_inner = vp8_h_loop_filter16_inner_sse2;
+        c->vp8_v_loop_filter8uv_inner = vp8_v_loop_filter8uv_inner_sse2;
+        c->vp8_h_loop_filter8uv_inner = vp8_h_loop_filter8uv_inner_sse2;
+
+        c->vp8_v_loop_filter_simple   = vp8_v_loop_filter_simple_sse2;
+        c->vp8_h_loop_filter_simple   = vp8_h_loop_filter_simple_sse2;
+    }
+#endif
+}
@@ -0,0 +1,664 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * VP9 inverse transforms, included by vp9dsp.c once per vector width.
+ * Each 1D transform runs on LANES columns at a time with the C arithmetic
+ * carried over to 32-bit lanes, intermediate results are truncated to int16
+ * where the C code stores them in dctcoef, so the output is bitexact.
+ *
+ * The includer defines VEC, LANES, TARGET, V(), SETZERO, LOAD(), STORE(), OR(),
+ * TESTZ() and FN() and provides FN(load_coefs), FN(transpose) and FN(add_pixels).
+ */
+
+#define IN(x)     in[x]
+#define ADD(a, b) V(add_epi32)(a, b)
+#define SUB(a, b) V(sub_epi32)(a, b)
+#define NEG(a)    V(sub_epi32)(SETZERO(), a)
+#define MUL(a, c) V(mullo_epi32)(a, V(set1_epi32)(c))
+#define RND(a)    V(srai_epi32)(V(add_epi32)(a, rnd), 14)
+
+static av_always_inline TARGET void FN(idct4_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3;
+
+    t0 = RND(MUL(ADD(IN(0), IN(2)), 11585));
+    t1 = RND(MUL(SUB(IN(0), IN(2)), 11585));
+    t2 = RND(SUB(MUL(IN(1), 6270), MUL(IN(3), 15137)));
+    t3 = RND(ADD(MUL(IN(1), 15137), MUL(IN(3), 6270)));
+
+    out[0] = ADD(t0, t3);
+    out[1] = ADD(t1, t2);
+    out[2] = SUB(t1, t2);
+    out[3] = SUB(t0, t3);
+}
+
+static av_always_inline TARGET void FN(iadst4_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3;
+
+    t0 = ADD(ADD(MUL(IN(0), 5283), MUL(IN(2), 15212)), MUL(IN(3), 9929));
+    t1 = SUB(SUB(MUL(IN(0), 9929), MUL(IN(2), 5283)), MUL(IN(3), 15212));
+    t2 = MUL(ADD(SUB(IN(0), IN(2)), IN(3)), 13377);
+    t3 = MUL(IN(1), 13377);
+
+    out[0] = RND(ADD(t0, t3));
+    out[1] = RND(ADD(t1, t3));
+    out[2] = RND(t2);
+    out[3] = RND(SUB(ADD(t0, t1), t3));
+}
+
+static av_always_inline TARGET void FN(idct8_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3, t4, t5, t6, t7;
+    VEC t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a;
+
+    t0a = RND(MUL(ADD(IN(0), IN(4)), 11585));
+    t1a = RND(MUL(SUB(IN(0), IN(4)), 11585));
+    t2a = RND(SUB(MUL(IN(2), 6270), MUL(IN(6), 15137)));
+    t3a = RND(ADD(MUL(IN(2), 15137), MUL(IN(6), 6270)));
+    t4a = RND(SUB(MUL(IN(1), 3196), MUL(IN(7), 16069)));
+    t5a = RND(SUB(MUL(IN(5), 13623), MUL(IN(3), 9102)));
+    t6a = RND(ADD(MUL(IN(5), 9102), MUL(IN(3), 13623)));
+    t7a = RND(ADD(MUL(IN(1), 16069), MUL(IN(7), 3196)));
+
+    t0  = ADD(t0a, t3a);
+    t1  = ADD(t1a, t2a);
+    t2  = SUB(t1a, t2a);
+    t3  = SUB(t0a, t3a);
+    t4  = ADD(t4a, t5a);
+    t5a = SUB(t4a, t5a);
+    t7  = ADD(t7a, t6a);
+    t6a = SUB(t7a, t6a);
+
+    t5 = RND(MUL(SUB(t6a, t5a), 11585));
+    t6 = RND(MUL(ADD(t6a, t5a), 11585));
+
+    out[0] = ADD(t0, t7);
+    out[1] = ADD(t1, t6);
+    out[2] = ADD(t2, t5);
+    out[3] = ADD(t3, t4);
+    out[4] = SUB(t3, t4);
+    out[5] = SUB(t2, t5);
+    out[6] = SUB(t1, t6);
+    out[7] = SUB(t0, t7);
+}
+
+static av_always_inline TARGET void FN(iadst8_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3, t4, t5, t6, t7;
+    VEC t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a;
+
+    t0a = ADD(MUL(IN(7), 16305), MUL(IN(0), 1606));
+    t1a = SUB(MUL(IN(7), 1606), MUL(IN(0), 16305));
+    t2a = ADD(MUL(IN(5), 14449), MUL(IN(2), 7723));
+    t3a = SUB(MUL(IN(5), 7723), MUL(IN(2), 14449));
+    t4a = ADD(MUL(IN(3), 10394), MUL(IN(4), 12665));
+    t5a = SUB(MUL(IN(3), 12665), MUL(IN(4), 10394));
+    t6a = ADD(MUL(IN(1), 4756), MUL(IN(6), 15679));
+    t7a = SUB(MUL(IN(1), 15679), MUL(IN(6), 4756));
+
+    t0 = RND(ADD(t0a, t4a));
+    t1 = RND(ADD(t1a, t5a));
+    t2 = RND(ADD(t2a, t6a));
+    t3 = RND(ADD(t3a, t7a));
+    t4 = RND(SUB(t0a, t4a));
+    t5 = RND(SUB(t1a, t5a));
+    t6 = RND(SUB(t2a, t6a));
+    t7 = RND(SUB(t3a, t7a));
+
+    t4a = ADD(MUL(t4, 15137), MUL(t5, 6270));
+    t5a = SUB(MUL(t4, 6270), MUL(t5, 15137));
+    t6a = SUB(MUL(t7, 15137), MUL(t6, 6270));
+    t7a = ADD(MUL(t7, 6270), MUL(t6, 15137));
+
+    out[0] = ADD(t0, t2);
+    out[7] = NEG(ADD(t1, t3));
+    t2     = SUB(t0, t2);
+    t3     = SUB(t1, t3);
+
+    out[1] = NEG(RND(ADD(t4a, t6a)));
+    out[6] = RND(ADD(t5a, t7a));
+    t6     = RND(SUB(t4a, t6a));
+    t7     = RND(SUB(t5a, t7a));
+
+    out[3] = NEG(RND(MUL(ADD(t2, t3), 11585)));
+    out[4] = RND(MUL(SUB(t2, t3), 11585));
+    out[2] = RND(MUL(ADD(t6, t7), 11585));
+    out[5] = NEG(RND(MUL(SUB(t6, t7), 11585)));
+}
+
+static av_always_inline TARGET void FN(idct16_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    VEC t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a, t8a, t9a, t10a, t11a, t12a;
+    VEC t13a, t14a, t15a;
+
+    t0a  = RND(MUL(ADD(IN(0), IN(8)), 11585));
+    t1a  = RND(MUL(SUB(IN(0), IN(8)), 11585));
+    t2a  = RND(SUB(MUL(IN(4), 6270), MUL(IN(12), 15137)));
+    t3a  = RND(ADD(MUL(IN(4), 15137), MUL(IN(12), 6270)));
+    t4a  = RND(SUB(MUL(IN(2), 3196), MUL(IN(14), 16069)));
+    t7a  = RND(ADD(MUL(IN(2), 16069), MUL(IN(14), 3196)));
+    t5a  = RND(SUB(MUL(IN(10), 13623), MUL(IN(6), 9102)));
+    t6a  = RND(ADD(MUL(IN(10), 9102), MUL(IN(6), 13623)));
+    t8a  = RND(SUB(MUL(IN(1), 1606), MUL(IN(15), 16305)));
+    t15a = RND(ADD(MUL(IN(1), 16305), MUL(IN(15), 1606)));
+    t9a  = RND(SUB(MUL(IN(9), 12665), MUL(IN(7), 10394)));
+    t14a = RND(ADD(MUL(IN(9), 10394), MUL(IN(7), 12665)));
+    t10a = RND(SUB(MUL(IN(5), 7723), MUL(IN(11), 14449)));
+    t13a = RND(ADD(MUL(IN(5), 14449), MUL(IN(11), 7723)));
+    t11a = RND(SUB(MUL(IN(13), 15679), MUL(IN(3), 4756)));
+    t12a = RND(ADD(MUL(IN(13), 4756), MUL(IN(3), 15679)));
+
+    t0  = ADD(t0a, t3a);
+    t1  = ADD(t1a, t2a);
+    t2  = SUB(t1a, t2a);
+    t3  = SUB(t0a, t3a);
+    t4  = ADD(t4a, t5a);
+    t5  = SUB(t4a, t5a);
+    t6  = SUB(t7a, t6a);
+    t7  = ADD(t7a, t6a);
+    t8  = ADD(t8a, t9a);
+    t9  = SUB(t8a, t9a);
+    t10 = SUB(t11a, t10a);
+    t11 = ADD(t11a, t10a);
+    t12 = ADD(t12a, t13a);
+    t13 = SUB(t12a, t13a);
+    t14 = SUB(t15a, t14a);
+    t15 = ADD(t15a, t14a);
+
+    t5a  = RND(MUL(SUB(t6, t5), 11585));
+    t6a  = RND(MUL(ADD(t6, t5), 11585));
+    t9a  = RND(SUB(MUL(t14, 6270), MUL(t9, 15137)));
+    t14a = RND(ADD(MUL(t14, 15137), MUL(t9, 6270)));
+    t10a = RND(NEG(ADD(MUL(t13, 15137), MUL(t10, 6270))));
+    t13a = RND(SUB(MUL(t13, 6270), MUL(t10, 15137)));
+
+    t0a  = ADD(t0, t7);
+    t1a  = ADD(t1, t6a);
+    t2a  = ADD(t2, t5a);
+    t3a  = ADD(t3, t4);
+    t4   = SUB(t3, t4);
+    t5   = SUB(t2, t5a);
+    t6   = SUB(t1, t6a);
+    t7   = SUB(t0, t7);
+    t8a  = ADD(t8, t11);
+    t9   = ADD(t9a, t10a);
+    t10  = SUB(t9a, t10a);
+    t11a = SUB(t8, t11);
+    t12a = SUB(t15, t12);
+    t13  = SUB(t14a, t13a);
+    t14  = ADD(t14a, t13a);
+    t15a = ADD(t15, t12);
+
+    t10a = RND(MUL(SUB(t13, t10), 11585));
+    t13a = RND(MUL(ADD(t13, t10), 11585));
+    t11  = RND(MUL(SUB(t12a, t11a), 11585));
+    t12  = RND(MUL(ADD(t12a, t11a), 11585));
+
+    out[0]  = ADD(t0a, t15a);
+    out[1]  = ADD(t1a, t14);
+    out[2]  = ADD(t2a, t13a);
+    out[3]  = ADD(t3a, t12);
+    out[4]  = ADD(t4, t11);
+    out[5]  = ADD(t5, t10a);
+    out[6]  = ADD(t6, t9);
+    out[7]  = ADD(t7, t8a);
+    out[8]  = SUB(t7, t8a);
+    out[9]  = SUB(t6, t9);
+    out[10] = SUB(t5, t10a);
+    out[11] = SUB(t4, t11);
+    out[12] = SUB(t3a, t12);
+    out[13] = SUB(t2a, t13a);
+    out[14] = SUB(t1a, t14);
+    out[15] = SUB(t0a, t15a);
+}
+
+static av_always_inline TARGET void FN(iadst16_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    VEC t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a, t8a, t9a, t10a, t11a, t12a;
+    VEC t13a, t14a, t15a;
+
+    t0  = ADD(MUL(IN(15), 16364), MUL(IN(0), 804));
+    t1  = SUB(MUL(IN(15), 804), MUL(IN(0), 16364));
+    t2  = ADD(MUL(IN(13), 15893), MUL(IN(2), 3981));
+    t3  = SUB(MUL(IN(13), 3981), MUL(IN(2), 15893));
+    t4  = ADD(MUL(IN(11), 14811), MUL(IN(4), 7005));
+    t5  = SUB(MUL(IN(11), 7005), MUL(IN(4), 14811));
+    t6  = ADD(MUL(IN(9), 13160), MUL(IN(6), 9760));
+    t7  = SUB(MUL(IN(9), 9760), MUL(IN(6), 13160));
+    t8  = ADD(MUL(IN(7), 11003), MUL(IN(8), 12140));
+    t9  = SUB(MUL(IN(7), 12140), MUL(IN(8), 11003));
+    t10 = ADD(MUL(IN(5), 8423), MUL(IN(10), 14053));
+    t11 = SUB(MUL(IN(5), 14053), MUL(IN(10), 8423));
+    t12 = ADD(MUL(IN(3), 5520), MUL(IN(12), 15426));
+    t13 = SUB(MUL(IN(3), 15426), MUL(IN(12), 5520));
+    t14 = ADD(MUL(IN(1), 2404), MUL(IN(14), 16207));
+    t15 = SUB(MUL(IN(1), 16207), MUL(IN(14), 2404));
+
+    t0a  = RND(ADD(t0, t8));
+    t1a  = RND(ADD(t1, t9));
+    t2a  = RND(ADD(t2, t10));
+    t3a  = RND(ADD(t3, t11));
+    t4a  = RND(ADD(t4, t12));
+    t5a  = RND(ADD(t5, t13));
+    t6a  = RND(ADD(t6, t14));
+    t7a  = RND(ADD(t7, t15));
+    t8a  = RND(SUB(t0, t8));
+    t9a  = RND(SUB(t1, t9));
+    t10a = RND(SUB(t2, t10));
+    t11a = RND(SUB(t3, t11));
+    t12a = RND(SUB(t4, t12));
+    t13a = RND(SUB(t5, t13));
+    t14a = RND(SUB(t6, t14));
+    t15a = RND(SUB(t7, t15));
+
+    t8  = ADD(MUL(t8a, 16069), MUL(t9a, 3196));
+    t9  = SUB(MUL(t8a, 3196), MUL(t9a, 16069));
+    t10 = ADD(MUL(t10a, 9102), MUL(t11a, 13623));
+    t11 = SUB(MUL(t10a, 13623), MUL(t11a, 9102));
+    t12 = SUB(MUL(t13a, 16069), MUL(t12a, 3196));
+    t13 = ADD(MUL(t13a, 3196), MUL(t12a, 16069));
+    t14 = SUB(MUL(t15a, 9102), MUL(t14a, 13623));
+    t15 = ADD(MUL(t15a, 13623), MUL(t14a, 9102));
+
+    t0   = ADD(t0a, t4a);
+    t1   = ADD(t1a, t5a);
+    t2   = ADD(t2a, t6a);
+    t3   = ADD(t3a, t7a);
+    t4   = SUB(t0a, t4a);
+    t5   = SUB(t1a, t5a);
+    t6   = SUB(t2a, t6a);
+    t7   = SUB(t3a, t7a);
+    t8a  = RND(ADD(t8, t12));
+    t9a  = RND(ADD(t9, t13));
+    t10a = RND(ADD(t10, t14));
+    t11a = RND(ADD(t11, t15));
+    t12a = RND(SUB(t8, t12));
+    t13a = RND(SUB(t9, t13));
+    t14a = RND(SUB(t10, t14));
+    t15a = RND(SUB(t11, t15));
+
+    t4a = ADD(MUL(t4, 15137), MUL(t5, 6270));
+    t5a = SUB(MUL(t4, 6270), MUL(t5, 15137));
+    t6a = SUB(MUL(t7, 15137), MUL(t6, 6270));
+    t7a = ADD(MUL(t7, 6270), MUL(t6, 15137));
+    t12 = ADD(MUL(t12a, 15137), MUL(t13a, 6270));
+    t13 = SUB(MUL(t12a, 6270), MUL(t13a, 15137));
+    t14 = SUB(MUL(t15a, 15137), MUL(t14a, 6270));
+    t15 = ADD(MUL(t15a, 6270), MUL(t14a, 15137));
+
+    out[0]  = ADD(t0, t2);
+    out[15] = NEG(ADD(t1, t3));
+    t2a     = SUB(t0, t2);
+    t3a     = SUB(t1, t3);
+    out[3]  = NEG(RND(ADD(t4a, t6a)));
+    out[12] = RND(ADD(t5a, t7a));
+    t6      = RND(SUB(t4a, t6a));
+    t7      = RND(SUB(t5a, t7a));
+    out[1]  = NEG(ADD(t8a, t10a));
+    out[14] = ADD(t9a, t11a);
+    t10     = SUB(t8a, t10a);
+    t11     = SUB(t9a, t11a);
+    out[2]  = RND(ADD(t12, t14));
+    out[13] = NEG(RND(ADD(t13, t15)));
+    t14a    = RND(SUB(t12, t14));
+    t15a    = RND(SUB(t13, t15));
+
+    out[7]  = RND(MUL(ADD(t2a, t3a), -11585));
+    out[8]  = RND(MUL(SUB(t2a, t3a), 11585));
+    out[4]  = RND(MUL(ADD(t7, t6), 11585));
+    out[11] = RND(MUL(SUB(t7, t6), 11585));
+    out[6]  = RND(MUL(ADD(t11, t10), 11585));
+    out[9]  = RND(MUL(SUB(t11, t10), 11585));
+    out[5]  = RND(MUL(ADD(t14a, t15a), -11585));
+    out[10] = RND(MUL(SUB(t14a, t15a), 11585));
+}
+
+static av_always_inline TARGET void FN(idct32_1d)(VEC *out, const VEC *in)
+{
+    const VEC rnd = V(set1_epi32)(1 << 13);
+    VEC t0, t1, t2, t3, t4, t5, t6, t7, t8, t9, t10, t11, t12, t13, t14, t15;
+    VEC t16, t17, t18, t19, t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+    VEC t30, t31;
+    VEC t0a, t1a, t2a, t3a, t4a, t5a, t6a, t7a, t8a, t9a, t10a, t11a, t12a;
+    VEC t13a, t14a, t15a, t16a, t17a, t18a, t19a, t20a, t21a, t22a, t23a, t24a;
+    VEC t25a, t26a, t27a, t28a, t29a, t30a, t31a;
+
+    t0a  = RND(MUL(ADD(IN(0), IN(16)), 11585));
+    t1a  = RND(MUL(SUB(IN(0), IN(16)), 11585));
+    t2a  = RND(SUB(MUL(IN(8), 6270), MUL(IN(24), 15137)));
+    t3a  = RND(ADD(MUL(IN(8), 15137), MUL(IN(24), 6270)));
+    t4a  = RND(SUB(MUL(IN(4), 3196), MUL(IN(28), 16069)));
+    t7a  = RND(ADD(MUL(IN(4), 16069), MUL(IN(28), 3196)));
+    t5a  = RND(SUB(MUL(IN(20), 13623), MUL(IN(12), 9102)));
+    t6a  = RND(ADD(MUL(IN(20), 9102), MUL(IN(12), 13623)));
+    t8a  = RND(SUB(MUL(IN(2), 1606), MUL(IN(30), 16305)));
+    t15a = RND(ADD(MUL(IN(2), 16305), MUL(IN(30), 1606)));
+    t9a  = RND(SUB(MUL(IN(18), 12665), MUL(IN(14), 10394)));
+    t14a = RND(ADD(MUL(IN(18), 10394), MUL(IN(14), 12665)));
+    t10a = RND(SUB(MUL(IN(10), 7723), MUL(IN(22), 14449)));
+    t13a = RND(ADD(MUL(IN(10), 14449), MUL(IN(22), 7723)));
+    t11a = RND(SUB(MUL(IN(26), 15679), MUL(IN(6), 4756)));
+    t12a = RND(ADD(MUL(IN(26), 4756), MUL(IN(6), 15679)));
+    t16a = RND(SUB(MUL(IN(1), 804), MUL(IN(31), 16364)));
+    t31a = RND(ADD(MUL(IN(1), 16364), MUL(IN(31), 804)));
+    t17a = RND(SUB(MUL(IN(17), 12140), MUL(IN(15), 11003)));
+    t30a = RND(ADD(MUL(IN(17), 11003), MUL(IN(15), 12140)));
+    t18a = RND(SUB(MUL(IN(9), 7005), MUL(IN(23), 14811)));
+    t29a = RND(ADD(MUL(IN(9), 14811), MUL(IN(23), 7005)));
+    t19a = RND(SUB(MUL(IN(25), 15426), MUL(IN(7), 5520)));
+    t28a = RND(ADD(MUL(IN(25), 5520), MUL(IN(7), 15426)));
+    t20a = RND(SUB(MUL(IN(5), 3981), MUL(IN(27), 15893)));
+    t27a = RND(ADD(MUL(IN(5), 15893), MUL(IN(27), 3981)));
+    t21a = RND(SUB(MUL(IN(21), 14053), MUL(IN(11), 8423)));
+    t26a = RND(ADD(MUL(IN(21), 8423), MUL(IN(11), 14053)));
+    t22a = RND(SUB(MUL(IN(13), 9760), MUL(IN(19), 13160)));
+    t25a = RND(ADD(MUL(IN(13), 13160), MUL(IN(19), 9760)));
+    t23a = RND(SUB(MUL(IN(29), 16207), MUL(IN(3), 2404)));
+    t24a = RND(ADD(MUL(IN(29), 2404), MUL(IN(3), 16207)));
+
+    t0  = ADD(t0a, t3a);
+    t1  = ADD(t1a, t2a);
+    t2  = SUB(t1a, t2a);
+    t3  = SUB(t0a, t3a);
+    t4  = ADD(t4a, t5a);
+    t5  = SUB(t4a, t5a);
+    t6  = SUB(t7a, t6a);
+    t7  = ADD(t7a, t6a);
+    t8  = ADD(t8a, t9a);
+    t9  = SUB(t8a, t9a);
+    t10 = SUB(t11a, t10a);
+    t11 = ADD(t11a, t10a);
+    t12 = ADD(t12a, t13a);
+    t13 = SUB(t12a, t13a);
+    t14 = SUB(t15a, t14a);
+    t15 = ADD(t15a, t14a);
+    t16 = ADD(t16a, t17a);
+    t17 = SUB(t16a, t17a);
+    t18 = SUB(t19a, t18a);
+    t19 = ADD(t19a, t18a);
+    t20 = ADD(t20a, t21a);
+    t21 = SUB(t20a, t21a);
+    t22 = SUB(t23a, t22a);
+    t23 = ADD(t23a, t22a);
+    t24 = ADD(t24a, t25a);
+    t25 = SUB(t24a, t25a);
+    t26 = SUB(t27a, t26a);
+    t27 = ADD(t27a, t26a);
+    t28 = ADD(t28a, t29a);
+    t29 = SUB(t28a, t29a);
+    t30 = SUB(t31a, t30a);
+    t31 = ADD(t31a, t30a);
+
+    t5a  = RND(MUL(SUB(t6, t5), 11585));
+    t6a  = RND(MUL(ADD(t6, t5), 11585));
+    t9a  = RND(SUB(MUL(t14, 6270), MUL(t9, 15137)));
+    t14a = RND(ADD(MUL(t14, 15137), MUL(t9, 6270)));
+    t10a = RND(NEG(ADD(MUL(t13, 15137), MUL(t10, 6270))));
+    t13a = RND(SUB(MUL(t13, 6270), MUL(t10, 15137)));
+    t17a = RND(SUB(MUL(t30, 3196), MUL(t17, 16069)));
+    t30a = RND(ADD(MUL(t30, 16069), MUL(t17, 3196)));
+    t18a = RND(NEG(ADD(MUL(t29, 16069), MUL(t18, 3196))));
+    t29a = RND(SUB(MUL(t29, 3196), MUL(t18, 16069)));
+    t21a = RND(SUB(MUL(t26, 13623), MUL(t21, 9102)));
+    t26a = RND(ADD(MUL(t26, 9102), MUL(t21, 13623)));
+    t22a = RND(NEG(ADD(MUL(t25, 9102), MUL(t22, 13623))));
+    t25a = RND(SUB(MUL(t25, 13623), MUL(t22, 9102)));
+
+    t0a  = ADD(t0, t7);
+    t1a  = ADD(t1, t6a);
+    t2a  = ADD(t2, t5a);
+    t3a  = ADD(t3, t4);
+    t4a  = SUB(t3, t4);
+    t5   = SUB(t2, t5a);
+    t6   = SUB(t1, t6a);
+    t7a  = SUB(t0, t7);
+    t8a  = ADD(t8, t11);
+    t9   = ADD(t9a, t10a);
+    t10  = SUB(t9a, t10a);
+    t11a = SUB(t8, t11);
+    t12a = SUB(t15, t12);
+    t13  = SUB(t14a, t13a);
+    t14  = ADD(t14a, t13a);
+    t15a = ADD(t15, t12);
+    t16a = ADD(t16, t19);
+    t17  = ADD(t17a, t18a);
+    t18  = SUB(t17a, t18a);
+    t19a = SUB(t16, t19);
+    t20a = SUB(t23, t20);
+    t21  = SUB(t22a, t21a);
+    t22  = ADD(t22a, t21a);
+    t23a = ADD(t23, t20);
+    t24a = ADD(t24, t27);
+    t25  = ADD(t25a, t26a);
+    t26  = SUB(t25a, t26a);
+    t27a = SUB(t24, t27);
+    t28a = SUB(t31, t28);
+    t29  = SUB(t30a, t29a);
+    t30  = ADD(t30a, t29a);
+    t31a = ADD(t31, t28);
+
+    t10a = RND(MUL(SUB(t13, t10), 11585));
+    t13a = RND(MUL(ADD(t13, t10), 11585));
+    t11  = RND(MUL(SUB(t12a, t11a), 11585));
+    t12  = RND(MUL(ADD(t12a, t11a), 11585));
+    t18a = RND(SUB(MUL(t29, 6270), MUL(t18, 15137)));
+    t29a = RND(ADD(MUL(t29, 15137), MUL(t18, 6270)));
+    t19  = RND(SUB(MUL(t28a, 6270), MUL(t19a, 15137)));
+    t28  = RND(ADD(MUL(t28a, 15137), MUL(t19a, 6270)));
+    t20  = RND(NEG(ADD(MUL(t27a, 15137), MUL(t20a, 6270))));
+    t27  = RND(SUB(MUL(t27a, 6270), MUL(t20a, 15137)));
+    t21a = RND(NEG(ADD(MUL(t26, 15137), MUL(t21, 6270))));
+    t26a = RND(SUB(MUL(t26, 6270), MUL(t21, 15137)));
+
+    t0   = ADD(t0a, t15a);
+    t1   = ADD(t1a, t14);
+    t2   = ADD(t2a, t13a);
+    t3   = ADD(t3a, t12);
+    t4   = ADD(t4a, t11);
+    t5a  = ADD(t5, t10a);
+    t6a  = ADD(t6, t9);
+    t7   = ADD(t7a, t8a);
+    t8   = SUB(t7a, t8a);
+    t9a  = SUB(t6, t9);
+    t10  = SUB(t5, t10a);
+    t11a = SUB(t4a, t11);
+    t12a = SUB(t3a, t12);
+    t13  = SUB(t2a, t13a);
+    t14a = SUB(t1a, t14);
+    t15  = SUB(t0a, t15a);
+    t16  = ADD(t16a, t23a);
+    t17a = ADD(t17, t22);
+    t18  = ADD(t18a, t21a);
+    t19a = ADD(t19, t20);
+    t20a = SUB(t19, t20);
+    t21  = SUB(t18a, t21a);
+    t22a = SUB(t17, t22);
+    t23  = SUB(t16a, t23a);
+    t24  = SUB(t31a, t24a);
+    t25a = SUB(t30, t25);
+    t26  = SUB(t29a, t26a);
+    t27a = SUB(t28, t27);
+    t28a = ADD(t28, t27);
+    t29  = ADD(t29a, t26a);
+    t30a = ADD(t30, t25);
+    t31  = ADD(t31a, t24a);
+
+    t20  = RND(MUL(SUB(t27a, t20a), 11585));
+    t27  = RND(MUL(ADD(t27a, t20a), 11585));
+    t21a = RND(MUL(SUB(t26, t21), 11585));
+    t26a = RND(MUL(ADD(t26, t21), 11585));
+    t22  = RND(MUL(SUB(t25a, t22a), 11585));
+    t25  = RND(MUL(ADD(t25a, t22a), 11585));
+    t23a = RND(MUL(SUB(t24, t23), 11585));
+    t24a = RND(MUL(ADD(t24, t23), 11585));
+
+    out[0]  = ADD(t0, t31);
+    out[1]  = ADD(t1, t30a);
+    out[2]  = ADD(t2, t29);
+    out[3]  = ADD(t3, t28a);
+    out[4]  = ADD(t4, t27);
+    out[5]  = ADD(t5a, t26a);
+    out[6]  = ADD(t6a, t25);
+    out[7]  = ADD(t7, t24a);
+    out[8]  = ADD(t8, t23a);
+    out[9]  = ADD(t9a, t22);
+    out[10] = ADD(t10, t21a);
+    out[11] = ADD(t11a, t20);
+    out[12] = ADD(t12a, t19a);
+    out[13] = ADD(t13, t18);
+    out[14] = ADD(t14a, t17a);
+    out[15] = ADD(t15, t16);
+    out[16] = SUB(t15, t16);
+    out[17] = SUB(t14a, t17a);
+    out[18] = SUB(t13, t18);
+    out[19] = SUB(t12a, t19a);
+    out[20] = SUB(t11a, t20);
+    out[21] = SUB(t10, t21a);
+    out[22] = SUB(t9a, t22);
+    out[23] = SUB(t8, t23a);
+    out[24] = SUB(t7, t24a);
+    out[25] = SUB(t6a, t25);
+    out[26] = SUB(t5a, t26a);
+    out[27] = SUB(t4, t27);
+    out[28] = SUB(t3, t28a);
+    out[29] = SUB(t2, t29);
+    out[30] = SUB(t1, t30a);
+    out[31] = SUB(t0, t31);
+}
+
+static av_always_inline TARGET void FN(itx1d)(VEC *out, const VEC *in, int adst, int sz)
+{
+    switch (sz) {
+    case 4:
+        if (adst) FN(iadst4_1d)(out, in);
+        else      FN(idct4_1d)(out, in);
+        break;
+    case 8:
+        if (adst) FN(iadst8_1d)(out, in);
+        else      FN(idct8_1d)(out, in);
+        break;
+    case 16:
+        if (adst) FN(iadst16_1d)(out, in);
+        else      FN(idct16_1d)(out, in);
+        break;
+    case 32:
+        FN(idct32_1d)(out, in);
+        break;
+    }
+}
+
+/* Truncate to int16 like the dctcoef stores of the C code */
+static av_always_inline TARGET VEC FN(trunc16)(VEC v)
+{
+    return V(srai_epi32)(V(slli_epi32)(v, 16), 16);
+}
+
+/**
+ * The first pass transforms the columns of the block and writes them as
+ * rows of tmp, the second one transforms the columns of tmp and adds them
+ * to dst. Column groups without coefficients skip the first pass.
+ */
+static av_always_inline TARGET void FN(itxfm_add)(uint8_t *dst, ptrdiff_t stride,
+                                                  int16_t *block, int sz, int bits,
+                                                  int adst_a, int adst_b)
+{
+    DECLARE_ALIGNED(32, int32_t, tmp)[32 * 32];
+    const VEC round = V(set1_epi32)(1 << (bits - 1));
+    VEC in[32], out[32];
+    int i, j, k;
+
+    for (i = 0; i < sz; i += LANES) {
+        VEC nz = SETZERO();
+
+        for (k = 0; k < sz; k++) {
+            in[k] = FN(load_coefs)(block + k * sz + i);
+            nz    = OR(nz, in[k]);
+        }
+        if (TESTZ(nz)) {
+            memset(tmp + i * sz, 0, LANES * sz * sizeof(*tmp));
+            continue;
+        }
+
+        FN(itx1d)(out, in, adst_a, sz);
+        for (k = 0; k < sz; k += LANES) {
+            for (j = 0; j < LANES; j++)
+                out[k + j] = FN(trunc16)(out[k + j]);
+            FN(transpose)(out + k);
+            for (j = 0; j < LANES; j++)
+                STORE(tmp + (i + j) * sz + k, out[k + j]);
+        }
+    }
+    memset(block, 0, sz * sz * sizeof(*block));
+
+    for (i = 0; i < sz; i += LANES) {
+        for (k = 0; k < sz; k++)
+            in[k] = LOAD(tmp + k * sz + i);
+
+        FN(itx1d)(out, in, adst_b, sz);
+        for (j = 0; j < sz; j++) {
+            VEC v = V(srai_epi32)(V(add_epi32)(FN(trunc16)(out[j]), round), bits);
+
+            FN(add_pixels)(dst + j * stride + i, v);
+        }
+    }
+}
+
+#define ITXFM_FN(type_a, type_b, sz, bits, adst_a, adst_b, has_dconly)           \
+static TARGET void FN(type_a ## _ ## type_b ## _ ## sz ## x ## sz ## _add)(uint8_t *dst,  \
+                                                                  ptrdiff_t stride,  \
+                                                                  int16_t *block,    \
+                                                                  int eob)           \
+{                                                                                  \
+    if (has_dconly && eob == 1)                                                    \
+        idct_dc_add(dst, stride, block, sz, bits);                                 \
+    else                                                                           \
+        FN(itxfm_add)(dst, stride, block, sz, bits, adst_a, adst_b);               \
+}
+
+#define ITXFM_FNS(sz, bits)                      \
+    ITXFM_FN(idct,  idct,  sz, bits, 0, 0, 1)    \
+    ITXFM_FN(iadst, idct,  sz, bits, 1, 0, 0)    \
+    ITXFM_FN(idct,  iadst, sz, bits, 0, 1, 0)    \
+    ITXFM_FN(iadst, iadst, sz, bits, 1, 1, 0)
+
+#if LANES == 4
+ITXFM_FNS(4, 4)
+#endif
+ITXFM_FNS(8, 5)
+ITXFM_FNS(16, 6)
+ITXFM_FN(idct, idct, 32, 6, 0, 0, 1)
+
+#undef ITXFM_FN
+#undef ITXFM_FNS
+#undef IN
+#undef ADD
+#undef SUB
+#undef NEG
+#undef MUL
+#undef RND
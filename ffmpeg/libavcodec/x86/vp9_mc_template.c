@@ -0,0 +1,208 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * VP9 motion compensation, included by vp9dsp.c once per vector width.
+ * Up to STEP output pixels are computed per iteration with pmaddubsw on
+ * interleaved source pixels, so horizontal and vertical filtering share
+ * the same code and only differ in the distance between the taps.
+ *
+ * The includer defines VEC, STEP, TARGET, V(), SETZERO and FN() and provides
+ * FN(load) and FN(store), which access n = 4, 8 or STEP pixels.
+ */
+
+/* f[] holds the tap pairs (0,1), (2,3), (4,5) and (6,7). The sums of the
+ * pairs (0,1)+(4,5) and (2,3)+(6,7) cannot overflow for any VP9 filter, so
+ * only the last addition needs to saturate. pmulhrsw with 256 rounds like
+ * (x + 64) >> 7. */
+static av_always_inline TARGET VEC FN(sum_8tap)(const VEC *r, const VEC *f, int hi)
+{
+#define PAIR(a, b) (hi ? V(unpackhi_epi8)(a, b) : V(unpacklo_epi8)(a, b))
+    VEC s0 = V(add_epi16)(V(maddubs_epi16)(PAIR(r[0], r[1]), f[0]),
+                          V(maddubs_epi16)(PAIR(r[4], r[5]), f[2]));
+    VEC s1 = V(add_epi16)(V(maddubs_epi16)(PAIR(r[2], r[3]), f[1]),
+                          V(maddubs_epi16)(PAIR(r[6], r[7]), f[3]));
+#undef PAIR
+
+    return V(mulhrs_epi16)(V(adds_epi16)(s0, s1), V(set1_epi16)(256));
+}
+
+/* (16 - m) * a + m * b rounded by pmulhrsw with 2048, which is the same as
+ * a + ((m * (b - a) + 8) >> 4) */
+static av_always_inline TARGET VEC FN(sum_bilin)(VEC a, VEC b, VEC f, int hi)
+{
+    VEC s = V(maddubs_epi16)(hi ? V(unpackhi_epi8)(a, b) : V(unpacklo_epi8)(a, b), f);
+
+    return V(mulhrs_epi16)(s, V(set1_epi16)(2048));
+}
+
+/* n pixels at src filtered in the direction of step */
+static av_always_inline TARGET VEC FN(filter)(const uint8_t *src, ptrdiff_t step,
+                                              const VEC *f, int n, int bilin)
+{
+    VEC lo, hi;
+
+    if (bilin) {
+        VEC a = FN(load)(src, n), b = FN(load)(src + step, n);
+
+        lo = FN(sum_bilin)(a, b, f[0], 0);
+        hi = n > 8 ? FN(sum_bilin)(a, b, f[0], 1) : lo;
+    } else {
+        VEC r[8];
+        int k;
+
+        for (k = 0; k < 8; k++)
+            r[k] = FN(load)(src + (k - 3) * step, n);
+        lo = FN(sum_8tap)(r, f, 0);
+        hi = n > 8 ? FN(sum_8tap)(r, f, 1) : lo;
+    }
+    return V(packus_epi16)(lo, hi);
+}
+
+static av_always_inline TARGET void FN(init_filter)(VEC *f, const int16_t *filter,
+                                                    int mxy, int bilin)
+{
+    int k;
+
+    if (bilin) {
+        f[0] = V(set1_epi16)((16 - mxy) | (mxy << 8));
+    } else {
+        for (k = 0; k < 4; k++)
+            f[k] = V(set1_epi16)((int16_t)((filter[2 * k] & 0xFF) |
+                                           (filter[2 * k + 1] * 256)));
+    }
+}
+
+static av_always_inline TARGET void FN(mc_1d)(uint8_t *dst, ptrdiff_t dst_stride,
+                                              const uint8_t *src, ptrdiff_t src_stride,
+                                              int w, int h, ptrdiff_t step,
+                                              const int16_t *filter, int mxy,
+                                              int bilin, int avg)
+{
+    const int n = FFMIN(w, STEP);
+    VEC f[4];
+    int x;
+
+    FN(init_filter)(f, filter, mxy, bilin);
+    do {
+        for (x = 0; x < w; x += n) {
+            VEC v = FN(filter)(src + x, step, f, n, bilin);
+
+            if (avg)
+                v = V(avg_epu8)(v, FN(load)(dst + x, n));
+            FN(store)(dst + x, v, n);
+        }
+        dst += dst_stride;
+        src += src_stride;
+    } while (--h);
+}
+
+/* Like the C code, the horizontal pass is clipped to 8 bits in tmp */
+static av_always_inline TARGET void FN(mc_2d)(uint8_t *dst, ptrdiff_t dst_stride,
+                                              const uint8_t *src, ptrdiff_t src_stride,
+                                              int w, int h, int mx, int my,
+                                              const int16_t (*filters)[8],
+                                              int bilin, int avg)
+{
+    DECLARE_ALIGNED(32, uint8_t, tmp)[64 * 71];
+    const int before = bilin ? 0 : 3;
+    const int after  = bilin ? 1 : 4;
+
+    FN(mc_1d)(tmp, 64, src - before * src_stride, src_stride, w, h + before + after,
+              1, bilin ? NULL : filters[mx], mx, bilin, 0);
+    FN(mc_1d)(dst, dst_stride, tmp + before * 64, 64, w, h,
+              64, bilin ? NULL : filters[my], my, bilin, avg);
+}
+
+static av_always_inline TARGET void FN(copy)(uint8_t *dst, ptrdiff_t dst_stride,
+                                             const uint8_t *src, ptrdiff_t src_stride,
+                                             int w, int h, int avg)
+{
+    const int n = FFMIN(w, STEP);
+    int x;
+
+    do {
+        for (x = 0; x < w; x += n) {
+            VEC v = FN(load)(src + x, n);
+
+            if (avg)
+                v = V(avg_epu8)(v, FN(load)(dst + x, n));
+            FN(store)(dst + x, v, n);
+        }
+        dst += dst_stride;
+        src += src_stride;
+    } while (--h);
+}
+
+#define MC_FNS(sz, op, avg)                                                             \
+static TARGET void FN(op ## sz)(uint8_t *dst, ptrdiff_t dst_stride,                       \
+                                const uint8_t *src, ptrdiff_t src_stride,                 \
+                                int h, int mx, int my)                                    \
+{                                                                                         \
+    FN(copy)(dst, dst_stride, src, src_stride, sz, h, avg);                               \
+}                                                                                         \
+                                                                                          \
+MC_FILTER_FNS(sz, op, avg, 8tap_smooth,  FILTER_8TAP_SMOOTH,  0)                          \
+MC_FILTER_FNS(sz, op, avg, 8tap_regular, FILTER_8TAP_REGULAR, 0)                          \
+MC_FILTER_FNS(sz, op, avg, 8tap_sharp,   FILTER_8TAP_SHARP,   0)                          \
+MC_FILTER_FNS(sz, op, avg, bilin,        0,                   1)
+
+#define MC_FILTER_FNS(sz, op, avg, type, type_idx, bilin)                               \
+static TARGET void FN(op ## _ ## type ## _ ## sz ## h)(uint8_t *dst, ptrdiff_t dst_stride, \
+                                                       const uint8_t *src,                \
+                                                       ptrdiff_t src_stride,              \
+                                                       int h, int mx, int my)             \
+{                                                                                         \
+    FN(mc_1d)(dst, dst_stride, src, src_stride, sz, h, 1,                                 \
+              ff_vp9_subpel_filters[type_idx][mx], mx, bilin, avg);                       \
+}                                                                                         \
+                                                                                          \
+static TARGET void FN(op ## _ ## type ## _ ## sz ## v)(uint8_t *dst, ptrdiff_t dst_stride, \
+                                                       const uint8_t *src,                \
+                                                       ptrdiff_t src_stride,              \
+                                                       int h, int mx, int my)             \
+{                                                                                         \
+    FN(mc_1d)(dst, dst_stride, src, src_stride, sz, h, src_stride,                        \
+              ff_vp9_subpel_filters[type_idx][my], my, bilin, avg);                       \
+}                                                                                         \
+                                                                                          \
+static TARGET void FN(op ## _ ## type ## _ ## sz ## hv)(uint8_t *dst, ptrdiff_t dst_stride, \
+                                                        const uint8_t *src,               \
+                                                        ptrdiff_t src_stride,             \
+                                                        int h, int mx, int my)            \
+{                                                                                         \
+    FN(mc_2d)(dst, dst_stride, src, src_stride, sz, h, mx, my,                            \
+              ff_vp9_subpel_filters[type_idx], bilin, avg);                               \
+}
+
+#define MC_SIZE_FNS(sz) \
+    MC_FNS(sz, put, 0)  \
+    MC_FNS(sz, avg, 1)
+
+#if STEP == 16
+MC_SIZE_FNS(4)
+MC_SIZE_FNS(8)
+MC_SIZE_FNS(16)
+#endif
+MC_SIZE_FNS(32)
+MC_SIZE_FNS(64)
+
+#undef MC_FNS
+#undef MC_FILTER_FNS
+#undef MC_SIZE_FNS
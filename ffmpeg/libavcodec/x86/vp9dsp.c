@@ -0,0 +1,773 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * VP9 8-bit DSP functions, SSE2, SSSE3, SSE4.1 and AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavcodec/vp9dsp.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_SSSE3
+#include <tmmintrin.h>
+#endif
+#if HAVE_INTRINSICS_SSE4
+#include <smmintrin.h>
+#endif
+#if HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+/* n = 4, 8, 16 pixels */
+static av_always_inline __m128i load_pixels(const uint8_t *p, int n)
+{
+    switch (n) {
+    case 4:  return _mm_cvtsi32_si128(AV_RN32(p));
+    case 8:  return _mm_loadl_epi64((const __m128i *)p);
+    default: return _mm_loadu_si128((const __m128i *)p);
+    }
+}
+
+static av_always_inline void store_pixels(uint8_t *p, __m128i v, int n)
+{
+    switch (n) {
+    case 4:  AV_WN32(p, _mm_cvtsi128_si32(v));         break;
+    case 8:  _mm_storel_epi64((__m128i *)p, v);         break;
+    default: _mm_storeu_si128((__m128i *)p, v);         break;
+    }
+}
+
+static av_always_inline void transpose8x8_epi16(__m128i *r)
+{
+    __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+    __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+    __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+    __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+    __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+    __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+    __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+    __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    r[0] = _mm_unpacklo_epi64(b0, b4);
+    r[1] = _mm_unpackhi_epi64(b0, b4);
+    r[2] = _mm_unpacklo_epi64(b1, b5);
+    r[3] = _mm_unpackhi_epi64(b1, b5);
+    r[4] = _mm_unpacklo_epi64(b2, b6);
+    r[5] = _mm_unpackhi_epi64(b2, b6);
+    r[6] = _mm_unpacklo_epi64(b3, b7);
+    r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+/****************************************************************************
+ * Intra prediction
+ ****************************************************************************/
+
+static av_always_inline void fill_rows(uint8_t *dst, ptrdiff_t stride, int n,
+                                       __m128i v0, __m128i v1)
+{
+    int y;
+
+    for (y = 0; y < n; y++, dst += stride) {
+        store_pixels(dst, v0, FFMIN(n, 16));
+        if (n == 32)
+            _mm_storeu_si128((__m128i *)(dst + 16), v1);
+    }
+}
+
+static av_always_inline int sum_pixels(const uint8_t *p, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i s;
+
+    if (n == 32)
+        s = _mm_add_epi64(_mm_sad_epu8(load_pixels(p, 16), zero),
+                          _mm_sad_epu8(load_pixels(p + 16, 16), zero));
+    else
+        s = _mm_sad_epu8(load_pixels(p, n), zero);
+    if (n >= 16)
+        s = _mm_add_epi64(s, _mm_unpackhi_epi64(s, s));
+    return _mm_cvtsi128_si32(s);
+}
+
+static av_always_inline void fill_dc(uint8_t *dst, ptrdiff_t stride, int n, int dc)
+{
+    __m128i v = _mm_set1_epi8(dc);
+
+    fill_rows(dst, stride, n, v, v);
+}
+
+static av_always_inline void dc_sse2(uint8_t *dst, ptrdiff_t stride,
+                                     const uint8_t *left, const uint8_t *top,
+                                     int n, int log2n)
+{
+    fill_dc(dst, stride, n, (sum_pixels(left, n) + sum_pixels(top, n) + n) >> (log2n + 1));
+}
+
+static av_always_inline void vert_sse2(uint8_t *dst, ptrdiff_t stride,
+                                       const uint8_t *top, int n)
+{
+    fill_rows(dst, stride, n, load_pixels(top, FFMIN(n, 16)),
+              n == 32 ? load_pixels(top + 16, 16) : _mm_setzero_si128());
+}
+
+/* left[] is stored bottom to top */
+static av_always_inline void hor_sse2(uint8_t *dst, ptrdiff_t stride,
+                                      const uint8_t *left, int n)
+{
+    int y;
+
+    for (y = 0; y < n; y++, dst += stride) {
+        __m128i v = _mm_set1_epi8(left[n - 1 - y]);
+
+        store_pixels(dst, v, FFMIN(n, 16));
+        if (n == 32)
+            _mm_storeu_si128((__m128i *)(dst + 16), v);
+    }
+}
+
+static av_always_inline void tm_sse2(uint8_t *dst, ptrdiff_t stride,
+                                     const uint8_t *left, const uint8_t *top, int n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i t[4];
+    int x, y;
+
+    for (x = 0; x < FFMAX(n, 8); x += 8)
+        t[x >> 3] = _mm_unpacklo_epi8(load_pixels(top + x, FFMIN(n, 8)), zero);
+
+    for (y = 0; y < n; y++, dst += stride) {
+        __m128i d = _mm_set1_epi16(left[n - 1 - y] - top[-1]);
+
+        for (x = 0; x < n; x += 16) {
+            __m128i lo = _mm_add_epi16(t[x >> 3], d);
+            __m128i hi = n > 8 ? _mm_add_epi16(t[(x >> 3) + 1], d) : lo;
+
+            store_pixels(dst + x, _mm_packus_epi16(lo, hi), FFMIN(n, 16));
+        }
+    }
+}
+
+#define INTRA_PRED_FNS(n, log2n)                                                    \
+static void vert_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,            \
+                                          const uint8_t *left, const uint8_t *top)   \
+{                                                                                    \
+    vert_sse2(dst, stride, top, n);                                                  \
+}                                                                                    \
+                                                                                     \
+static void hor_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,             \
+                                         const uint8_t *left, const uint8_t *top)    \
+{                                                                                    \
+    hor_sse2(dst, stride, left, n);                                                  \
+}                                                                                    \
+                                                                                     \
+static void tm_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,              \
+                                        const uint8_t *left, const uint8_t *top)     \
+{                                                                                    \
+    tm_sse2(dst, stride, left, top, n);                                              \
+}                                                                                    \
+                                                                                     \
+static void dc_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,              \
+                                        const uint8_t *left, const uint8_t *top)     \
+{                                                                                    \
+    dc_sse2(dst, stride, left, top, n, log2n);                                       \
+}                                                                                    \
+                                                                                     \
+static void dc_left_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,         \
+                                             const uint8_t *left, const uint8_t *top) \
+{                                                                                    \
+    fill_dc(dst, stride, n, (sum_pixels(left, n) + n / 2) >> log2n);                 \
+}                                                                                    \
+                                                                                     \
+static void dc_top_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,          \
+                                            const uint8_t *left, const uint8_t *top) \
+{                                                                                    \
+    fill_dc(dst, stride, n, (sum_pixels(top, n) + n / 2) >> log2n);                  \
+}                                                                                    \
+                                                                                     \
+static void dc_127_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,          \
+                                            const uint8_t *left, const uint8_t *top) \
+{                                                                                    \
+    fill_dc(dst, stride, n, 127);                                                    \
+}                                                                                    \
+                                                                                     \
+static void dc_128_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,          \
+                                            const uint8_t *left, const uint8_t *top) \
+{                                                                                    \
+    fill_dc(dst, stride, n, 128);                                                    \
+}                                                                                    \
+                                                                                     \
+static void dc_129_ ## n ## x ## n ## _sse2(uint8_t *dst, ptrdiff_t stride,          \
+                                            const uint8_t *left, const uint8_t *top) \
+{                                                                                    \
+    fill_dc(dst, stride, n, 129);                                                    \
+}
+
+INTRA_PRED_FNS(4,  2)
+INTRA_PRED_FNS(8,  3)
+INTRA_PRED_FNS(16, 4)
+INTRA_PRED_FNS(32, 5)
+
+/****************************************************************************
+ * Inverse transforms
+ ****************************************************************************/
+
+/* dc-only idct_idct, the rounded dc is added with unsigned saturation */
+static av_always_inline void idct_dc_add(uint8_t *dst, ptrdiff_t stride,
+                                         int16_t *block, int sz, int bits)
+{
+    int t  = ((((int) block[0] * 11585 + (1 << 13)) >> 14) * 11585 + (1 << 13)) >> 14;
+    int dc = (t + (1 << (bits - 1))) >> bits;
+    __m128i add = _mm_set1_epi8(av_clip_uint8( dc));
+    __m128i sub = _mm_set1_epi8(av_clip_uint8(-dc));
+    int x, y;
+
+    block[0] = 0;
+    for (y = 0; y < sz; y++, dst += stride) {
+        for (x = 0; x < sz; x += 16) {
+            __m128i v = load_pixels(dst + x, FFMIN(sz, 16));
+
+            v = _mm_subs_epu8(_mm_adds_epu8(v, add), sub);
+            store_pixels(dst + x, v, FFMIN(sz, 16));
+        }
+    }
+}
+
+/****************************************************************************
+ * Loop filter
+ ****************************************************************************/
+
+static av_always_inline __m128i absdiff_epu16(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+}
+
+static av_always_inline __m128i blend(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+/**
+ * Filter 8 pixels across an edge. p[0..15] hold the rows p7..p0, q0..q7
+ * as 16-bit lanes. All filters are computed on the unmodified pixels and
+ * the results are selected per lane like the branches of the C code.
+ * Returns 0 if no pixel changed.
+ */
+static av_always_inline int loop_filter_sse2(__m128i *p, int E, int I, int H, int wd)
+{
+    const int first = wd == 16 ? 0 : 4, last = 15 - first;
+    const __m128i e   = _mm_set1_epi16(E);
+    const __m128i i   = _mm_set1_epi16(I);
+    const __m128i h   = _mm_set1_epi16(H);
+    const __m128i one = _mm_set1_epi16(1);
+    __m128i bad, fm, flat8in, flat8out, hev, m4, m8, m16;
+    __m128i f, f1, f2, np[16];
+    int k;
+
+#define P(k) p[7 - (k)]
+#define Q(k) p[8 + (k)]
+#define GT(a, b, lim) _mm_cmpgt_epi16(absdiff_epu16(a, b), lim)
+    bad = _mm_or_si128(_mm_or_si128(GT(P(3), P(2), i), GT(P(2), P(1), i)),
+                       _mm_or_si128(GT(P(1), P(0), i), GT(Q(1), Q(0), i)));
+    bad = _mm_or_si128(bad, _mm_or_si128(GT(Q(2), Q(1), i), GT(Q(3), Q(2), i)));
+    bad = _mm_or_si128(bad, _mm_cmpgt_epi16(_mm_add_epi16(_mm_slli_epi16(absdiff_epu16(P(0), Q(0)), 1),
+                                                          _mm_srli_epi16(absdiff_epu16(P(1), Q(1)), 1)),
+                                            e));
+    if (_mm_movemask_epi8(bad) == 0xFFFF)
+        return 0;
+    fm = _mm_cmpeq_epi16(bad, _mm_setzero_si128());
+
+    flat8in = flat8out = _mm_setzero_si128();
+    if (wd >= 8) {
+        bad = _mm_or_si128(_mm_or_si128(GT(P(3), P(0), one), GT(P(2), P(0), one)),
+                           _mm_or_si128(GT(P(1), P(0), one), GT(Q(1), Q(0), one)));
+        bad = _mm_or_si128(bad, _mm_or_si128(GT(Q(2), Q(0), one), GT(Q(3), Q(0), one)));
+        flat8in = _mm_andnot_si128(bad, fm);
+    }
+    if (wd >= 16) {
+        bad = _mm_or_si128(_mm_or_si128(GT(P(7), P(0), one), GT(P(6), P(0), one)),
+                           _mm_or_si128(GT(P(5), P(0), one), GT(P(4), P(0), one)));
+        bad = _mm_or_si128(bad, _mm_or_si128(_mm_or_si128(GT(Q(4), Q(0), one), GT(Q(5), Q(0), one)),
+                                             _mm_or_si128(GT(Q(6), Q(0), one), GT(Q(7), Q(0), one))));
+        flat8out = _mm_andnot_si128(bad, flat8in);
+    }
+    hev = _mm_or_si128(GT(P(1), P(0), h), GT(Q(1), Q(0), h));
+#undef GT
+
+    m16 = flat8out;
+    m8  = _mm_andnot_si128(m16, flat8in);
+    m4  = _mm_andnot_si128(flat8in, fm);
+
+    for (k = first; k <= last; k++)
+        np[k] = p[k];
+
+    if (_mm_movemask_epi8(m4)) {
+        const __m128i lo = _mm_set1_epi16(-128), hi = _mm_set1_epi16(127);
+
+        f  = _mm_and_si128(hev, _mm_max_epi16(_mm_min_epi16(_mm_sub_epi16(P(1), Q(1)), hi), lo));
+        f  = _mm_add_epi16(f, _mm_mullo_epi16(_mm_sub_epi16(Q(0), P(0)), _mm_set1_epi16(3)));
+        f  = _mm_max_epi16(_mm_min_epi16(f, hi), lo);
+        f1 = _mm_srai_epi16(_mm_min_epi16(_mm_add_epi16(f, _mm_set1_epi16(4)), hi), 3);
+        f2 = _mm_srai_epi16(_mm_min_epi16(_mm_add_epi16(f, _mm_set1_epi16(3)), hi), 3);
+        np[7] = blend(m4, _mm_add_epi16(P(0), f2), np[7]);
+        np[8] = blend(m4, _mm_sub_epi16(Q(0), f1), np[8]);
+
+        f  = _mm_srai_epi16(_mm_add_epi16(f1, one), 1);
+        m4 = _mm_andnot_si128(hev, m4);
+        np[6] = blend(m4, _mm_add_epi16(P(1), f), np[6]);
+        np[9] = blend(m4, _mm_sub_epi16(Q(1), f), np[9]);
+    }
+
+    /* running sums over the filter windows, pixels beyond p3/q3 (p7/q7)
+     * repeat the outermost one */
+    if (wd >= 8 && _mm_movemask_epi8(m8)) {
+#define G(k) p[av_clip(k, 4, 11)]
+        __m128i s = _mm_set1_epi16(4);
+
+        for (k = 2; k <= 8; k++)
+            s = _mm_add_epi16(s, G(k));
+        s = _mm_add_epi16(s, G(5));
+        for (k = 5; k <= 10; k++) {
+            np[k] = blend(m8, _mm_srli_epi16(s, 3), np[k]);
+            s = _mm_add_epi16(_mm_sub_epi16(s, _mm_add_epi16(G(k - 3), G(k))),
+                              _mm_add_epi16(G(k + 4), G(k + 1)));
+        }
+#undef G
+    }
+
+    if (wd >= 16 && _mm_movemask_epi8(m16)) {
+#define G(k) p[av_clip(k, 0, 15)]
+        __m128i s = _mm_set1_epi16(8);
+
+        for (k = -6; k <= 8; k++)
+            s = _mm_add_epi16(s, G(k));
+        s = _mm_add_epi16(s, G(1));
+        for (k = 1; k <= 14; k++) {
+            np[k] = blend(m16, _mm_srli_epi16(s, 4), np[k]);
+            s = _mm_add_epi16(_mm_sub_epi16(s, _mm_add_epi16(G(k - 7), G(k))),
+                              _mm_add_epi16(G(k + 8), G(k + 1)));
+        }
+#undef G
+    }
+#undef P
+#undef Q
+
+    for (k = first; k <= last; k++)
+        p[k] = np[k];
+    return 1;
+}
+
+/* dir 0 filters a vertical edge (columns), 1 a horizontal one (rows) */
+static av_always_inline void loop_filter_8px(uint8_t *dst, ptrdiff_t stride,
+                                             int E, int I, int H, int wd, int dir)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const int first = wd == 16 ? 0 : 4, last = 15 - first;
+    __m128i p[16];
+    int k;
+
+    if (dir) {
+        for (k = first; k <= last; k++)
+            p[k] = _mm_unpacklo_epi8(load_pixels(dst + (k - 8) * stride, 8), zero);
+        if (!loop_filter_sse2(p, E, I, H, wd))
+            return;
+        for (k = first; k <= last; k++)
+            store_pixels(dst + (k - 8) * stride, _mm_packus_epi16(p[k], p[k]), 8);
+    } else {
+        for (k = 0; k < 8; k++) {
+            if (wd == 16) {
+                __m128i v = load_pixels(dst + k * stride - 8, 16);
+
+                p[k]     = _mm_unpacklo_epi8(v, zero);
+                p[k + 8] = _mm_unpackhi_epi8(v, zero);
+            } else {
+                p[k + 4] = _mm_unpacklo_epi8(load_pixels(dst + k * stride - 4, 8), zero);
+            }
+        }
+        if (wd == 16) {
+            transpose8x8_epi16(p);
+            transpose8x8_epi16(p + 8);
+        } else {
+            transpose8x8_epi16(p + 4);
+        }
+        if (!loop_filter_sse2(p, E, I, H, wd))
+            return;
+        if (wd == 16) {
+            transpose8x8_epi16(p);
+            transpose8x8_epi16(p + 8);
+            for (k = 0; k < 8; k++)
+                store_pixels(dst + k * stride - 8, _mm_packus_epi16(p[k], p[k + 8]), 16);
+        } else {
+            transpose8x8_epi16(p + 4);
+            for (k = 0; k < 8; k++)
+                store_pixels(dst + k * stride - 4, _mm_packus_epi16(p[k + 4], p[k + 4]), 8);
+        }
+    }
+}
+
+#define LF_8_FNS(wd)                                                               \
+static void loop_filter_h_ ## wd ## _8_sse2(uint8_t *dst, ptrdiff_t stride,       \
+                                            int E, int I, int H)                  \
+{                                                                                  \
+    loop_filter_8px(dst, stride, E, I, H, wd, 0);                                  \
+}                                                                                  \
+                                                                                   \
+static void loop_filter_v_ ## wd ## _8_sse2(uint8_t *dst, ptrdiff_t stride,       \
+                                            int E, int I, int H)                  \
+{                                                                                  \
+    loop_filter_8px(dst, stride, E, I, H, wd, 1);                                  \
+}
+
+LF_8_FNS(4)
+LF_8_FNS(8)
+LF_8_FNS(16)
+
+static void loop_filter_h_16_16_sse2(uint8_t *dst, ptrdiff_t stride, int E, int I, int H)
+{
+    loop_filter_8px(dst,              stride, E, I, H, 16, 0);
+    loop_filter_8px(dst + 8 * stride, stride, E, I, H, 16, 0);
+}
+
+static void loop_filter_v_16_16_sse2(uint8_t *dst, ptrdiff_t stride, int E, int I, int H)
+{
+    loop_filter_8px(dst,     stride, E, I, H, 16, 1);
+    loop_filter_8px(dst + 8, stride, E, I, H, 16, 1);
+}
+
+#define LF_MIX_FNS(wd1, wd2)                                                       \
+static void loop_filter_h_ ## wd1 ## wd2 ## _16_sse2(uint8_t *dst, ptrdiff_t stride, \
+                                                    int E, int I, int H)          \
+{                                                                                  \
+    loop_filter_8px(dst, stride, E & 0xFF, I & 0xFF, H & 0xFF, wd1, 0);            \
+    loop_filter_8px(dst + 8 * stride, stride, E >> 8, I >> 8, H >> 8, wd2, 0);     \
+}                                                                                  \
+                                                                                   \
+static void loop_filter_v_ ## wd1 ## wd2 ## _16_sse2(uint8_t *dst, ptrdiff_t stride, \
+                                                    int E, int I, int H)          \
+{                                                                                  \
+    loop_filter_8px(dst, stride, E & 0xFF, I & 0xFF, H & 0xFF, wd1, 1);            \
+    loop_filter_8px(dst + 8, stride, E >> 8, I >> 8, H >> 8, wd2, 1);              \
+}
+
+LF_MIX_FNS(4, 4)
+LF_MIX_FNS(4, 8)
+LF_MIX_FNS(8, 4)
+LF_MIX_FNS(8, 8)
+
+/****************************************************************************
+ * Motion compensation
+ ****************************************************************************/
+
+#if HAVE_INTRINSICS_SSSE3
+static av_always_inline av_target_ssse3 __m128i load_ssse3(const uint8_t *p, int n)
+{
+    return load_pixels(p, n);
+}
+
+static av_always_inline av_target_ssse3 void store_ssse3(uint8_t *p, __m128i v, int n)
+{
+    store_pixels(p, v, n);
+}
+
+#define VEC             __m128i
+#define STEP            16
+#define TARGET          av_target_ssse3
+#define V(op)           _mm_ ## op
+#define SETZERO         _mm_setzero_si128
+#define FN(name)        name ## _ssse3
+#include "vp9_mc_template.c"
+#undef VEC
+#undef STEP
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef FN
+#endif /* HAVE_INTRINSICS_SSSE3 */
+
+#if HAVE_INTRINSICS_AVX2
+static av_always_inline av_target_avx2 __m256i load_avx2(const uint8_t *p, int n)
+{
+    return _mm256_loadu_si256((const __m256i *)p);
+}
+
+static av_always_inline av_target_avx2 void store_avx2(uint8_t *p, __m256i v, int n)
+{
+    _mm256_storeu_si256((__m256i *)p, v);
+}
+
+#define VEC             __m256i
+#define STEP            32
+#define TARGET          av_target_avx2
+#define V(op)           _mm256_ ## op
+#define SETZERO         _mm256_setzero_si256
+#define FN(name)        name ## _avx2
+#include "vp9_mc_template.c"
+#undef VEC
+#undef STEP
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef FN
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+/****************************************************************************
+ * Inverse transforms, SSE4.1 and AVX2
+ ****************************************************************************/
+
+#if HAVE_INTRINSICS_SSE4
+static av_always_inline av_target_sse4 __m128i load_coefs_sse4(const int16_t *p)
+{
+    return _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+static av_always_inline av_target_sse4 void transpose_sse4(__m128i *r)
+{
+    __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+    __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+    __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+    __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+
+    r[0] = _mm_unpacklo_epi64(t0, t1);
+    r[1] = _mm_unpackhi_epi64(t0, t1);
+    r[2] = _mm_unpacklo_epi64(t2, t3);
+    r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+static av_always_inline av_target_sse4 void add_pixels_sse4(uint8_t *dst, __m128i v)
+{
+    v = _mm_add_epi32(v, _mm_cvtepu8_epi32(_mm_cvtsi32_si128(AV_RN32(dst))));
+    v = _mm_packs_epi32(v, v);
+    AV_WN32(dst, _mm_cvtsi128_si32(_mm_packus_epi16(v, v)));
+}
+
+#define VEC             __m128i
+#define LANES           4
+#define TARGET          av_target_sse4
+#define V(op)           _mm_ ## op
+#define SETZERO         _mm_setzero_si128
+#define LOAD(p)         _mm_load_si128((const __m128i *)(p))
+#define STORE(p, v)     _mm_store_si128((__m128i *)(p), v)
+#define OR(a, b)        _mm_or_si128(a, b)
+#define TESTZ(v)        _mm_testz_si128(v, v)
+#define FN(name)        name ## _sse4
+#include "vp9_itxfm_template.c"
+#undef VEC
+#undef LANES
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef LOAD
+#undef STORE
+#undef OR
+#undef TESTZ
+#undef FN
+#endif /* HAVE_INTRINSICS_SSE4 */
+
+#if HAVE_INTRINSICS_AVX2
+static av_always_inline av_target_avx2 __m256i load_coefs_avx2(const int16_t *p)
+{
+    return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p));
+}
+
+static av_always_inline av_target_avx2 void transpose_avx2(__m256i *r)
+{
+    __m256i a[8], b[8];
+    int k;
+
+    for (k = 0; k < 8; k += 4) {
+        __m256i t0 = _mm256_unpacklo_epi32(r[k + 0], r[k + 1]);
+        __m256i t1 = _mm256_unpacklo_epi32(r[k + 2], r[k + 3]);
+        __m256i t2 = _mm256_unpackhi_epi32(r[k + 0], r[k + 1]);
+        __m256i t3 = _mm256_unpackhi_epi32(r[k + 2], r[k + 3]);
+
+        a[k + 0] = _mm256_unpacklo_epi64(t0, t1);
+        a[k + 1] = _mm256_unpackhi_epi64(t0, t1);
+        a[k + 2] = _mm256_unpacklo_epi64(t2, t3);
+        a[k + 3] = _mm256_unpackhi_epi64(t2, t3);
+    }
+    for (k = 0; k < 4; k++) {
+        b[k]     = _mm256_permute2x128_si256(a[k], a[k + 4], 0x20);
+        b[k + 4] = _mm256_permute2x128_si256(a[k], a[k + 4], 0x31);
+    }
+    for (k = 0; k < 8; k++)
+        r[k] = b[k];
+}
+
+static av_always_inline av_target_avx2 void add_pixels_avx2(uint8_t *dst, __m256i v)
+{
+    __m128i p;
+
+    v = _mm256_add_epi32(v, _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)dst)));
+    v = _mm256_permute4x64_epi64(_mm256_packs_epi32(v, v), 0x08);
+    p = _mm256_castsi256_si128(v);
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(p, p));
+}
+
+#define VEC             __m256i
+#define LANES           8
+#define TARGET          av_target_avx2
+#define V(op)           _mm256_ ## op
+#define SETZERO         _mm256_setzero_si256
+#define LOAD(p)         _mm256_load_si256((const __m256i *)(p))
+#define STORE(p, v)     _mm256_store_si256((__m256i *)(p), v)
+#define OR(a, b)        _mm256_or_si256(a, b)
+#define TESTZ(v)        _mm256_testz_si256(v, v)
+#define FN(name)        name ## _avx2
+#include "vp9_itxfm_template.c"
+#undef VEC
+#undef LANES
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef LOAD
+#undef STORE
+#undef OR
+#undef TESTZ
+#undef FN
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+#define INIT_MC(sz, idx, opt)                                                         \
+    INIT_MC_OP(sz, idx, put, 0, opt);                                                 \
+    INIT_MC_OP(sz, idx, avg, 1, opt)
+
+#define INIT_MC_OP(sz, idx, op, avg, opt)                                             \
+    dsp->mc[idx][FILTER_8TAP_SMOOTH ][avg][0][0] =                                    \
+    dsp->mc[idx][FILTER_8TAP_REGULAR][avg][0][0] =                                    \
+    dsp->mc[idx][FILTER_8TAP_SHARP  ][avg][0][0] =                                    \
+    dsp->mc[idx][FILTER_BILINEAR    ][avg][0][0] = op ## sz ## _ ## opt;              \
+    INIT_MC_FILTER(sz, idx, op, avg, FILTER_8TAP_SMOOTH,  8tap_smooth,  opt);         \
+    INIT_MC_FILTER(sz, idx, op, avg, FILTER_8TAP_REGULAR, 8tap_regular, opt);         \
+    INIT_MC_FILTER(sz, idx, op, avg, FILTER_8TAP_SHARP,   8tap_sharp,   opt);         \
+    INIT_MC_FILTER(sz, idx, op, avg, FILTER_BILINEAR,     bilin,        opt)
+
+#define INIT_MC_FILTER(sz, idx, op, avg, type_idx, type, opt)                         \
+    dsp->mc[idx][type_idx][avg][1][0] = op ## _ ## type ## _ ## sz ## h_  ## opt;     \
+    dsp->mc[idx][type_idx][avg][0][1] = op ## _ ## type ## _ ## sz ## v_  ## opt;     \
+    dsp->mc[idx][type_idx][avg][1][1] = op ## _ ## type ## _ ## sz ## hv_ ## opt
+
+#define INIT_ITXFM(tx, sz, opt)                                                       \
+    dsp->itxfm_add[tx][DCT_DCT]   = idct_idct_   ## sz ## _add_ ## opt;               \
+    dsp->itxfm_add[tx][DCT_ADST]  = iadst_idct_  ## sz ## _add_ ## opt;               \
+    dsp->itxfm_add[tx][ADST_DCT]  = idct_iadst_  ## sz ## _add_ ## opt;               \
+    dsp->itxfm_add[tx][ADST_ADST] = iadst_iadst_ ## sz ## _add_ ## opt
+
+#define INIT_IDCT32(opt)                                                              \
+    dsp->itxfm_add[TX_32X32][DCT_DCT]   =                                             \
+    dsp->itxfm_add[TX_32X32][DCT_ADST]  =                                             \
+    dsp->itxfm_add[TX_32X32][ADST_DCT]  =                                             \
+    dsp->itxfm_add[TX_32X32][ADST_ADST] = idct_idct_32x32_add_ ## opt
+
+#define INIT_INTRA_PRED(tx, sz)                                                       \
+    dsp->intra_pred[tx][VERT_PRED]    = vert_    ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][HOR_PRED]     = hor_     ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][TM_VP8_PRED]  = tm_      ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][DC_PRED]      = dc_      ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][LEFT_DC_PRED] = dc_left_ ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][TOP_DC_PRED]  = dc_top_  ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][DC_127_PRED]  = dc_127_  ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][DC_128_PRED]  = dc_128_  ## sz ## _sse2;                      \
+    dsp->intra_pred[tx][DC_129_PRED]  = dc_129_  ## sz ## _sse2
+
+/* High bit depth, the directional intra predictors, the lossless WHT and the
+ * scaled MC stay in C. */
+av_cold void ff_vp9dsp_init_x86(VP9DSPContext *dsp, int bpp, int bitexact)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+
+    if (bpp != 8)
+        return;
+
+    if (INTRINSICS_SSE2(cpu_flags)) {
+        INIT_INTRA_PRED(TX_4X4,   4x4);
+        INIT_INTRA_PRED(TX_8X8,   8x8);
+        INIT_INTRA_PRED(TX_16X16, 16x16);
+        INIT_INTRA_PRED(TX_32X32, 32x32);
+
+        dsp->loop_filter_8[0][0] = loop_filter_h_4_8_sse2;
+        dsp->loop_filter_8[0][1] = loop_filter_v_4_8_sse2;
+        dsp->loop_filter_8[1][0] = loop_filter_h_8_8_sse2;
+        dsp->loop_filter_8[1][1] = loop_filter_v_8_8_sse2;
+        dsp->loop_filter_8[2][0] = loop_filter_h_16_8_sse2;
+        dsp->loop_filter_8[2][1] = loop_filter_v_16_8_sse2;
+
+        dsp->loop_filter_16[0] = loop_filter_h_16_16_sse2;
+        dsp->loop_filter_16[1] = loop_filter_v_16_16_sse2;
+
+        dsp->loop_filter_mix2[0][0][0] = loop_filter_h_44_16_sse2;
+        dsp->loop_filter_mix2[0][0][1] = loop_filter_v_44_16_sse2;
+        dsp->loop_filter_mix2[0][1][0] = loop_filter_h_48_16_sse2;
+        dsp->loop_filter_mix2[0][1][1] = loop_filter_v_48_16_sse2;
+        dsp->loop_filter_mix2[1][0][0] = loop_filter_h_84_16_sse2;
+        dsp->loop_filter_mix2[1][0][1] = loop_filter_v_84_16_sse2;
+        dsp->loop_filter_mix2[1][1][0] = loop_filter_h_88_16_sse2;
+        dsp->loop_filter_mix2[1][1][1] = loop_filter_v_88_16_sse2;
+    }
+#if HAVE_INTRINSICS_SSSE3
+    if (INTRINSICS_SSSE3(cpu_flags)) {
+        INIT_MC(64, 0, ssse3);
+        INIT_MC(32, 1, ssse3);
+        INIT_MC(16, 2, ssse3);
+        INIT_MC(8,  3, ssse3);
+        INIT_MC(4,  4, ssse3);
+    }
+#endif
+#if HAVE_INTRINSICS_SSE4
+    if (INTRINSICS_SSE4(cpu_flags)) {
+        INIT_ITXFM(TX_4X4,   4x4,   sse4);
+        INIT_ITXFM(TX_8X8,   8x8,   sse4);
+        INIT_ITXFM(TX_16X16, 16x16, sse4);
+        INIT_IDCT32(sse4);
+    }
+#endif
+#if HAVE_INTRINSICS_AVX2
+    if (INTRINSICS_AVX2(cpu_flags)) {
+        INIT_MC(64, 0, avx2);
+        INIT_MC(32, 1, avx2);
+
+        INIT_ITXFM(TX_8X8,   8x8,   avx2);
+        INIT_ITXFM(TX_16X16, 16x16, avx2);
+        INIT_IDCT32(avx2);
+    }
+#endif
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
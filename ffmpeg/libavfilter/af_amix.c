@@ -167,6 +167,8 @@ typedef struct MixContext {
     AVAudioFifo **fifos;        /**< audio fifo for each input */
     uint8_t *input_state;       /**< current state of each input */
     float *input_scale;         /**< mixing scale factor for each input */
+    AVFrame **mix_bufs;         /**< samples of the active inputs for one output frame */
+    float *mix_scale;           /**< scale factor of each of mix_bufs */
     float scale_norm;           /**< normalization factor for all inputs */
     int64_t next_pts;           /**< calculated pts for next output frame */
     FrameList *frame_list;      /**< list of frame info for the first input */
@@ -254,6 +256,11 @@ static int config_output(AVFilterLink *outlink)
     s->scale_norm = s->active_inputs;
     calculate_scales(s, 0);
 
+    s->mix_bufs  = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_bufs));
+    s->mix_scale = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_scale));
+    if (!s->mix_bufs || !s->mix_scale)
+        return AVERROR(ENOMEM);
+
     av_get_channel_layout_string(buf, sizeof(buf), -1, outlink->channel_layout);
 
     av_log(ctx, AV_LOG_VERBOSE,
@@ -265,6 +272,57 @@ static int config_output(AVFilterLink *outlink)
 
 static int calc_active_inputs(MixContext *s);
 
+/* Samples of a plane mixed per block: the block of the output stays in L1
+ * cache while all the inputs are added to it. */
+#define MIX_BLOCK_SIZE 256
+
+/* Blocks times inputs below which a job costs more than it saves */
+#define MIN_SLICE_WORK 64
+
+typedef struct ThreadData {
+    AVFrame *out;
+    int nb_bufs;
+    int plane_size;             /**< samples per plane, a multiple of 16 */
+    int nb_blocks;              /**< blocks per plane */
+    int nb_units;               /**< blocks of all planes */
+} ThreadData;
+
+/**
+ * Mix a range of blocks, numbered across all planes.
+ *
+ * Every output sample gets the inputs added in the same order as one pass
+ * per input over the whole frame would, so the result does not depend on
+ * the block size or on the number of jobs.
+ */
+static int mix_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MixContext *s  = ctx->priv;
+    ThreadData *td = arg;
+    const int start = (td->nb_units *  jobnr     ) / nb_jobs;
+    const int end   = (td->nb_units * (jobnr + 1)) / nb_jobs;
+    int u, i;
+
+    for (u = start; u < end; u++) {
+        const int p   = u / td->nb_blocks;
+        const int off = u % td->nb_blocks * MIX_BLOCK_SIZE;
+        const int len = FFMIN(MIX_BLOCK_SIZE, td->plane_size - off);
+
+        if (td->out->format == AV_SAMPLE_FMT_FLT ||
+            td->out->format == AV_SAMPLE_FMT_FLTP) {
+            float *dst = (float *)td->out->extended_data[p] + off;
+            for (i = 0; i < td->nb_bufs; i++)
+                s->fdsp->vector_fmac_scalar(dst, (float *)s->mix_bufs[i]->extended_data[p] + off,
+                                            s->mix_scale[i], len);
+        } else {
+            double *dst = (double *)td->out->extended_data[p] + off;
+            for (i = 0; i < td->nb_bufs; i++)
+                s->fdsp->vector_dmac_scalar(dst, (double *)s->mix_bufs[i]->extended_data[p] + off,
+                                            s->mix_scale[i], len);
+        }
+    }
+    return 0;
+}
+
 /**
  * Read samples from the input FIFOs, mix, and write to the output link.
  */
@@ -272,8 +330,9 @@ static int output_frame(AVFilterLink *outlink, int need_request)
 {
     AVFilterContext *ctx = outlink->src;
     MixContext      *s = ctx->priv;
-    AVFrame *out_buf, *in_buf;
-    int nb_samples, ns, ret, i;
+    AVFrame *out_buf;
+    ThreadData td;
+    int nb_samples, ns, ret, i, nb_bufs, nb_jobs;
 
     ret = calc_active_inputs(s);
     if (ret < 0)
@@ -319,46 +378,44 @@ static int output_frame(AVFilterLink *outlink, int need_request)
     if (!out_buf)
         return AVERROR(ENOMEM);
 
-    in_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!in_buf) {
-        av_frame_free(&out_buf);
-        return AVERROR(ENOMEM);
-    }
-
+    nb_bufs = 0;
     for (i = 0; i < s->nb_inputs; i++) {
         if (s->input_state[i] & INPUT_ON) {
-            int planes, plane_size, p;
-
+            AVFrame *in_buf = ff_get_audio_buffer(outlink, nb_samples);
+            if (!in_buf) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
             av_audio_fifo_read(s->fifos[i], (void **)in_buf->extended_data,
                                nb_samples);
-
-            planes     = s->planar ? s->nb_channels : 1;
-            plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
-
-            if (out_buf->format == AV_SAMPLE_FMT_FLT ||
-                out_buf->format == AV_SAMPLE_FMT_FLTP) {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                                (float *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
-            } else {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_dmac_scalar((double *)out_buf->extended_data[p],
-                                                (double *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
-            }
+            s->mix_bufs[nb_bufs]    = in_buf;
+            s->mix_scale[nb_bufs++] = s->input_scale[i];
         }
     }
-    av_frame_free(&in_buf);
+
+    td.out        = out_buf;
+    td.nb_bufs    = nb_bufs;
+    td.plane_size = FFALIGN(nb_samples * (s->planar ? 1 : s->nb_channels), 16);
+    td.nb_blocks  = (td.plane_size + MIX_BLOCK_SIZE - 1) / MIX_BLOCK_SIZE;
+    td.nb_units   = (s->planar ? s->nb_channels : 1) * td.nb_blocks;
+    nb_jobs = av_clip(td.nb_units * nb_bufs / MIN_SLICE_WORK, 1,
+                      FFMIN(td.nb_units, ff_filter_get_nb_threads(ctx)));
+    ctx->internal->execute(ctx, mix_slice, &td, NULL, nb_jobs);
+
+    for (i = 0; i < nb_bufs; i++)
+        av_frame_free(&s->mix_bufs[i]);
 
     out_buf->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
         s->next_pts += nb_samples;
 
     return ff_filter_frame(outlink, out_buf);
+
+fail:
+    for (i = 0; i < nb_bufs; i++)
+        av_frame_free(&s->mix_bufs[i]);
+    av_frame_free(&out_buf);
+    return ret;
 }
 
 /**
@@ -520,6 +577,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->frame_list);
     av_freep(&s->input_state);
     av_freep(&s->input_scale);
+    av_freep(&s->mix_bufs);
+    av_freep(&s->mix_scale);
     av_freep(&s->fdsp);
 
     for (i = 0; i < ctx->nb_inputs; i++)
@@ -574,5 +633,6 @@ AVFilter ff_af_amix = {
     .query_formats  = query_formats,
     .inputs         = NULL,
     .outputs        = avfilter_af_amix_outputs,
-    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS |
+                      AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -254,6 +254,47 @@ static av_cold void volume_init(VolumeContext *vol)
         ff_volume_init_x86(vol);
 }
 
+/* Below this many samples per job, splitting a frame costs more than it saves */
+#define MIN_SLICE_SAMPLES 4096
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int plane_samples;
+} ThreadData;
+
+/*
+ * Each job scales the same range of samples in every plane. Range
+ * boundaries are multiples of 16 samples, which keeps the alignment
+ * AVFloatDSPContext needs.
+ */
+static int volume_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    VolumeContext *vol = ctx->priv;
+    ThreadData *td = arg;
+    const int bps   = av_get_bytes_per_sample(vol->sample_fmt);
+    const int start = FFMIN(FFALIGN(td->plane_samples *  jobnr      / nb_jobs, 16), td->plane_samples);
+    const int end   = FFMIN(FFALIGN(td->plane_samples * (jobnr + 1) / nb_jobs, 16), td->plane_samples);
+    int p;
+
+    if (start >= end)
+        return 0;
+
+    for (p = 0; p < vol->planes; p++) {
+        uint8_t       *dst = td->out->extended_data[p] + start * bps;
+        const uint8_t *src = td->in->extended_data[p]  + start * bps;
+
+        if (vol->precision == PRECISION_FIXED)
+            vol->scale_samples(dst, src, end - start, vol->volume_i);
+        else if (av_get_packed_sample_fmt(vol->sample_fmt) == AV_SAMPLE_FMT_FLT)
+            vol->fdsp->vector_fmul_scalar((float *)dst, (const float *)src,
+                                          vol->volume, end - start);
+        else
+            vol->fdsp->vector_dmul_scalar((double *)dst, (const double *)src,
+                                          vol->volume, end - start);
+    }
+    return 0;
+}
+
 static int set_volume(AVFilterContext *ctx)
 {
     VolumeContext *vol = ctx->priv;
@@ -424,32 +465,19 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *buf)
     }
 
     if (vol->precision != PRECISION_FIXED || vol->volume_i > 0) {
-        int p, plane_samples;
+        ThreadData td;
+        int nb_jobs;
 
         if (av_sample_fmt_is_planar(buf->format))
-            plane_samples = FFALIGN(nb_samples, vol->samples_align);
+            td.plane_samples = FFALIGN(nb_samples, vol->samples_align);
         else
-            plane_samples = FFALIGN(nb_samples * vol->channels, vol->samples_align);
+            td.plane_samples = FFALIGN(nb_samples * vol->channels, vol->samples_align);
+        td.in  = buf;
+        td.out = out_buf;
 
-        if (vol->precision == PRECISION_FIXED) {
-            for (p = 0; p < vol->planes; p++) {
-                vol->scale_samples(out_buf->extended_data[p],
-                                   buf->extended_data[p], plane_samples,
-                                   vol->volume_i);
-            }
-        } else if (av_get_packed_sample_fmt(vol->sample_fmt) == AV_SAMPLE_FMT_FLT) {
-            for (p = 0; p < vol->planes; p++) {
-                vol->fdsp->vector_fmul_scalar((float *)out_buf->extended_data[p],
-                                             (const float *)buf->extended_data[p],
-                                             vol->volume, plane_samples);
-            }
-        } else {
-            for (p = 0; p < vol->planes; p++) {
-                vol->fdsp->vector_dmul_scalar((double *)out_buf->extended_data[p],
-                                             (const double *)buf->extended_data[p],
-                                             vol->volume, plane_samples);
-            }
-        }
+        nb_jobs = av_clip(vol->planes * td.plane_samples / MIN_SLICE_SAMPLES,
+                          1, ff_filter_get_nb_threads(ctx));
+        ctx->internal->execute(ctx, volume_slice, &td, NULL, nb_jobs);
     }
 
     emms_c();
@@ -490,6 +518,7 @@ AVFilter ff_af_volume = {
     .uninit         = uninit,
     .inputs         = avfilter_af_volume_inputs,
     .outputs        = avfilter_af_volume_outputs,
-    .flags          = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags          = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                      AVFILTER_FLAG_SLICE_THREADS,
     .process_command = process_command,
 };
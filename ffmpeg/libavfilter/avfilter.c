@@ -190,7 +190,14 @@ int avfilter_link_get_channels(AVFilterLink *link)
 
 void ff_filter_set_ready(AVFilterContext *filter, unsigned priority)
 {
+    AVFilterGraph *graph = filter->graph;
+
+    /* filters on independent branches may share an upstream neighbor */
+    if (graph)
+        ff_graph_lock(graph);
     filter->ready = FFMAX(filter->ready, priority);
+    if (graph)
+        ff_graph_unlock(graph);
 }
 
 /**
@@ -527,11 +534,15 @@ void ff_update_link_current_pts(AVFilterLink *link, int64_t pts)
 {
     if (pts == AV_NOPTS_VALUE)
         return;
+    if (link->graph)
+        ff_graph_lock(link->graph);
     link->current_pts = pts;
     link->current_pts_us = av_rescale_q(pts, link->time_base, AV_TIME_BASE_Q);
     /* TODO use duration */
     if (link->graph && link->age_index >= 0)
         ff_avfilter_graph_update_heap(link->graph, link);
+    if (link->graph)
+        ff_graph_unlock(link->graph);
 }
 
 int avfilter_process_command(AVFilterContext *filter, const char *cmd, const char *arg, char *res, int res_len, int flags)
@@ -317,6 +317,13 @@ typedef struct AVFilter {
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
 
+/**
+ * Activate filters of independent branches of a graph concurrently, e.g.
+ * the outputs of a split or unconnected audio and video chains.
+ * Only meaningful in AVFilterGraph.thread_type.
+ */
+#define AVFILTER_THREAD_GRAPH (1 << 1)
+
 typedef struct AVFilterInternal AVFilterInternal;
 
 /** An instance of a filter */
@@ -852,7 +859,9 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is allowing everything
+     * but AVFILTER_THREAD_GRAPH, which must be set before configuring the
+     * graph.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
@@ -47,6 +47,7 @@ static const AVOption filtergraph_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .flags = FLAGS, .unit = "thread_type" },
+        { "graph", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_GRAPH }, .flags = FLAGS, .unit = "thread_type" },
     { "threads",     "Maximum number of threads", OFFSET(nb_threads),
         AV_OPT_TYPE_INT,   { .i64 = 0 }, 0, INT_MAX, FLAGS },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
@@ -75,6 +76,26 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     graph->nb_threads  = 1;
     return 0;
 }
+
+int ff_graph_sched_init(AVFilterGraph *graph)
+{
+    graph->thread_type &= ~AVFILTER_THREAD_GRAPH;
+    return 0;
+}
+
+int ff_graph_sched_execute(AVFilterGraph *graph, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+    return AVERROR(ENOSYS);
+}
+
+void ff_graph_lock(AVFilterGraph *graph)
+{
+}
+
+void ff_graph_unlock(AVFilterGraph *graph)
+{
+}
 #endif
 
 AVFilterGraph *avfilter_graph_alloc(void)
@@ -125,6 +146,8 @@ void avfilter_graph_free(AVFilterGraph **graph)
     ff_graph_thread_free(*graph);
 
     av_freep(&(*graph)->sink_links);
+    av_freep(&(*graph)->internal->batch);
+    av_freep(&(*graph)->internal->batch_ret);
 
     av_freep(&(*graph)->scale_sws_opts);
     av_freep(&(*graph)->aresample_swr_opts);
@@ -1223,6 +1246,54 @@ static int graph_config_pointers(AVFilterGraph *graph,
     return 0;
 }
 
+/**
+ * Find the sinks reachable from every filter and start the graph scheduler.
+ */
+static int graph_config_sched(AVFilterGraph *graph, AVClass *log_ctx)
+{
+    AVFilterGraphInternal *gi = graph->internal;
+    unsigned i, j, nb_sinks = 0, changed = 1;
+    int ret;
+
+    if (!(graph->thread_type & AVFILTER_THREAD_GRAPH))
+        return 0;
+
+    for (i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+        f->internal->sinks = f->nb_outputs ? 0 : 1ULL << (nb_sinks++ & 63);
+    }
+    /* the graph is acyclic, so this ends after at most nb_filters passes */
+    while (changed) {
+        changed = 0;
+        for (i = 0; i < graph->nb_filters; i++) {
+            AVFilterContext *f = graph->filters[i];
+            uint64_t sinks = f->internal->sinks;
+
+            for (j = 0; j < f->nb_outputs; j++)
+                sinks |= f->outputs[j]->dst->internal->sinks;
+            if (sinks != f->internal->sinks) {
+                f->internal->sinks = sinks;
+                changed = 1;
+            }
+        }
+    }
+
+    av_freep(&gi->batch);
+    av_freep(&gi->batch_ret);
+    gi->batch_size = 0;
+    gi->batch     = av_malloc_array(graph->nb_filters, sizeof(*gi->batch));
+    gi->batch_ret = av_malloc_array(graph->nb_filters, sizeof(*gi->batch_ret));
+    if (!gi->batch || !gi->batch_ret)
+        return AVERROR(ENOMEM);
+    gi->batch_size = graph->nb_filters;
+
+    ret = ff_graph_sched_init(graph);
+    if (ret < 0)
+        av_log(log_ctx, AV_LOG_ERROR, "Error initializing graph threads: %s.\n",
+               av_err2str(ret));
+    return ret;
+}
+
 static int graph_insert_fifos(AVFilterGraph *graph, AVClass *log_ctx)
 {
     AVFilterContext *f;
@@ -1275,6 +1346,8 @@ int avfilter_graph_config(AVFilterGraph *graphctx, void *log_ctx)
         return ret;
     if ((ret = graph_config_pointers(graphctx, log_ctx)))
         return ret;
+    if ((ret = graph_config_sched(graphctx, log_ctx)))
+        return ret;
 
     return 0;
 }
@@ -1434,6 +1507,62 @@ int avfilter_graph_request_oldest(AVFilterGraph *graph)
     return 0;
 }
 
+/**
+ * Maximum number of frames queued on an output link for the graph scheduler
+ * to activate its source filter along with the most ready one.
+ */
+#define MAX_QUEUED_FRAMES 4
+
+static int outputs_full(AVFilterContext *filter)
+{
+    unsigned i;
+
+    for (i = 0; i < filter->nb_outputs; i++)
+        if (ff_framequeue_queued_frames(&filter->outputs[i]->fifo) >= MAX_QUEUED_FRAMES)
+            return 1;
+    return 0;
+}
+
+static int activate_job(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AVFilterContext **batch = arg;
+
+    return ff_filter_activate(batch[jobnr]);
+}
+
+/**
+ * Activate the most ready filter and, concurrently, the ready filters that
+ * share no sink with it nor with each other. A filter always reaches the
+ * sinks of the filters it feeds, so no two filters of a batch are linked,
+ * feed a common filter or depend on each other's frames, and the output of
+ * every sink is the same as with one filter at a time.
+ */
+static int graph_run_batch(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    AVFilterGraphInternal *gi = graph->internal;
+    uint64_t sinks = filter->internal->sinks;
+    unsigned i, nb_jobs = 0;
+
+    gi->batch[nb_jobs++] = filter;
+    for (i = 0; i < graph->nb_filters && nb_jobs < gi->batch_size; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (!f->ready || !f->internal->sinks || (f->internal->sinks & sinks) ||
+            outputs_full(f))
+            continue;
+        gi->batch[nb_jobs++] = f;
+        sinks |= f->internal->sinks;
+    }
+    if (nb_jobs == 1)
+        return ff_filter_activate(filter);
+
+    ff_graph_sched_execute(graph, activate_job, gi->batch, gi->batch_ret, nb_jobs);
+    for (i = 0; i < nb_jobs; i++)
+        if (gi->batch_ret[i] < 0)
+            return gi->batch_ret[i];
+    return 0;
+}
+
 int ff_filter_graph_run_once(AVFilterGraph *graph)
 {
     AVFilterContext *filter;
@@ -1446,5 +1575,7 @@ int ff_filter_graph_run_once(AVFilterGraph *graph)
             filter = graph->filters[i];
     if (!filter->ready)
         return AVERROR(EAGAIN);
+    if (graph->internal->sched && filter->internal->sinks)
+        return graph_run_batch(graph, filter);
     return ff_filter_activate(filter);
 }
@@ -148,10 +148,19 @@ struct AVFilterGraphInternal {
     void *thread;
     avfilter_execute_func *thread_execute;
     FFFrameQueueGlobal frame_queues;
+    void *sched;                    ///< graph scheduler, see AVFILTER_THREAD_GRAPH
+    AVFilterContext **batch;        ///< filters activated together by the scheduler
+    int *batch_ret;
+    unsigned batch_size;
 };
 
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+    /**
+     * Sinks reachable from this filter, bit n % 64 for the n-th sink.
+     * Filters with no sink in common are on independent branches.
+     */
+    uint64_t sinks;
 };
 
 /**
@@ -48,11 +48,19 @@ typedef struct ThreadContext {
     pthread_cond_t last_job_cond;
     pthread_cond_t current_job_cond;
     pthread_mutex_t current_job_lock;
+    pthread_mutex_t execute_lock;
     int current_job;
     unsigned int current_execute;
     int done;
 } ThreadContext;
 
+/* The graph scheduler activates filters of independent branches on its own
+ * workers, these filters share the slice threads. */
+typedef struct GraphScheduler {
+    ThreadContext pool;
+    pthread_mutex_t lock;
+} GraphScheduler;
+
 static void* attribute_align_arg worker(void *v)
 {
     ThreadContext *c = v;
@@ -103,6 +111,7 @@ static void slice_thread_uninit(ThreadContext *c)
          pthread_join(c->workers[i], NULL);
 
     pthread_mutex_destroy(&c->current_job_lock);
+    pthread_mutex_destroy(&c->execute_lock);
     pthread_cond_destroy(&c->current_job_cond);
     pthread_cond_destroy(&c->last_job_cond);
     av_freep(&c->workers);
@@ -115,14 +124,14 @@ static void slice_thread_park_workers(ThreadContext *c)
     pthread_mutex_unlock(&c->current_job_lock);
 }
 
-static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
-                          void *arg, int *ret, int nb_jobs)
+static int thread_execute_internal(ThreadContext *c, AVFilterContext *ctx,
+                                   avfilter_action_func *func,
+                                   void *arg, int *ret, int nb_jobs)
 {
-    ThreadContext *c = ctx->graph->internal->thread;
-
     if (nb_jobs <= 0)
         return 0;
 
+    pthread_mutex_lock(&c->execute_lock);
     pthread_mutex_lock(&c->current_job_lock);
 
     c->current_job = c->nb_threads;
@@ -136,10 +145,18 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     pthread_cond_broadcast(&c->current_job_cond);
 
     slice_thread_park_workers(c);
+    pthread_mutex_unlock(&c->execute_lock);
 
     return 0;
 }
 
+static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
+                          void *arg, int *ret, int nb_jobs)
+{
+    return thread_execute_internal(ctx->graph->internal->thread, ctx,
+                                   func, arg, ret, nb_jobs);
+}
+
 static int thread_init_internal(ThreadContext *c, int nb_threads)
 {
     int i, ret;
@@ -169,6 +186,7 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
     pthread_cond_init(&c->last_job_cond,    NULL);
 
     pthread_mutex_init(&c->current_job_lock, NULL);
+    pthread_mutex_init(&c->execute_lock, NULL);
     pthread_mutex_lock(&c->current_job_lock);
     for (i = 0; i < nb_threads; i++) {
         ret = pthread_create(&c->workers[i], NULL, worker, c);
@@ -218,7 +236,63 @@ int ff_graph_thread_init(AVFilterGraph *graph)
 
 void ff_graph_thread_free(AVFilterGraph *graph)
 {
+    GraphScheduler *s = graph->internal->sched;
+
     if (graph->internal->thread)
         slice_thread_uninit(graph->internal->thread);
     av_freep(&graph->internal->thread);
+
+    if (s) {
+        slice_thread_uninit(&s->pool);
+        pthread_mutex_destroy(&s->lock);
+    }
+    av_freep(&graph->internal->sched);
+}
+
+int ff_graph_sched_init(AVFilterGraph *graph)
+{
+    GraphScheduler *s;
+    int ret;
+
+    if (graph->internal->sched)
+        return 0;
+
+    s = av_mallocz(sizeof(*s));
+    if (!s)
+        return AVERROR(ENOMEM);
+
+    ret = thread_init_internal(&s->pool, graph->nb_threads);
+    if (ret <= 1) {
+        av_free(s);
+        graph->thread_type &= ~AVFILTER_THREAD_GRAPH;
+        return (ret < 0) ? ret : 0;
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    graph->internal->sched = s;
+
+    return 0;
+}
+
+int ff_graph_sched_execute(AVFilterGraph *graph, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+    GraphScheduler *s = graph->internal->sched;
+
+    return thread_execute_internal(&s->pool, NULL, func, arg, ret, nb_jobs);
+}
+
+void ff_graph_lock(AVFilterGraph *graph)
+{
+    GraphScheduler *s = graph->internal->sched;
+
+    if (s)
+        pthread_mutex_lock(&s->lock);
+}
+
+void ff_graph_unlock(AVFilterGraph *graph)
+{
+    GraphScheduler *s = graph->internal->sched;
+
+    if (s)
+        pthread_mutex_unlock(&s->lock);
 }
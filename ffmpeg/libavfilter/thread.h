@@ -25,4 +25,26 @@ int ff_graph_thread_init(AVFilterGraph *graph);
 
 void ff_graph_thread_free(AVFilterGraph *graph);
 
+/**
+ * Start the workers activating the filters of independent branches.
+ * Clear AVFILTER_THREAD_GRAPH from the graph thread_type if only one thread
+ * is available.
+ */
+int ff_graph_sched_init(AVFilterGraph *graph);
+
+/**
+ * Run nb_jobs jobs on the graph scheduler workers and wait for them, the
+ * filter context passed to func is NULL.
+ */
+int ff_graph_sched_execute(AVFilterGraph *graph, avfilter_action_func *func,
+                           void *arg, int *ret, int nb_jobs);
+
+/**
+ * Protect the state filters running concurrently may share: the ready field
+ * of their common neighbors and the heap of the sink links. No-ops without
+ * graph scheduler.
+ */
+void ff_graph_lock(AVFilterGraph *graph);
+void ff_graph_unlock(AVFilterGraph *graph);
+
 #endif /* AVFILTER_THREAD_H */
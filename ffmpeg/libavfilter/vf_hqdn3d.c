@@ -42,8 +42,9 @@
 #include "vf_hqdn3d.h"
 
 #define LUT_BITS (depth==16 ? 8 : 4)
-#define LOAD(x) (((depth == 8 ? src[x] : AV_RN16A(src + (x) * 2)) << (16 - depth))\
-                 + (((1 << (16 - depth)) - 1) >> 1))
+#define LOAD_LINE(src, x) (((depth == 8 ? (src)[x] : AV_RN16A((src) + (x) * 2)) << (16 - depth))\
+                           + (((1 << (16 - depth)) - 1) >> 1))
+#define LOAD(x) LOAD_LINE(src, x)
 #define STORE(x,val) (depth == 8 ? dst[x] = (val) >> (16 - depth) : \
                                    AV_WN16A(dst + (x) * 2, (val) >> (16 - depth)))
 
@@ -76,99 +77,181 @@ static void denoise_temporal(uint8_t *src, uint8_t *dst,
     }
 }
 
+/*
+ * The spatial filter is recursive along the lines and along the columns.
+ * Its two directions run as separate passes so that both can be sliced:
+ * the horizontal pass only depends on the source line and writes the
+ * low-passed lines to hline, the vertical and temporal passes only depend
+ * on the column.
+ */
 av_always_inline
-static void denoise_spatial(HQDN3DContext *s,
-                            uint8_t *src, uint8_t *dst,
-                            uint16_t *line_ant, uint16_t *frame_ant,
-                            int w, int h, int sstride, int dstride,
-                            int16_t *spatial, int16_t *temporal, int depth)
+static void denoise_horizontal(uint8_t *src, uint16_t *hline,
+                               int w, int y0, int y1, int sstride,
+                               int16_t *spatial, int depth)
+{
+    long x, y = y0;
+
+    spatial += 256 << LUT_BITS;
+    src     += y0 * sstride;
+    hline   += y0 * w;
+
+    /* The filter is a dependency chain along the line, run four lines at
+     * once to have independent ones. */
+    for (; y + 3 < y1; y += 4, src += 4 * sstride, hline += 4 * w) {
+        uint8_t *src1 = src + sstride, *src2 = src + 2 * sstride, *src3 = src + 3 * sstride;
+        uint32_t p0 = LOAD(0), p1 = LOAD_LINE(src1, 0), p2 = LOAD_LINE(src2, 0), p3 = LOAD_LINE(src3, 0);
+
+        /* first line has no top neighbor */
+        if (!y)
+            p0 = lowpass(p0, p0, spatial, depth);
+        hline[0]     = p0;
+        hline[w]     = p1;
+        hline[2 * w] = p2;
+        hline[3 * w] = p3;
+        for (x = 1; x < w; x++) {
+            hline[x]         = p0 = lowpass(p0, LOAD(x),              spatial, depth);
+            hline[x + w]     = p1 = lowpass(p1, LOAD_LINE(src1, x),   spatial, depth);
+            hline[x + 2 * w] = p2 = lowpass(p2, LOAD_LINE(src2, x),   spatial, depth);
+            hline[x + 3 * w] = p3 = lowpass(p3, LOAD_LINE(src3, x),   spatial, depth);
+        }
+    }
+    for (; y < y1; y++, src += sstride, hline += w) {
+        uint32_t pixel_ant = LOAD(0);
+
+        if (!y)
+            pixel_ant = lowpass(pixel_ant, pixel_ant, spatial, depth);
+        hline[0] = pixel_ant;
+        for (x = 1; x < w; x++)
+            hline[x] = pixel_ant = lowpass(pixel_ant, LOAD(x), spatial, depth);
+    }
+}
+
+av_always_inline
+static void denoise_vertical(uint8_t *dst, const uint16_t *hline,
+                             uint16_t *line_ant, uint16_t *frame_ant,
+                             int w, int h, int x0, int x1, ptrdiff_t dstride,
+                             int16_t *spatial, int16_t *temporal, int depth)
 {
     long x, y;
-    uint32_t pixel_ant;
     uint32_t tmp;
 
     spatial  += 256 << LUT_BITS;
     temporal += 256 << LUT_BITS;
 
-    /* First line has no top neighbor. Only left one for each tmp and
-     * last frame */
-    pixel_ant = LOAD(0);
-    for (x = 0; x < w; x++) {
-        line_ant[x] = tmp = pixel_ant = lowpass(pixel_ant, LOAD(x), spatial, depth);
+    for (x = x0; x < x1; x++) {
+        line_ant[x] = tmp = hline[x];
         frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
         STORE(x, tmp);
     }
 
     for (y = 1; y < h; y++) {
-        src += sstride;
-        dst += dstride;
+        dst       += dstride;
+        hline     += w;
         frame_ant += w;
-        if (s->denoise_row[depth]) {
-            s->denoise_row[depth](src, dst, line_ant, frame_ant, w, spatial, temporal);
-            continue;
-        }
-        pixel_ant = LOAD(0);
-        for (x = 0; x < w-1; x++) {
-            line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
-            pixel_ant = lowpass(pixel_ant, LOAD(x+1), spatial, depth);
+        for (x = x0; x < x1; x++) {
+            line_ant[x] = tmp = lowpass(line_ant[x], hline[x], spatial, depth);
             frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
             STORE(x, tmp);
         }
-        line_ant[x] = tmp = lowpass(line_ant[x], pixel_ant, spatial, depth);
-        frame_ant[x] = tmp = lowpass(frame_ant[x], tmp, temporal, depth);
-        STORE(x, tmp);
     }
 }
 
+#define DEFINE_DENOISE_VERTICAL(depth)                                        \
+static void denoise_vertical_ ## depth(uint8_t *dst, const uint16_t *hline,   \
+                                       uint16_t *line_ant, uint16_t *frame_ant, \
+                                       int w, int h, int x0, int x1,          \
+                                       ptrdiff_t dstride, int16_t *spatial,   \
+                                       int16_t *temporal)                     \
+{                                                                             \
+    denoise_vertical(dst, hline, line_ant, frame_ant, w, h, x0, x1, dstride,  \
+                     spatial, temporal, depth);                               \
+}
+
+DEFINE_DENOISE_VERTICAL(8)
+DEFINE_DENOISE_VERTICAL(9)
+DEFINE_DENOISE_VERTICAL(10)
+DEFINE_DENOISE_VERTICAL(16)
+
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int init;                   ///< frame_prev has to be set from the input
+} ThreadData;
+
 av_always_inline
-static int denoise_depth(HQDN3DContext *s,
-                         uint8_t *src, uint8_t *dst,
-                         uint16_t *line_ant, uint16_t **frame_ant_ptr,
-                         int w, int h, int sstride, int dstride,
-                         int16_t *spatial, int16_t *temporal, int depth)
+static void denoise_rows(HQDN3DContext *s, ThreadData *td,
+                         int jobnr, int nb_jobs, int depth)
 {
-    // FIXME: For 16-bit depth, frame_ant could be a pointer to the previous
-    // filtered frame rather than a separate buffer.
-    long x, y;
-    uint16_t *frame_ant = *frame_ant_ptr;
-    if (!frame_ant) {
-        uint8_t *frame_src = src;
-        *frame_ant_ptr = frame_ant = av_malloc_array(w, h*sizeof(uint16_t));
-        if (!frame_ant)
-            return AVERROR(ENOMEM);
-        for (y = 0; y < h; y++, src += sstride, frame_ant += w)
-            for (x = 0; x < w; x++)
-                frame_ant[x] = LOAD(x);
-        src = frame_src;
-        frame_ant = *frame_ant_ptr;
+    int c;
+
+    for (c = 0; c < 3; c++) {
+        const int w  = AV_CEIL_RSHIFT(td->in->width,  (!!c * s->hsub));
+        const int h  = AV_CEIL_RSHIFT(td->in->height, (!!c * s->vsub));
+        const int y0 = (h *  jobnr     ) / nb_jobs;
+        const int y1 = (h * (jobnr + 1)) / nb_jobs;
+        const int sstride = td->in->linesize[c];
+        const int dstride = td->out->linesize[c];
+        int16_t *spatial  = s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL];
+        int16_t *temporal = s->coefs[c ? CHROMA_TMP     : LUMA_TMP];
+        uint8_t *src = td->in->data[c] + y0 * sstride;
+        uint16_t *frame_ant = s->frame_prev[c] + y0 * w;
+        long x, y;
+
+        if (td->init) {
+            for (y = y0; y < y1; y++, src += sstride, frame_ant += w)
+                for (x = 0; x < w; x++)
+                    frame_ant[x] = LOAD(x);
+            src       = td->in->data[c] + y0 * sstride;
+            frame_ant = s->frame_prev[c] + y0 * w;
+        }
+
+        if (spatial[0])
+            denoise_horizontal(td->in->data[c], s->hline[c], w, y0, y1, sstride,
+                               spatial, depth);
+        else
+            denoise_temporal(src, td->out->data[c] + y0 * dstride, frame_ant,
+                             w, y1 - y0, sstride, dstride, temporal, depth);
     }
+}
 
-    if (spatial[0])
-        denoise_spatial(s, src, dst, line_ant, frame_ant,
-                        w, h, sstride, dstride, spatial, temporal, depth);
-    else
-        denoise_temporal(src, dst, frame_ant,
-                         w, h, sstride, dstride, temporal, depth);
-    emms_c();
-    return 0;
+av_always_inline
+static void denoise_columns(HQDN3DContext *s, ThreadData *td,
+                            int jobnr, int nb_jobs, int depth)
+{
+    int c;
+
+    for (c = 0; c < 3; c++) {
+        const int w  = AV_CEIL_RSHIFT(td->in->width,  (!!c * s->hsub));
+        const int h  = AV_CEIL_RSHIFT(td->in->height, (!!c * s->vsub));
+        /* whole cache lines of the line buffers per job */
+        const int x0 = (w *  jobnr     ) / nb_jobs & ~31;
+        const int x1 = jobnr == nb_jobs - 1 ? w : (w * (jobnr + 1)) / nb_jobs & ~31;
+        int16_t *spatial = s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL];
+
+        if (spatial[0])
+            s->denoise_vertical[depth](td->out->data[c], s->hline[c],
+                                       s->line + c * td->in->width, s->frame_prev[c],
+                                       w, h, x0, x1, td->out->linesize[c],
+                                       spatial, s->coefs[c ? CHROMA_TMP : LUMA_TMP]);
+    }
 }
 
-#define denoise(...)                                                          \
-    do {                                                                      \
-        int ret = AVERROR_BUG;                                                \
-        switch (s->depth) {                                                   \
-            case  8: ret = denoise_depth(__VA_ARGS__,  8); break;             \
-            case  9: ret = denoise_depth(__VA_ARGS__,  9); break;             \
-            case 10: ret = denoise_depth(__VA_ARGS__, 10); break;             \
-            case 16: ret = denoise_depth(__VA_ARGS__, 16); break;             \
-        }                                                                     \
-        if (ret < 0) {                                                        \
-            av_frame_free(&out);                                              \
-            if (!direct)                                                      \
-                av_frame_free(&in);                                           \
-            return ret;                                                       \
-        }                                                                     \
-    } while (0)
+#define DEFINE_SLICE(name)                                                    \
+static int name ## _slice(AVFilterContext *ctx, void *arg,                    \
+                          int jobnr, int nb_jobs)                             \
+{                                                                             \
+    HQDN3DContext *s = ctx->priv;                                             \
+                                                                              \
+    switch (s->depth) {                                                       \
+    case  8: name(s, arg, jobnr, nb_jobs,  8); break;                         \
+    case  9: name(s, arg, jobnr, nb_jobs,  9); break;                         \
+    case 10: name(s, arg, jobnr, nb_jobs, 10); break;                         \
+    case 16: name(s, arg, jobnr, nb_jobs, 16); break;                         \
+    }                                                                         \
+    return 0;                                                                 \
+}
+
+DEFINE_SLICE(denoise_rows)
+DEFINE_SLICE(denoise_columns)
 
 static int16_t *precalc_coefs(double dist25, int depth)
 {
@@ -227,6 +310,9 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->frame_prev[0]);
     av_freep(&s->frame_prev[1]);
     av_freep(&s->frame_prev[2]);
+    av_freep(&s->hline[0]);
+    av_freep(&s->hline[1]);
+    av_freep(&s->hline[2]);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -271,7 +357,8 @@ static int config_input(AVFilterLink *inlink)
     s->vsub  = desc->log2_chroma_h;
     s->depth = desc->comp[0].depth;
 
-    s->line = av_malloc_array(inlink->w, sizeof(*s->line));
+    // the planes are filtered concurrently and need a line each
+    s->line = av_malloc_array(inlink->w, 3 * sizeof(*s->line));
     if (!s->line)
         return AVERROR(ENOMEM);
 
@@ -281,9 +368,21 @@ static int config_input(AVFilterLink *inlink)
             return AVERROR(ENOMEM);
     }
 
+    s->denoise_vertical[8]  = denoise_vertical_8;
+    s->denoise_vertical[9]  = denoise_vertical_9;
+    s->denoise_vertical[10] = denoise_vertical_10;
+    s->denoise_vertical[16] = denoise_vertical_16;
     if (ARCH_X86)
         ff_hqdn3d_init_x86(s);
 
+    for (i = 0; i < 3; i++) {
+        s->hline[i] = av_malloc_array(AV_CEIL_RSHIFT(inlink->w, (!!i * s->hsub)),
+                                      AV_CEIL_RSHIFT(inlink->h, (!!i * s->vsub)) * sizeof(*s->hline[i]));
+        if (!s->hline[i])
+            return AVERROR(ENOMEM);
+    }
+    s->nb_threads = ff_filter_get_nb_threads(inlink->dst);
+
     return 0;
 }
 
@@ -293,8 +392,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     HQDN3DContext *s = ctx->priv;
     AVFilterLink *outlink = ctx->outputs[0];
 
+    ThreadData td = { 0 };
     AVFrame *out;
-    int c, direct = av_frame_is_writable(in) && !ctx->is_disabled;
+    int c, nb_jobs, direct = av_frame_is_writable(in) && !ctx->is_disabled;
 
     if (direct) {
         out = in;
@@ -307,17 +407,28 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
         av_frame_copy_props(out, in);
     }
-
-    for (c = 0; c < 3; c++) {
-        denoise(s, in->data[c], out->data[c],
-                s->line, &s->frame_prev[c],
-                AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
-                AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)),
-                in->linesize[c], out->linesize[c],
-                s->coefs[c ? CHROMA_SPATIAL : LUMA_SPATIAL],
-                s->coefs[c ? CHROMA_TMP     : LUMA_TMP]);
+    td.in  = in;
+    td.out = out;
+
+    if (!s->frame_prev[0]) {
+        for (c = 0; c < 3; c++) {
+            s->frame_prev[c] = av_malloc_array(AV_CEIL_RSHIFT(in->width,  (!!c * s->hsub)),
+                                               AV_CEIL_RSHIFT(in->height, (!!c * s->vsub)) * sizeof(uint16_t));
+            if (!s->frame_prev[c]) {
+                av_frame_free(&out);
+                if (!direct)
+                    av_frame_free(&in);
+                return AVERROR(ENOMEM);
+            }
+        }
+        td.init = 1;
     }
 
+    nb_jobs = FFMIN(AV_CEIL_RSHIFT(in->height, s->vsub), s->nb_threads);
+    ctx->internal->execute(ctx, denoise_rows_slice,    &td, NULL, nb_jobs);
+    ctx->internal->execute(ctx, denoise_columns_slice, &td, NULL, nb_jobs);
+    emms_c();
+
     if (ctx->is_disabled) {
         av_frame_free(&out);
         return ff_filter_frame(outlink, in);
@@ -370,5 +481,5 @@ AVFilter ff_vf_hqdn3d = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_hqdn3d_inputs,
     .outputs       = avfilter_vf_hqdn3d_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL | AVFILTER_FLAG_SLICE_THREADS,
 };
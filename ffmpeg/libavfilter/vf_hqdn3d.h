@@ -33,10 +33,19 @@ typedef struct HQDN3DContext {
     int16_t *coefs[4];
     uint16_t *line;
     uint16_t *frame_prev[3];
+    uint16_t *hline[3];         ///< horizontally filtered planes
     double strength[4];
     int hsub, vsub;
     int depth;
-    void (*denoise_row[17])(uint8_t *src, uint8_t *dst, uint16_t *line_ant, uint16_t *frame_ant, ptrdiff_t w, int16_t *spatial, int16_t *temporal);
+    int nb_threads;
+    /**
+     * Vertical and temporal passes over the columns [x0, x1) of a plane, one
+     * per bit depth. spatial and temporal point to the start of the tables.
+     */
+    void (*denoise_vertical[17])(uint8_t *dst, const uint16_t *hline,
+                                 uint16_t *line_ant, uint16_t *frame_ant,
+                                 int w, int h, int x0, int x1, ptrdiff_t dstride,
+                                 int16_t *spatial, int16_t *temporal);
 } HQDN3DContext;
 
 #define LUMA_SPATIAL   0
@@ -39,6 +39,7 @@
 #include "dualinput.h"
 #include "drawutils.h"
 #include "video.h"
+#include "vf_overlay.h"
 
 static const char *const var_names[] = {
     "main_w",    "W", ///< width  of the main    video
@@ -55,21 +56,6 @@ static const char *const var_names[] = {
     NULL
 };
 
-enum var_name {
-    VAR_MAIN_W,    VAR_MW,
-    VAR_MAIN_H,    VAR_MH,
-    VAR_OVERLAY_W, VAR_OW,
-    VAR_OVERLAY_H, VAR_OH,
-    VAR_HSUB,
-    VAR_VSUB,
-    VAR_X,
-    VAR_Y,
-    VAR_N,
-    VAR_POS,
-    VAR_T,
-    VAR_VARS_NB
-};
-
 enum EOFAction {
     EOF_ACTION_REPEAT,
     EOF_ACTION_ENDALL,
@@ -92,51 +78,10 @@ static const char * const eof_action_str[] = {
 #define U 1
 #define V 2
 
-enum EvalMode {
-    EVAL_MODE_INIT,
-    EVAL_MODE_FRAME,
-    EVAL_MODE_NB
-};
-
-enum OverlayFormat {
-    OVERLAY_FORMAT_YUV420,
-    OVERLAY_FORMAT_YUV422,
-    OVERLAY_FORMAT_YUV444,
-    OVERLAY_FORMAT_RGB,
-    OVERLAY_FORMAT_GBRP,
-    OVERLAY_FORMAT_AUTO,
-    OVERLAY_FORMAT_NB
-};
-
-typedef struct OverlayContext {
-    const AVClass *class;
-    int x, y;                   ///< position of overlaid picture
-
-    uint8_t main_is_packed_rgb;
-    uint8_t main_rgba_map[4];
-    uint8_t main_has_alpha;
-    uint8_t overlay_is_packed_rgb;
-    uint8_t overlay_rgba_map[4];
-    uint8_t overlay_has_alpha;
-    int format;                 ///< OverlayFormat
-    int eval_mode;              ///< EvalMode
-
-    FFDualInputContext dinput;
-
-    int main_pix_step[4];       ///< steps per pixel for each plane of the main output
-    int overlay_pix_step[4];    ///< steps per pixel for each plane of the overlay
-    int hsub, vsub;             ///< chroma subsampling values
-    const AVPixFmtDescriptor *main_desc; ///< format descriptor for main input
-
-    double var_values[VAR_VARS_NB];
-    char *x_expr, *y_expr;
-
-    int eof_action;             ///< action to take on EOF from source
-
-    AVExpr *x_pexpr, *y_pexpr;
-
-    void (*blend_image)(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y);
-} OverlayContext;
+typedef struct ThreadData {
+    AVFrame *dst;
+    const AVFrame *src;
+} ThreadData;
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
@@ -410,13 +355,31 @@ static int config_output(AVFilterLink *outlink)
 // ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)) is a faster version of: 255 * (x + y)
 #define UNPREMULTIPLY_ALPHA(x, y) ((((x) << 16) - ((x) << 9) + (x)) / ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)))
 
+/**
+ * Rows of the overlay, in lines of the overlay picture, which are blended
+ * by job jobnr. The boundaries are multiples of 1 << vsub, so that the jobs
+ * never share a line of a subsampled plane.
+ */
+static void slice_rows(int y, int src_h, int dst_h, int vsub,
+                       int jobnr, int nb_jobs, int *slice_start, int *slice_end)
+{
+    int start = FFMAX(-y, 0);
+    int n     = FFMAX(FFMIN(-y + dst_h, src_h) - start, 0);
+    int mask  = (1 << vsub) - 1;
+
+    *slice_start = start + ((n * jobnr / nb_jobs) & ~mask);
+    *slice_end   = jobnr + 1 < nb_jobs ? start + ((n * (jobnr + 1) / nb_jobs) & ~mask)
+                                       : start + n;
+}
+
 /**
  * Blend image in src to destination buffer dst at position (x, y).
  */
 
-static void blend_image_packed_rgb(AVFilterContext *ctx,
-                                   AVFrame *dst, const AVFrame *src,
-                                   int main_has_alpha, int x, int y)
+static av_always_inline void blend_slice_packed_rgb(AVFilterContext *ctx,
+                                                    AVFrame *dst, const AVFrame *src,
+                                                    int main_has_alpha, int x, int y,
+                                                    int is_straight, int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
     int i, imax, j, jmax;
@@ -437,11 +400,11 @@ static void blend_image_packed_rgb(AVFilterContext *ctx,
     const int sstep = s->overlay_pix_step[0];
     uint8_t *S, *sp, *d, *dp;
 
-    i = FFMAX(-y, 0);
+    slice_rows(y, src_h, dst_h, 0, jobnr, nb_jobs, &i, &imax);
     sp = src->data[0] + i     * src->linesize[0];
     dp = dst->data[0] + (y+i) * dst->linesize[0];
 
-    for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
+    for (; i < imax; i++) {
         j = FFMAX(-x, 0);
         S = sp + j     * sstep;
         d = dp + (x+j) * dstep;
@@ -467,9 +430,16 @@ static void blend_image_packed_rgb(AVFilterContext *ctx,
             default:
                 // main_value = main_value * (1 - alpha) + overlay_value * alpha
                 // since alpha is in the range 0-255, the result must divided by 255
-                d[dr] = FAST_DIV255(d[dr] * (255 - alpha) + S[sr] * alpha);
-                d[dg] = FAST_DIV255(d[dg] * (255 - alpha) + S[sg] * alpha);
-                d[db] = FAST_DIV255(d[db] * (255 - alpha) + S[sb] * alpha);
+                if (is_straight) {
+                    d[dr] = FAST_DIV255(d[dr] * (255 - alpha) + S[sr] * alpha);
+                    d[dg] = FAST_DIV255(d[dg] * (255 - alpha) + S[sg] * alpha);
+                    d[db] = FAST_DIV255(d[db] * (255 - alpha) + S[sb] * alpha);
+                } else {
+                    // the overlay value is already multiplied by alpha
+                    d[dr] = FFMIN(FAST_DIV255(d[dr] * (255 - alpha)) + S[sr], 255);
+                    d[dg] = FFMIN(FAST_DIV255(d[dg] * (255 - alpha)) + S[sg], 255);
+                    d[db] = FFMIN(FAST_DIV255(d[db] * (255 - alpha)) + S[sb], 255);
+                }
             }
             if (main_has_alpha) {
                 switch (alpha) {
@@ -491,6 +461,22 @@ static void blend_image_packed_rgb(AVFilterContext *ctx,
     }
 }
 
+// average alpha for color components, improve quality
+static av_always_inline int subsampled_alpha(const uint8_t *a, ptrdiff_t linesize,
+                                             int hsub, int vsub, int right, int below)
+{
+    int alpha_v, alpha_h;
+
+    if (hsub && vsub && right && below)
+        return (a[0] + a[linesize] + a[1] + a[linesize + 1]) >> 2;
+    if (hsub || vsub) {
+        alpha_h = hsub && right ? (a[0] + a[1])        >> 1 : a[0];
+        alpha_v = vsub && below ? (a[0] + a[linesize]) >> 1 : a[0];
+        return (alpha_v + alpha_h) >> 1;
+    }
+    return a[0];
+}
+
 static av_always_inline void blend_plane(AVFilterContext *ctx,
                                          AVFrame *dst, const AVFrame *src,
                                          int src_w, int src_h,
@@ -500,88 +486,100 @@ static av_always_inline void blend_plane(AVFilterContext *ctx,
                                          int main_has_alpha,
                                          int dst_plane,
                                          int dst_offset,
-                                         int dst_step)
+                                         int dst_step,
+                                         int is_straight,
+                                         int is_chroma,
+                                         int slice_start,
+                                         int slice_end)
 {
+    OverlayContext *octx = ctx->priv;
     int src_wp = AV_CEIL_RSHIFT(src_w, hsub);
     int src_hp = AV_CEIL_RSHIFT(src_h, vsub);
     int dst_wp = AV_CEIL_RSHIFT(dst_w, hsub);
     int dst_hp = AV_CEIL_RSHIFT(dst_h, vsub);
     int yp = y>>vsub;
     int xp = x>>hsub;
-    uint8_t *s, *sp, *d, *dp, *a, *ap;
+    uint8_t *s, *sp, *d, *dp, *a, *ap, *da = NULL, *dap = NULL;
     int jmax, j, k, kmax;
 
-    j = FFMAX(-yp, 0);
+    j    = slice_start >> vsub;
+    jmax = AV_CEIL_RSHIFT(slice_end, vsub);
     sp = src->data[i] + j         * src->linesize[i];
     dp = dst->data[dst_plane]
                       + (yp+j)    * dst->linesize[dst_plane]
                       + dst_offset;
     ap = src->data[3] + (j<<vsub) * src->linesize[3];
+    if (main_has_alpha)
+        dap = dst->data[3] + ((yp+j) << vsub) * dst->linesize[3];
+
+    for (; j < jmax; j++) {
+        int below = j+1 < src_hp;
 
-    for (jmax = FFMIN(-yp + dst_hp, src_hp); j < jmax; j++) {
         k = FFMAX(-xp, 0);
+        kmax = FFMIN(-xp + dst_wp, src_wp);
         d = dp + (xp+k) * dst_step;
         s = sp + k;
         a = ap + (k<<hsub);
+        if (main_has_alpha)
+            da = dap + ((xp+k) << hsub);
+
+        // the last line of a vertically subsampled plane is averaged differently
+        if (!main_has_alpha && octx->blend_row[i] && (!vsub || below)) {
+            int n = octx->blend_row[i](d, s, a, (hsub ? FFMIN(kmax, src_wp - 1) : kmax) - k,
+                                       src->linesize[3]);
+            k += n;
+            d += n;
+            s += n;
+            a += n << hsub;
+        }
+
+        for (; k < kmax; k++) {
+            int alpha = subsampled_alpha(a, src->linesize[3], hsub, vsub,
+                                         k+1 < src_wp, below);
 
-        for (kmax = FFMIN(-xp + dst_wp, src_wp); k < kmax; k++) {
-            int alpha_v, alpha_h, alpha;
-
-            // average alpha for color components, improve quality
-            if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {
-                alpha = (a[0] + a[src->linesize[3]] +
-                         a[1] + a[src->linesize[3]+1]) >> 2;
-            } else if (hsub || vsub) {
-                alpha_h = hsub && k+1 < src_wp ?
-                    (a[0] + a[1]) >> 1 : a[0];
-                alpha_v = vsub && j+1 < src_hp ?
-                    (a[0] + a[src->linesize[3]]) >> 1 : a[0];
-                alpha = (alpha_v + alpha_h) >> 1;
-            } else
-                alpha = a[0];
             // if the main channel has an alpha channel, alpha has to be calculated
             // to create an un-premultiplied (straight) alpha value
             if (main_has_alpha && alpha != 0 && alpha != 255) {
-                // average alpha for color components, improve quality
-                uint8_t alpha_d;
-                if (hsub && vsub && j+1 < src_hp && k+1 < src_wp) {
-                    alpha_d = (d[0] + d[src->linesize[3]] +
-                               d[1] + d[src->linesize[3]+1]) >> 2;
-                } else if (hsub || vsub) {
-                    alpha_h = hsub && k+1 < src_wp ?
-                        (d[0] + d[1]) >> 1 : d[0];
-                    alpha_v = vsub && j+1 < src_hp ?
-                        (d[0] + d[src->linesize[3]]) >> 1 : d[0];
-                    alpha_d = (alpha_v + alpha_h) >> 1;
-                } else
-                    alpha_d = d[0];
+                int alpha_d = subsampled_alpha(da, dst->linesize[3], hsub, vsub,
+                                               xp+k+1 < dst_wp, yp+j+1 < dst_hp);
                 alpha = UNPREMULTIPLY_ALPHA(alpha, alpha_d);
             }
-            *d = FAST_DIV255(*d * (255 - alpha) + *s * alpha);
+            if (is_straight)
+                *d = FAST_DIV255(*d * (255 - alpha) + *s * alpha);
+            else if (is_chroma)
+                // premultiplied chroma is centered on 128
+                *d = av_clip_uint8(FAST_DIV255((*d - 128) * (255 - alpha)) + *s);
+            else
+                *d = FFMIN(FAST_DIV255(*d * (255 - alpha)) + *s, 255);
             s++;
             d += dst_step;
             a += 1 << hsub;
+            if (main_has_alpha)
+                da += 1 << hsub;
         }
         dp += dst->linesize[dst_plane];
         sp += src->linesize[i];
         ap += (1 << vsub) * src->linesize[3];
+        if (main_has_alpha)
+            dap += (1 << vsub) * dst->linesize[3];
     }
 }
 
 static inline void alpha_composite(const AVFrame *src, const AVFrame *dst,
                                    int src_w, int src_h,
                                    int dst_w, int dst_h,
-                                   int x, int y)
+                                   int x, int y,
+                                   int slice_start, int slice_end)
 {
     uint8_t alpha;          ///< the amount of overlay to blend on to main
     uint8_t *s, *sa, *d, *da;
     int i, imax, j, jmax;
 
-    i = FFMAX(-y, 0);
+    i = slice_start;
     sa = src->data[3] + i     * src->linesize[3];
     da = dst->data[3] + (y+i) * dst->linesize[3];
 
-    for (imax = FFMIN(-y + dst_h, src_h); i < imax; i++) {
+    for (imax = slice_end; i < imax; i++) {
         j = FFMAX(-x, 0);
         s = sa + j;
         d = da + x+j;
@@ -610,100 +608,112 @@ static inline void alpha_composite(const AVFrame *src, const AVFrame *dst,
     }
 }
 
-static av_always_inline void blend_image_yuv(AVFilterContext *ctx,
+/* The color planes are blended first, as they read the alpha of the main
+ * picture from before the composition. */
+static av_always_inline void blend_slice_yuv(AVFilterContext *ctx,
                                              AVFrame *dst, const AVFrame *src,
                                              int hsub, int vsub,
                                              int main_has_alpha,
-                                             int x, int y)
+                                             int is_straight,
+                                             int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
     const int src_w = src->width;
     const int src_h = src->height;
     const int dst_w = dst->width;
     const int dst_h = dst->height;
+    int slice_start, slice_end;
+
+    slice_rows(s->y, src_h, dst_h, vsub, jobnr, nb_jobs, &slice_start, &slice_end);
+
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0, s->x, s->y, main_has_alpha,
+                s->main_desc->comp[0].plane, s->main_desc->comp[0].offset, s->main_desc->comp[0].step,
+                is_straight, 0, slice_start, slice_end);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, s->x, s->y, main_has_alpha,
+                s->main_desc->comp[1].plane, s->main_desc->comp[1].offset, s->main_desc->comp[1].step,
+                is_straight, 1, slice_start, slice_end);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, s->x, s->y, main_has_alpha,
+                s->main_desc->comp[2].plane, s->main_desc->comp[2].offset, s->main_desc->comp[2].step,
+                is_straight, 1, slice_start, slice_end);
 
     if (main_has_alpha)
-        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, x, y);
-
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0, x, y, main_has_alpha,
-                s->main_desc->comp[0].plane, s->main_desc->comp[0].offset, s->main_desc->comp[0].step);
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, x, y, main_has_alpha,
-                s->main_desc->comp[1].plane, s->main_desc->comp[1].offset, s->main_desc->comp[1].step);
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, x, y, main_has_alpha,
-                s->main_desc->comp[2].plane, s->main_desc->comp[2].offset, s->main_desc->comp[2].step);
+        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, s->x, s->y, slice_start, slice_end);
 }
 
-static av_always_inline void blend_image_planar_rgb(AVFilterContext *ctx,
+static av_always_inline void blend_slice_planar_rgb(AVFilterContext *ctx,
                                                     AVFrame *dst, const AVFrame *src,
                                                     int hsub, int vsub,
                                                     int main_has_alpha,
-                                                    int x, int y)
+                                                    int is_straight,
+                                                    int jobnr, int nb_jobs)
 {
     OverlayContext *s = ctx->priv;
     const int src_w = src->width;
     const int src_h = src->height;
     const int dst_w = dst->width;
     const int dst_h = dst->height;
+    int slice_start, slice_end;
 
-    if (main_has_alpha)
-        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, x, y);
-
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0, x, y, main_has_alpha,
-                s->main_desc->comp[1].plane, s->main_desc->comp[1].offset, s->main_desc->comp[1].step);
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, x, y, main_has_alpha,
-                s->main_desc->comp[2].plane, s->main_desc->comp[2].offset, s->main_desc->comp[2].step);
-    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, x, y, main_has_alpha,
-                s->main_desc->comp[0].plane, s->main_desc->comp[0].offset, s->main_desc->comp[0].step);
-}
-
-static void blend_image_yuv420(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_yuv(ctx, dst, src, 1, 1, 0, x, y);
-}
+    slice_rows(s->y, src_h, dst_h, vsub, jobnr, nb_jobs, &slice_start, &slice_end);
 
-static void blend_image_yuva420(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_yuv(ctx, dst, src, 1, 1, 1, x, y);
-}
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 0, 0,       0, s->x, s->y, main_has_alpha,
+                s->main_desc->comp[1].plane, s->main_desc->comp[1].offset, s->main_desc->comp[1].step,
+                is_straight, 0, slice_start, slice_end);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 1, hsub, vsub, s->x, s->y, main_has_alpha,
+                s->main_desc->comp[2].plane, s->main_desc->comp[2].offset, s->main_desc->comp[2].step,
+                is_straight, 0, slice_start, slice_end);
+    blend_plane(ctx, dst, src, src_w, src_h, dst_w, dst_h, 2, hsub, vsub, s->x, s->y, main_has_alpha,
+                s->main_desc->comp[0].plane, s->main_desc->comp[0].offset, s->main_desc->comp[0].step,
+                is_straight, 0, slice_start, slice_end);
 
-static void blend_image_yuv422(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_yuv(ctx, dst, src, 1, 0, 0, x, y);
+    if (main_has_alpha)
+        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, s->x, s->y, slice_start, slice_end);
 }
 
-static void blend_image_yuva422(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_yuv(ctx, dst, src, 1, 0, 1, x, y);
+#define DEFINE_BLEND_SLICE(name, blend, hsub, vsub, main_has_alpha)                          \
+static int blend_slice_ ## name(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)    \
+{                                                                                            \
+    OverlayContext *s = ctx->priv;                                                           \
+    ThreadData *td = arg;                                                                    \
+                                                                                             \
+    if (s->alpha_format == ALPHA_FORMAT_STRAIGHT)                                            \
+        blend(ctx, td->dst, td->src, hsub, vsub, main_has_alpha, 1, jobnr, nb_jobs);         \
+    else                                                                                     \
+        blend(ctx, td->dst, td->src, hsub, vsub, main_has_alpha, 0, jobnr, nb_jobs);         \
+    return 0;                                                                                \
 }
 
-static void blend_image_yuv444(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_yuv(ctx, dst, src, 0, 0, 0, x, y);
-}
+DEFINE_BLEND_SLICE(yuv420,  blend_slice_yuv,        1, 1, 0)
+DEFINE_BLEND_SLICE(yuva420, blend_slice_yuv,        1, 1, 1)
+DEFINE_BLEND_SLICE(yuv422,  blend_slice_yuv,        1, 0, 0)
+DEFINE_BLEND_SLICE(yuva422, blend_slice_yuv,        1, 0, 1)
+DEFINE_BLEND_SLICE(yuv444,  blend_slice_yuv,        0, 0, 0)
+DEFINE_BLEND_SLICE(yuva444, blend_slice_yuv,        0, 0, 1)
+DEFINE_BLEND_SLICE(gbrp,    blend_slice_planar_rgb, 0, 0, 0)
+DEFINE_BLEND_SLICE(gbrap,   blend_slice_planar_rgb, 0, 0, 1)
 
-static void blend_image_yuva444(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
+static int blend_slice_rgb(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    blend_image_yuv(ctx, dst, src, 0, 0, 1, x, y);
-}
-
-static void blend_image_gbrp(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_planar_rgb(ctx, dst, src, 0, 0, 0, x, y);
-}
+    OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
 
-static void blend_image_gbrap(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_planar_rgb(ctx, dst, src, 0, 0, 1, x, y);
+    if (s->alpha_format == ALPHA_FORMAT_STRAIGHT)
+        blend_slice_packed_rgb(ctx, td->dst, td->src, 0, s->x, s->y, 1, jobnr, nb_jobs);
+    else
+        blend_slice_packed_rgb(ctx, td->dst, td->src, 0, s->x, s->y, 0, jobnr, nb_jobs);
+    return 0;
 }
 
-static void blend_image_rgb(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
+static int blend_slice_rgba(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
-    blend_image_packed_rgb(ctx, dst, src, 0, x, y);
-}
+    OverlayContext *s = ctx->priv;
+    ThreadData *td = arg;
 
-static void blend_image_rgba(AVFilterContext *ctx, AVFrame *dst, const AVFrame *src, int x, int y)
-{
-    blend_image_packed_rgb(ctx, dst, src, 1, x, y);
+    if (s->alpha_format == ALPHA_FORMAT_STRAIGHT)
+        blend_slice_packed_rgb(ctx, td->dst, td->src, 1, s->x, s->y, 1, jobnr, nb_jobs);
+    else
+        blend_slice_packed_rgb(ctx, td->dst, td->src, 1, s->x, s->y, 0, jobnr, nb_jobs);
+    return 0;
 }
 
 static int config_input_main(AVFilterLink *inlink)
@@ -723,39 +733,39 @@ static int config_input_main(AVFilterLink *inlink)
     s->main_has_alpha = ff_fmt_is_in(inlink->format, alpha_pix_fmts);
     switch (s->format) {
     case OVERLAY_FORMAT_YUV420:
-        s->blend_image = s->main_has_alpha ? blend_image_yuva420 : blend_image_yuv420;
+        s->blend_slice = s->main_has_alpha ? blend_slice_yuva420 : blend_slice_yuv420;
         break;
     case OVERLAY_FORMAT_YUV422:
-        s->blend_image = s->main_has_alpha ? blend_image_yuva422 : blend_image_yuv422;
+        s->blend_slice = s->main_has_alpha ? blend_slice_yuva422 : blend_slice_yuv422;
         break;
     case OVERLAY_FORMAT_YUV444:
-        s->blend_image = s->main_has_alpha ? blend_image_yuva444 : blend_image_yuv444;
+        s->blend_slice = s->main_has_alpha ? blend_slice_yuva444 : blend_slice_yuv444;
         break;
     case OVERLAY_FORMAT_RGB:
-        s->blend_image = s->main_has_alpha ? blend_image_rgba : blend_image_rgb;
+        s->blend_slice = s->main_has_alpha ? blend_slice_rgba : blend_slice_rgb;
         break;
     case OVERLAY_FORMAT_GBRP:
-        s->blend_image = s->main_has_alpha ? blend_image_gbrap : blend_image_gbrp;
+        s->blend_slice = s->main_has_alpha ? blend_slice_gbrap : blend_slice_gbrp;
         break;
     case OVERLAY_FORMAT_AUTO:
         switch (inlink->format) {
         case AV_PIX_FMT_YUVA420P:
-            s->blend_image = blend_image_yuva420;
+            s->blend_slice = blend_slice_yuva420;
             break;
         case AV_PIX_FMT_YUVA422P:
-            s->blend_image = blend_image_yuva422;
+            s->blend_slice = blend_slice_yuva422;
             break;
         case AV_PIX_FMT_YUVA444P:
-            s->blend_image = blend_image_yuva444;
+            s->blend_slice = blend_slice_yuva444;
             break;
         case AV_PIX_FMT_ARGB:
         case AV_PIX_FMT_RGBA:
         case AV_PIX_FMT_BGRA:
         case AV_PIX_FMT_ABGR:
-            s->blend_image = blend_image_rgba;
+            s->blend_slice = blend_slice_rgba;
             break;
         case AV_PIX_FMT_GBRAP:
-            s->blend_image = blend_image_gbrap;
+            s->blend_slice = blend_slice_gbrap;
             break;
         default:
             av_assert0(0);
@@ -763,6 +773,10 @@ static int config_input_main(AVFilterLink *inlink)
         }
         break;
     }
+
+    memset(s->blend_row, 0, sizeof(s->blend_row));
+    if (ARCH_X86)
+        ff_overlay_init_x86(s);
     return 0;
 }
 
@@ -793,8 +807,13 @@ static AVFrame *do_blend(AVFilterContext *ctx, AVFrame *mainpic,
     }
 
     if (s->x < mainpic->width  && s->x + second->width  >= 0 ||
-        s->y < mainpic->height && s->y + second->height >= 0)
-        s->blend_image(ctx, mainpic, second, s->x, s->y);
+        s->y < mainpic->height && s->y + second->height >= 0) {
+        ThreadData td = { .dst = mainpic, .src = second };
+        int h = FFMIN(s->y + second->height, mainpic->height) - FFMAX(s->y, 0);
+
+        ctx->internal->execute(ctx, s->blend_slice, &td, NULL,
+                               av_clip(h >> s->vsub, 1, ff_filter_get_nb_threads(ctx)));
+    }
     return mainpic;
 }
 
@@ -852,6 +871,9 @@ static const AVOption overlay_options[] = {
         { "gbrp",   "", 0, AV_OPT_TYPE_CONST, {.i64=OVERLAY_FORMAT_GBRP},   .flags = FLAGS, .unit = "format" },
         { "auto",   "", 0, AV_OPT_TYPE_CONST, {.i64=OVERLAY_FORMAT_AUTO},   .flags = FLAGS, .unit = "format" },
     { "repeatlast", "repeat overlay of the last overlay frame", OFFSET(dinput.repeatlast), AV_OPT_TYPE_BOOL, {.i64=1}, 0, 1, FLAGS },
+    { "alpha", "set the alpha format of the overlay", OFFSET(alpha_format), AV_OPT_TYPE_INT, {.i64=ALPHA_FORMAT_STRAIGHT}, 0, ALPHA_FORMAT_NB-1, FLAGS, "alpha_format" },
+        { "straight",      "", 0, AV_OPT_TYPE_CONST, {.i64=ALPHA_FORMAT_STRAIGHT},      .flags = FLAGS, .unit = "alpha_format" },
+        { "premultiplied", "", 0, AV_OPT_TYPE_CONST, {.i64=ALPHA_FORMAT_PREMULTIPLIED}, .flags = FLAGS, .unit = "alpha_format" },
     { NULL }
 };
 
@@ -895,5 +917,6 @@ AVFilter ff_vf_overlay = {
     .process_command = process_command,
     .inputs        = avfilter_vf_overlay_inputs,
     .outputs       = avfilter_vf_overlay_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -36,14 +36,24 @@
 #include "psnr.h"
 #include "video.h"
 
+enum StatsFormat {
+    STATS_FORMAT_TEXT,
+    STATS_FORMAT_JSON,
+    STATS_FORMAT_NB
+};
+
 typedef struct PSNRContext {
     const AVClass *class;
     FFDualInputContext dinput;
     double mse, min_mse, max_mse, mse_comp[4];
-    uint64_t nb_frames;
+    uint64_t nb_frames;     ///< number of scored frames
+    uint64_t frame_num;     ///< number of compared frame pairs, scored or not
     FILE *stats_file;
     char *stats_file_str;
     int stats_version;
+    int stats_format;
+    int frame_subsample;
+    int row_subsample;
     int stats_header_written;
     int stats_add_max;
     int max[4], average_max;
@@ -54,9 +64,15 @@ typedef struct PSNRContext {
     int planewidth[4];
     int planeheight[4];
     double planeweight[4];
+    uint64_t (*sse)[4];     ///< squared error sums of each job
+    int nb_threads;
     PSNRDSPContext dsp;
 } PSNRContext;
 
+typedef struct ThreadData {
+    const AVFrame *main, *ref;
+} ThreadData;
+
 #define OFFSET(x) offsetof(PSNRContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 
@@ -65,6 +81,11 @@ static const AVOption psnr_options[] = {
     {"f",          "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
     {"stats_version", "Set the format version for the stats file.",               OFFSET(stats_version),  AV_OPT_TYPE_INT,    {.i64=1},    1, 2, FLAGS },
     {"output_max",  "Add raw stats (max values) to the output log.",            OFFSET(stats_add_max), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS},
+    {"stats_format", "Set the format of the stats file", OFFSET(stats_format), AV_OPT_TYPE_INT, {.i64=STATS_FORMAT_TEXT}, 0, STATS_FORMAT_NB-1, FLAGS, "stats_format" },
+        {"text", "key:value pairs",           0, AV_OPT_TYPE_CONST, {.i64=STATS_FORMAT_TEXT}, 0, 0, FLAGS, "stats_format" },
+        {"json", "one JSON object per line",  0, AV_OPT_TYPE_CONST, {.i64=STATS_FORMAT_JSON}, 0, 0, FLAGS, "stats_format" },
+    {"frame_subsample", "Score one frame out of every N", OFFSET(frame_subsample), AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS },
+    {"row_subsample",   "Score one line out of every N",  OFFSET(row_subsample),   AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -104,27 +125,63 @@ static uint64_t sse_line_16bit(const uint8_t *_main_line, const uint8_t *_ref_li
     return m2;
 }
 
-static inline
-void compute_images_mse(PSNRContext *s,
-                        const uint8_t *main_data[4], const int main_linesizes[4],
-                        const uint8_t *ref_data[4], const int ref_linesizes[4],
-                        int w, int h, double mse[4])
+/*
+ * Each job sums the squared errors of its slice of lines. The sums are
+ * integers, so adding up the slices gives the same result for any number
+ * of jobs.
+ */
+static int sse_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    PSNRContext *s = ctx->priv;
+    ThreadData *td = arg;
+    uint64_t *sse = s->sse[jobnr];
     int i, c;
 
     for (c = 0; c < s->nb_components; c++) {
         const int outw = s->planewidth[c];
         const int outh = s->planeheight[c];
-        const uint8_t *main_line = main_data[c];
-        const uint8_t *ref_line = ref_data[c];
-        const int ref_linesize = ref_linesizes[c];
-        const int main_linesize = main_linesizes[c];
+        const int ref_linesize = td->ref->linesize[c];
+        const int main_linesize = td->main->linesize[c];
+        const int slice_start = (outh *  jobnr     ) / nb_jobs;
+        const int slice_end   = (outh * (jobnr + 1)) / nb_jobs;
+        const uint8_t *main_line;
+        const uint8_t *ref_line;
         uint64_t m = 0;
-        for (i = 0; i < outh; i++) {
+
+        /* first scored line of the slice */
+        i = (slice_start + s->row_subsample - 1) / s->row_subsample * s->row_subsample;
+        main_line = td->main->data[c] + i * main_linesize;
+        ref_line  = td->ref->data[c]  + i * ref_linesize;
+        for (; i < slice_end; i += s->row_subsample) {
             m += s->dsp.sse_line(main_line, ref_line, outw);
-            ref_line += ref_linesize;
-            main_line += main_linesize;
+            ref_line  += s->row_subsample * ref_linesize;
+            main_line += s->row_subsample * main_linesize;
         }
+        sse[c] = m;
+    }
+    return 0;
+}
+
+static void compute_images_mse(AVFilterContext *ctx,
+                               const AVFrame *main, const AVFrame *ref,
+                               double mse[4])
+{
+    PSNRContext *s = ctx->priv;
+    const int nb_jobs = FFMIN(s->planeheight[0], s->nb_threads);
+    ThreadData td;
+    int i, c;
+
+    td.main = main;
+    td.ref  = ref;
+    ctx->internal->execute(ctx, sse_slice, &td, NULL, nb_jobs);
+
+    for (c = 0; c < s->nb_components; c++) {
+        const int outw = s->planewidth[c];
+        const int outh = (s->planeheight[c] + s->row_subsample - 1) / s->row_subsample;
+        uint64_t m = 0;
+
+        for (i = 0; i < nb_jobs; i++)
+            m += s->sse[i][c];
         mse[c] = m / (double)(outw * outh);
     }
 }
@@ -142,6 +199,18 @@ static void set_meta(AVDictionary **metadata, const char *key, char comp, float
     }
 }
 
+static void print_json_number(FILE *f, const char *key, char comp, double d)
+{
+    if (comp)
+        fprintf(f, ",\"%s%c\":", key, comp);
+    else
+        fprintf(f, ",\"%s\":", key);
+    if (isfinite(d))
+        fprintf(f, "%f", d);
+    else
+        fprintf(f, "null");
+}
+
 static AVFrame *do_psnr(AVFilterContext *ctx, AVFrame *main,
                         const AVFrame *ref)
 {
@@ -150,9 +219,10 @@ static AVFrame *do_psnr(AVFilterContext *ctx, AVFrame *main,
     int j, c;
     AVDictionary **metadata = &main->metadata;
 
-    compute_images_mse(s, (const uint8_t **)main->data, main->linesize,
-                          (const uint8_t **)ref->data, ref->linesize,
-                          main->width, main->height, comp_mse);
+    if (s->frame_num++ % s->frame_subsample)
+        return main;
+
+    compute_images_mse(ctx, main, ref, comp_mse);
 
     for (j = 0; j < s->nb_components; j++)
         mse += comp_mse[j] * s->planeweight[j];
@@ -173,7 +243,34 @@ static AVFrame *do_psnr(AVFilterContext *ctx, AVFrame *main,
     set_meta(metadata, "lavfi.psnr.mse_avg", 0, mse);
     set_meta(metadata, "lavfi.psnr.psnr_avg", 0, get_psnr(mse, 1, s->average_max));
 
-    if (s->stats_file) {
+    if (s->stats_file && s->stats_format == STATS_FORMAT_JSON) {
+        double pts_time = main->pts == AV_NOPTS_VALUE ? NAN :
+                          main->pts * av_q2d(ctx->inputs[0]->time_base);
+
+        fprintf(s->stats_file, "{\"n\":%"PRId64, s->frame_num);
+        print_json_number(s->stats_file, "pts_time", 0, pts_time);
+        print_json_number(s->stats_file, "mse_avg", 0, mse);
+        for (j = 0; j < s->nb_components; j++) {
+            c = s->is_rgb ? s->rgba_map[j] : j;
+            print_json_number(s->stats_file, "mse_", s->comps[j], comp_mse[c]);
+        }
+        print_json_number(s->stats_file, "psnr_avg", 0, get_psnr(mse, 1, s->average_max));
+        for (j = 0; j < s->nb_components; j++) {
+            c = s->is_rgb ? s->rgba_map[j] : j;
+            print_json_number(s->stats_file, "psnr_", s->comps[j],
+                              get_psnr(comp_mse[c], 1, s->max[c]));
+        }
+        if (s->stats_add_max) {
+            print_json_number(s->stats_file, "max_avg", 0, s->average_max);
+            for (j = 0; j < s->nb_components; j++) {
+                c = s->is_rgb ? s->rgba_map[j] : j;
+                print_json_number(s->stats_file, "max_", s->comps[j], s->max[c]);
+            }
+        }
+        fprintf(s->stats_file, "}\n");
+        /* let a quality gate follow the file while the filter runs */
+        fflush(s->stats_file);
+    } else if (s->stats_file) {
         if (s->stats_version == 2 && !s->stats_header_written) {
             fprintf(s->stats_file, "psnr_log_version:2 fields:n");
             fprintf(s->stats_file, ",mse_avg");
@@ -193,7 +290,7 @@ static AVFrame *do_psnr(AVFilterContext *ctx, AVFrame *main,
             fprintf(s->stats_file, "\n");
             s->stats_header_written = 1;
         }
-        fprintf(s->stats_file, "n:%"PRId64" mse_avg:%0.2f ", s->nb_frames, mse);
+        fprintf(s->stats_file, "n:%"PRId64" mse_avg:%0.2f ", s->frame_num, mse);
         for (j = 0; j < s->nb_components; j++) {
             c = s->is_rgb ? s->rgba_map[j] : j;
             fprintf(s->stats_file, "mse_%c:%0.2f ", s->comps[j], comp_mse[c]);
@@ -225,7 +322,8 @@ static av_cold int init(AVFilterContext *ctx)
     s->max_mse = -INFINITY;
 
     if (s->stats_file_str) {
-        if (s->stats_version < 2 && s->stats_add_max) {
+        if (s->stats_format == STATS_FORMAT_TEXT &&
+            s->stats_version < 2 && s->stats_add_max) {
             av_log(ctx, AV_LOG_ERROR,
                 "stats_add_max was specified but stats_version < 2.\n" );
             return AVERROR(EINVAL);
@@ -317,6 +415,11 @@ static int config_input_ref(AVFilterLink *inlink)
     }
     s->average_max = lrint(average_max);
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->sse = av_malloc_array(s->nb_threads, sizeof(*s->sse));
+    if (!s->sse)
+        return AVERROR(ENOMEM);
+
     s->dsp.sse_line = desc->comp[0].depth > 8 ? sse_line_16bit : sse_line_8bit;
     if (ARCH_X86)
         ff_psnr_init_x86(&s->dsp, desc->comp[0].depth);
@@ -379,6 +482,8 @@ static av_cold void uninit(AVFilterContext *ctx)
 
     if (s->stats_file && s->stats_file != stdout)
         fclose(s->stats_file);
+
+    av_freep(&s->sse);
 }
 
 static const AVFilterPad psnr_inputs[] = {
@@ -415,4 +520,5 @@ AVFilter ff_vf_psnr = {
     .priv_class    = &psnr_class,
     .inputs        = psnr_inputs,
     .outputs       = psnr_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
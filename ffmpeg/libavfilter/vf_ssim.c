@@ -45,36 +45,59 @@
 #include "ssim.h"
 #include "video.h"
 
+enum StatsFormat {
+    STATS_FORMAT_TEXT,
+    STATS_FORMAT_JSON,
+    STATS_FORMAT_NB
+};
+
 typedef struct SSIMContext {
     const AVClass *class;
     FFDualInputContext dinput;
     FILE *stats_file;
     char *stats_file_str;
+    int stats_format;
+    int frame_subsample;
+    int row_subsample;
     int nb_components;
     int max;
-    uint64_t nb_frames;
+    uint64_t nb_frames;     ///< number of scored frames
+    uint64_t frame_num;     ///< number of compared frame pairs, scored or not
     double ssim[4], ssim_total;
     char comps[4];
     float coefs[4];
     uint8_t rgba_map[4];
     int planewidth[4];
     int planeheight[4];
-    int *temp;
+    uint8_t *temp;          ///< line sums, one buffer of temp_size bytes per job
+    int temp_size;
+    float *row_ssim;        ///< SSIM of each block row of each plane
+    int row_ssim_stride;
+    int nb_threads;
     int is_rgb;
-    float (*ssim_plane)(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max);
+    void (*ssim_rows)(SSIMDSPContext *dsp,
+                      uint8_t *main, int main_stride,
+                      uint8_t *ref, int ref_stride,
+                      int width, int y0, int y1, int step,
+                      void *temp, int max, float *row_ssim);
     SSIMDSPContext dsp;
 } SSIMContext;
 
+typedef struct ThreadData {
+    const AVFrame *main, *ref;
+} ThreadData;
+
 #define OFFSET(x) offsetof(SSIMContext, x)
 #define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
 
 static const AVOption ssim_options[] = {
     {"stats_file", "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
     {"f",          "Set file where to store per-frame difference information", OFFSET(stats_file_str), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    {"stats_format", "Set the format of the stats file", OFFSET(stats_format), AV_OPT_TYPE_INT, {.i64=STATS_FORMAT_TEXT}, 0, STATS_FORMAT_NB-1, FLAGS, "stats_format" },
+        {"text", "key:value pairs",           0, AV_OPT_TYPE_CONST, {.i64=STATS_FORMAT_TEXT}, 0, 0, FLAGS, "stats_format" },
+        {"json", "one JSON object per line",  0, AV_OPT_TYPE_CONST, {.i64=STATS_FORMAT_JSON}, 0, 0, FLAGS, "stats_format" },
+    {"frame_subsample", "Score one frame out of every N",     OFFSET(frame_subsample), AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS },
+    {"row_subsample",   "Score one block row out of every N", OFFSET(row_subsample),   AV_OPT_TYPE_INT, {.i64=1}, 1, INT_MAX, FLAGS },
     { NULL }
 };
 
@@ -93,6 +116,18 @@ static void set_meta(AVDictionary **metadata, const char *key, char comp, float
     }
 }
 
+static void print_json_number(FILE *f, const char *key, char comp, double d)
+{
+    if (comp)
+        fprintf(f, ",\"%s%c\":", key, comp);
+    else
+        fprintf(f, ",\"%s\":", key);
+    if (isfinite(d))
+        fprintf(f, "%f", d);
+    else
+        fprintf(f, "null");
+}
+
 static void ssim_4x4xn_16bit(const uint8_t *main8, ptrdiff_t main_stride,
                              const uint8_t *ref8, ptrdiff_t ref_stride,
                              int64_t (*sums)[4], int width)
@@ -219,60 +254,106 @@ static float ssim_endn_8bit(const int (*sum0)[4], const int (*sum1)[4], int widt
     return ssim;
 }
 
-static float ssim_plane_16bit(SSIMDSPContext *dsp,
-                              uint8_t *main, int main_stride,
-                              uint8_t *ref, int ref_stride,
-                              int width, int height, void *temp,
-                              int max)
+/*
+ * The SSIM of block row y uses the 4x4 sums of the lines of blocks y - 1
+ * and y. Only the rows y0 <= y < y1 that are a multiple of step away from
+ * the first one are scored, their SSIM is stored in row_ssim[y]. Each slice
+ * starts from its own sums, so slices of rows are independent.
+ */
+static void ssim_rows_16bit(SSIMDSPContext *dsp,
+                            uint8_t *main, int main_stride,
+                            uint8_t *ref, int ref_stride,
+                            int width, int y0, int y1, int step,
+                            void *temp, int max, float *row_ssim)
 {
-    int z = 0, y;
-    float ssim = 0.0;
+    int z = -1, y;
     int64_t (*sum0)[4] = temp;
     int64_t (*sum1)[4] = sum0 + (width >> 2) + 3;
 
     width >>= 2;
-    height >>= 2;
 
-    for (y = 1; y < height; y++) {
-        for (; z <= y; z++) {
+    for (y = y0; y < y1; y++) {
+        if ((y - 1) % step)
+            continue;
+        if (z == y - 1)
             FFSWAP(void*, sum0, sum1);
-            ssim_4x4xn_16bit(&main[4 * z * main_stride], main_stride,
-                             &ref[4 * z * ref_stride], ref_stride,
-                             sum0, width);
-        }
-
-        ssim += ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
+        else
+            ssim_4x4xn_16bit(&main[4 * (y - 1) * main_stride], main_stride,
+                             &ref[4 * (y - 1) * ref_stride], ref_stride,
+                             sum1, width);
+        ssim_4x4xn_16bit(&main[4 * y * main_stride], main_stride,
+                         &ref[4 * y * ref_stride], ref_stride,
+                         sum0, width);
+        z = y;
+
+        row_ssim[y] = ssim_endn_16bit((const int64_t (*)[4])sum0, (const int64_t (*)[4])sum1, width - 1, max);
     }
-
-    return ssim / ((height - 1) * (width - 1));
 }
 
-static float ssim_plane(SSIMDSPContext *dsp,
-                        uint8_t *main, int main_stride,
-                        uint8_t *ref, int ref_stride,
-                        int width, int height, void *temp,
-                        int max)
+static void ssim_rows(SSIMDSPContext *dsp,
+                      uint8_t *main, int main_stride,
+                      uint8_t *ref, int ref_stride,
+                      int width, int y0, int y1, int step,
+                      void *temp, int max, float *row_ssim)
 {
-    int z = 0, y;
-    float ssim = 0.0;
+    int z = -1, y;
     int (*sum0)[4] = temp;
     int (*sum1)[4] = sum0 + (width >> 2) + 3;
 
     width >>= 2;
-    height >>= 2;
 
-    for (y = 1; y < height; y++) {
-        for (; z <= y; z++) {
+    for (y = y0; y < y1; y++) {
+        if ((y - 1) % step)
+            continue;
+        if (z == y - 1)
             FFSWAP(void*, sum0, sum1);
-            dsp->ssim_4x4_line(&main[4 * z * main_stride], main_stride,
-                               &ref[4 * z * ref_stride], ref_stride,
-                               sum0, width);
-        }
+        else
+            dsp->ssim_4x4_line(&main[4 * (y - 1) * main_stride], main_stride,
+                               &ref[4 * (y - 1) * ref_stride], ref_stride,
+                               sum1, width);
+        dsp->ssim_4x4_line(&main[4 * y * main_stride], main_stride,
+                           &ref[4 * y * ref_stride], ref_stride,
+                           sum0, width);
+        z = y;
+
+        row_ssim[y] = dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+    }
+}
 
-        ssim += dsp->ssim_end_line((const int (*)[4])sum0, (const int (*)[4])sum1, width - 1);
+static int ssim_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SSIMContext *s = ctx->priv;
+    ThreadData *td = arg;
+    void *temp = s->temp + jobnr * s->temp_size;
+    int i;
+
+    for (i = 0; i < s->nb_components; i++) {
+        const int rows  = (s->planeheight[i] >> 2) - 1;
+        const int start = 1 + (rows *  jobnr     ) / nb_jobs;
+        const int end   = 1 + (rows * (jobnr + 1)) / nb_jobs;
+
+        s->ssim_rows(&s->dsp, td->main->data[i], td->main->linesize[i],
+                     td->ref->data[i], td->ref->linesize[i],
+                     s->planewidth[i], start, end, s->row_subsample,
+                     temp, s->max, s->row_ssim + i * s->row_ssim_stride);
     }
+    return 0;
+}
+
+/* Sum the rows in order, as a single loop over the plane would, so that
+ * the result does not depend on the number of slices. */
+static float ssim_plane(SSIMContext *s, int plane)
+{
+    const float *row_ssim = s->row_ssim + plane * s->row_ssim_stride;
+    int width  = s->planewidth[plane]  >> 2;
+    int height = s->planeheight[plane] >> 2;
+    float ssim = 0.0;
+    int y, nb_rows = 0;
+
+    for (y = 1; y < height; y += s->row_subsample, nb_rows++)
+        ssim += row_ssim[y];
 
-    return ssim / ((height - 1) * (width - 1));
+    return ssim / (nb_rows * (width - 1));
 }
 
 static double ssim_db(double ssim, double weight)
@@ -286,15 +367,20 @@ static AVFrame *do_ssim(AVFilterContext *ctx, AVFrame *main,
     AVDictionary **metadata = &main->metadata;
     SSIMContext *s = ctx->priv;
     float c[4], ssimv = 0.0;
+    ThreadData td;
     int i;
 
+    if (s->frame_num++ % s->frame_subsample)
+        return main;
     s->nb_frames++;
 
+    td.main = main;
+    td.ref  = ref;
+    ctx->internal->execute(ctx, ssim_slice, &td, NULL,
+                           av_clip((s->planeheight[0] >> 2) - 1, 1, s->nb_threads));
+
     for (i = 0; i < s->nb_components; i++) {
-        c[i] = s->ssim_plane(&s->dsp, main->data[i], main->linesize[i],
-                             ref->data[i], ref->linesize[i],
-                             s->planewidth[i], s->planeheight[i], s->temp,
-                             s->max);
+        c[i] = ssim_plane(s, i);
         ssimv += s->coefs[i] * c[i];
         s->ssim[i] += c[i];
     }
@@ -307,8 +393,23 @@ static AVFrame *do_ssim(AVFilterContext *ctx, AVFrame *main,
     set_meta(metadata, "lavfi.ssim.All", 0, ssimv);
     set_meta(metadata, "lavfi.ssim.dB", 0, ssim_db(ssimv, 1.0));
 
-    if (s->stats_file) {
-        fprintf(s->stats_file, "n:%"PRId64" ", s->nb_frames);
+    if (s->stats_file && s->stats_format == STATS_FORMAT_JSON) {
+        double pts_time = main->pts == AV_NOPTS_VALUE ? NAN :
+                          main->pts * av_q2d(ctx->inputs[0]->time_base);
+
+        fprintf(s->stats_file, "{\"n\":%"PRId64, s->frame_num);
+        print_json_number(s->stats_file, "pts_time", 0, pts_time);
+        for (i = 0; i < s->nb_components; i++) {
+            int cidx = s->is_rgb ? s->rgba_map[i] : i;
+            print_json_number(s->stats_file, "", s->comps[i], c[cidx]);
+        }
+        print_json_number(s->stats_file, "All", 0, ssimv);
+        print_json_number(s->stats_file, "dB", 0, ssim_db(ssimv, 1.0));
+        fprintf(s->stats_file, "}\n");
+        /* let a quality gate follow the file while the filter runs */
+        fflush(s->stats_file);
+    } else if (s->stats_file) {
+        fprintf(s->stats_file, "n:%"PRId64" ", s->frame_num);
 
         for (i = 0; i < s->nb_components; i++) {
             int cidx = s->is_rgb ? s->rgba_map[i] : i;
@@ -402,12 +503,18 @@ static int config_input_ref(AVFilterLink *inlink)
     for (i = 0; i < s->nb_components; i++)
         s->coefs[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
 
-    s->temp = av_malloc_array((2 * inlink->w + 12), sizeof(*s->temp) * (1 + (desc->comp[0].depth > 8)));
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->temp_size  = FFALIGN((2 * inlink->w + 12) * sizeof(int) * (1 + (desc->comp[0].depth > 8)), 64);
+    s->temp = av_malloc_array(s->nb_threads, s->temp_size);
     if (!s->temp)
         return AVERROR(ENOMEM);
+    s->row_ssim_stride = (inlink->h >> 2) + 1;
+    s->row_ssim = av_malloc_array(4 * s->row_ssim_stride, sizeof(*s->row_ssim));
+    if (!s->row_ssim)
+        return AVERROR(ENOMEM);
     s->max = (1 << desc->comp[0].depth) - 1;
 
-    s->ssim_plane = desc->comp[0].depth > 8 ? ssim_plane_16bit : ssim_plane;
+    s->ssim_rows = desc->comp[0].depth > 8 ? ssim_rows_16bit : ssim_rows;
     s->dsp.ssim_4x4_line = ssim_4x4xn_8bit;
     s->dsp.ssim_end_line = ssim_endn_8bit;
     if (ARCH_X86)
@@ -470,6 +577,7 @@ static av_cold void uninit(AVFilterContext *ctx)
         fclose(s->stats_file);
 
     av_freep(&s->temp);
+    av_freep(&s->row_ssim);
 }
 
 static const AVFilterPad ssim_inputs[] = {
@@ -506,4 +614,5 @@ AVFilter ff_vf_ssim = {
     .priv_class    = &ssim_class,
     .inputs        = ssim_inputs,
     .outputs       = ssim_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -48,16 +48,26 @@
 #include "unsharp.h"
 #include "unsharp_opencl.h"
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+} ThreadData;
+
+/**
+ * Filter the lines [slice_start, slice_end) of a plane. Every output line
+ * only depends on the steps_y input lines above and below it, so the
+ * vertical state machine is primed from zero with the 2 * steps_y lines
+ * around the slice and the result is the same as for the whole plane.
+ */
 static void apply_unsharp(      uint8_t *dst, int dst_stride,
                           const uint8_t *src, int src_stride,
-                          int width, int height, UnsharpFilterParam *fp)
+                          int width, int height, UnsharpFilterParam *fp,
+                          uint32_t **sc, int slice_start, int slice_end)
 {
-    uint32_t **sc = fp->sc;
     uint32_t sr[MAX_MATRIX_SIZE - 1], tmp1, tmp2;
 
     int32_t res;
     int x, y, z;
-    const uint8_t *src2 = NULL;  //silence a warning
+    const uint8_t *src2;
     const int amount = fp->amount;
     const int steps_x = fp->steps_x;
     const int steps_y = fp->steps_y;
@@ -65,16 +75,17 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
     const int32_t halfscale = fp->halfscale;
 
     if (!amount) {
-        av_image_copy_plane(dst, dst_stride, src, src_stride, width, height);
+        av_image_copy_plane(dst + slice_start * dst_stride, dst_stride,
+                            src + slice_start * src_stride, src_stride,
+                            width, slice_end - slice_start);
         return;
     }
 
     for (y = 0; y < 2 * steps_y; y++)
         memset(sc[y], 0, sizeof(sc[y][0]) * (width + 2 * steps_x));
 
-    for (y = -steps_y; y < height + steps_y; y++) {
-        if (y < height)
-            src2 = src;
+    for (y = slice_start - steps_y; y < slice_end + steps_y; y++) {
+        src2 = src + av_clip(y, 0, height - 1) * src_stride;
 
         memset(sr, 0, sizeof(sr[0]) * (2 * steps_x - 1));
         for (x = -steps_x; x < width + steps_x; x++) {
@@ -87,27 +98,26 @@ static void apply_unsharp(      uint8_t *dst, int dst_stride,
                 tmp2 = sc[z + 0][x + steps_x] + tmp1; sc[z + 0][x + steps_x] = tmp1;
                 tmp1 = sc[z + 1][x + steps_x] + tmp2; sc[z + 1][x + steps_x] = tmp2;
             }
-            if (x >= steps_x && y >= steps_y) {
-                const uint8_t *srx = src - steps_y * src_stride + x - steps_x;
-                uint8_t *dsx       = dst - steps_y * dst_stride + x - steps_x;
+            if (x >= steps_x && y >= slice_start + steps_y) {
+                const uint8_t *srx = src + (y - steps_y) * src_stride + x - steps_x;
+                uint8_t *dsx       = dst + (y - steps_y) * dst_stride + x - steps_x;
 
                 res = (int32_t)*srx + ((((int32_t) * srx - (int32_t)((tmp1 + halfscale) >> scalebits)) * amount) >> 16);
                 *dsx = av_clip_uint8(res);
             }
         }
-        if (y >= 0) {
-            dst += dst_stride;
-            src += src_stride;
-        }
     }
 }
 
-static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
+static int unsharp_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     AVFilterLink *inlink = ctx->inputs[0];
     UnsharpContext *s = ctx->priv;
-    int i, plane_w[3], plane_h[3];
+    ThreadData *td = arg;
+    int i, z, plane_w[3], plane_h[3];
     UnsharpFilterParam *fp[3];
+    uint32_t *sc[MAX_MATRIX_SIZE - 1];
+
     plane_w[0] = inlink->w;
     plane_w[1] = plane_w[2] = AV_CEIL_RSHIFT(inlink->w, s->hsub);
     plane_h[0] = inlink->h;
@@ -115,11 +125,30 @@ static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
     fp[0] = &s->luma;
     fp[1] = fp[2] = &s->chroma;
     for (i = 0; i < 3; i++) {
-        apply_unsharp(out->data[i], out->linesize[i], in->data[i], in->linesize[i], plane_w[i], plane_h[i], fp[i]);
+        const int slice_start = (plane_h[i] *  jobnr     ) / nb_jobs;
+        const int slice_end   = (plane_h[i] * (jobnr + 1)) / nb_jobs;
+
+        // each job has its own state machine lines
+        for (z = 0; z < 2 * fp[i]->steps_y; z++)
+            sc[z] = fp[i]->sc[z] + jobnr * (plane_w[i] + 2 * fp[i]->steps_x);
+
+        apply_unsharp(td->out->data[i], td->out->linesize[i],
+                      td->in->data[i], td->in->linesize[i],
+                      plane_w[i], plane_h[i], fp[i], sc, slice_start, slice_end);
     }
     return 0;
 }
 
+static int apply_unsharp_c(AVFilterContext *ctx, AVFrame *in, AVFrame *out)
+{
+    UnsharpContext *s = ctx->priv;
+    ThreadData td = { .in = in, .out = out };
+
+    ctx->internal->execute(ctx, unsharp_slice, &td, NULL,
+                           FFMIN(AV_CEIL_RSHIFT(in->height, s->vsub), s->nb_threads));
+    return 0;
+}
+
 static void set_filter_param(UnsharpFilterParam *fp, int msize_x, int msize_y, float amount)
 {
     fp->msize_x = msize_x;
@@ -175,6 +204,7 @@ static int query_formats(AVFilterContext *ctx)
 
 static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const char *effect_type, int width)
 {
+    UnsharpContext *s = ctx->priv;
     int z;
     const char *effect = fp->amount == 0 ? "none" : fp->amount < 0 ? "blur" : "sharpen";
 
@@ -189,7 +219,7 @@ static int init_filter_param(AVFilterContext *ctx, UnsharpFilterParam *fp, const
            effect, effect_type, fp->msize_x, fp->msize_y, fp->amount / 65535.0);
 
     for (z = 0; z < 2 * fp->steps_y; z++)
-        if (!(fp->sc[z] = av_malloc_array(width + 2 * fp->steps_x,
+        if (!(fp->sc[z] = av_malloc_array((width + 2 * fp->steps_x) * s->nb_threads,
                                           sizeof(*(fp->sc[z])))))
             return AVERROR(ENOMEM);
 
@@ -204,6 +234,7 @@ static int config_props(AVFilterLink *link)
 
     s->hsub = desc->log2_chroma_w;
     s->vsub = desc->log2_chroma_h;
+    s->nb_threads = ff_filter_get_nb_threads(link->dst);
 
     ret = init_filter_param(link->dst, &s->luma,   "luma",   link->w);
     if (ret < 0)
@@ -316,5 +347,6 @@ AVFilter ff_vf_unsharp = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_unsharp_inputs,
     .outputs       = avfilter_vf_unsharp_outputs,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
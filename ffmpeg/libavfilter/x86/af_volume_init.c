@@ -0,0 +1,196 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Fixed-point volume scaling, SSE2, SSE4.1, AVX and AVX2 intrinsics
+ *
+ * The results are the same as those of the C code. Float and double
+ * volume scaling goes through AVFloatDSPContext.
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavfilter/af_volume.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_SSE4
+#include <smmintrin.h>
+#endif
+#if HAVE_INTRINSICS_AVX || HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+#define LOAD(p)     _mm_loadu_si128((const __m128i *)(p))
+#define STORE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+
+/*
+ * s16 with volume < 0x10000: the product fits in 32 bits. pmulhw treats
+ * volumes of 0x8000 and above as negative, which is made up for by adding
+ * the sample to the high half.
+ */
+static void scale_samples_s16_sse2(uint8_t *dst, const uint8_t *src,
+                                   int nb_samples, int volume)
+{
+    int16_t *smp_dst       = (int16_t *)dst;
+    const int16_t *smp_src = (const int16_t *)src;
+    const __m128i vol   = _mm_set1_epi16(volume);
+    const __m128i fix   = _mm_set1_epi16(volume & 0x8000 ? -1 : 0);
+    const __m128i round = _mm_set1_epi32(128);
+    int i;
+
+    for (i = 0; i + 8 <= nb_samples; i += 8) {
+        __m128i s  = LOAD(smp_src + i);
+        __m128i lo = _mm_mullo_epi16(s, vol);
+        __m128i hi = _mm_add_epi16(_mm_mulhi_epi16(s, vol), _mm_and_si128(s, fix));
+        __m128i p0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), round), 8);
+        __m128i p1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), round), 8);
+        STORE(smp_dst + i, _mm_packs_epi32(p0, p1));
+    }
+    for (; i < nb_samples; i++)
+        smp_dst[i] = av_clip_int16((smp_src[i] * volume + 128) >> 8);
+}
+
+/*
+ * s32: src * volume is exact in a double for volume < 1 << 22, and so are
+ * the rounding offset and the division by 256. floor() then gives the
+ * arithmetic shift of the C code.
+ */
+#define S32_VOLUME_MAX (1 << 22)
+
+#if HAVE_INTRINSICS_SSE4
+static av_always_inline av_target_sse4 __m128i scale_s32x2_sse4(__m128d s, __m128d vol)
+{
+    __m128d v = _mm_mul_pd(_mm_add_pd(_mm_mul_pd(s, vol), _mm_set1_pd(128.0)),
+                           _mm_set1_pd(1.0 / 256));
+    v = _mm_min_pd(_mm_max_pd(_mm_floor_pd(v), _mm_set1_pd(INT32_MIN)),
+                   _mm_set1_pd(INT32_MAX));
+    return _mm_cvttpd_epi32(v);
+}
+
+static av_target_sse4 void scale_samples_s32_sse4(uint8_t *dst, const uint8_t *src,
+                                                  int nb_samples, int volume)
+{
+    int32_t *smp_dst       = (int32_t *)dst;
+    const int32_t *smp_src = (const int32_t *)src;
+    const __m128d vol = _mm_set1_pd(volume);
+    int i;
+
+    for (i = 0; i + 4 <= nb_samples; i += 4) {
+        __m128i s = LOAD(smp_src + i);
+        __m128i a = scale_s32x2_sse4(_mm_cvtepi32_pd(s), vol);
+        __m128i b = scale_s32x2_sse4(_mm_cvtepi32_pd(_mm_srli_si128(s, 8)), vol);
+        STORE(smp_dst + i, _mm_unpacklo_epi64(a, b));
+    }
+    for (; i < nb_samples; i++)
+        smp_dst[i] = av_clipl_int32((((int64_t)smp_src[i] * volume + 128) >> 8));
+}
+#endif /* HAVE_INTRINSICS_SSE4 */
+
+#if HAVE_INTRINSICS_AVX
+static av_always_inline av_target_avx __m128i scale_s32x4_avx(__m128i s, __m256d vol)
+{
+    __m256d v = _mm256_mul_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(s), vol),
+                                            _mm256_set1_pd(128.0)),
+                              _mm256_set1_pd(1.0 / 256));
+    v = _mm256_min_pd(_mm256_max_pd(_mm256_floor_pd(v), _mm256_set1_pd(INT32_MIN)),
+                      _mm256_set1_pd(INT32_MAX));
+    return _mm256_cvttpd_epi32(v);
+}
+
+static av_target_avx void scale_samples_s32_avx(uint8_t *dst, const uint8_t *src,
+                                                int nb_samples, int volume)
+{
+    int32_t *smp_dst       = (int32_t *)dst;
+    const int32_t *smp_src = (const int32_t *)src;
+    const __m256d vol = _mm256_set1_pd(volume);
+    int i;
+
+    for (i = 0; i + 8 <= nb_samples; i += 8) {
+        STORE(smp_dst + i,     scale_s32x4_avx(LOAD(smp_src + i),     vol));
+        STORE(smp_dst + i + 4, scale_s32x4_avx(LOAD(smp_src + i + 4), vol));
+    }
+    for (; i < nb_samples; i++)
+        smp_dst[i] = av_clipl_int32((((int64_t)smp_src[i] * volume + 128) >> 8));
+}
+#endif /* HAVE_INTRINSICS_AVX */
+
+#if HAVE_INTRINSICS_AVX2
+#define LOAD256(p)     _mm256_loadu_si256((const __m256i *)(p))
+#define STORE256(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+
+/* the unpacks and the pack work within 128-bit lanes, so the order is kept */
+static av_target_avx2 void scale_samples_s16_avx2(uint8_t *dst, const uint8_t *src,
+                                                  int nb_samples, int volume)
+{
+    int16_t *smp_dst       = (int16_t *)dst;
+    const int16_t *smp_src = (const int16_t *)src;
+    const __m256i vol   = _mm256_set1_epi16(volume);
+    const __m256i fix   = _mm256_set1_epi16(volume & 0x8000 ? -1 : 0);
+    const __m256i round = _mm256_set1_epi32(128);
+    int i;
+
+    for (i = 0; i + 16 <= nb_samples; i += 16) {
+        __m256i s  = LOAD256(smp_src + i);
+        __m256i lo = _mm256_mullo_epi16(s, vol);
+        __m256i hi = _mm256_add_epi16(_mm256_mulhi_epi16(s, vol), _mm256_and_si256(s, fix));
+        __m256i p0 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(lo, hi), round), 8);
+        __m256i p1 = _mm256_srai_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(lo, hi), round), 8);
+        STORE256(smp_dst + i, _mm256_packs_epi32(p0, p1));
+    }
+    for (; i < nb_samples; i++)
+        smp_dst[i] = av_clip_int16((smp_src[i] * volume + 128) >> 8);
+}
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_volume_init_x86(VolumeContext *vol)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+    enum AVSampleFormat sample_fmt = av_get_packed_sample_fmt(vol->sample_fmt);
+
+    if (sample_fmt == AV_SAMPLE_FMT_S16 && vol->volume_i < 0x10000) {
+        if (INTRINSICS_SSE2(cpu_flags))
+            vol->scale_samples = scale_samples_s16_sse2;
+#if HAVE_INTRINSICS_AVX2
+        if (INTRINSICS_AVX2(cpu_flags))
+            vol->scale_samples = scale_samples_s16_avx2;
+#endif
+    } else if (sample_fmt == AV_SAMPLE_FMT_S32 && vol->volume_i < S32_VOLUME_MAX) {
+#if HAVE_INTRINSICS_SSE4
+        if (INTRINSICS_SSE4(cpu_flags))
+            vol->scale_samples = scale_samples_s32_sse4;
+#endif
+#if HAVE_INTRINSICS_AVX
+        if (INTRINSICS_AVX(cpu_flags))
+            vol->scale_samples = scale_samples_s32_avx;
+#endif
+    }
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
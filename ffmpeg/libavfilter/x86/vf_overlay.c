@@ -0,0 +1,244 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Overlay line blending, SSE2 and AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libavfilter/vf_overlay.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+/* How the overlay is combined with the main picture */
+enum BlendMode {
+    BLEND_STRAIGHT,         ///< d + (s - d) * a
+    BLEND_PREMULTIPLIED,    ///< d * (1 - a) + s, saturated
+    BLEND_PREMULTIPLIED_UV, ///< same around 128, for premultiplied chroma
+};
+
+/*
+ * All products fit in 16 bits: FAST_DIV255(x) = ((x + 128) * 257) >> 16 is
+ * pmulhuw for the unsigned sums and pmulhw for the signed chroma ones, so
+ * the results are the same as those of the C code. The alpha of subsampled
+ * planes is averaged from the even and odd bytes of the alpha lines.
+ */
+
+static av_always_inline __m128i alpha8_sse2(const uint8_t *a, ptrdiff_t alinesize,
+                                            int hsub, int vsub)
+{
+    const __m128i lo = _mm_set1_epi16(0xFF);
+    __m128i t, a0, a1;
+
+    if (!hsub)
+        return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)a), _mm_setzero_si128());
+
+    t  = _mm_loadu_si128((const __m128i *)a);
+    a0 = _mm_and_si128(t, lo);
+    a1 = _mm_srli_epi16(t, 8);
+    if (vsub) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(a + alinesize));
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(a0, a1),
+                                    _mm_add_epi16(_mm_and_si128(b, lo), _mm_srli_epi16(b, 8)));
+        return _mm_srli_epi16(sum, 2);
+    }
+    return _mm_srli_epi16(_mm_add_epi16(a0, _mm_srli_epi16(_mm_add_epi16(a0, a1), 1)), 1);
+}
+
+static av_always_inline __m128i blend8_sse2(__m128i d, __m128i s, __m128i alpha, int mode)
+{
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i c257 = _mm_set1_epi16(257);
+    __m128i ia = _mm_sub_epi16(c255, alpha);
+
+    switch (mode) {
+    case BLEND_STRAIGHT:
+        d = _mm_add_epi16(_mm_mullo_epi16(d, ia), _mm_mullo_epi16(s, alpha));
+        return _mm_mulhi_epu16(_mm_add_epi16(d, c128), c257);
+    case BLEND_PREMULTIPLIED:
+        d = _mm_mulhi_epu16(_mm_add_epi16(_mm_mullo_epi16(d, ia), c128), c257);
+        return _mm_add_epi16(d, s);
+    default:
+        d = _mm_mullo_epi16(_mm_sub_epi16(d, c128), ia);
+        d = _mm_mulhi_epi16(_mm_add_epi16(d, c128), c257);
+        return _mm_add_epi16(d, s);
+    }
+}
+
+static av_always_inline int blend_row_sse2(uint8_t *d, const uint8_t *s, const uint8_t *a,
+                                           int w, ptrdiff_t alinesize,
+                                           int hsub, int vsub, int mode)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x;
+
+    for (x = 0; x <= w - 8; x += 8) {
+        __m128i dv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(d + x)), zero);
+        __m128i sv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(s + x)), zero);
+        __m128i av = alpha8_sse2(a + (x << hsub), alinesize, hsub, vsub);
+
+        _mm_storel_epi64((__m128i *)(d + x), _mm_packus_epi16(blend8_sse2(dv, sv, av, mode), zero));
+    }
+    return x;
+}
+
+#if HAVE_INTRINSICS_AVX2
+static av_always_inline av_target_avx2 __m256i alpha16_avx2(const uint8_t *a, ptrdiff_t alinesize,
+                                                            int hsub, int vsub)
+{
+    const __m256i lo = _mm256_set1_epi16(0xFF);
+    __m256i t, a0, a1;
+
+    if (!hsub)
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)a));
+
+    t  = _mm256_loadu_si256((const __m256i *)a);
+    a0 = _mm256_and_si256(t, lo);
+    a1 = _mm256_srli_epi16(t, 8);
+    if (vsub) {
+        __m256i b = _mm256_loadu_si256((const __m256i *)(a + alinesize));
+        __m256i sum = _mm256_add_epi16(_mm256_add_epi16(a0, a1),
+                                       _mm256_add_epi16(_mm256_and_si256(b, lo), _mm256_srli_epi16(b, 8)));
+        return _mm256_srli_epi16(sum, 2);
+    }
+    return _mm256_srli_epi16(_mm256_add_epi16(a0, _mm256_srli_epi16(_mm256_add_epi16(a0, a1), 1)), 1);
+}
+
+static av_always_inline av_target_avx2 __m256i blend16_avx2(__m256i d, __m256i s, __m256i alpha,
+                                                            int mode)
+{
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const __m256i c255 = _mm256_set1_epi16(255);
+    const __m256i c257 = _mm256_set1_epi16(257);
+    __m256i ia = _mm256_sub_epi16(c255, alpha);
+
+    switch (mode) {
+    case BLEND_STRAIGHT:
+        d = _mm256_add_epi16(_mm256_mullo_epi16(d, ia), _mm256_mullo_epi16(s, alpha));
+        return _mm256_mulhi_epu16(_mm256_add_epi16(d, c128), c257);
+    case BLEND_PREMULTIPLIED:
+        d = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_mullo_epi16(d, ia), c128), c257);
+        return _mm256_add_epi16(d, s);
+    default:
+        d = _mm256_mullo_epi16(_mm256_sub_epi16(d, c128), ia);
+        d = _mm256_mulhi_epi16(_mm256_add_epi16(d, c128), c257);
+        return _mm256_add_epi16(d, s);
+    }
+}
+
+static av_always_inline av_target_avx2 int blend_row_avx2(uint8_t *d, const uint8_t *s,
+                                                          const uint8_t *a, int w,
+                                                          ptrdiff_t alinesize,
+                                                          int hsub, int vsub, int mode)
+{
+    int x;
+
+    for (x = 0; x <= w - 16; x += 16) {
+        __m256i dv = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(d + x)));
+        __m256i sv = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(s + x)));
+        __m256i av = alpha16_avx2(a + (x << hsub), alinesize, hsub, vsub);
+        __m256i r  = blend16_avx2(dv, sv, av, mode);
+
+        _mm_storeu_si128((__m128i *)(d + x), _mm_packus_epi16(_mm256_castsi256_si128(r),
+                                                              _mm256_extracti128_si256(r, 1)));
+    }
+    return x;
+}
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+#define BLEND_ROW(name, hsub, vsub, mode, opt, target)                                  \
+static target int blend_row_ ## name ## _ ## opt(uint8_t *d, const uint8_t *s,         \
+                                                 const uint8_t *a, int w,              \
+                                                 ptrdiff_t alinesize)                  \
+{                                                                                       \
+    return blend_row_ ## opt(d, s, a, w, alinesize, hsub, vsub, mode);                  \
+}
+
+#define BLEND_ROWS(opt, target)                                                         \
+BLEND_ROW(444,    0, 0, BLEND_STRAIGHT,         opt, target)                            \
+BLEND_ROW(422,    1, 0, BLEND_STRAIGHT,         opt, target)                            \
+BLEND_ROW(420,    1, 1, BLEND_STRAIGHT,         opt, target)                            \
+BLEND_ROW(444_pm, 0, 0, BLEND_PREMULTIPLIED,    opt, target)                            \
+BLEND_ROW(444_uv, 0, 0, BLEND_PREMULTIPLIED_UV, opt, target)                            \
+BLEND_ROW(422_uv, 1, 0, BLEND_PREMULTIPLIED_UV, opt, target)                            \
+BLEND_ROW(420_uv, 1, 1, BLEND_PREMULTIPLIED_UV, opt, target)
+
+BLEND_ROWS(sse2, )
+#if HAVE_INTRINSICS_AVX2
+BLEND_ROWS(avx2, av_target_avx2)
+#endif
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+/* The last line of a vertically subsampled plane is left to the C code,
+ * so are the horizontally subsampled ones that have only 4:4:4 and 4:2:2
+ * and 4:2:0 versions. */
+#define SET_BLEND_ROW(opt)                                                              \
+    for (i = 0; i < 3; i++) {                                                           \
+        int chroma = i && !rgb;                                                         \
+        int hsub   = chroma ? s->hsub : 0;                                              \
+        int vsub   = chroma ? s->vsub : 0;                                              \
+                                                                                        \
+        if (s->main_desc->comp[rgb ? (i + 1) % 3 : i].step != 1)                        \
+            continue;                                                                   \
+        if (!hsub && !vsub)                                                             \
+            s->blend_row[i] = straight ? blend_row_444_ ## opt    :                     \
+                              chroma   ? blend_row_444_uv_ ## opt :                     \
+                                         blend_row_444_pm_ ## opt;                      \
+        else if (hsub == 1 && !vsub)                                                    \
+            s->blend_row[i] = straight ? blend_row_422_ ## opt : blend_row_422_uv_ ## opt; \
+        else if (hsub == 1 && vsub == 1)                                                \
+            s->blend_row[i] = straight ? blend_row_420_ ## opt : blend_row_420_uv_ ## opt; \
+    }
+
+av_cold void ff_overlay_init_x86(OverlayContext *s)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+    int straight  = s->alpha_format == ALPHA_FORMAT_STRAIGHT;
+    int rgb       = !!(s->main_desc->flags & AV_PIX_FMT_FLAG_RGB);
+    int i;
+
+    if (s->main_has_alpha || s->main_is_packed_rgb)
+        return;
+
+    if (INTRINSICS_SSE2(cpu_flags)) {
+        SET_BLEND_ROW(sse2);
+    }
+#if HAVE_INTRINSICS_AVX2
+    if (INTRINSICS_AVX2(cpu_flags)) {
+        SET_BLEND_ROW(avx2);
+    }
+#endif
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
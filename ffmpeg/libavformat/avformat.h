@@ -1917,6 +1917,16 @@ typedef struct AVFormatContext {
      * - decoding: set by user
      */
     int max_streams;
+
+    /**
+     * Path of a file caching the stream parameters and the index of the
+     * input between opens. If it matches the input, avformat_find_stream_info()
+     * restores the parameters from it instead of probing, otherwise it is
+     * written by avformat_close_input(). Only used with seekable inputs.
+     * - encoding: unused
+     * - decoding: set by user
+     */
+    char *index_cache;
 } AVFormatContext;
 
 /**
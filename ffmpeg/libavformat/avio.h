@@ -350,6 +350,31 @@ typedef struct AVIOContext {
      * Try to buffer at least this amount of data before flushing it
      */
     int min_packet_size;
+
+    /**
+     * Largest read issued by the adaptive read-ahead, 0 (the default)
+     * disables it.
+     * Each refill of the buffer requests twice as much data as the previous
+     * one, starting from the buffer size, and the buffer is grown to match.
+     * A seek that cannot be done inside the buffer starts over from the
+     * buffer size. Also settable through the "read_ahead_max" option.
+     */
+    int read_ahead_max;
+
+    /**
+     * Size of the next read of the adaptive read-ahead.
+     * Internal, not meant to be used from outside of AVIOContext.
+     */
+    int read_ahead_size;
+
+    /**
+     * Number of read_packet() calls and of those returning less data than
+     * requested. Read through the "read_count" and "short_read_count"
+     * options, like bytes_read and seek_count.
+     * This field is internal to libavformat and access from outside is not allowed.
+     */
+    int read_count;
+    int short_read_count;
 } AVIOContext;
 
 /**
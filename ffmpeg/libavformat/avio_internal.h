@@ -53,6 +53,16 @@ int ffio_init_context(AVIOContext *s,
  */
 int ffio_read_indirect(AVIOContext *s, unsigned char *buf, int size, const unsigned char **data);
 
+/**
+ * Read size bytes into a new buffer the protocol maps the data to instead of
+ * copying it. The buffer is writable and followed by
+ * AV_INPUT_BUFFER_PADDING_SIZE zero bytes.
+ *
+ * @return size, or AVERROR(ENOSYS) if the data cannot be referenced and
+ *         must be read with avio_read()
+ */
+int ffio_read_mapped(AVIOContext *s, AVBufferRef **buf, int size);
+
 /**
  * Read size bytes from AVIOContext into buf.
  * This reads at most 1 packet. If that is not enough fewer bytes will be
@@ -42,15 +42,39 @@
  */
 #define SHORT_SEEK_THRESHOLD 4096
 
+/**
+ * For protocols that map the whole resource into memory, the buffer is a
+ * window of up to MAP_WINDOW_SIZE bytes ahead and MAP_SEEKBACK bytes behind
+ * the read position, moved over the mapping by fill_buffer().
+ */
+#define MAP_WINDOW_SIZE (64 << 20)
+#define MAP_SEEKBACK    (1 << 20)
+
+/**
+ * Smaller reads are copied from the window, mapping them on their own
+ * costs more than the copy.
+ */
+#define MAP_RANGE_MIN   (64 << 10)
+
 typedef struct AVIOInternal {
     URLContext *h;
+    AVBufferRef *map;       ///< mapping of the whole resource, if any
+    int64_t map_size;
+    uint8_t *buffer;        ///< allocated buffer while the mapping is used
+    int buffer_size;
 } AVIOInternal;
 
+static int io_read_packet(void *opaque, uint8_t *buf, int buf_size);
+static int io_write_packet(void *opaque, uint8_t *buf, int buf_size);
+
 static void *ff_avio_child_next(void *obj, void *prev)
 {
     AVIOContext *s = obj;
     AVIOInternal *internal = s->opaque;
-    return prev ? NULL : internal->h;
+    /* contexts from avio_alloc_context() have no URLContext */
+    if (prev || (s->read_packet != io_read_packet && s->write_packet != io_write_packet))
+        return NULL;
+    return internal->h;
 }
 
 static const AVClass *ff_avio_child_class_next(const AVClass *prev)
@@ -61,8 +85,14 @@ static const AVClass *ff_avio_child_class_next(const AVClass *prev)
 #define OFFSET(x) offsetof(AVIOContext,x)
 #define E AV_OPT_FLAG_ENCODING_PARAM
 #define D AV_OPT_FLAG_DECODING_PARAM
+#define S (AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY)
 static const AVOption ff_avio_options[] = {
     {"protocol_whitelist", "List of protocols that are allowed to be used", OFFSET(protocol_whitelist), AV_OPT_TYPE_STRING, { .str = NULL },  CHAR_MIN, CHAR_MAX, D },
+    {"read_ahead_max", "largest read of the adaptive read-ahead, 0 disables it", OFFSET(read_ahead_max), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX / 2, D },
+    {"bytes_read", "number of bytes read", OFFSET(bytes_read), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, S },
+    {"seek_count", "number of seeks", OFFSET(seek_count), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, S },
+    {"read_count", "number of reads", OFFSET(read_count), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, S },
+    {"short_read_count", "number of reads returning less than requested", OFFSET(short_read_count), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, S },
     { NULL },
 };
 
@@ -140,6 +170,7 @@ AVIOContext *avio_alloc_context(
         return NULL;
     ffio_init_context(s, buffer, buffer_size, write_flag, opaque,
                   read_packet, write_packet, seek);
+    s->av_class = &ff_avio_class;
     return s;
 }
 
@@ -298,6 +329,7 @@ int64_t avio_seek(AVIOContext *s, int64_t offset, int whence)
         s->buf_ptr = s->buffer;
         s->pos = pos;
         s->eof_reached = 0;
+        s->read_ahead_size = 0;
         fill_buffer(s);
         return avio_seek(s, offset, SEEK_SET | force);
     } else {
@@ -314,6 +346,7 @@ int64_t avio_seek(AVIOContext *s, int64_t offset, int whence)
             s->buf_end = s->buffer;
         s->buf_ptr = s->buf_ptr_max = s->buffer;
         s->pos = offset;
+        s->read_ahead_size = 0;
     }
     s->eof_reached = 0;
     return offset;
@@ -526,6 +559,93 @@ void avio_write_marker(AVIOContext *s, int64_t time, enum AVIODataMarkerType typ
 
 /* Input stream */
 
+static int io_is_mapped(AVIOContext *s)
+{
+    return s->read_packet == io_read_packet && ((AVIOInternal *)s->opaque)->map;
+}
+
+static void fill_mapped(AVIOContext *s)
+{
+    AVIOInternal *internal = s->opaque;
+    uint8_t *map = internal->map->data;
+    int64_t cur  = s->pos - (s->buf_end - s->buf_ptr);
+    int64_t start, end;
+
+    if (s->eof_reached)
+        return;
+    if (s->pos >= internal->map_size) {
+        s->eof_reached = 1;
+        return;
+    }
+
+    if (s->update_checksum) {
+        if (s->buf_end > s->checksum_ptr)
+            s->checksum = s->update_checksum(s->checksum, s->checksum_ptr,
+                                             s->buf_end - s->checksum_ptr);
+        s->checksum_ptr = map + s->pos;
+    }
+
+    start = FFMIN(cur, FFMAX(s->pos - MAP_SEEKBACK, 0));
+    end   = FFMIN(internal->map_size, s->pos + MAP_WINDOW_SIZE);
+
+    s->buffer      = map + start;
+    s->buf_ptr     = map + cur;
+    s->buf_end     = map + end;
+    s->bytes_read += end - s->pos;
+    s->pos         = end;
+
+    /* keep the protocol in step for reads bypassing the buffer */
+    ffurl_seek(internal->h, end, SEEK_SET);
+}
+
+/* Go back to reading into the allocated buffer. */
+static void io_unmap(AVIOContext *s)
+{
+    AVIOInternal *internal = s->opaque;
+    int64_t pos = avio_tell(s);
+
+    if (s->update_checksum && s->buf_ptr > s->checksum_ptr)
+        s->checksum = s->update_checksum(s->checksum, s->checksum_ptr,
+                                         s->buf_ptr - s->checksum_ptr);
+
+    s->buffer      = internal->buffer;
+    s->buffer_size = internal->buffer_size;
+    s->buf_ptr     = s->buf_end = s->checksum_ptr = s->buffer;
+    s->pos         = pos;
+    internal->buffer = NULL;
+    av_buffer_unref(&internal->map);
+
+    ffurl_seek(internal->h, pos, SEEK_SET);
+}
+
+int ffio_read_mapped(AVIOContext *s, AVBufferRef **pbuf, int size)
+{
+    AVIOInternal *internal = s->opaque;
+    AVBufferRef *buf;
+    int64_t pos, ret;
+
+    if (!io_is_mapped(s) || !internal->h->prot->url_map_range ||
+        s->update_checksum || size < MAP_RANGE_MIN || size > INT_MAX / 2)
+        return AVERROR(ENOSYS);
+
+    /* the padding past the end must still be inside the file */
+    pos = avio_tell(s);
+    if (pos + size + AV_INPUT_BUFFER_PADDING_SIZE > internal->map_size)
+        return AVERROR(ENOSYS);
+
+    ret = internal->h->prot->url_map_range(internal->h, pos, size, &buf);
+    if (ret < 0)
+        return ret;
+
+    if ((ret = avio_skip(s, size)) < 0) {
+        av_buffer_unref(&buf);
+        return ret;
+    }
+
+    *pbuf = buf;
+    return size;
+}
+
 static void fill_buffer(AVIOContext *s)
 {
     int max_buffer_size = s->max_packet_size ?
@@ -534,6 +654,11 @@ static void fill_buffer(AVIOContext *s)
                           s->buf_end : s->buffer;
     int len             = s->buffer_size - (dst - s->buffer);
 
+    if (io_is_mapped(s)) {
+        fill_mapped(s);
+        return;
+    }
+
     /* can't fill the buffer without read_packet, just set EOF if appropriate */
     if (!s->read_packet && s->buf_ptr >= s->buf_end)
         s->eof_reached = 1;
@@ -549,8 +674,24 @@ static void fill_buffer(AVIOContext *s)
         s->checksum_ptr = s->buffer;
     }
 
-    /* make buffer smaller in case it ended up large after probing */
-    if (s->read_packet && s->orig_buffer_size && s->buffer_size > s->orig_buffer_size) {
+    if (s->read_ahead_max && s->read_packet && !s->max_packet_size) {
+        /* adaptive read-ahead, the buffer only grows when it is refilled
+         * from the start so that nothing needs to be copied */
+        int size = FFMAX(s->read_ahead_size, s->orig_buffer_size);
+
+        if (dst == s->buffer && size > s->buffer_size) {
+            uint8_t *buffer = av_malloc(size);
+            if (buffer) {
+                av_free(s->buffer);
+                s->buffer      = buffer;
+                s->buffer_size = size;
+                s->buf_ptr     = s->buf_end = s->checksum_ptr = dst = buffer;
+            }
+        }
+        len = FFMIN(s->buffer_size - (dst - s->buffer), size);
+        s->read_ahead_size = FFMIN(size, s->read_ahead_max / 2) * 2;
+    } else if (s->read_packet && s->orig_buffer_size && s->buffer_size > s->orig_buffer_size) {
+        /* make buffer smaller in case it ended up large after probing */
         if (dst == s->buffer && s->buf_ptr != dst) {
             int ret = ffio_set_buf_size(s, s->orig_buffer_size);
             if (ret < 0)
@@ -562,9 +703,13 @@ static void fill_buffer(AVIOContext *s)
         len = s->orig_buffer_size;
     }
 
-    if (s->read_packet)
-        len = s->read_packet(s->opaque, dst, len);
-    else
+    if (s->read_packet) {
+        int size = len;
+        len = s->read_packet(s->opaque, dst, size);
+        s->read_count++;
+        if (len > 0 && len < size)
+            s->short_read_count++;
+    } else
         len = 0;
     if (len <= 0) {
         /* do not modify buffer if EOF reached so that a seek back can
@@ -637,8 +782,12 @@ int avio_read(AVIOContext *s, unsigned char *buf, int size)
         if (len == 0 || s->write_flag) {
             if((s->direct || size > s->buffer_size) && !s->update_checksum) {
                 // bypass the buffer and read data directly into buf
-                if(s->read_packet)
+                if(s->read_packet) {
                     len = s->read_packet(s->opaque, buf, size);
+                    s->read_count++;
+                    if (len > 0 && len < size)
+                        s->short_read_count++;
+                }
 
                 if (len <= 0) {
                     /* do not modify buffer if EOF reached so that a seek back can
@@ -957,6 +1106,14 @@ int ffio_fdopen(AVIOContext **s, URLContext *h)
     }
     (*s)->short_seek_get = io_short_seek;
     (*s)->av_class = &ff_avio_class;
+
+    if (h->prot && h->prot->url_get_mapping && !(h->flags & AVIO_FLAG_WRITE) &&
+        h->prot->url_get_mapping(h, &internal->map, &internal->map_size) >= 0) {
+        internal->buffer      = buffer;
+        internal->buffer_size = buffer_size;
+        (*s)->buffer          = (*s)->buf_ptr = (*s)->buf_end = internal->map->data;
+        (*s)->buffer_size     = MAP_WINDOW_SIZE;
+    }
     return 0;
 fail:
     av_freep(&internal);
@@ -996,6 +1153,10 @@ int ffio_ensure_seekback(AVIOContext *s, int64_t buf_size)
 int ffio_set_buf_size(AVIOContext *s, int buf_size)
 {
     uint8_t *buffer;
+
+    if (io_is_mapped(s))
+        io_unmap(s);
+
     buffer = av_malloc(buf_size);
     if (!buffer)
         return AVERROR(ENOMEM);
@@ -1035,6 +1196,13 @@ int ffio_rewind_with_probe_data(AVIOContext *s, unsigned char **bufp, int buf_si
         return AVERROR(EINVAL);
     }
 
+    /* the probe data is still in the mapping */
+    if (io_is_mapped(s)) {
+        int64_t ret = avio_seek(s, 0, SEEK_SET);
+        av_freep(bufp);
+        return ret < 0 ? ret : 0;
+    }
+
     buffer_size = s->buf_end - s->buffer;
 
     /* the buffers must touch or overlap */
@@ -1087,6 +1255,10 @@ int ffio_open_whitelist(AVIOContext **s, const char *filename, int flags,
         ffurl_close(h);
         return err;
     }
+    if (options && (err = av_opt_set_dict(*s, options)) < 0) {
+        avio_closep(s);
+        return err;
+    }
     return 0;
 }
 
@@ -1114,6 +1286,8 @@ int avio_close(AVIOContext *s)
     internal = s->opaque;
     h        = internal->h;
 
+    if (internal->map)
+        io_unmap(s);
     av_freep(&s->opaque);
     av_freep(&s->buffer);
     if (s->write_flag)
@@ -20,6 +20,8 @@
  */
 
 #include "libavutil/avstring.h"
+#include "libavutil/buffer.h"
+#include "libavutil/file.h"
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "avformat.h"
@@ -403,3 +405,164 @@ const URLProtocol ff_pipe_protocol = {
 };
 
 #endif /* CONFIG_PIPE_PROTOCOL */
+
+#if CONFIG_MMAP_PROTOCOL
+
+#include <sys/mman.h>
+
+/* read only access to a file mapped into memory, AVIOContext reads point
+ * into the mapping instead of copying from it */
+
+typedef struct MmapContext {
+    AVBufferRef *map;
+    int64_t size;
+    int64_t pos;
+    int fd;
+    long page_size;
+} MmapContext;
+
+static void mmap_free(void *opaque, uint8_t *data)
+{
+    av_file_unmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static void mmap_range_free(void *opaque, uint8_t *data)
+{
+    munmap(data, (size_t)(uintptr_t)opaque);
+}
+
+static int mmap_open(URLContext *h, const char *filename, int flags)
+{
+    MmapContext *c = h->priv_data;
+    uint8_t *data;
+    size_t size;
+    int ret;
+
+    av_strstart(filename, "mmap:", &filename);
+
+    if (flags & AVIO_FLAG_WRITE)
+        return AVERROR(ENOSYS);
+
+    c->fd = avpriv_open(filename, O_RDONLY);
+    if (c->fd < 0)
+        return AVERROR(errno);
+    c->page_size = sysconf(_SC_PAGESIZE);
+
+    ret = av_file_map(filename, &data, &size, 0, h);
+    if (ret < 0) {
+        close(c->fd);
+        return ret;
+    }
+
+    /* the buffer size is only informative, AVIOContext uses its own
+     * offsets into the mapping */
+    c->map = av_buffer_create(data, FFMIN(size, INT_MAX), mmap_free,
+                              (void *)(uintptr_t)size, AV_BUFFER_FLAG_READONLY);
+    if (!c->map) {
+        av_file_unmap(data, size);
+        close(c->fd);
+        return AVERROR(ENOMEM);
+    }
+    c->size = size;
+
+    return 0;
+}
+
+static int mmap_read(URLContext *h, unsigned char *buf, int size)
+{
+    MmapContext *c = h->priv_data;
+
+    if (c->pos >= c->size)
+        return AVERROR_EOF;
+    size = FFMIN(size, c->size - c->pos);
+    memcpy(buf, c->map->data + c->pos, size);
+    c->pos += size;
+    return size;
+}
+
+static int64_t mmap_seek(URLContext *h, int64_t pos, int whence)
+{
+    MmapContext *c = h->priv_data;
+
+    switch (whence) {
+    case AVSEEK_SIZE:
+        return c->size;
+    case SEEK_CUR:
+        pos += c->pos;
+        break;
+    case SEEK_END:
+        pos += c->size;
+        break;
+    case SEEK_SET:
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    if (pos < 0)
+        return AVERROR(EINVAL);
+
+    return c->pos = pos;
+}
+
+static int mmap_close(URLContext *h)
+{
+    MmapContext *c = h->priv_data;
+    av_buffer_unref(&c->map);
+    close(c->fd);
+    return 0;
+}
+
+static int mmap_get_mapping(URLContext *h, AVBufferRef **buf, int64_t *size)
+{
+    MmapContext *c = h->priv_data;
+
+    *buf = av_buffer_ref(c->map);
+    if (!*buf)
+        return AVERROR(ENOMEM);
+    *size = c->size;
+    return 0;
+}
+
+/* Each range gets its own private mapping: the caller may write to it
+ * without changing the file or the AVIOContext window, and zeroing the
+ * padding only copies the last page. */
+static int mmap_map_range(URLContext *h, int64_t pos, int size, AVBufferRef **buf)
+{
+    MmapContext *c = h->priv_data;
+    int64_t start  = pos - pos % c->page_size;
+    size_t len     = pos - start + size + AV_INPUT_BUFFER_PADDING_SIZE;
+    uint8_t *data;
+
+    /* pages past the end of the file cannot be accessed */
+    if (pos < 0 || pos + size + AV_INPUT_BUFFER_PADDING_SIZE > c->size)
+        return AVERROR(EINVAL);
+
+    data = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, c->fd, start);
+    if (data == MAP_FAILED)
+        return AVERROR(errno);
+
+    *buf = av_buffer_create(data, len, mmap_range_free, (void *)(uintptr_t)len, 0);
+    if (!*buf) {
+        munmap(data, len);
+        return AVERROR(ENOMEM);
+    }
+    (*buf)->data += pos - start;
+    (*buf)->size  = size + AV_INPUT_BUFFER_PADDING_SIZE;
+    memset((*buf)->data + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    return 0;
+}
+
+const URLProtocol ff_mmap_protocol = {
+    .name              = "mmap",
+    .url_open          = mmap_open,
+    .url_read          = mmap_read,
+    .url_seek          = mmap_seek,
+    .url_close         = mmap_close,
+    .url_get_mapping   = mmap_get_mapping,
+    .url_map_range     = mmap_map_range,
+    .priv_data_size    = sizeof(MmapContext),
+    .default_whitelist = "mmap,file,crypto"
+};
+
+#endif /* CONFIG_MMAP_PROTOCOL */
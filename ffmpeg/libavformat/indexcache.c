@@ -0,0 +1,525 @@
+/*
+ * Persistent demuxer index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Sidecar file with the result of avformat_find_stream_info() and the
+ * index entries of an input, so that later opens of the same input skip
+ * the probing and seek without bisecting the file.
+ *
+ * All values are big-endian:
+ *   tag 'FFIC', version, input size, mtime, MD5 of the first HASH_SIZE bytes,
+ *   demuxer name, flags, start_time, duration, bit_rate,
+ *   duration_estimation_method, stream count, then for every stream its
+ *   id, time base, codec parameters, timing and index entries.
+ */
+
+#include <sys/stat.h>
+
+#include "libavutil/avstring.h"
+#include "libavutil/md5.h"
+#include "libavutil/mem.h"
+#include "avformat.h"
+#include "avio_internal.h"
+#include "indexcache.h"
+#include "internal.h"
+#include "os_support.h"
+
+#define CACHE_TAG       MKBETAG('F','F','I','C')
+#define CACHE_VERSION   2
+#define CACHE_COMPLETE  1
+
+#define HASH_SIZE       65536
+#define ENTRY_SIZE      28
+#define ENTRY_FLAGS     (AVINDEX_KEYFRAME | AVINDEX_DISCARD_FRAME)
+
+typedef struct CachedStream {
+    AVCodecParameters *par;
+    AVRational avg_frame_rate;
+    AVRational r_frame_rate;
+    AVRational sample_aspect_ratio;
+    int64_t start_time;
+    int64_t first_dts;
+    int64_t pts_wrap_reference;
+    int pts_wrap_behavior;
+    int64_t duration;
+    int64_t nb_frames;
+    int disposition;
+    int codec_info_nb_frames;
+    AVIndexEntry *index_entries;
+    int nb_index_entries;
+} CachedStream;
+
+static int64_t input_mtime(AVFormatContext *s)
+{
+    const char *proto = avio_find_protocol_name(s->filename);
+    const char *path  = s->filename;
+    struct stat st;
+    int ret;
+
+    if (!proto || (strcmp(proto, "file") && strcmp(proto, "mmap")))
+        return 0;
+    if (!av_strstart(path, "file:", &path))
+        av_strstart(path, "mmap:", &path);
+#ifndef _WIN32
+    ret = stat(path, &st);
+#else
+    ret = win32_stat(path, &st);
+#endif
+    return ret < 0 ? 0 : st.st_mtime;
+}
+
+static int compute_key(AVFormatContext *s, FFIndexCache *ic)
+{
+    AVIOContext *pb = s->pb;
+    int64_t pos = avio_tell(pb);
+    uint8_t buf[4096];
+    struct AVMD5 *md5;
+    int left, ret = 0;
+
+    ic->size  = avio_size(pb);
+    ic->mtime = input_mtime(s);
+    if (ic->size <= 0 || pos < 0)
+        return AVERROR(ENOSYS);
+
+    md5 = av_md5_alloc();
+    if (!md5)
+        return AVERROR(ENOMEM);
+    av_md5_init(md5);
+
+    if ((ret = avio_seek(pb, 0, SEEK_SET)) < 0)
+        goto end;
+    for (left = FFMIN(ic->size, HASH_SIZE); left > 0; left -= ret) {
+        ret = avio_read(pb, buf, FFMIN(left, sizeof(buf)));
+        if (ret <= 0) {
+            ret = ret < 0 ? ret : AVERROR_EOF;
+            break;
+        }
+        av_md5_update(md5, buf, ret);
+    }
+    av_md5_final(md5, ic->hash);
+    if (avio_seek(pb, pos, SEEK_SET) < 0)
+        ret = AVERROR(EIO);
+
+end:
+    av_free(md5);
+    return ret < 0 ? ret : 0;
+}
+
+static void write_rational(AVIOContext *pb, AVRational q)
+{
+    avio_wb32(pb, q.num);
+    avio_wb32(pb, q.den);
+}
+
+static AVRational read_rational(AVIOContext *pb)
+{
+    AVRational q;
+    q.num = avio_rb32(pb);
+    q.den = avio_rb32(pb);
+    return q;
+}
+
+static void write_stream(AVIOContext *pb, AVStream *st, int nb_index_entries)
+{
+    AVCodecParameters *par = st->codecpar;
+    int i;
+
+    avio_wb32(pb, st->id);
+    write_rational(pb, st->time_base);
+
+    avio_wb32(pb, par->codec_type);
+    avio_wb32(pb, par->codec_id);
+    avio_wb32(pb, par->codec_tag);
+    avio_wb32(pb, par->format);
+    avio_wb64(pb, par->bit_rate);
+    avio_wb32(pb, par->bits_per_coded_sample);
+    avio_wb32(pb, par->bits_per_raw_sample);
+    avio_wb32(pb, par->profile);
+    avio_wb32(pb, par->level);
+    avio_wb32(pb, par->width);
+    avio_wb32(pb, par->height);
+    write_rational(pb, par->sample_aspect_ratio);
+    avio_wb32(pb, par->field_order);
+    avio_wb32(pb, par->color_range);
+    avio_wb32(pb, par->color_primaries);
+    avio_wb32(pb, par->color_trc);
+    avio_wb32(pb, par->color_space);
+    avio_wb32(pb, par->chroma_location);
+    avio_wb32(pb, par->video_delay);
+    avio_wb64(pb, par->channel_layout);
+    avio_wb32(pb, par->channels);
+    avio_wb32(pb, par->sample_rate);
+    avio_wb32(pb, par->block_align);
+    avio_wb32(pb, par->frame_size);
+    avio_wb32(pb, par->initial_padding);
+    avio_wb32(pb, par->trailing_padding);
+    avio_wb32(pb, par->seek_preroll);
+    avio_wb32(pb, par->extradata_size);
+    avio_write(pb, par->extradata, par->extradata_size);
+
+    write_rational(pb, st->avg_frame_rate);
+    write_rational(pb, st->r_frame_rate);
+    write_rational(pb, st->sample_aspect_ratio);
+    avio_wb64(pb, st->start_time);
+    avio_wb64(pb, st->first_dts);
+    avio_wb64(pb, st->pts_wrap_reference);
+    avio_wb32(pb, st->pts_wrap_behavior);
+    avio_wb64(pb, st->duration);
+    avio_wb64(pb, st->nb_frames);
+    avio_wb32(pb, st->disposition);
+    avio_wb32(pb, st->codec_info_nb_frames);
+
+    avio_wb32(pb, nb_index_entries);
+    for (i = 0; i < nb_index_entries; i++) {
+        const AVIndexEntry *e = &st->index_entries[i];
+        avio_wb64(pb, e->pos);
+        avio_wb64(pb, e->timestamp);
+        avio_wb32(pb, e->size);
+        avio_wb32(pb, e->flags & ENTRY_FLAGS);
+        avio_wb32(pb, e->min_distance);
+    }
+}
+
+static int read_stream(AVFormatContext *s, AVIOContext *pb, AVStream *st,
+                       CachedStream *cs, int64_t file_size)
+{
+    AVCodecParameters *par;
+    AVRational time_base;
+    int i, id;
+
+    id        = avio_rb32(pb);
+    time_base = read_rational(pb);
+    if (id != st->id || av_cmp_q(time_base, st->time_base))
+        return AVERROR_INVALIDDATA;
+
+    if (!(par = cs->par = avcodec_parameters_alloc()))
+        return AVERROR(ENOMEM);
+    par->codec_type             = avio_rb32(pb);
+    par->codec_id               = avio_rb32(pb);
+    par->codec_tag              = avio_rb32(pb);
+    par->format                 = avio_rb32(pb);
+    par->bit_rate               = avio_rb64(pb);
+    par->bits_per_coded_sample  = avio_rb32(pb);
+    par->bits_per_raw_sample    = avio_rb32(pb);
+    par->profile                = avio_rb32(pb);
+    par->level                  = avio_rb32(pb);
+    par->width                  = avio_rb32(pb);
+    par->height                 = avio_rb32(pb);
+    par->sample_aspect_ratio    = read_rational(pb);
+    par->field_order            = avio_rb32(pb);
+    par->color_range            = avio_rb32(pb);
+    par->color_primaries        = avio_rb32(pb);
+    par->color_trc              = avio_rb32(pb);
+    par->color_space            = avio_rb32(pb);
+    par->chroma_location        = avio_rb32(pb);
+    par->video_delay            = avio_rb32(pb);
+    par->channel_layout         = avio_rb64(pb);
+    par->channels               = avio_rb32(pb);
+    par->sample_rate            = avio_rb32(pb);
+    par->block_align            = avio_rb32(pb);
+    par->frame_size             = avio_rb32(pb);
+    par->initial_padding        = avio_rb32(pb);
+    par->trailing_padding       = avio_rb32(pb);
+    par->seek_preroll           = avio_rb32(pb);
+
+    /* probing may refine the codec id set by the demuxer, e.g. MP3 to MP2
+     * for MPEG audio in mpegts, so only the type has to match */
+    if (par->codec_type != st->codecpar->codec_type)
+        return AVERROR_INVALIDDATA;
+
+    i = avio_rb32(pb);
+    if (i < 0 || i > file_size)
+        return AVERROR_INVALIDDATA;
+    if (i) {
+        if (ff_get_extradata(s, par, pb, i) < 0)
+            return AVERROR_INVALIDDATA;
+    }
+
+    cs->avg_frame_rate          = read_rational(pb);
+    cs->r_frame_rate            = read_rational(pb);
+    cs->sample_aspect_ratio     = read_rational(pb);
+    cs->start_time              = avio_rb64(pb);
+    cs->first_dts               = avio_rb64(pb);
+    cs->pts_wrap_reference      = avio_rb64(pb);
+    cs->pts_wrap_behavior       = avio_rb32(pb);
+    cs->duration                = avio_rb64(pb);
+    cs->nb_frames               = avio_rb64(pb);
+    cs->disposition             = avio_rb32(pb);
+    cs->codec_info_nb_frames    = avio_rb32(pb);
+
+    cs->nb_index_entries = avio_rb32(pb);
+    if (cs->nb_index_entries < 0 ||
+        cs->nb_index_entries > file_size / ENTRY_SIZE)
+        return AVERROR_INVALIDDATA;
+    if (!cs->nb_index_entries)
+        return 0;
+    cs->index_entries = av_malloc_array(cs->nb_index_entries,
+                                        sizeof(*cs->index_entries));
+    if (!cs->index_entries)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < cs->nb_index_entries; i++) {
+        AVIndexEntry *e = &cs->index_entries[i];
+        int size, flags;
+        e->pos          = avio_rb64(pb);
+        e->timestamp    = avio_rb64(pb);
+        size            = avio_rb32(pb);
+        flags           = avio_rb32(pb);
+        e->min_distance = avio_rb32(pb);
+        /* size has to fit the 30 bit field of AVIndexEntry */
+        if (size < 0 || size >= 1 << 29 || flags & ~ENTRY_FLAGS ||
+            e->min_distance < 0 || e->pos < 0 ||
+            e->timestamp == AV_NOPTS_VALUE ||
+            (i && e->timestamp <= e[-1].timestamp))
+            return AVERROR_INVALIDDATA;
+        e->size         = size;
+        e->flags        = flags;
+    }
+    return 0;
+}
+
+static int apply_stream(AVStream *st, CachedStream *cs, int keep_index)
+{
+    int ret = avcodec_parameters_copy(st->codecpar, cs->par);
+    if (ret < 0)
+        return ret;
+
+    st->avg_frame_rate          = cs->avg_frame_rate;
+    st->r_frame_rate            = cs->r_frame_rate;
+    st->sample_aspect_ratio     = cs->sample_aspect_ratio;
+    st->start_time              = cs->start_time;
+    /* without probing no packets are buffered whose timestamps could be
+     * fixed up once the first dts is known, so start from the known one,
+     * and take the wrap reference from the start of the input even if the
+     * first packet is read after a seek */
+    if (cs->first_dts != AV_NOPTS_VALUE) {
+        st->first_dts           = cs->first_dts;
+        st->cur_dts             = cs->first_dts;
+    }
+    if (cs->pts_wrap_reference != AV_NOPTS_VALUE) {
+        st->pts_wrap_reference  = cs->pts_wrap_reference;
+        st->pts_wrap_behavior   = cs->pts_wrap_behavior;
+    }
+    st->duration                = cs->duration;
+    st->nb_frames               = cs->nb_frames;
+    st->disposition             = cs->disposition;
+    st->codec_info_nb_frames    = cs->codec_info_nb_frames;
+    st->request_probe           = -1;
+
+    /* keep an index the demuxer read from the file if it is as detailed */
+    if (keep_index && cs->nb_index_entries > st->nb_index_entries) {
+        av_free(st->index_entries);
+        st->index_entries                = cs->index_entries;
+        st->nb_index_entries             = cs->nb_index_entries;
+        st->index_entries_allocated_size = cs->nb_index_entries *
+                                           sizeof(*cs->index_entries);
+        cs->index_entries = NULL;
+    }
+    return 0;
+}
+
+static int read_cache(AVFormatContext *s, FFIndexCache *ic, AVIOContext *pb)
+{
+    CachedStream *cs = NULL;
+    char name[64];
+    uint8_t hash[16];
+    int64_t file_size = avio_size(pb);
+    int64_t start_time, duration, bit_rate;
+    int flags, method, nb_streams, entries = 0, i, ret = 0;
+
+    if (avio_rb32(pb) != CACHE_TAG || avio_rb32(pb) != CACHE_VERSION)
+        return 0;
+    if (avio_rb64(pb) != ic->size || avio_rb64(pb) != ic->mtime ||
+        avio_read(pb, hash, sizeof(hash)) != sizeof(hash) ||
+        memcmp(hash, ic->hash, sizeof(hash)))
+        return 0;
+    avio_get_str(pb, INT_MAX, name, sizeof(name));
+    if (strcmp(name, s->iformat->name))
+        return 0;
+
+    flags      = avio_rb32(pb);
+    start_time = avio_rb64(pb);
+    duration   = avio_rb64(pb);
+    bit_rate   = avio_rb64(pb);
+    method     = avio_rb32(pb);
+    nb_streams = avio_rb32(pb);
+    if (nb_streams != s->nb_streams || pb->eof_reached)
+        return 0;
+
+    cs = av_mallocz_array(nb_streams, sizeof(*cs));
+    if (!cs)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < nb_streams; i++) {
+        ret = read_stream(s, pb, s->streams[i], &cs[i], file_size);
+        if (ret < 0 || pb->eof_reached || pb->error)
+            break;
+        entries += cs[i].nb_index_entries;
+    }
+
+    if (ret == AVERROR(ENOMEM)) {
+        goto end;
+    } else if (i < nb_streams) {
+        av_log(s, AV_LOG_WARNING, "Index cache %s is invalid, ignoring it\n",
+               s->index_cache);
+        ret = 0;
+        goto end;
+    }
+
+    /* the index of a bisecting demuxer may hold entries which are not
+     * keyframes, it is only kept once every keyframe was added in order */
+    flags &= CACHE_COMPLETE;
+    if (ic->bisect && !flags)
+        entries = 0;
+    for (i = 0; i < nb_streams; i++)
+        if ((ret = apply_stream(s->streams[i], &cs[i], !ic->bisect || flags)) < 0)
+            goto end;
+    s->start_time                 = start_time;
+    s->duration                   = duration;
+    s->bit_rate                   = bit_rate;
+    s->duration_estimation_method = method;
+
+    ic->loaded          = 1;
+    ic->loaded_complete = ic->complete = flags;
+    ic->loaded_entries  = entries;
+    ret = 1;
+
+end:
+    for (i = 0; i < nb_streams; i++) {
+        avcodec_parameters_free(&cs[i].par);
+        av_freep(&cs[i].index_entries);
+    }
+    av_free(cs);
+    return ret;
+}
+
+int ff_index_cache_load(AVFormatContext *s)
+{
+    FFIndexCache *ic;
+    AVIOContext *pb = NULL;
+    int ret;
+
+    if (!s->index_cache || !*s->index_cache || !s->pb ||
+        (s->flags & AVFMT_FLAG_CUSTOM_IO) ||
+        !(s->pb->seekable & AVIO_SEEKABLE_NORMAL))
+        return 0;
+
+    ic = s->internal->index_cache = av_mallocz(sizeof(*ic));
+    if (!ic)
+        return AVERROR(ENOMEM);
+
+    if ((ret = compute_key(s, ic)) < 0) {
+        av_log(s, AV_LOG_VERBOSE, "Cannot identify the input for the index cache\n");
+        ff_index_cache_free(&s->internal->index_cache);
+        return ret == AVERROR(ENOMEM) ? ret : 0;
+    }
+    ic->nb_streams = s->nb_streams;
+    ic->bisect     = s->iformat->read_timestamp && !s->iformat->read_seek &&
+                     !(s->iformat->flags & AVFMT_NOBINSEARCH);
+    ic->record     = !(s->iformat->flags & AVFMT_GENERIC_INDEX) &&
+                     !s->iformat->read_seek && !s->iformat->read_seek2;
+
+    ret = ffio_open_whitelist(&pb, s->index_cache, AVIO_FLAG_READ,
+                              &s->interrupt_callback, NULL,
+                              s->protocol_whitelist, s->protocol_blacklist);
+    if (ret >= 0) {
+        ret = read_cache(s, ic, pb);
+        avio_closep(&pb);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (ret > 0)
+        av_log(s, AV_LOG_VERBOSE, "Restored %d index entries%s from %s\n",
+               ic->loaded_entries, ic->complete ? " (complete)" : "",
+               s->index_cache);
+    if (ic->complete)
+        ic->record = 0;
+    else
+        ic->linear = 1;
+    return ret > 0;
+}
+
+int ff_index_cache_save(AVFormatContext *s)
+{
+    FFIndexCache *ic = s->internal->index_cache;
+    AVIOContext *pb;
+    char *tmp;
+    int entries = 0, keep_index, i, ret;
+
+    if (!ic)
+        return 0;
+    keep_index = !ic->bisect || ic->complete;
+    for (i = 0; i < s->nb_streams && keep_index; i++)
+        entries += s->streams[i]->nb_index_entries;
+    /* a complete index is only replaced by a complete one */
+    if (ic->loaded && (ic->loaded_complete > ic->complete ||
+                       (ic->loaded_complete == ic->complete &&
+                        entries <= ic->loaded_entries)))
+        return 0;
+    if (s->nb_streams != ic->nb_streams) {
+        av_log(s, AV_LOG_VERBOSE, "Streams were added, not writing index cache\n");
+        return 0;
+    }
+
+    tmp = av_asprintf("%s.tmp", s->index_cache);
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    ret = ffio_open_whitelist(&pb, tmp, AVIO_FLAG_WRITE,
+                              &s->interrupt_callback, NULL,
+                              s->protocol_whitelist, s->protocol_blacklist);
+    if (ret < 0) {
+        av_log(s, AV_LOG_WARNING, "Cannot write index cache %s\n", tmp);
+        goto end;
+    }
+
+    avio_wb32(pb, CACHE_TAG);
+    avio_wb32(pb, CACHE_VERSION);
+    avio_wb64(pb, ic->size);
+    avio_wb64(pb, ic->mtime);
+    avio_write(pb, ic->hash, sizeof(ic->hash));
+    avio_put_str(pb, s->iformat->name);
+    avio_wb32(pb, ic->complete ? CACHE_COMPLETE : 0);
+    avio_wb64(pb, s->start_time);
+    avio_wb64(pb, s->duration);
+    avio_wb64(pb, s->bit_rate);
+    avio_wb32(pb, s->duration_estimation_method);
+    avio_wb32(pb, s->nb_streams);
+    for (i = 0; i < s->nb_streams; i++)
+        write_stream(pb, s->streams[i],
+                     keep_index ? s->streams[i]->nb_index_entries : 0);
+    avio_flush(pb);
+    ret = pb->error;
+    avio_closep(&pb);
+
+    if (ret >= 0)
+        ret = ff_rename(tmp, s->index_cache, s);
+    if (ret >= 0)
+        av_log(s, AV_LOG_VERBOSE, "Wrote %d index entries%s to %s\n", entries,
+               ic->complete ? " (complete)" : "", s->index_cache);
+
+end:
+    av_free(tmp);
+    return ret;
+}
+
+void ff_index_cache_free(FFIndexCache **pic)
+{
+    av_freep(pic);
+}
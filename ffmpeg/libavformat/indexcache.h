@@ -0,0 +1,89 @@
+/*
+ * Persistent demuxer index cache
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_INDEXCACHE_H
+#define AVFORMAT_INDEXCACHE_H
+
+#include <stdint.h>
+
+#include "avformat.h"
+
+/**
+ * State of the index cache of an input, AVFormatInternal.index_cache.
+ *
+ * The cache is a sidecar file holding the stream parameters, the index
+ * entries and the duration found on an earlier open of the same input,
+ * which is identified by its size, modification time and a hash of its
+ * first bytes.
+ */
+typedef struct FFIndexCache {
+    int64_t size;
+    int64_t mtime;
+    uint8_t hash[16];
+
+    /**
+     * The demuxer seeks by bisecting the file with read_timestamp(), which
+     * adds index entries for packets that are not necessarily keyframes.
+     */
+    int bisect;
+
+    /**
+     * Add an index entry for every keyframe returned by read_frame_internal().
+     * Set for demuxers which seek by bisection and keep no index of their own.
+     */
+    int record;
+
+    /**
+     * Set while the packets have been read from the start without seeking,
+     * so that reaching EOF means every keyframe is in the index.
+     */
+    int linear;
+
+    /**
+     * Every keyframe of the input is in the index, seeking can go straight
+     * to the index entries instead of bisecting the file.
+     */
+    int complete;
+
+    int nb_streams;         ///< number of streams when the key was computed
+    int loaded;             ///< the parameters were restored from the cache file
+    int loaded_complete;
+    int loaded_entries;
+} FFIndexCache;
+
+/**
+ * Compute the key of the input and, if s->index_cache names a valid cache
+ * file for it, restore the stream parameters, index entries and durations.
+ * The index of a demuxer which bisects the file is only restored if it was
+ * complete.
+ *
+ * @return 1 if the parameters were restored, 0 if the input has to be
+ *         probed, a negative AVERROR code on allocation failure
+ */
+int ff_index_cache_load(AVFormatContext *s);
+
+/**
+ * Write the cache file if the index grew since it was loaded.
+ */
+int ff_index_cache_save(AVFormatContext *s);
+
+void ff_index_cache_free(FFIndexCache **pic);
+
+#endif /* AVFORMAT_INDEXCACHE_H */
@@ -150,6 +150,11 @@ struct AVFormatInternal {
      * Prefer the codec framerate for avg_frame_rate computation.
      */
     int prefer_codec_framerate;
+
+    /**
+     * State of the index cache, NULL if it is not used.
+     */
+    struct FFIndexCache *index_cache;
 };
 
 struct AVStreamInternal {
@@ -127,6 +127,63 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/**
+ * State of the sample table walk of mov_build_index() before a sample.
+ */
+typedef struct MOVIndexCursor {
+    unsigned int sample;
+    unsigned int chunk;
+    unsigned int chunk_sample;  ///< sample in the chunk, UINT_MAX before the chunk is entered
+    unsigned int stsc_index;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    unsigned int stss_index;
+    unsigned int stps_index;
+    unsigned int rap_group_index;
+    unsigned int rap_group_sample;
+    unsigned int distance;
+    int64_t offset;
+    int64_t dts;
+} MOVIndexCursor;
+
+/**
+ * Run of index entries which are consecutive samples of the sample tables,
+ * with their timestamps shifted by the same amount.
+ */
+typedef struct MOVIndexSegment {
+    int start;                  ///< index of the first entry
+    int count;
+    unsigned int sample;        ///< sample of the first entry
+    int discard;                ///< the entries are marked AVINDEX_DISCARD_FRAME
+    int64_t offset;             ///< added to the timestamps of the samples
+} MOVIndexSegment;
+
+/**
+ * Index entries generated from the sample tables on demand, see the
+ * lazy_index option. The demuxer reads them through a window of the index,
+ * st->index_entries holds one key frame every MOV_INDEX_POINT_DIST entries
+ * so that users of the public index see the whole stream.
+ */
+typedef struct MOVLazyIndex {
+    int nb_samples;             ///< number of samples in the sample tables
+    int nb_entries;             ///< number of index entries
+    AVIndexEntry *window;
+    int window_start;           ///< index of window[0]
+    int window_count;           ///< number of entries in the window
+    int window_size;            ///< allocated number of entries
+    int key_off;
+    int rap_group_present;
+
+    MOVIndexCursor *points;     ///< cursors every MOV_INDEX_POINT_DIST samples
+    int nb_points;
+    MOVIndexCursor cursor;      ///< cursor after the last generated sample
+    AVIndexEntry sample;        ///< last generated sample
+
+    MOVIndexSegment *segments;
+    int nb_segments;
+    unsigned int segments_allocated_size;
+} MOVLazyIndex;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int pb_is_copied;
@@ -202,6 +259,11 @@ typedef struct MOVStreamContext {
     uint32_t format;
 
     int has_sidx;  // If there is an sidx entry for this stream.
+
+    int64_t next_sample_pos;    ///< position of index_entries[current_sample]
+    int64_t next_sample_dts;    ///< its timestamp in AV_TIME_BASE units
+    int heap_index[2];          ///< position in MOVContext.sample_heap
+    MOVLazyIndex *lazy_index;
     struct {
         int use_subsamples;
         uint8_t* auxiliary_info;
@@ -265,6 +327,16 @@ typedef struct MOVContext {
     int decryption_key_len;
     int enable_drefs;
     int32_t movie_display_matrix[3][3]; ///< display matrix from mvhd
+
+    /**
+     * Streams with samples left, ordered by the position and by the dts of
+     * their next sample, for mov_find_next_sample().
+     */
+    int *sample_heap[2];
+    int sample_heap_size;
+    int sample_heap_valid;  ///< cleared when the sample cursors are moved
+    int sample_heap_scan;   ///< the heaps cannot be used, scan all streams
+    int lazy_index;
 } MOVContext;
 
 int ff_mp4_read_descr_len(AVIOContext *pb);
@@ -2837,10 +2837,465 @@ static int get_edit_list_entry(MOVContext *mov,
     return 1;
 }
 
+#define MOV_INDEX_POINT_DIST 1024
+#define MOV_INDEX_WINDOW     2048
+
+/**
+ * Generate the next sample of the sample tables, as the loop of
+ * mov_build_index() does.
+ *
+ * @return 1 if a sample was generated, 0 at the end of the tables, a negative
+ *         value if mov_build_index() would have to fix or reject the tables
+ */
+static int mov_index_cursor_next(MOVStreamContext *sc, AVStream *st,
+                                 MOVLazyIndex *li, MOVIndexCursor *c,
+                                 AVIndexEntry *e)
+{
+    unsigned int sample_size;
+    int keyframe = 0;
+
+    for (;;) {
+        if (c->chunk >= sc->chunk_count)
+            return 0;
+        if (c->chunk_sample == UINT_MAX) {
+            int64_t next_offset = c->chunk + 1 < sc->chunk_count ?
+                                  sc->chunk_offsets[c->chunk + 1] : INT64_MAX;
+            c->offset = sc->chunk_offsets[c->chunk];
+            while (mov_stsc_index_valid(c->stsc_index, sc->stsc_count) &&
+                   c->chunk + 1 == sc->stsc_data[c->stsc_index + 1].first)
+                c->stsc_index++;
+            if (next_offset > c->offset && sc->sample_size > 0 &&
+                sc->sample_size < sc->stsz_sample_size &&
+                sc->stsc_data[c->stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - c->offset)
+                return AVERROR_INVALIDDATA;
+            c->chunk_sample = 0;
+        }
+        if (c->chunk_sample < sc->stsc_data[c->stsc_index].count)
+            break;
+        c->chunk++;
+        c->chunk_sample = UINT_MAX;
+    }
+    if (c->sample >= sc->sample_count)
+        return AVERROR_INVALIDDATA;
+
+    if (!sc->keyframe_absent && (!sc->keyframe_count || c->sample + li->key_off == sc->keyframes[c->stss_index])) {
+        keyframe = 1;
+        if (c->stss_index + 1 < sc->keyframe_count)
+            c->stss_index++;
+    } else if (sc->stps_count && c->sample + li->key_off == sc->stps_data[c->stps_index]) {
+        keyframe = 1;
+        if (c->stps_index + 1 < sc->stps_count)
+            c->stps_index++;
+    }
+    if (li->rap_group_present && c->rap_group_index < sc->rap_group_count) {
+        if (sc->rap_group[c->rap_group_index].index > 0)
+            keyframe = 1;
+        if (++c->rap_group_sample == sc->rap_group[c->rap_group_index].count) {
+            c->rap_group_sample = 0;
+            c->rap_group_index++;
+        }
+    }
+    if (sc->keyframe_absent
+        && !sc->stps_count
+        && !li->rap_group_present
+        && (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || (c->chunk == 0 && c->chunk_sample == 0)))
+         keyframe = 1;
+    if (keyframe)
+        c->distance = 0;
+    sample_size = sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[c->sample];
+    if (sample_size > 0x3FFFFFFF)
+        return AVERROR_INVALIDDATA;
+
+    e->pos          = c->offset;
+    e->timestamp    = c->dts;
+    e->size         = sample_size;
+    e->min_distance = c->distance;
+    e->flags        = keyframe ? AVINDEX_KEYFRAME : 0;
+
+    c->offset += sample_size;
+    c->dts    += sc->stts_data[c->stts_index].duration;
+    c->distance++;
+    c->stts_sample++;
+    c->sample++;
+    c->chunk_sample++;
+    if (c->stts_index + 1 < sc->stts_count && c->stts_sample == sc->stts_data[c->stts_index].count) {
+        c->stts_sample = 0;
+        c->stts_index++;
+    }
+    return 1;
+}
+
+/**
+ * Get the index entry the sample tables give for a sample, before the edit
+ * lists are applied. The entry is valid until the next call.
+ */
+static const AVIndexEntry *mov_lazy_sample(AVStream *st, unsigned int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+
+    if (sample + 1 == li->cursor.sample)
+        return &li->sample;
+    if (sample < li->cursor.sample ||
+        sample / MOV_INDEX_POINT_DIST * MOV_INDEX_POINT_DIST > li->cursor.sample)
+        li->cursor = li->points[sample / MOV_INDEX_POINT_DIST];
+    while (li->cursor.sample <= sample)
+        if (mov_index_cursor_next(sc, st, li, &li->cursor, &li->sample) <= 0)
+            break;
+    return &li->sample;
+}
+
+static MOVIndexSegment *mov_lazy_segment(MOVLazyIndex *li, int index)
+{
+    int a = 0, b = li->nb_segments - 1;
+
+    while (a < b) {
+        int m = (a + b + 1) >> 1;
+        if (li->segments[m].start <= index)
+            a = m;
+        else
+            b = m - 1;
+    }
+    return &li->segments[a];
+}
+
+static void mov_lazy_entry(AVStream *st, int index, AVIndexEntry *e)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVIndexSegment *seg = mov_lazy_segment(sc->lazy_index, index);
+
+    *e = *mov_lazy_sample(st, seg->sample + index - seg->start);
+    e->timestamp += seg->offset;
+    if (seg->discard)
+        e->flags |= AVINDEX_DISCARD_FRAME;
+}
+
+static void mov_lazy_fill_window(AVStream *st, int start)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+    int i;
+
+    li->window_start = start;
+    li->window_count = FFMIN(li->window_size, li->nb_entries - start);
+    for (i = 0; i < li->window_count; i++)
+        mov_lazy_entry(st, start + i, &li->window[i]);
+}
+
+/**
+ * Fill st->index_entries with the first key frame of every
+ * MOV_INDEX_POINT_DIST index entries, for av_index_search_timestamp() and
+ * the other users of the index outside of the demuxer.
+ */
+static int mov_lazy_build_coarse_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+    AVIndexEntry *entries, e;
+    int nb_entries = 0, i, j;
+
+    entries = av_malloc_array(li->nb_entries / MOV_INDEX_POINT_DIST + 1, sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < li->nb_entries; i += MOV_INDEX_POINT_DIST) {
+        for (j = i; j < FFMIN(i + MOV_INDEX_POINT_DIST, li->nb_entries); j++) {
+            mov_lazy_entry(st, j, &e);
+            if ((e.flags & AVINDEX_KEYFRAME) && !(e.flags & AVINDEX_DISCARD_FRAME)) {
+                entries[nb_entries++] = e;
+                break;
+            }
+        }
+    }
+
+    av_free(st->index_entries);
+    st->index_entries                = entries;
+    st->nb_index_entries             = nb_entries;
+    st->index_entries_allocated_size = (li->nb_entries / MOV_INDEX_POINT_DIST + 1) * sizeof(*entries);
+    return 0;
+}
+
+static int mov_index_count(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    return sc->lazy_index ? sc->lazy_index->nb_entries : st->nb_index_entries;
+}
+
+/**
+ * Get an index entry of a stream. For a lazily indexed stream the entry is
+ * valid until the window of the index is moved by the next call.
+ */
+static AVIndexEntry *mov_index_entry(AVStream *st, int index)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+
+    if (!li)
+        return &st->index_entries[index];
+    if (index < li->window_start)
+        mov_lazy_fill_window(st, FFMAX(index - li->window_size + 1, 0));
+    else if (index >= li->window_start + li->window_count)
+        mov_lazy_fill_window(st, index);
+    return &li->window[index - li->window_start];
+}
+
+/**
+ * ff_index_search_timestamp() over the index entries of a lazily indexed
+ * stream, or over its sample table entries if samples is set.
+ */
+static int mov_lazy_search(AVStream *st, int samples, int64_t wanted_timestamp, int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+    int nb_entries = samples ? li->nb_samples : li->nb_entries;
+    AVIndexEntry e;
+    int a, b, m;
+
+#define GET_ENTRY(i) (samples ? (void)(e = *mov_lazy_sample(st, i)) : mov_lazy_entry(st, i, &e))
+    a = -1;
+    b = nb_entries;
+
+    if (b) {
+        GET_ENTRY(b - 1);
+        if (e.timestamp < wanted_timestamp)
+            a = b - 1;
+    }
+
+    while (b - a > 1) {
+        m = (a + b) >> 1;
+        GET_ENTRY(m);
+
+        while ((e.flags & AVINDEX_DISCARD_FRAME) && m < b && m < nb_entries - 1) {
+            m++;
+            GET_ENTRY(m);
+            if (m == b && e.timestamp >= wanted_timestamp) {
+                m = b - 1;
+                GET_ENTRY(m);
+                break;
+            }
+        }
+
+        if (e.timestamp >= wanted_timestamp)
+            b = m;
+        if (e.timestamp <= wanted_timestamp)
+            a = m;
+    }
+    m = (flags & AVSEEK_FLAG_BACKWARD) ? a : b;
+
+    if (!(flags & AVSEEK_FLAG_ANY)) {
+        while (m >= 0 && m < nb_entries) {
+            if (samples)
+                GET_ENTRY(m);
+            else
+                e = *mov_index_entry(st, m);
+            if (e.flags & AVINDEX_KEYFRAME)
+                break;
+            m += (flags & AVSEEK_FLAG_BACKWARD) ? -1 : 1;
+        }
+    }
+#undef GET_ENTRY
+
+    if (m == nb_entries)
+        return -1;
+    return m;
+}
+
+/**
+ * Append an index entry for a sample with its timestamp shifted by offset,
+ * as add_index_entry() does for an index which is not lazy.
+ */
+static int64_t mov_lazy_add_entry(MOVLazyIndex *li, unsigned int sample,
+                                  int64_t offset, int discard)
+{
+    MOVIndexSegment *seg = li->nb_segments ? &li->segments[li->nb_segments - 1] : NULL;
+
+    if (!seg || seg->sample + seg->count != sample ||
+        seg->offset != offset || seg->discard != discard) {
+        if ((unsigned)li->nb_segments + 1 >= UINT_MAX / sizeof(*seg))
+            return -1;
+        seg = av_fast_realloc(li->segments, &li->segments_allocated_size,
+                              (li->nb_segments + 1) * sizeof(*seg));
+        if (!seg)
+            return -1;
+        li->segments = seg;
+        seg = &li->segments[li->nb_segments++];
+        seg->start   = li->nb_entries;
+        seg->count   = 0;
+        seg->sample  = sample;
+        seg->offset  = offset;
+        seg->discard = discard;
+    }
+    seg->count++;
+    return li->nb_entries++;
+}
+
+static void mov_lazy_set_timestamp(AVStream *st, int index, int64_t timestamp)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+    MOVIndexSegment *seg = mov_lazy_segment(li, index);
+    int64_t offset = timestamp - mov_lazy_sample(st, seg->sample + index - seg->start)->timestamp;
+    int k, split;
+
+    if (seg->offset == offset)
+        return;
+    if (seg->count > 1) {
+        /* split the segment around the entry */
+        split = (index > seg->start) + (index < seg->start + seg->count - 1);
+        k     = seg - li->segments;
+        seg   = av_fast_realloc(li->segments, &li->segments_allocated_size,
+                                (li->nb_segments + split) * sizeof(*seg));
+        if (!seg)
+            return;
+        li->segments = seg;
+        memmove(&seg[k + 1 + split], &seg[k + 1],
+                (li->nb_segments - k - 1) * sizeof(*seg));
+        li->nb_segments += split;
+        seg = &li->segments[k];
+        if (index > seg->start) {
+            seg[1]        = seg[0];
+            seg[0].count  = index - seg->start;
+            seg++;
+            seg->sample  += index - seg->start;
+            seg->count   -= index - seg->start;
+            seg->start    = index;
+        }
+        if (seg->count > 1) {
+            seg[1]         = seg[0];
+            seg[1].start  += 1;
+            seg[1].sample += 1;
+            seg[1].count  -= 1;
+            seg->count     = 1;
+        }
+    }
+    seg->offset = offset;
+}
+
+static void mov_free_lazy_index(MOVStreamContext *sc)
+{
+    if (!sc->lazy_index)
+        return;
+    av_freep(&sc->lazy_index->points);
+    av_freep(&sc->lazy_index->segments);
+    av_freep(&sc->lazy_index->window);
+    av_freep(&sc->lazy_index);
+}
+
+/**
+ * Replace the coarse index of a lazily indexed stream by all its index
+ * entries.
+ */
+static int mov_expand_lazy_index(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVLazyIndex *li = sc->lazy_index;
+    AVIndexEntry *entries;
+    int i;
+
+    entries = av_malloc_array(FFMAX(li->nb_entries, 1), sizeof(*entries));
+    if (!entries)
+        return AVERROR(ENOMEM);
+    for (i = 0; i < li->nb_entries; i++)
+        mov_lazy_entry(st, i, &entries[i]);
+    av_free(st->index_entries);
+    st->index_entries                = entries;
+    st->nb_index_entries             = li->nb_entries;
+    st->index_entries_allocated_size = FFMAX(li->nb_entries, 1) * sizeof(*entries);
+    mov_free_lazy_index(sc);
+    return 0;
+}
+
+/**
+ * Walk the sample tables like mov_build_index() without storing the index
+ * entries, keeping a cursor every MOV_INDEX_POINT_DIST samples from which
+ * the entries are generated again when they are needed.
+ *
+ * @return 0 on success, a negative value if the index has to be built in
+ *         full, in which case the stream is left unchanged
+ */
+static int mov_build_lazy_index(MOVContext *mov, AVStream *st, int64_t current_dts)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVIndexCursor cursor = { 0 };
+    MOVLazyIndex *li;
+    AVIndexEntry e;
+    int64_t rfps_dts[99];
+    uint64_t stream_size = 0;
+    unsigned int i;
+    int ret;
+
+    /* the sample tables would be changed while building the index */
+    if (sc->stsz_sample_size > 0 && sc->stsz_sample_size < sc->sample_size)
+        return AVERROR(ENOSYS);
+    for (i = 0; i < sc->stts_count; i++)
+        if (sc->stts_data[i].duration < 0)
+            return AVERROR(ENOSYS);
+    /* samples of other sample descriptions would be skipped */
+    for (i = 0; i < sc->stsc_count && sc->pseudo_stream_id != -1; i++)
+        if (sc->stsc_data[i].id - 1 != sc->pseudo_stream_id)
+            return AVERROR(ENOSYS);
+    if (st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO &&
+        st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO)
+        return AVERROR(ENOSYS);
+
+    li = av_mallocz(sizeof(*li));
+    if (!li)
+        return AVERROR(ENOMEM);
+    li->key_off = (sc->keyframe_count && sc->keyframes[0] > 0) || (sc->stps_count && sc->stps_data[0] > 0);
+    li->rap_group_present = sc->rap_group_count && sc->rap_group;
+
+    cursor.chunk_sample = UINT_MAX;
+    cursor.dts          = current_dts;
+    for (;;) {
+        if (!(cursor.sample % MOV_INDEX_POINT_DIST)) {
+            MOVIndexCursor *points = av_realloc_array(li->points, li->nb_points + 1,
+                                                      sizeof(*li->points));
+            if (!points) {
+                ret = AVERROR(ENOMEM);
+                goto fail;
+            }
+            li->points = points;
+            li->points[li->nb_points++] = cursor;
+        }
+        ret = mov_index_cursor_next(sc, st, li, &cursor, &e);
+        if (ret < 0)
+            goto fail;
+        if (!ret)
+            break;
+        if (cursor.sample < 100)
+            rfps_dts[cursor.sample - 1] = e.timestamp;
+        stream_size += e.size;
+    }
+    if (!cursor.sample) {
+        ret = AVERROR(ENOSYS);
+        goto fail;
+    }
+
+    li->nb_samples = cursor.sample;
+    li->cursor     = li->points[0];
+    sc->lazy_index = li;
+    if (mov_lazy_add_entry(li, 0, 0, 0) < 0) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    li->segments[0].count = li->nb_entries = li->nb_samples;
+
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+        for (i = 0; i < FFMIN(li->nb_samples, 99); i++)
+            ff_rfps_add_frame(mov->fc, st, rfps_dts[i]);
+    if (st->duration > 0)
+        st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+    return 0;
+fail:
+    sc->lazy_index = li;
+    mov_free_lazy_index(sc);
+    return ret;
+}
+
 /**
  * Find the closest previous frame to the timestamp, in e_old index
- * entries. Searching for just any frame / just key frames can be controlled by
- * last argument 'flag'.
+ * entries, or in the sample table entries of a lazily indexed stream if
+ * e_old is NULL. Searching for just any frame / just key frames can be
+ * controlled by last argument 'flag'.
  * Returns the index of the entry in st->index_entries if successful,
  * else returns -1.
  */
@@ -2855,6 +3310,22 @@ static int64_t find_prev_closest_index(AVStream *st,
     int64_t found = -1;
     int64_t i = 0;
 
+    if (!e_old) {
+        found = mov_lazy_search(st, 1, timestamp, flag | AVSEEK_FLAG_BACKWARD);
+
+        if (found >= 0) {
+            int64_t found_timestamp = mov_lazy_sample(st, found)->timestamp;
+            for (i = found; i > 0; i--) {
+                const AVIndexEntry *e = mov_lazy_sample(st, i - 1);
+                if (e->timestamp != found_timestamp)
+                    break;
+                if ((flag & AVSEEK_FLAG_ANY) || (e->flags & AVINDEX_KEYFRAME))
+                    found = i - 1;
+            }
+        }
+        return found;
+    }
+
     st->index_entries = e_old;
     st->nb_index_entries = nb_old;
     found = av_index_search_timestamp(st, timestamp, flag | AVSEEK_FLAG_BACKWARD);
@@ -2930,11 +3401,15 @@ static int64_t add_index_entry(AVStream *st, int64_t pos, int64_t timestamp,
 static void fix_index_entry_timestamps(AVStream* st, int end_index, int64_t end_ts,
                                        int64_t* frame_duration_buffer,
                                        int frame_duration_buffer_size) {
+    MOVStreamContext *sc = st->priv_data;
     int i = 0;
-    av_assert0(end_index >= 0 && end_index <= st->nb_index_entries);
+    av_assert0(end_index >= 0 && end_index <= mov_index_count(st));
     for (i = 0; i < frame_duration_buffer_size; i++) {
         end_ts -= frame_duration_buffer[frame_duration_buffer_size - 1 - i];
-        st->index_entries[end_index - 1 - i].timestamp = end_ts;
+        if (sc->lazy_index)
+            mov_lazy_set_timestamp(st, end_index - 1 - i, end_ts);
+        else
+            st->index_entries[end_index - 1 - i].timestamp = end_ts;
     }
 }
 
@@ -3024,9 +3499,10 @@ static void mov_current_sample_set(MOVStreamContext *sc, int current_sample)
 static void mov_fix_index(MOVContext *mov, AVStream *st)
 {
     MOVStreamContext *msc = st->priv_data;
-    AVIndexEntry *e_old = st->index_entries;
-    int nb_old = st->nb_index_entries;
-    const AVIndexEntry *e_old_end = e_old + nb_old;
+    MOVLazyIndex *li = msc->lazy_index;
+    AVIndexEntry *e_old = li ? NULL : st->index_entries;
+    int nb_old = li ? li->nb_samples : st->nb_index_entries;
+    AVIndexEntry current_entry;
     const AVIndexEntry *current = NULL;
     MOVStts *ctts_data_old = msc->ctts_data;
     int64_t ctts_index_old = 0;
@@ -3056,6 +3532,7 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
     int first_non_zero_audio_edit = -1;
     int packet_skip_samples = 0;
     MOVIndexRange *current_index_range;
+    int64_t ret;
     int i;
 
     if (!msc->elst_data || msc->elst_count <= 0 || nb_old <= 0) {
@@ -3075,6 +3552,8 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
     st->index_entries = NULL;
     st->index_entries_allocated_size = 0;
     st->nb_index_entries = 0;
+    if (li)
+        li->nb_entries = li->nb_segments = 0;
 
     // Clean ctts fields of MOVStreamContext
     msc->ctts_data = NULL;
@@ -3132,7 +3611,8 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
             // Audio decoders like AAC need need a decoder delay samples previous to the current sample,
             // to correctly decode this frame. Hence for audio we seek to a frame 1 sec. before the
             // edit_list_media_time to cover the decoder delay.
-            search_timestamp = FFMAX(search_timestamp - msc->time_scale, e_old[0].timestamp);
+            search_timestamp = FFMAX(search_timestamp - msc->time_scale,
+                                     e_old ? e_old[0].timestamp : mov_lazy_sample(st, 0)->timestamp);
         }
 
         index = find_prev_closest_index(st, e_old, nb_old, search_timestamp, 0);
@@ -3151,8 +3631,6 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
                 edit_list_media_time = 0;
             }
         }
-        current = e_old + index;
-
         ctts_index_old = 0;
         ctts_sample_old = 0;
 
@@ -3171,10 +3649,16 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
 
         // Iterate over index and arrange it according to edit list
         edit_list_start_encountered = 0;
-        for (; current < e_old_end; current++, index++) {
+        for (; index < nb_old; index++) {
+            current_entry = e_old ? e_old[index] : *mov_lazy_sample(st, index);
+            current = &current_entry;
+
             // check  if frame outside edit list mark it for discard
-            frame_duration = (current + 1 <  e_old_end) ?
-                             ((current + 1)->timestamp - current->timestamp) : edit_list_duration;
+            if (index + 1 < nb_old)
+                frame_duration = (e_old ? e_old[index + 1].timestamp : mov_lazy_sample(st, index + 1)->timestamp) -
+                                 current->timestamp;
+            else
+                frame_duration = edit_list_duration;
 
             flags = current->flags;
 
@@ -3219,7 +3703,7 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
                         // Make timestamps strictly monotonically increasing for audio, by rewriting timestamps for
                         // discarded packets.
                         if (frame_duration_buffer) {
-                            fix_index_entry_timestamps(st, st->nb_index_entries, edit_list_dts_counter,
+                            fix_index_entry_timestamps(st, mov_index_count(st), edit_list_dts_counter,
                                                        frame_duration_buffer, num_discarded_begin);
                             av_freep(&frame_duration_buffer);
                         }
@@ -3258,15 +3742,20 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
                     // Make timestamps strictly monotonically increasing for audio, by rewriting timestamps for
                     // discarded packets.
                     if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO && frame_duration_buffer) {
-                        fix_index_entry_timestamps(st, st->nb_index_entries, edit_list_dts_counter,
+                        fix_index_entry_timestamps(st, mov_index_count(st), edit_list_dts_counter,
                                                    frame_duration_buffer, num_discarded_begin);
                         av_freep(&frame_duration_buffer);
                     }
                 }
             }
 
-            if (add_index_entry(st, current->pos, edit_list_dts_counter, current->size,
-                                current->min_distance, flags) == -1) {
+            if (li)
+                ret = mov_lazy_add_entry(li, index, edit_list_dts_counter - current->timestamp,
+                                         !!(flags & AVINDEX_DISCARD_FRAME));
+            else
+                ret = add_index_entry(st, current->pos, edit_list_dts_counter, current->size,
+                                      current->min_distance, flags);
+            if (ret == -1) {
                 av_log(mov->fc, AV_LOG_ERROR, "Cannot add index entry\n");
                 break;
             }
@@ -3313,6 +3802,8 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
         for (i = 0; i < st->nb_index_entries; ++i) {
             st->index_entries[i].timestamp -= min_corrected_pts;
         }
+        for (i = 0; li && i < li->nb_segments; i++)
+            li->segments[i].offset -= min_corrected_pts;
     }
 
     // Update av stream length
@@ -3400,6 +3891,9 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
             return;
         if (sc->sample_count >= UINT_MAX / sizeof(*st->index_entries) - st->nb_index_entries)
             return;
+        if (mov->lazy_index && !mov->fc->index_cache &&
+            mov_build_lazy_index(mov, st, current_dts) >= 0)
+            goto fix_index;
         if (av_reallocp_array(&st->index_entries,
                               st->nb_index_entries + sc->sample_count,
                               sizeof(*st->index_entries)) < 0) {
@@ -3610,10 +4104,22 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
         }
     }
 
+fix_index:
     if (!mov->ignore_editlist && mov->advanced_editlist) {
         // Fix index according to edit lists.
         mov_fix_index(mov, st);
     }
+
+    if (sc->lazy_index) {
+        MOVLazyIndex *li = sc->lazy_index;
+        li->window_size = FFMIN(li->nb_entries, MOV_INDEX_WINDOW);
+        li->window      = av_malloc_array(FFMAX(li->window_size, 1), sizeof(*li->window));
+        if (!li->window || mov_lazy_build_coarse_index(st) < 0) {
+            mov_free_lazy_index(sc);
+            return;
+        }
+        mov_lazy_fill_window(st, 0);
+    }
 }
 
 static int test_same_origin(const char *src, const char *ref) {
@@ -3831,6 +4337,10 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             st->need_parsing = AVSTREAM_PARSE_FULL;
     }
+    /* The index entries of a lazily indexed stream are generated from these. */
+    if (sc->lazy_index)
+        return 0;
+
     /* Do not need those anymore. */
     av_freep(&sc->chunk_offsets);
     av_freep(&sc->sample_sizes);
@@ -4274,6 +4784,8 @@ static int mov_read_trun(MOVContext *c, AVIOContext *pb, MOVAtom atom)
     sc = st->priv_data;
     if (sc->pseudo_stream_id+1 != frag->stsd_id && sc->pseudo_stream_id != -1)
         return 0;
+    if (sc->lazy_index && (err = mov_expand_lazy_index(st)) < 0)
+        return err;
     avio_r8(pb); /* version */
     flags = avio_rb24(pb);
     entries = avio_rb32(pb);
@@ -5957,6 +6469,7 @@ static int mov_read_close(AVFormatContext *s)
         av_freep(&sc->rap_group);
         av_freep(&sc->display_matrix);
         av_freep(&sc->index_ranges);
+        mov_free_lazy_index(sc);
 
         if (sc->extradata)
             for (j = 0; j < sc->stsd_count; j++)
@@ -5988,6 +6501,7 @@ static int mov_read_close(AVFormatContext *s)
 
     av_freep(&mov->trex_data);
     av_freep(&mov->bitrates);
+    av_freep(&mov->sample_heap[0]);
 
     for (i = 0; i < mov->fragment_index_count; i++) {
         MOVFragmentIndex* index = mov->fragment_index_data[i];
@@ -6348,7 +6862,7 @@ static int mov_read_header(AVFormatContext *s)
     return 0;
 }
 
-static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
+static AVIndexEntry *mov_scan_next_sample(AVFormatContext *s, AVStream **st)
 {
     AVIndexEntry *sample = NULL;
     int64_t best_dts = INT64_MAX;
@@ -6356,8 +6870,8 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *avst = s->streams[i];
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample];
+        if (msc->pb && msc->current_sample < mov_index_count(avst)) {
+            AVIndexEntry *current_sample = mov_index_entry(avst, msc->current_sample);
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
             if (!sample || (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) && current_sample->pos < sample->pos) ||
@@ -6374,6 +6888,171 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     return sample;
 }
 
+#define POS_HEAP 0
+#define DTS_HEAP 1
+
+static int sample_heap_less(AVFormatContext *s, int heap, int a, int b)
+{
+    MOVStreamContext *sa = s->streams[a]->priv_data;
+    MOVStreamContext *sb = s->streams[b]->priv_data;
+
+    if (heap == POS_HEAP)
+        return sa->next_sample_pos <  sb->next_sample_pos ||
+              (sa->next_sample_pos == sb->next_sample_pos && a < b);
+    return sa->next_sample_dts < sb->next_sample_dts;
+}
+
+static void sample_heap_swap(AVFormatContext *s, int heap, int i, int j)
+{
+    MOVContext *mov = s->priv_data;
+    int *h = mov->sample_heap[heap];
+    MOVStreamContext *sc;
+
+    FFSWAP(int, h[i], h[j]);
+    sc = s->streams[h[i]]->priv_data;
+    sc->heap_index[heap] = i;
+    sc = s->streams[h[j]]->priv_data;
+    sc->heap_index[heap] = j;
+}
+
+static void sample_heap_sift_down(AVFormatContext *s, int heap, int i)
+{
+    MOVContext *mov = s->priv_data;
+    int *h = mov->sample_heap[heap];
+    int n  = mov->sample_heap_size;
+
+    for (;;) {
+        int c = 2 * i + 1;
+        if (c >= n)
+            break;
+        if (c + 1 < n && sample_heap_less(s, heap, h[c + 1], h[c]))
+            c++;
+        if (!sample_heap_less(s, heap, h[c], h[i]))
+            break;
+        sample_heap_swap(s, heap, i, c);
+        i = c;
+    }
+}
+
+static void sample_heap_sift(AVFormatContext *s, int heap, int i)
+{
+    MOVContext *mov = s->priv_data;
+    int *h = mov->sample_heap[heap];
+
+    while (i > 0 && sample_heap_less(s, heap, h[i], h[(i - 1) >> 1])) {
+        sample_heap_swap(s, heap, i, (i - 1) >> 1);
+        i = (i - 1) >> 1;
+    }
+    sample_heap_sift_down(s, heap, i);
+}
+
+static int sample_heap_key(AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    AVIndexEntry *e;
+
+    if (!sc->pb || sc->current_sample >= mov_index_count(st))
+        return 0;
+    e = mov_index_entry(st, sc->current_sample);
+    sc->next_sample_pos = e->pos;
+    sc->next_sample_dts = av_rescale(e->timestamp, AV_TIME_BASE, sc->time_scale);
+    return 1;
+}
+
+static void sample_heap_build(AVFormatContext *s)
+{
+    MOVContext *mov = s->priv_data;
+    int i, heap;
+
+    mov->sample_heap_valid = 1;
+    mov->sample_heap_size  = 0;
+    mov->sample_heap_scan  = 0;
+    if (!mov->sample_heap[0]) {
+        mov->sample_heap[0] = av_malloc_array(s->nb_streams, 2 * sizeof(int));
+        if (!mov->sample_heap[0]) {
+            mov->sample_heap_scan = 1;
+            return;
+        }
+        mov->sample_heap[1] = mov->sample_heap[0] + s->nb_streams;
+    }
+
+    for (i = 0; i < s->nb_streams; i++) {
+        MOVStreamContext *sc = s->streams[i]->priv_data;
+        if (!sample_heap_key(s->streams[i]))
+            continue;
+        /* samples of other files are ordered by dts alone */
+        if (sc->pb != s->pb)
+            mov->sample_heap_scan = 1;
+        for (heap = 0; heap < 2; heap++) {
+            sc->heap_index[heap] = mov->sample_heap_size;
+            mov->sample_heap[heap][mov->sample_heap_size] = i;
+        }
+        mov->sample_heap_size++;
+    }
+    for (heap = 0; heap < 2; heap++)
+        for (i = mov->sample_heap_size / 2 - 1; i >= 0; i--)
+            sample_heap_sift_down(s, heap, i);
+}
+
+/**
+ * Move a stream in the heaps after its current sample was incremented.
+ */
+static void sample_heap_update(AVFormatContext *s, AVStream *st)
+{
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *sc = st->priv_data;
+    int heap;
+
+    if (!mov->sample_heap_valid || mov->sample_heap_scan)
+        return;
+    if (sample_heap_key(st)) {
+        for (heap = 0; heap < 2; heap++)
+            sample_heap_sift(s, heap, sc->heap_index[heap]);
+        return;
+    }
+    mov->sample_heap_size--;
+    for (heap = 0; heap < 2; heap++) {
+        int i = sc->heap_index[heap];
+        if (i == mov->sample_heap_size)
+            continue;
+        sample_heap_swap(s, heap, i, mov->sample_heap_size);
+        sample_heap_sift(s, heap, i);
+    }
+}
+
+/**
+ * Find the sample mov_scan_next_sample() would pick, without scanning all
+ * the streams in the common case.
+ *
+ * If the stream with the lowest next sample position is within AV_TIME_BASE
+ * of the lowest next dts, the scan picks it as soon as it reaches it and
+ * never replaces it, because no other sample is both earlier in the file
+ * and more than AV_TIME_BASE earlier in time. Otherwise the scan is run.
+ */
+static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
+{
+    MOVContext *mov = s->priv_data;
+    MOVStreamContext *sc;
+    int first;
+
+    if (!mov->sample_heap_valid)
+        sample_heap_build(s);
+    if (mov->sample_heap_scan)
+        return mov_scan_next_sample(s, st);
+    if (!mov->sample_heap_size)
+        return NULL;
+
+    first = mov->sample_heap[POS_HEAP][0];
+    sc    = s->streams[first]->priv_data;
+    if (s->pb->seekable & AVIO_SEEKABLE_NORMAL) {
+        MOVStreamContext *dsc = s->streams[mov->sample_heap[DTS_HEAP][0]]->priv_data;
+        if (sc->next_sample_dts - dsc->next_sample_dts > AV_TIME_BASE)
+            return mov_scan_next_sample(s, st);
+    }
+    *st = s->streams[first];
+    return mov_index_entry(*st, sc->current_sample);
+}
+
 static int should_retry(AVIOContext *pb, int error_code) {
     if (error_code == AVERROR_EOF || avio_feof(pb))
         return 0;
@@ -6393,6 +7072,7 @@ static int mov_switch_root(AVFormatContext *s, int64_t target)
     }
 
     mov->next_root_atom = 0;
+    mov->sample_heap_valid = 0;
 
     for (i = 0; i < mov->fragment_index_count; i++) {
         MOVFragmentIndex *index = mov->fragment_index_data[i];
@@ -6454,7 +7134,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
 {
     MOVContext *mov = s->priv_data;
     MOVStreamContext *sc;
-    AVIndexEntry *sample;
+    AVIndexEntry *sample, lazy_sample;
     AVStream *st = NULL;
     int64_t current_index;
     int ret;
@@ -6469,9 +7149,15 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         goto retry;
     }
     sc = st->priv_data;
+    if (sc->lazy_index) {
+        /* looking up the next sample may move the window of the index */
+        lazy_sample = *sample;
+        sample = &lazy_sample;
+    }
     /* must be done just before reading, to avoid infinite loop on sample */
     current_index = sc->current_index;
     mov_current_sample_inc(sc);
+    sample_heap_update(s, st);
 
     if (mov->next_root_atom) {
         sample->pos = FFMIN(sample->pos, mov->next_root_atom);
@@ -6485,6 +7171,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
                    sc->ffindex, sample->pos);
             if (should_retry(sc->pb, ret64)) {
                 mov_current_sample_dec(sc);
+                mov->sample_heap_valid = 0;
             }
             return AVERROR_INVALIDDATA;
         }
@@ -6498,6 +7185,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             if (should_retry(sc->pb, ret)) {
                 mov_current_sample_dec(sc);
+                mov->sample_heap_valid = 0;
             }
             return ret;
         }
@@ -6543,8 +7231,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             sc->ctts_sample = 0;
         }
     } else {
-        int64_t next_dts = (sc->current_sample < st->nb_index_entries) ?
-            st->index_entries[sc->current_sample].timestamp : st->duration;
+        int64_t next_dts = (sc->current_sample < mov_index_count(st)) ?
+            mov_index_entry(st, sc->current_sample)->timestamp : st->duration;
         pkt->duration = next_dts - pkt->dts;
         pkt->pts = pkt->dts;
     }
@@ -6621,9 +7309,12 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
-    sample = av_index_search_timestamp(st, timestamp, flags);
+    if (sc->lazy_index)
+        sample = mov_lazy_search(st, 0, timestamp, flags);
+    else
+        sample = av_index_search_timestamp(st, timestamp, flags);
     av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-    if (sample < 0 && st->nb_index_entries && timestamp < st->index_entries[0].timestamp)
+    if (sample < 0 && mov_index_count(st) && timestamp < mov_index_entry(st, 0)->timestamp)
         sample = 0;
     if (sample < 0) /* not sure what to do */
         return AVERROR_INVALIDDATA;
@@ -6668,6 +7359,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
     if (stream_index >= s->nb_streams)
         return AVERROR_INVALIDDATA;
 
+    mc->sample_heap_valid = 0;
     st = s->streams[stream_index];
     sample = mov_seek_stream(s, st, sample_time, flags);
     if (sample < 0)
@@ -6675,7 +7367,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = st->index_entries[sample].timestamp;
+        int64_t seek_timestamp = mov_index_entry(st, sample)->timestamp;
 
         for (i = 0; i < s->nb_streams; i++) {
             int64_t timestamp;
@@ -6696,6 +7388,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
             sc = st->priv_data;
             mov_current_sample_set(sc, 0);
         }
+        mc->sample_heap_valid = 0;
         while (1) {
             MOVStreamContext *sc;
             AVIndexEntry *entry = mov_find_next_sample(s, &st);
@@ -6705,6 +7398,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
             if (sc->ffindex == stream_index && sc->current_sample == sample)
                 break;
             mov_current_sample_inc(sc);
+            sample_heap_update(s, st);
         }
     }
     return 0;
@@ -6753,6 +7447,8 @@ static const AVOption mov_options[] = {
     { "decryption_key", "The media decryption key (hex)", OFFSET(decryption_key), AV_OPT_TYPE_BINARY, .flags = AV_OPT_FLAG_DECODING_PARAM },
     { "enable_drefs", "Enable external track support.", OFFSET(enable_drefs), AV_OPT_TYPE_BOOL,
         {.i64 = 0}, 0, 1, FLAGS },
+    { "lazy_index", "Generate the index entries from the sample tables when they are needed.",
+        OFFSET(lazy_index), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
 
     { NULL },
 };
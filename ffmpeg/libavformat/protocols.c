@@ -42,6 +42,7 @@ extern const URLProtocol ff_icecast_protocol;
 extern const URLProtocol ff_mmsh_protocol;
 extern const URLProtocol ff_mmst_protocol;
 extern const URLProtocol ff_md5_protocol;
+extern const URLProtocol ff_mmap_protocol;
 extern const URLProtocol ff_pipe_protocol;
 extern const URLProtocol ff_prompeg_protocol;
 extern const URLProtocol ff_rtmp_protocol;
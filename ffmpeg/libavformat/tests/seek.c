@@ -79,6 +79,9 @@ int main(int argc, char **argv)
             frame_count = atoi(argv[i+1]);
         } else if(!strcmp(argv[i], "-duration")){
             duration = atoi(argv[i+1]);
+        } else if(!strcmp(argv[i], "-verbose")) {
+            if (atoi(argv[i+1]))
+                av_log_set_level(AV_LOG_VERBOSE);
         } else if(!strcmp(argv[i], "-fastseek")) {
             if (atoi(argv[i+1])) {
                 ic->flags |= AVFMT_FLAG_FAST_SEEK;
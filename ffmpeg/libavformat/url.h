@@ -27,6 +27,7 @@
 #include "avio.h"
 #include "libavformat/version.h"
 
+#include "libavutil/buffer.h"
 #include "libavutil/dict.h"
 #include "libavutil/log.h"
 
@@ -97,6 +98,18 @@ typedef struct URLProtocol {
     int (*url_delete)(URLContext *h);
     int (*url_move)(URLContext *h_src, URLContext *h_dst);
     const char *default_whitelist;
+    /**
+     * Return a new reference to the whole resource mapped into memory and
+     * its size in *size. An AVIOContext reading from such a protocol
+     * points its buffer into the mapping instead of calling url_read().
+     */
+    int (*url_get_mapping)(URLContext *h, AVBufferRef **buf, int64_t *size);
+    /**
+     * Map size bytes of the resource at offset pos into a new buffer of
+     * size + AV_INPUT_BUFFER_PADDING_SIZE bytes with zeroed padding. The
+     * buffer is private to the caller and writable.
+     */
+    int (*url_map_range)(URLContext *h, int64_t pos, int size, AVBufferRef **buf);
 } URLProtocol;
 
 /**
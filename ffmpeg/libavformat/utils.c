@@ -44,6 +44,7 @@
 #include "avformat.h"
 #include "avio_internal.h"
 #include "id3v2.h"
+#include "indexcache.h"
 #include "internal.h"
 #include "metadata.h"
 #if CONFIG_NETWORK
@@ -288,11 +289,22 @@ static int append_packet_chunked(AVIOContext *s, AVPacket *pkt, int size)
 
 int av_get_packet(AVIOContext *s, AVPacket *pkt, int size)
 {
+    int ret;
+
     av_init_packet(pkt);
     pkt->data = NULL;
     pkt->size = 0;
     pkt->pos  = avio_tell(s);
 
+    ret = ffio_read_mapped(s, &pkt->buf, size);
+    if (ret != AVERROR(ENOSYS)) {
+        if (ret < 0)
+            return ret;
+        pkt->data = pkt->buf->data;
+        pkt->size = ret;
+        return ret;
+    }
+
     return append_packet_chunked(s, pkt, size);
 }
 
@@ -1519,6 +1531,9 @@ static int read_frame_internal(AVFormatContext *s, AVPacket *pkt)
         if (ret < 0) {
             if (ret == AVERROR(EAGAIN))
                 return ret;
+            if (ret == AVERROR_EOF && s->internal->index_cache &&
+                s->internal->index_cache->linear)
+                s->internal->index_cache->complete = 1;
             /* flush the parsers */
             for (i = 0; i < s->nb_streams; i++) {
                 st = s->streams[i];
@@ -1790,7 +1805,10 @@ int av_read_frame(AVFormatContext *s, AVPacket *pkt)
 return_packet:
 
     st = s->streams[pkt->stream_index];
-    if ((s->iformat->flags & AVFMT_GENERIC_INDEX) && pkt->flags & AV_PKT_FLAG_KEY) {
+    /* packets split by a parser may have no position to seek to */
+    if ((s->iformat->flags & AVFMT_GENERIC_INDEX ||
+         s->internal->index_cache && s->internal->index_cache->record && pkt->pos >= 0) &&
+        pkt->flags & AV_PKT_FLAG_KEY) {
         ff_reduce_index(s, st->index);
         av_add_index_entry(st, pkt->pos, pkt->dts, 0, 0, AVINDEX_KEYFRAME);
     }
@@ -2424,6 +2442,9 @@ static int seek_frame_internal(AVFormatContext *s, int stream_index,
                                AV_TIME_BASE * (int64_t) st->time_base.num);
     }
 
+    if (s->internal->index_cache)
+        s->internal->index_cache->linear = 0;
+
     /* first, we try the format specific seek */
     if (s->iformat->read_seek) {
         ff_read_frame_flush(s);
@@ -2433,8 +2454,23 @@ static int seek_frame_internal(AVFormatContext *s, int stream_index,
     if (ret >= 0)
         return 0;
 
+    /* the index has every keyframe, no need to bisect the file */
+    if (s->internal->index_cache && s->internal->index_cache->complete &&
+        !(s->iformat->flags & AVFMT_NOGENSEARCH)) {
+        st = s->streams[stream_index];
+        if (st->nb_index_entries)
+            timestamp = FFMAX(timestamp, st->index_entries[0].timestamp);
+        ff_read_frame_flush(s);
+        ret = seek_frame_generic(s, stream_index, timestamp, flags);
+        if (ret >= 0)
+            return ret;
+    }
+
     if (s->iformat->read_timestamp &&
         !(s->iformat->flags & AVFMT_NOBINSEARCH)) {
+        /* bisecting adds entries which are not known to be keyframes */
+        if (s->internal->index_cache)
+            s->internal->index_cache->complete = 0;
         ff_read_frame_flush(s);
         return ff_seek_frame_binary(s, stream_index, timestamp, flags);
     } else if (!(s->iformat->flags & AVFMT_NOGENSEARCH)) {
@@ -2482,6 +2518,8 @@ int avformat_seek_file(AVFormatContext *s, int stream_index, int64_t min_ts,
     if (s->iformat->read_seek2) {
         int ret;
         ff_read_frame_flush(s);
+        if (s->internal->index_cache)
+            s->internal->index_cache->linear = 0;
 
         if (stream_index == -1 && s->nb_streams == 1) {
             AVRational time_base = s->streams[0]->time_base;
@@ -3512,6 +3550,28 @@ int avformat_find_stream_info(AVFormatContext *ic, AVDictionary **options)
 
     flush_codecs = probesize > 0;
 
+    if (ic->index_cache) {
+        ret = ff_index_cache_load(ic);
+        if (ret < 0)
+            return ret;
+        if (ret > 0) {
+            for (i = 0; i < ic->nb_streams; i++) {
+                st    = ic->streams[i];
+                avctx = st->internal->avctx;
+                ret = avcodec_parameters_to_context(avctx, st->codecpar);
+                if (ret < 0)
+                    goto find_stream_info_err;
+                if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO ||
+                    st->codecpar->codec_type == AVMEDIA_TYPE_SUBTITLE)
+                    avctx->time_base = st->time_base;
+                st->internal->orig_codec_id = st->codecpar->codec_id;
+                st->internal->avctx_inited  = 1;
+            }
+            ret = 0;
+            goto update_stream_params;
+        }
+    }
+
     av_opt_set(ic, "skip_clear", "1", AV_OPT_SEARCH_CHILDREN);
 
     max_stream_analyze_duration = max_analyze_duration;
@@ -4013,6 +4073,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
     }
 
+update_stream_params:
     compute_chapters_end(ic);
 
     /* update the stream parameters from the internal codec contexts */
@@ -4332,6 +4393,7 @@ void avformat_free_context(AVFormatContext *s)
     av_freep(&s->chapters);
     av_dict_free(&s->metadata);
     av_dict_free(&s->internal->id3v2_meta);
+    ff_index_cache_free(&s->internal->index_cache);
     av_freep(&s->streams);
     av_freep(&s->internal);
     flush_packet_queue(s);
@@ -4355,6 +4417,9 @@ void avformat_close_input(AVFormatContext **ps)
 
     flush_packet_queue(s);
 
+    if (s->internal->index_cache)
+        ff_index_cache_save(s);
+
     if (s->iformat)
         if (s->iformat->read_close)
             s->iformat->read_close(s);
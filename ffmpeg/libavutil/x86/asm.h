@@ -0,0 +1,195 @@
+/*
+ * copyright (c) 2006 Michael Niedermayer <michaelni@gmx.at>
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+#ifndef AVUTIL_X86_ASM_H
+#define AVUTIL_X86_ASM_H
+
+#include <stdint.h>
+#include "config.h"
+
+typedef struct xmm_reg { uint64_t a, b; } xmm_reg;
+typedef struct ymm_reg { uint64_t a, b, c, d; } ymm_reg;
+
+#if ARCH_X86_64
+#    define FF_OPSIZE "q"
+#    define FF_REG_a "rax"
+#    define FF_REG_b "rbx"
+#    define FF_REG_c "rcx"
+#    define FF_REG_d "rdx"
+#    define FF_REG_D "rdi"
+#    define FF_REG_S "rsi"
+#    define FF_PTR_SIZE "8"
+typedef int64_t x86_reg;
+
+/* FF_REG_SP is defined in Solaris sys headers, so use FF_REG_sp */
+#    define FF_REG_sp "rsp"
+#    define FF_REG_BP "rbp"
+#    define FF_REGBP   rbp
+#    define FF_REGa    rax
+#    define FF_REGb    rbx
+#    define FF_REGc    rcx
+#    define FF_REGd    rdx
+#    define FF_REGSP   rsp
+
+#elif ARCH_X86_32
+
+#    define FF_OPSIZE "l"
+#    define FF_REG_a "eax"
+#    define FF_REG_b "ebx"
+#    define FF_REG_c "ecx"
+#    define FF_REG_d "edx"
+#    define FF_REG_D "edi"
+#    define FF_REG_S "esi"
+#    define FF_PTR_SIZE "4"
+typedef int32_t x86_reg;
+
+#    define FF_REG_sp "esp"
+#    define FF_REG_BP "ebp"
+#    define FF_REGBP   ebp
+#    define FF_REGa    eax
+#    define FF_REGb    ebx
+#    define FF_REGc    ecx
+#    define FF_REGd    edx
+#    define FF_REGSP   esp
+#else
+typedef int x86_reg;
+#endif
+
+#define HAVE_7REGS (ARCH_X86_64 || (HAVE_EBX_AVAILABLE && HAVE_EBP_AVAILABLE))
+#define HAVE_6REGS (ARCH_X86_64 || (HAVE_EBX_AVAILABLE || HAVE_EBP_AVAILABLE))
+
+#if ARCH_X86_64 && defined(PIC)
+#    define BROKEN_RELOCATIONS 1
+#endif
+
+/*
+ * If gcc is not set to support sse (-msse) it will not accept xmm registers
+ * in the clobber list for inline asm. XMM_CLOBBERS takes a list of xmm
+ * registers to be marked as clobbered and evaluates to nothing if they are
+ * not supported, or to the list itself if they are supported. Since a clobber
+ * list may not be empty, XMM_CLOBBERS_ONLY should be used if the xmm
+ * registers are the only in the clobber list.
+ * For example a list with "eax" and "xmm0" as clobbers should become:
+ * : XMM_CLOBBERS("xmm0",) "eax"
+ * and a list with only "xmm0" should become:
+ * XMM_CLOBBERS_ONLY("xmm0")
+ */
+#if HAVE_XMM_CLOBBERS
+#    define XMM_CLOBBERS(...)        __VA_ARGS__
+#    define XMM_CLOBBERS_ONLY(...) : __VA_ARGS__
+#else
+#    define XMM_CLOBBERS(...)
+#    define XMM_CLOBBERS_ONLY(...)
+#endif
+
+/* Use to export labels from asm. */
+#define LABEL_MANGLE(a) EXTERN_PREFIX #a
+
+// Use rip-relative addressing if compiling PIC code on x86-64.
+#if ARCH_X86_64 && defined(PIC)
+#    define LOCAL_MANGLE(a) #a "(%%rip)"
+#else
+#    define LOCAL_MANGLE(a) #a
+#endif
+
+#if HAVE_INLINE_ASM_DIRECT_SYMBOL_REFS
+#   define MANGLE(a) EXTERN_PREFIX LOCAL_MANGLE(a)
+#   define NAMED_CONSTRAINTS_ADD(...)
+#   define NAMED_CONSTRAINTS(...)
+#   define NAMED_CONSTRAINTS_ARRAY_ADD(...)
+#   define NAMED_CONSTRAINTS_ARRAY(...)
+#else
+    /* When direct symbol references are used in code passed to a compiler that does not support them
+     *  then these references need to be converted to named asm constraints instead.
+     * Instead of returning a direct symbol MANGLE now returns a named constraint for that specific symbol.
+     * In order for this to work there must also be a corresponding entry in the asm-interface. To add this
+     *  entry use the macro NAMED_CONSTRAINTS() and pass in a list of each symbol reference used in the
+     *  corresponding block of code. (e.g. NAMED_CONSTRAINTS(var1,var2,var3) where var1 is the first symbol etc. ).
+     * If there are already existing constraints then use NAMED_CONSTRAINTS_ADD to add to the existing constraint list.
+     */
+#   define MANGLE(a) "%["#a"]"
+    // Intel/MSVC does not correctly expand va-args so we need a rather ugly hack in order to get it to work
+#   define FE_0(P,X) P(X)
+#   define FE_1(P,X,X1) P(X), FE_0(P,X1)
+#   define FE_2(P,X,...) P(X), FE_1(P,__VA_ARGS__)
+#   define FE_3(P,X,...) P(X), FE_2(P,__VA_ARGS__)
+#   define FE_4(P,X,...) P(X), FE_3(P,__VA_ARGS__)
+#   define FE_5(P,X,...) P(X), FE_4(P,__VA_ARGS__)
+#   define FE_6(P,X,...) P(X), FE_5(P,__VA_ARGS__)
+#   define FE_7(P,X,...) P(X), FE_6(P,__VA_ARGS__)
+#   define FE_8(P,X,...) P(X), FE_7(P,__VA_ARGS__)
+#   define FE_9(P,X,...) P(X), FE_8(P,__VA_ARGS__)
+#   define FE_10(P,X,...) P(X), FE_9(P,__VA_ARGS__)
+#   define FE_11(P,X,...) P(X), FE_10(P,__VA_ARGS__)
+#   define FE_12(P,X,...) P(X), FE_11(P,__VA_ARGS__)
+#   define FE_13(P,X,...) P(X), FE_12(P,__VA_ARGS__)
+#   define FE_14(P,X,...) P(X), FE_13(P,__VA_ARGS__)
+#   define FE_15(P,X,...) P(X), FE_14(P,__VA_ARGS__)
+#   define FE_16(P,X,...) P(X), FE_15(P,__VA_ARGS__)
+#   define FE_17(P,X,...) P(X), FE_16(P,__VA_ARGS__)
+#   define FE_18(P,X,...) P(X), FE_17(P,__VA_ARGS__)
+#   define FE_19(P,X,...) P(X), FE_18(P,__VA_ARGS__)
+#   define FE_20(P,X,...) P(X), FE_19(P,__VA_ARGS__)
+#   define FE_21(P,X,...) P(X), FE_20(P,__VA_ARGS__)
+#   define FE_22(P,X,...) P(X), FE_21(P,__VA_ARGS__)
+#   define FE_23(P,X,...) P(X), FE_22(P,__VA_ARGS__)
+#   define FE_24(P,X,...) P(X), FE_23(P,__VA_ARGS__)
+#   define FE_25(P,X,...) P(X), FE_24(P,__VA_ARGS__)
+#   define FE_26(P,X,...) P(X), FE_25(P,__VA_ARGS__)
+#   define FE_27(P,X,...) P(X), FE_26(P,__VA_ARGS__)
+#   define FE_28(P,X,...) P(X), FE_27(P,__VA_ARGS__)
+#   define FE_29(P,X,...) P(X), FE_28(P,__VA_ARGS__)
+#   define FE_30(P,X,...) P(X), FE_29(P,__VA_ARGS__)
+#   define FE_31(P,X,...) P(X), FE_30(P,__VA_ARGS__)
+#   define FE_32(P,X,...) P(X), FE_31(P,__VA_ARGS__)
+#   define FE_33(P,X,...) P(X), FE_32(P,__VA_ARGS__)
+#   define FE_34(P,X,...) P(X), FE_33(P,__VA_ARGS__)
+#   define FE_35(P,X,...) P(X), FE_34(P,__VA_ARGS__)
+#   define FE_36(P,X,...) P(X), FE_35(P,__VA_ARGS__)
+#   define FE_37(P,X,...) P(X), FE_36(P,__VA_ARGS__)
+#   define FE_38(P,X,...) P(X), FE_37(P,__VA_ARGS__)
+#   define FE_39(P,X,...) P(X), FE_38(P,__VA_ARGS__)
+#   define FE_40(P,X,...) P(X), FE_39(P,__VA_ARGS__)
+#   define FE_41(P,X,...) P(X), FE_40(P,__VA_ARGS__)
+#   define FE_42(P,X,...) P(X), FE_41(P,__VA_ARGS__)
+#   define FE_43(P,X,...) P(X), FE_42(P,__VA_ARGS__)
+#   define FE_44(P,X,...) P(X), FE_43(P,__VA_ARGS__)
+#   define FE_45(P,X,...) P(X), FE_44(P,__VA_ARGS__)
+#   define FE_46(P,X,...) P(X), FE_45(P,__VA_ARGS__)
+#   define FE_47(P,X,...) P(X), FE_46(P,__VA_ARGS__)
+#   define FE_48(P,X,...) P(X), FE_47(P,__VA_ARGS__)
+#   define FE_49(P,X,...) P(X), FE_48(P,__VA_ARGS__)
+#   define GET_FE_IMPL(_0,_1,_2,_3,_4,_5,_6,_7,_8,_9,_10,_11,_12,_13,_14,_15,_16,_17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32,_33,_34,_35,_36,_37,_38,_39,_40,_41,_42,_43,_44,_45,_46,_47,_48,_49,name,...) name
+#   define GET_FE_GLUE(x, y) x y
+#   define GET_FE(...) GET_FE_GLUE(GET_FE_IMPL, (__VA_ARGS__,FE_49,FE_48,FE_47,FE_46,FE_45,FE_44,FE_43,FE_42,FE_41,FE_40,FE_39,FE_38,FE_37,FE_36,FE_35,FE_34,FE_33,FE_32,FE_31,FE_30,FE_29,FE_28,FE_27,FE_26,FE_25,FE_24,FE_23,FE_22,FE_21,FE_20,FE_19,FE_18,FE_17,FE_16,FE_15,FE_14,FE_13,FE_12,FE_11,FE_10,FE_9,FE_8,FE_7,FE_6,FE_5,FE_4,FE_3,FE_2,FE_1,FE_0))
+#   define FOR_EACH_VA(P,...) GET_FE_GLUE(GET_FE(__VA_ARGS__),(P,__VA_ARGS__))
+#   define NAME_CONSTRAINT(x) [x] "m"(x)
+    // Parameters are a list of each symbol reference required
+#   define NAMED_CONSTRAINTS_ADD(...) , FOR_EACH_VA(NAME_CONSTRAINT,__VA_ARGS__)
+    // Same but without comma for when there are no previously defined constraints
+#   define NAMED_CONSTRAINTS(...) FOR_EACH_VA(NAME_CONSTRAINT,__VA_ARGS__)
+    // Same as above NAMED_CONSTRAINTS except used for passing arrays/pointers instead of normal variables
+#   define NAME_CONSTRAINT_ARRAY(x) [x] "m"(*x)
+#   define NAMED_CONSTRAINTS_ARRAY_ADD(...) , FOR_EACH_VA(NAME_CONSTRAINT_ARRAY,__VA_ARGS__)
+#   define NAMED_CONSTRAINTS_ARRAY(...) FOR_EACH_VA(NAME_CONSTRAINT_ARRAY,__VA_ARGS__)
+#endif
+
+#endif /* AVUTIL_X86_ASM_H */
@@ -0,0 +1,221 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * AVFloatDSPContext functions, SSE2, AVX and FMA3 intrinsics
+ *
+ * The element-wise functions give the same results as the C code, except
+ * for the FMA3 multiply-adds which round once instead of twice.
+ * scalarproduct_float sums in a different order.
+ */
+
+#include "config.h"
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/float_dsp.h"
+#include "libavutil/x86/cpu.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_AVX || HAVE_INTRINSICS_FMA3
+#include <immintrin.h>
+#endif
+
+#define TARGET
+#define FN(name) name ## _sse2
+#define VF __m128
+#define VD __m128d
+#define WF 4
+#define WD 2
+#define LOADF(p)     _mm_loadu_ps(p)
+#define STOREF(p, v) _mm_storeu_ps(p, v)
+#define SET1F(x)     _mm_set1_ps(x)
+#define MULF(a, b)   _mm_mul_ps(a, b)
+#define ADDF(a, b)   _mm_add_ps(a, b)
+#define SUBF(a, b)   _mm_sub_ps(a, b)
+#define MADDF(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define REVF(v)      _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3))
+#define LOADD(p)     _mm_loadu_pd(p)
+#define STORED(p, v) _mm_storeu_pd(p, v)
+#define SET1D(x)     _mm_set1_pd(x)
+#define MULD(a, b)   _mm_mul_pd(a, b)
+#define MADDD(a, b, c) _mm_add_pd(_mm_mul_pd(a, b), c)
+#include "float_dsp_template.c"
+#undef TARGET
+#undef FN
+#undef VF
+#undef VD
+#undef WF
+#undef WD
+#undef LOADF
+#undef STOREF
+#undef SET1F
+#undef MULF
+#undef ADDF
+#undef SUBF
+#undef MADDF
+#undef REVF
+#undef LOADD
+#undef STORED
+#undef SET1D
+#undef MULD
+#undef MADDD
+
+static void vector_fmul_window_sse2(float *dst, const float *src0,
+                                    const float *src1, const float *win,
+                                    int len)
+{
+    int i, j;
+
+    dst  += len;
+    win  += len;
+    src0 += len;
+
+    /* i runs up from -len, j down from len - 1, four at a time: the src1
+     * and win[j] vectors are reversed */
+    for (i = -len, j = len - 4; i + 4 <= 0; i += 4, j -= 4) {
+        __m128 s0 = _mm_loadu_ps(src0 + i);
+        __m128 s1 = _mm_loadu_ps(src1 + j);
+        __m128 wi = _mm_loadu_ps(win  + i);
+        __m128 wj = _mm_loadu_ps(win  + j);
+
+        s1 = _mm_shuffle_ps(s1, s1, _MM_SHUFFLE(0, 1, 2, 3));
+        wj = _mm_shuffle_ps(wj, wj, _MM_SHUFFLE(0, 1, 2, 3));
+        _mm_storeu_ps(dst + i, _mm_sub_ps(_mm_mul_ps(s0, wj), _mm_mul_ps(s1, wi)));
+        s0 = _mm_add_ps(_mm_mul_ps(s0, wi), _mm_mul_ps(s1, wj));
+        _mm_storeu_ps(dst + j, _mm_shuffle_ps(s0, s0, _MM_SHUFFLE(0, 1, 2, 3)));
+    }
+    for (j += 3; i < 0; i++, j--) {
+        float s0 = src0[i];
+        float s1 = src1[j];
+        float wi = win[i];
+        float wj = win[j];
+        dst[i] = s0 * wj - s1 * wi;
+        dst[j] = s0 * wi + s1 * wj;
+    }
+}
+
+static float scalarproduct_float_sse2(const float *v1, const float *v2, int len)
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    float p;
+    int i;
+
+    for (i = 0; i + 8 <= len; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(v1 + i),     _mm_loadu_ps(v2 + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(v1 + i + 4), _mm_loadu_ps(v2 + i + 4)));
+    }
+    if (i + 4 <= len) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(v1 + i), _mm_loadu_ps(v2 + i)));
+        i += 4;
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    p = _mm_cvtss_f32(acc0);
+    for (; i < len; i++)
+        p += v1[i] * v2[i];
+    return p;
+}
+
+#define VF __m256
+#define VD __m256d
+#define WF 8
+#define WD 4
+#define LOADF(p)     _mm256_loadu_ps(p)
+#define STOREF(p, v) _mm256_storeu_ps(p, v)
+#define SET1F(x)     _mm256_set1_ps(x)
+#define MULF(a, b)   _mm256_mul_ps(a, b)
+#define ADDF(a, b)   _mm256_add_ps(a, b)
+#define SUBF(a, b)   _mm256_sub_ps(a, b)
+#define LOADD(p)     _mm256_loadu_pd(p)
+#define STORED(p, v) _mm256_storeu_pd(p, v)
+#define SET1D(x)     _mm256_set1_pd(x)
+#define MULD(a, b)   _mm256_mul_pd(a, b)
+/* reverse within the 128-bit lanes, then swap the lanes */
+#define REVF(v)      _mm256_permute2f128_ps(_mm256_permute_ps(v, _MM_SHUFFLE(0, 1, 2, 3)), \
+                                            _mm256_permute_ps(v, _MM_SHUFFLE(0, 1, 2, 3)), 1)
+
+#if HAVE_INTRINSICS_AVX
+#define TARGET av_target_avx
+#define FN(name) name ## _avx
+#define MADDF(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#define MADDD(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+#include "float_dsp_template.c"
+#undef TARGET
+#undef FN
+#undef MADDF
+#undef MADDD
+#endif /* HAVE_INTRINSICS_AVX */
+
+#if HAVE_INTRINSICS_FMA3
+#define TARGET av_target_fma3
+#define FN(name) name ## _fma3
+#define MADD_ONLY
+#define MADDF(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define MADDD(a, b, c) _mm256_fmadd_pd(a, b, c)
+#include "float_dsp_template.c"
+#undef TARGET
+#undef FN
+#undef MADD_ONLY
+#undef MADDF
+#undef MADDD
+#endif /* HAVE_INTRINSICS_FMA3 */
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+av_cold void ff_float_dsp_init_x86(AVFloatDSPContext *fdsp)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INTRINSICS_SSE2(cpu_flags)) {
+        fdsp->vector_fmul         = vector_fmul_sse2;
+        fdsp->vector_fmac_scalar  = vector_fmac_scalar_sse2;
+        fdsp->vector_fmul_scalar  = vector_fmul_scalar_sse2;
+        fdsp->vector_dmac_scalar  = vector_dmac_scalar_sse2;
+        fdsp->vector_dmul_scalar  = vector_dmul_scalar_sse2;
+        fdsp->vector_fmul_window  = vector_fmul_window_sse2;
+        fdsp->vector_fmul_add     = vector_fmul_add_sse2;
+        fdsp->vector_fmul_reverse = vector_fmul_reverse_sse2;
+        fdsp->butterflies_float   = butterflies_float_sse2;
+        fdsp->scalarproduct_float = scalarproduct_float_sse2;
+    }
+#if HAVE_INTRINSICS_AVX
+    if (INTRINSICS_AVX(cpu_flags)) {
+        fdsp->vector_fmul         = vector_fmul_avx;
+        fdsp->vector_fmac_scalar  = vector_fmac_scalar_avx;
+        fdsp->vector_fmul_scalar  = vector_fmul_scalar_avx;
+        fdsp->vector_dmac_scalar  = vector_dmac_scalar_avx;
+        fdsp->vector_dmul_scalar  = vector_dmul_scalar_avx;
+        fdsp->vector_fmul_add     = vector_fmul_add_avx;
+        fdsp->vector_fmul_reverse = vector_fmul_reverse_avx;
+        fdsp->butterflies_float   = butterflies_float_avx;
+    }
+#endif
+#if HAVE_INTRINSICS_FMA3
+    if (INTRINSICS_FMA3(cpu_flags)) {
+        fdsp->vector_fmac_scalar  = vector_fmac_scalar_fma3;
+        fdsp->vector_dmac_scalar  = vector_dmac_scalar_fma3;
+        fdsp->vector_fmul_add     = vector_fmul_add_fma3;
+    }
+#endif
+#endif /* HAVE_INTRINSICS_SSE2 */
+}
@@ -0,0 +1,143 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Element-wise AVFloatDSPContext functions for one vector width.
+ *
+ * The includer defines TARGET, FN(), VF and VD (float and double vector
+ * types), WF and WD (their number of elements), LOADF/STOREF/SET1F/MULF/
+ * ADDF/SUBF, the same with a D suffix for doubles, MADDF(a, b, c) and
+ * MADDD(a, b, c) computing a * b + c, and REVF() reversing a float vector.
+ * With MADD_ONLY defined, only the functions that multiply and add are
+ * generated.
+ *
+ * Loads and stores are unaligned and the remainder of len that does not
+ * fill a vector is done in C, so these accept any alignment and length.
+ */
+
+#ifndef MADD_ONLY
+static TARGET void FN(vector_fmul)(float *dst, const float *src0,
+                                   const float *src1, int len)
+{
+    int i;
+
+    for (i = 0; i + WF <= len; i += WF)
+        STOREF(dst + i, MULF(LOADF(src0 + i), LOADF(src1 + i)));
+    for (; i < len; i++)
+        dst[i] = src0[i] * src1[i];
+}
+#endif
+
+static TARGET void FN(vector_fmac_scalar)(float *dst, const float *src,
+                                          float mul, int len)
+{
+    const VF m = SET1F(mul);
+    int i;
+
+    for (i = 0; i + 2 * WF <= len; i += 2 * WF) {
+        STOREF(dst + i,      MADDF(LOADF(src + i),      m, LOADF(dst + i)));
+        STOREF(dst + i + WF, MADDF(LOADF(src + i + WF), m, LOADF(dst + i + WF)));
+    }
+    for (; i < len; i++)
+        dst[i] += src[i] * mul;
+}
+
+#ifndef MADD_ONLY
+static TARGET void FN(vector_fmul_scalar)(float *dst, const float *src,
+                                          float mul, int len)
+{
+    const VF m = SET1F(mul);
+    int i;
+
+    for (i = 0; i + WF <= len; i += WF)
+        STOREF(dst + i, MULF(LOADF(src + i), m));
+    for (; i < len; i++)
+        dst[i] = src[i] * mul;
+}
+#endif
+
+static TARGET void FN(vector_dmac_scalar)(double *dst, const double *src,
+                                          double mul, int len)
+{
+    const VD m = SET1D(mul);
+    int i;
+
+    for (i = 0; i + 2 * WD <= len; i += 2 * WD) {
+        STORED(dst + i,      MADDD(LOADD(src + i),      m, LOADD(dst + i)));
+        STORED(dst + i + WD, MADDD(LOADD(src + i + WD), m, LOADD(dst + i + WD)));
+    }
+    for (; i < len; i++)
+        dst[i] += src[i] * mul;
+}
+
+#ifndef MADD_ONLY
+static TARGET void FN(vector_dmul_scalar)(double *dst, const double *src,
+                                          double mul, int len)
+{
+    const VD m = SET1D(mul);
+    int i;
+
+    for (i = 0; i + WD <= len; i += WD)
+        STORED(dst + i, MULD(LOADD(src + i), m));
+    for (; i < len; i++)
+        dst[i] = src[i] * mul;
+}
+#endif
+
+static TARGET void FN(vector_fmul_add)(float *dst, const float *src0,
+                                       const float *src1, const float *src2,
+                                       int len)
+{
+    int i;
+
+    for (i = 0; i + WF <= len; i += WF)
+        STOREF(dst + i, MADDF(LOADF(src0 + i), LOADF(src1 + i), LOADF(src2 + i)));
+    for (; i < len; i++)
+        dst[i] = src0[i] * src1[i] + src2[i];
+}
+
+#ifndef MADD_ONLY
+static TARGET void FN(vector_fmul_reverse)(float *dst, const float *src0,
+                                           const float *src1, int len)
+{
+    int i;
+
+    for (i = 0; i + WF <= len; i += WF)
+        STOREF(dst + i, MULF(LOADF(src0 + i), REVF(LOADF(src1 + len - i - WF))));
+    for (; i < len; i++)
+        dst[i] = src0[i] * src1[len - 1 - i];
+}
+
+static TARGET void FN(butterflies_float)(float *av_restrict v1,
+                                         float *av_restrict v2, int len)
+{
+    int i;
+
+    for (i = 0; i + WF <= len; i += WF) {
+        VF a = LOADF(v1 + i);
+        VF b = LOADF(v2 + i);
+        STOREF(v1 + i, ADDF(a, b));
+        STOREF(v2 + i, SUBF(a, b));
+    }
+    for (; i < len; i++) {
+        float t = v1[i] - v2[i];
+        v1[i] += v2[i];
+        v2[i] = t;
+    }
+}
+#endif
@@ -0,0 +1,64 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+#ifndef AVUTIL_X86_INTMATH_H
+#define AVUTIL_X86_INTMATH_H
+
+#include <stdint.h>
+#include "config.h"
+#include "libavutil/attributes.h"
+#if HAVE_FAST_CLZ && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if HAVE_FAST_CLZ
+#if defined(_MSC_VER)
+
+/* GCC and clang get these from the generic __builtin_clz/ctz versions */
+#define ff_log2 ff_log2_x86
+static av_always_inline av_const int ff_log2_x86(unsigned int v)
+{
+    unsigned long n;
+    _BitScanReverse(&n, v | 1);
+    return n;
+}
+#   define ff_log2_16bit av_log2
+
+#define ff_ctz ff_ctz_x86
+static av_always_inline av_const int ff_ctz_x86(int v)
+{
+    unsigned long c;
+    _BitScanForward(&c, v);
+    return c;
+}
+
+#if ARCH_X86_64
+#define ff_ctzll ff_ctzll_x86
+static av_always_inline av_const int ff_ctzll_x86(long long v)
+{
+    unsigned long c;
+    _BitScanForward64(&c, v);
+    return c;
+}
+#endif
+
+#endif /* _MSC_VER */
+#endif /* HAVE_FAST_CLZ */
+
+#endif /* AVUTIL_X86_INTMATH_H */
@@ -0,0 +1,279 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * sample format conversion, SSE2 intrinsics
+ *
+ * swri_audio_convert() only hands multiples of 16 samples per channel to
+ * these, the remainder goes through the C functions. The results are the
+ * same as the C code for float input of magnitude below 65536.
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/samplefmt.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libswresample/swresample_internal.h"
+#include "libswresample/audioconvert.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+
+#define LOAD(p)     _mm_loadu_si128((const __m128i *)(p))
+#define STORE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+
+static av_always_inline __m128 s16_to_flt(__m128i v)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(v, 16)), _mm_set1_ps(1.0f / (1 << 15)));
+}
+
+static av_always_inline __m128i flt_to_s16(__m128 a, __m128 b)
+{
+    const __m128 scale = _mm_set1_ps(1 << 15);
+
+    return _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(a, scale)),
+                           _mm_cvtps_epi32(_mm_mul_ps(b, scale)));
+}
+
+/* cvtps2dq returns 0x80000000 for anything out of range, flip that to
+ * INT32_MAX on the positive side */
+static av_always_inline __m128i flt_to_s32(__m128 a)
+{
+    const __m128 max = _mm_set1_ps(2147483648.0f);
+    __m128 v = _mm_mul_ps(a, max);
+
+    return _mm_xor_si128(_mm_cvtps_epi32(v), _mm_castps_si128(_mm_cmpge_ps(v, max)));
+}
+
+static void conv_s16_to_s32_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int16_t *pi = (const int16_t *)src[0];
+    int32_t *po = (int32_t *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128i v = LOAD(pi + i);
+        STORE(po + i,     _mm_unpacklo_epi16(_mm_setzero_si128(), v));
+        STORE(po + i + 4, _mm_unpackhi_epi16(_mm_setzero_si128(), v));
+    }
+}
+
+static void conv_s32_to_s16_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int32_t *pi = (const int32_t *)src[0];
+    int16_t *po = (int16_t *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 8)
+        STORE(po + i, _mm_packs_epi32(_mm_srai_epi32(LOAD(pi + i),     16),
+                                      _mm_srai_epi32(LOAD(pi + i + 4), 16)));
+}
+
+static void conv_s16_to_flt_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int16_t *pi = (const int16_t *)src[0];
+    float *po = (float *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128i v = LOAD(pi + i);
+        _mm_storeu_ps(po + i,     s16_to_flt(_mm_unpacklo_epi16(v, v)));
+        _mm_storeu_ps(po + i + 4, s16_to_flt(_mm_unpackhi_epi16(v, v)));
+    }
+}
+
+static void conv_s32_to_flt_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int32_t *pi = (const int32_t *)src[0];
+    float *po = (float *)dst[0];
+    const __m128 scale = _mm_set1_ps(1.0f / (1U << 31));
+    int i;
+
+    for (i = 0; i < len; i += 4)
+        _mm_storeu_ps(po + i, _mm_mul_ps(_mm_cvtepi32_ps(LOAD(pi + i)), scale));
+}
+
+static void conv_flt_to_s16_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const float *pi = (const float *)src[0];
+    int16_t *po = (int16_t *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 8)
+        STORE(po + i, flt_to_s16(_mm_loadu_ps(pi + i), _mm_loadu_ps(pi + i + 4)));
+}
+
+static void conv_flt_to_s32_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const float *pi = (const float *)src[0];
+    int32_t *po = (int32_t *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 4)
+        STORE(po + i, flt_to_s32(_mm_loadu_ps(pi + i)));
+}
+
+static void conv_flt_to_dbl_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const float *pi = (const float *)src[0];
+    double *po = (double *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128 v = _mm_loadu_ps(pi + i);
+        _mm_storeu_pd(po + i,     _mm_cvtps_pd(v));
+        _mm_storeu_pd(po + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    }
+}
+
+static void conv_dbl_to_flt_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const double *pi = (const double *)src[0];
+    float *po = (float *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 4)
+        _mm_storeu_ps(po + i, _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(pi + i)),
+                                            _mm_cvtpd_ps(_mm_loadu_pd(pi + i + 2))));
+}
+
+/* planar <-> packed for stereo, len counts samples per channel */
+
+static void conv_s16p_to_s16_2ch_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int16_t *l = (const int16_t *)src[0], *r = (const int16_t *)src[1];
+    int16_t *po = (int16_t *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128i a = LOAD(l + i), b = LOAD(r + i);
+        STORE(po + 2 * i,     _mm_unpacklo_epi16(a, b));
+        STORE(po + 2 * i + 8, _mm_unpackhi_epi16(a, b));
+    }
+}
+
+static void conv_s16_to_s16p_2ch_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int16_t *pi = (const int16_t *)src[0];
+    int16_t *l = (int16_t *)dst[0], *r = (int16_t *)dst[1];
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128i a = LOAD(pi + 2 * i), b = LOAD(pi + 2 * i + 8);
+        STORE(l + i, _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                                     _mm_srai_epi32(_mm_slli_epi32(b, 16), 16)));
+        STORE(r + i, _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16)));
+    }
+}
+
+static void conv_fltp_to_flt_2ch_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const float *l = (const float *)src[0], *r = (const float *)src[1];
+    float *po = (float *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128 a = _mm_loadu_ps(l + i), b = _mm_loadu_ps(r + i);
+        _mm_storeu_ps(po + 2 * i,     _mm_unpacklo_ps(a, b));
+        _mm_storeu_ps(po + 2 * i + 4, _mm_unpackhi_ps(a, b));
+    }
+}
+
+static void conv_flt_to_fltp_2ch_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const float *pi = (const float *)src[0];
+    float *l = (float *)dst[0], *r = (float *)dst[1];
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128 a = _mm_loadu_ps(pi + 2 * i), b = _mm_loadu_ps(pi + 2 * i + 4);
+        _mm_storeu_ps(l + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(r + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+}
+
+static void conv_fltp_to_s16_2ch_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const float *l = (const float *)src[0], *r = (const float *)src[1];
+    int16_t *po = (int16_t *)dst[0];
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128i a = flt_to_s16(_mm_loadu_ps(l + i), _mm_loadu_ps(l + i + 4));
+        __m128i b = flt_to_s16(_mm_loadu_ps(r + i), _mm_loadu_ps(r + i + 4));
+        STORE(po + 2 * i,     _mm_unpacklo_epi16(a, b));
+        STORE(po + 2 * i + 8, _mm_unpackhi_epi16(a, b));
+    }
+}
+
+static void conv_s16_to_fltp_2ch_sse2(uint8_t **dst, const uint8_t **src, int len)
+{
+    const int16_t *pi = (const int16_t *)src[0];
+    float *l = (float *)dst[0], *r = (float *)dst[1];
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        /* each 32-bit lane holds the left sample in the low and the right
+         * sample in the high half */
+        __m128i v = LOAD(pi + 2 * i);
+        _mm_storeu_ps(l + i, s16_to_flt(_mm_slli_epi32(v, 16)));
+        _mm_storeu_ps(r + i, s16_to_flt(v));
+    }
+}
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+#define PAIR(out, in) (out_fmt == AV_SAMPLE_FMT_ ## out && in_fmt == AV_SAMPLE_FMT_ ## in)
+/* same layout on both sides, or mono where everything is planar */
+#define SAME(out, in) (PAIR(out, in) || PAIR(out ## P, in ## P))
+
+av_cold void swri_audio_convert_init_x86(struct AudioConvert *ac,
+                                         enum AVSampleFormat out_fmt,
+                                         enum AVSampleFormat in_fmt,
+                                         int channels)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+
+    if (!INTRINSICS_SSE2(cpu_flags))
+        return;
+
+    if (SAME(S32, S16)) ac->simd_f = conv_s16_to_s32_sse2;
+    if (SAME(S16, S32)) ac->simd_f = conv_s32_to_s16_sse2;
+    if (SAME(FLT, S16)) ac->simd_f = conv_s16_to_flt_sse2;
+    if (SAME(FLT, S32)) ac->simd_f = conv_s32_to_flt_sse2;
+    if (SAME(S16, FLT)) ac->simd_f = conv_flt_to_s16_sse2;
+    if (SAME(S32, FLT)) ac->simd_f = conv_flt_to_s32_sse2;
+    if (SAME(DBL, FLT)) ac->simd_f = conv_flt_to_dbl_sse2;
+    if (SAME(FLT, DBL)) ac->simd_f = conv_dbl_to_flt_sse2;
+
+    if (channels == 2) {
+        if (PAIR(S16,  S16P)) ac->simd_f = conv_s16p_to_s16_2ch_sse2;
+        if (PAIR(S16P, S16 )) ac->simd_f = conv_s16_to_s16p_2ch_sse2;
+        if (PAIR(FLT,  FLTP)) ac->simd_f = conv_fltp_to_flt_2ch_sse2;
+        if (PAIR(FLTP, FLT )) ac->simd_f = conv_flt_to_fltp_2ch_sse2;
+        if (PAIR(S16,  FLTP)) ac->simd_f = conv_fltp_to_s16_2ch_sse2;
+        if (PAIR(FLTP, S16 )) ac->simd_f = conv_s16_to_fltp_2ch_sse2;
+    }
+#endif
+}
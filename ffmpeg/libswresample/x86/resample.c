@@ -0,0 +1,575 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * polyphase resampler, SSE2/SSE4.1/AVX/FMA3/AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libswresample/resample.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_SSE4
+#include <smmintrin.h>
+#endif
+#if HAVE_INTRINSICS_AVX || HAVE_INTRINSICS_FMA3 || HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+static av_always_inline int32_t hsum_epi32(__m128i x)
+{
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0x4e));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, 0xb1));
+    return _mm_cvtsi128_si32(x);
+}
+
+static av_always_inline int64_t hsum_epi64(__m128i x)
+{
+    union { __m128i v; int64_t i[2]; } u;
+
+    u.v = x;
+    return u.i[0] + u.i[1];
+}
+
+static av_always_inline float hsum_ps(__m128 x)
+{
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 0x55));
+    return _mm_cvtss_f32(x);
+}
+
+static av_always_inline double hsum_pd(__m128d x)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(x, _mm_unpackhi_pd(x, x)));
+}
+
+#define LOADU(p) _mm_loadu_si128((const __m128i *)(p))
+
+/* int16: pmaddwd, the sums wrap like the int32 accumulators of the C code */
+
+static av_always_inline int32_t dot_int16_sse2(const int16_t *src, const int16_t *filter, int len)
+{
+    __m128i acc = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < len; i += 8)
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(LOADU(src + i), LOADU(filter + i)));
+    return hsum_epi32(acc);
+}
+
+static av_always_inline void dot2_int16_sse2(const int16_t *src, const int16_t *f0,
+                                             const int16_t *f1, int len,
+                                             int32_t *v0, int32_t *v1)
+{
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m128i s = LOADU(src + i);
+        acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(s, LOADU(f0 + i)));
+        acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(s, LOADU(f1 + i)));
+    }
+    *v0 = hsum_epi32(acc0);
+    *v1 = hsum_epi32(acc1);
+}
+
+/* float, two accumulators of 4 */
+
+static av_always_inline float dot_float_sse2(const float *src, const float *filter, int len)
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(src + i),     _mm_loadu_ps(filter + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(src + i + 4), _mm_loadu_ps(filter + i + 4)));
+    }
+    return hsum_ps(_mm_add_ps(acc0, acc1));
+}
+
+static av_always_inline void dot2_float_sse2(const float *src, const float *f0,
+                                             const float *f1, int len,
+                                             float *v0, float *v1)
+{
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128 s = _mm_loadu_ps(src + i);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(s, _mm_loadu_ps(f0 + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(s, _mm_loadu_ps(f1 + i)));
+    }
+    *v0 = hsum_ps(acc0);
+    *v1 = hsum_ps(acc1);
+}
+
+/* double, two accumulators of 2 */
+
+static av_always_inline double dot_double_sse2(const double *src, const double *filter, int len)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(src + i),     _mm_loadu_pd(filter + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(src + i + 2), _mm_loadu_pd(filter + i + 2)));
+    }
+    return hsum_pd(_mm_add_pd(acc0, acc1));
+}
+
+static av_always_inline void dot2_double_sse2(const double *src, const double *f0,
+                                              const double *f1, int len,
+                                              double *v0, double *v1)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    int i;
+
+    for (i = 0; i < len; i += 2) {
+        __m128d s = _mm_loadu_pd(src + i);
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(s, _mm_loadu_pd(f0 + i)));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(s, _mm_loadu_pd(f1 + i)));
+    }
+    *v0 = hsum_pd(acc0);
+    *v1 = hsum_pd(acc1);
+}
+
+#define TARGET
+#define FN(name) name ## _int16_sse2
+#define FILTER_SHIFT 15
+#define DELEM  int16_t
+#define FELEM  int16_t
+#define FELEM2 int32_t
+#define FELEML int64_t
+#define FOFFSET (1 << (FILTER_SHIFT - 1))
+#define OUT(d, v) (d) = av_clip_int16((v) >> FILTER_SHIFT)
+#include "resample_template.c"
+#undef FN
+#undef FILTER_SHIFT
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+#undef FELEML
+#undef FOFFSET
+#undef OUT
+
+#define FILTER_SHIFT 0
+#define FOFFSET 0
+#define OUT(d, v) (d) = (v)
+
+#define FN(name) name ## _float_sse2
+#define DELEM  float
+#define FELEM  float
+#define FELEM2 float
+#include "resample_template.c"
+#undef FN
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+
+#define FN(name) name ## _double_sse2
+#define DELEM  double
+#define FELEM  double
+#define FELEM2 double
+#include "resample_template.c"
+#undef FN
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+
+#undef FILTER_SHIFT
+#undef FOFFSET
+#undef OUT
+#undef TARGET
+
+#if HAVE_INTRINSICS_SSE4
+/* int32: pmuldq on the even lanes, exact 64-bit sums */
+
+static av_always_inline av_target_sse4 __m128i madd_epi32_sse4(__m128i acc, __m128i a, __m128i b)
+{
+    acc = _mm_add_epi64(acc, _mm_mul_epi32(a, b));
+    return _mm_add_epi64(acc, _mm_mul_epi32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32)));
+}
+
+static av_always_inline av_target_sse4 int64_t dot_int32_sse4(const int32_t *src, const int32_t *filter, int len)
+{
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        acc0 = madd_epi32_sse4(acc0, LOADU(src + i),     LOADU(filter + i));
+        acc1 = madd_epi32_sse4(acc1, LOADU(src + i + 4), LOADU(filter + i + 4));
+    }
+    return hsum_epi64(_mm_add_epi64(acc0, acc1));
+}
+
+static av_always_inline av_target_sse4 void dot2_int32_sse4(const int32_t *src, const int32_t *f0,
+                                                            const int32_t *f1, int len,
+                                                            int64_t *v0, int64_t *v1)
+{
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    int i;
+
+    for (i = 0; i < len; i += 4) {
+        __m128i s = LOADU(src + i);
+        acc0 = madd_epi32_sse4(acc0, s, LOADU(f0 + i));
+        acc1 = madd_epi32_sse4(acc1, s, LOADU(f1 + i));
+    }
+    *v0 = hsum_epi64(acc0);
+    *v1 = hsum_epi64(acc1);
+}
+
+#define TARGET av_target_sse4
+#define FN(name) name ## _int32_sse4
+#define FILTER_SHIFT 30
+#define DELEM  int32_t
+#define FELEM  int32_t
+#define FELEM2 int64_t
+#define FOFFSET (1 << (FILTER_SHIFT - 1))
+#define OUT(d, v) (d) = av_clipl_int32((v) >> FILTER_SHIFT)
+#include "resample_template.c"
+#undef TARGET
+#undef FN
+#undef FILTER_SHIFT
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+#undef FOFFSET
+#undef OUT
+#endif /* HAVE_INTRINSICS_SSE4 */
+
+/* float and double with 256-bit vectors, once with separate multiplies and
+ * adds and once with fused multiply-adds */
+#define DOT_FLOAT_256(opt, target, MADD_PS, MADD_PD)                                       \
+static av_always_inline target float dot_float_ ## opt(const float *src,                   \
+                                                       const float *filter, int len)       \
+{                                                                                           \
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();                          \
+    int i;                                                                                  \
+                                                                                            \
+    for (i = 0; i + 16 <= len; i += 16) {                                                   \
+        acc0 = MADD_PS(_mm256_loadu_ps(src + i),     _mm256_loadu_ps(filter + i),     acc0); \
+        acc1 = MADD_PS(_mm256_loadu_ps(src + i + 8), _mm256_loadu_ps(filter + i + 8), acc1); \
+    }                                                                                       \
+    if (i < len)                                                                            \
+        acc0 = MADD_PS(_mm256_loadu_ps(src + i), _mm256_loadu_ps(filter + i), acc0);        \
+    acc0 = _mm256_add_ps(acc0, acc1);                                                       \
+    return hsum_ps(_mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1))); \
+}                                                                                           \
+                                                                                            \
+static av_always_inline target void dot2_float_ ## opt(const float *src, const float *f0,  \
+                                                       const float *f1, int len,            \
+                                                       float *v0, float *v1)                \
+{                                                                                           \
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();                          \
+    int i;                                                                                  \
+                                                                                            \
+    for (i = 0; i < len; i += 8) {                                                          \
+        __m256 s = _mm256_loadu_ps(src + i);                                                \
+        acc0 = MADD_PS(s, _mm256_loadu_ps(f0 + i), acc0);                                   \
+        acc1 = MADD_PS(s, _mm256_loadu_ps(f1 + i), acc1);                                   \
+    }                                                                                       \
+    *v0 = hsum_ps(_mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1))); \
+    *v1 = hsum_ps(_mm_add_ps(_mm256_castps256_ps128(acc1), _mm256_extractf128_ps(acc1, 1))); \
+}                                                                                           \
+                                                                                            \
+static av_always_inline target double dot_double_ ## opt(const double *src,                \
+                                                         const double *filter, int len)     \
+{                                                                                           \
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();                         \
+    int i;                                                                                  \
+                                                                                            \
+    for (i = 0; i < len; i += 8) {                                                          \
+        acc0 = MADD_PD(_mm256_loadu_pd(src + i),     _mm256_loadu_pd(filter + i),     acc0); \
+        acc1 = MADD_PD(_mm256_loadu_pd(src + i + 4), _mm256_loadu_pd(filter + i + 4), acc1); \
+    }                                                                                       \
+    acc0 = _mm256_add_pd(acc0, acc1);                                                       \
+    return hsum_pd(_mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1))); \
+}                                                                                           \
+                                                                                            \
+static av_always_inline target void dot2_double_ ## opt(const double *src, const double *f0, \
+                                                        const double *f1, int len,          \
+                                                        double *v0, double *v1)             \
+{                                                                                           \
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();                         \
+    int i;                                                                                  \
+                                                                                            \
+    for (i = 0; i < len; i += 4) {                                                          \
+        __m256d s = _mm256_loadu_pd(src + i);                                               \
+        acc0 = MADD_PD(s, _mm256_loadu_pd(f0 + i), acc0);                                   \
+        acc1 = MADD_PD(s, _mm256_loadu_pd(f1 + i), acc1);                                   \
+    }                                                                                       \
+    *v0 = hsum_pd(_mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1))); \
+    *v1 = hsum_pd(_mm_add_pd(_mm256_castpd256_pd128(acc1), _mm256_extractf128_pd(acc1, 1))); \
+}
+
+#if HAVE_INTRINSICS_AVX
+#define MADD_PS(a, b, acc) _mm256_add_ps(acc, _mm256_mul_ps(a, b))
+#define MADD_PD(a, b, acc) _mm256_add_pd(acc, _mm256_mul_pd(a, b))
+DOT_FLOAT_256(avx, av_target_avx, MADD_PS, MADD_PD)
+#undef MADD_PS
+#undef MADD_PD
+#endif
+
+#if HAVE_INTRINSICS_FMA3
+DOT_FLOAT_256(fma3, av_target_fma3, _mm256_fmadd_ps, _mm256_fmadd_pd)
+#endif
+
+#define FILTER_SHIFT 0
+#define FOFFSET 0
+#define OUT(d, v) (d) = (v)
+
+#if HAVE_INTRINSICS_AVX
+#define TARGET av_target_avx
+#define FN(name) name ## _float_avx
+#define DELEM  float
+#define FELEM  float
+#define FELEM2 float
+#include "resample_template.c"
+#undef FN
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+
+#define FN(name) name ## _double_avx
+#define DELEM  double
+#define FELEM  double
+#define FELEM2 double
+#include "resample_template.c"
+#undef FN
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+#undef TARGET
+#endif /* HAVE_INTRINSICS_AVX */
+
+#if HAVE_INTRINSICS_FMA3
+#define TARGET av_target_fma3
+#define FN(name) name ## _float_fma3
+#define DELEM  float
+#define FELEM  float
+#define FELEM2 float
+#include "resample_template.c"
+#undef FN
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+
+#define FN(name) name ## _double_fma3
+#define DELEM  double
+#define FELEM  double
+#define FELEM2 double
+#include "resample_template.c"
+#undef FN
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+#undef TARGET
+#endif /* HAVE_INTRINSICS_FMA3 */
+
+#undef FILTER_SHIFT
+#undef FOFFSET
+#undef OUT
+
+#if HAVE_INTRINSICS_AVX2
+#define LOADU256(p) _mm256_loadu_si256((const __m256i *)(p))
+
+static av_always_inline av_target_avx2 int32_t hsum256_epi32(__m256i x)
+{
+    return hsum_epi32(_mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+}
+
+static av_always_inline av_target_avx2 int64_t hsum256_epi64(__m256i x)
+{
+    return hsum_epi64(_mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+}
+
+/* 16 taps per step, the length is only a multiple of 8 */
+static av_always_inline av_target_avx2 int32_t dot_int16_avx2(const int16_t *src, const int16_t *filter, int len)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int32_t tail = 0;
+    int i;
+
+    for (i = 0; i + 16 <= len; i += 16)
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(LOADU256(src + i), LOADU256(filter + i)));
+    if (i < len)
+        tail = hsum_epi32(_mm_madd_epi16(LOADU(src + i), LOADU(filter + i)));
+    return hsum256_epi32(acc) + tail;
+}
+
+static av_always_inline av_target_avx2 void dot2_int16_avx2(const int16_t *src, const int16_t *f0,
+                                                            const int16_t *f1, int len,
+                                                            int32_t *v0, int32_t *v1)
+{
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    int32_t tail0 = 0, tail1 = 0;
+    int i;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        __m256i s = LOADU256(src + i);
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(s, LOADU256(f0 + i)));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(s, LOADU256(f1 + i)));
+    }
+    if (i < len) {
+        __m128i s = LOADU(src + i);
+        tail0 = hsum_epi32(_mm_madd_epi16(s, LOADU(f0 + i)));
+        tail1 = hsum_epi32(_mm_madd_epi16(s, LOADU(f1 + i)));
+    }
+    *v0 = hsum256_epi32(acc0) + tail0;
+    *v1 = hsum256_epi32(acc1) + tail1;
+}
+
+static av_always_inline av_target_avx2 __m256i madd_epi32_avx2(__m256i acc, __m256i a, __m256i b)
+{
+    acc = _mm256_add_epi64(acc, _mm256_mul_epi32(a, b));
+    return _mm256_add_epi64(acc, _mm256_mul_epi32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32)));
+}
+
+static av_always_inline av_target_avx2 int64_t dot_int32_avx2(const int32_t *src, const int32_t *filter, int len)
+{
+    __m256i acc = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i < len; i += 8)
+        acc = madd_epi32_avx2(acc, LOADU256(src + i), LOADU256(filter + i));
+    return hsum256_epi64(acc);
+}
+
+static av_always_inline av_target_avx2 void dot2_int32_avx2(const int32_t *src, const int32_t *f0,
+                                                            const int32_t *f1, int len,
+                                                            int64_t *v0, int64_t *v1)
+{
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    int i;
+
+    for (i = 0; i < len; i += 8) {
+        __m256i s = LOADU256(src + i);
+        acc0 = madd_epi32_avx2(acc0, s, LOADU256(f0 + i));
+        acc1 = madd_epi32_avx2(acc1, s, LOADU256(f1 + i));
+    }
+    *v0 = hsum256_epi64(acc0);
+    *v1 = hsum256_epi64(acc1);
+}
+
+#define TARGET av_target_avx2
+#define FN(name) name ## _int16_avx2
+#define FILTER_SHIFT 15
+#define DELEM  int16_t
+#define FELEM  int16_t
+#define FELEM2 int32_t
+#define FELEML int64_t
+#define FOFFSET (1 << (FILTER_SHIFT - 1))
+#define OUT(d, v) (d) = av_clip_int16((v) >> FILTER_SHIFT)
+#include "resample_template.c"
+#undef FN
+#undef FILTER_SHIFT
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+#undef FELEML
+#undef FOFFSET
+#undef OUT
+
+#define FN(name) name ## _int32_avx2
+#define FILTER_SHIFT 30
+#define DELEM  int32_t
+#define FELEM  int32_t
+#define FELEM2 int64_t
+#define FOFFSET (1 << (FILTER_SHIFT - 1))
+#define OUT(d, v) (d) = av_clipl_int32((v) >> FILTER_SHIFT)
+#include "resample_template.c"
+#undef TARGET
+#undef FN
+#undef FILTER_SHIFT
+#undef DELEM
+#undef FELEM
+#undef FELEM2
+#undef FOFFSET
+#undef OUT
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+#define SET_FUNCS(type, opt)                                                \
+    do {                                                                    \
+        c->dsp.resample_common = resample_common_ ## type ## _ ## opt;      \
+        c->dsp.resample_linear = resample_linear_ ## type ## _ ## opt;      \
+    } while (0)
+
+/* resample_one() is a plain gather and stays in C. */
+av_cold void swri_resample_dsp_x86_init(ResampleContext *c)
+{
+#if HAVE_INTRINSICS_SSE2
+    int av_unused cpu_flags = av_get_cpu_flags();
+
+    switch (c->format) {
+    case AV_SAMPLE_FMT_S16P:
+        if (INTRINSICS_SSE2(cpu_flags))
+            SET_FUNCS(int16, sse2);
+#if HAVE_INTRINSICS_AVX2
+        if (INTRINSICS_AVX2(cpu_flags))
+            SET_FUNCS(int16, avx2);
+#endif
+        break;
+    case AV_SAMPLE_FMT_S32P:
+#if HAVE_INTRINSICS_SSE4
+        if (INTRINSICS_SSE4(cpu_flags))
+            SET_FUNCS(int32, sse4);
+#endif
+#if HAVE_INTRINSICS_AVX2
+        if (INTRINSICS_AVX2(cpu_flags))
+            SET_FUNCS(int32, avx2);
+#endif
+        break;
+    case AV_SAMPLE_FMT_FLTP:
+        if (INTRINSICS_SSE2(cpu_flags))
+            SET_FUNCS(float, sse2);
+#if HAVE_INTRINSICS_AVX
+        if (INTRINSICS_AVX(cpu_flags))
+            SET_FUNCS(float, avx);
+#endif
+#if HAVE_INTRINSICS_FMA3
+        if (INTRINSICS_FMA3(cpu_flags) && INTRINSICS_AVX(cpu_flags))
+            SET_FUNCS(float, fma3);
+#endif
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        if (INTRINSICS_SSE2(cpu_flags))
+            SET_FUNCS(double, sse2);
+#if HAVE_INTRINSICS_AVX
+        if (INTRINSICS_AVX(cpu_flags))
+            SET_FUNCS(double, avx);
+#endif
+#if HAVE_INTRINSICS_FMA3
+        if (INTRINSICS_FMA3(cpu_flags) && INTRINSICS_AVX(cpu_flags))
+            SET_FUNCS(double, fma3);
+#endif
+        break;
+    }
+#endif
+}
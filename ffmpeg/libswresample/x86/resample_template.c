@@ -0,0 +1,133 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The phase stepping is the same as in libswresample/resample_template.c,
+ * only the filter loop is replaced by FN(dot)() and FN(dot2)(). These run
+ * over the filter length rounded up to 8 taps, the filter bank is zero
+ * padded to that size and resample() leaves 7 samples of input headroom
+ * on x86.
+ *
+ * The includer defines TARGET, FN(), FILTER_SHIFT, DELEM, FELEM, FELEM2,
+ * FOFFSET, OUT() and, for int16, FELEML.
+ */
+
+static TARGET int FN(resample_common)(ResampleContext *c,
+                                      void *dest, const void *source,
+                                      int n, int update_ctx)
+{
+    DELEM *dst = dest;
+    const DELEM *src = source;
+    int len = FFALIGN(c->filter_length, 8);
+    int dst_index;
+    int index = c->index;
+    int frac  = c->frac;
+    int sample_index = 0;
+
+    while (index >= c->phase_count) {
+        sample_index++;
+        index -= c->phase_count;
+    }
+
+    for (dst_index = 0; dst_index < n; dst_index++) {
+        const FELEM *filter = ((FELEM *) c->filter_bank) + c->filter_alloc * index;
+        FELEM2 val = FN(dot)(src + sample_index, filter, len);
+
+#ifdef FELEML
+        OUT(dst[dst_index], FOFFSET + (FELEML)val);
+#else
+        OUT(dst[dst_index], FOFFSET + val);
+#endif
+
+        frac  += c->dst_incr_mod;
+        index += c->dst_incr_div;
+        if (frac >= c->src_incr) {
+            frac -= c->src_incr;
+            index++;
+        }
+
+        while (index >= c->phase_count) {
+            sample_index++;
+            index -= c->phase_count;
+        }
+    }
+
+    if (update_ctx) {
+        c->frac  = frac;
+        c->index = index;
+    }
+
+    return sample_index;
+}
+
+static TARGET int FN(resample_linear)(ResampleContext *c,
+                                      void *dest, const void *source,
+                                      int n, int update_ctx)
+{
+    DELEM *dst = dest;
+    const DELEM *src = source;
+    int len = FFALIGN(c->filter_length, 8);
+    int dst_index;
+    int index = c->index;
+    int frac  = c->frac;
+    int sample_index = 0;
+#if FILTER_SHIFT == 0
+    double inv_src_incr = 1.0 / c->src_incr;
+#endif
+
+    while (index >= c->phase_count) {
+        sample_index++;
+        index -= c->phase_count;
+    }
+
+    for (dst_index = 0; dst_index < n; dst_index++) {
+        const FELEM *filter = ((FELEM *) c->filter_bank) + c->filter_alloc * index;
+        FELEM2 val, v2;
+
+        FN(dot2)(src + sample_index, filter, filter + c->filter_alloc, len, &val, &v2);
+        val += FOFFSET;
+        v2  += FOFFSET;
+#ifdef FELEML
+        val += (v2 - val) * (FELEML) frac / c->src_incr;
+#elif FILTER_SHIFT == 0
+        val += (v2 - val) * inv_src_incr * frac;
+#else
+        val += (v2 - val) / c->src_incr * frac;
+#endif
+        OUT(dst[dst_index], val);
+
+        frac  += c->dst_incr_mod;
+        index += c->dst_incr_div;
+        if (frac >= c->src_incr) {
+            frac -= c->src_incr;
+            index++;
+        }
+
+        while (index >= c->phase_count) {
+            sample_index++;
+            index -= c->phase_count;
+        }
+    }
+
+    if (update_ctx) {
+        c->frac  = frac;
+        c->index = index;
+    }
+
+    return sample_index;
+}
@@ -228,14 +228,21 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+/**
+ * Scale the lines of a source slice. With dstSliceH != 0, only the
+ * destination lines dstSliceY to dstSliceY + dstSliceH - 1 are output, which
+ * requires the complete source picture.
+ */
+static int swscale_lines(SwsContext *c, const uint8_t *src[],
+                         int srcStride[], int srcSliceY,
+                         int srcSliceH, uint8_t *dst[], int dstStride[],
+                         int dstSliceY, int dstSliceH)
 {
     /* load a few things into local vars to make the code more readable?
      * and faster */
     const int dstW                   = c->dstW;
     const int dstH                   = c->dstH;
+    const int dstEnd                 = dstSliceH ? dstSliceY + dstSliceH : dstH;
 
     const enum AVPixelFormat dstFormat = c->dstFormat;
     const int flags                  = c->flags;
@@ -337,7 +344,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -369,7 +376,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -531,6 +538,66 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return swscale_lines(c, src, srcStride, srcSliceY, srcSliceH,
+                         dst, dstStride, 0, 0);
+}
+
+typedef struct ScaleThreadArg {
+    const uint8_t **src;
+    int *srcStride;
+    uint8_t **dst;
+    int *dstStride;
+} ScaleThreadArg;
+
+static void scale_band(SwsContext *c, void *arg, int jobnr, int nb_jobs)
+{
+    const ScaleThreadArg *a = arg;
+    SwsContext *slice = c->slice_ctx[jobnr];
+    /* keep the bands aligned to the destination chroma lines */
+    const int sub     = c->chrDstVSubSample;
+    const int lines   = AV_CEIL_RSHIFT(c->dstH, sub);
+    const int start   = (lines *  jobnr      / nb_jobs) << sub;
+    const int end     = jobnr == nb_jobs - 1 ? c->dstH :
+                        (lines * (jobnr + 1) / nb_jobs) << sub;
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    if (start >= end)
+        return;
+
+    /* swscale_lines() modifies these */
+    memcpy(src,       a->src,       sizeof(src));
+    memcpy(dst,       a->dst,       sizeof(dst));
+    memcpy(srcStride, a->srcStride, sizeof(srcStride));
+    memcpy(dstStride, a->dstStride, sizeof(dstStride));
+
+    if (usePal(c->srcFormat)) {
+        memcpy(slice->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+        memcpy(slice->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+    }
+
+    swscale_lines(slice, src, srcStride, 0, c->srcH, dst, dstStride,
+                  start, end - start);
+}
+
+/* Scale a complete picture with the slice contexts of c. */
+static int scale_threaded(SwsContext *c, const uint8_t *src[], int srcStride[],
+                          uint8_t *dst[], int dstStride[])
+{
+    ScaleThreadArg arg = { src, srcStride, dst, dstStride };
+    int nb_jobs = FFMIN(c->nb_slice_ctx, AV_CEIL_RSHIFT(c->dstH, c->chrDstVSubSample));
+
+    ff_sws_thread_execute(c, scale_band, &arg, nb_jobs);
+
+    c->dstY = c->dstH;
+    return c->dstH;
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -977,7 +1044,10 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+    if (HAVE_THREADS && c->nb_slice_ctx && !srcSliceY_internal && srcSliceH == c->srcH)
+        ret = scale_threaded(c, src2, srcStride2, dst2, dstStride2);
+    else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
@@ -321,6 +321,15 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_* fields allow splitting the generic scaler over several
+     * threads, each slice context scales a band of destination lines from
+     * the complete source picture.
+     */
+    int nb_threads;               ///< Number of threads, 0 for one per CPU.
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    struct SwsThreadContext *thread;
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -823,6 +832,7 @@ void ff_get_unscaled_swscale(SwsContext *c);
 void ff_get_unscaled_swscale_ppc(SwsContext *c);
 void ff_get_unscaled_swscale_arm(SwsContext *c);
 void ff_get_unscaled_swscale_aarch64(SwsContext *c);
+void ff_get_unscaled_swscale_x86(SwsContext *c);
 
 /**
  * Return function pointer to fastest main scaler path function depending
@@ -948,6 +958,23 @@ int ff_init_filters(SwsContext *c);
 // Free all filter data
 int ff_free_filters(SwsContext *c);
 
+typedef void (sws_thread_func)(SwsContext *c, void *arg, int jobnr, int nb_jobs);
+
+/**
+ * Start nb_threads worker threads for c.
+ * @return the number of threads started, 0 if nb_threads <= 1, or a
+ *         negative error code
+ */
+int ff_sws_thread_init(SwsContext *c, int nb_threads);
+void ff_sws_thread_free(SwsContext *c);
+
+/**
+ * Run func for the jobs 0..nb_jobs-1 on the worker threads of c and wait
+ * for all of them to finish.
+ */
+void ff_sws_thread_execute(SwsContext *c, sws_thread_func *func,
+                           void *arg, int nb_jobs);
+
 /*
  function for applying ring buffer logic into slice s
  It checks if the slice can hold more @lum lines, if yes
@@ -1895,6 +1895,8 @@ void ff_get_unscaled_swscale(SwsContext *c)
          ff_get_unscaled_swscale_arm(c);
     if (ARCH_AARCH64)
         ff_get_unscaled_swscale_aarch64(c);
+    if (ARCH_X86)
+        ff_get_unscaled_swscale_x86(c);
 }
 
 /* Convert the palette to the same packed 32-bit format as the palette */
@@ -0,0 +1,152 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/* Check that scaling with slice threads gives the same output as without. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/swscale.h"
+
+static const enum AVPixelFormat formats[] = {
+    AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P,
+    AV_PIX_FMT_YUV410P, AV_PIX_FMT_YUVA420P, AV_PIX_FMT_YUV420P10LE,
+    AV_PIX_FMT_NV12,    AV_PIX_FMT_GRAY8,   AV_PIX_FMT_BGRA,
+    AV_PIX_FMT_RGB24,   AV_PIX_FMT_RGB565,  AV_PIX_FMT_GBRP,
+};
+
+static const int flags[] = {
+    SWS_BICUBIC, SWS_BILINEAR, SWS_LANCZOS, SWS_POINT, SWS_AREA,
+    SWS_BICUBIC | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT,
+};
+
+static const int sizes[][4] = {
+    { 352, 288, 176, 144 },
+    { 176, 144, 352, 288 },
+    {  97,  61,  53,  37 },
+    {  64,  64,  64,  33 },
+    {  33,  17, 100,  99 },
+};
+
+static struct SwsContext *alloc_context(const int *size, enum AVPixelFormat src_fmt,
+                                        enum AVPixelFormat dst_fmt, int flags,
+                                        int threads)
+{
+    struct SwsContext *sws = sws_alloc_context();
+
+    if (!sws)
+        return NULL;
+
+    av_opt_set_int(sws, "srcw",       size[0], 0);
+    av_opt_set_int(sws, "srch",       size[1], 0);
+    av_opt_set_int(sws, "src_format", src_fmt, 0);
+    av_opt_set_int(sws, "dstw",       size[2], 0);
+    av_opt_set_int(sws, "dsth",       size[3], 0);
+    av_opt_set_int(sws, "dst_format", dst_fmt, 0);
+    av_opt_set_int(sws, "sws_flags",  flags,   0);
+    av_opt_set_int(sws, "threads",    threads, 0);
+
+    if (sws_init_context(sws, NULL, NULL) < 0) {
+        sws_freeContext(sws);
+        return NULL;
+    }
+    return sws;
+}
+
+static int run_test(AVLFG *lfg, const int *size, enum AVPixelFormat src_fmt,
+                    enum AVPixelFormat dst_fmt, int flags, int threads)
+{
+    struct SwsContext *ref = alloc_context(size, src_fmt, dst_fmt, flags, 1);
+    struct SwsContext *thr = alloc_context(size, src_fmt, dst_fmt, flags, threads);
+    uint8_t *src[4] = { NULL }, *dst_ref[4] = { NULL }, *dst_thr[4] = { NULL };
+    int src_linesize[4], ref_linesize[4], thr_linesize[4];
+    int i, src_size, dst_size, ret = 0;
+
+    /* unsupported conversions fail in both cases */
+    if (!ref || !thr) {
+        ret = !ref == !thr ? 0 : -1;
+        goto end;
+    }
+
+    src_size = av_image_alloc(src, src_linesize, size[0], size[1], src_fmt, 32);
+    dst_size = av_image_alloc(dst_ref, ref_linesize, size[2], size[3], dst_fmt, 32);
+    if (src_size < 0 || dst_size < 0 ||
+        av_image_alloc(dst_thr, thr_linesize, size[2], size[3], dst_fmt, 32) < 0) {
+        ret = -1;
+        goto end;
+    }
+
+    for (i = 0; i < src_size; i++)
+        src[0][i] = av_lfg_get(lfg);
+    memset(dst_ref[0], 0, dst_size);
+    memset(dst_thr[0], 0, dst_size);
+
+    /* twice, to make sure no state is carried over from the first picture */
+    for (i = 0; i < 2; i++) {
+        int h_ref = sws_scale(ref, (const uint8_t * const *)src, src_linesize,
+                              0, size[1], dst_ref, ref_linesize);
+        int h_thr = sws_scale(thr, (const uint8_t * const *)src, src_linesize,
+                              0, size[1], dst_thr, thr_linesize);
+
+        if (h_ref != h_thr || memcmp(dst_ref[0], dst_thr[0], dst_size)) {
+            fprintf(stderr, "%s %dx%d -> %s %dx%d, flags 0x%x, %d threads: mismatch\n",
+                    av_get_pix_fmt_name(src_fmt), size[0], size[1],
+                    av_get_pix_fmt_name(dst_fmt), size[2], size[3],
+                    flags, threads);
+            ret = -1;
+            break;
+        }
+    }
+
+end:
+    av_freep(&src[0]);
+    av_freep(&dst_ref[0]);
+    av_freep(&dst_thr[0]);
+    sws_freeContext(ref);
+    sws_freeContext(thr);
+    return ret;
+}
+
+int main(void)
+{
+    AVLFG lfg;
+    int i, j, k, ret = 0;
+
+    av_log_set_level(AV_LOG_ERROR);
+    av_lfg_init(&lfg, 1);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++)
+        for (j = 0; j < FF_ARRAY_ELEMS(formats); j++)
+            for (k = 0; k < FF_ARRAY_ELEMS(flags); k++) {
+                const int *size = sizes[(i + j + k) % FF_ARRAY_ELEMS(sizes)];
+
+                if (run_test(&lfg, size, formats[i], formats[j], flags[k],
+                             2 + (i + k) % 4) < 0)
+                    ret = 1;
+            }
+
+    return ret;
+}
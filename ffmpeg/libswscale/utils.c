@@ -850,6 +850,7 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
 
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -892,6 +893,14 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     if (c->cascaded_context[c->cascaded_mainindex])
         return sws_setColorspaceDetails(c->cascaded_context[c->cascaded_mainindex],inv_table, srcRange,table, dstRange, brightness,  contrast, saturation);
 
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        int ret = sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                           table, dstRange, brightness,
+                                           contrast, saturation);
+        if (ret < 0)
+            return ret;
+    }
+
     if (!need_reinit)
         return 0;
 
@@ -1146,6 +1155,73 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
+static void free_slice_threads(SwsContext *c)
+{
+    int i;
+
+    if (HAVE_THREADS)
+        ff_sws_thread_free(c);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    c->nb_slice_ctx = 0;
+}
+
+/* Set up the contexts and threads for scaling complete pictures in bands.
+ * Only the generic scaler is threaded, and not with error diffusion, which
+ * carries state from one line to the next. */
+static av_cold int init_slice_threads(SwsContext *c, SwsFilter *srcFilter,
+                                      SwsFilter *dstFilter)
+{
+    int i, ret, nb_threads = c->nb_threads;
+
+    if (!HAVE_THREADS || c->dither == SWS_DITHER_ED)
+        return 0;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+    nb_threads = FFMIN(nb_threads, AV_CEIL_RSHIFT(c->dstH, c->chrDstVSubSample));
+    if (nb_threads <= 1)
+        return 0;
+
+    c->slice_ctx = av_mallocz_array(nb_threads, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_threads; i++) {
+        SwsContext *slice = sws_alloc_context();
+        if (!slice)
+            return AVERROR(ENOMEM);
+        c->slice_ctx[c->nb_slice_ctx++] = slice;
+
+        if ((ret = av_opt_copy(slice, c)) < 0)
+            return ret;
+        slice->nb_threads = 1;
+
+        if ((ret = sws_init_context(slice, srcFilter, dstFilter)) < 0)
+            return ret;
+        if ((ret = sws_setColorspaceDetails(slice, c->srcColorspaceTable, c->srcRange,
+                                            c->dstColorspaceTable, c->dstRange,
+                                            c->brightness, c->contrast,
+                                            c->saturation)) < 0)
+            return ret;
+
+        /* all contexts must use the generic scaler with the same setup */
+        if (slice->swscale != c->swscale || slice->cascaded_context[0]) {
+            free_slice_threads(c);
+            return 0;
+        }
+    }
+
+    ret = ff_sws_thread_init(c, nb_threads);
+    if (ret <= 1) {
+        free_slice_threads(c);
+        return FFMIN(ret, 0);
+    }
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -1794,7 +1870,9 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     c->swscale = ff_getSwsFunc(c);
-    return ff_init_filters(c);
+    if ((ret = ff_init_filters(c)) < 0)
+        return ret;
+    return init_slice_threads(c, srcFilter, dstFilter);
 fail: // FIXME replace things by appropriate error codes
     if (ret == RETCODE_USE_CASCADE)  {
         int tmpW = sqrt(srcW * (int64_t)dstW);
@@ -2279,6 +2357,8 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    free_slice_threads(c);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
@@ -0,0 +1,472 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Unscaled conversions to NV12/NV21, SSE2 and AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixfmt.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+/* The 10 to 8 bit rows of the ordered dither used by planarCopyWrapper().
+ * (x + d) * 511 >> 11 is computed as pmulhuw with 511 << 5. */
+DECLARE_ALIGNED(8, static const uint8_t, dither_10to8)[2][8] = {
+    { 1, 2, 1, 2, 1, 2, 1, 2 },
+    { 3, 0, 3, 0, 3, 0, 3, 0 },
+};
+
+/****************************************************************************
+ * Row kernels. The vector loops are completed by the C loops below, w is
+ * the number of output chroma pairs or, for P010, of 16-bit samples.
+ ****************************************************************************/
+
+static av_always_inline void interleave_c(uint8_t *dst, const uint8_t *u,
+                                          const uint8_t *v, int x, int w)
+{
+    for (; x < w; x++) {
+        dst[2 * x]     = u[x];
+        dst[2 * x + 1] = v[x];
+    }
+}
+
+static av_always_inline void interleave_avg_c(uint8_t *dst,
+                                              const uint8_t *u0, const uint8_t *u1,
+                                              const uint8_t *v0, const uint8_t *v1,
+                                              int x, int w)
+{
+    for (; x < w; x++) {
+        dst[2 * x]     = (u0[x] + u1[x] + 1) >> 1;
+        dst[2 * x + 1] = (v0[x] + v1[x] + 1) >> 1;
+    }
+}
+
+/* src_w is the width of the full resolution chroma planes, an odd last
+ * column is averaged vertically only */
+static av_always_inline void interleave_box_c(uint8_t *dst,
+                                              const uint8_t *u0, const uint8_t *u1,
+                                              const uint8_t *v0, const uint8_t *v1,
+                                              int x, int w, int src_w)
+{
+    for (; x < w; x++) {
+        int i = 2 * x, j = FFMIN(2 * x + 1, src_w - 1);
+
+        dst[2 * x]     = (u0[i] + u0[j] + u1[i] + u1[j] + 2) >> 2;
+        dst[2 * x + 1] = (v0[i] + v0[j] + v1[i] + v1[j] + 2) >> 2;
+    }
+}
+
+static av_always_inline void p010_c(uint8_t *dst, const uint16_t *src,
+                                    const uint8_t *dither, int x, int w, int be)
+{
+    for (; x < w; x++) {
+        int v = (be ? AV_RB16(src + x) : AV_RL16(src + x)) >> 6;
+
+        dst[x] = (v + dither[x & 7]) * 511 >> 11;
+    }
+}
+
+static void interleave_sse2(uint8_t *dst, const uint8_t *u, const uint8_t *v, int w)
+{
+    int x;
+
+    for (x = 0; x <= w - 16; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(u + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(v + x));
+
+        _mm_storeu_si128((__m128i *)(dst + 2 * x),      _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128((__m128i *)(dst + 2 * x + 16), _mm_unpackhi_epi8(a, b));
+    }
+    interleave_c(dst, u, v, x, w);
+}
+
+static void interleave_avg_sse2(uint8_t *dst, const uint8_t *u0, const uint8_t *u1,
+                                const uint8_t *v0, const uint8_t *v1, int w, int src_w)
+{
+    int x;
+
+    for (x = 0; x <= w - 16; x += 16) {
+        __m128i a = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(u0 + x)),
+                                 _mm_loadu_si128((const __m128i *)(u1 + x)));
+        __m128i b = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(v0 + x)),
+                                 _mm_loadu_si128((const __m128i *)(v1 + x)));
+
+        _mm_storeu_si128((__m128i *)(dst + 2 * x),      _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128((__m128i *)(dst + 2 * x + 16), _mm_unpackhi_epi8(a, b));
+    }
+    interleave_avg_c(dst, u0, u1, v0, v1, x, w);
+}
+
+/* sums of horizontal pairs in 16-bit lanes */
+static av_always_inline __m128i pair_sum_sse2(const uint8_t *p0, const uint8_t *p1)
+{
+    const __m128i lo = _mm_set1_epi16(0xFF);
+    __m128i a = _mm_loadu_si128((const __m128i *)p0);
+    __m128i b = _mm_loadu_si128((const __m128i *)p1);
+
+    return _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, lo), _mm_srli_epi16(a, 8)),
+                         _mm_add_epi16(_mm_and_si128(b, lo), _mm_srli_epi16(b, 8)));
+}
+
+static void interleave_box_sse2(uint8_t *dst, const uint8_t *u0, const uint8_t *u1,
+                                const uint8_t *v0, const uint8_t *v1, int w, int src_w)
+{
+    const __m128i rnd = _mm_set1_epi16(2);
+    int x;
+
+    for (x = 0; x <= FFMIN(w, src_w >> 1) - 8; x += 8) {
+        __m128i a = _mm_srli_epi16(_mm_add_epi16(pair_sum_sse2(u0 + 2 * x, u1 + 2 * x), rnd), 2);
+        __m128i b = _mm_srli_epi16(_mm_add_epi16(pair_sum_sse2(v0 + 2 * x, v1 + 2 * x), rnd), 2);
+
+        _mm_storeu_si128((__m128i *)(dst + 2 * x), _mm_or_si128(a, _mm_slli_epi16(b, 8)));
+    }
+    interleave_box_c(dst, u0, u1, v0, v1, x, w, src_w);
+}
+
+static void p010_sse2(uint8_t *dst, const uint16_t *src, const uint8_t *dither,
+                      int w, int be)
+{
+    const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)dither),
+                                        _mm_setzero_si128());
+    const __m128i k = _mm_set1_epi16(511 << 5);
+    int x;
+
+    for (x = 0; x <= w - 16; x += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + x + 8));
+
+        if (be) {
+            a = _mm_or_si128(_mm_slli_epi16(a, 8), _mm_srli_epi16(a, 8));
+            b = _mm_or_si128(_mm_slli_epi16(b, 8), _mm_srli_epi16(b, 8));
+        }
+        a = _mm_mulhi_epu16(_mm_add_epi16(_mm_srli_epi16(a, 6), d), k);
+        b = _mm_mulhi_epu16(_mm_add_epi16(_mm_srli_epi16(b, 6), d), k);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(a, b));
+    }
+    p010_c(dst, src, dither, x, w, be);
+}
+
+static void p010le_sse2(uint8_t *dst, const uint16_t *src, const uint8_t *dither, int w)
+{
+    p010_sse2(dst, src, dither, w, 0);
+}
+
+static void p010be_sse2(uint8_t *dst, const uint16_t *src, const uint8_t *dither, int w)
+{
+    p010_sse2(dst, src, dither, w, 1);
+}
+
+#if HAVE_INTRINSICS_AVX2
+/* 16 pairs u[i], v[i] in the order of the output */
+static av_always_inline av_target_avx2 __m256i interleave16_avx2(__m128i u, __m128i v)
+{
+    return _mm256_or_si256(_mm256_cvtepu8_epi16(u),
+                           _mm256_slli_epi16(_mm256_cvtepu8_epi16(v), 8));
+}
+
+static av_target_avx2 void interleave_avx2(uint8_t *dst, const uint8_t *u,
+                                           const uint8_t *v, int w)
+{
+    int x;
+
+    for (x = 0; x <= w - 16; x += 16)
+        _mm256_storeu_si256((__m256i *)(dst + 2 * x),
+                            interleave16_avx2(_mm_loadu_si128((const __m128i *)(u + x)),
+                                              _mm_loadu_si128((const __m128i *)(v + x))));
+    interleave_c(dst, u, v, x, w);
+}
+
+static av_target_avx2 void interleave_avg_avx2(uint8_t *dst,
+                                               const uint8_t *u0, const uint8_t *u1,
+                                               const uint8_t *v0, const uint8_t *v1,
+                                               int w, int src_w)
+{
+    int x;
+
+    for (x = 0; x <= w - 16; x += 16) {
+        __m128i a = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(u0 + x)),
+                                 _mm_loadu_si128((const __m128i *)(u1 + x)));
+        __m128i b = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(v0 + x)),
+                                 _mm_loadu_si128((const __m128i *)(v1 + x)));
+
+        _mm256_storeu_si256((__m256i *)(dst + 2 * x), interleave16_avx2(a, b));
+    }
+    interleave_avg_c(dst, u0, u1, v0, v1, x, w);
+}
+
+static av_always_inline av_target_avx2 __m256i pair_sum_avx2(const uint8_t *p0,
+                                                             const uint8_t *p1)
+{
+    const __m256i lo = _mm256_set1_epi16(0xFF);
+    __m256i a = _mm256_loadu_si256((const __m256i *)p0);
+    __m256i b = _mm256_loadu_si256((const __m256i *)p1);
+
+    return _mm256_add_epi16(_mm256_add_epi16(_mm256_and_si256(a, lo), _mm256_srli_epi16(a, 8)),
+                            _mm256_add_epi16(_mm256_and_si256(b, lo), _mm256_srli_epi16(b, 8)));
+}
+
+static av_target_avx2 void interleave_box_avx2(uint8_t *dst,
+                                               const uint8_t *u0, const uint8_t *u1,
+                                               const uint8_t *v0, const uint8_t *v1,
+                                               int w, int src_w)
+{
+    const __m256i rnd = _mm256_set1_epi16(2);
+    int x;
+
+    for (x = 0; x <= FFMIN(w, src_w >> 1) - 16; x += 16) {
+        __m256i a = _mm256_srli_epi16(_mm256_add_epi16(pair_sum_avx2(u0 + 2 * x, u1 + 2 * x), rnd), 2);
+        __m256i b = _mm256_srli_epi16(_mm256_add_epi16(pair_sum_avx2(v0 + 2 * x, v1 + 2 * x), rnd), 2);
+
+        _mm256_storeu_si256((__m256i *)(dst + 2 * x), _mm256_or_si256(a, _mm256_slli_epi16(b, 8)));
+    }
+    interleave_box_c(dst, u0, u1, v0, v1, x, w, src_w);
+}
+
+static av_always_inline av_target_avx2 void p010_avx2(uint8_t *dst, const uint16_t *src,
+                                                      const uint8_t *dither, int w, int be)
+{
+    const __m256i d = _mm256_cvtepu8_epi16(_mm_set1_epi64x(AV_RN64(dither)));
+    const __m256i k = _mm256_set1_epi16(511 << 5);
+    int x;
+
+    for (x = 0; x <= w - 32; x += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + x));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + x + 16));
+
+        if (be) {
+            a = _mm256_or_si256(_mm256_slli_epi16(a, 8), _mm256_srli_epi16(a, 8));
+            b = _mm256_or_si256(_mm256_slli_epi16(b, 8), _mm256_srli_epi16(b, 8));
+        }
+        a = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_srli_epi16(a, 6), d), k);
+        b = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_srli_epi16(b, 6), d), k);
+        _mm256_storeu_si256((__m256i *)(dst + x),
+                            _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+    }
+    p010_c(dst, src, dither, x, w, be);
+}
+
+static av_target_avx2 void p010le_avx2(uint8_t *dst, const uint16_t *src,
+                                       const uint8_t *dither, int w)
+{
+    p010_avx2(dst, src, dither, w, 0);
+}
+
+static av_target_avx2 void p010be_avx2(uint8_t *dst, const uint16_t *src,
+                                       const uint8_t *dither, int w)
+{
+    p010_avx2(dst, src, dither, w, 1);
+}
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+/****************************************************************************
+ * Wrappers. Like the C ones, they expect slices to start on an even line.
+ ****************************************************************************/
+
+static void copy_luma(SwsContext *c, const uint8_t *src, int srcStride,
+                      int srcSliceY, int srcSliceH, uint8_t *dst, int dstStride)
+{
+    int y;
+
+    dst += srcSliceY * dstStride;
+    for (y = 0; y < srcSliceH; y++)
+        memcpy(dst + y * dstStride, src + y * srcStride, c->srcW);
+}
+
+/* vsub and hsub describe the source chroma planes */
+static av_always_inline int planar_to_nv12(SwsContext *c, const uint8_t *src[],
+                                           int srcStride[], int srcSliceY,
+                                           int srcSliceH, uint8_t *dst[],
+                                           int dstStride[], int hsub, int vsub,
+                                           void (*interleave)(uint8_t *dst,
+                                                              const uint8_t *u,
+                                                              const uint8_t *v,
+                                                              int w),
+                                           void (*interleave2)(uint8_t *dst,
+                                                               const uint8_t *u0,
+                                                               const uint8_t *u1,
+                                                               const uint8_t *v0,
+                                                               const uint8_t *v1,
+                                                               int w, int src_w))
+{
+    const int swap   = c->dstFormat == AV_PIX_FMT_NV21;
+    const uint8_t *u = src[1 + swap], *v = src[2 - swap];
+    const int ustride = srcStride[1 + swap], vstride = srcStride[2 - swap];
+    const int w      = AV_CEIL_RSHIFT(c->srcW, 1);
+    const int src_w  = AV_CEIL_RSHIFT(c->srcW, hsub);
+    const int end    = AV_CEIL_RSHIFT(srcSliceY + srcSliceH, 1);
+    int y;
+
+    copy_luma(c, src[0], srcStride[0], srcSliceY, srcSliceH, dst[0], dstStride[0]);
+
+    for (y = srcSliceY >> 1; y < end; y++) {
+        uint8_t *out = dst[1] + y * dstStride[1];
+
+        if (vsub) {
+            const int sy = y - (srcSliceY >> 1);
+
+            interleave(out, u + sy * ustride, v + sy * vstride, w);
+        } else {
+            const int y0 = 2 * y - srcSliceY;
+            const int y1 = FFMIN(y0 + 1, srcSliceH - 1);
+
+            interleave2(out, u + y0 * ustride, u + y1 * ustride,
+                             v + y0 * vstride, v + y1 * vstride, w, src_w);
+        }
+    }
+    return srcSliceH;
+}
+
+static av_always_inline int p010_to_nv12(SwsContext *c, const uint8_t *src[],
+                                         int srcStride[], int srcSliceY,
+                                         int srcSliceH, uint8_t *dst[],
+                                         int dstStride[],
+                                         void (*convert)(uint8_t *dst,
+                                                         const uint16_t *src,
+                                                         const uint8_t *dither,
+                                                         int w))
+{
+    const int end = AV_CEIL_RSHIFT(srcSliceY + srcSliceH, 1);
+    const int w   = 2 * AV_CEIL_RSHIFT(c->srcW, 1);
+    int y;
+
+    for (y = 0; y < srcSliceH; y++)
+        convert(dst[0] + (srcSliceY + y) * dstStride[0],
+                (const uint16_t *)(src[0] + y * srcStride[0]),
+                dither_10to8[(srcSliceY + y) & 1], c->srcW);
+
+    for (y = srcSliceY >> 1; y < end; y++)
+        convert(dst[1] + y * dstStride[1],
+                (const uint16_t *)(src[1] + (y - (srcSliceY >> 1)) * srcStride[1]),
+                dither_10to8[y & 1], w);
+    return srcSliceH;
+}
+
+#define WRAPPERS(opt)                                                                   \
+static int yuv420p_to_nv12_ ## opt(SwsContext *c, const uint8_t *src[],                \
+                                   int srcStride[], int srcSliceY, int srcSliceH,      \
+                                   uint8_t *dst[], int dstStride[])                    \
+{                                                                                       \
+    return planar_to_nv12(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,      \
+                          1, 1, interleave_ ## opt, NULL);                              \
+}                                                                                       \
+                                                                                        \
+static int yuv422p_to_nv12_ ## opt(SwsContext *c, const uint8_t *src[],                \
+                                   int srcStride[], int srcSliceY, int srcSliceH,      \
+                                   uint8_t *dst[], int dstStride[])                    \
+{                                                                                       \
+    return planar_to_nv12(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,      \
+                          1, 0, NULL, interleave_avg_ ## opt);                          \
+}                                                                                       \
+                                                                                        \
+static int yuv444p_to_nv12_ ## opt(SwsContext *c, const uint8_t *src[],                \
+                                   int srcStride[], int srcSliceY, int srcSliceH,      \
+                                   uint8_t *dst[], int dstStride[])                    \
+{                                                                                       \
+    return planar_to_nv12(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,      \
+                          0, 0, NULL, interleave_box_ ## opt);                          \
+}                                                                                       \
+                                                                                        \
+static int p010le_to_nv12_ ## opt(SwsContext *c, const uint8_t *src[],                 \
+                                  int srcStride[], int srcSliceY, int srcSliceH,       \
+                                  uint8_t *dst[], int dstStride[])                     \
+{                                                                                       \
+    return p010_to_nv12(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,        \
+                        p010le_ ## opt);                                                \
+}                                                                                       \
+                                                                                        \
+static int p010be_to_nv12_ ## opt(SwsContext *c, const uint8_t *src[],                 \
+                                  int srcStride[], int srcSliceY, int srcSliceH,       \
+                                  uint8_t *dst[], int dstStride[])                     \
+{                                                                                       \
+    return p010_to_nv12(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,        \
+                        p010be_ ## opt);                                                \
+}
+
+WRAPPERS(sse2)
+#if HAVE_INTRINSICS_AVX2
+WRAPPERS(avx2)
+#endif
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+#define SET_NV12_FUNCS(opt)                                                           \
+    if (dstFormat == AV_PIX_FMT_NV12 || dstFormat == AV_PIX_FMT_NV21) {               \
+        if (srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P)      \
+            c->swscale = yuv420p_to_nv12_ ## opt;                                     \
+        else if (srcFormat == AV_PIX_FMT_YUV422P && approx)                           \
+            c->swscale = yuv422p_to_nv12_ ## opt;                                     \
+        else if (srcFormat == AV_PIX_FMT_YUV444P && approx)                           \
+            c->swscale = yuv444p_to_nv12_ ## opt;                                     \
+    }                                                                                 \
+    if (dstFormat == AV_PIX_FMT_NV12 && approx) {                                     \
+        if (srcFormat == AV_PIX_FMT_P010LE)                                           \
+            c->swscale = p010le_to_nv12_ ## opt;                                      \
+        else if (srcFormat == AV_PIX_FMT_P010BE)                                      \
+            c->swscale = p010be_to_nv12_ ## opt;                                      \
+    }
+
+/* The conversions which do not reproduce the output of the scaler, i.e. the
+ * box filtered chroma of 4:2:2 and 4:4:4 and the dithered P010, are only
+ * used without SWS_ACCURATE_RND and SWS_BITEXACT. */
+av_cold void ff_get_unscaled_swscale_x86(SwsContext *c)
+{
+#if HAVE_INTRINSICS_SSE2
+    const enum AVPixelFormat srcFormat = c->srcFormat;
+    const enum AVPixelFormat dstFormat = c->dstFormat;
+    const int approx = !(c->flags & (SWS_ACCURATE_RND | SWS_BITEXACT));
+    int cpu_flags = av_get_cpu_flags();
+
+    if (INTRINSICS_SSE2(cpu_flags)) {
+        SET_NV12_FUNCS(sse2);
+    }
+#if HAVE_INTRINSICS_AVX2
+    if (INTRINSICS_AVX2(cpu_flags)) {
+        SET_NV12_FUNCS(avx2);
+    }
+#endif
+
+    /* 4:2:0 and 4:2:2 reach ff_yuv2rgb_init_x86() through
+     * ff_yuv2rgb_get_func_ptr() already */
+    if (srcFormat == AV_PIX_FMT_YUV444P && approx &&
+        (c->dither == SWS_DITHER_BAYER || c->dither == SWS_DITHER_AUTO)) {
+        SwsFunc func = ff_yuv2rgb_init_x86(c);
+
+        if (func)
+            c->swscale = func;
+    }
+#endif
+}
@@ -0,0 +1,160 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * YUV to RGB32 conversion, SSE2 and AVX2 intrinsics
+ */
+
+#include "config.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixfmt.h"
+#include "libavutil/x86/cpu.h"
+
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#if HAVE_INTRINSICS_SSE2
+#include <emmintrin.h>
+#if HAVE_INTRINSICS_AVX2
+#include <immintrin.h>
+#endif
+
+static av_always_inline __m128i load_luma_sse2(const uint8_t *p)
+{
+    return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+/* 8 samples, or 4 repeated ones for horizontally subsampled chroma */
+static av_always_inline __m128i load_chroma_sse2(const uint8_t *p, int hsub)
+{
+    __m128i v;
+
+    if (!hsub)
+        return load_luma_sse2(p);
+    v = _mm_cvtsi32_si128(AV_RN32(p));
+    return _mm_unpacklo_epi8(_mm_unpacklo_epi8(v, v), _mm_setzero_si128());
+}
+
+/* lo and hi hold the bytes 0,1 and 2,3 of 8 pixels */
+static av_always_inline void store_sse2(uint8_t *dst, __m128i lo, __m128i hi)
+{
+    _mm_storeu_si128((__m128i *)dst,        _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(lo, hi));
+}
+
+#define VEC             __m128i
+#define STEP            8
+#define TARGET
+#define V(op)           _mm_ ## op
+#define SETZERO         _mm_setzero_si128
+#define OR(a, b)        _mm_or_si128(a, b)
+#define FN(name)        name ## _sse2
+#include "yuv2rgb_template.c"
+#undef VEC
+#undef STEP
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef OR
+#undef FN
+
+#if HAVE_INTRINSICS_AVX2
+static av_always_inline av_target_avx2 __m256i load_luma_avx2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+static av_always_inline av_target_avx2 __m256i load_chroma_avx2(const uint8_t *p, int hsub)
+{
+    __m128i v;
+
+    if (!hsub)
+        return load_luma_avx2(p);
+    v = _mm_loadl_epi64((const __m128i *)p);
+    return _mm256_cvtepu8_epi16(_mm_unpacklo_epi8(v, v));
+}
+
+/* the unpacks work within 128-bit lanes, so pixels 0-3 and 8-11 end up in
+ * the first register */
+static av_always_inline av_target_avx2 void store_avx2(uint8_t *dst, __m256i lo, __m256i hi)
+{
+    __m256i a = _mm256_unpacklo_epi16(lo, hi);
+    __m256i b = _mm256_unpackhi_epi16(lo, hi);
+
+    _mm256_storeu_si256((__m256i *)dst,        _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+#define VEC             __m256i
+#define STEP            16
+#define TARGET          av_target_avx2
+#define V(op)           _mm256_ ## op
+#define SETZERO         _mm256_setzero_si256
+#define OR(a, b)        _mm256_or_si256(a, b)
+#define FN(name)        name ## _avx2
+#include "yuv2rgb_template.c"
+#undef VEC
+#undef STEP
+#undef TARGET
+#undef V
+#undef SETZERO
+#undef OR
+#undef FN
+#endif /* HAVE_INTRINSICS_AVX2 */
+
+#endif /* HAVE_INTRINSICS_SSE2 */
+
+#define RGB32_FUNCS(opt)                                                  \
+    switch (c->dstFormat) {                                               \
+    case AV_PIX_FMT_RGBA: return yuv2rgba_ ## opt;                        \
+    case AV_PIX_FMT_BGRA: return yuv2bgra_ ## opt;                        \
+    case AV_PIX_FMT_ARGB: return yuv2argb_ ## opt;                        \
+    case AV_PIX_FMT_ABGR: return yuv2abgr_ ## opt;                        \
+    default:              return NULL;                                    \
+    }
+
+/* Only the 32-bit RGB outputs are handled, the rest uses the C tables. */
+av_cold SwsFunc ff_yuv2rgb_init_x86(SwsContext *c)
+{
+#if HAVE_INTRINSICS_SSE2
+    int cpu_flags = av_get_cpu_flags();
+
+    if (c->srcFormat != AV_PIX_FMT_YUV420P  &&
+        c->srcFormat != AV_PIX_FMT_YUVA420P &&
+        c->srcFormat != AV_PIX_FMT_YUV422P  &&
+        c->srcFormat != AV_PIX_FMT_YUV444P)
+        return NULL;
+
+#if HAVE_INTRINSICS_AVX2
+    if (INTRINSICS_AVX2(cpu_flags))
+        RGB32_FUNCS(avx2)
+#endif
+    if (INTRINSICS_SSE2(cpu_flags))
+        RGB32_FUNCS(sse2)
+#endif
+    return NULL;
+}
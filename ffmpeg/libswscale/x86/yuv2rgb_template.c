@@ -0,0 +1,131 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Planar YUV to packed 32-bit RGB, included by yuv2rgb.c once per vector
+ * width. STEP pixels are converted per iteration in 16-bit lanes.
+ *
+ * The includer defines VEC, STEP, TARGET, V(), SETZERO, OR() and FN() and
+ * provides FN(load_luma), FN(load_chroma) and FN(store), see yuv2rgb.c.
+ */
+
+/* Same fixed point arithmetic and coefficients as the MMX code: samples are
+ * scaled by 8 and multiplied with the 3.13 coefficients by pmulhw. dst
+ * receives STEP pixels, the byte order of a pixel is given by the positions
+ * of R, G, B and A. */
+static av_always_inline TARGET void FN(convert)(uint8_t *dst, const SwsContext *c,
+                                                VEC y, VEC u, VEC v, VEC a,
+                                                int rpos, int gpos, int bpos, int apos)
+{
+    const VEC zero = SETZERO();
+    const VEC max  = V(set1_epi16)(255);
+    VEC ch[4], r, g, b;
+
+    y = V(mulhi_epi16)(V(sub_epi16)(V(slli_epi16)(y, 3), V(set1_epi64x)(c->yOffset)),
+                       V(set1_epi64x)(c->yCoeff));
+    u = V(sub_epi16)(V(slli_epi16)(u, 3), V(set1_epi64x)(c->uOffset));
+    v = V(sub_epi16)(V(slli_epi16)(v, 3), V(set1_epi64x)(c->vOffset));
+
+    r = V(adds_epi16)(y, V(mulhi_epi16)(v, V(set1_epi64x)(c->vrCoeff)));
+    g = V(adds_epi16)(y, V(adds_epi16)(V(mulhi_epi16)(u, V(set1_epi64x)(c->ugCoeff)),
+                                       V(mulhi_epi16)(v, V(set1_epi64x)(c->vgCoeff))));
+    b = V(adds_epi16)(y, V(mulhi_epi16)(u, V(set1_epi64x)(c->ubCoeff)));
+
+    ch[rpos] = V(min_epi16)(V(max_epi16)(r, zero), max);
+    ch[gpos] = V(min_epi16)(V(max_epi16)(g, zero), max);
+    ch[bpos] = V(min_epi16)(V(max_epi16)(b, zero), max);
+    ch[apos] = a;
+
+    FN(store)(dst, OR(ch[0], V(slli_epi16)(ch[1], 8)),
+                   OR(ch[2], V(slli_epi16)(ch[3], 8)));
+}
+
+static av_always_inline TARGET void FN(yuv2rgb32_row)(uint8_t *dst, const SwsContext *c,
+                                                      const uint8_t *py, const uint8_t *pu,
+                                                      const uint8_t *pv, const uint8_t *pa,
+                                                      int w, int hsub,
+                                                      int rpos, int gpos, int bpos, int apos)
+{
+    const VEC opaque = V(set1_epi16)(255);
+    int x;
+
+    for (x = 0; x <= w - STEP; x += STEP)
+        FN(convert)(dst + 4 * x, c, FN(load_luma)(py + x),
+                    FN(load_chroma)(pu + (x >> hsub), hsub),
+                    FN(load_chroma)(pv + (x >> hsub), hsub),
+                    pa ? FN(load_luma)(pa + x) : opaque,
+                    rpos, gpos, bpos, apos);
+
+    if (x < w) {
+        DECLARE_ALIGNED(32, uint8_t, tmp)[4][STEP] = { { 0 } };
+        DECLARE_ALIGNED(32, uint8_t, out)[4 * STEP];
+        const int n = w - x, nc = AV_CEIL_RSHIFT(w, hsub) - (x >> hsub);
+
+        memcpy(tmp[0], py + x, n);
+        memcpy(tmp[1], pu + (x >> hsub), nc);
+        memcpy(tmp[2], pv + (x >> hsub), nc);
+        if (pa)
+            memcpy(tmp[3], pa + x, n);
+        FN(convert)(out, c, FN(load_luma)(tmp[0]),
+                    FN(load_chroma)(tmp[1], hsub), FN(load_chroma)(tmp[2], hsub),
+                    pa ? FN(load_luma)(tmp[3]) : opaque,
+                    rpos, gpos, bpos, apos);
+        memcpy(dst + 4 * x, out, 4 * n);
+    }
+}
+
+static av_always_inline TARGET int FN(yuv2rgb32)(SwsContext *c, const uint8_t *src[],
+                                                 int srcStride[], int srcSliceY,
+                                                 int srcSliceH, uint8_t *dst[],
+                                                 int dstStride[],
+                                                 int rpos, int gpos, int bpos, int apos)
+{
+    const int hsub  = c->chrSrcHSubSample;
+    const int vsub  = c->chrSrcVSubSample;
+    const int alpha = CONFIG_SWSCALE_ALPHA && isALPHA(c->srcFormat) && src[3];
+    int y;
+
+    for (y = 0; y < srcSliceH; y++) {
+        const int cy = ((srcSliceY + y) >> vsub) - (srcSliceY >> vsub);
+
+        FN(yuv2rgb32_row)(dst[0] + (srcSliceY + y) * dstStride[0], c,
+                          src[0] + y  * srcStride[0],
+                          src[1] + cy * srcStride[1],
+                          src[2] + cy * srcStride[2],
+                          alpha ? src[3] + y * srcStride[3] : NULL,
+                          c->dstW, hsub, rpos, gpos, bpos, apos);
+    }
+    return srcSliceH;
+}
+
+#define YUV2RGB32_FUNC(name, rpos, gpos, bpos, apos)                                   \
+static TARGET int FN(yuv2 ## name)(SwsContext *c, const uint8_t *src[],               \
+                                   int srcStride[], int srcSliceY, int srcSliceH,     \
+                                   uint8_t *dst[], int dstStride[])                   \
+{                                                                                      \
+    return FN(yuv2rgb32)(c, src, srcStride, srcSliceY, srcSliceH, dst, dstStride,      \
+                         rpos, gpos, bpos, apos);                                      \
+}
+
+YUV2RGB32_FUNC(rgba, 0, 1, 2, 3)
+YUV2RGB32_FUNC(bgra, 2, 1, 0, 3)
+YUV2RGB32_FUNC(argb, 1, 2, 3, 0)
+YUV2RGB32_FUNC(abgr, 3, 2, 1, 0)
+
+#undef YUV2RGB32_FUNC
@@ -0,0 +1,117 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#include "libavfilter/af_volume.h"
+
+#include "checkasm.h"
+
+#define LEN 1024
+
+/* The scale_samples_s16_small() and scale_samples_s32() functions of
+ * af_volume.c, which are static there. */
+static void scale_samples_ref(uint8_t *dst, const uint8_t *src, int nb_samples,
+                              int volume, enum AVSampleFormat sample_fmt)
+{
+    int i;
+
+    if (sample_fmt == AV_SAMPLE_FMT_S16) {
+        int16_t *smp_dst       = (int16_t *)dst;
+        const int16_t *smp_src = (const int16_t *)src;
+        for (i = 0; i < nb_samples; i++)
+            smp_dst[i] = av_clip_int16((smp_src[i] * volume + 128) >> 8);
+    } else {
+        int32_t *smp_dst       = (int32_t *)dst;
+        const int32_t *smp_src = (const int32_t *)src;
+        for (i = 0; i < nb_samples; i++)
+            smp_dst[i] = av_clipl_int32((((int64_t)smp_src[i] * volume + 128) >> 8));
+    }
+}
+
+/* Full scale samples show up often in real audio, mix them in to exercise
+ * the clipping */
+static void randomize_samples(uint8_t *buf, enum AVSampleFormat sample_fmt)
+{
+    int i;
+
+    for (i = 0; i < LEN; i++) {
+        uint32_t r = rnd();
+        if (sample_fmt == AV_SAMPLE_FMT_S16)
+            ((int16_t *)buf)[i] = r & 7 ? r >> 16 : r & 8 ? INT16_MAX : INT16_MIN;
+        else
+            ((int32_t *)buf)[i] = r & 7 ? rnd() : r & 8 ? INT32_MAX : INT32_MIN;
+    }
+}
+
+static void check_scale_samples(enum AVSampleFormat sample_fmt, int volume)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,     [LEN * 4]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [LEN * 4 + 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [LEN * 4 + 32]);
+    const int bps = av_get_bytes_per_sample(sample_fmt);
+    VolumeContext vol = { 0 };
+    int i;
+
+    declare_func(void, uint8_t *dst, const uint8_t *src, int nb_samples, int volume);
+
+    vol.sample_fmt = sample_fmt;
+    vol.volume_i   = volume;
+    if (ARCH_X86)
+        ff_volume_init_x86(&vol);
+
+    if (!check_func(vol.scale_samples, "scale_samples_%s_%d",
+                    av_get_sample_fmt_name(sample_fmt), volume))
+        return;
+
+    for (i = 0; i < 4; i++) {
+        /* full length, odd lengths and lengths shorter than a vector */
+        int n = i ? rnd() % (LEN >> (2 * i)) + 1 : LEN;
+        int offset = i & 1;
+
+        randomize_samples(src, sample_fmt);
+        memset(dst_ref, 0x55, LEN * bps + 32);
+        memset(dst_new, 0x55, LEN * bps + 32);
+        scale_samples_ref(dst_ref + offset * bps, src + offset * bps, n, volume, sample_fmt);
+        call_new(dst_new + offset * bps, src + offset * bps, n, volume);
+        if (memcmp(dst_ref, dst_new, LEN * bps + 32))
+            fail();
+    }
+    bench_new(dst_new, src, LEN, volume);
+}
+
+void checkasm_check_volume(void)
+{
+    /* unity, the signed 16-bit boundary, the largest volumes each function
+     * handles, and a gain that clips */
+    static const int s16_volumes[] = { 256, 0x7fff, 0x8000, 0xffff, 3000 };
+    static const int s32_volumes[] = { 256, 3000, (1 << 22) - 1 };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(s16_volumes); i++)
+        check_scale_samples(AV_SAMPLE_FMT_S16, s16_volumes[i]);
+    report("scale_samples_s16");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(s32_volumes); i++)
+        check_scale_samples(AV_SAMPLE_FMT_S32, s32_volumes[i]);
+    report("scale_samples_s32");
+}
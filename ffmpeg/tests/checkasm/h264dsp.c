@@ -226,7 +226,103 @@ static void check_idct(void)
     report("idct");
 }
 
+#define LF_STRIDE (16 * SIZEOF_PIXEL)
+
+/* Smooth random blocks with a step across the edge, so the thresholds pass
+ * often enough to reach every branch of the filters */
+static void randomize_loop_filter(uint8_t *buf, int bit_depth, int dir,
+                                  int alpha, int beta)
+{
+    const int max   = (1 << bit_depth) - 1;
+    const int shift = bit_depth - 8;
+    int base  = rnd() & max;
+    int step  = (int)(rnd() % (2 * alpha + 1)) - alpha;
+    int noise = beta + 1;
+    int x, y;
+
+    for (y = 0; y < 16; y++) {
+        for (x = 0; x < 16; x++) {
+            int side = (dir ? x : y) >= 8;
+            int v = base + ((side * step + (int)(rnd() % (2 * noise + 1)) - noise) << shift);
+            v = av_clip(v, 0, max);
+            if (bit_depth == 8)
+                buf[y * LF_STRIDE + x] = v;
+            else
+                AV_WN16A(buf + y * LF_STRIDE + 2 * x, v);
+        }
+    }
+}
+
+#define CHECK_LOOP_FILTER(name, dir, args)                                   \
+    do {                                                                     \
+        if (check_func(h.h264_##name, "h264_" #name "_%dbpp", bit_depth)) {  \
+            int off = dir ? 8 * SIZEOF_PIXEL : 8 * LF_STRIDE;                \
+            for (i = 0; i < 32; i++) {                                       \
+                alpha = rnd() % 64 + 4;                                      \
+                beta  = rnd() % 18 + 1;                                      \
+                for (j = 0; j < 4; j++)                                      \
+                    tc0[j] = (int)(rnd() % 27) - 1;                          \
+                randomize_loop_filter(buf, bit_depth, dir, alpha, beta);     \
+                memcpy(buf0, buf, 16 * LF_STRIDE);                           \
+                memcpy(buf1, buf, 16 * LF_STRIDE);                           \
+                pix = buf0 + off;                                            \
+                call_ref args;                                               \
+                pix = buf1 + off;                                            \
+                call_new args;                                               \
+                if (memcmp(buf0, buf1, 16 * LF_STRIDE))                      \
+                    fail();                                                  \
+            }                                                                \
+            bench_new args;                                                  \
+        }                                                                    \
+    } while (0)
+
+static void check_loop_filter(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf,  [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, buf0, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, buf1, [16 * 16 * 2]);
+    H264DSPContext h;
+    uint8_t *pix;
+    int8_t tc0[4];
+    int bit_depth, alpha, beta, i, j;
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *pix, int stride,
+                      int alpha, int beta, int8_t *tc0);
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        ff_h264dsp_init(&h, bit_depth, 1);
+        CHECK_LOOP_FILTER(v_loop_filter_luma,   0, (pix, LF_STRIDE, alpha, beta, tc0));
+        CHECK_LOOP_FILTER(h_loop_filter_luma,   1, (pix, LF_STRIDE, alpha, beta, tc0));
+        CHECK_LOOP_FILTER(v_loop_filter_chroma, 0, (pix, LF_STRIDE, alpha, beta, tc0));
+        CHECK_LOOP_FILTER(h_loop_filter_chroma, 1, (pix, LF_STRIDE, alpha, beta, tc0));
+    }
+    report("loop_filter");
+}
+
+static void check_loop_filter_intra(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf,  [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, buf0, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, buf1, [16 * 16 * 2]);
+    H264DSPContext h;
+    uint8_t *pix;
+    int8_t tc0[4];
+    int bit_depth, alpha, beta, i, j;
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *pix, int stride,
+                      int alpha, int beta);
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        ff_h264dsp_init(&h, bit_depth, 1);
+        CHECK_LOOP_FILTER(v_loop_filter_luma_intra,   0, (pix, LF_STRIDE, alpha, beta));
+        CHECK_LOOP_FILTER(h_loop_filter_luma_intra,   1, (pix, LF_STRIDE, alpha, beta));
+        CHECK_LOOP_FILTER(v_loop_filter_chroma_intra, 0, (pix, LF_STRIDE, alpha, beta));
+        CHECK_LOOP_FILTER(h_loop_filter_chroma_intra, 1, (pix, LF_STRIDE, alpha, beta));
+    }
+    report("loop_filter_intra");
+}
+
 void checkasm_check_h264dsp(void)
 {
     check_idct();
+    check_loop_filter();
+    check_loop_filter_intra();
 }
@@ -0,0 +1,194 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/intreadwrite.h"
+
+#include "libavcodec/hevcdsp.h"
+
+#include "checkasm.h"
+
+static const int widths[] = { 2, 4, 6, 8, 12, 16, 24, 32, 48, 64 };
+
+/* room for the filter taps above, below, left and right of the block */
+#define SRC_STRIDE  (MAX_PB_SIZE + 32)
+#define SRC_ROWS    (MAX_PB_SIZE + 16)
+#define SRC_OFFSET  (4 * SRC_STRIDE + 16)
+#define DST_SIZE    (MAX_PB_SIZE * MAX_PB_SIZE)
+
+#define randomize_pixels(buf, size, bit_depth)                  \
+    do {                                                        \
+        int j;                                                  \
+        for (j = 0; j < size; j++) {                            \
+            if (bit_depth > 8)                                  \
+                AV_WN16A(buf + 2 * j, rnd() & 0x3FF);           \
+            else                                                \
+                buf[j] = rnd();                                 \
+        }                                                       \
+    } while (0)
+
+#define randomize_words(buf, size)                              \
+    do {                                                        \
+        int j;                                                  \
+        for (j = 0; j < size; j++)                              \
+            buf[j] = rnd();                                     \
+    } while (0)
+
+typedef struct MCBuffers {
+    uint8_t *src;
+    int16_t *src2;
+    int16_t *put0, *put1;
+    uint8_t *dst0, *dst1;
+} MCBuffers;
+
+static void check_mc_set(const char *name, int bit_depth, int max_idx, MCBuffers *b,
+                         void (*put[10][2][2])(int16_t *, uint8_t *, ptrdiff_t,
+                                                int, intptr_t, intptr_t, int),
+                         void (*uni[10][2][2])(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t,
+                                                int, intptr_t, intptr_t, int),
+                         void (*bi[10][2][2])(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t,
+                                               int16_t *, int, intptr_t, intptr_t, int),
+                         void (*uni_w[10][2][2])(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t,
+                                                  int, int, int, int, intptr_t, intptr_t, int),
+                         void (*bi_w[10][2][2])(uint8_t *, ptrdiff_t, uint8_t *, ptrdiff_t,
+                                                 int16_t *, int, int, int, int, int, int,
+                                                 intptr_t, intptr_t, int))
+{
+    static const char *const dirs[2][2] = { { "pixels", "h" }, { "v", "hv" } };
+    const int ps        = bit_depth > 8;
+    ptrdiff_t srcstride = SRC_STRIDE << ps;
+    ptrdiff_t dststride = MAX_PB_SIZE << ps;
+    uint8_t *src        = b->src + (SRC_OFFSET << ps);
+    int i, v, h;
+
+    for (i = max_idx == 3 ? 1 : 0; i < 10; i++) {
+        int width  = widths[i];
+        int height = width;
+
+        for (v = 0; v < 2; v++) {
+            for (h = 0; h < 2; h++) {
+                intptr_t mx = h ? 1 + rnd() % max_idx : 0;
+                intptr_t my = v ? 1 + rnd() % max_idx : 0;
+                int denom   = rnd() % 8;
+                int wx0     = (1 << denom) + (int)(rnd() % 256) - 128;
+                int wx1     = (1 << denom) + (int)(rnd() % 256) - 128;
+                int ox0     = (int)(rnd() % 256) - 128;
+                int ox1     = (int)(rnd() % 256) - 128;
+
+                if (check_func(put[i][v][h], "put_hevc_%s_%s%d_%d", name, dirs[v][h], width, bit_depth)) {
+                    declare_func(void, int16_t *dst, uint8_t *src, ptrdiff_t srcstride,
+                                 int height, intptr_t mx, intptr_t my, int width);
+
+                    randomize_words(b->put0, DST_SIZE);
+                    memcpy(b->put1, b->put0, DST_SIZE * sizeof(*b->put0));
+                    call_ref(b->put0, src, srcstride, height, mx, my, width);
+                    call_new(b->put1, src, srcstride, height, mx, my, width);
+                    if (memcmp(b->put0, b->put1, DST_SIZE * sizeof(*b->put0)))
+                        fail();
+                    bench_new(b->put1, src, srcstride, height, mx, my, width);
+                }
+
+                if (check_func(uni[i][v][h], "put_hevc_%s_uni_%s%d_%d", name, dirs[v][h], width, bit_depth)) {
+                    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src,
+                                 ptrdiff_t srcstride, int height, intptr_t mx, intptr_t my,
+                                 int width);
+
+                    randomize_pixels(b->dst0, DST_SIZE, bit_depth);
+                    memcpy(b->dst1, b->dst0, DST_SIZE << ps);
+                    call_ref(b->dst0, dststride, src, srcstride, height, mx, my, width);
+                    call_new(b->dst1, dststride, src, srcstride, height, mx, my, width);
+                    if (memcmp(b->dst0, b->dst1, DST_SIZE << ps))
+                        fail();
+                    bench_new(b->dst1, dststride, src, srcstride, height, mx, my, width);
+                }
+
+                if (check_func(bi[i][v][h], "put_hevc_%s_bi_%s%d_%d", name, dirs[v][h], width, bit_depth)) {
+                    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src,
+                                 ptrdiff_t srcstride, int16_t *src2, int height,
+                                 intptr_t mx, intptr_t my, int width);
+
+                    randomize_pixels(b->dst0, DST_SIZE, bit_depth);
+                    memcpy(b->dst1, b->dst0, DST_SIZE << ps);
+                    call_ref(b->dst0, dststride, src, srcstride, b->src2, height, mx, my, width);
+                    call_new(b->dst1, dststride, src, srcstride, b->src2, height, mx, my, width);
+                    if (memcmp(b->dst0, b->dst1, DST_SIZE << ps))
+                        fail();
+                    bench_new(b->dst1, dststride, src, srcstride, b->src2, height, mx, my, width);
+                }
+
+                if (check_func(uni_w[i][v][h], "put_hevc_%s_uni_w_%s%d_%d", name, dirs[v][h], width, bit_depth)) {
+                    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src,
+                                 ptrdiff_t srcstride, int height, int denom, int wx, int ox,
+                                 intptr_t mx, intptr_t my, int width);
+
+                    randomize_pixels(b->dst0, DST_SIZE, bit_depth);
+                    memcpy(b->dst1, b->dst0, DST_SIZE << ps);
+                    call_ref(b->dst0, dststride, src, srcstride, height, denom, wx1, ox1, mx, my, width);
+                    call_new(b->dst1, dststride, src, srcstride, height, denom, wx1, ox1, mx, my, width);
+                    if (memcmp(b->dst0, b->dst1, DST_SIZE << ps))
+                        fail();
+                    bench_new(b->dst1, dststride, src, srcstride, height, denom, wx1, ox1, mx, my, width);
+                }
+
+                if (check_func(bi_w[i][v][h], "put_hevc_%s_bi_w_%s%d_%d", name, dirs[v][h], width, bit_depth)) {
+                    declare_func(void, uint8_t *dst, ptrdiff_t dststride, uint8_t *src,
+                                 ptrdiff_t srcstride, int16_t *src2, int height, int denom,
+                                 int wx0, int wx1, int ox0, int ox1,
+                                 intptr_t mx, intptr_t my, int width);
+
+                    randomize_pixels(b->dst0, DST_SIZE, bit_depth);
+                    memcpy(b->dst1, b->dst0, DST_SIZE << ps);
+                    call_ref(b->dst0, dststride, src, srcstride, b->src2, height, denom,
+                             wx0, wx1, ox0, ox1, mx, my, width);
+                    call_new(b->dst1, dststride, src, srcstride, b->src2, height, denom,
+                             wx0, wx1, ox0, ox1, mx, my, width);
+                    if (memcmp(b->dst0, b->dst1, DST_SIZE << ps))
+                        fail();
+                    bench_new(b->dst1, dststride, src, srcstride, b->src2, height, denom,
+                              wx0, wx1, ox0, ox1, mx, my, width);
+                }
+            }
+        }
+    }
+}
+
+void checkasm_check_hevc_mc(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src,  [SRC_ROWS * SRC_STRIDE * 2]);
+    LOCAL_ALIGNED_32(int16_t, src2, [DST_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, put0, [DST_SIZE]);
+    LOCAL_ALIGNED_32(int16_t, put1, [DST_SIZE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_SIZE * 2]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_SIZE * 2]);
+    MCBuffers b = { src, src2, put0, put1, dst0, dst1 };
+    int bit_depth;
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        randomize_pixels(src, SRC_ROWS * SRC_STRIDE, bit_depth);
+        randomize_words(src2, DST_SIZE);
+        check_mc_set("qpel", bit_depth, 3, &b, h.put_hevc_qpel, h.put_hevc_qpel_uni,
+                     h.put_hevc_qpel_bi, h.put_hevc_qpel_uni_w, h.put_hevc_qpel_bi_w);
+        check_mc_set("epel", bit_depth, 7, &b, h.put_hevc_epel, h.put_hevc_epel_uni,
+                     h.put_hevc_epel_bi, h.put_hevc_epel_uni_w, h.put_hevc_epel_bi_w);
+    }
+    report("mc");
+}
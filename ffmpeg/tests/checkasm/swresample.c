@@ -0,0 +1,261 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+
+#include "libswresample/audioconvert.h"
+#include "libswresample/resample.h"
+
+#include "checkasm.h"
+
+#define SRC_LEN 1024
+#define DST_LEN 256
+
+static const struct {
+    int filter_length, phase_count, src_incr, dst_incr;
+} resample_params[] = {
+    { 32, 1024, 160, 147 * 1024 }, /* 44100 -> 48000 */
+    { 35, 1024, 147, 160 * 1024 }, /* 48000 -> 44100 */
+    { 11,   32,   3,   4 *   32 }, /* odd length, few phases */
+};
+
+static double random_sample(void)
+{
+    return (int)(rnd() & 0xffff) / 32768.0 - 1.0;
+}
+
+/* Sample and filter ranges keep the integer sums within the accumulators of
+ * the C code, the zero padding of the filter bank is the same as in
+ * resample.c. */
+static void fill(ResampleContext *c, uint8_t *src, int filter_length)
+{
+    int i, j;
+
+    for (i = 0; i < SRC_LEN; i++) {
+        switch (c->format) {
+        case AV_SAMPLE_FMT_S16P: ((int16_t *)src)[i] = rnd();                break;
+        case AV_SAMPLE_FMT_S32P: ((int32_t *)src)[i] = rnd();                break;
+        case AV_SAMPLE_FMT_FLTP: ((float   *)src)[i] = random_sample();      break;
+        case AV_SAMPLE_FMT_DBLP: ((double  *)src)[i] = random_sample();      break;
+        }
+    }
+
+    memset(c->filter_bank, 0, (c->phase_count + 1) * c->filter_alloc * c->felem_size);
+    for (i = 0; i <= c->phase_count; i++) {
+        for (j = 0; j < filter_length; j++) {
+            int k = i * c->filter_alloc + j;
+            switch (c->format) {
+            case AV_SAMPLE_FMT_S16P: ((int16_t *)c->filter_bank)[k] = (int)(rnd() & 0x7ff) - 0x400;            break;
+            case AV_SAMPLE_FMT_S32P: ((int32_t *)c->filter_bank)[k] = (int)(rnd() & 0x1ffffff) - 0x1000000;    break;
+            case AV_SAMPLE_FMT_FLTP: ((float   *)c->filter_bank)[k] = random_sample() / filter_length;        break;
+            case AV_SAMPLE_FMT_DBLP: ((double  *)c->filter_bank)[k] = random_sample() / filter_length;        break;
+            }
+        }
+    }
+}
+
+static int compare(enum AVSampleFormat fmt, const uint8_t *a, const uint8_t *b, int n)
+{
+    int i;
+
+    switch (fmt) {
+    case AV_SAMPLE_FMT_FLTP:
+        for (i = 0; i < n; i++)
+            if (!float_near_abs_eps(((const float *)a)[i], ((const float *)b)[i], 1e-5))
+                return i;
+        return -1;
+    case AV_SAMPLE_FMT_DBLP:
+        for (i = 0; i < n; i++)
+            if (!double_near_abs_eps(((const double *)a)[i], ((const double *)b)[i], 1e-12))
+                return i;
+        return -1;
+    default:
+        for (i = 0; i < n; i++)
+            if (memcmp(a + i * av_get_bytes_per_sample(fmt),
+                       b + i * av_get_bytes_per_sample(fmt), av_get_bytes_per_sample(fmt)))
+                return i;
+        return -1;
+    }
+}
+
+static void check_resample(void)
+{
+    static const enum AVSampleFormat formats[] = {
+        AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP,
+    };
+    LOCAL_ALIGNED_32(uint8_t, src,     [SRC_LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [DST_LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [DST_LEN * 8]);
+    int f, p, linear;
+
+    declare_func(int, ResampleContext *c, void *dst, const void *src, int n, int update_ctx);
+
+    for (f = 0; f < FF_ARRAY_ELEMS(formats); f++) {
+        for (p = 0; p < FF_ARRAY_ELEMS(resample_params); p++) {
+            for (linear = 0; linear < 2; linear++) {
+                ResampleContext c = { 0 }, c_ref, c_new;
+                const char *name = av_get_sample_fmt_name(formats[f]);
+                void *func;
+
+                c.format        = formats[f];
+                c.felem_size    = av_get_bytes_per_sample(c.format);
+                c.filter_length = resample_params[p].filter_length;
+                c.filter_alloc  = FFALIGN(c.filter_length, 8);
+                c.phase_count   = resample_params[p].phase_count;
+                c.src_incr      = resample_params[p].src_incr;
+                c.dst_incr      = resample_params[p].dst_incr;
+                c.dst_incr_div  = c.dst_incr / c.src_incr;
+                c.dst_incr_mod  = c.dst_incr % c.src_incr;
+                c.linear        = linear;
+                swri_resample_dsp_init(&c);
+
+                func = linear ? (void *)c.dsp.resample_linear : (void *)c.dsp.resample_common;
+                if (!check_func(func, "resample_%s_%s_%d", linear ? "linear" : "common",
+                                name, c.filter_length))
+                    continue;
+
+                c.filter_bank = av_malloc((c.phase_count + 1) * c.filter_alloc * c.felem_size);
+                if (!c.filter_bank) {
+                    fail();
+                    continue;
+                }
+                fill(&c, src, c.filter_length);
+                c.index = rnd() % (2 * c.phase_count);
+                c.frac  = rnd() % c.src_incr;
+
+                c_ref = c_new = c;
+                memset(dst_ref, 0, DST_LEN * c.felem_size);
+                memset(dst_new, 0, DST_LEN * c.felem_size);
+                if (call_ref(&c_ref, dst_ref, src, DST_LEN, 1) !=
+                    call_new(&c_new, dst_new, src, DST_LEN, 1) ||
+                    c_ref.index != c_new.index || c_ref.frac != c_new.frac ||
+                    compare(c.format, dst_ref, dst_new, DST_LEN) >= 0)
+                    fail();
+
+                c_new = c;
+                bench_new(&c_new, dst_new, src, DST_LEN, 0);
+                av_freep(&c.filter_bank);
+            }
+        }
+    }
+    report("resample");
+}
+
+#define LEN 256
+
+static void fill_samples(enum AVSampleFormat fmt, uint8_t *buf, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        switch (av_get_packed_sample_fmt(fmt)) {
+        case AV_SAMPLE_FMT_S16: ((int16_t *)buf)[i] = rnd();                   break;
+        case AV_SAMPLE_FMT_S32: ((int32_t *)buf)[i] = rnd();                   break;
+        /* out of range values check the clipping */
+        case AV_SAMPLE_FMT_FLT: ((float   *)buf)[i] = random_sample() * 1.5;   break;
+        case AV_SAMPLE_FMT_DBL: ((double  *)buf)[i] = random_sample() * 1.5;   break;
+        }
+    }
+}
+
+static void check_audio_convert(void)
+{
+    static const struct {
+        enum AVSampleFormat out, in;
+        int channels;
+    } convs[] = {
+        { AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_S16P, 1 },
+        { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P, 1 },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16P, 1 },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S32P, 1 },
+        { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_FLTP, 1 },
+        { AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLTP, 1 },
+        { AV_SAMPLE_FMT_DBLP, AV_SAMPLE_FMT_FLTP, 1 },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP, 1 },
+        { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_S16P, 2 },
+        { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S16,  2 },
+        { AV_SAMPLE_FMT_FLT,  AV_SAMPLE_FMT_FLTP, 2 },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_FLT,  2 },
+        { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_FLTP, 2 },
+        { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16,  2 },
+    };
+    LOCAL_ALIGNED_32(uint8_t, src,     [2 * LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [2 * LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [2 * LEN * 8]);
+    int i, ch;
+
+    declare_func(void, uint8_t **dst, const uint8_t **src, int len);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(convs); i++) {
+        int channels = convs[i].channels;
+        int ibps = av_get_bytes_per_sample(convs[i].in);
+        int obps = av_get_bytes_per_sample(convs[i].out);
+        int iplanar = av_sample_fmt_is_planar(convs[i].in);
+        int oplanar = av_sample_fmt_is_planar(convs[i].out);
+        AudioConvert *ac = swri_audio_convert_alloc(convs[i].out, convs[i].in,
+                                                    channels, NULL, 0);
+        const uint8_t *in[2];
+        uint8_t *out_ref[2], *out_new[2];
+
+        if (!ac) {
+            fail();
+            continue;
+        }
+
+        for (ch = 0; ch < channels; ch++) {
+            in[ch]      = src     + (iplanar ? ch * LEN * ibps : 0);
+            out_ref[ch] = dst_ref + (oplanar ? ch * LEN * obps : 0);
+            out_new[ch] = dst_new + (oplanar ? ch * LEN * obps : 0);
+        }
+
+        /* the C code has no whole buffer functions, the per channel ones
+         * are the reference */
+        if (check_func(ac->simd_f, "conv_%s_to_%s%s", av_get_sample_fmt_name(convs[i].in),
+                       av_get_sample_fmt_name(convs[i].out), channels == 2 ? "_2ch" : "")) {
+            fill_samples(convs[i].in, src, channels * LEN);
+            memset(dst_ref, 0, 2 * LEN * 8);
+            memset(dst_new, 0, 2 * LEN * 8);
+
+            for (ch = 0; ch < channels; ch++) {
+                int is = iplanar ? ibps : channels * ibps;
+                int os = oplanar ? obps : channels * obps;
+                uint8_t *po = out_ref[ch] + (oplanar ? 0 : ch * obps);
+
+                ac->conv_f(po, in[ch] + (iplanar ? 0 : ch * ibps), is, os, po + LEN * os);
+            }
+            call_new(out_new, in, LEN);
+            if (memcmp(dst_ref, dst_new, channels * LEN * obps))
+                fail();
+
+            bench_new(out_new, in, LEN);
+        }
+        swri_audio_convert_free(&ac);
+    }
+    report("audio_convert");
+}
+
+void checkasm_check_swresample(void)
+{
+    check_resample();
+    check_audio_convert();
+}
@@ -0,0 +1,149 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libavfilter/vf_overlay.h"
+
+#include "checkasm.h"
+
+#define WIDTH    256
+#define ALINESIZE (2 * WIDTH + 64)
+
+#define FAST_DIV255(x) ((((x) + 128) * 257) >> 16)
+
+/* The per-pixel code of blend_plane() in vf_overlay.c, for a pixel that has
+ * a right and a lower neighbour in the overlay alpha plane. There is no C
+ * version of blend_row, the C code blends the whole line itself. */
+static void blend_row_ref(uint8_t *d, const uint8_t *s, const uint8_t *a, int w,
+                          ptrdiff_t alinesize, int hsub, int vsub,
+                          int straight, int chroma)
+{
+    int k, alpha;
+
+    for (k = 0; k < w; k++) {
+        if (hsub && vsub)
+            alpha = (a[0] + a[alinesize] + a[1] + a[alinesize + 1]) >> 2;
+        else if (hsub)
+            alpha = (a[0] + ((a[0] + a[1]) >> 1)) >> 1;
+        else
+            alpha = a[0];
+
+        if (straight)
+            d[k] = FAST_DIV255(d[k] * (255 - alpha) + s[k] * alpha);
+        else if (chroma)
+            d[k] = av_clip_uint8(FAST_DIV255((d[k] - 128) * (255 - alpha)) + s[k]);
+        else
+            d[k] = FFMIN(FAST_DIV255(d[k] * (255 - alpha)) + s[k], 255);
+        a += 1 << hsub;
+    }
+}
+
+/* Opaque and transparent pixels are common in overlays, make sure they
+ * show up next to the partially transparent ones. */
+static void randomize_alpha(uint8_t *a, int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        uint32_t r = rnd();
+        a[i] = r & 3 ? r >> 24 : (r >> 8) & 1 ? 255 : 0;
+    }
+}
+
+#define randomize_buffers()                     \
+    do {                                        \
+        int j;                                  \
+        for (j = 0; j < WIDTH + 32; j++) {      \
+            dst_ref[j] = dst_new[j] = rnd();    \
+            src[j] = rnd();                     \
+        }                                       \
+        randomize_alpha(alpha, 2 * ALINESIZE);  \
+    } while (0)
+
+static void check_blend_row(enum AVPixelFormat pix_fmt, int alpha_format)
+{
+    LOCAL_ALIGNED_32(uint8_t, dst_ref, [WIDTH + 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst_new, [WIDTH + 32]);
+    LOCAL_ALIGNED_32(uint8_t, src,     [WIDTH + 32]);
+    LOCAL_ALIGNED_32(uint8_t, alpha,   [2 * ALINESIZE]);
+    const int straight = alpha_format == ALPHA_FORMAT_STRAIGHT;
+    OverlayContext s = { 0 };
+    int plane, i;
+
+    declare_func(int, uint8_t *d, const uint8_t *s, const uint8_t *a,
+                 int w, ptrdiff_t alinesize);
+
+    s.main_desc    = av_pix_fmt_desc_get(pix_fmt);
+    s.hsub         = s.main_desc->log2_chroma_w;
+    s.vsub         = s.main_desc->log2_chroma_h;
+    s.alpha_format = alpha_format;
+    if (ARCH_X86)
+        ff_overlay_init_x86(&s);
+
+    /* the two chroma planes share their function */
+    for (plane = 0; plane < 2; plane++) {
+        int hsub = plane ? s.hsub : 0;
+        int vsub = plane ? s.vsub : 0;
+
+        if (!plane && pix_fmt != AV_PIX_FMT_YUV444P)
+            continue;
+        if (!check_func(s.blend_row[plane], "blend_row_%s_%s",
+                        plane ? s.main_desc->name : "luma",
+                        straight ? "straight" : "premultiplied"))
+            continue;
+
+        for (i = 0; i < 4; i++) {
+            /* full width, odd widths and lines shorter than a vector */
+            int w = i ? rnd() % (WIDTH >> i) + 1 : WIDTH;
+            int offset = i & 1;
+            int n;
+
+            randomize_buffers();
+            n = call_new(dst_new + offset, src + offset, alpha + (offset << hsub), w, ALINESIZE);
+            if (n < 0 || n > w || n < w - 15)
+                fail();
+            blend_row_ref(dst_ref + offset, src + offset, alpha + (offset << hsub), n,
+                          ALINESIZE, hsub, vsub, straight, !!plane);
+            if (memcmp(dst_ref, dst_new, WIDTH + 32))
+                fail();
+        }
+        bench_new(dst_new, src, alpha, WIDTH, ALINESIZE);
+    }
+}
+
+void checkasm_check_overlay(void)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_YUV444P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV420P,
+    };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(pix_fmts); i++)
+        check_blend_row(pix_fmts[i], ALPHA_FORMAT_STRAIGHT);
+    report("straight");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(pix_fmts); i++)
+        check_blend_row(pix_fmts[i], ALPHA_FORMAT_PREMULTIPLIED);
+    report("premultiplied");
+}
@@ -343,6 +343,45 @@ concat(){
     fi
 }
 
+# Writes the index cache of $4 with the seek test $2 ($1 = seek) or with a
+# read to EOF ($1 = linear), truncates it or writes it for a shorter copy of
+# the input ($4 = truncated, mismatch), then runs the seek test with it. The
+# cache has to be restored only if it is valid.
+seek_index_cache(){
+    write=$1
+    seek=$2
+    src=$3
+    change=$4
+    cache="${outdir}/${test}.cache"
+    logfile="${outdir}/${test}.log"
+    input=$src
+    cleanfiles="$cache $logfile"
+    rm -f "$cache"
+
+    if [ "$change" = "mismatch" ]; then
+        input="${outdir}/${test}.ts"
+        cleanfiles="$cleanfiles $input"
+        head -c 100000 "$src" > "$input" || return
+    fi
+    case $write in
+        seek)   run $seek $(target_path $input) -index_cache $(target_path $cache) > /dev/null ;;
+        linear) ffmpeg -index_cache $(target_path $cache) -i $(target_path $input) -c copy -f null - ;;
+    esac || return
+    test -s "$cache" || return
+    if [ "$change" = "truncated" ]; then
+        size=$(wc -c < "$cache")
+        head -c $((size - 20)) "$cache" > "$cache.tmp" && mv -f "$cache.tmp" "$cache" || return
+    fi
+
+    run $seek $(target_path $src) -index_cache $(target_path $cache) -verbose 1 2> "$logfile" || return
+    cat "$logfile" >&2
+    if [ -z "$change" ]; then
+        grep -q "^\[.*\] Restored" "$logfile"
+    else
+        ! grep -q "^\[.*\] Restored" "$logfile"
+    fi
+}
+
 mkdir -p "$outdir"
 
 # Disable globbing: command arguments may contain globbing characters and
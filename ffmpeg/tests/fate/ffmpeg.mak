@@ -130,3 +130,27 @@ fate-time_base: $(TARGET_SAMPLES)/mpeg2/dvd_single_frame.vob
 fate-time_base: CMD = md5 -i $(TARGET_SAMPLES)/mpeg2/dvd_single_frame.vob -an -sn -c:v copy -r 25 -time_base 1001:30000 -fflags +bitexact -f mxf
 
 FATE_SAMPLES_FFMPEG-yes += $(FATE_TIME_BASE-yes)
+
+# the mmap protocol has to return the same packets as the file protocol;
+# rawvideo frames reference the mapping through av_get_packet(), mpegts reads
+# it with ffio_read_indirect(), and -ss seeks back after the probing and the
+# duration estimation have read ahead
+FATE_MMAP-$(call ALLYES, MMAP_PROTOCOL RAWVIDEO_DEMUXER FRAMEMD5_MUXER) += fate-mmap-rawvideo fate-mmap-rawvideo-file
+fate-mmap-rawvideo fate-mmap-rawvideo-file: tests/data/vsynth1.yuv
+fate-mmap-rawvideo:      CMD = framemd5 -f rawvideo -s 352x288 -i mmap:$(TARGET_PATH)/tests/data/vsynth1.yuv -c copy
+fate-mmap-rawvideo-file: CMD = framemd5 -f rawvideo -s 352x288 -i file:$(TARGET_PATH)/tests/data/vsynth1.yuv -c copy
+fate-mmap-rawvideo-file: REF = $(SRC_PATH)/tests/ref/fate/mmap-rawvideo
+
+FATE_MMAP_TS-$(call ALLYES, MMAP_PROTOCOL FRAMEMD5_MUXER) += fate-mmap-ts fate-mmap-ts-file
+FATE_MMAP_TS-$(call ALLYES, MMAP_PROTOCOL FRAMEMD5_MUXER) += fate-mmap-ts-seekback fate-mmap-ts-seekback-file
+FATE_MMAP-$(call ENCDEC2, MPEG2VIDEO, MP2, MPEGTS) += $(FATE_MMAP_TS-yes)
+$(FATE_MMAP_TS-yes): fate-lavf-ts
+fate-mmap-ts:               CMD = framemd5 -i mmap:$(TARGET_PATH)/tests/data/lavf/lavf.ts -c copy
+fate-mmap-ts-file:          CMD = framemd5 -i file:$(TARGET_PATH)/tests/data/lavf/lavf.ts -c copy
+fate-mmap-ts-file:          REF = $(SRC_PATH)/tests/ref/fate/mmap-ts
+fate-mmap-ts-seekback:      CMD = framemd5 -ss 1 -i mmap:$(TARGET_PATH)/tests/data/lavf/lavf.ts -c copy
+fate-mmap-ts-seekback-file: CMD = framemd5 -ss 1 -i file:$(TARGET_PATH)/tests/data/lavf/lavf.ts -c copy
+fate-mmap-ts-seekback-file: REF = $(SRC_PATH)/tests/ref/fate/mmap-ts-seekback
+
+FATE_FFMPEG += $(FATE_MMAP-yes)
+fate-mmap: $(FATE_MMAP-yes)
@@ -120,6 +120,10 @@ fate-filter-gradfun: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf gradfun
 FATE_FILTER_VSYNTH-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d
 fate-filter-hqdn3d: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf hqdn3d
 
+FATE_FILTER_VSYNTH-$(CONFIG_HQDN3D_FILTER) += fate-filter-hqdn3d-threads
+fate-filter-hqdn3d-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-hqdn3d
+fate-filter-hqdn3d-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 5 -vf hqdn3d
+
 FATE_FILTER_VSYNTH-$(CONFIG_INTERLACE_FILTER) += fate-filter-interlace
 fate-filter-interlace: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf interlace
 
@@ -178,6 +182,15 @@ FATE_FILTER_VSYNTH-$(CONFIG_OVERLAY_FILTER) += fate-filter-overlay
 fate-filter-overlay: tests/data/filtergraphs/overlay
 fate-filter-overlay: CMD = framecrc -c:v pgmyuv -i $(SRC) -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay
 
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER SCALE_FILTER HQDN3D_FILTER UNSHARP_FILTER) += fate-filter-ladder
+fate-filter-ladder: tests/data/filtergraphs/ladder
+fate-filter-ladder: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/ladder -map "[o1]" -map "[o2]" -map "[o3]"
+
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER SCALE_FILTER HQDN3D_FILTER UNSHARP_FILTER) += fate-filter-ladder-graph-threads
+fate-filter-ladder-graph-threads: tests/data/filtergraphs/ladder
+fate-filter-ladder-graph-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-ladder
+fate-filter-ladder-graph-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_complex_threads 4 -filter_thread_type slice+graph -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/ladder -map "[o1]" -map "[o2]" -map "[o3]"
+
 FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER SCALE_FILTER PAD_FILTER OVERLAY_FILTER) += fate-filter-overlay_rgb
 fate-filter-overlay_rgb: tests/data/filtergraphs/overlay_rgb
 fate-filter-overlay_rgb: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay_rgb
@@ -204,9 +217,46 @@ FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER SCALE_FILTER PAD_FILTER OVERLAY_F
 fate-filter-overlay_yuv444: tests/data/filtergraphs/overlay_yuv444
 fate-filter-overlay_yuv444: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay_yuv444
 
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER TRIM_FILTER SCALE_FILTER FORMAT_FILTER GEQ_FILTER OVERLAY_FILTER) += fate-filter-overlay_pip
+fate-filter-overlay_pip: tests/data/filtergraphs/overlay_pip
+fate-filter-overlay_pip: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/overlay_pip
+
 FATE_FILTER_VSYNTH-$(CONFIG_PHASE_FILTER) += fate-filter-phase
 fate-filter-phase: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf phase
 
+# The stats go to stdout, the -threads tests must print the same stats.
+FATE_PSNR += fate-filter-psnr
+fate-filter-psnr: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 1 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1[c];[a][c]psnr=f=-" -f null -
+
+FATE_PSNR += fate-filter-psnr-threads
+fate-filter-psnr-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-psnr
+fate-filter-psnr-threads: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 5 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1[c];[a][c]psnr=f=-" -f null -
+
+FATE_PSNR += fate-filter-psnr-json-10bit
+fate-filter-psnr-json-10bit: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 1 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1,format=yuv420p10le[c];[a]format=yuv420p10le[d];[d][c]psnr=f=-:stats_format=json:frame_subsample=3:row_subsample=2" -f null -
+
+FATE_PSNR += fate-filter-psnr-json-10bit-threads
+fate-filter-psnr-json-10bit-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-psnr-json-10bit
+fate-filter-psnr-json-10bit-threads: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 5 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1,format=yuv420p10le[c];[a]format=yuv420p10le[d];[d][c]psnr=f=-:stats_format=json:frame_subsample=3:row_subsample=2" -f null -
+
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER UNSHARP_FILTER FORMAT_FILTER PSNR_FILTER NULL_MUXER WRAPPED_AVFRAME_ENCODER) += $(FATE_PSNR)
+
+FATE_SSIM += fate-filter-ssim
+fate-filter-ssim: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 1 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1[c];[a][c]ssim=f=-" -f null -
+
+FATE_SSIM += fate-filter-ssim-threads
+fate-filter-ssim-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-ssim
+fate-filter-ssim-threads: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 5 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1[c];[a][c]ssim=f=-" -f null -
+
+FATE_SSIM += fate-filter-ssim-json-10bit
+fate-filter-ssim-json-10bit: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 1 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1,format=yuv420p10le[c];[a]format=yuv420p10le[d];[d][c]ssim=f=-:stats_format=json:frame_subsample=3:row_subsample=2" -f null -
+
+FATE_SSIM += fate-filter-ssim-json-10bit-threads
+fate-filter-ssim-json-10bit-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-ssim-json-10bit
+fate-filter-ssim-json-10bit-threads: CMD = ffmpeg -c:v pgmyuv -i $(SRC) -filter_threads 5 -lavfi "split[a][b];[b]unsharp=5:5:1:5:5:1,format=yuv420p10le[c];[a]format=yuv420p10le[d];[d][c]ssim=f=-:stats_format=json:frame_subsample=3:row_subsample=2" -f null -
+
+FATE_FILTER_VSYNTH-$(call ALLYES, SPLIT_FILTER UNSHARP_FILTER FORMAT_FILTER SSIM_FILTER NULL_MUXER WRAPPED_AVFRAME_ENCODER) += $(FATE_SSIM)
+
 FATE_REMOVEGRAIN += fate-filter-removegrain-mode-00
 fate-filter-removegrain-mode-00: CMD = framecrc -c:v pgmyuv -i $(SRC) -frames:v 1 -vf removegrain=0:0:0
 
@@ -343,6 +393,10 @@ FATE_FILTER_VSYNTH-$(CONFIG_TRIM_FILTER) += $(FATE_TRIM)
 FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp
 fate-filter-unsharp: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf unsharp=11:11:-1.5:11:11:-1.5
 
+FATE_FILTER_VSYNTH-$(CONFIG_UNSHARP_FILTER) += fate-filter-unsharp-threads
+fate-filter-unsharp-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-unsharp
+fate-filter-unsharp-threads: CMD = framecrc -c:v pgmyuv -i $(SRC) -filter_threads 5 -vf unsharp=11:11:-1.5:11:11:-1.5
+
 FATE_FILTER_SAMPLES-$(call ALLYES, SMJPEG_DEMUXER MJPEG_DECODER PERMS_FILTER HQDN3D_FILTER) += fate-filter-hqdn3d-sample
 fate-filter-hqdn3d-sample: tests/data/filtergraphs/hqdn3d
 fate-filter-hqdn3d-sample: CMD = framecrc -idct simple -i $(TARGET_SAMPLES)/smjpeg/scenwin.mjpg -filter_complex_script $(TARGET_PATH)/tests/data/filtergraphs/hqdn3d -an
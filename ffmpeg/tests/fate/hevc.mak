@@ -215,12 +215,65 @@ FATE_HEVC += fate-hevc-conformance-$(1)
 fate-hevc-conformance-$(1): CMD = framecrc -flags unaligned -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit -pix_fmt yuv444p12le
 endef
 
+# tiles, and WPP with dependent slices and entry points, decoded with slice threads
+# and tile_threads, must match the single threaded output
+HEVC_SAMPLES_SLICE_THREADS =    \
+    DSLICE_A_HHI_5              \
+    DSLICE_B_HHI_5              \
+    DSLICE_C_HHI_5              \
+    ENTP_A_Qualcomm_1           \
+    ENTP_B_Qualcomm_1           \
+    ENTP_C_Qualcomm_1           \
+    TILES_A_Cisco_2             \
+    TILES_B_Cisco_1             \
+
+define FATE_HEVC_TEST_SLICE_THREADS
+FATE_HEVC_SLICE_THREADS-$(HAVE_THREADS) += fate-hevc-conformance-slice-threads-$(1)
+fate-hevc-conformance-slice-threads-$(1): CMD = framecrc -flags unaligned -tile_threads 1 -vsync drop -i $(TARGET_SAMPLES)/hevc-conformance/$(1).bit
+fate-hevc-conformance-slice-threads-$(1): REF = $(SRC_PATH)/tests/ref/fate/hevc-conformance-$(1)
+fate-hevc-conformance-slice-threads-$(1): THREADS = 4
+fate-hevc-conformance-slice-threads-$(1): THREAD_TYPE = slice
+endef
+
 $(foreach N,$(HEVC_SAMPLES),$(eval $(call FATE_HEVC_TEST,$(N))))
 $(foreach N,$(HEVC_SAMPLES_10BIT),$(eval $(call FATE_HEVC_TEST_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIT),$(eval $(call FATE_HEVC_TEST_422_10BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_422_10BIN),$(eval $(call FATE_HEVC_TEST_422_10BIN,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_8BIT),$(eval $(call FATE_HEVC_TEST_444_8BIT,$(N))))
 $(foreach N,$(HEVC_SAMPLES_444_12BIT),$(eval $(call FATE_HEVC_TEST_444_12BIT,$(N))))
+$(foreach N,$(HEVC_SAMPLES_SLICE_THREADS),$(eval $(call FATE_HEVC_TEST_SLICE_THREADS,$(N))))
+
+# streams of tests/hevcgen, with random syntax in the tile, WPP and dependent
+# slice segment layouts the conformance samples above lack, tiles with WPP in
+# particular; the slice threads output must match the single threaded one
+HEVC_GEN_STREAMS = tiles wpp tiles-wpp tiles-wpp-ctb32
+
+tests/data/hevc-gen-tiles.hevc:           HEVCGEN_ARGS = tiles=4x3 slices=1 pps=3 frames=4
+tests/data/hevc-gen-wpp.hevc:             HEVCGEN_ARGS = wpp=1 slices=1 frames=4
+tests/data/hevc-gen-tiles-wpp.hevc:       HEVCGEN_ARGS = tiles=3x2 wpp=1 slices=1 pps=3 frames=4
+tests/data/hevc-gen-tiles-wpp-ctb32.hevc: HEVCGEN_ARGS = size=640x360 ctb=32 tiles=4x2 uniform=1 wpp=1 frames=3
+
+tests/data/hevc-gen-%.hevc: TAG = GEN
+tests/data/hevc-gen-%.hevc: tests/hevcgen$(HOSTEXESUF) | tests/data
+	$(M)./$< $@ $(HEVCGEN_ARGS)
+
+define FATE_HEVC_GEN_TEST
+FATE_HEVC_GEN += fate-hevc-gen-$(1)
+fate-hevc-gen-$(1): tests/data/hevc-gen-$(1).hevc
+fate-hevc-gen-$(1): CMD = framecrc -i $(TARGET_PATH)/tests/data/hevc-gen-$(1).hevc
+
+FATE_HEVC_GEN_SLICE_THREADS-$(HAVE_THREADS) += fate-hevc-gen-slice-threads-$(1)
+fate-hevc-gen-slice-threads-$(1): tests/data/hevc-gen-$(1).hevc
+fate-hevc-gen-slice-threads-$(1): CMD = framecrc -tile_threads 1 -i $(TARGET_PATH)/tests/data/hevc-gen-$(1).hevc
+fate-hevc-gen-slice-threads-$(1): REF = $(SRC_PATH)/tests/ref/fate/hevc-gen-$(1)
+fate-hevc-gen-slice-threads-$(1): THREADS = 4
+fate-hevc-gen-slice-threads-$(1): THREAD_TYPE = slice
+endef
+
+$(foreach N,$(HEVC_GEN_STREAMS),$(eval $(call FATE_HEVC_GEN_TEST,$(N))))
+
+FATE_HEVC_GEN-$(call DEMDEC, HEVC, HEVC) += $(FATE_HEVC_GEN) $(FATE_HEVC_GEN_SLICE_THREADS-yes)
+FATE_FFMPEG += $(FATE_HEVC_GEN-yes)
 
 fate-hevc-paramchange-yuv420p-yuv420p10: CMD = framecrc -vsync 0 -i $(TARGET_SAMPLES)/hevc/paramchange_yuv420p_yuv420p10.hevc -sws_flags area+accurate_rnd+bitexact
 FATE_HEVC += fate-hevc-paramchange-yuv420p-yuv420p10
@@ -237,6 +290,7 @@ fate-hevc-bsf-mp4toannexb: CMP = oneline
 fate-hevc-bsf-mp4toannexb: REF = 1873662a3af1848c37e4eb25722c8df9
 
 FATE_HEVC-$(call DEMDEC, HEVC, HEVC) += $(FATE_HEVC)
+FATE_HEVC-$(call DEMDEC, HEVC, HEVC) += $(FATE_HEVC_SLICE_THREADS-yes)
 
 # this sample has two stsd entries and needs to reload extradata
 FATE_HEVC-$(call DEMDEC, MOV, HEVC) += fate-hevc-extradata-reload
@@ -245,4 +299,4 @@ fate-hevc-extradata-reload: CMD = framemd5 -i $(TARGET_SAMPLES)/hevc/extradata-r
 
 FATE_SAMPLES_AVCONV += $(FATE_HEVC-yes)
 
-fate-hevc: $(FATE_HEVC-yes)
+fate-hevc: $(FATE_HEVC-yes) $(FATE_HEVC_GEN-yes)
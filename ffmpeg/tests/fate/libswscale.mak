@@ -2,6 +2,12 @@ FATE_LIBSWSCALE += fate-sws-pixdesc-query
 fate-sws-pixdesc-query: libswscale/tests/pixdesc_query$(EXESUF)
 fate-sws-pixdesc-query: CMD = run libswscale/tests/pixdesc_query
 
+FATE_LIBSWSCALE-$(HAVE_THREADS) += fate-sws-threads
+fate-sws-threads: libswscale/tests/threads$(EXESUF)
+fate-sws-threads: CMD = run libswscale/tests/threads
+fate-sws-threads: CMP = null
+fate-sws-threads: REF = /dev/null
+
 FATE_LIBSWSCALE += $(FATE_LIBSWSCALE-yes)
 FATE-$(CONFIG_SWSCALE) += $(FATE_LIBSWSCALE)
 fate-libswscale: $(FATE_LIBSWSCALE)
@@ -243,6 +243,44 @@ fate-seek-lavf-yuv4mpeg: SRC = lavf/lavf.y4m
 
 FATE_SEEK += $(FATE_SEEK_LAVF-yes:%=fate-seek-lavf-%)
 
+# the lazily generated mov index has to seek like the full one
+FATE_SEEK_LAZY_INDEX-$(call ENCDEC2, MPEG4, PCM_ALAW, MOV) += fate-seek-lavf-mov-lazy_index
+fate-seek-lavf-mov-lazy_index: fate-lavf-mov libavformat/tests/seek$(EXESUF)
+fate-seek-lavf-mov-lazy_index: CMD = run libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.mov -lazy_index 1
+fate-seek-lavf-mov-lazy_index: REF = $(SRC_PATH)/tests/ref/seek/lavf-mov
+
+FATE_AVCONV += $(FATE_SEEK_LAZY_INDEX-yes)
+fate-seek: $(FATE_SEEK_LAZY_INDEX-yes)
+
+# an index cache written by one open and restored by the next one has to
+# seek like the demuxer, a truncated cache or the cache of another input is
+# ignored; the -complete tests write it with a linear read to EOF so it also
+# holds index entries
+FATE_SEEK_INDEX_CACHE_LINEAR-$(CONFIG_NULL_MUXER) += fate-seek-lavf-ts-index_cache-complete
+FATE_SEEK_INDEX_CACHE_LINEAR-$(CONFIG_NULL_MUXER) += fate-seek-lavf-ts-index_cache-truncated
+FATE_SEEK_INDEX_CACHE_LINEAR-$(CONFIG_NULL_MUXER) += fate-seek-lavf-ts-index_cache-mismatch
+FATE_SEEK_INDEX_CACHE-$(call ENCDEC2, MPEG2VIDEO, MP2, MPEGTS) += fate-seek-lavf-ts-index_cache
+FATE_SEEK_INDEX_CACHE-$(call ENCDEC2, MPEG2VIDEO, MP2, MPEGTS) += $(FATE_SEEK_INDEX_CACHE_LINEAR-yes)
+$(FATE_SEEK_INDEX_CACHE-yes): fate-lavf-ts libavformat/tests/seek$(EXESUF)
+$(FATE_SEEK_INDEX_CACHE-yes): REF = $(SRC_PATH)/tests/ref/seek/lavf-ts
+fate-seek-lavf-ts-index_cache:           CMD = seek_index_cache seek   libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.ts
+fate-seek-lavf-ts-index_cache-complete:  CMD = seek_index_cache linear libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.ts
+fate-seek-lavf-ts-index_cache-truncated: CMD = seek_index_cache linear libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.ts truncated
+fate-seek-lavf-ts-index_cache-mismatch:  CMD = seek_index_cache linear libavformat/tests/seek$(EXESUF) $(TARGET_PATH)/tests/data/lavf/lavf.ts mismatch
+
+FATE_AVCONV += $(FATE_SEEK_INDEX_CACHE-yes)
+fate-seek: $(FATE_SEEK_INDEX_CACHE-yes)
+
+# seeking back and forth within the mapping of the mmap protocol
+FATE_SEEK_MMAP_TS-$(CONFIG_MMAP_PROTOCOL) += fate-seek-lavf-ts-mmap
+FATE_SEEK_MMAP-$(call ENCDEC2, MPEG2VIDEO, MP2, MPEGTS) += $(FATE_SEEK_MMAP_TS-yes)
+fate-seek-lavf-ts-mmap: fate-lavf-ts libavformat/tests/seek$(EXESUF)
+fate-seek-lavf-ts-mmap: CMD = run libavformat/tests/seek$(EXESUF) mmap:$(TARGET_PATH)/tests/data/lavf/lavf.ts
+fate-seek-lavf-ts-mmap: REF = $(SRC_PATH)/tests/ref/seek/lavf-ts
+
+FATE_AVCONV += $(FATE_SEEK_MMAP-yes)
+fate-seek: $(FATE_SEEK_MMAP-yes)
+
 # extra files
 
 FATE_SEEK_EXTRA-$(CONFIG_MP3_DEMUXER)   += fate-seek-extra-mp3
@@ -151,11 +151,17 @@ $(eval $(call FATE_VP9_SUITE,parallelmode-akiyo))
 $(eval $(call FATE_VP9_SUITE,segmentation-aq-akiyo))
 $(eval $(call FATE_VP9_SUITE,segmentation-sf-akiyo))
 $(eval $(call FATE_VP9_SUITE,tiling-pedestrian))
+$(eval $(call FATE_VP9_SUITE,tiling-pedestrian,-slice))
 $(eval $(call FATE_VP9_SUITE,trac3849))
 $(eval $(call FATE_VP9_SUITE,trac4359))
 endef
 
 $(eval $(call FATE_VP9_FULL))
+
+# fate-run.sh passes -threads before -i, so the thread settings must be set here
+fate-vp9-slice-tiling-pedestrian: THREADS = 4
+fate-vp9-slice-tiling-pedestrian: THREAD_TYPE = slice
+
 FATE_VP9-$(CONFIG_IVF_DEMUXER) += fate-vp9-05-resize
 fate-vp9-05-resize: CMD = framemd5 -i $(TARGET_SAMPLES)/vp9-test-vectors/vp90-2-05-resize.ivf -s 352x288 -sws_flags bitexact+bilinear
 fate-vp9-05-resize: REF = $(SRC_PATH)/tests/ref/fate/vp9-05-resize
@@ -0,0 +1,1548 @@
+/*
+ * Generate HEVC bitstreams with random syntax, to test the decoding of
+ * tiles, wavefront parallel processing (WPP) and dependent slice segments.
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The stream is an IDR picture followed by P pictures, 8-bit 4:2:0 Main
+ * profile. Every syntax element is chosen at random within the constraints
+ * of the specification: CU and TU trees, intra modes, merge candidates,
+ * motion vector differences, QP deltas, SAO parameters and the residual
+ * coefficients. The pictures are noise; the streams are meant for comparing
+ * decoding modes, e.g. slice threads against a single thread.
+ *
+ * Slices and dependent slice segments are cut at random CTBs where the
+ * tile and WPP rules allow it, and each slice segment carries the entry
+ * points of its substreams.
+ *
+ * Usage: hevcgen file [size=WxH] [ctb=16|32] [tiles=CxR] [uniform=0|1]
+ *                     [wpp=0|1] [slices=0|1] [pps=N] [frames=N] [seed=N]
+ *
+ * tiles=CxR sets the tile columns and rows of the first PPS, uniform=1
+ * spaces them uniformly. The other PPSs, used by turns, have random
+ * layouts with up to C columns and R rows.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TILES    20
+#define MAX_PPS      4
+#define NB_CONTEXTS  166
+
+enum { SLICE_B, SLICE_P, SLICE_I };
+enum { PART_2Nx2N, PART_2NxN, PART_Nx2N, PART_NxN };
+
+#define NOT_INTRA 0xff
+#define INTRA_DC  1
+
+/* Context offsets, in the layout of init_values */
+#define SAO_MERGE        0
+#define SAO_TYPE         1
+#define SPLIT_CU         2
+#define SKIP             6
+#define CU_QP_DELTA      9
+#define PRED_MODE       12
+#define PART_MODE       13
+#define PREV_INTRA      17
+#define CHROMA_MODE     18
+#define MERGE_FLAG      20
+#define MERGE_IDX       21
+#define MVD_GREATER0    31
+#define MVD_GREATER1    34
+#define MVP_FLAG        35
+#define RQT_ROOT_CBF    36
+#define SPLIT_TRANSFORM 37
+#define CBF_LUMA        40
+#define CBF_CHROMA      42
+#define LAST_X_PREFIX   52
+#define LAST_Y_PREFIX   70
+#define CSBF            88
+#define SIG_COEFF       92
+#define GREATER1       136
+#define GREATER2       160
+
+static const uint8_t lps_range[64][4] = {
+    { 128, 176, 208, 240 }, { 128, 167, 197, 227 }, { 128, 158, 187, 216 }, { 123, 150, 178, 205 },
+    { 116, 142, 169, 195 }, { 111, 135, 160, 185 }, { 105, 128, 152, 175 }, { 100, 122, 144, 166 },
+    {  95, 116, 137, 158 }, {  90, 110, 130, 150 }, {  85, 104, 123, 142 }, {  81,  99, 117, 135 },
+    {  77,  94, 111, 128 }, {  73,  89, 105, 122 }, {  69,  85, 100, 116 }, {  66,  80,  95, 110 },
+    {  62,  76,  90, 104 }, {  59,  72,  86,  99 }, {  56,  69,  81,  94 }, {  53,  65,  77,  89 },
+    {  51,  62,  73,  85 }, {  48,  59,  69,  80 }, {  46,  56,  66,  76 }, {  43,  53,  63,  72 },
+    {  41,  50,  59,  69 }, {  39,  48,  56,  65 }, {  37,  45,  54,  62 }, {  35,  43,  51,  59 },
+    {  33,  41,  48,  56 }, {  32,  39,  46,  53 }, {  30,  37,  43,  50 }, {  29,  35,  41,  48 },
+    {  27,  33,  39,  45 }, {  26,  31,  37,  43 }, {  24,  30,  35,  41 }, {  23,  28,  33,  39 },
+    {  22,  27,  32,  37 }, {  21,  26,  30,  35 }, {  20,  24,  29,  33 }, {  19,  23,  27,  31 },
+    {  18,  22,  26,  30 }, {  17,  21,  25,  28 }, {  16,  20,  23,  27 }, {  15,  19,  22,  25 },
+    {  14,  18,  21,  24 }, {  14,  17,  20,  23 }, {  13,  16,  19,  22 }, {  12,  15,  18,  21 },
+    {  12,  14,  17,  20 }, {  11,  14,  16,  19 }, {  11,  13,  15,  18 }, {  10,  12,  15,  17 },
+    {  10,  12,  14,  16 }, {   9,  11,  13,  15 }, {   9,  11,  12,  14 }, {   8,  10,  12,  14 },
+    {   8,   9,  11,  13 }, {   7,   9,  11,  12 }, {   7,   9,  10,  12 }, {   7,   8,  10,  11 },
+    {   6,   8,   9,  11 }, {   6,   7,   9,  10 }, {   6,   7,   8,   9 }, {   2,   2,   2,   2 },
+};
+
+static const uint8_t trans_lps[64] = {
+     0,  0,  1,  2,  2,  4,  4,  5,  6,  7,  8,  9,  9, 11, 11, 12,
+    13, 13, 15, 15, 16, 16, 18, 18, 19, 19, 21, 21, 22, 22, 23, 24,
+    24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 30, 30, 31, 32, 32, 33,
+    33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 37, 38, 38, 63,
+};
+
+static const uint8_t init_values[3][NB_CONTEXTS] = {
+    {
+        153, 200, 139, 141, 157, 154, 154, 154, 154, 154, 154, 154,
+        154, 184, 154, 154, 154, 184,  63, 139, 154, 154, 154, 154,
+        154, 154, 154, 154, 154, 154, 154, 154, 154, 154, 154, 154,
+        154, 153, 138, 138, 111, 141,  94, 138, 182, 154, 139, 139,
+        139, 139, 139, 139, 110, 110, 124, 125, 140, 153, 125, 127,
+        140, 109, 111, 143, 127, 111,  79, 108, 123,  63, 110, 110,
+        124, 125, 140, 153, 125, 127, 140, 109, 111, 143, 127, 111,
+         79, 108, 123,  63,  91, 171, 134, 141, 111, 111, 125, 110,
+        110,  94, 124, 108, 124, 107, 125, 141, 179, 153, 125, 107,
+        125, 141, 179, 153, 125, 107, 125, 141, 179, 153, 125, 140,
+        139, 182, 182, 152, 136, 152, 136, 153, 136, 139, 111, 136,
+        139, 111, 141, 111, 140,  92, 137, 138, 140, 152, 138, 139,
+        153,  74, 149,  92, 139, 107, 122, 152, 140, 179, 166, 182,
+        140, 227, 122, 197, 138, 153, 136, 167, 152, 152,
+    },
+    {
+        153, 185, 107, 139, 126, 154, 197, 185, 201, 154, 154, 154,
+        149, 154, 139, 154, 154, 154, 152, 139, 110, 122,  95,  79,
+         63,  31,  31, 153, 153, 153, 153, 140, 198, 140, 198, 168,
+         79, 124, 138,  94, 153, 111, 149, 107, 167, 154, 139, 139,
+        139, 139, 139, 139, 125, 110,  94, 110,  95,  79, 125, 111,
+        110,  78, 110, 111, 111,  95,  94, 108, 123, 108, 125, 110,
+         94, 110,  95,  79, 125, 111, 110,  78, 110, 111, 111,  95,
+         94, 108, 123, 108, 121, 140,  61, 154, 155, 154, 139, 153,
+        139, 123, 123,  63, 153, 166, 183, 140, 136, 153, 154, 166,
+        183, 140, 136, 153, 154, 166, 183, 140, 136, 153, 154, 170,
+        153, 123, 123, 107, 121, 107, 121, 167, 151, 183, 140, 151,
+        183, 140, 140, 140, 154, 196, 196, 167, 154, 152, 167, 182,
+        182, 134, 149, 136, 153, 121, 136, 137, 169, 194, 166, 167,
+        154, 167, 137, 182, 107, 167,  91, 122, 107, 167,
+    },
+    {
+        153, 160, 107, 139, 126, 154, 197, 185, 201, 154, 154, 154,
+        134, 154, 139, 154, 154, 183, 152, 139, 154, 137,  95,  79,
+         63,  31,  31, 153, 153, 153, 153, 169, 198, 169, 198, 168,
+         79, 224, 167, 122, 153, 111, 149,  92, 167, 154, 139, 139,
+        139, 139, 139, 139, 125, 110, 124, 110,  95,  94, 125, 111,
+        111,  79, 125, 126, 111, 111,  79, 108, 123,  93, 125, 110,
+        124, 110,  95,  94, 125, 111, 111,  79, 125, 126, 111, 111,
+         79, 108, 123,  93, 121, 140,  61, 154, 170, 154, 139, 153,
+        139, 123, 123,  63, 124, 166, 183, 140, 136, 153, 154, 166,
+        183, 140, 136, 153, 154, 166, 183, 140, 136, 153, 154, 170,
+        153, 138, 138, 122, 121, 122, 121, 167, 151, 183, 140, 151,
+        183, 140, 140, 140, 154, 196, 167, 167, 154, 152, 167, 182,
+        182, 134, 149, 136, 153, 121, 136, 122, 169, 208, 166, 167,
+        154, 152, 167, 182, 107, 167,  91, 107, 107, 167,
+    },
+};
+
+typedef struct PutBits {
+    uint8_t *buf;
+    int size, alloc;
+    int bits, nbits;
+} PutBits;
+
+typedef struct CabacEnc {
+    PutBits pb;
+    uint32_t low, range;
+    int outstanding, first;
+} CabacEnc;
+
+typedef struct PPS {
+    int tiles, cols, rows, lf_across_tiles;
+    int col_bd[MAX_TILES + 1], row_bd[MAX_TILES + 1];
+    int wpp;
+    int init_qp, cb_qp_offset, cr_qp_offset, qp_delta_depth;
+    int beta_offset, tc_offset, lf_across_slices, header_ext;
+    int *tile_id;  /* by raster scan address */
+    int *col_start;
+    int *rs_to_ts, *ts_to_rs;
+} PPS;
+
+typedef struct Segment {
+    int start, end, dependent;
+} Segment;
+
+typedef struct Gen {
+    FILE *out;
+    uint32_t seed;
+
+    int width, height, log2_ctb, ctb_w, ctb_h, nb_ctbs, log2_max_tb;
+    int slices;
+    PPS pps[MAX_PPS];
+    int nb_pps;
+
+    /* current picture */
+    PPS *p;
+    int poc, idr, temporal_mvp;
+    int *ctb_slice;
+    uint8_t *ct_depth, *skip;  /* per 8x8 */
+    uint8_t *intra_mode;       /* per 4x4 */
+    int min_cb_w, min_pu_w;
+
+    /* current slice */
+    int slice_addr, slice_type, slice_qp, cabac_init_flag, max_merge;
+    int sao_luma, sao_chroma, deblock_override, deblock_disable;
+    int beta_offset, tc_offset, lf_across_slices;
+    int is_cu_qp_delta_coded;
+
+    CabacEnc *c;
+    uint8_t ctx[NB_CONTEXTS], wpp_ctx[NB_CONTEXTS];
+} Gen;
+
+static uint8_t scan4x4[3][16][2];
+static uint8_t scan_sb[4][3][64][2]; /* subblock scans by log2 size - 2 */
+
+static unsigned rnd(Gen *g, unsigned n)
+{
+    g->seed = g->seed * 1664525 + 1013904223;
+    return (g->seed >> 8) % n;
+}
+
+static void *alloc(size_t size)
+{
+    void *ptr = calloc(1, size);
+    if (!ptr) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    return ptr;
+}
+
+static void put_byte(PutBits *pb, int v)
+{
+    if (pb->size == pb->alloc) {
+        pb->alloc = pb->alloc ? 2 * pb->alloc : 1024;
+        pb->buf   = realloc(pb->buf, pb->alloc);
+        if (!pb->buf) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    pb->buf[pb->size++] = v;
+}
+
+static void put_bits(PutBits *pb, int n, uint32_t v)
+{
+    while (n--) {
+        pb->bits = pb->bits << 1 | (v >> n & 1);
+        if (++pb->nbits == 8) {
+            put_byte(pb, pb->bits);
+            pb->bits = pb->nbits = 0;
+        }
+    }
+}
+
+static void put_ue(PutBits *pb, uint32_t v)
+{
+    int len = 0;
+
+    while ((v + 1) >> (len + 1))
+        len++;
+    put_bits(pb, len, 0);
+    put_bits(pb, len + 1, v + 1);
+}
+
+static void put_se(PutBits *pb, int v)
+{
+    put_ue(pb, v > 0 ? 2 * v - 1 : -2 * v);
+}
+
+/* rbsp_trailing_bits() and byte_alignment() */
+static void put_trailing_bits(PutBits *pb)
+{
+    put_bits(pb, 1, 1);
+    while (pb->nbits)
+        put_bits(pb, 1, 0);
+}
+
+/* Size of the data after emulation prevention */
+static int escaped_size(const uint8_t *buf, int size)
+{
+    int i, zeros = 0, n = size;
+
+    for (i = 0; i < size; i++) {
+        if (zeros >= 2 && buf[i] <= 3) {
+            n++;
+            zeros = 0;
+        }
+        zeros = buf[i] ? 0 : zeros + 1;
+    }
+    return n;
+}
+
+static void write_nal(Gen *g, int type, const PutBits *pb)
+{
+    static const uint8_t start_code[4] = { 0, 0, 0, 1 };
+    int i, zeros = 0;
+
+    fwrite(start_code, 1, 4, g->out);
+    fputc(type << 1, g->out);
+    fputc(1, g->out);
+    for (i = 0; i < pb->size; i++) {
+        if (zeros >= 2 && pb->buf[i] <= 3) {
+            fputc(3, g->out);
+            zeros = 0;
+        }
+        fputc(pb->buf[i], g->out);
+        zeros = pb->buf[i] ? 0 : zeros + 1;
+    }
+}
+
+/* CABAC encoder, 9.3.4.3 of the specification */
+
+static void cabac_start(CabacEnc *c)
+{
+    memset(c, 0, sizeof(*c));
+    c->range = 510;
+    c->first = 1;
+}
+
+static void cabac_put_bit(CabacEnc *c, int b)
+{
+    if (c->first)
+        c->first = 0;
+    else
+        put_bits(&c->pb, 1, b);
+    for (; c->outstanding; c->outstanding--)
+        put_bits(&c->pb, 1, !b);
+}
+
+static void cabac_renorm(CabacEnc *c)
+{
+    while (c->range < 256) {
+        if (c->low < 256) {
+            cabac_put_bit(c, 0);
+        } else if (c->low >= 512) {
+            c->low -= 512;
+            cabac_put_bit(c, 1);
+        } else {
+            c->low -= 256;
+            c->outstanding++;
+        }
+        c->range <<= 1;
+        c->low   <<= 1;
+    }
+}
+
+/* A context state is pStateIdx << 1 | valMps */
+static void encode_bin(Gen *g, int ctx, int bin)
+{
+    CabacEnc *c = g->c;
+    int state = g->ctx[ctx] >> 1, mps = g->ctx[ctx] & 1;
+    int lps = lps_range[state][(c->range >> 6) & 3];
+
+    c->range -= lps;
+    if (bin != mps) {
+        c->low  += c->range;
+        c->range = lps;
+        if (!state)
+            mps ^= 1;
+        state = trans_lps[state];
+    } else if (state < 62) {
+        state++;
+    }
+    g->ctx[ctx] = state << 1 | mps;
+    cabac_renorm(c);
+}
+
+static void encode_bypass(Gen *g, int bin)
+{
+    CabacEnc *c = g->c;
+
+    c->low <<= 1;
+    if (bin)
+        c->low += c->range;
+    if (c->low >= 1024) {
+        cabac_put_bit(c, 1);
+        c->low -= 1024;
+    } else if (c->low < 512) {
+        cabac_put_bit(c, 0);
+    } else {
+        c->low -= 512;
+        c->outstanding++;
+    }
+}
+
+static void encode_bypass_bits(Gen *g, int n, unsigned v)
+{
+    while (n--)
+        encode_bypass(g, v >> n & 1);
+}
+
+/* The last bit written by the flush is the rbsp_stop_one_bit or the
+ * alignment_bit_equal_to_one of the byte_alignment() that follows. */
+static void encode_terminate(Gen *g, int bin)
+{
+    CabacEnc *c = g->c;
+
+    c->range -= 2;
+    if (bin) {
+        c->low  += c->range;
+        c->range = 2;
+        cabac_renorm(c);
+        cabac_put_bit(c, c->low >> 9 & 1);
+        put_bits(&c->pb, 2, (c->low >> 7 & 3) | 1);
+        while (c->pb.nbits)
+            put_bits(&c->pb, 1, 0);
+    } else {
+        cabac_renorm(c);
+    }
+}
+
+static void encode_eg(Gen *g, unsigned v, int k)
+{
+    while (v >= 1U << k) {
+        encode_bypass(g, 1);
+        v -= 1U << k;
+        k++;
+    }
+    encode_bypass(g, 0);
+    encode_bypass_bits(g, k, v);
+}
+
+static void init_contexts(Gen *g)
+{
+    int type = g->slice_type == SLICE_I ? 0 :
+               g->slice_type == SLICE_P ? 1 + g->cabac_init_flag : 2 - g->cabac_init_flag;
+    int qp   = g->slice_qp < 0 ? 0 : g->slice_qp > 51 ? 51 : g->slice_qp;
+    int i;
+
+    for (i = 0; i < NB_CONTEXTS; i++) {
+        int m   = (init_values[type][i] >> 4) * 5 - 45;
+        int n   = ((init_values[type][i] & 15) << 3) - 16;
+        int pre = ((m * qp) >> 4) + n;
+
+        pre = pre < 1 ? 1 : pre > 126 ? 126 : pre;
+        g->ctx[i] = pre <= 63 ? (63 - pre) << 1 : (pre - 64) << 1 | 1;
+    }
+}
+
+/* Parameter sets */
+
+static void profile_tier_level(PutBits *pb)
+{
+    put_bits(pb, 2, 0);              // general_profile_space
+    put_bits(pb, 1, 0);              // general_tier_flag
+    put_bits(pb, 5, 1);              // general_profile_idc, Main
+    put_bits(pb, 32, 0x60000000);    // general_profile_compatibility_flag, Main and Main 10
+    put_bits(pb, 4, 0x9);            // progressive, not interlaced, not non-packed, frame only
+    put_bits(pb, 32, 0);             // general_reserved_zero_43bits and general_inbld_flag
+    put_bits(pb, 12, 0);
+    put_bits(pb, 8, 153);            // general_level_idc, 5.1
+}
+
+static void write_vps(Gen *g)
+{
+    PutBits pb = { 0 };
+
+    put_bits(&pb, 4, 0);             // vps_video_parameter_set_id
+    put_bits(&pb, 2, 3);             // vps_base_layer_internal_flag, vps_base_layer_available_flag
+    put_bits(&pb, 6, 0);             // vps_max_layers_minus1
+    put_bits(&pb, 3, 0);             // vps_max_sub_layers_minus1
+    put_bits(&pb, 1, 1);             // vps_temporal_id_nesting_flag
+    put_bits(&pb, 16, 0xffff);
+    profile_tier_level(&pb);
+    put_bits(&pb, 1, 1);             // vps_sub_layer_ordering_info_present_flag
+    put_ue(&pb, 1);                  // vps_max_dec_pic_buffering_minus1
+    put_ue(&pb, 0);                  // vps_max_num_reorder_pics
+    put_ue(&pb, 0);                  // vps_max_latency_increase_plus1
+    put_bits(&pb, 6, 0);             // vps_max_layer_id
+    put_ue(&pb, 0);                  // vps_num_layer_sets_minus1
+    put_bits(&pb, 1, 0);             // vps_timing_info_present_flag
+    put_bits(&pb, 1, 0);             // vps_extension_flag
+    put_trailing_bits(&pb);
+    write_nal(g, 32, &pb);
+    free(pb.buf);
+}
+
+static void write_sps(Gen *g)
+{
+    PutBits pb = { 0 };
+
+    put_bits(&pb, 4, 0);             // sps_video_parameter_set_id
+    put_bits(&pb, 3, 0);             // sps_max_sub_layers_minus1
+    put_bits(&pb, 1, 1);             // sps_temporal_id_nesting_flag
+    profile_tier_level(&pb);
+    put_ue(&pb, 0);                  // sps_seq_parameter_set_id
+    put_ue(&pb, 1);                  // chroma_format_idc
+    put_ue(&pb, g->width);
+    put_ue(&pb, g->height);
+    put_bits(&pb, 1, 0);             // conformance_window_flag
+    put_ue(&pb, 0);                  // bit_depth_luma_minus8
+    put_ue(&pb, 0);                  // bit_depth_chroma_minus8
+    put_ue(&pb, 4);                  // log2_max_pic_order_cnt_lsb_minus4
+    put_bits(&pb, 1, 1);             // sps_sub_layer_ordering_info_present_flag
+    put_ue(&pb, 1);                  // sps_max_dec_pic_buffering_minus1
+    put_ue(&pb, 0);                  // sps_max_num_reorder_pics
+    put_ue(&pb, 0);                  // sps_max_latency_increase_plus1
+    put_ue(&pb, 0);                  // log2_min_luma_coding_block_size_minus3
+    put_ue(&pb, g->log2_ctb - 3);    // log2_diff_max_min_luma_coding_block_size
+    put_ue(&pb, 0);                  // log2_min_luma_transform_block_size_minus2
+    put_ue(&pb, g->log2_max_tb - 2); // log2_diff_max_min_luma_transform_block_size
+    put_ue(&pb, 1);                  // max_transform_hierarchy_depth_inter
+    put_ue(&pb, 1);                  // max_transform_hierarchy_depth_intra
+    put_bits(&pb, 1, 0);             // scaling_list_enabled_flag
+    put_bits(&pb, 1, 0);             // amp_enabled_flag
+    put_bits(&pb, 1, 1);             // sample_adaptive_offset_enabled_flag
+    put_bits(&pb, 1, 0);             // pcm_enabled_flag
+    put_ue(&pb, 1);                  // num_short_term_ref_pic_sets
+    put_ue(&pb, 1);                  // num_negative_pics
+    put_ue(&pb, 0);                  // num_positive_pics
+    put_ue(&pb, 0);                  // delta_poc_s0_minus1
+    put_bits(&pb, 1, 1);             // used_by_curr_pic_s0_flag
+    put_bits(&pb, 1, 0);             // long_term_ref_pics_present_flag
+    put_bits(&pb, 1, 1);             // sps_temporal_mvp_enabled_flag
+    put_bits(&pb, 1, 1);             // strong_intra_smoothing_enabled_flag
+    put_bits(&pb, 1, 0);             // vui_parameters_present_flag
+    put_bits(&pb, 1, 0);             // sps_extension_present_flag
+    put_trailing_bits(&pb);
+    write_nal(g, 33, &pb);
+    free(pb.buf);
+}
+
+static void write_pps(Gen *g, int id)
+{
+    PPS *p = &g->pps[id];
+    PutBits pb = { 0 };
+    int i;
+
+    put_ue(&pb, id);                 // pps_pic_parameter_set_id
+    put_ue(&pb, 0);                  // pps_seq_parameter_set_id
+    put_bits(&pb, 1, 1);             // dependent_slice_segments_enabled_flag
+    put_bits(&pb, 1, 0);             // output_flag_present_flag
+    put_bits(&pb, 3, 0);             // num_extra_slice_header_bits
+    put_bits(&pb, 1, 0);             // sign_data_hiding_enabled_flag
+    put_bits(&pb, 1, 1);             // cabac_init_present_flag
+    put_ue(&pb, 0);                  // num_ref_idx_l0_default_active_minus1
+    put_ue(&pb, 0);                  // num_ref_idx_l1_default_active_minus1
+    put_se(&pb, p->init_qp - 26);
+    put_bits(&pb, 1, 0);             // constrained_intra_pred_flag
+    put_bits(&pb, 1, 0);             // transform_skip_enabled_flag
+    put_bits(&pb, 1, 1);             // cu_qp_delta_enabled_flag
+    put_ue(&pb, p->qp_delta_depth);
+    put_se(&pb, p->cb_qp_offset);
+    put_se(&pb, p->cr_qp_offset);
+    put_bits(&pb, 1, 0);             // pps_slice_chroma_qp_offsets_present_flag
+    put_bits(&pb, 1, 0);             // weighted_pred_flag
+    put_bits(&pb, 1, 0);             // weighted_bipred_flag
+    put_bits(&pb, 1, 0);             // transquant_bypass_enabled_flag
+    put_bits(&pb, 1, p->tiles);
+    put_bits(&pb, 1, p->wpp);
+    if (p->tiles) {
+        put_ue(&pb, p->cols - 1);
+        put_ue(&pb, p->rows - 1);
+        put_bits(&pb, 1, 0);         // uniform_spacing_flag, the sizes are sent either way
+        for (i = 0; i < p->cols - 1; i++)
+            put_ue(&pb, p->col_bd[i + 1] - p->col_bd[i] - 1);
+        for (i = 0; i < p->rows - 1; i++)
+            put_ue(&pb, p->row_bd[i + 1] - p->row_bd[i] - 1);
+        put_bits(&pb, 1, p->lf_across_tiles);
+    }
+    put_bits(&pb, 1, p->lf_across_slices);
+    put_bits(&pb, 1, 1);             // deblocking_filter_control_present_flag
+    put_bits(&pb, 1, 1);             // deblocking_filter_override_enabled_flag
+    put_bits(&pb, 1, 0);             // pps_deblocking_filter_disabled_flag
+    put_se(&pb, p->beta_offset);
+    put_se(&pb, p->tc_offset);
+    put_bits(&pb, 1, 0);             // pps_scaling_list_data_present_flag
+    put_bits(&pb, 1, 0);             // lists_modification_present_flag
+    put_ue(&pb, 0);                  // log2_parallel_merge_level_minus2
+    put_bits(&pb, 1, p->header_ext);
+    put_bits(&pb, 1, 0);             // pps_extension_present_flag
+    put_trailing_bits(&pb);
+    write_nal(g, 34, &pb);
+    free(pb.buf);
+}
+
+/* Tile boundaries at the given count, uniform or at random positions */
+static void split_tiles(Gen *g, int *bd, int n, int size, int uniform)
+{
+    int i, j;
+
+    for (i = 0; i <= n; i++)
+        bd[i] = i * size / n;
+    if (uniform)
+        return;
+    for (i = 1; i < n; i++) {
+        do {
+            bd[i] = 1 + rnd(g, size - 1);
+            for (j = 1; j < i && bd[j] != bd[i]; j++)
+                ;
+        } while (j < i);
+    }
+    for (i = 1; i < n; i++)
+        for (j = i + 1; j < n; j++)
+            if (bd[j] < bd[i]) {
+                int tmp = bd[i];
+                bd[i] = bd[j];
+                bd[j] = tmp;
+            }
+}
+
+static void init_pps(Gen *g, PPS *p, int cols, int rows, int uniform, int wpp)
+{
+    int i, x, y, tx, ty, ts = 0;
+
+    p->cols  = cols;
+    p->rows  = rows;
+    p->tiles = cols > 1 || rows > 1;
+    p->wpp   = wpp;
+    split_tiles(g, p->col_bd, cols, g->ctb_w, uniform);
+    split_tiles(g, p->row_bd, rows, g->ctb_h, uniform);
+    p->lf_across_tiles  = rnd(g, 2);
+    p->lf_across_slices = rnd(g, 2);
+    p->init_qp          = 22 + rnd(g, 9);
+    p->cb_qp_offset     = (int)rnd(g, 7) - 3;
+    p->cr_qp_offset     = (int)rnd(g, 7) - 3;
+    p->qp_delta_depth   = rnd(g, g->log2_ctb - 2);
+    p->beta_offset      = (int)rnd(g, 5) - 2;
+    p->tc_offset        = (int)rnd(g, 5) - 2;
+    p->header_ext       = rnd(g, 2);
+
+    p->tile_id   = alloc(g->nb_ctbs * sizeof(*p->tile_id));
+    p->col_start = alloc(g->ctb_w * sizeof(*p->col_start));
+    p->rs_to_ts  = alloc(g->nb_ctbs * sizeof(*p->rs_to_ts));
+    p->ts_to_rs  = alloc(g->nb_ctbs * sizeof(*p->ts_to_rs));
+    for (tx = 0; tx < cols; tx++)
+        for (x = p->col_bd[tx]; x < p->col_bd[tx + 1]; x++)
+            p->col_start[x] = p->col_bd[tx];
+    for (ty = 0; ty < rows; ty++)
+        for (tx = 0; tx < cols; tx++)
+            for (y = p->row_bd[ty]; y < p->row_bd[ty + 1]; y++)
+                for (x = p->col_bd[tx]; x < p->col_bd[tx + 1]; x++) {
+                    int rs = y * g->ctb_w + x;
+                    p->tile_id[rs]  = ty * cols + tx;
+                    p->rs_to_ts[rs] = ts;
+                    p->ts_to_rs[ts++] = rs;
+                }
+    for (i = 0; i < g->nb_ctbs; i++)
+        if (p->ts_to_rs[p->rs_to_ts[i]] != i)
+            abort();
+}
+
+static int tile_start(Gen *g, int ts)
+{
+    return !ts || g->p->tile_id[g->p->ts_to_rs[ts]] != g->p->tile_id[g->p->ts_to_rs[ts - 1]];
+}
+
+/* First CTB of a CTB row in its tile */
+static int row_start(Gen *g, int ts)
+{
+    int rs = g->p->ts_to_rs[ts];
+    return rs % g->ctb_w == g->p->col_start[rs % g->ctb_w];
+}
+
+/* 6.3.1 and 7.4.7.1: a slice or slice segment [start, end) is in one tile
+ * or made of complete tiles, and with WPP, it ends in its first CTB row
+ * unless it starts a CTB row. */
+static int can_end(Gen *g, int start, int end)
+{
+    int s = g->p->ts_to_rs[start], e = g->p->ts_to_rs[end - 1];
+
+    if (g->p->tile_id[s] != g->p->tile_id[e] &&
+        !(tile_start(g, start) && (end == g->nb_ctbs || tile_start(g, end))))
+        return 0;
+    if (g->p->wpp && !row_start(g, start) &&
+        (s / g->ctb_w != e / g->ctb_w || g->p->tile_id[s] != g->p->tile_id[e]))
+        return 0;
+    return 1;
+}
+
+static int must_end(Gen *g, int start, int end)
+{
+    return (tile_start(g, end) && !tile_start(g, start)) ||
+           (g->p->wpp && row_start(g, end) && !row_start(g, start));
+}
+
+static int plan_segments(Gen *g, Segment *seg)
+{
+    int nb_seg = 1, slice_start = 0, ts;
+    int rate = g->nb_ctbs / 6 + 2;
+
+    seg[0].start     = 0;
+    seg[0].dependent = 0;
+    for (ts = 1; ts < g->nb_ctbs; ts++) {
+        int cut = 0;  // 1 dependent slice segment, 2 slice
+
+        if (must_end(g, slice_start, ts))
+            cut = 2;
+        else if (must_end(g, seg[nb_seg - 1].start, ts))
+            cut = rnd(g, 2) && can_end(g, slice_start, ts) ? 2 : 1;
+        else if (g->slices && !rnd(g, rate) && can_end(g, seg[nb_seg - 1].start, ts))
+            cut = rnd(g, 2) && can_end(g, slice_start, ts) ? 2 : 1;
+
+        if (cut) {
+            if (!can_end(g, seg[nb_seg - 1].start, ts))
+                abort();
+            seg[nb_seg - 1].end = ts;
+            seg[nb_seg].start     = ts;
+            seg[nb_seg].dependent = cut == 1;
+            if (cut == 2)
+                slice_start = ts;
+            nb_seg++;
+        }
+    }
+    seg[nb_seg - 1].end = g->nb_ctbs;
+    return nb_seg;
+}
+
+/* CTU syntax */
+
+static int ctb_addr(Gen *g, int x, int y)
+{
+    return (y >> g->log2_ctb) * g->ctb_w + (x >> g->log2_ctb);
+}
+
+/* 6.4.1, for the left and upper neighbours of a block */
+static int available(Gen *g, int x, int y, int xn, int yn)
+{
+    int cur, nb;
+
+    if (xn < 0 || yn < 0 || xn >= g->width || yn >= g->height)
+        return 0;
+    cur = ctb_addr(g, x, y);
+    nb  = ctb_addr(g, xn, yn);
+    return nb == cur ||
+           (g->ctb_slice[nb] == g->slice_addr && g->p->tile_id[nb] == g->p->tile_id[cur]);
+}
+
+static void sao_offsets(Gen *g, int type)
+{
+    int i, abs[4];
+
+    for (i = 0; i < 4; i++) {
+        abs[i] = rnd(g, 8);
+        encode_bypass_bits(g, abs[i] + (abs[i] < 7), ((1 << abs[i]) - 1) << (abs[i] < 7));
+    }
+    if (type == 1) {
+        for (i = 0; i < 4; i++)
+            if (abs[i])
+                encode_bypass(g, rnd(g, 2));
+        encode_bypass_bits(g, 5, rnd(g, 32));
+    }
+}
+
+static void sao_type(Gen *g, int type)
+{
+    encode_bin(g, SAO_TYPE, type != 0);
+    if (type)
+        encode_bypass(g, type == 2);
+}
+
+static void sao(Gen *g, int rx, int ry)
+{
+    int rs = ry * g->ctb_w + rx, merge = 0, type, type_chroma;
+
+    if (rx > 0 && rs > g->slice_addr &&
+        g->p->tile_id[rs] == g->p->tile_id[rs - 1]) {
+        merge = !rnd(g, 3);
+        encode_bin(g, SAO_MERGE, merge);
+    }
+    if (ry > 0 && !merge && rs - g->ctb_w >= g->slice_addr &&
+        g->p->tile_id[rs] == g->p->tile_id[rs - g->ctb_w]) {
+        merge = !rnd(g, 3);
+        encode_bin(g, SAO_MERGE, merge);
+    }
+    if (merge)
+        return;
+
+    if (g->sao_luma) {
+        sao_type(g, type = rnd(g, 3));
+        if (type) {
+            sao_offsets(g, type);
+            if (type == 2)
+                encode_bypass_bits(g, 2, rnd(g, 4));
+        }
+    }
+    if (g->sao_chroma) {
+        sao_type(g, type_chroma = rnd(g, 3));
+        if (type_chroma) {
+            sao_offsets(g, type_chroma);
+            if (type_chroma == 2)
+                encode_bypass_bits(g, 2, rnd(g, 4));
+            sao_offsets(g, type_chroma);
+        }
+    }
+}
+
+static int neighbour_mode(Gen *g, int x, int y, int xn, int yn)
+{
+    int mode;
+
+    if (!available(g, x, y, xn, yn))
+        return INTRA_DC;
+    mode = g->intra_mode[(yn >> 2) * g->min_pu_w + (xn >> 2)];
+    return mode == NOT_INTRA ? INTRA_DC : mode;
+}
+
+/* 8.4.2 */
+static void mpm_list(Gen *g, int x, int y, int cand[3])
+{
+    int a = neighbour_mode(g, x, y, x - 1, y);
+    int b = neighbour_mode(g, x, y, x, y - 1);
+
+    if (y - 1 < ((y >> g->log2_ctb) << g->log2_ctb))
+        b = INTRA_DC;
+    if (a == b) {
+        if (a < 2) {
+            cand[0] = 0;
+            cand[1] = 1;
+            cand[2] = 26;
+        } else {
+            cand[0] = a;
+            cand[1] = 2 + ((a + 29) % 32);
+            cand[2] = 2 + ((a - 2 + 1) % 32);
+        }
+    } else {
+        cand[0] = a;
+        cand[1] = b;
+        cand[2] = a && b ? 0 : a != 1 && b != 1 ? 1 : 26;
+    }
+}
+
+static void set_intra_mode(Gen *g, int x0, int y0, int size, int mode)
+{
+    int x, y;
+
+    for (y = y0 >> 2; y < (y0 + size) >> 2 && y < g->height >> 2; y++)
+        for (x = x0 >> 2; x < (x0 + size) >> 2 && x < g->width >> 2; x++)
+            g->intra_mode[y * g->min_pu_w + x] = mode;
+}
+
+static int scan_idx(int mode)
+{
+    return mode >= 6 && mode <= 14 ? 2 : mode >= 22 && mode <= 30 ? 1 : 0;
+}
+
+static void last_position(Gen *g, int ctx, int pos, int log2, int c_idx)
+{
+    int max = (log2 << 1) - 1;
+    int offset = c_idx ? 15 : 3 * (log2 - 2) + ((log2 - 1) >> 2);
+    int shift  = c_idx ? log2 - 2 : (log2 + 1) >> 2;
+    int prefix = pos, i;
+
+    if (pos >= 4) {
+        int k = 31 - __builtin_clz(pos);
+        prefix = 2 * k + (pos >> (k - 1) & 1);
+    }
+    for (i = 0; i < prefix; i++)
+        encode_bin(g, ctx + offset + (i >> shift), 1);
+    if (prefix < max)
+        encode_bin(g, ctx + offset + (prefix >> shift), 0);
+}
+
+static void last_suffix(Gen *g, int pos)
+{
+    if (pos >= 4) {
+        int k = 31 - __builtin_clz(pos);
+        int prefix = 2 * k + (pos >> (k - 1) & 1);
+        int len = (prefix >> 1) - 1;
+
+        encode_bypass_bits(g, len, pos - ((2 + (prefix & 1)) << len));
+    }
+}
+
+static void abs_level_remaining(Gen *g, int v, int k)
+{
+    int m = 0;
+
+    if (v < 3 << k) {
+        encode_bypass_bits(g, (v >> k) + 1, ((1 << (v >> k)) - 1) << 1);
+        encode_bypass_bits(g, k, v & ((1 << k) - 1));
+        return;
+    }
+    while (v >= ((1 << (m + 1)) + 2) << k)
+        m++;
+    encode_bypass_bits(g, 3 + m + 1, ((1 << (3 + m)) - 1) << 1);
+    encode_bypass_bits(g, m + k, v - (((1 << m) + 2) << k));
+}
+
+static int random_level(Gen *g)
+{
+    int r = rnd(g, 64), v;
+
+    v = r < 32 ? 1 : r < 48 ? 2 : r < 62 ? 3 + rnd(g, 6) : 9 + rnd(g, 40);
+    return rnd(g, 2) ? -v : v;
+}
+
+/* 7.3.8.11, with sign data hiding and transform skip off */
+static void residual_coding(Gen *g, int log2, int c_idx, int scan)
+{
+    int size = 1 << log2, nb_sb = size >> 2;
+    int level[32 * 32] = { 0 };  // in scan order
+    uint8_t csbf[8][8] = { { 0 } };
+    const uint8_t (*sb)[2] = scan_sb[log2 - 2][scan];
+    int last, last_x, last_y, last_sb, i, n;
+    int greater1_ctx = 1;
+
+    last = rnd(g, 1 + rnd(g, size * size));
+    for (n = 0; n < last; n++)
+        if (!rnd(g, 3))
+            level[n] = random_level(g);
+    level[last] = random_level(g);
+
+    last_sb = last >> 4;
+    last_x  = sb[last_sb][0] * 4 + scan4x4[scan][last & 15][0];
+    last_y  = sb[last_sb][1] * 4 + scan4x4[scan][last & 15][1];
+    if (scan == 2) {
+        int tmp = last_x;
+        last_x = last_y;
+        last_y = tmp;
+    }
+    last_position(g, LAST_X_PREFIX, last_x, log2, c_idx);
+    last_position(g, LAST_Y_PREFIX, last_y, log2, c_idx);
+    last_suffix(g, last_x);
+    last_suffix(g, last_y);
+
+    for (i = last_sb; i >= 0; i--) {
+        int xs = sb[i][0], ys = sb[i][1];
+        int right = xs + 1 < nb_sb ? csbf[xs + 1][ys] : 0;
+        int below = ys + 1 < nb_sb ? csbf[xs][ys + 1] : 0;
+        int infer_dc = 0, nb_sig = 0, first_g1 = -1, rice = 0;
+        int sig[16];
+
+        if (i < last_sb && i > 0) {
+            for (n = 0; n < 16 && !level[i * 16 + n]; n++)
+                ;
+            csbf[xs][ys] = n < 16;
+            encode_bin(g, CSBF + (right || below) + (c_idx ? 2 : 0), csbf[xs][ys]);
+            infer_dc = 1;
+        } else {
+            csbf[xs][ys] = 1;
+        }
+        if (!csbf[xs][ys])
+            continue;
+
+        if (i == last_sb)
+            sig[nb_sig++] = last & 15;
+        for (n = i == last_sb ? (last & 15) - 1 : 15; n >= 0; n--) {
+            int x = xs * 4 + scan4x4[scan][n][0];
+            int y = ys * 4 + scan4x4[scan][n][1];
+            int xp = x & 3, yp = y & 3, prev = right + 2 * below, inc;
+
+            if (!n && infer_dc) {
+                sig[nb_sig++] = 0;
+                break;
+            }
+            if (log2 == 2) {
+                static const uint8_t ctx_idx_map[16] = { 0, 1, 4, 5, 2, 3, 4, 5, 6, 6, 8, 8, 7, 7, 8, 8 };
+                inc = ctx_idx_map[(y << 2) + x];
+            } else if (!x && !y) {
+                inc = 0;
+            } else {
+                inc = prev == 0 ? (xp + yp == 0 ? 2 : xp + yp < 3 ? 1 : 0) :
+                      prev == 1 ? (yp == 0 ? 2 : yp == 1 ? 1 : 0) :
+                      prev == 2 ? (xp == 0 ? 2 : xp == 1 ? 1 : 0) : 2;
+                if (!c_idx) {
+                    if (xs || ys)
+                        inc += 3;
+                    inc += log2 == 3 ? (scan ? 15 : 9) : 21;
+                } else {
+                    inc += log2 == 3 ? 9 : 12;
+                }
+            }
+            encode_bin(g, SIG_COEFF + (c_idx ? 27 : 0) + inc, level[i * 16 + n] != 0);
+            if (level[i * 16 + n]) {
+                sig[nb_sig++] = n;
+                infer_dc = 0;
+            }
+        }
+
+        {
+            int ctx_set = i > 0 && !c_idx ? 2 : 0;
+
+            if (i != last_sb && !greater1_ctx)
+                ctx_set++;
+            greater1_ctx = 1;
+            for (n = 0; n < nb_sig && n < 8; n++) {
+                int g1 = abs(level[i * 16 + sig[n]]) > 1;
+
+                encode_bin(g, GREATER1 + (c_idx ? 16 : 0) + (ctx_set << 2) + greater1_ctx, g1);
+                if (g1) {
+                    greater1_ctx = 0;
+                    if (first_g1 < 0)
+                        first_g1 = n;
+                } else if (greater1_ctx > 0 && greater1_ctx < 3) {
+                    greater1_ctx++;
+                }
+            }
+            if (first_g1 >= 0)
+                encode_bin(g, GREATER2 + (c_idx ? 4 : 0) + ctx_set,
+                           abs(level[i * 16 + sig[first_g1]]) > 2);
+        }
+        for (n = 0; n < nb_sig; n++)
+            encode_bypass(g, level[i * 16 + sig[n]] < 0);
+        for (n = 0; n < nb_sig; n++) {
+            int v = abs(level[i * 16 + sig[n]]);
+            int base = n < 8 ? 1 + (v > 1) + (n == first_g1 && v > 2) : 1;
+            int threshold = n < 8 ? (n == first_g1 ? 3 : 2) : 1;
+
+            if (base == threshold) {
+                abs_level_remaining(g, v - base, rice);
+                if (v > 3 << rice && rice < 4)
+                    rice++;
+            }
+        }
+    }
+}
+
+static void cu_qp_delta(Gen *g)
+{
+    int v = rnd(g, 8) ? (int)rnd(g, 7) - 3 : (int)rnd(g, 21) - 10;
+    int a = abs(v), i;
+
+    for (i = 0; i < 5 && i < a; i++)
+        encode_bin(g, CU_QP_DELTA + !!i, 1);
+    if (a < 5)
+        encode_bin(g, CU_QP_DELTA + !!a, 0);
+    else
+        encode_eg(g, a - 5, 0);
+    if (a)
+        encode_bypass(g, v < 0);
+    g->is_cu_qp_delta_coded = 1;
+}
+
+typedef struct CU {
+    int x, y, intra, part, chroma_mode;
+} CU;
+
+/* 7.3.8.10, for 4:2:0, cbf_cb and cbf_cr are those of the parent for 4x4 luma */
+static void transform_unit(Gen *g, CU *cu, int x0, int y0, int log2, int blk,
+                           int cbf_luma, int cbf_cb, int cbf_cr)
+{
+    int scan = 0, scan_c = 0;
+
+    if (!cbf_luma && !cbf_cb && !cbf_cr)
+        return;
+    if (!g->is_cu_qp_delta_coded)
+        cu_qp_delta(g);
+    if (cu->intra && log2 <= 3) {
+        scan   = scan_idx(g->intra_mode[(y0 >> 2) * g->min_pu_w + (x0 >> 2)]);
+        scan_c = scan_idx(cu->chroma_mode);
+    }
+    if (cbf_luma)
+        residual_coding(g, log2, 0, scan);
+    if (log2 > 2 || blk == 3) {
+        int log2_c = log2 > 2 ? log2 - 1 : 2;
+
+        if (log2_c > 2)
+            scan_c = 0;
+        if (cbf_cb)
+            residual_coding(g, log2_c, 1, scan_c);
+        if (cbf_cr)
+            residual_coding(g, log2_c, 2, scan_c);
+    }
+}
+
+static void transform_tree(Gen *g, CU *cu, int x0, int y0, int log2, int depth, int blk,
+                           int parent_cb, int parent_cr)
+{
+    int intra_split = cu->intra && cu->part == PART_NxN;
+    int max_depth = 1 + intra_split;
+    int split, cbf_cb = 0, cbf_cr = 0, cbf_luma = 1;
+
+    if (log2 <= g->log2_max_tb && log2 > 2 && depth < max_depth && !(intra_split && !depth)) {
+        split = rnd(g, 2);
+        encode_bin(g, SPLIT_TRANSFORM + 5 - log2, split);
+    } else {
+        split = log2 > g->log2_max_tb || (intra_split && !depth);
+    }
+
+    if (log2 > 2) {
+        if (!depth || parent_cb) {
+            cbf_cb = rnd(g, 2);
+            encode_bin(g, CBF_CHROMA + depth, cbf_cb);
+        }
+        if (!depth || parent_cr) {
+            cbf_cr = rnd(g, 2);
+            encode_bin(g, CBF_CHROMA + depth, cbf_cr);
+        }
+    }
+
+    if (split) {
+        int half = 1 << (log2 - 1);
+
+        transform_tree(g, cu, x0,        y0,        log2 - 1, depth + 1, 0, cbf_cb, cbf_cr);
+        transform_tree(g, cu, x0 + half, y0,        log2 - 1, depth + 1, 1, cbf_cb, cbf_cr);
+        transform_tree(g, cu, x0,        y0 + half, log2 - 1, depth + 1, 2, cbf_cb, cbf_cr);
+        transform_tree(g, cu, x0 + half, y0 + half, log2 - 1, depth + 1, 3, cbf_cb, cbf_cr);
+        return;
+    }
+    if (cu->intra || depth || cbf_cb || cbf_cr) {
+        cbf_luma = rnd(g, 3) != 0;
+        encode_bin(g, CBF_LUMA + !depth, cbf_luma);
+    }
+    if (log2 == 2)
+        transform_unit(g, cu, x0, y0, log2, blk, cbf_luma, parent_cb, parent_cr);
+    else
+        transform_unit(g, cu, x0, y0, log2, blk, cbf_luma, cbf_cb, cbf_cr);
+}
+
+static void merge_idx(Gen *g)
+{
+    int idx, i;
+
+    if (g->max_merge < 2)
+        return;
+    idx = rnd(g, g->max_merge);
+    for (i = 0; i < g->max_merge - 1; i++) {
+        if (!i)
+            encode_bin(g, MERGE_IDX, i < idx);
+        else
+            encode_bypass(g, i < idx);
+        if (i >= idx)
+            break;
+    }
+}
+
+static void mvd_coding(Gen *g)
+{
+    int mvd[2], i;
+
+    for (i = 0; i < 2; i++)
+        mvd[i] = rnd(g, 4) ? (int)rnd(g, 129) - 64 : (int)rnd(g, 3) - 1;
+    for (i = 0; i < 2; i++)
+        encode_bin(g, MVD_GREATER0, mvd[i] != 0);
+    for (i = 0; i < 2; i++)
+        if (mvd[i])
+            encode_bin(g, MVD_GREATER1, abs(mvd[i]) > 1);
+    for (i = 0; i < 2; i++) {
+        if (!mvd[i])
+            continue;
+        if (abs(mvd[i]) > 1)
+            encode_eg(g, abs(mvd[i]) - 2, 1);
+        encode_bypass(g, mvd[i] < 0);
+    }
+}
+
+static int prediction_unit(Gen *g)
+{
+    int merge = rnd(g, 2);
+
+    encode_bin(g, MERGE_FLAG, merge);
+    if (merge) {
+        merge_idx(g);
+    } else {
+        mvd_coding(g);
+        encode_bin(g, MVP_FLAG, rnd(g, 2));
+    }
+    return merge;
+}
+
+static void intra_modes(Gen *g, CU *cu, int log2)
+{
+    static const int chroma_modes[4] = { 0, 26, 10, 1 };
+    int nb = cu->part == PART_NxN ? 4 : 1;
+    int size = nb == 4 ? 1 << (log2 - 1) : 1 << log2;
+    int mode[4], cand[4][3], i, j, c;
+
+    for (i = 0; i < nb; i++) {
+        int x = cu->x + (i & 1) * size, y = cu->y + (i >> 1) * size;
+
+        mpm_list(g, x, y, cand[i]);
+        mode[i] = rnd(g, 3) ? cand[i][rnd(g, 3)] : rnd(g, 35);
+        set_intra_mode(g, x, y, size, mode[i]);
+    }
+    for (i = 0; i < nb; i++)
+        encode_bin(g, PREV_INTRA, mode[i] == cand[i][0] || mode[i] == cand[i][1] ||
+                                  mode[i] == cand[i][2]);
+    for (i = 0; i < nb; i++) {
+        for (j = 0; j < 3 && mode[i] != cand[i][j]; j++)
+            ;
+        if (j < 3) {
+            encode_bypass(g, j > 0);
+            if (j > 0)
+                encode_bypass(g, j > 1);
+        } else {
+            int rem = mode[i];
+            for (j = 0; j < 3; j++)
+                rem -= cand[i][j] < mode[i];
+            encode_bypass_bits(g, 5, rem);
+        }
+    }
+
+    c = rnd(g, 5);
+    encode_bin(g, CHROMA_MODE, c != 4);
+    if (c != 4)
+        encode_bypass_bits(g, 2, c);
+    cu->chroma_mode = c == 4 ? mode[0] : chroma_modes[c] == mode[0] ? 34 : chroma_modes[c];
+}
+
+static void coding_unit(Gen *g, int x0, int y0, int log2, int depth)
+{
+    int size = 1 << log2, skip = 0, x, y;
+    CU cu = { x0, y0, 0, PART_2Nx2N, 0 };
+
+    if (g->slice_type != SLICE_I) {
+        int inc = (available(g, x0, y0, x0 - 1, y0) &&
+                   g->skip[(y0 >> 3) * g->min_cb_w + ((x0 - 1) >> 3)]) +
+                  (available(g, x0, y0, x0, y0 - 1) &&
+                   g->skip[((y0 - 1) >> 3) * g->min_cb_w + (x0 >> 3)]);
+        skip = !rnd(g, 4);
+        encode_bin(g, SKIP + inc, skip);
+    }
+
+    if (skip) {
+        merge_idx(g);
+        set_intra_mode(g, x0, y0, size, NOT_INTRA);
+    } else {
+        int merge = 0, rqt_root_cbf = 1;
+
+        cu.intra = g->slice_type == SLICE_I || !rnd(g, 4);
+        if (g->slice_type != SLICE_I)
+            encode_bin(g, PRED_MODE, cu.intra);
+        if (cu.intra) {
+            if (log2 == 3) {
+                cu.part = rnd(g, 3) ? PART_2Nx2N : PART_NxN;
+                encode_bin(g, PART_MODE, cu.part == PART_2Nx2N);
+            }
+            intra_modes(g, &cu, log2);
+        } else {
+            cu.part = rnd(g, 3);
+            encode_bin(g, PART_MODE, cu.part == PART_2Nx2N);
+            if (cu.part != PART_2Nx2N)
+                encode_bin(g, PART_MODE + 1, cu.part == PART_2NxN);
+            set_intra_mode(g, x0, y0, size, NOT_INTRA);
+            merge = prediction_unit(g);
+            if (cu.part != PART_2Nx2N)
+                prediction_unit(g);
+            if (!(cu.part == PART_2Nx2N && merge)) {
+                rqt_root_cbf = rnd(g, 4) != 0;
+                encode_bin(g, RQT_ROOT_CBF, rqt_root_cbf);
+            }
+        }
+        if (rqt_root_cbf)
+            transform_tree(g, &cu, x0, y0, log2, 0, 0, 0, 0);
+    }
+
+    for (y = y0 >> 3; y < (y0 + size) >> 3 && y < g->height >> 3; y++)
+        for (x = x0 >> 3; x < (x0 + size) >> 3 && x < g->width >> 3; x++) {
+            g->ct_depth[y * g->min_cb_w + x] = depth;
+            g->skip[y * g->min_cb_w + x]     = skip;
+        }
+}
+
+static void coding_quadtree(Gen *g, int x0, int y0, int log2, int depth)
+{
+    int size = 1 << log2, split;
+
+    if (x0 + size <= g->width && y0 + size <= g->height && log2 > 3) {
+        int inc = (available(g, x0, y0, x0 - 1, y0) &&
+                   g->ct_depth[(y0 >> 3) * g->min_cb_w + ((x0 - 1) >> 3)] > depth) +
+                  (available(g, x0, y0, x0, y0 - 1) &&
+                   g->ct_depth[((y0 - 1) >> 3) * g->min_cb_w + (x0 >> 3)] > depth);
+        split = rnd(g, 5) < 3;
+        encode_bin(g, SPLIT_CU + inc, split);
+    } else {
+        split = log2 > 3;
+    }
+    if (log2 >= g->log2_ctb - g->p->qp_delta_depth)
+        g->is_cu_qp_delta_coded = 0;
+
+    if (split) {
+        int half = size >> 1;
+
+        coding_quadtree(g, x0, y0, log2 - 1, depth + 1);
+        if (x0 + half < g->width)
+            coding_quadtree(g, x0 + half, y0, log2 - 1, depth + 1);
+        if (y0 + half < g->height)
+            coding_quadtree(g, x0, y0 + half, log2 - 1, depth + 1);
+        if (x0 + half < g->width && y0 + half < g->height)
+            coding_quadtree(g, x0 + half, y0 + half, log2 - 1, depth + 1);
+    } else {
+        coding_unit(g, x0, y0, log2, depth);
+    }
+}
+
+/* Slice segments */
+
+static void start_substream(Gen *g, PutBits *sub, int ts, int first, int dependent)
+{
+    int rs = g->p->ts_to_rs[ts], x = rs % g->ctb_w, y = rs / g->ctb_w;
+
+    if (g->c)
+        sub[-1] = g->c->pb;
+    cabac_start(g->c = alloc(sizeof(*g->c)));
+
+    // 9.3.1: at the start of a tile, of a WPP row, or of an independent slice segment
+    if (tile_start(g, ts)) {
+        init_contexts(g);
+    } else if (g->p->wpp && row_start(g, ts)) {
+        int tr = rs - g->ctb_w + 1;
+
+        if (y > 0 && x + 1 < g->ctb_w && g->ctb_slice[tr] == g->slice_addr &&
+            g->p->tile_id[tr] == g->p->tile_id[rs])
+            memcpy(g->ctx, g->wpp_ctx, sizeof(g->ctx));
+        else
+            init_contexts(g);
+    } else if (first && !dependent) {
+        init_contexts(g);
+    }
+}
+
+static void write_slice_segment(Gen *g, const Segment *seg, int first_in_pic)
+{
+    PutBits *sub = alloc((seg->end - seg->start + 1) * sizeof(*sub));
+    PutBits pb = { 0 };
+    int nb_sub = 0, ts, i, offset_len, max_size = 0, addr_bits = 0;
+    int nal_type = g->idr ? 19 : 1;
+
+    for (ts = seg->start; ts < seg->end; ts++) {
+        int rs = g->p->ts_to_rs[ts], x = rs % g->ctb_w;
+
+        if (ts == seg->start)
+            start_substream(g, &sub[++nb_sub], ts, 1, seg->dependent);
+        g->ctb_slice[rs] = g->slice_addr;
+        if (g->sao_luma || g->sao_chroma)
+            sao(g, x, rs / g->ctb_w);
+        coding_quadtree(g, x << g->log2_ctb, (rs / g->ctb_w) << g->log2_ctb, g->log2_ctb, 0);
+        if (g->p->wpp && x - g->p->col_start[x] == 1)
+            memcpy(g->wpp_ctx, g->ctx, sizeof(g->ctx));
+
+        encode_terminate(g, ts + 1 == seg->end);  // end_of_slice_segment_flag
+        if (ts + 1 < seg->end && (tile_start(g, ts + 1) || (g->p->wpp && row_start(g, ts + 1)))) {
+            encode_terminate(g, 1);               // end_of_subset_one_bit
+            start_substream(g, &sub[++nb_sub], ts + 1, 0, 0);
+        }
+    }
+    sub[nb_sub] = g->c->pb;
+    free(g->c);
+    g->c = NULL;
+
+    put_bits(&pb, 1, first_in_pic);
+    if (nal_type >= 16)
+        put_bits(&pb, 1, 0);                     // no_output_of_prior_pics_flag
+    put_ue(&pb, g->p - g->pps);
+    if (!first_in_pic) {
+        while ((1 << addr_bits) < g->nb_ctbs)
+            addr_bits++;
+        put_bits(&pb, 1, seg->dependent);
+        put_bits(&pb, addr_bits, g->p->ts_to_rs[seg->start]);
+    }
+    if (!seg->dependent) {
+        put_ue(&pb, g->slice_type);
+        if (!g->idr) {
+            put_bits(&pb, 8, g->poc & 0xff);     // slice_pic_order_cnt_lsb
+            put_bits(&pb, 1, 1);                 // short_term_ref_pic_set_sps_flag
+            put_bits(&pb, 1, g->temporal_mvp);
+        }
+        put_bits(&pb, 1, g->sao_luma);
+        put_bits(&pb, 1, g->sao_chroma);
+        if (g->slice_type == SLICE_P) {
+            put_bits(&pb, 1, 0);                 // num_ref_idx_active_override_flag
+            put_bits(&pb, 1, g->cabac_init_flag);
+            put_ue(&pb, 5 - g->max_merge);
+        }
+        put_se(&pb, g->slice_qp - g->p->init_qp);
+        put_bits(&pb, 1, g->deblock_override);
+        if (g->deblock_override) {
+            put_bits(&pb, 1, g->deblock_disable);
+            if (!g->deblock_disable) {
+                put_se(&pb, g->beta_offset);
+                put_se(&pb, g->tc_offset);
+            }
+        }
+        if (g->p->lf_across_slices && (g->sao_luma || g->sao_chroma || !g->deblock_disable))
+            put_bits(&pb, 1, g->lf_across_slices);
+    }
+    if (g->p->tiles || g->p->wpp) {
+        put_ue(&pb, nb_sub - 1);                 // num_entry_point_offsets
+        if (nb_sub > 1) {
+            for (i = 1; i < nb_sub; i++)
+                if (escaped_size(sub[i].buf, sub[i].size) > max_size)
+                    max_size = escaped_size(sub[i].buf, sub[i].size);
+            for (offset_len = 1; (max_size - 1) >> offset_len; offset_len++)
+                ;
+            put_ue(&pb, offset_len - 1);
+            for (i = 1; i < nb_sub; i++)
+                put_bits(&pb, offset_len, escaped_size(sub[i].buf, sub[i].size) - 1);
+        }
+    }
+    if (g->p->header_ext) {
+        int len = rnd(g, 4);
+
+        put_ue(&pb, len);
+        for (i = 0; i < len; i++)
+            put_bits(&pb, 8, rnd(g, 256));
+    }
+    put_trailing_bits(&pb);
+
+    for (i = 1; i <= nb_sub; i++) {
+        int j;
+        for (j = 0; j < sub[i].size; j++)
+            put_byte(&pb, sub[i].buf[j]);
+        free(sub[i].buf);
+    }
+    write_nal(g, nal_type, &pb);
+    free(pb.buf);
+    free(sub);
+}
+
+static void write_picture(Gen *g, int n)
+{
+    Segment *seg = alloc(g->nb_ctbs * sizeof(*seg));
+    int nb_seg, i;
+
+    g->p    = &g->pps[n % g->nb_pps];
+    g->poc  = n;
+    g->idr  = !n;
+    g->temporal_mvp = rnd(g, 2);
+    for (i = 0; i < g->nb_ctbs; i++)
+        g->ctb_slice[i] = -1;
+
+    nb_seg = plan_segments(g, seg);
+    for (i = 0; i < nb_seg; i++) {
+        if (!seg[i].dependent) {
+            g->slice_addr       = g->p->ts_to_rs[seg[i].start];
+            g->slice_type       = g->idr || !rnd(g, 6) ? SLICE_I : SLICE_P;
+            g->slice_qp         = 22 + rnd(g, 11);
+            g->cabac_init_flag  = rnd(g, 2);
+            g->max_merge        = 1 + rnd(g, 5);
+            g->sao_luma         = rnd(g, 2);
+            g->sao_chroma       = rnd(g, 2);
+            g->deblock_override = rnd(g, 2);
+            g->deblock_disable  = g->deblock_override && !rnd(g, 4);
+            g->beta_offset      = (int)rnd(g, 13) - 6;
+            g->tc_offset        = (int)rnd(g, 13) - 6;
+            g->lf_across_slices = g->p->lf_across_slices && rnd(g, 2);
+        }
+        write_slice_segment(g, &seg[i], !i);
+    }
+    free(seg);
+}
+
+static void init_scans(void)
+{
+    int log2, scan, size, i, x, y, d;
+
+    for (log2 = 0; log2 < 4; log2++) {
+        size = 1 << log2;
+        for (scan = 0; scan < 3; scan++) {
+            i = 0;
+            if (scan == 0) {
+                for (d = 0; d < 2 * size - 1; d++)
+                    for (y = d; y >= 0; y--)
+                        if (y < size && d - y < size) {
+                            scan_sb[log2][0][i][0]   = d - y;
+                            scan_sb[log2][0][i++][1] = y;
+                        }
+            } else {
+                for (y = 0; y < size; y++)
+                    for (x = 0; x < size; x++) {
+                        scan_sb[log2][scan][i][scan == 2]   = x;
+                        scan_sb[log2][scan][i++][scan != 2] = y;
+                    }
+            }
+        }
+    }
+    for (scan = 0; scan < 3; scan++)
+        memcpy(scan4x4[scan], scan_sb[2][scan], sizeof(scan4x4[scan]));
+}
+
+static int parse_size(const char *arg, int *w, int *h)
+{
+    return sscanf(arg, "%dx%d", w, h) == 2 && *w > 0 && *h > 0;
+}
+
+int main(int argc, char **argv)
+{
+    Gen g = { 0 };
+    int cols = 1, rows = 1, uniform = 0, wpp = 0, frames = 3, ctb = 16, i;
+
+    if (argc < 2) {
+        printf("usage: %s file [size=WxH] [ctb=16|32] [tiles=CxR] [uniform=0|1]\n"
+               "       [wpp=0|1] [slices=0|1] [pps=N] [frames=N] [seed=N]\n"
+               "generate an HEVC stream with random syntax\n", argv[0]);
+        return 1;
+    }
+
+    g.width  = 416;
+    g.height = 240;
+    g.nb_pps = 1;
+    g.seed   = 1;
+    for (i = 2; i < argc; i++) {
+        const char *arg = argv[i];
+        int ok = 1;
+
+        if (!strncmp(arg, "size=", 5))
+            ok = parse_size(arg + 5, &g.width, &g.height) && !(g.width & 7) && !(g.height & 7);
+        else if (!strncmp(arg, "ctb=", 4))
+            ok = (ctb = atoi(arg + 4)) == 16 || ctb == 32;
+        else if (!strncmp(arg, "tiles=", 6))
+            ok = parse_size(arg + 6, &cols, &rows) && cols <= MAX_TILES && rows <= MAX_TILES;
+        else if (!strncmp(arg, "uniform=", 8))
+            uniform = atoi(arg + 8);
+        else if (!strncmp(arg, "wpp=", 4))
+            wpp = atoi(arg + 4);
+        else if (!strncmp(arg, "slices=", 7))
+            g.slices = atoi(arg + 7);
+        else if (!strncmp(arg, "pps=", 4))
+            ok = (g.nb_pps = atoi(arg + 4)) >= 1 && g.nb_pps <= MAX_PPS;
+        else if (!strncmp(arg, "frames=", 7))
+            ok = (frames = atoi(arg + 7)) >= 1;
+        else if (!strncmp(arg, "seed=", 5))
+            g.seed = strtoul(arg + 5, NULL, 0);
+        else
+            ok = 0;
+        if (!ok) {
+            fprintf(stderr, "invalid option %s\n", arg);
+            return 1;
+        }
+    }
+
+    g.log2_ctb    = ctb == 32 ? 5 : 4;
+    g.ctb_w       = (g.width  + ctb - 1) >> g.log2_ctb;
+    g.ctb_h       = (g.height + ctb - 1) >> g.log2_ctb;
+    g.nb_ctbs     = g.ctb_w * g.ctb_h;
+    g.log2_max_tb = 4 + rnd(&g, g.log2_ctb - 3);
+    g.min_cb_w    = g.width  >> 3;
+    g.min_pu_w    = g.width  >> 2;
+    if (cols > g.ctb_w || rows > g.ctb_h) {
+        fprintf(stderr, "%dx%d tiles do not fit in %dx%d CTBs\n", cols, rows, g.ctb_w, g.ctb_h);
+        return 1;
+    }
+
+    init_scans();
+    init_pps(&g, &g.pps[0], cols, rows, uniform, wpp);
+    for (i = 1; i < g.nb_pps; i++)
+        init_pps(&g, &g.pps[i], 1 + rnd(&g, cols), 1 + rnd(&g, rows), rnd(&g, 2), wpp);
+    g.ctb_slice  = alloc(g.nb_ctbs * sizeof(*g.ctb_slice));
+    g.ct_depth   = alloc((g.width >> 3) * (g.height >> 3));
+    g.skip       = alloc((g.width >> 3) * (g.height >> 3));
+    g.intra_mode = alloc((g.width >> 2) * (g.height >> 2));
+
+    if (!(g.out = fopen(argv[1], "wb"))) {
+        perror(argv[1]);
+        return 1;
+    }
+    write_vps(&g);
+    write_sps(&g);
+    for (i = 0; i < g.nb_pps; i++)
+        write_pps(&g, i);
+    for (i = 0; i < frames; i++)
+        write_picture(&g, i);
+    fclose(g.out);
+    return 0;
+}
@@ -0,0 +1,235 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * CPU cost of the amix filter followed by volume, in CPU microseconds per
+ * mixed channel second (one second of one channel of one input), e.g.
+ *   tools/amix_bench                      (32 mono inputs, 48 kHz, fltp)
+ *   tools/amix_bench -i 64 -n 2 -f flt
+ *   tools/amix_bench -c 0                 (C code only)
+ *   tools/amix_bench -t 4                 (4 filter threads)
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavutil/samplefmt.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+#define RATE  48000
+#define BLOCK 960   /* 20 ms, a common conference audio frame */
+
+static void fill(AVFrame *frame, int channels, AVLFG *lfg)
+{
+    int planes  = av_sample_fmt_is_planar(frame->format) ? channels : 1;
+    int samples = av_sample_fmt_is_planar(frame->format) ? frame->nb_samples
+                                                         : frame->nb_samples * channels;
+    int p, i;
+
+    for (p = 0; p < planes; p++) {
+        for (i = 0; i < samples; i++) {
+            double v = (int)(av_lfg_get(lfg) & 0xffff) / 32768.0 - 1.0;
+            if (av_get_packed_sample_fmt(frame->format) == AV_SAMPLE_FMT_FLT)
+                ((float  *)frame->extended_data[p])[i] = v;
+            else
+                ((double *)frame->extended_data[p])[i] = v;
+        }
+    }
+}
+
+static int build_graph(AVFilterGraph *graph, AVFilterContext **srcs, AVFilterContext **sink,
+                       int inputs, int channels, enum AVSampleFormat fmt)
+{
+    AVFilterContext *mix, *vol;
+    char args[256];
+    int i, ret;
+
+    snprintf(args, sizeof(args), "inputs=%d", inputs);
+    if ((ret = avfilter_graph_create_filter(&mix, avfilter_get_by_name("amix"), "mix",
+                                            args, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&vol, avfilter_get_by_name("volume"), "vol",
+                                            "volume=0.8", NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(sink, avfilter_get_by_name("abuffersink"), "out",
+                                            NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_link(mix, 0, vol, 0)) < 0 ||
+        (ret = avfilter_link(vol, 0, *sink, 0)) < 0)
+        return ret;
+
+    snprintf(args, sizeof(args), "time_base=1/%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%"PRIx64,
+             RATE, RATE, av_get_sample_fmt_name(fmt), av_get_default_channel_layout(channels));
+    for (i = 0; i < inputs; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "in%d", i);
+        if ((ret = avfilter_graph_create_filter(&srcs[i], avfilter_get_by_name("abuffer"), name,
+                                                args, NULL, graph)) < 0 ||
+            (ret = avfilter_link(srcs[i], 0, mix, i)) < 0)
+            return ret;
+    }
+    return avfilter_graph_config(graph, NULL);
+}
+
+static int run_test(enum AVSampleFormat fmt, int inputs, int channels, int seconds,
+                    int threads, AVLFG *lfg)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext **srcs = av_mallocz_array(inputs, sizeof(*srcs));
+    AVFilterContext *sink;
+    AVFrame *in = av_frame_alloc(), *out = av_frame_alloc();
+    int64_t n, blocks = (int64_t)RATE * seconds / BLOCK;
+    clock_t t;
+    int i, ret;
+
+    if (!graph || !srcs || !in || !out) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = threads;
+    if ((ret = build_graph(graph, srcs, &sink, inputs, channels, fmt)) < 0)
+        goto end;
+
+    in->format         = fmt;
+    in->nb_samples     = BLOCK;
+    in->channel_layout = av_get_default_channel_layout(channels);
+    in->sample_rate    = RATE;
+    if ((ret = av_frame_get_buffer(in, 0)) < 0)
+        goto end;
+    fill(in, channels, lfg);
+
+    t = clock();
+    for (n = 0; n < blocks; n++) {
+        in->pts = n * BLOCK;
+        for (i = 0; i < inputs; i++) {
+            if ((ret = av_buffersrc_add_frame_flags(srcs[i], in, AV_BUFFERSRC_FLAG_KEEP_REF)) < 0)
+                goto end;
+        }
+        while ((ret = av_buffersink_get_frame(sink, out)) >= 0)
+            av_frame_unref(out);
+        if (ret != AVERROR(EAGAIN))
+            goto end;
+    }
+    t = clock() - t;
+
+    printf("%-4s %3d inputs x %d ch, %d threads: %7.2f CPU us per mixed channel second\n",
+           av_get_sample_fmt_name(fmt), inputs, channels, threads,
+           1e6 * t / CLOCKS_PER_SEC / ((double)inputs * channels * blocks * BLOCK / RATE));
+    ret = 0;
+
+end:
+    av_frame_free(&in);
+    av_frame_free(&out);
+    av_freep(&srcs);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-i inputs] [-n channels] [-f fltp|flt|dblp|dbl] [-l seconds] "
+           "[-t threads] [-c cpuflags]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    enum AVSampleFormat fmt = AV_SAMPLE_FMT_FLTP;
+    int inputs = 32, channels = 1, seconds = 60, threads = 1;
+    AVLFG lfg;
+    int opt, ret;
+
+    while ((opt = getopt(argc, argv, "i:n:f:l:t:c:h")) != -1) {
+        switch (opt) {
+        case 'i':
+            inputs = atoi(optarg);
+            if (inputs <= 0 || inputs > 1024) {
+                fprintf(stderr, "Invalid number of inputs '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            channels = atoi(optarg);
+            if (channels <= 0 || channels > 8) {
+                fprintf(stderr, "Invalid number of channels '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            fmt = av_get_sample_fmt(optarg);
+            if (av_get_packed_sample_fmt(fmt) != AV_SAMPLE_FMT_FLT &&
+                av_get_packed_sample_fmt(fmt) != AV_SAMPLE_FMT_DBL) {
+                fprintf(stderr, "Invalid sample format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'l':
+            seconds = atoi(optarg);
+            if (seconds <= 0) {
+                fprintf(stderr, "Invalid length '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            threads = atoi(optarg);
+            if (threads <= 0) {
+                fprintf(stderr, "Invalid number of threads '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c': {
+            unsigned flags = av_get_cpu_flags();
+            if (av_parse_cpu_caps(&flags, optarg) < 0) {
+                fprintf(stderr, "Invalid cpu flags '%s'\n", optarg);
+                return 1;
+            }
+            av_force_cpu_flags(flags);
+            break;
+        }
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    avfilter_register_all();
+    av_lfg_init(&lfg, 0xC0FFEE);
+    ret = run_test(fmt, inputs, channels, seconds, threads, &lfg);
+    if (ret < 0) {
+        fprintf(stderr, "amix failed: %s\n", av_err2str(ret));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * CPU time of opening a file and of the av_read_frame() loop over all of it,
+ * the best of several passes, e.g.
+ *   tools/demux_bench input.mp4
+ *   tools/demux_bench -n 10 a.mp4 b.mkv
+ *   tools/demux_bench -f mov -o use_mfra_for=pts input.mp4
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libavutil/dict.h"
+#include "libavutil/error.h"
+#include "libavformat/avformat.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static int run_pass(const char *filename, AVInputFormat *fmt, AVDictionary *opts,
+                    double *open_time, double *read_time, int64_t *packets,
+                    int64_t *bytes, int *streams)
+{
+    AVFormatContext *s = NULL;
+    AVDictionary *pass_opts = NULL;
+    AVPacket pkt;
+    clock_t t;
+    int ret;
+
+    av_dict_copy(&pass_opts, opts, 0);
+    t = clock();
+    ret = avformat_open_input(&s, filename, fmt, &pass_opts);
+    av_dict_free(&pass_opts);
+    if (ret < 0)
+        return ret;
+    *open_time = (double)(clock() - t) / CLOCKS_PER_SEC;
+    *streams   = s->nb_streams;
+
+    *packets = *bytes = 0;
+    t = clock();
+    while ((ret = av_read_frame(s, &pkt)) >= 0) {
+        (*packets)++;
+        *bytes += pkt.size;
+        av_packet_unref(&pkt);
+    }
+    *read_time = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+    avformat_close_input(&s);
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-n passes] [-f format] [-o key=value] file...\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    AVInputFormat *fmt = NULL;
+    AVDictionary *opts = NULL;
+    int passes = 5;
+    int opt, i, pass, ret = 0;
+
+    while ((opt = getopt(argc, argv, "n:f:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            passes = atoi(optarg);
+            if (passes <= 0) {
+                fprintf(stderr, "Invalid number of passes '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            av_register_all();
+            fmt = av_find_input_format(optarg);
+            if (!fmt) {
+                fprintf(stderr, "Unknown input format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            if (av_dict_parse_string(&opts, optarg, "=", ":", 0) < 0) {
+                fprintf(stderr, "Invalid option '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    av_register_all();
+    for (i = optind; i < argc; i++) {
+        double best_open = 0, best_read = 0;
+        int64_t packets = 0, bytes = 0;
+        int streams = 0;
+
+        for (pass = 0; pass < passes; pass++) {
+            double open_time, read_time;
+
+            ret = run_pass(argv[i], fmt, opts, &open_time, &read_time,
+                           &packets, &bytes, &streams);
+            if (ret < 0) {
+                fprintf(stderr, "%s: %s\n", argv[i], av_err2str(ret));
+                goto end;
+            }
+            if (!pass || open_time < best_open)
+                best_open = open_time;
+            if (!pass || read_time < best_read)
+                best_read = read_time;
+        }
+
+        printf("%s: %d streams, %"PRId64" packets, %"PRId64" bytes, "
+               "open %.3f s, read %.3f s CPU (best of %d)\n",
+               argv[i], streams, packets, bytes, best_open, best_read, passes);
+    }
+
+end:
+    av_dict_free(&opts);
+    return ret < 0;
+}
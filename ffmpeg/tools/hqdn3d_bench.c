@@ -0,0 +1,236 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Throughput of the hqdn3d filter on noise frames, in frames per second of
+ * wall time and CPU milliseconds per frame, e.g.
+ *   tools/hqdn3d_bench                    (1080p yuv420p, default strengths)
+ *   tools/hqdn3d_bench -t 4
+ *   tools/hqdn3d_bench -s 3840x2160 -f yuv420p10le -n 20
+ *   tools/hqdn3d_bench -o luma_spatial=0:chroma_spatial=0   (temporal only)
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+/* The inputs cycle through a few frames so the temporal filter keeps working */
+#define NB_INPUTS 4
+
+/* Smooth gradient plus noise in every plane */
+static void fill(AVFrame *frame, AVLFG *lfg)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+    int max = (1 << desc->comp[0].depth) - 1;
+    int p, x, y;
+
+    for (p = 0; p < 4 && frame->data[p]; p++) {
+        int w = p == 1 || p == 2 ? AV_CEIL_RSHIFT(frame->width,  desc->log2_chroma_w) : frame->width;
+        int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+
+        for (y = 0; y < h; y++) {
+            uint8_t *line = frame->data[p] + y * frame->linesize[p];
+            for (x = 0; x < w; x++) {
+                int v = av_clip((x + y) * max / (w + h) + (int)(av_lfg_get(lfg) & 15) - 8, 0, max);
+                if (max > 255)
+                    ((uint16_t *)line)[x] = v;
+                else
+                    line[x] = v;
+            }
+        }
+    }
+}
+
+static int build_graph(AVFilterGraph *graph, AVFilterContext **src, AVFilterContext **sink,
+                       const char *opts, const AVFrame *frame)
+{
+    AVFilterContext *filter;
+    char args[256];
+    int ret;
+
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=1/25:pixel_aspect=1/1",
+             frame->width, frame->height, frame->format);
+    if ((ret = avfilter_graph_create_filter(src, avfilter_get_by_name("buffer"), "in",
+                                            args, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(&filter, avfilter_get_by_name("hqdn3d"), "hqdn3d",
+                                            opts, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(sink, avfilter_get_by_name("buffersink"), "out",
+                                            NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_link(*src, 0, filter, 0)) < 0 ||
+        (ret = avfilter_link(filter, 0, *sink, 0)) < 0)
+        return ret;
+    return avfilter_graph_config(graph, NULL);
+}
+
+static int run_test(const char *opts, AVFrame **in, int frames, int threads)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *src, *sink;
+    AVFrame *out = av_frame_alloc();
+    int64_t wall;
+    clock_t t;
+    int n, ret;
+
+    if (!graph || !out) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = threads;
+    if ((ret = build_graph(graph, &src, &sink, opts, in[0])) < 0)
+        goto end;
+
+    wall = av_gettime_relative();
+    t    = clock();
+    for (n = 0; n <= frames; n++) {
+        AVFrame *frame = n < frames ? in[n % NB_INPUTS] : NULL;
+        if (frame)
+            frame->pts = n;
+        /* a NULL frame after the last one flushes the filter */
+        if ((ret = av_buffersrc_add_frame_flags(src, frame, AV_BUFFERSRC_FLAG_KEEP_REF)) < 0)
+            goto end;
+        while ((ret = av_buffersink_get_frame(sink, out)) >= 0)
+            av_frame_unref(out);
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    t    = clock() - t;
+    wall = av_gettime_relative() - wall;
+
+    printf("hqdn3d %dx%d %s, %d threads: %7.2f fps, %8.2f CPU ms per frame\n",
+           in[0]->width, in[0]->height, av_get_pix_fmt_name(in[0]->format), threads,
+           frames * 1e6 / wall, 1e3 * t / CLOCKS_PER_SEC / frames);
+    ret = 0;
+
+end:
+    av_frame_free(&out);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-s size] [-f pix_fmt] [-n frames] [-t threads] "
+           "[-o options] [-c cpuflags]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    const char *opts = NULL;
+    enum AVPixelFormat fmt = AV_PIX_FMT_YUV420P;
+    int width = 1920, height = 1080, frames = 100, threads = 1;
+    AVFrame *in[NB_INPUTS] = { NULL };
+    AVLFG lfg;
+    int opt, i, ret = 0;
+
+    while ((opt = getopt(argc, argv, "s:f:n:t:o:c:h")) != -1) {
+        switch (opt) {
+        case 's':
+            if (av_parse_video_size(&width, &height, optarg) < 0) {
+                fprintf(stderr, "Invalid size '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            fmt = av_get_pix_fmt(optarg);
+            if (fmt == AV_PIX_FMT_NONE) {
+                fprintf(stderr, "Invalid pixel format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            frames = atoi(optarg);
+            if (frames <= 0) {
+                fprintf(stderr, "Invalid number of frames '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            threads = atoi(optarg);
+            if (threads <= 0) {
+                fprintf(stderr, "Invalid number of threads '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            opts = optarg;
+            break;
+        case 'c': {
+            unsigned flags = av_get_cpu_flags();
+            if (av_parse_cpu_caps(&flags, optarg) < 0) {
+                fprintf(stderr, "Invalid cpu flags '%s'\n", optarg);
+                return 1;
+            }
+            av_force_cpu_flags(flags);
+            break;
+        }
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    avfilter_register_all();
+    av_log_set_level(AV_LOG_WARNING);
+
+    av_lfg_init(&lfg, 0xC0FFEE);
+    for (i = 0; i < NB_INPUTS; i++) {
+        if (!(in[i] = av_frame_alloc())) {
+            ret = AVERROR(ENOMEM);
+            goto end;
+        }
+        in[i]->format = fmt;
+        in[i]->width  = width;
+        in[i]->height = height;
+        if ((ret = av_frame_get_buffer(in[i], 32)) < 0)
+            goto end;
+        fill(in[i], &lfg);
+    }
+
+    if ((ret = run_test(opts, in, frames, threads)) < 0)
+        fprintf(stderr, "hqdn3d failed: %s\n", av_err2str(ret));
+
+end:
+    for (i = 0; i < NB_INPUTS; i++)
+        av_frame_free(&in[i]);
+    return ret < 0;
+}
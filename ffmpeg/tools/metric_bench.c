@@ -0,0 +1,263 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Throughput of the psnr and ssim filters on noise frames, in frame pairs
+ * per second of wall time and CPU milliseconds per frame pair, e.g.
+ *   tools/metric_bench                    (both filters, 4K yuv420p10le)
+ *   tools/metric_bench -m ssim -t 8
+ *   tools/metric_bench -s 1920x1080 -f yuv420p -n 100
+ *   tools/metric_bench -o row_subsample=4
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/error.h"
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+#include "libavfilter/avfilter.h"
+#include "libavfilter/buffersink.h"
+#include "libavfilter/buffersrc.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+/* Noise in every plane, dist is ref with small errors added. */
+static void fill(AVFrame *dist, AVFrame *ref, AVLFG *lfg)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(dist->format);
+    int max = (1 << desc->comp[0].depth) - 1;
+    int p, x, y;
+
+    for (p = 0; p < 4 && dist->data[p]; p++) {
+        int w = p == 1 || p == 2 ? AV_CEIL_RSHIFT(dist->width,  desc->log2_chroma_w) : dist->width;
+        int h = p == 1 || p == 2 ? AV_CEIL_RSHIFT(dist->height, desc->log2_chroma_h) : dist->height;
+
+        for (y = 0; y < h; y++) {
+            uint8_t *d = dist->data[p] + y * dist->linesize[p];
+            uint8_t *r = ref->data[p]  + y * ref->linesize[p];
+            for (x = 0; x < w; x++) {
+                unsigned v = av_lfg_get(lfg);
+                int a = v & max;
+                int b = av_clip(a + (int)((v >> 20) & 7) - 3, 0, max);
+                if (max > 255) {
+                    ((uint16_t *)r)[x] = a;
+                    ((uint16_t *)d)[x] = b;
+                } else {
+                    r[x] = a;
+                    d[x] = b;
+                }
+            }
+        }
+    }
+}
+
+static int build_graph(AVFilterGraph *graph, AVFilterContext **srcs, AVFilterContext **sink,
+                       const char *metric, const char *opts, const AVFrame *frame)
+{
+    AVFilterContext *filter;
+    char args[256];
+    int i, ret;
+
+    if ((ret = avfilter_graph_create_filter(&filter, avfilter_get_by_name(metric), metric,
+                                            opts, NULL, graph)) < 0 ||
+        (ret = avfilter_graph_create_filter(sink, avfilter_get_by_name("buffersink"), "out",
+                                            NULL, NULL, graph)) < 0 ||
+        (ret = avfilter_link(filter, 0, *sink, 0)) < 0)
+        return ret;
+
+    snprintf(args, sizeof(args), "video_size=%dx%d:pix_fmt=%d:time_base=1/25:pixel_aspect=1/1",
+             frame->width, frame->height, frame->format);
+    for (i = 0; i < 2; i++) {
+        if ((ret = avfilter_graph_create_filter(&srcs[i], avfilter_get_by_name("buffer"),
+                                                i ? "ref" : "dist", args, NULL, graph)) < 0 ||
+            (ret = avfilter_link(srcs[i], 0, filter, i)) < 0)
+            return ret;
+    }
+    return avfilter_graph_config(graph, NULL);
+}
+
+static int run_test(const char *metric, const char *opts, AVFrame *dist, AVFrame *ref,
+                    int frames, int threads)
+{
+    AVFilterGraph *graph = avfilter_graph_alloc();
+    AVFilterContext *srcs[2], *sink;
+    AVFrame *out = av_frame_alloc();
+    int64_t wall;
+    clock_t t;
+    int n, i, ret;
+
+    if (!graph || !out) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    graph->nb_threads = threads;
+    if ((ret = build_graph(graph, srcs, &sink, metric, opts, dist)) < 0)
+        goto end;
+
+    wall = av_gettime_relative();
+    t    = clock();
+    for (n = 0; n <= frames; n++) {
+        for (i = 0; i < 2; i++) {
+            AVFrame *in = i ? ref : dist;
+            in->pts = n;
+            /* a NULL frame after the last one flushes the filter */
+            if ((ret = av_buffersrc_add_frame_flags(srcs[i], n < frames ? in : NULL,
+                                                    AV_BUFFERSRC_FLAG_KEEP_REF)) < 0)
+                goto end;
+        }
+        while ((ret = av_buffersink_get_frame(sink, out)) >= 0)
+            av_frame_unref(out);
+        if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+            goto end;
+    }
+    t    = clock() - t;
+    wall = av_gettime_relative() - wall;
+
+    printf("%-4s %dx%d %s, %d threads: %7.2f fps, %8.2f CPU ms per frame pair\n",
+           metric, dist->width, dist->height, av_get_pix_fmt_name(dist->format), threads,
+           frames * 1e6 / wall, 1e3 * t / CLOCKS_PER_SEC / frames);
+    ret = 0;
+
+end:
+    av_frame_free(&out);
+    avfilter_graph_free(&graph);
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-m psnr|ssim] [-s size] [-f pix_fmt] [-n frames] [-t threads] "
+           "[-o options] [-c cpuflags]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *const metrics[] = { "psnr", "ssim" };
+    const char *metric = NULL, *opts = NULL;
+    enum AVPixelFormat fmt = AV_PIX_FMT_YUV420P10;
+    int width = 3840, height = 2160, frames = 30, threads = 1;
+    AVFrame *dist = NULL, *ref = NULL;
+    AVLFG lfg;
+    int opt, i, ret = 0;
+
+    while ((opt = getopt(argc, argv, "m:s:f:n:t:o:c:h")) != -1) {
+        switch (opt) {
+        case 'm':
+            if (strcmp(optarg, "psnr") && strcmp(optarg, "ssim")) {
+                fprintf(stderr, "Invalid metric '%s'\n", optarg);
+                return 1;
+            }
+            metric = optarg;
+            break;
+        case 's':
+            if (av_parse_video_size(&width, &height, optarg) < 0) {
+                fprintf(stderr, "Invalid size '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'f':
+            fmt = av_get_pix_fmt(optarg);
+            if (fmt == AV_PIX_FMT_NONE) {
+                fprintf(stderr, "Invalid pixel format '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            frames = atoi(optarg);
+            if (frames <= 0) {
+                fprintf(stderr, "Invalid number of frames '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            threads = atoi(optarg);
+            if (threads <= 0) {
+                fprintf(stderr, "Invalid number of threads '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'o':
+            opts = optarg;
+            break;
+        case 'c': {
+            unsigned flags = av_get_cpu_flags();
+            if (av_parse_cpu_caps(&flags, optarg) < 0) {
+                fprintf(stderr, "Invalid cpu flags '%s'\n", optarg);
+                return 1;
+            }
+            av_force_cpu_flags(flags);
+            break;
+        }
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    avfilter_register_all();
+    /* the filters log their averages when they are freed */
+    av_log_set_level(AV_LOG_WARNING);
+
+    dist = av_frame_alloc();
+    ref  = av_frame_alloc();
+    if (!dist || !ref) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    dist->format = ref->format = fmt;
+    dist->width  = ref->width  = width;
+    dist->height = ref->height = height;
+    if ((ret = av_frame_get_buffer(dist, 32)) < 0 ||
+        (ret = av_frame_get_buffer(ref, 32)) < 0)
+        goto end;
+    av_lfg_init(&lfg, 0xC0FFEE);
+    fill(dist, ref, &lfg);
+
+    for (i = 0; i < 2; i++) {
+        if (metric && strcmp(metric, metrics[i]))
+            continue;
+        if ((ret = run_test(metrics[i], opts, dist, ref, frames, threads)) < 0) {
+            fprintf(stderr, "%s failed: %s\n", metrics[i], av_err2str(ret));
+            break;
+        }
+    }
+
+end:
+    av_frame_free(&dist);
+    av_frame_free(&ref);
+    return ret < 0;
+}
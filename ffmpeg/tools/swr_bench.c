@@ -0,0 +1,192 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Throughput of libswresample, in seconds of audio per channel converted
+ * per second of CPU time, e.g.
+ *   tools/swr_bench                       (44100 -> 48000 Hz, stereo)
+ *   tools/swr_bench -r 48000:44100 -n 6 -l 60
+ *   tools/swr_bench -c 0                  (C code only)
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/error.h"
+#include "libavutil/lfg.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+#include "libswresample/swresample.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+#define BLOCK 1024
+
+static const struct {
+    enum AVSampleFormat in, out;
+    int resample;
+} tests[] = {
+    { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_FLTP, 1 },
+    { AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S16P, 1 },
+    { AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_S32P, 1 },
+    { AV_SAMPLE_FMT_DBLP, AV_SAMPLE_FMT_DBLP, 1 },
+    { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16,  1 },
+    { AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_S16,  0 },
+    { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_FLTP, 0 },
+    { AV_SAMPLE_FMT_S16,  AV_SAMPLE_FMT_FLT,  0 },
+};
+
+static void fill(uint8_t **data, enum AVSampleFormat fmt, int channels, int n, AVLFG *lfg)
+{
+    int planes  = av_sample_fmt_is_planar(fmt) ? channels : 1;
+    int samples = av_sample_fmt_is_planar(fmt) ? n : n * channels;
+    int p, i;
+
+    for (p = 0; p < planes; p++) {
+        for (i = 0; i < samples; i++) {
+            double v = (int)(av_lfg_get(lfg) & 0xffff) / 32768.0 - 1.0;
+            switch (av_get_packed_sample_fmt(fmt)) {
+            case AV_SAMPLE_FMT_S16: ((int16_t *)data[p])[i] = v * INT16_MAX; break;
+            case AV_SAMPLE_FMT_S32: ((int32_t *)data[p])[i] = v * INT32_MAX; break;
+            case AV_SAMPLE_FMT_FLT: ((float   *)data[p])[i] = v;             break;
+            case AV_SAMPLE_FMT_DBL: ((double  *)data[p])[i] = v;             break;
+            }
+        }
+    }
+}
+
+static int run_test(enum AVSampleFormat in_fmt, enum AVSampleFormat out_fmt,
+                    int in_rate, int out_rate, int channels, int seconds, AVLFG *lfg)
+{
+    int64_t layout = av_get_default_channel_layout(channels);
+    int out_max = av_rescale_rnd(BLOCK, out_rate, in_rate, AV_ROUND_UP) + 64;
+    uint8_t **in = NULL, **out = NULL;
+    struct SwrContext *swr;
+    int64_t n, blocks = (int64_t)in_rate * seconds / BLOCK;
+    clock_t t;
+    int ret;
+
+    swr = swr_alloc_set_opts(NULL, layout, out_fmt, out_rate,
+                             layout, in_fmt, in_rate, 0, NULL);
+    if (!swr)
+        return AVERROR(ENOMEM);
+    if ((ret = swr_init(swr)) < 0 ||
+        (ret = av_samples_alloc_array_and_samples(&in,  NULL, channels, BLOCK,   in_fmt,  0)) < 0 ||
+        (ret = av_samples_alloc_array_and_samples(&out, NULL, channels, out_max, out_fmt, 0)) < 0)
+        goto end;
+    fill(in, in_fmt, channels, BLOCK, lfg);
+
+    t = clock();
+    for (n = 0; n < blocks; n++) {
+        if ((ret = swr_convert(swr, out, out_max, (const uint8_t **)in, BLOCK)) < 0)
+            goto end;
+    }
+    t = clock() - t;
+
+    printf("%-5s %6d -> %-5s %6d: %9.1f channel seconds per CPU second\n",
+           av_get_sample_fmt_name(in_fmt), in_rate, av_get_sample_fmt_name(out_fmt), out_rate,
+           (double)channels * blocks * BLOCK / in_rate * CLOCKS_PER_SEC / FFMAX(t, 1));
+    ret = 0;
+
+end:
+    if (in)
+        av_freep(&in[0]);
+    av_freep(&in);
+    if (out)
+        av_freep(&out[0]);
+    av_freep(&out);
+    swr_free(&swr);
+    return ret;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-r in_rate:out_rate] [-n channels] [-l seconds] [-c cpuflags]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int in_rate = 44100, out_rate = 48000, channels = 2, seconds = 600;
+    AVLFG lfg;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "r:n:l:c:h")) != -1) {
+        switch (opt) {
+        case 'r':
+            if (sscanf(optarg, "%d:%d", &in_rate, &out_rate) != 2 ||
+                in_rate <= 0 || out_rate <= 0) {
+                fprintf(stderr, "Invalid rates '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            channels = atoi(optarg);
+            if (channels <= 0 || channels > 8) {
+                fprintf(stderr, "Invalid number of channels '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'l':
+            seconds = atoi(optarg);
+            if (seconds <= 0) {
+                fprintf(stderr, "Invalid length '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c': {
+            unsigned flags = av_get_cpu_flags();
+            if (av_parse_cpu_caps(&flags, optarg) < 0) {
+                fprintf(stderr, "Invalid cpu flags '%s'\n", optarg);
+                return 1;
+            }
+            av_force_cpu_flags(flags);
+            break;
+        }
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    av_lfg_init(&lfg, 0xC0FFEE);
+    for (i = 0; i < FF_ARRAY_ELEMS(tests); i++) {
+        int rate = tests[i].resample ? out_rate : in_rate;
+        int ret  = run_test(tests[i].in, tests[i].out, in_rate, rate, channels, seconds, &lfg);
+        if (ret < 0) {
+            fprintf(stderr, "%s -> %s failed: %s\n", av_get_sample_fmt_name(tests[i].in),
+                    av_get_sample_fmt_name(tests[i].out), av_err2str(ret));
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,208 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Throughput of libswscale conversions, e.g.
+ *   tools/sws_bench -s 3840x2160 -n 50
+ *   tools/sws_bench -c 0                        (C code only)
+ *   tools/sws_bench -s 3840x2160 -d 1280x720 -t 8  (bicubic, 8 threads)
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libavutil/cpu.h"
+#include "libavutil/imgutils.h"
+#include "libavutil/lfg.h"
+#include "libavutil/log.h"
+#include "libavutil/opt.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+#include "libswscale/swscale.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h> /* for getopt */
+#endif
+#if !HAVE_GETOPT
+#include "compat/getopt.c"
+#endif
+
+static const struct {
+    enum AVPixelFormat src, dst;
+} conversions[] = {
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12 },
+    { AV_PIX_FMT_YUV422P, AV_PIX_FMT_NV12 },
+    { AV_PIX_FMT_YUV444P, AV_PIX_FMT_NV12 },
+    { AV_PIX_FMT_P010LE,  AV_PIX_FMT_NV12 },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_BGRA },
+    { AV_PIX_FMT_YUV422P, AV_PIX_FMT_BGRA },
+    { AV_PIX_FMT_YUV444P, AV_PIX_FMT_BGRA },
+    { AV_PIX_FMT_YUV420P, AV_PIX_FMT_RGBA },
+};
+
+static struct SwsContext *alloc_context(int w, int h, enum AVPixelFormat src_fmt,
+                                        int dst_w, int dst_h, enum AVPixelFormat dst_fmt,
+                                        int flags, int threads)
+{
+    struct SwsContext *sws = sws_alloc_context();
+
+    if (!sws)
+        return NULL;
+
+    av_opt_set_int(sws, "srcw",       w,       0);
+    av_opt_set_int(sws, "srch",       h,       0);
+    av_opt_set_int(sws, "src_format", src_fmt, 0);
+    av_opt_set_int(sws, "dstw",       dst_w,   0);
+    av_opt_set_int(sws, "dsth",       dst_h,   0);
+    av_opt_set_int(sws, "dst_format", dst_fmt, 0);
+    av_opt_set_int(sws, "sws_flags",  flags,   0);
+    av_opt_set_int(sws, "threads",    threads, 0);
+
+    if (sws_init_context(sws, NULL, NULL) < 0) {
+        sws_freeContext(sws);
+        return NULL;
+    }
+    return sws;
+}
+
+/* dst_w and dst_h different from w and h select bicubic scaling,
+ * Mpixels/s are counted at the destination */
+static int run_conversion(enum AVPixelFormat src_fmt, enum AVPixelFormat dst_fmt,
+                          int w, int h, int dst_w, int dst_h, int threads,
+                          int runs, AVLFG *lfg)
+{
+    uint8_t *src[4], *dst[4];
+    int src_linesize[4], dst_linesize[4];
+    struct SwsContext *sws;
+    int64_t t;
+    int i, j, size, ret;
+
+    sws = alloc_context(w, h, src_fmt, dst_w, dst_h, dst_fmt,
+                        w == dst_w && h == dst_h ? SWS_BILINEAR : SWS_BICUBIC,
+                        threads);
+    if (!sws)
+        return AVERROR(EINVAL);
+
+    if ((size = av_image_alloc(src, src_linesize, w, h, src_fmt, 32)) < 0) {
+        sws_freeContext(sws);
+        return size;
+    }
+    if ((ret = av_image_alloc(dst, dst_linesize, dst_w, dst_h, dst_fmt, 32)) < 0) {
+        av_freep(&src[0]);
+        sws_freeContext(sws);
+        return ret;
+    }
+    for (j = 0; j < size; j++)
+        src[0][j] = av_lfg_get(lfg);
+
+    sws_scale(sws, (const uint8_t * const *)src, src_linesize, 0, h,
+              dst, dst_linesize);
+    t = av_gettime_relative();
+    for (i = 0; i < runs; i++)
+        sws_scale(sws, (const uint8_t * const *)src, src_linesize, 0, h,
+                  dst, dst_linesize);
+    t = av_gettime_relative() - t;
+
+    printf("%-8s -> %-5s: %8.1f Mpixels/s\n",
+           av_get_pix_fmt_name(src_fmt), av_get_pix_fmt_name(dst_fmt),
+           (double)dst_w * dst_h * runs / FFMAX(t, 1));
+
+    av_freep(&src[0]);
+    av_freep(&dst[0]);
+    sws_freeContext(sws);
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-s WxH] [-d WxH] [-t threads] [-n runs] [-c cpuflags]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    int w = 1920, h = 1080, dst_w = 0, dst_h = 0, threads = 1, runs = 100;
+    AVLFG lfg;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "s:d:t:n:c:h")) != -1) {
+        switch (opt) {
+        case 's':
+            if (av_parse_video_size(&w, &h, optarg) < 0) {
+                fprintf(stderr, "Invalid size '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'd':
+            if (av_parse_video_size(&dst_w, &dst_h, optarg) < 0) {
+                fprintf(stderr, "Invalid size '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 't':
+            threads = atoi(optarg);
+            if (threads < 0) {
+                fprintf(stderr, "Invalid number of threads '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'n':
+            runs = atoi(optarg);
+            if (runs <= 0) {
+                fprintf(stderr, "Invalid number of runs '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        case 'c': {
+            unsigned flags = av_get_cpu_flags();
+            if (av_parse_cpu_caps(&flags, optarg) < 0) {
+                fprintf(stderr, "Invalid cpu flags '%s'\n", optarg);
+                return 1;
+            }
+            av_force_cpu_flags(flags);
+            break;
+        }
+        case 'h':
+            usage(argv[0]);
+            return 0;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!dst_w) {
+        dst_w = w;
+        dst_h = h;
+    }
+
+    av_lfg_init(&lfg, 0xC0FFEE);
+    for (i = 0; i < FF_ARRAY_ELEMS(conversions); i++) {
+        int ret = run_conversion(conversions[i].src, conversions[i].dst,
+                                 w, h, dst_w, dst_h, threads, runs, &lfg);
+        if (ret < 0) {
+            fprintf(stderr, "%s -> %s failed: %s\n",
+                    av_get_pix_fmt_name(conversions[i].src),
+                    av_get_pix_fmt_name(conversions[i].dst), av_err2str(ret));
+            return 1;
+        }
+    }
+    return 0;
+}